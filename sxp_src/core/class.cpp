@@ -9,6 +9,10 @@
 #include "class.h"
 #include "sort.h"
 #include "sxp_src/core/fsys/fsys.h"
+#include "sxp_src/core/mp/mp_job_queue.h"
+#ifdef PFC_ENGINEOP_LZ4
+#include "lz4.h"
+#endif
 using namespace pfc;
 //----------------------------------------------------------------------------
 
@@ -28,10 +32,11 @@ namespace pfc
 //============================================================================
 namespace pfc
 {
-  void *read_object_impl(bin_input_stream_base &s_, const char *file_ext_, const char *path_, unsigned type_id_)
+  void *read_object_impl(bin_input_stream_base &s_, const char *file_ext_, const char *path_, unsigned type_id_, usize_t *num_bytes_)
   {
     // read archive signature and perform proper archive deserialization
     void *p=0;
+    usize_t start_pos=s_.pos();
     char sig[16];
     s_.read_bytes(sig, 16);
     if(mem_eq(sig, PFC_BIG_ENDIAN?"PFC_ARCH":"pfc_arch", 8))
@@ -39,6 +44,8 @@ namespace pfc
       // normal deserialization
       prop_enum_input_archive<bin_input_stream_base> pe(s_, file_ext_, path_);
       p=pe.root_object(type_id_);
+      if(num_bytes_)
+        *num_bytes_=pe.has_type_info()?pe.num_object_bytes():s_.pos()-start_pos;
     }
     else if(mem_eq(sig, PFC_BIG_ENDIAN?"pfc_arch":"PFC_ARCH", 8))
     {
@@ -47,14 +54,58 @@ namespace pfc
       endian_input_stream es(s_);
       prop_enum_input_archive<endian_input_stream> pe(es, file_ext_, path_);
       p=pe.root_object(type_id_);
+      if(num_bytes_)
+        *num_bytes_=pe.has_type_info()?pe.num_object_bytes():s_.pos()-start_pos;
 #else
       PFC_ERRORF("Executable doesn't support reading %s-endian archive files\r\n", PFC_BIG_ENDIAN?"little":"big");
 #endif
     }
+    else if(mem_eq(sig, "pfc_pack", 8))
+    {
+      // compressed archive deserialization
+      switch(sig[8])
+      {
+        case archcodec_lz4:
+        {
+#ifdef PFC_ENGINEOP_LZ4
+          lz4_input_stream ls(s_);
+          p=read_object_impl(ls, file_ext_, path_, type_id_, num_bytes_);
+#else
+          PFC_ERROR("Executable doesn't support reading LZ4 compressed archive files\r\n");
+#endif
+        } break;
+
+        default: PFC_ERRORF("Unsupported archive compression codec (%i)\r\n", sig[8]);
+      }
+    }
     else
       PFC_ERROR("Invalid archive signature\r\n");
     return p;
   }
+  //----
+
+  owner_ptr<bin_output_stream_base> create_archive_codec_stream(bin_output_stream_base &s_, e_archive_codec codec_)
+  {
+    // write compressed archive signature and create compression stream for the archive
+    char sig[16]={0};
+    mem_copy(sig, "pfc_pack", 8);
+    sig[8]=char(codec_);
+    switch(codec_)
+    {
+      case archcodec_lz4:
+      {
+#ifdef PFC_ENGINEOP_LZ4
+        s_.write_bytes(sig, 16);
+        return PFC_NEW(lz4_output_stream)(s_);
+#else
+        PFC_ERROR("Executable doesn't support writing LZ4 compressed archive files\r\n");
+#endif
+      } break;
+
+      default: PFC_ERRORF("Unsupported archive compression codec (%i)\r\n", codec_);
+    }
+    return 0;
+  }
 } // namespace pfc
 //----------------------------------------------------------------------------
 
@@ -156,6 +207,97 @@ void class_repository_base::add_factory(const str_id &id_, const class_factory_b
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// object_repository_base::load_request
+//============================================================================
+namespace
+{
+  enum e_load_state
+  {
+    loadstate_queued,
+    loadstate_loading,
+    loadstate_done,
+  };
+  //--------------------------------------------------------------------------
+
+  // repository container & pending load access lock, the pool objects are
+  // loaded to by the thread (nested loads of dependencies go to the same pool)
+  // and the referenced dependencies of the object being loaded by the thread
+  mp_critical_section s_repository_cs;
+  PFC_THREAD_VAR object_repository_pool *s_load_pool=0;
+  PFC_THREAD_VAR array<void*> *s_load_dependencies=0;
+  //--------------------------------------------------------------------------
+
+  struct eviction_candidate
+  {
+    usize_t last_access;
+    void *object;
+  };
+  PFC_INLINE bool operator<(const eviction_candidate &c0_, const eviction_candidate &c1_)
+  {
+    return c0_.last_access<c1_.last_access;
+  }
+  //--------------------------------------------------------------------------
+
+  bool is_pool_in_hierarchy(const object_repository_pool &pool_, const object_repository_pool *hierarchy_)
+  {
+    // check if the pool is the hierarchy pool or one of its parents
+    do
+    {
+      if(hierarchy_==&pool_)
+        return true;
+      hierarchy_=hierarchy_->parent();
+    } while(hierarchy_);
+    return false;
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+struct object_repository_base::load_request
+{
+  struct callback
+  {
+    void(*func)(void*, void*);
+    void *user_data;
+  };
+  //--------------------------------------------------------------------------
+
+  object_repository_base *repository;
+  object_repository_pool *pool;
+  heap_str name;
+  heap_str file_ext;
+  heap_str path;
+  bool has_file_ext;
+  bool has_path;
+  unsigned type_id;
+  array<callback> callbacks;
+  void *object;
+  volatile int32_t state;
+  volatile int32_t ref_count;
+  load_request *next_pending; // next pending load of the object to another pool
+  volatile uint32_t load_counter; // 1 while the load is in flight (job counter for waiting job fibers)
+  mp_gate done;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// object_repository_pool
+//============================================================================
+void object_repository_pool::get_stats(object_repository_pool_stats &stats_) const
+{
+  s_repository_cs.enter();
+  stats_.budget=m_budget;
+  stats_.num_objects=m_residency.size();
+  stats_.num_bytes=m_num_bytes;
+  stats_.num_hits=m_num_hits;
+  stats_.num_misses=m_num_misses;
+  stats_.num_evicts=m_num_evicts;
+  s_repository_cs.leave();
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // object_repository_base
 //============================================================================
@@ -187,21 +329,11 @@ object_repository_pool &object_repository_base::add_pool(const char *name_, obje
 
 void object_repository_base::remove_pool(object_repository_pool &pool_)
 {
-  // remove pool and all child pools
+  // remove child pools first (child pool objects may reference objects of the pool)
   list<object_repository_pool>::iterator it=s_pools.begin();
   while(is_valid(it))
   {
-    if(ptr(it)==&pool_)
-    {
-      // clear containers and remove the pool
-      if(s_active_pool==&pool_)
-        s_active_pool=0;
-      unsigned num_reps=(unsigned)s_repositories.size();
-      for(unsigned i=0; i<num_reps; ++i)
-        s_repositories[i]->clear_container(it->m_containers[i]);
-      s_pools.erase(it);
-    }
-    else if(it->m_parent==&pool_)
+    if(it->m_parent==&pool_)
     {
       // remove child pool and restart from beginning (iterator is invalidated)
       remove_pool(*it);
@@ -210,14 +342,46 @@ void object_repository_base::remove_pool(object_repository_pool &pool_)
     else
       ++it;
   }
+
+  // complete in-flight loads to the pool (loads add objects and dependency references to the pool)
+  wait_pool_loads(pool_);
+
+  // release references of the pool objects to objects in parent pools
+  if(pool_.m_parent)
+  {
+    s_repository_cs.enter();
+    hash_map<void*, object_repository_pool::residency_info>::iterator rit=pool_.m_residency.begin();
+    while(is_valid(rit))
+    {
+      release_dependencies(*pool_.m_parent, rit->dependencies);
+      ++rit;
+    }
+    s_repository_cs.leave();
+  }
+
+  // clear containers and remove the pool
+  if(s_active_pool==&pool_)
+    s_active_pool=0;
+  unsigned num_reps=(unsigned)s_repositories.size();
+  for(unsigned i=0; i<num_reps; ++i)
+    s_repositories[i]->clear_container(pool_.m_containers[i]);
+  it=s_pools.begin();
+  while(ptr(it)!=&pool_)
+    ++it;
+  s_pools.erase(it);
 }
 //----
 
 void object_repository_base::remove_all_pools()
 {
+  // complete in-flight loads to all pools before clearing any (loads may reference objects of parent pools)
+  list<object_repository_pool>::iterator it=s_pools.begin();
+  for(; is_valid(it); ++it)
+    wait_pool_loads(*it);
+
   // iterate through all pools
   unsigned num_reps=(unsigned)s_repositories.size();
-  list<object_repository_pool>::iterator it=s_pools.begin();
+  it=s_pools.begin();
   while(is_valid(it))
   {
     // clear all repository containers in the pool
@@ -256,6 +420,72 @@ object_repository_pool *object_repository_base::find_pool(const char *name_)
   }
   return 0;
 }
+//----
+
+void object_repository_base::trim_pools()
+{
+  // evict least-recently-used unreferenced objects from pools exceeding their budget
+  array<eviction_candidate> candidates;
+  array<pair<object_repository_base*, void*> > evicted;
+  bool has_released_deps;
+  do
+  {
+    // repeat eviction passes while evictions release dependencies for eviction
+    has_released_deps=false;
+    list<object_repository_pool>::iterator it=s_pools.begin();
+    while(is_valid(it))
+    {
+      object_repository_pool &pool=*it;
+      s_repository_cs.enter();
+      if(pool.m_budget && pool.m_num_bytes>pool.m_budget)
+      {
+        // collect unreferenced objects in LRU order
+        candidates.clear();
+        hash_map<void*, object_repository_pool::residency_info>::const_iterator rit=pool.m_residency.begin();
+        while(is_valid(rit))
+        {
+          if(!rit->num_refs)
+          {
+            eviction_candidate &c=candidates.push_back();
+            c.last_access=rit->last_access;
+            c.object=rit.key();
+          }
+          ++rit;
+        }
+        quick_sort(candidates.data(), candidates.size());
+
+        // remove objects from the pool until within the budget
+        usize_t num_candidates=candidates.size();
+        for(usize_t ci=0; ci<num_candidates && pool.m_num_bytes>pool.m_budget; ++ci)
+        {
+          void *p=candidates[ci].object;
+          hash_map<void*, object_repository_pool::residency_info>::iterator rit=pool.m_residency.find(p);
+          unsigned rep_idx=rit->repository_index;
+          pool.m_num_bytes-=rit->num_bytes;
+          if(rit->dependencies.size())
+          {
+            release_dependencies(pool, rit->dependencies);
+            has_released_deps=true;
+          }
+          pool.m_residency.erase(rit);
+          repository_container::iterator cit=pool.m_containers[rep_idx].find_val(p);
+          const char *name=cit.key().c_str();
+          cit.remove_val();
+          pool.m_strings.remove_string(name);
+          ++pool.m_num_evicts;
+          evicted.push_back(pair<object_repository_base*, void*>(s_repositories[rep_idx], p));
+        }
+      }
+      s_repository_cs.leave();
+      ++it;
+    }
+  } while(has_released_deps);
+
+  // delete evicted objects outside the lock (destructors may access repositories)
+  usize_t num_evicted=evicted.size();
+  for(usize_t i=0; i<num_evicted; ++i)
+    evicted[i].first->delete_object(evicted[i].second);
+}
 //----------------------------------------------------------------------------
 
 object_repository_base *object_repository_base::find_repository(const str_id &id_)
@@ -269,17 +499,13 @@ object_repository_base *object_repository_base::find_repository(const str_id &id
 void *object_repository_base::find_object(const str_id &id_) const
 {
   // find object with given id from the repository
-  PFC_ASSERT_MSG(s_active_pool, ("No object repository pool has been activated\r\n"));
+  object_repository_pool *pool=s_load_pool?s_load_pool:s_active_pool;
+  PFC_ASSERT_MSG(pool, ("No object repository pool has been activated\r\n"));
   PFC_ASSERT(id_.c_str());
-  object_repository_pool *pool=s_active_pool;
-  do
-  {
-    repository_container::const_iterator it=pool->m_containers[m_index].find(id_);
-    if(is_valid(it))
-      return *it;
-    pool=pool->m_parent;
-  } while(pool);
-  return 0;
+  s_repository_cs.enter();
+  void *p=find_pool_object(*pool, id_);
+  s_repository_cs.leave();
+  return p;
 }
 //----
 
@@ -288,39 +514,50 @@ const str_id *object_repository_base::find_object_name(const void *p_) const
   // find name associated with the pointer
   if(!p_)
     return 0;
-  PFC_ASSERT_MSG(s_active_pool, ("No object repository pool has been activated\r\n"));
-  object_repository_pool *pool=s_active_pool;
+  object_repository_pool *pool=s_load_pool?s_load_pool:s_active_pool;
+  PFC_ASSERT_MSG(pool, ("No object repository pool has been activated\r\n"));
+  const str_id *name=0;
+  s_repository_cs.enter();
   do
   {
     repository_container::const_iterator it=pool->m_containers[m_index].find_val(const_cast<void*>(p_));
     if(is_valid(it))
-      return &it.key();
+    {
+      name=&it.key();
+      break;
+    }
     pool=pool->m_parent;
   } while(pool);
-  return 0;
+  s_repository_cs.leave();
+  return name;
 }
 //----
 
 void *object_repository_base::load_object(const str_id &id_, const char *file_ext_, const char *path_, unsigned type_id_)
 {
   // search for object from the repository
-  void *p=find_object(id_);
+  object_repository_pool *pool=s_load_pool?s_load_pool:s_active_pool;
+  PFC_ASSERT_MSG(pool, ("No object repository pool has been activated\r\n"));
+  PFC_ASSERT(id_.c_str());
+  s_repository_cs.enter();
+  void *p=find_pool_object(*pool, id_);
+  if(p)
+  {
+    ++pool->m_num_hits;
+    add_load_dependency(*pool, p);
+  }
+  s_repository_cs.leave();
   if(!p)
   {
-    // load object from archive file
-    filepath_str asset_file=id_.c_str();
-    if(file_ext_)
-      asset_file+=file_ext_;
-    owner_ptr<bin_input_stream_base> s=file_system_base::active().open_read(asset_file.c_str(), path_, fopencheck_none);
-    if(s.data)
+    // load the object on this thread (or wait for the load already in-flight)
+    object_load_future_base f(start_load(id_, file_ext_, path_, type_id_, 0, 0, false));
+    p=f.wait();
+    if(p && s_load_dependencies)
     {
-      // read object and add to repository
-      p=read_object_impl(*s.data, file_ext_, path_, type_id_);
-      if(p)
-        add_object(id_, p);
+      s_repository_cs.enter();
+      add_load_dependency(*pool, p);
+      s_repository_cs.leave();
     }
-    else
-      PFC_WARNF("Unable to load file \"%s\" for \"%s\" repository object \"%s\"\r\n", afs_complete_path(asset_file.c_str(), path_).c_str(), m_name.c_str(), id_.c_str());
   }
   return p;
 }
@@ -333,12 +570,47 @@ void *object_repository_base::load_object(const str_id &id_, bin_input_stream_ba
   if(!p)
   {
     // read object and add to repository
-    p=read_object_impl(s_, file_ext_, path_, type_id_);
+    usize_t num_bytes=0;
+    array<void*> deps;
+    array<void*> *old_load_deps=s_load_dependencies;
+    s_load_dependencies=&deps;
+    p=read_object_impl(s_, file_ext_, path_, type_id_, &num_bytes);
+    s_load_dependencies=old_load_deps;
+    object_repository_pool *pool=s_load_pool?s_load_pool:s_active_pool;
     if(p)
       add_object(id_, p);
+    set_object_residency(*pool, p, num_bytes, deps);
   }
   return p;
 }
+//----
+
+object_load_future_base object_repository_base::load_object_async(const str_id &id_, const char *file_ext_, const char *path_, unsigned type_id_, void(*callback_)(void*, void*), void *user_data_)
+{
+  return object_load_future_base(start_load(id_, file_ext_, path_, type_id_, callback_, user_data_, true));
+}
+//----
+
+void object_repository_base::ref_object(void *p_)
+{
+  // add reference to the object to prevent its eviction
+  s_repository_cs.enter();
+  object_repository_pool::residency_info *ri=find_residency(p_);
+  PFC_ASSERT_MSG(ri, ("Referenced object isn't in \"%s\" repository\r\n", m_name.c_str()));
+  ++ri->num_refs;
+  s_repository_cs.leave();
+}
+//----
+
+void object_repository_base::unref_object(void *p_)
+{
+  // remove reference from the object
+  s_repository_cs.enter();
+  object_repository_pool::residency_info *ri=find_residency(p_);
+  PFC_ASSERT_MSG(ri && ri->num_refs, ("Unreferenced object isn't referenced in \"%s\" repository\r\n", m_name.c_str()));
+  --ri->num_refs;
+  s_repository_cs.leave();
+}
 //----------------------------------------------------------------------------
 
 object_repository_base::object_repository_base(const str_id &id_)
@@ -366,12 +638,20 @@ object_repository_base::~object_repository_base()
 const char *object_repository_base::add_object(const str_id &id_, void *p_)
 {
   // add new object to the repository
-  PFC_ASSERT_MSG(s_active_pool, ("No object repository pool has been activated while adding resource \"%s\" to \"%s\" repository\r\n", id_.c_str(), m_name.c_str()));
+  object_repository_pool *pool=s_load_pool?s_load_pool:s_active_pool;
+  PFC_ASSERT_MSG(pool, ("No object repository pool has been activated while adding resource \"%s\" to \"%s\" repository\r\n", id_.c_str(), m_name.c_str()));
   PFC_ASSERT(p_!=0);
-  repository_container &container=s_active_pool->m_containers[m_index];
+  s_repository_cs.enter();
+  repository_container &container=pool->m_containers[m_index];
   PFC_ASSERT_MSG(!is_valid(container.find(id_)), ("Object \"%s\" already exists in \"%s\" repository\r\n", id_.c_str(), m_name.c_str()));
-  const char *name=s_active_pool->m_strings.add_string(id_.c_str());
+  const char *name=pool->m_strings.add_string(id_.c_str());
   container.insert(str_id(name, id_.crc32()), p_);
+  object_repository_pool::residency_info &ri=*pool->m_residency.insert(p_).it;
+  ri.repository_index=m_index;
+  ri.num_refs=0;
+  ri.num_bytes=0;
+  ri.last_access=++pool->m_access_tick;
+  s_repository_cs.leave();
   return name;
 }
 //----
@@ -379,14 +659,416 @@ const char *object_repository_base::add_object(const str_id &id_, void *p_)
 void object_repository_base::remove_object(void *p_)
 {
   // remove object from the repository
-  PFC_ASSERT_MSG(s_active_pool, ("No object repository pool has been activated\r\n"));
+  object_repository_pool *pool=s_load_pool?s_load_pool:s_active_pool;
+  PFC_ASSERT_MSG(pool, ("No object repository pool has been activated\r\n"));
   PFC_ASSERT(p_!=0);
-  repository_container::iterator it=s_active_pool->m_containers[m_index].find_val(p_);
+  s_repository_cs.enter();
+  repository_container::iterator it=pool->m_containers[m_index].find_val(p_);
   if(is_valid(it))
   {
     const char *name=it.key().c_str();
     it.remove_val();
-    s_active_pool->m_strings.remove_string(name);
+    pool->m_strings.remove_string(name);
+    hash_map<void*, object_repository_pool::residency_info>::iterator rit=pool->m_residency.find(p_);
+    pool->m_num_bytes-=rit->num_bytes;
+    release_dependencies(*pool, rit->dependencies);
+    pool->m_residency.erase(rit);
+  }
+  s_repository_cs.leave();
+}
+//----------------------------------------------------------------------------
+
+void *object_repository_base::find_pool_object(object_repository_pool &pool_, const str_id &id_) const
+{
+  // find object from the pool hierarchy (repository lock must be held)
+  object_repository_pool *pool=&pool_;
+  do
+  {
+    repository_container::const_iterator it=pool->m_containers[m_index].find(id_);
+    if(is_valid(it))
+    {
+      // update object access time for LRU eviction
+      if(pool->m_budget)
+        pool->m_residency.find(*it)->last_access=++pool->m_access_tick;
+      return *it;
+    }
+    pool=pool->m_parent;
+  } while(pool);
+  return 0;
+}
+//----
+
+object_repository_pool::residency_info *object_repository_base::find_residency(void *p_) const
+{
+  object_repository_pool *pool=s_load_pool?s_load_pool:s_active_pool;
+  PFC_ASSERT_MSG(pool, ("No object repository pool has been activated\r\n"));
+  return find_residency(*pool, p_);
+}
+//----
+
+object_repository_pool::residency_info *object_repository_base::find_residency(object_repository_pool &pool_, void *p_)
+{
+  // find residency info of the object from the pool hierarchy (repository lock must be held)
+  object_repository_pool *pool=&pool_;
+  do
+  {
+    hash_map<void*, object_repository_pool::residency_info>::iterator it=pool->m_residency.find(p_);
+    if(is_valid(it))
+      return &*it;
+    pool=pool->m_parent;
+  } while(pool);
+  return 0;
+}
+//----
+
+void object_repository_base::set_object_residency(object_repository_pool &pool_, void *p_, usize_t num_bytes_, array<void*> &dependencies_)
+{
+  // set archived size and referenced dependencies of a loaded object (release the dependencies if the load failed)
+  s_repository_cs.enter();
+  if(p_)
+  {
+    hash_map<void*, object_repository_pool::residency_info>::iterator it=pool_.m_residency.find(p_);
+    if(is_valid(it))
+    {
+      pool_.m_num_bytes+=num_bytes_-it->num_bytes;
+      it->num_bytes=num_bytes_;
+      it->dependencies.swap(dependencies_);
+    }
+  }
+  release_dependencies(pool_, dependencies_);
+  s_repository_cs.leave();
+}
+//----
+
+void object_repository_base::add_load_dependency(object_repository_pool &pool_, void *p_)
+{
+  // reference the object as a dependency of the object being loaded by the thread (repository lock must be held)
+  if(!s_load_dependencies)
+    return;
+  if(object_repository_pool::residency_info *ri=find_residency(pool_, p_))
+  {
+    ++ri->num_refs;
+    s_load_dependencies->push_back(p_);
+  }
+}
+//----
+
+void object_repository_base::release_dependencies(object_repository_pool &pool_, array<void*> &deps_)
+{
+  // release references to the dependencies from the pool hierarchy (repository lock must be held)
+  usize_t num_deps=deps_.size();
+  for(usize_t i=0; i<num_deps; ++i)
+    if(object_repository_pool::residency_info *ri=find_residency(pool_, deps_[i]))
+      --ri->num_refs;
+  deps_.clear();
+}
+//----
+
+object_repository_base::load_request *object_repository_base::start_load(const str_id &id_, const char *file_ext_, const char *path_, unsigned type_id_, void(*callback_)(void*, void*), void *user_data_, bool async_)
+{
+  // check for already loaded object or in-flight load of the object
+  object_repository_pool *pool=s_load_pool?s_load_pool:s_active_pool;
+  PFC_ASSERT_MSG(pool, ("No object repository pool has been activated while loading resource \"%s\" to \"%s\" repository\r\n", id_.c_str(), m_name.c_str()));
+  PFC_ASSERT(id_.c_str());
+  s_repository_cs.enter();
+  void *p=find_pool_object(*pool, id_);
+  load_request *req=0;
+  if(!p)
+  {
+    // search for in-flight load of the object to the pool hierarchy
+    hash_map<str_id, load_request*>::iterator it=m_pending_loads.find(id_);
+    if(is_valid(it))
+    {
+      req=*it;
+      while(req && !is_pool_in_hierarchy(*req->pool, pool))
+        req=req->next_pending;
+    }
+    if(req)
+    {
+      // share the in-flight load
+      ++pool->m_num_hits;
+      if(callback_)
+      {
+        load_request::callback &cb=req->callbacks.push_back();
+        cb.func=callback_;
+        cb.user_data=user_data_;
+      }
+      atom_inc(req->ref_count);
+      s_repository_cs.leave();
+      return req;
+    }
+  }
+
+  // init new load request (owned by the pending load and the returned future)
+  req=PFC_NEW(load_request);
+  req->repository=this;
+  req->pool=pool;
+  req->name=id_.c_str();
+  req->has_file_ext=file_ext_!=0;
+  req->has_path=path_!=0;
+  if(file_ext_)
+    req->file_ext=file_ext_;
+  if(path_)
+    req->path=path_;
+  req->type_id=type_id_;
+  req->object=p;
+  req->state=p?loadstate_done:loadstate_queued;
+  req->ref_count=p?1:2;
+  req->next_pending=0;
+  req->load_counter=p?0:1;
+  ++(p?pool->m_num_hits:pool->m_num_misses);
+  if(p)
+  {
+    // object already loaded => signal the callback immediately
+    s_repository_cs.leave();
+    req->done.open();
+    if(callback_)
+      (*callback_)(p, user_data_);
+    return req;
+  }
+  if(callback_)
+  {
+    load_request::callback &cb=req->callbacks.push_back();
+    cb.func=callback_;
+    cb.user_data=user_data_;
+  }
+  hash_map<str_id, load_request*>::inserter ins=m_pending_loads.insert(str_id(req->name.c_str(), id_.crc32()), req, false);
+  if(!ins.is_new)
+  {
+    // append to the pending loads of the object to other pools
+    load_request *preq=*ins.it;
+    while(preq->next_pending)
+      preq=preq->next_pending;
+    preq->next_pending=req;
+  }
+
+  // schedule the load to the job queue or load on this thread
+  if(async_ && mp_job_queue::has_active())
+  {
+    mp_job_queue &jq=mp_job_queue::active();
+    e_jobtype_id job_type=jq.find_or_create_job_type("object load", &load_job);
+    atom_inc(req->ref_count);
+    s_repository_cs.leave();
+    jq.add_job(job_type, req);
+  }
+  else
+  {
+    s_repository_cs.leave();
+    exec_load(*req);
+  }
+  return req;
+}
+//----
+
+void object_repository_base::exec_load(load_request &req_)
+{
+  // claim the load (may be executed either by a job or a waiting thread)
+  if(atom_cmov_eq(req_.state, int32_t(loadstate_loading), int32_t(loadstate_queued))!=loadstate_queued)
+    return;
+
+  // load object from archive file to the requested pool
+  object_repository_pool *old_load_pool=s_load_pool;
+  s_load_pool=req_.pool;
+  const char *file_ext=req_.has_file_ext?req_.file_ext.c_str():0;
+  const char *path=req_.has_path?req_.path.c_str():0;
+  filepath_str asset_file=req_.name.c_str();
+  if(file_ext)
+    asset_file+=file_ext;
+  void *p=0;
+  {
+    PFC_PERF_TRACE_SCOPE("load_object", "file", asset_file.c_str());
+    owner_ptr<bin_input_stream_base> s=file_system_base::active().open_read(asset_file.c_str(), path, fopencheck_none);
+    if(s.data)
+    {
+      // read object and add to repository
+      usize_t num_bytes=0;
+      array<void*> deps;
+      array<void*> *old_load_deps=s_load_dependencies;
+      s_load_dependencies=&deps;
+      p=read_object_impl(*s.data, file_ext, path, req_.type_id, &num_bytes);
+      s_load_dependencies=old_load_deps;
+      if(p)
+        add_object(str_id(req_.name.c_str()), p);
+      set_object_residency(*req_.pool, p, num_bytes, deps);
+    }
+    else
+      PFC_WARNF("Unable to load file \"%s\" for \"%s\" repository object \"%s\"\r\n", afs_complete_path(asset_file.c_str(), path).c_str(), m_name.c_str(), req_.name.c_str());
+  }
+  s_load_pool=old_load_pool;
+
+  // complete the load and signal callbacks (no new callbacks are added after removal from pending loads)
+  s_repository_cs.enter();
+  str_id id(req_.name.c_str());
+  hash_map<str_id, load_request*>::iterator it=m_pending_loads.find(id);
+  PFC_ASSERT(is_valid(it));
+  if(*it==&req_)
+  {
+    // remove the first pending load and re-key the next one (key string is owned by the request)
+    m_pending_loads.erase(it);
+    if(load_request *next=req_.next_pending)
+      m_pending_loads.insert(str_id(next->name.c_str(), id.crc32()), next);
+  }
+  else
+  {
+    // unlink the load from the pending loads of the object
+    load_request *preq=*it;
+    while(preq->next_pending!=&req_)
+      preq=preq->next_pending;
+    preq->next_pending=req_.next_pending;
+  }
+  req_.next_pending=0;
+  req_.object=p;
+  atom_write(req_.state, int32_t(loadstate_done));
+  s_repository_cs.leave();
+  req_.done.open();
+  if(mp_job_queue::has_active())
+    mp_job_queue::active().dec_job_counter(req_.load_counter);
+  else
+    atom_write(req_.load_counter, uint32_t(0));
+  usize_t num_callbacks=req_.callbacks.size();
+  for(usize_t i=0; i<num_callbacks; ++i)
+    (*req_.callbacks[i].func)(p, req_.callbacks[i].user_data);
+  release_load(&req_);
+}
+//----
+
+void object_repository_base::load_job(load_request *req_, void*)
+{
+  req_->repository->exec_load(*req_);
+  release_load(req_);
+}
+//----
+
+void object_repository_base::release_load(load_request *req_)
+{
+  if(!atom_dec(req_->ref_count))
+    PFC_DELETE(req_);
+}
+//----
+
+void object_repository_base::wait_pool_loads(object_repository_pool &pool_)
+{
+  // wait for (or execute) in-flight loads to the pool one at a time
+  while(true)
+  {
+    s_repository_cs.enter();
+    load_request *req=0;
+    unsigned num_reps=(unsigned)s_repositories.size();
+    for(unsigned i=0; i<num_reps && !req; ++i)
+    {
+      hash_map<str_id, load_request*>::iterator it=s_repositories[i]->m_pending_loads.begin();
+      for(; is_valid(it) && !req; ++it)
+        for(load_request *preq=*it; preq; preq=preq->next_pending)
+          if(preq->pool==&pool_)
+          {
+            req=preq;
+            break;
+          }
+    }
+    if(!req)
+    {
+      s_repository_cs.leave();
+      return;
+    }
+    atom_inc(req->ref_count);
+    s_repository_cs.leave();
+    object_load_future_base(req).wait();
+  }
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// object_load_future_base
+//============================================================================
+object_load_future_base::object_load_future_base()
+{
+  m_request=0;
+}
+//----
+
+object_load_future_base::object_load_future_base(const object_load_future_base &f_)
+{
+  m_request=f_.m_request;
+  if(m_request)
+    atom_inc(m_request->ref_count);
+}
+//----
+
+object_load_future_base::object_load_future_base(object_repository_base::load_request *req_)
+{
+  // take ownership of the request reference
+  m_request=req_;
+}
+//----
+
+object_load_future_base::~object_load_future_base()
+{
+  if(m_request)
+    object_repository_base::release_load(m_request);
+}
+//----
+
+void object_load_future_base::operator=(const object_load_future_base &f_)
+{
+  if(f_.m_request)
+    atom_inc(f_.m_request->ref_count);
+  if(m_request)
+    object_repository_base::release_load(m_request);
+  m_request=f_.m_request;
+}
+//----------------------------------------------------------------------------
+
+bool object_load_future_base::is_ready() const
+{
+  return m_request && atom_read(m_request->state)==loadstate_done;
+}
+//----
+
+void *object_load_future_base::wait() const
+{
+  // execute the load on this thread if not yet started, or wait for completion (suspending job fibers)
+  PFC_ASSERT(m_request);
+  if(atom_read(m_request->state)!=loadstate_done)
+  {
+    m_request->repository->exec_load(*m_request);
+    if(mp_job_queue::has_active() && mp_job_queue::active().is_job_fiber_active())
+      mp_job_queue::active().wait_jobs(m_request->load_counter);
+    else
+      wait_gate(m_request->done);
+  }
+  return m_request->object;
+}
+//----
+
+void *object_load_future_base::object() const
+{
+  return is_ready()?m_request->object:0;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// load_objects
+//============================================================================
+unsigned pfc::load_objects(void **objects_, const object_load_desc *descs_, unsigned num_objects_)
+{
+  // start loading all objects before waiting for any of them
+  array<object_load_future_base> loads(num_objects_);
+  for(unsigned i=0; i<num_objects_; ++i)
+  {
+    const object_load_desc &desc=descs_[i];
+    PFC_ASSERT(desc.repository);
+    loads[i]=desc.repository->load_object_async(desc.id, desc.file_ext, desc.path, desc.type_id);
+  }
+  unsigned num_loaded=0;
+  for(unsigned i=0; i<num_objects_; ++i)
+  {
+    void *p=loads[i].wait();
+    if(objects_)
+      objects_[i]=p;
+    num_loaded+=p!=0;
   }
+  return num_loaded;
 }
 //----------------------------------------------------------------------------
@@ -21,14 +21,19 @@ namespace pfc
 
 // new
 enum {archive_version=0x1520}; // v1.52
+enum e_archive_codec {archcodec_none, archcodec_lz4}; // archive compression for save_object()
 template<typename> struct archive_mvar_type_id;
 class class_factory_base;
 template<class T> class class_factory;
 class class_repository_base;
 template<class B> class class_repository;
 class object_repository_pool;
+struct object_repository_pool_stats;
 class object_repository_base;
 template<class B> class object_repository;
+class object_load_future_base;
+template<class B> class object_load_future;
+struct object_load_desc;
 template<class S> class prop_enum_input_archive;
 template<class S> class prop_enum_output_archive;
 class prop_enum_find_mvar;
@@ -56,22 +61,29 @@ PFC_INLINE void remove_object_pool(object_repository_pool&);
 PFC_INLINE object_repository_pool *active_pool();
 PFC_INLINE object_repository_pool *activate_object_pool(object_repository_pool*);
 PFC_INLINE object_repository_pool *find_object_pool(const char *name_);
+PFC_INLINE void trim_object_pools();
 // repository management
 PFC_INLINE const class_factory_base *find_mono_factory(const str_id&);
 PFC_INLINE class_repository_base *find_class_repository(const str_id&);
 PFC_INLINE object_repository_base *find_object_repository(const str_id&);
 template<class B> PFC_INLINE void add_object(const str_id&, B&);
 template<class B> PFC_INLINE void remove_object(B&);
+template<class B> PFC_INLINE void ref_object(B&);
+template<class B> PFC_INLINE void unref_object(B&);
 template<class B> PFC_INLINE B *create_object(const str_id&);
 template<class B> PFC_INLINE B *create_object();
 template<class B> PFC_INLINE B *find_object(const str_id&);
 template<class B> PFC_INLINE const str_id *find_object_name(const B&);
 template<class B> PFC_INLINE B *load_object(const str_id&, const char *file_ext_=0, const char *path_=0);
 template<class B> PFC_INLINE B *load_object(const str_id&, bin_input_stream_base&, const char *file_ext_=0, const char *path_=0);
+template<class B> PFC_INLINE object_load_future<B> load_object_async(const str_id&, const char *file_ext_=0, const char *path_=0);
+template<class B, typename U> PFC_INLINE object_load_future<B> load_object_async(const str_id&, void(*callback_)(B*, U*), U *user_data_, const char *file_ext_=0, const char *path_=0);
+template<class B> unsigned load_objects(B **objects_, const str_id *ids_, unsigned num_objects_, const char *file_ext_=0, const char *path_=0);
+unsigned load_objects(void **objects_, const object_load_desc*, unsigned num_objects_);
 template<class B> inline owner_ptr<B> read_object(const char *filename_, const char *file_ext_=0, const char *path_=0);
 template<class B> inline owner_ptr<B> read_object(bin_input_stream_base&, const char *file_ext_=0, const char *path_=0);
-template<class B> void save_object(const B&, const char *filename_, const char *path_=0, const char *custom_id_=0, bool save_type_info_=true, bool swap_endianness_=false);
-template<class B> void save_object(const B&, bin_output_stream_base&, const char *custom_id_=0, bool save_type_info_=true, bool swap_endianness_=false);
+template<class B> void save_object(const B&, const char *filename_, const char *path_=0, const char *custom_id_=0, bool save_type_info_=true, bool swap_endianness_=false, e_archive_codec=archcodec_none);
+template<class B> void save_object(const B&, bin_output_stream_base&, const char *custom_id_=0, bool save_type_info_=true, bool swap_endianness_=false, e_archive_codec=archcodec_none);
 #define PFC_CREATE_OBJECT(id__, ptr__)  {static const pfc::str_id s_id(id__); ptr__=ptr__->crep().create(s_id);}
 #define PFC_FIND_OBJECT(id__, ptr__)    {static const pfc::str_id s_id(id__); ptr__=ptr__->orep().find_object(s_id);}
 #define PFC_LOAD_OBJECT(id__, ptr__)    {static const pfc::str_id s_id(id__); ptr__=ptr__->orep().load_object(s_id);}
@@ -433,9 +445,32 @@ private:
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// object_repository_pool_stats
+//============================================================================
+struct object_repository_pool_stats
+{
+  usize_t budget;      // byte budget of the pool (0=unlimited)
+  usize_t num_objects; // number of objects in the pool
+  usize_t num_bytes;   // archived bytes of the objects in the pool
+  usize_t num_hits;    // number of loads of objects already in the pool
+  usize_t num_misses;  // number of loads of objects read from archives
+  usize_t num_evicts;  // number of objects evicted from the pool
+};
+PFC_SET_TYPE_TRAIT(object_repository_pool_stats, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // object_repository_pool
 //============================================================================
+// Pools with a byte budget evict least-recently-used unreferenced objects
+// upon trim_object_pools() while the archived bytes of the pool objects
+// exceed the budget. Pointers to unreferenced objects shouldn't be held over
+// trims, i.e. use ref_object()/unref_object() for the objects in use and
+// load_object() reloads evicted objects when needed again. Objects loaded
+// from archives reference the repository objects they point to, so these
+// dependencies are evicted only after the objects depending on them.
 class object_repository_pool
 {
 public:
@@ -445,14 +480,37 @@ public:
 
   // accessors
   PFC_INLINE object_repository_pool *parent() const;
+  PFC_INLINE void set_budget(usize_t num_bytes_);
+  PFC_INLINE usize_t budget() const;
+  void get_stats(object_repository_pool_stats&) const;
   //--------------------------------------------------------------------------
 
 private:
   friend class object_repository_base;
+  //==========================================================================
+  // residency_info
+  //==========================================================================
+  struct residency_info
+  {
+    unsigned repository_index;
+    unsigned num_refs;
+    usize_t num_bytes;
+    usize_t last_access;
+    array<void*> dependencies;
+  };
+  //--------------------------------------------------------------------------
+
   heap_str m_name;
   deque<hash_bimap<str_id, void*> > m_containers;
   str_pool m_strings;
   object_repository_pool *m_parent;
+  hash_map<void*, residency_info> m_residency;
+  usize_t m_budget;
+  usize_t m_num_bytes;
+  usize_t m_access_tick;
+  usize_t m_num_hits;
+  usize_t m_num_misses;
+  usize_t m_num_evicts;
 };
 //----------------------------------------------------------------------------
 
@@ -474,6 +532,7 @@ public:
   static object_repository_pool *active_pool();
   static object_repository_pool *activate_pool(object_repository_pool*);
   static object_repository_pool *find_pool(const char *name_);
+  static void trim_pools();
   //--------------------------------------------------------------------------
 
   // accessors
@@ -482,6 +541,9 @@ public:
   const str_id *find_object_name(const void*) const;
   void *load_object(const str_id&, const char *file_ext_=0, const char *path_=0, unsigned type_id_=0);
   void *load_object(const str_id&, bin_input_stream_base&, const char *file_ext_=0, const char *path_=0, unsigned type_id_=0);
+  object_load_future_base load_object_async(const str_id&, const char *file_ext_=0, const char *path_=0, unsigned type_id_=0, void(*callback_)(void *object_, void *user_data_)=0, void *user_data_=0);
+  void ref_object(void*);
+  void unref_object(void*);
   //--------------------------------------------------------------------------
 
 protected:
@@ -492,11 +554,25 @@ protected:
   virtual const char *add_object(const str_id&, void*);
   virtual void remove_object(void*);
   virtual void clear_container(repository_container&)=0;
+  virtual void delete_object(void*)=0;
   //--------------------------------------------------------------------------
 
 private:
+  friend class object_load_future_base;
+  struct load_request;
   object_repository_base(const object_repository_base&); // not implemented
   void operator=(const object_repository_base&); // not implemented
+  void *find_pool_object(object_repository_pool&, const str_id&) const;
+  object_repository_pool::residency_info *find_residency(void*) const;
+  static object_repository_pool::residency_info *find_residency(object_repository_pool&, void*);
+  void set_object_residency(object_repository_pool&, void*, usize_t num_bytes_, array<void*> &dependencies_);
+  static void add_load_dependency(object_repository_pool&, void*);
+  static void release_dependencies(object_repository_pool&, array<void*>&);
+  load_request *start_load(const str_id&, const char *file_ext_, const char *path_, unsigned type_id_, void(*callback_)(void*, void*), void *user_data_, bool async_);
+  void exec_load(load_request&);
+  static void load_job(load_request*, void*);
+  static void release_load(load_request*);
+  static void wait_pool_loads(object_repository_pool&);
   //--------------------------------------------------------------------------
 
   static hash_map<str_id, object_repository_base*> s_repository_map;
@@ -505,6 +581,7 @@ private:
   static object_repository_pool *s_active_pool;
   const str_id m_name;
   const unsigned m_index;
+  hash_map<str_id, load_request*> m_pending_loads;
 };
 //----------------------------------------------------------------------------
 
@@ -520,9 +597,13 @@ public:
   static PFC_INLINE object_repository &instance(const str_id&);
   PFC_INLINE void add_object(const str_id&, B&);
   PFC_INLINE void remove_object(B&);
+  PFC_INLINE void ref_object(B&);
+  PFC_INLINE void unref_object(B&);
   PFC_INLINE B *find_object(const str_id&) const;
   PFC_INLINE B *load_object(const str_id&, const char *file_ext_=0, const char *path_=0);
   PFC_INLINE B *load_object(const str_id&, bin_input_stream_base&, const char *file_ext_=0, const char *path_=0);
+  PFC_INLINE object_load_future<B> load_object_async(const str_id&, const char *file_ext_=0, const char *path_=0);
+  template<typename U> PFC_INLINE object_load_future<B> load_object_async(const str_id&, void(*callback_)(B*, U*), U *user_data_, const char *file_ext_=0, const char *path_=0);
   //--------------------------------------------------------------------------
 
 private:
@@ -532,6 +613,79 @@ private:
   virtual const char *add_object(const str_id&, void*);
   virtual void remove_object(void*);
   virtual void clear_container(repository_container&);
+  virtual void delete_object(void*);
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// object_load_future_base
+//============================================================================
+// Handle to an asynchronous object repository load started with
+// load_object_async(). Concurrent requests of the same object share a single
+// in-flight load, which is executed on the active job queue (or on the
+// requesting thread if there's no active job queue). wait() executes a load
+// that hasn't been started yet on the calling thread instead of blocking, and
+// suspends the job fiber when called from a job running in a fiber.
+class object_load_future_base
+{
+public:
+  // construction
+  object_load_future_base();
+  object_load_future_base(const object_load_future_base&);
+  ~object_load_future_base();
+  void operator=(const object_load_future_base&);
+  //--------------------------------------------------------------------------
+
+  // accessors
+  PFC_INLINE bool is_valid() const;
+  bool is_ready() const;
+  void *wait() const;
+  void *object() const;
+  //--------------------------------------------------------------------------
+
+private:
+  friend class object_repository_base;
+  object_load_future_base(object_repository_base::load_request*);
+  //--------------------------------------------------------------------------
+
+  object_repository_base::load_request *m_request;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// object_load_future
+//============================================================================
+template<class B>
+class object_load_future: public object_load_future_base
+{
+public:
+  // construction
+  PFC_INLINE object_load_future();
+  PFC_INLINE object_load_future(const object_load_future_base&);
+  //--------------------------------------------------------------------------
+
+  // accessors
+  PFC_INLINE B *wait() const;
+  PFC_INLINE B *object() const;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// object_load_desc
+//============================================================================
+struct object_load_desc
+{
+  PFC_INLINE object_load_desc();
+  //--------------------------------------------------------------------------
+
+  object_repository_base *repository;
+  str_id id;
+  const char *file_ext;
+  const char *path;
+  unsigned type_id;
 };
 //----------------------------------------------------------------------------
 
@@ -550,6 +704,7 @@ public:
   PFC_INLINE S &stream() const;
   PFC_INLINE const class_mvar_t *composite_type_info(archive_type_id_t typeid_, unsigned &num_mvars_, const uint16_t *&csub_vers_) const;
   PFC_INLINE bool has_type_info() const;
+  PFC_INLINE usize_t num_object_bytes() const;
   //--------------------------------------------------------------------------
 
   // serialization
@@ -601,6 +756,9 @@ private:
   template<typename T> PFC_INLINE void stream(T&, meta_case<3> is_type_class_);
   template<typename T> PFC_INLINE void stream(T*&, meta_case<4> is_type_ptr_);
   template<typename T> PFC_INLINE void stream(T&, meta_case<-1> default_);
+  template<typename T> PFC_INLINE void stream_array(T*, usize_t size_, meta_case<0> is_type_pod_archive_);
+  template<typename T> PFC_INLINE void stream_array(T*, usize_t size_, meta_case<1> is_type_swapped_pod_archive_);
+  template<typename T> PFC_INLINE void stream_array(T*, usize_t size_, meta_case<-1> default_);
   //--------------------------------------------------------------------------
 
   S &m_stream;
@@ -611,6 +769,7 @@ private:
   unsigned m_num_composite_sigs;
   const composite_class_sig *m_composite_sigs;
   array<void*> m_objects;
+  usize_t m_num_object_bytes;
 };
 //----------------------------------------------------------------------------
 
@@ -677,6 +836,9 @@ private:
   template<typename T> PFC_INLINE void stream(T, meta_case<3> is_type_fund_);
   template<typename T> PFC_INLINE void stream(T, meta_case<4> is_type_enum_);
   template<typename T> PFC_INLINE void stream(const T&, meta_case<-1> default_);
+  template<typename T> PFC_INLINE void stream_array(const T*, usize_t size_, meta_case<0> is_type_pod_archive_);
+  template<typename T> void stream_array(const T*, usize_t size_, meta_case<1> is_type_swapped_pod_archive_);
+  template<typename T> PFC_INLINE void stream_array(const T*, usize_t size_, meta_case<-1> default_);
   void init_save();
   void save_info(archive_pointer_t root_idx_, const char *custom_id_);
   void save_data();
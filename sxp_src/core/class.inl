@@ -77,6 +77,12 @@ object_repository_pool *find_object_pool(const char *name_)
 {
   return object_repository_base::find_pool(name_);
 }
+//----
+
+void trim_object_pools()
+{
+  object_repository_base::trim_pools();
+}
 //----------------------------------------------------------------------------
 
 
@@ -118,6 +124,20 @@ PFC_INLINE void remove_object(B &object_)
 }
 //----
 
+template<class B>
+PFC_INLINE void ref_object(B &object_)
+{
+  B::orep().ref_object(object_);
+}
+//----
+
+template<class B>
+PFC_INLINE void unref_object(B &object_)
+{
+  B::orep().unref_object(object_);
+}
+//----
+
 template<class B>
 PFC_INLINE B *create_object(const str_id &id_)
 {
@@ -165,6 +185,42 @@ PFC_INLINE B *load_object(const str_id &id_, bin_input_stream_base &s_, const ch
 }
 //----
 
+template<class B>
+PFC_INLINE object_load_future<B> load_object_async(const str_id &id_, const char *file_ext_, const char *path_)
+{
+  PFC_STATIC_ASSERT_MSG(is_type_orep<B>::res, load_object_works_only_with_object_repository_types);
+  return B::orep().load_object_async(id_, file_ext_, path_);
+}
+//----
+
+template<class B, typename U>
+PFC_INLINE object_load_future<B> load_object_async(const str_id &id_, void(*callback_)(B*, U*), U *user_data_, const char *file_ext_, const char *path_)
+{
+  PFC_STATIC_ASSERT_MSG(is_type_orep<B>::res, load_object_works_only_with_object_repository_types);
+  return B::orep().load_object_async(id_, callback_, user_data_, file_ext_, path_);
+}
+//----
+
+template<class B>
+unsigned load_objects(B **objects_, const str_id *ids_, unsigned num_objects_, const char *file_ext_, const char *path_)
+{
+  // start loading all objects before waiting for any of them
+  PFC_STATIC_ASSERT_MSG(is_type_orep<B>::res, load_object_works_only_with_object_repository_types);
+  array<object_load_future<B> > loads(num_objects_);
+  for(unsigned i=0; i<num_objects_; ++i)
+    loads[i]=B::orep().load_object_async(ids_[i], file_ext_, path_);
+  unsigned num_loaded=0;
+  for(unsigned i=0; i<num_objects_; ++i)
+  {
+    B *p=loads[i].wait();
+    if(objects_)
+      objects_[i]=safe_cast<B*>(p);
+    num_loaded+=p!=0;
+  }
+  return num_loaded;
+}
+//----
+
 template<class B>
 inline owner_ptr<B> read_object(const char *filename_, const char *file_ext_, const char *path_)
 {
@@ -176,8 +232,8 @@ inline owner_ptr<B> read_object(const char *filename_, const char *file_ext_, co
   owner_ptr<bin_input_stream_base> s=afs_open_read(fname.c_str(), path_, fopencheck_warn);
   if(s.data)
   {
-    extern void *read_object_impl(bin_input_stream_base&, const char *file_ext_, const char *path_, unsigned type_id_);
-    return static_cast<B*>(read_object_impl(*s.data, file_ext_, path_, type_id<B>::id));
+    extern void *read_object_impl(bin_input_stream_base&, const char *file_ext_, const char *path_, unsigned type_id_, usize_t *num_bytes_);
+    return static_cast<B*>(read_object_impl(*s.data, file_ext_, path_, type_id<B>::id, 0));
   }
   extern filepath_str afs_complete_path(const char *name_, const char *path_, bool collapse_relative_dirs_);
   PFC_WARNF("Unable to read object \"%s\"\r\n", afs_complete_path(fname.c_str(), path_, true).c_str());
@@ -189,45 +245,38 @@ template<class B>
 inline owner_ptr<B> read_object(bin_input_stream_base &s_, const char *file_ext_, const char *path_)
 {
   // read object from archive stream
-  extern void *read_object_impl(bin_input_stream_base&, const char *file_ext_, const char *path_, unsigned type_id_);
-  return static_cast<B*>(read_object_impl(s_, file_ext_, path_, type_id<B>::id));
+  extern void *read_object_impl(bin_input_stream_base&, const char *file_ext_, const char *path_, unsigned type_id_, usize_t *num_bytes_);
+  return static_cast<B*>(read_object_impl(s_, file_ext_, path_, type_id<B>::id, 0));
 }
 //----
 
 template<class B>
-void save_object(const B &v_, const char *filename_, const char *path_, const char *custom_id_, bool save_type_info_, bool swap_endianness_)
+void save_object(const B &v_, const char *filename_, const char *path_, const char *custom_id_, bool save_type_info_, bool swap_endianness_, e_archive_codec codec_)
 {
   // write object to file
   extern owner_ptr<bin_output_stream_base> afs_open_write(const char *filename_, const char *path_, e_file_open_write_mode, uint64_t fpos_, bool makedir_, e_file_open_check);
   extern filepath_str afs_complete_path(const char *name_, const char *path_, bool collapse_relative_dirs_);
   owner_ptr<bin_output_stream_base> s=afs_open_write(filename_, path_, fopenwritemode_clear, 0, true, fopencheck_warn);
   PFC_CHECK_MSG(s.data, ("Unable to open file \"%s\" for writing\r\n", afs_complete_path(filename_, path_, true).c_str()));
-  if(swap_endianness_)
-  {
-#ifdef PFC_BUILDOP_ARCHIVE_ENDIAN_SUPPORT
-    endian_output_stream es(*s.data);
-    prop_enum_output_archive<endian_output_stream> pe(es, save_type_info_);
-    pe.write(v_, custom_id_);
-#else
-    PFC_ERRORF("Executable doesn't support writing %s-endian archive files\r\n", PFC_BIG_ENDIAN?"little", "big");
-#endif
-  }
-  else
-  {
-    prop_enum_output_archive<bin_output_stream_base> pe(*s.data, save_type_info_);
-    pe.write(v_, custom_id_);
-  }
+  save_object(v_, *s.data, custom_id_, save_type_info_, swap_endianness_, codec_);
 }
 //----
 
 template<class B>
-void save_object(const B &v_, bin_output_stream_base &s_, const char *custom_id_, bool save_type_info_, bool swap_endianness_)
+void save_object(const B &v_, bin_output_stream_base &s_, const char *custom_id_, bool save_type_info_, bool swap_endianness_, e_archive_codec codec_)
 {
-  // write object to the stream
+  // write object to the stream (through a compression stream for compressed archives)
+  owner_ptr<bin_output_stream_base> cs;
+  if(codec_!=archcodec_none)
+  {
+    extern owner_ptr<bin_output_stream_base> create_archive_codec_stream(bin_output_stream_base&, e_archive_codec);
+    cs=create_archive_codec_stream(s_, codec_);
+  }
+  bin_output_stream_base &s=cs.data?*cs.data:s_;
   if(swap_endianness_)
   {
 #ifdef PFC_BUILDOP_ARCHIVE_ENDIAN_SUPPORT
-    endian_output_stream es(s_);
+    endian_output_stream es(s);
     prop_enum_output_archive<endian_output_stream> pe(es, save_type_info_);
     pe.write(v_, custom_id_);
 #else
@@ -236,7 +285,7 @@ void save_object(const B &v_, bin_output_stream_base &s_, const char *custom_id_
   }
   else
   {
-    prop_enum_output_archive<bin_output_stream_base> pe(s_, save_type_info_);
+    prop_enum_output_archive<bin_output_stream_base> pe(s, save_type_info_);
     pe.write(v_, custom_id_);
   }
 }
@@ -322,6 +371,9 @@ private:
   template<typename T> PFC_INLINE void stream_class(T&, meta_bool<false> is_type_class_);
   template<typename T> PFC_INLINE void stream_class(T*, usize_t num_objects_, meta_bool<true> is_type_class_);
   template<typename T> PFC_INLINE void stream_class(T*, usize_t num_objects_, meta_bool<false> is_type_class_);
+  template<typename T> PFC_INLINE bool stream_array(T*, usize_t size_, meta_case<0> is_type_pod_archive_);
+  template<typename T> PFC_INLINE bool stream_array(T*, usize_t size_, meta_case<1> is_type_swapped_pod_archive_);
+  template<typename T> PFC_INLINE bool stream_array(T*, usize_t size_, meta_case<-1> default_);
   //--------------------------------------------------------------------------
 
   prop_enum_input_archive<S> &m_penum;
@@ -536,6 +588,15 @@ bool class_factory_base::prop_enum_input_converter<S>::avar(T *a_, usize_t size_
     else
       m_stream>>m_type_id;
 
+    // read plain data array of matching fundamental type without conversion in bulk
+    if(   is_type_fund<T>::res
+       && (m_type_id&~archtype_flag_array)==archive_mvar_type_id<typename meta_if<is_type_fund<T>::res, T, void>::res>::res
+       && stream_array(a_, size_, meta_case<!is_type_pod_archive<T>::res?-1:
+                                            S::is_big_endian==PFC_BIG_ENDIAN?0:
+                                            is_type_fund<T>::res?1:
+                                            -1>()))
+      return true;
+
     // switch to proper conversion procedure for the array
     switch(m_type_id&~archtype_flag_array)
     {
@@ -829,11 +890,21 @@ void class_factory_base::prop_enum_input_converter<S>::stream_class(T *a_, usize
     }
     else
     {
-      // read objects without conversion
-      for(usize_t i=1; i<num_objects_; ++i)
+      // read objects without conversion (plain data objects in bulk)
+      if(stream_array(a_+1, num_objects_-1, meta_case<!is_type_pod_archive<T>::res?-1:
+                                                      S::is_big_endian==PFC_BIG_ENDIAN?0:
+                                                      -1>()))
       {
-        enum_props_most_derived(m_penum, a_[i]);
-        post_load_function(a_+i);
+        for(usize_t i=1; i<num_objects_; ++i)
+          post_load_function(a_+i);
+      }
+      else
+      {
+        for(usize_t i=1; i<num_objects_; ++i)
+        {
+          enum_props_most_derived(m_penum, a_[i]);
+          post_load_function(a_+i);
+        }
       }
       m_penum.reset();
     }
@@ -848,6 +919,36 @@ void class_factory_base::prop_enum_input_converter<S>::stream_class(T *a_, usize
   // unable to convert from a class array to non-class array => skip array
   skip_type(m_type_id, num_objects_);
 }
+//----
+
+template<class S>
+template<typename T>
+bool class_factory_base::prop_enum_input_converter<S>::stream_array(T *a_, usize_t size_, meta_case<0> is_type_pod_archive_)
+{
+  // read plain data array with a single read
+  m_stream.read_bytes(a_, sizeof(T)*size_);
+  return true;
+}
+//----
+
+template<class S>
+template<typename T>
+bool class_factory_base::prop_enum_input_converter<S>::stream_array(T *a_, usize_t size_, meta_case<1> is_type_swapped_pod_archive_)
+{
+  // read plain data array with a single read and swap bytes of the values in place
+  m_stream.read_bytes(a_, sizeof(T)*size_);
+  swap_bytes(a_, size_);
+  return true;
+}
+//----
+
+template<class S>
+template<typename T>
+bool class_factory_base::prop_enum_input_converter<S>::stream_array(T*, usize_t, meta_case<-1> default_)
+{
+  // not plain data array => read objects one at the time
+  return false;
+}
 //----------------------------------------------------------------------------
 
 
@@ -1037,6 +1138,12 @@ class_repository<B>::~class_repository()
 object_repository_pool::object_repository_pool()
 {
   m_parent=0;
+  m_budget=0;
+  m_num_bytes=0;
+  m_access_tick=0;
+  m_num_hits=0;
+  m_num_misses=0;
+  m_num_evicts=0;
 }
 //----------------------------------------------------------------------------
 
@@ -1044,6 +1151,18 @@ object_repository_pool *object_repository_pool::parent() const
 {
   return m_parent;
 }
+//----
+
+void object_repository_pool::set_budget(usize_t num_bytes_)
+{
+  m_budget=num_bytes_;
+}
+//----
+
+usize_t object_repository_pool::budget() const
+{
+  return m_budget;
+}
 //----------------------------------------------------------------------------
 
 
@@ -1076,6 +1195,20 @@ void object_repository<B>::remove_object(B &object_)
 }
 //----
 
+template<class B>
+void object_repository<B>::ref_object(B &object_)
+{
+  object_repository_base::ref_object(&object_);
+}
+//----
+
+template<class B>
+void object_repository<B>::unref_object(B &object_)
+{
+  object_repository_base::unref_object(&object_);
+}
+//----
+
 template<class B>
 B *object_repository<B>::find_object(const str_id &id_) const
 {
@@ -1098,6 +1231,23 @@ B *object_repository<B>::load_object(const str_id &id_, bin_input_stream_base &s
   PFC_ASSERT(id_.c_str());
   return static_cast<B*>(object_repository_base::load_object(id_, s_, file_ext_, path_, type_id<B>::id));
 }
+//----
+
+template<class B>
+object_load_future<B> object_repository<B>::load_object_async(const str_id &id_, const char *file_ext_, const char *path_)
+{
+  PFC_ASSERT(id_.c_str());
+  return object_repository_base::load_object_async(id_, file_ext_, path_, type_id<B>::id);
+}
+//----
+
+template<class B>
+template<typename U>
+object_load_future<B> object_repository<B>::load_object_async(const str_id &id_, void(*callback_)(B*, U*), U *user_data_, const char *file_ext_, const char *path_)
+{
+  PFC_ASSERT(id_.c_str());
+  return object_repository_base::load_object_async(id_, file_ext_, path_, type_id<B>::id, (void(*)(void*, void*))callback_, (void*)user_data_);
+}
 //----------------------------------------------------------------------------
 
 template<class B>
@@ -1144,6 +1294,69 @@ void object_repository<B>::clear_container(repository_container &c_)
   }
   c_.clear();
 }
+//----
+
+template<class B>
+void object_repository<B>::delete_object(void *p_)
+{
+  B *p=static_cast<B*>(p_);
+  p->debug_object_name.value=0;
+  PFC_DELETE(p);
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// object_load_future_base
+//============================================================================
+bool object_load_future_base::is_valid() const
+{
+  return m_request!=0;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// object_load_future
+//============================================================================
+template<class B>
+object_load_future<B>::object_load_future()
+{
+}
+//----
+
+template<class B>
+object_load_future<B>::object_load_future(const object_load_future_base &f_)
+  :object_load_future_base(f_)
+{
+}
+//----------------------------------------------------------------------------
+
+template<class B>
+B *object_load_future<B>::wait() const
+{
+  return static_cast<B*>(object_load_future_base::wait());
+}
+//----
+
+template<class B>
+B *object_load_future<B>::object() const
+{
+  return static_cast<B*>(object_load_future_base::object());
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// object_load_desc
+//============================================================================
+object_load_desc::object_load_desc()
+{
+  repository=0;
+  file_ext=0;
+  path=0;
+  type_id=0;
+}
 //----------------------------------------------------------------------------
 
 
@@ -1159,6 +1372,7 @@ prop_enum_input_archive<S>::prop_enum_input_archive(S &s_, const char *file_ext_
   ,m_root_factory(0)
   ,m_num_composite_sigs(0)
   ,m_composite_sigs(0)
+  ,m_num_object_bytes(0)
 {
   // read and check archive version
   uint16_t arch_ver;
@@ -1271,6 +1485,7 @@ prop_enum_input_archive<S>::prop_enum_input_archive(S &s_, const char *file_ext_
     classes[factory_idx].flags=class_flags;
     classes[factory_idx].num_instancies=num_inst;
     classes[factory_idx].total_bytes=total_bytes;
+    m_num_object_bytes+=total_bytes;
     ++factory_idx;
     if(fact)
     {
@@ -1318,6 +1533,7 @@ prop_enum_input_archive<S>::prop_enum_input_archive(S &s_, const char *file_ext_
       classes[factory_idx].flags=class_flags;
       classes[factory_idx].num_instancies=num_inst;
       classes[factory_idx].total_bytes=total_bytes;
+      m_num_object_bytes+=total_bytes;
       ++factory_idx;
       if(fact)
       {
@@ -1463,6 +1679,14 @@ bool prop_enum_input_archive<S>::has_type_info() const
 {
   return m_has_type_info;
 }
+//----
+
+template<class S>
+usize_t prop_enum_input_archive<S>::num_object_bytes() const
+{
+  // total archived bytes of the objects (available only for archives with type info)
+  return m_num_object_bytes;
+}
 //----------------------------------------------------------------------------
 
 template<class S>
@@ -1574,14 +1798,11 @@ bool prop_enum_input_archive<S>::avar(T *a_, usize_t size_, unsigned flags_, con
   }
 #endif
 
-  // read array objects
-  for(usize_t i=0; i<size_; ++i)
-    stream(a_[i], meta_case<is_type_equal<T, bool>::res?0:
-                            is_type_fund<T>::res?1:
-                            is_type_enum<T>::res?2:
-                            is_type_class<T>::res?3:
-                            is_type_ptr<T>::res?4:
-                            -1>());
+  // read array objects (plain data arrays in bulk)
+  stream_array(a_, size_, meta_case<!is_type_pod_archive<T>::res?-1:
+                                    S::is_big_endian==PFC_BIG_ENDIAN?0:
+                                    is_type_fund<T>::res?1:
+                                    -1>());
   return true;
 }
 //----
@@ -1748,6 +1969,40 @@ void prop_enum_input_archive<S>::stream(T &v_, meta_case<-1> default_)
 {
   PFC_STATIC_ERROR(T, no_archiving_defined_for_the_type);
 }
+//----
+
+template<class S>
+template<typename T>
+void prop_enum_input_archive<S>::stream_array(T *a_, usize_t size_, meta_case<0> is_type_pod_archive_)
+{
+  // read plain data array with a single read
+  m_stream.read_bytes(a_, sizeof(T)*size_);
+}
+//----
+
+template<class S>
+template<typename T>
+void prop_enum_input_archive<S>::stream_array(T *a_, usize_t size_, meta_case<1> is_type_swapped_pod_archive_)
+{
+  // read plain data array with a single read and swap bytes of the values in place
+  m_stream.read_bytes(a_, sizeof(T)*size_);
+  swap_bytes(a_, size_);
+}
+//----
+
+template<class S>
+template<typename T>
+void prop_enum_input_archive<S>::stream_array(T *a_, usize_t size_, meta_case<-1> default_)
+{
+  // read array objects one at the time
+  for(usize_t i=0; i<size_; ++i)
+    stream(a_[i], meta_case<is_type_equal<T, bool>::res?0:
+                            is_type_fund<T>::res?1:
+                            is_type_enum<T>::res?2:
+                            is_type_class<T>::res?3:
+                            is_type_ptr<T>::res?4:
+                            -1>());
+}
 //----------------------------------------------------------------------------
 
 
@@ -1929,6 +2184,16 @@ bool prop_enum_output_archive<S>::avar(const T *a_, usize_t size_, unsigned flag
         m_cur_collected_class->total_bytes+=sizeof(archive_array_size_t);
     }
 #endif
+    if(is_type_pod_archive<T>::res)
+    {
+      // collect type info only from the first item (plain data array doesn't have pointers)
+      if(size_)
+      {
+        collect_pointers(a_[0], meta_case<!is_type_pod_archive<T>::res?-2:is_type_class<T>::res?0:-1>());
+        m_cur_collected_class->total_bytes+=sizeof(T)*(size_-1);
+      }
+      return true;
+    }
     for(usize_t i=0; i<size_; ++i)
       collect_pointers(a_[i], meta_case<is_type_class<T>::res?0:
                                         is_ptr_orep<T>::res?1:
@@ -1952,14 +2217,11 @@ bool prop_enum_output_archive<S>::avar(const T *a_, usize_t size_, unsigned flag
     }
 #endif
 
-    // save object array
-    for(usize_t i=0; i<size_; ++i)
-      stream(a_[i], meta_case<is_type_class<T>::res?0:
-                              is_type_ptr<T>::res?1:
-                              is_type_equal<T, bool>::res?2:
-                              is_type_fund<T>::res?3:
-                              is_type_enum<T>::res?4:
-                              -1>());
+    // save object array (plain data arrays in bulk)
+    stream_array(a_, size_, meta_case<!is_type_pod_archive<T>::res?-1:
+                                      S::is_big_endian==PFC_BIG_ENDIAN?0:
+                                      is_type_fund<T>::res?1:
+                                      -1>());
   }
   return true;
 }
@@ -2283,6 +2545,49 @@ void prop_enum_output_archive<S>::stream(const T &v_, meta_case<-1> default_)
 }
 //----
 
+template<class S>
+template<typename T>
+void prop_enum_output_archive<S>::stream_array(const T *a_, usize_t size_, meta_case<0> is_type_pod_archive_)
+{
+  // write plain data array with a single write
+  m_stream.write_bytes(a_, sizeof(T)*size_);
+}
+//----
+
+template<class S>
+template<typename T>
+void prop_enum_output_archive<S>::stream_array(const T *a_, usize_t size_, meta_case<1> is_type_swapped_pod_archive_)
+{
+  // swap bytes of the values in blocks and write the blocks
+  enum {block_size=4096/sizeof(T)};
+  T block[block_size];
+  while(size_)
+  {
+    usize_t num_values=min<usize_t>(size_, block_size);
+    mem_copy(block, a_, sizeof(T)*num_values);
+    swap_bytes(block, num_values);
+    m_stream.write_bytes(block, sizeof(T)*num_values);
+    a_+=num_values;
+    size_-=num_values;
+  }
+}
+//----
+
+template<class S>
+template<typename T>
+void prop_enum_output_archive<S>::stream_array(const T *a_, usize_t size_, meta_case<-1> default_)
+{
+  // write array objects one at the time
+  for(usize_t i=0; i<size_; ++i)
+    stream(a_[i], meta_case<is_type_class<T>::res?0:
+                            is_type_ptr<T>::res?1:
+                            is_type_equal<T, bool>::res?2:
+                            is_type_fund<T>::res?3:
+                            is_type_enum<T>::res?4:
+                            -1>());
+}
+//----
+
 template<class S>
 void prop_enum_output_archive<S>::init_save()
 {
@@ -23,6 +23,7 @@ namespace pfc
 #define PFC_BUILDOP_ARCHIVE_ENDIAN_SUPPORT   // support reading/writing different endian archive files
 #define PFC_BUILDOP_INTRINSICS               // use compiler intrinsics
 #define PFC_BUILDOP_INTRINSICS_BMI2          // use BMI2 intrinsics
+//#define PFC_BUILDOP_MP_HEAP                // use thread-caching size-class heap (mp_heap_alloc()/mp_heap_free()) for mem_alloc()/mem_free()
 // per build config
 #define PFC_BUILDOP_MEMORY_TRACKING          // track memory usage
 #define PFC_BUILDOP_EXCEPTIONS               // support exceptions
@@ -59,6 +60,7 @@ namespace pfc
 // platform specific config
 //============================================================================
 //#define PFC_PLATFORM_SSE4  // enable SSE4 intrinsics
+//#define PFC_PLATFORM_AVX   // enable AVX intrinsics (8-wide SoA kernels)
 //----------------------------------------------------------------------------
 
 
@@ -83,6 +85,7 @@ namespace pfc
 #define PFC_ENGINEOP_OBJ             // enable support for loading OBJ 3D files (Wavefront Object)
 // data compression support
 #define PFC_ENGINEOP_ZLIB            // enable support for decompressing zip files ("zlib" library)
+#define PFC_ENGINEOP_LZ4             // enable support for LZ4 compressed streams ("lz4" library)
 // misc feature support
 #define PFC_ENGINEOP_NVTEXTURETOOLS  // enable support for converting textures to DXT and generating mipmaps ("NVIDIA Texture Tools" library)
 //#define PFC_ENGINEOP_NVTRISTRIP      // enable support for optimizing 3D mesh geometry ("NvTriStrip" library)
@@ -174,9 +177,6 @@ namespace pfc
 #define PFC_COMPILER_STR gcc
 #define PFC_COMPILER_SRC_STR gcc
 #define PFC_COMPILER_LIB_EXT .a
-#ifdef PFC_BUILDOP_PROFILING
-#undef PFC_BUILDOP_PROFILING // bugs in GCC: linear_search() (and probably other searches) for an array fails to properly construct 0-pointer if no match is found
-#endif
 #else
 #error Target compiler not supported.
 #endif
@@ -24,10 +24,13 @@ struct compare_predicate;
 template<typename> class owner_array;
 template<typename> class array;
 template<typename, usize_t capacity> class sarray;
+template<typename, usize_t capacity> class small_array;
 template<typename> class deque;
 template<typename> class list;
 template<typename T, class CmpPred=compare_predicate> class set;
 template<typename K, typename T, class CmpPred=compare_predicate> class map;
+template<typename T, class CmpPred=compare_predicate> class btree_set;
+template<typename K, typename T, class CmpPred=compare_predicate> class btree_map;
 template<typename T> class hash_table_array;
 template<typename T, usize_t capacity> class hash_table_sarray;
 template<typename T> class hash_table_deque;
@@ -41,10 +44,13 @@ class str_pool;
 template<typename T> PFC_INLINE void swap(owner_array<T>&, owner_array<T>&);
 template<typename T> PFC_INLINE void swap(array<T>&, array<T>&);
 template<typename T, usize_t capacity> PFC_INLINE void swap(sarray<T, capacity>&, sarray<T, capacity>&);
+template<typename T, usize_t capacity> PFC_INLINE void swap(small_array<T, capacity>&, small_array<T, capacity>&);
 template<typename T> PFC_INLINE void swap(deque<T>&, deque<T>&);
 template<typename T> PFC_INLINE void swap(list<T>&, list<T>&);
 template<typename T, class CmpPred> PFC_INLINE void swap(set<T, CmpPred>&, set<T, CmpPred>&);
 template<typename K, typename T, class CmpPred> PFC_INLINE void swap(map<K, T, CmpPred>&, map<K, T, CmpPred>&);
+template<typename T, class CmpPred> PFC_INLINE void swap(btree_set<T, CmpPred>&, btree_set<T, CmpPred>&);
+template<typename K, typename T, class CmpPred> PFC_INLINE void swap(btree_map<K, T, CmpPred>&, btree_map<K, T, CmpPred>&);
 template<typename T, class Config> PFC_INLINE void swap(hash_set<T, Config>&, hash_set<T, Config>&);
 template<typename K, typename T, class Config> PFC_INLINE void swap(hash_map<K, T, Config>&, hash_map<K, T, Config>&);
 template<typename K, typename T, class KConfig, class VConfig> PFC_INLINE void swap(hash_bimap<K, T, KConfig, VConfig>&, hash_bimap<K, T, KConfig, VConfig>&);
@@ -281,6 +287,108 @@ PFC_SET_TYPE_TRAIT_PARTIAL2(typename T, usize_t cap, sarray<T, cap>, is_type_pod
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// small_array
+//============================================================================
+// Array which stores up to cap items inline and moves the items to the heap
+// (default memory allocator) only when the capacity is exceeded. The heap
+// pointer shares the storage with the inline items, so the array is
+// pod-movable if T is.
+template<typename T, usize_t cap>
+class small_array
+{ PFC_MONO(small_array) PFC_INTROSPEC_DECL;
+public:
+  // nested types
+  typedef const T *const_iterator;
+  typedef T *iterator;
+  typedef array_iterator<typename add_const<T>::res, false> const_reverse_iterator;
+  typedef array_iterator<T, false> reverse_iterator;
+  //--------------------------------------------------------------------------
+
+  // construction
+  small_array();
+  small_array(const small_array&);
+  explicit small_array(usize_t size_);
+  small_array(usize_t size_, const T&);
+  PFC_INLINE ~small_array();
+  void operator=(const small_array&);
+  void clear();
+  void reset_size(usize_t size_);
+  void reset_size(usize_t size_, const T&);
+  void resize(usize_t size_);
+  void resize(usize_t size_, const T&);
+  void resize_to_zero();
+  void reserve(usize_t capacity_);
+  void trim(usize_t permitted_slack_=0);
+  void swap(small_array&);
+  //--------------------------------------------------------------------------
+
+  // accessors and mutators
+  PFC_INLINE usize_t size() const;
+  PFC_INLINE usize_t capacity() const;
+  PFC_INLINE bool is_local() const;
+  PFC_INLINE const T &operator[](usize_t idx_) const;
+  PFC_INLINE T &operator[](usize_t idx_);
+  PFC_INLINE const T &front() const;
+  PFC_INLINE T &front();
+  PFC_INLINE const T &back() const;
+  PFC_INLINE T &back();
+  PFC_INLINE const T *data() const;
+  PFC_INLINE T *data();
+  PFC_INLINE const_iterator begin() const;
+  PFC_INLINE iterator begin();
+  PFC_INLINE const_reverse_iterator rbegin() const;
+  PFC_INLINE reverse_iterator rbegin();
+  PFC_INLINE const_iterator last() const;
+  PFC_INLINE iterator last();
+  PFC_INLINE const_reverse_iterator rlast() const;
+  PFC_INLINE reverse_iterator rlast();
+  PFC_INLINE const_iterator end() const;
+  PFC_INLINE iterator end();
+  PFC_INLINE const_reverse_iterator rend() const;
+  PFC_INLINE reverse_iterator rend();
+  PFC_INLINE void get(usize_t start_idx_, T*, usize_t num_items_) const;
+  PFC_INLINE void set(usize_t start_idx_, const T*, usize_t num_items_);
+  PFC_INLINE void set(usize_t start_idx_, const T&, usize_t num_items_);
+  PFC_INLINE void push_front(const T&);
+  PFC_INLINE T &push_front();
+  PFC_INLINE void push_back(const T&);
+  PFC_INLINE T &push_back();
+  PFC_INLINE void insert_front(usize_t num_items_);
+  PFC_INLINE void insert_front(usize_t num_items_, const T&);
+  PFC_INLINE void insert_front(usize_t num_items_, const T*);
+  PFC_INLINE void insert_back(usize_t num_items_);
+  PFC_INLINE void insert_back(usize_t num_items_, const T&);
+  PFC_INLINE void insert_back(usize_t num_items_, const T*);
+  PFC_INLINE void pop_front();
+  PFC_INLINE void pop_back();
+  PFC_INLINE void remove_front(usize_t num_items_);
+  PFC_INLINE void remove_back(usize_t num_items_);
+  PFC_INLINE void remove(T&);
+  PFC_INLINE void remove_unordered(T&);
+  PFC_INLINE void remove_at(usize_t idx_);
+  PFC_INLINE void remove_at(usize_t idx_, usize_t num_items_);
+  PFC_INLINE void remove_at_unordered(usize_t idx_);
+  //--------------------------------------------------------------------------
+
+private:
+  PFC_INLINE T *items() const;
+  void reserve(usize_t capacity_, usize_t offset_);
+  void take(small_array&);
+  //--------------------------------------------------------------------------
+
+  usize_t m_size;
+  usize_t m_capacity;
+  union
+  {
+    T *m_data;
+    typename meta_storage<T>::res m_local[cap];
+  };
+};
+PFC_SET_TYPE_TRAIT_PARTIAL2(typename T, usize_t cap, small_array<T, cap>, is_type_pod_move, is_type_pod_move<T>::res);
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // deque
 //============================================================================
@@ -1040,6 +1148,427 @@ private:
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// btree_set
+//============================================================================
+// Ordered set stored in a B+tree: items are kept sorted in wide leaf nodes
+// linked in order and branch nodes store copies of separating keys. Has the
+// same interface and ordering semantics as set, but with far fewer
+// allocations and cache misses for lookups and ordered iteration. Inserts
+// and erases invalidate all iterators.
+template<typename T, class CmpPred=compare_predicate>
+struct btree_set_traits
+{
+  // properties
+  enum {node_size=256};
+};
+//----------------------------------------------------------------------------
+
+template<typename T, class CmpPred>
+class btree_set
+{ PFC_MONO(btree_set) PFC_INTROSPEC_DECL;
+public:
+  // nested types
+  class const_iterator;
+  class iterator;
+  struct inserter {iterator it; bool is_new;};
+  //--------------------------------------------------------------------------
+
+  // construction
+  btree_set(const CmpPred &cmp_pred_=CmpPred(), memory_allocator_base *alloc_=0);
+  btree_set(const T *sorted_items_, usize_t num_items_, const CmpPred &cmp_pred_=CmpPred(), memory_allocator_base *alloc_=0);
+  btree_set(const btree_set&);
+  btree_set(const btree_set&, memory_allocator_base*);
+  PFC_INLINE ~btree_set();
+  void operator=(const btree_set&);
+  void set_allocator(memory_allocator_base*);
+  void clear();
+  PFC_INLINE void swap(btree_set&);
+  void validate_btree_state() const;
+  //--------------------------------------------------------------------------
+
+  // accessors and mutators
+  PFC_INLINE memory_allocator_base &allocator() const;
+  PFC_INLINE usize_t size() const;
+  template<typename K> PFC_INLINE const_iterator find(const K&) const;
+  template<typename K> PFC_INLINE iterator find(const K&);
+  template<typename K> PFC_INLINE const_iterator lower_bound(const K&) const;
+  template<typename K> PFC_INLINE iterator lower_bound(const K&);
+  template<typename K> PFC_INLINE const_iterator upper_bound(const K&) const;
+  template<typename K> PFC_INLINE iterator upper_bound(const K&);
+  PFC_INLINE const_iterator begin() const;
+  PFC_INLINE iterator begin();
+  PFC_INLINE const_iterator end() const;
+  PFC_INLINE iterator end();
+  template<typename K> inserter insert(const K&, bool replace_=true);
+  void erase(iterator&);
+  //--------------------------------------------------------------------------
+
+private:
+  enum {node_size=btree_set_traits<T, CmpPred>::node_size,
+        leaf_capacity=(node_size-3*sizeof(void*))/sizeof(T)>5?(node_size-3*sizeof(void*))/sizeof(T)-1:4,
+        branch_capacity=(node_size-2*sizeof(void*))/(sizeof(T)+sizeof(void*))>4?(node_size-2*sizeof(void*))/(sizeof(T)+sizeof(void*))-1:3,
+        leaf_min_items=leaf_capacity/2,
+        branch_min_keys=branch_capacity/2,
+        max_depth=32};
+  struct leaf;
+  struct branch;
+  template<class U> void bulk_load(U, usize_t num_items_);
+  leaf *alloc_leaf();
+  branch *alloc_branch();
+  void destroy_subtree(void*, unsigned depth_);
+  void add_separator(branch *const*, const unsigned *path_idx_, const T&, void *right_);
+  void rebalance(branch *const*, const unsigned *path_idx_, leaf&);
+  template<typename K> leaf *find_leaf(const K&, branch **path_=0, unsigned *path_idx_=0) const;
+  template<typename K> PFC_INLINE unsigned lower_idx(const T*, unsigned num_items_, const K&) const;
+  template<typename K> PFC_INLINE unsigned upper_idx(const T*, unsigned num_items_, const K&) const;
+  void validate_btree_state(const void*, unsigned depth_, const T *min_, const T *max_, usize_t &num_items_, const leaf *&prev_leaf_) const;
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // btree_set::leaf
+  //==========================================================================
+  struct leaf
+  {
+    PFC_INLINE T *items() {return (T*)item_data;}
+    //------------------------------------------------------------------------
+
+    unsigned num_items;
+    leaf *prev, *next;
+    typename meta_storage<T>::res item_data[leaf_capacity+1];
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // btree_set::branch
+  //==========================================================================
+  struct branch
+  {
+    PFC_INLINE T *keys() {return (T*)key_data;}
+    //------------------------------------------------------------------------
+
+    unsigned num_keys;
+    void *children[branch_capacity+2];
+    typename meta_storage<T>::res key_data[branch_capacity+1];
+  };
+  //--------------------------------------------------------------------------
+
+  CmpPred m_cmp_pred;
+  memory_allocator_base *m_allocator;
+  usize_t m_size;
+  void *m_root;
+  unsigned m_depth;
+};
+PFC_SET_TYPE_TRAIT_PARTIAL2(typename T, class CmpPred, btree_set<T, CmpPred>, is_type_pod_move, true);
+//----------------------------------------------------------------------------
+
+//============================================================================
+// btree_set::const_iterator
+//============================================================================
+template<typename T, class CmpPred>
+class btree_set<T, CmpPred>::const_iterator
+{
+public:
+  // nested types
+  typedef T value_t;
+  //--------------------------------------------------------------------------
+
+  // construction
+  PFC_INLINE const_iterator();
+  PFC_INLINE const_iterator(const iterator&);
+  PFC_INLINE void reset();
+  //--------------------------------------------------------------------------
+
+  // iteration
+  PFC_INLINE friend bool is_valid(const const_iterator &it_)  {return it_.m_leaf!=0;}
+  PFC_INLINE bool operator==(const const_iterator&) const;
+  PFC_INLINE bool operator==(const iterator&) const;
+  PFC_INLINE bool operator!=(const const_iterator&) const;
+  PFC_INLINE bool operator!=(const iterator&) const;
+  PFC_INLINE const_iterator &operator++();
+  PFC_INLINE const T &operator*() const;
+  PFC_INLINE const T *operator->() const;
+  PFC_INLINE friend const T *ptr(const const_iterator &it_)   {return it_.m_leaf?it_.m_leaf->items()+it_.m_idx:0;}
+  //--------------------------------------------------------------------------
+
+private:
+  friend class btree_set<T, CmpPred>;
+  PFC_INLINE const_iterator(leaf*, unsigned idx_);
+  //--------------------------------------------------------------------------
+
+  leaf *m_leaf;
+  unsigned m_idx;
+};
+//----------------------------------------------------------------------------
+
+//============================================================================
+// btree_set::iterator
+//============================================================================
+template<typename T, class CmpPred>
+class btree_set<T, CmpPred>::iterator
+{
+public:
+  // nested types
+  typedef T value_t;
+  //--------------------------------------------------------------------------
+
+  // construction
+  PFC_INLINE iterator();
+  PFC_INLINE void reset();
+  //--------------------------------------------------------------------------
+
+  // iteration
+  PFC_INLINE friend bool is_valid(const iterator &it_)  {return it_.m_leaf!=0;}
+  PFC_INLINE bool operator==(const const_iterator&) const;
+  PFC_INLINE bool operator==(const iterator&) const;
+  PFC_INLINE bool operator!=(const const_iterator&) const;
+  PFC_INLINE bool operator!=(const iterator&) const;
+  PFC_INLINE iterator &operator++();
+  PFC_INLINE const T &operator*() const;
+  PFC_INLINE const T *operator->() const;
+  PFC_INLINE friend const T *ptr(const iterator &it_)   {return it_.m_leaf?it_.m_leaf->items()+it_.m_idx:0;}
+  //--------------------------------------------------------------------------
+
+private:
+  friend class btree_set<T, CmpPred>;
+  friend class const_iterator;
+  PFC_INLINE iterator(leaf*, unsigned idx_);
+  //--------------------------------------------------------------------------
+
+  leaf *m_leaf;
+  unsigned m_idx;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// btree_map
+//============================================================================
+// Ordered map stored in a B+tree (see btree_set). Leaves store keys and
+// values in separate arrays and branches store copies of separating keys.
+// Inserts and erases invalidate all iterators.
+template<typename K, typename T, class CmpPred=compare_predicate>
+struct btree_map_traits
+{
+  // properties
+  enum {node_size=256};
+};
+//----------------------------------------------------------------------------
+
+template<typename K, typename T, class CmpPred>
+class btree_map
+{ PFC_MONO(btree_map) PFC_INTROSPEC_DECL;
+public:
+  // nested types
+  class const_iterator;
+  class iterator;
+  struct inserter {iterator it; bool is_new;};
+  //--------------------------------------------------------------------------
+
+  // construction
+  btree_map(const CmpPred &cmp_pred_=CmpPred(), memory_allocator_base *alloc_=0);
+  btree_map(const K *sorted_keys_, const T *values_, usize_t num_items_, const CmpPred &cmp_pred_=CmpPred(), memory_allocator_base *alloc_=0);
+  btree_map(const btree_map&);
+  btree_map(const btree_map&, memory_allocator_base*);
+  PFC_INLINE ~btree_map();
+  void operator=(const btree_map&);
+  void set_allocator(memory_allocator_base*);
+  void clear();
+  PFC_INLINE void swap(btree_map&);
+  void validate_btree_state() const;
+  //--------------------------------------------------------------------------
+
+  // accessors and mutators
+  PFC_INLINE memory_allocator_base &allocator() const;
+  PFC_INLINE usize_t size() const;
+  template<typename K1> PFC_INLINE const T &operator[](const K1&) const;
+  template<typename K1> PFC_INLINE T &operator[](const K1&);
+  template<typename K1> PFC_INLINE const_iterator find(const K1&) const;
+  template<typename K1> PFC_INLINE iterator find(const K1&);
+  template<typename K1> PFC_INLINE const_iterator lower_bound(const K1&) const;
+  template<typename K1> PFC_INLINE iterator lower_bound(const K1&);
+  template<typename K1> PFC_INLINE const_iterator upper_bound(const K1&) const;
+  template<typename K1> PFC_INLINE iterator upper_bound(const K1&);
+  PFC_INLINE const_iterator begin() const;
+  PFC_INLINE iterator begin();
+  PFC_INLINE const_iterator end() const;
+  PFC_INLINE iterator end();
+  inserter insert(const K&, const T&, bool replace_=true);
+  inserter insert(const K&, bool replace_=true);
+  void erase(iterator&);
+  //--------------------------------------------------------------------------
+
+private:
+  enum {node_size=btree_map_traits<K, T, CmpPred>::node_size,
+        leaf_capacity=(node_size-3*sizeof(void*))/(sizeof(K)+sizeof(T))>5?(node_size-3*sizeof(void*))/(sizeof(K)+sizeof(T))-1:4,
+        branch_capacity=(node_size-2*sizeof(void*))/(sizeof(K)+sizeof(void*))>4?(node_size-2*sizeof(void*))/(sizeof(K)+sizeof(void*))-1:3,
+        leaf_min_items=leaf_capacity/2,
+        branch_min_keys=branch_capacity/2,
+        max_depth=32};
+  struct item;
+  struct array_iterator;
+  struct leaf;
+  struct branch;
+  template<class U> void bulk_load(U, usize_t num_items_);
+  leaf *alloc_leaf();
+  branch *alloc_branch();
+  void destroy_subtree(void*, unsigned depth_);
+  inserter insert_item(const K&, const T *v_, bool replace_);
+  void add_separator(branch *const*, const unsigned *path_idx_, const K&, void *right_);
+  void rebalance(branch *const*, const unsigned *path_idx_, leaf&);
+  template<typename K1> leaf *find_leaf(const K1&, branch **path_=0, unsigned *path_idx_=0) const;
+  template<typename K1> PFC_INLINE unsigned lower_idx(const K*, unsigned num_keys_, const K1&) const;
+  template<typename K1> PFC_INLINE unsigned upper_idx(const K*, unsigned num_keys_, const K1&) const;
+  void validate_btree_state(const void*, unsigned depth_, const K *min_, const K *max_, usize_t &num_items_, const leaf *&prev_leaf_) const;
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // btree_map::item
+  //==========================================================================
+  struct item
+  { PFC_MONO(item) {PFC_VAR2(key, val);}
+    K &key;
+    T &val;
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // btree_map::array_iterator
+  //==========================================================================
+  struct array_iterator
+  {
+    PFC_INLINE const K &key() const {return *keys;}
+    PFC_INLINE const T &operator*() const {return *values;}
+    PFC_INLINE void operator++() {++keys; ++values;}
+    //------------------------------------------------------------------------
+
+    const K *keys;
+    const T *values;
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // btree_map::leaf
+  //==========================================================================
+  struct leaf
+  {
+    PFC_INLINE K *keys() {return (K*)key_data;}
+    PFC_INLINE T *vals() {return (T*)val_data;}
+    //------------------------------------------------------------------------
+
+    unsigned num_items;
+    leaf *prev, *next;
+    typename meta_storage<K>::res key_data[leaf_capacity+1];
+    typename meta_storage<T>::res val_data[leaf_capacity+1];
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // btree_map::branch
+  //==========================================================================
+  struct branch
+  {
+    PFC_INLINE K *keys() {return (K*)key_data;}
+    //------------------------------------------------------------------------
+
+    unsigned num_keys;
+    void *children[branch_capacity+2];
+    typename meta_storage<K>::res key_data[branch_capacity+1];
+  };
+  //--------------------------------------------------------------------------
+
+  CmpPred m_cmp_pred;
+  memory_allocator_base *m_allocator;
+  usize_t m_size;
+  void *m_root;
+  unsigned m_depth;
+};
+PFC_SET_TYPE_TRAIT_PARTIAL3(typename K, typename T, class CmpPred, btree_map<K, T, CmpPred>, is_type_pod_move, true);
+//----------------------------------------------------------------------------
+
+//============================================================================
+// btree_map::const_iterator
+//============================================================================
+template<typename K, typename T, class CmpPred>
+class btree_map<K, T, CmpPred>::const_iterator
+{
+public:
+  // nested types
+  typedef K key_t;
+  typedef T value_t;
+  //--------------------------------------------------------------------------
+
+  // construction
+  PFC_INLINE const_iterator();
+  PFC_INLINE const_iterator(const iterator&);
+  PFC_INLINE void reset();
+  //--------------------------------------------------------------------------
+
+  // iteration
+  PFC_INLINE friend bool is_valid(const const_iterator &it_)  {return it_.m_leaf!=0;}
+  PFC_INLINE bool operator==(const const_iterator&) const;
+  PFC_INLINE bool operator==(const iterator&) const;
+  PFC_INLINE bool operator!=(const const_iterator&) const;
+  PFC_INLINE bool operator!=(const iterator&) const;
+  PFC_INLINE const_iterator &operator++();
+  PFC_INLINE const T &operator*() const;
+  PFC_INLINE const T *operator->() const;
+  PFC_INLINE friend const T *ptr(const const_iterator &it_)   {return it_.m_leaf?it_.m_leaf->vals()+it_.m_idx:0;}
+  PFC_INLINE const K &key() const;
+  //--------------------------------------------------------------------------
+
+private:
+  friend class btree_map<K, T, CmpPred>;
+  PFC_INLINE const_iterator(leaf*, unsigned idx_);
+  //--------------------------------------------------------------------------
+
+  leaf *m_leaf;
+  unsigned m_idx;
+};
+//----------------------------------------------------------------------------
+
+//============================================================================
+// btree_map::iterator
+//============================================================================
+template<typename K, typename T, class CmpPred>
+class btree_map<K, T, CmpPred>::iterator
+{
+public:
+  // nested types
+  typedef K key_t;
+  typedef T value_t;
+  //--------------------------------------------------------------------------
+
+  // construction
+  PFC_INLINE iterator();
+  PFC_INLINE void reset();
+  //--------------------------------------------------------------------------
+
+  // iteration
+  PFC_INLINE friend bool is_valid(const iterator &it_)  {return it_.m_leaf!=0;}
+  PFC_INLINE bool operator==(const const_iterator&) const;
+  PFC_INLINE bool operator==(const iterator&) const;
+  PFC_INLINE bool operator!=(const const_iterator&) const;
+  PFC_INLINE bool operator!=(const iterator&) const;
+  PFC_INLINE iterator &operator++();
+  PFC_INLINE T &operator*() const;
+  PFC_INLINE T *operator->() const;
+  PFC_INLINE friend T *ptr(const iterator &it_)         {return it_.m_leaf?it_.m_leaf->vals()+it_.m_idx:0;}
+  PFC_INLINE const K &key() const;
+  //--------------------------------------------------------------------------
+
+private:
+  friend class btree_map<K, T, CmpPred>;
+  friend class const_iterator;
+  PFC_INLINE iterator(leaf*, unsigned idx_);
+  //--------------------------------------------------------------------------
+
+  leaf *m_leaf;
+  unsigned m_idx;
+};
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // hash_table_array
 //============================================================================
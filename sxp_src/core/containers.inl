@@ -1421,9 +1421,9 @@ void sarray<T, cap>::remove_back(usize_t num_items_)
 
 
 //============================================================================
-// deque
+// small_array
 //============================================================================
-PFC_INTROSPEC_INL_TDEF1(typename T, deque<T>)
+PFC_INTROSPEC_INL_TDEF2(typename T, usize_t cap, small_array<T, cap>)
 {
   PFC_CUSTOM_STREAMING(0);
   switch(unsigned(PE::pe_type))
@@ -1436,2492 +1436,4812 @@ PFC_INTROSPEC_INL_TDEF1(typename T, deque<T>)
       uint32_t size;
       pe_.var(size);
       resize(size);
-      for(uint32_t i=0; i<size; ++i)
-        pe_.var((*this)[i], i?mvarflag_array_tail:0);
+      pe_.avar(items(), size);
     } break;
 
     case penum_output:
     case penum_display:
     {
       // write/display data
-      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize deque<%s> that contains more than 2^32-1 elements\r\n", typeid(T).name()));
+      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize small_array<%s> that contains more than 2^32-1 elements\r\n", typeid(T).name()));
       uint32_t size=(uint32_t)m_size;
       pe_.var(size, 0, "size");
-      for(uint32_t i=0; i<size; ++i)
-        pe_.var((*this)[i], mvarflag_mutable|mvarflag_mutable_ptr|(i?mvarflag_array_tail:0));
+      pe_.avar(items(), size, mvarflag_mutable|mvarflag_mutable_ptr);
     } break;
   }
 }
 //----------------------------------------------------------------------------
 
-template<typename T>
-deque<T>::deque(memory_allocator_base *alloc_)
-  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
-  ,m_size(0)
-  ,m_offset(0)
-  ,m_first(0)
-  ,m_last(0)
-  ,m_stride_last(0)
-{
-  PFC_ASSERT_CALL(m_allocator->check_allocator(deque_traits<T>::block_alloc_size, deque_traits<T>::block_alloc_align));
-}
-//----
-
-template<typename T>
-deque<T>::deque(const deque &dq_)
-  :m_allocator(&default_memory_allocator::inst())
+template<typename T, usize_t cap>
+small_array<T, cap>::small_array()
+  :m_size(0)
+  ,m_capacity(cap)
 {
-  PFC_MEM_TRACK_STACK();
-  cctor(dq_);
+  PFC_STATIC_ASSERT(cap>0);
 }
 //----
 
-template<typename T>
-deque<T>::deque(const deque &dq_, memory_allocator_base *alloc_)
-  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+template<typename T, usize_t cap>
+small_array<T, cap>::small_array(const small_array &a_)
+  :m_size(0)
+  ,m_capacity(cap)
 {
+  // copy-construct the array from array (allocate only if the items don't fit in the local storage)
   PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(deque_traits<T>::block_alloc_size, deque_traits<T>::block_alloc_align));
-  cctor(dq_);
+  usize_t size=a_.m_size;
+  eh_data<T> p(default_memory_allocator::inst(), size>cap?size:0, meta_alignof<T>::res);
+  copy_construct(p.data?p.data:(T*)m_local, a_.items(), size);
+  if(p.data)
+  {
+    m_data=p.data;
+    m_capacity=size;
+  }
+  m_size=size;
+  p.reset();
 }
 //----
 
-template<typename T>
-deque<T>::deque(usize_t size_, memory_allocator_base *alloc_)
-  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+template<typename T, usize_t cap>
+small_array<T, cap>::small_array(usize_t size_)
+  :m_size(0)
+  ,m_capacity(cap)
 {
-  // default construct the deque
+  // default construct the array
   PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(deque_traits<T>::block_alloc_size, deque_traits<T>::block_alloc_align));
-  m_size=0;
-  m_offset=0;
-  m_strides.resize((size_+deque_traits<T>::smask)>>deque_traits<T>::sshift);
-  PFC_EDTOR(*this, &deque<T>::clear);
-  usize_t idx=0;
-  while(m_size<size_)
-  {
-    // construct a stride
-    eh_data<T> p(*m_allocator, deque_traits<T>::ssize, deque_traits<T>::block_alloc_align);
-    m_strides[idx++]=p.data;
-    usize_t num_vals=min<usize_t>(size_-m_size, deque_traits<T>::ssize);
-    default_construct(p.data, num_vals);
-    p.reset();
-    m_size+=num_vals;
-  }
-  PFC_EDTOR_RESET();
-
-  // setup first & last pointers
-  if(m_size)
+  eh_data<T> p(default_memory_allocator::inst(), size_>cap?size_:0, meta_alignof<T>::res);
+  default_construct(p.data?p.data:(T*)m_local, size_);
+  if(p.data)
   {
-    m_first=m_strides.front()+m_offset;
-    m_last=m_strides.back()+((m_size-1)&deque_traits<T>::smask);
-    m_stride_last=m_strides.back()+deque_traits<T>::smask;
+    m_data=p.data;
+    m_capacity=size_;
   }
-  else
-    m_first=m_last=m_stride_last=0;
+  m_size=size_;
+  p.reset();
 }
 //----
 
-template<typename T>
-deque<T>::deque(usize_t size_, const T &v_, memory_allocator_base *alloc_)
-  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+template<typename T, usize_t cap>
+small_array<T, cap>::small_array(usize_t size_, const T &v_)
+  :m_size(0)
+  ,m_capacity(cap)
 {
-  // copy-construct the deque from the value
+  // copy-construct the array from value
   PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(deque_traits<T>::block_alloc_size, deque_traits<T>::block_alloc_align));
-  m_size=0;
-  m_offset=0;
-  m_strides.resize((size_+deque_traits<T>::smask)>>deque_traits<T>::sshift);
-  PFC_EDTOR(*this, &deque<T>::clear);
-  usize_t idx=0;
-  while(m_size<size_)
-  {
-    // construct a stride
-    eh_data<T> p(*m_allocator, deque_traits<T>::ssize, deque_traits<T>::block_alloc_align);
-    m_strides[idx++]=p.data;
-    usize_t num_vals=min<usize_t>(size_-m_size, deque_traits<T>::ssize);
-    copy_construct(p.data, v_, num_vals);
-    p.reset();
-    m_size+=num_vals;
-  }
-  PFC_EDTOR_RESET();
-
-  // setup first & last pointers
-  if(m_size)
+  eh_data<T> p(default_memory_allocator::inst(), size_>cap?size_:0, meta_alignof<T>::res);
+  copy_construct(p.data?p.data:(T*)m_local, v_, size_);
+  if(p.data)
   {
-    m_first=m_strides.front()+m_offset;
-    m_last=m_strides.back()+((m_size-1)&deque_traits<T>::smask);
-    m_stride_last=m_strides.back()+deque_traits<T>::smask;
+    m_data=p.data;
+    m_capacity=size_;
   }
-  else
-    m_first=m_last=m_stride_last=0;
+  m_size=size_;
+  p.reset();
 }
 //----
 
-template<typename T>
-deque<T>::~deque()
+template<typename T, usize_t cap>
+small_array<T, cap>::~small_array()
 {
   clear();
 }
 //----
 
-template<typename T>
-void deque<T>::operator=(const deque &dq_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::operator=(const small_array &a_)
 {
-  deque<T> dq(dq_);
-  swap(dq);
+  small_array a(a_);
+  swap(a);
 }
 //----
 
-template<typename T>
-void deque<T>::set_allocator(memory_allocator_base *alloc_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::clear()
 {
-  PFC_ASSERT_MSG(!m_size, ("Unable to change the allocator of a non-empty deque\r\n"));
-  m_allocator=alloc_?alloc_:&default_memory_allocator::inst();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(deque_traits<T>::block_alloc_size, deque_traits<T>::block_alloc_align));
+  // clear the array and release heap storage
+  T *data=items();
+  reverse_destruct(data, m_size);
+  if(m_capacity>cap)
+    default_memory_allocator::inst().free(data);
+  m_size=0;
+  m_capacity=cap;
 }
 //----
 
-template<typename T>
-void deque<T>::clear()
+template<typename T, usize_t cap>
+void small_array<T, cap>::reset_size(usize_t size_)
 {
-  // clear the deque
-  usize_t idx=0;
-  while(m_size)
-  {
-    usize_t num_vals=min(m_size, deque_traits<T>::ssize-m_offset);
-    destruct(m_strides[idx]+m_offset, num_vals);
-    m_allocator->free(m_strides[idx]);
-    m_size-=num_vals;
-    m_offset=0;
-    ++idx;
-  }
-  m_first=m_last=m_stride_last=0;
-  m_strides.clear();
+  // reset array size to given size
+  PFC_MEM_TRACK_STACK();
+  clear();
+  if(size_>cap)
+    reserve(size_, 0);
+  default_construct(items(), size_);
+  m_size=size_;
 }
 //----
 
-template<typename T>
-void deque<T>::resize(usize_t size_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::reset_size(usize_t size_, const T &v_)
 {
+  // reset array size to given size of given value
   PFC_MEM_TRACK_STACK();
-  if(size_<m_size)
-  {
-    // release elements from the end of the deque until the size matches
-    do
-    {
-      usize_t num_vals=min(((m_offset+m_size-1)&deque_traits<T>::smask)+1, m_size-size_);
-      m_size-=num_vals;
-      usize_t offset=(m_offset+m_size)&deque_traits<T>::smask;
-      reverse_destruct(m_strides.back()+offset, num_vals);
-      if(!offset || !m_size)
-        dealloc_stride_back();
-    } while(m_size>size_);
-    if(!size_)
-      m_offset=0;
-  }
-  else
-  {
-    // add elements to the end of the deque until the size matches
-    while(m_size<size_)
-    {
-      usize_t offset=(m_offset+m_size)&deque_traits<T>::smask;
-      usize_t num_vals=min(deque_traits<T>::ssize-offset, size_-m_size);
-      if(!offset)
-        alloc_stride_back();
-      default_construct(m_strides.back()+offset, num_vals);
-      m_size+=num_vals;
-    }
-  }
+  clear();
+  if(size_>cap)
+    reserve(size_, 0);
+  copy_construct(items(), v_, size_);
+  m_size=size_;
+}
+//----
 
-  // setup first & last pointers
-  if(m_size)
+template<typename T, usize_t cap>
+void small_array<T, cap>::resize(usize_t size_)
+{
+  // resize the array to given size
+  if(size_>m_size)
   {
-    m_first=m_strides.front()+m_offset;
-    m_last=m_strides.back()+((m_size-1)&deque_traits<T>::smask);
-    m_stride_last=m_strides.back()+deque_traits<T>::smask;
+    PFC_MEM_TRACK_STACK();
+    if(m_capacity<size_)
+      reserve(size_, 0);
+    default_construct(items()+m_size, size_-m_size);
   }
   else
-    m_first=m_last=m_stride_last=0;
+    reverse_destruct(items()+size_, m_size-size_);
+  m_size=size_;
 }
 //----
 
-template<typename T>
-void deque<T>::resize(usize_t size_, const T &v_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::resize(usize_t size_, const T &v_)
 {
-  PFC_MEM_TRACK_STACK();
-  if(size_<m_size)
+  // resize the array to given size
+  if(size_>m_size)
   {
-    // release elements from the end of the deque until the size matches
-    do
-    {
-      usize_t num_vals=min(((m_offset+m_size-1)&deque_traits<T>::smask)+1, m_size-size_);
-      m_size-=num_vals;
-      usize_t offset=(m_offset+m_size)&deque_traits<T>::smask;
-      reverse_destruct(m_strides.back()+offset, num_vals);
-      if(!offset || !m_size)
-        dealloc_stride_back();
-    } while(m_size>size_);
-    if(!size_)
-      m_offset=0;
+    PFC_MEM_TRACK_STACK();
+    if(m_capacity<size_)
+      reserve(size_, 0);
+    copy_construct(items()+m_size, v_, size_-m_size);
   }
   else
+    reverse_destruct(items()+size_, m_size-size_);
+  m_size=size_;
+}
+//----
+
+template<typename T, usize_t cap>
+void small_array<T, cap>::resize_to_zero()
+{
+  reverse_destruct(items(), m_size);
+  m_size=0;
+}
+//----
+
+template<typename T, usize_t cap>
+void small_array<T, cap>::reserve(usize_t capacity_)
+{
+  if(m_capacity<capacity_)
   {
-    // add elements to the end of the deque until the size matches
-    while(m_size<size_)
-    {
-      usize_t offset=(m_offset+m_size)&deque_traits<T>::smask;
-      usize_t num_vals=min(deque_traits<T>::ssize-offset, size_-m_size);
-      if(!offset)
-        alloc_stride_back();
-      copy_construct(m_strides.back()+offset, v_, num_vals);
-      m_size+=num_vals;
-    }
+    PFC_MEM_TRACK_STACK();
+    reserve(capacity_, 0);
   }
+}
+//----
 
-  // setup first & last pointers
-  if(m_size)
+template<typename T, usize_t cap>
+void small_array<T, cap>::trim(usize_t permitted_slack_)
+{
+  // trim heap capacity (moves items back to the local storage if they fit)
+  if(m_capacity>cap && m_size+permitted_slack_<m_capacity)
   {
-    m_first=m_strides.front()+m_offset;
-    m_last=m_strides.back()+((m_size-1)&deque_traits<T>::smask);
-    m_stride_last=m_strides.back()+deque_traits<T>::smask;
+    small_array a(*this);
+    swap(a);
   }
-  else
-    m_first=m_last=m_stride_last=0;
 }
 //----
 
-template<typename T>
-void deque<T>::swap(deque &dq_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::swap(small_array &a_)
 {
-  // swap content of deques
-  pfc::swap(m_allocator, dq_.m_allocator);
-  pfc::swap(m_size, dq_.m_size);
-  pfc::swap(m_offset, dq_.m_offset);
-  pfc::swap(m_first, dq_.m_first);
-  pfc::swap(m_last, dq_.m_last);
-  pfc::swap(m_stride_last, dq_.m_stride_last);
-  m_strides.swap(dq_.m_strides);
+  // swap heap pointers or move the items through a temporal array if either array is local
+  if(m_capacity>cap && a_.m_capacity>cap)
+  {
+    pfc::swap(m_size, a_.m_size);
+    pfc::swap(m_capacity, a_.m_capacity);
+    pfc::swap(m_data, a_.m_data);
+    return;
+  }
+  small_array a;
+  a.take(*this);
+  take(a_);
+  a_.take(a);
 }
 //----------------------------------------------------------------------------
 
-template<typename T>
-memory_allocator_base &deque<T>::allocator() const
+template<typename T, usize_t cap>
+usize_t small_array<T, cap>::size() const
 {
-  return *m_allocator;
+  return m_size;
 }
 //----
 
-template<typename T>
-usize_t deque<T>::size() const
+template<typename T, usize_t cap>
+usize_t small_array<T, cap>::capacity() const
 {
-  return m_size;
+  return m_capacity;
 }
 //----
 
-template<typename T>
-const T &deque<T>::operator[](usize_t idx_) const
+template<typename T, usize_t cap>
+bool small_array<T, cap>::is_local() const
 {
-  // return nth element in the deque
-  PFC_ASSERT_PEDANTIC_MSG(idx_<m_size, ("Trying to access element at index %u of deque<%s> (size=%u)\r\n", idx_, typeid(T).name(), m_size));
-  idx_+=m_offset;
-  return m_strides[idx_>>deque_traits<T>::sshift][idx_&deque_traits<T>::smask];
+  return m_capacity==cap;
 }
 //----
 
-template<typename T>
-T &deque<T>::operator[](usize_t idx_)
+template<typename T, usize_t cap>
+const T &small_array<T, cap>::operator[](usize_t idx_) const
 {
-  // return nth element in the deque
-  PFC_ASSERT_PEDANTIC_MSG(idx_<m_size, ("Trying to access element at index %u of deque<%s> (size=%u)\r\n", idx_, typeid(T).name(), m_size));
-  idx_+=m_offset;
-  return m_strides[idx_>>deque_traits<T>::sshift][idx_&deque_traits<T>::smask];
+  PFC_ASSERT_PEDANTIC_MSG(idx_<m_size, ("Trying to access element at index %u of small_array<%s> (size=%u)\r\n", idx_, typeid(T).name(), m_size));
+  return items()[idx_];
 }
 //----
 
-template<typename T>
-const T &deque<T>::front() const
+template<typename T, usize_t cap>
+T &small_array<T, cap>::operator[](usize_t idx_)
+{
+  PFC_ASSERT_PEDANTIC_MSG(idx_<m_size, ("Trying to access element at index %u of small_array<%s> (size=%u)\r\n", idx_, typeid(T).name(), m_size));
+  return items()[idx_];
+}
+//----
+
+template<typename T, usize_t cap>
+const T &small_array<T, cap>::front() const
 {
-  // return the first element in the deque
   PFC_ASSERT_PEDANTIC(m_size);
-  return *m_first;
+  return *items();
 }
 //----
 
-template<typename T>
-T &deque<T>::front()
+template<typename T, usize_t cap>
+T &small_array<T, cap>::front()
 {
-  // return the first element in the deque
   PFC_ASSERT_PEDANTIC(m_size);
-  return *m_first;
+  return *items();
 }
 //----
 
-template<typename T>
-const T &deque<T>::back() const
+template<typename T, usize_t cap>
+const T &small_array<T, cap>::back() const
 {
-  // return the last element in the deque
   PFC_ASSERT_PEDANTIC(m_size);
-  return *m_last;
+  return items()[m_size-1];
 }
 //----
 
-template<typename T>
-T &deque<T>::back()
+template<typename T, usize_t cap>
+T &small_array<T, cap>::back()
 {
-  // return the last element in the deque
   PFC_ASSERT_PEDANTIC(m_size);
-  return *m_last;
+  return items()[m_size-1];
 }
 //----
 
-template<typename T>
-typename deque<T>::const_iterator deque<T>::begin() const
+template<typename T, usize_t cap>
+const T *small_array<T, cap>::data() const
 {
-  return const_iterator(*this, 0);
+  return items();
 }
 //----
 
-template<typename T>
-typename deque<T>::iterator deque<T>::begin()
+template<typename T, usize_t cap>
+T *small_array<T, cap>::data()
 {
-  return iterator(*this, 0);
+  return items();
 }
 //----
 
-template<typename T>
-typename deque<T>::const_reverse_iterator deque<T>::rbegin() const
+template<typename T, usize_t cap>
+typename small_array<T, cap>::const_iterator small_array<T, cap>::begin() const
 {
-  return const_reverse_iterator(*this, m_size-1);
+  return items();
 }
 //----
 
-template<typename T>
-typename deque<T>::reverse_iterator deque<T>::rbegin()
+template<typename T, usize_t cap>
+typename small_array<T, cap>::iterator small_array<T, cap>::begin()
 {
-  return reverse_iterator(*this, m_size-1);
+  return items();
 }
 //----
 
-template<typename T>
-typename deque<T>::const_iterator deque<T>::last() const
+template<typename T, usize_t cap>
+typename small_array<T, cap>::const_reverse_iterator small_array<T, cap>::rbegin() const
 {
-  return const_iterator(*this, m_size?m_size-1:0);
+  return items()+m_size-1;
 }
 //----
 
-template<typename T>
-typename deque<T>::iterator deque<T>::last()
+template<typename T, usize_t cap>
+typename small_array<T, cap>::reverse_iterator small_array<T, cap>::rbegin()
 {
-  return iterator(*this, m_size?m_size-1:0);
+  return items()+m_size-1;
 }
 //----
 
-template<typename T>
-typename deque<T>::const_reverse_iterator deque<T>::rlast() const
+template<typename T, usize_t cap>
+typename small_array<T, cap>::const_iterator small_array<T, cap>::last() const
 {
-  return const_reverse_iterator(*this, 0);
+  return items()+m_size-1;
 }
 //----
 
-template<typename T>
-typename deque<T>::reverse_iterator deque<T>::rlast()
+template<typename T, usize_t cap>
+typename small_array<T, cap>::iterator small_array<T, cap>::last()
 {
-  return reverse_iterator(*this, 0);
+  return items()+m_size-1;
 }
 //----
 
-template<typename T>
-typename deque<T>::const_iterator deque<T>::end() const
+template<typename T, usize_t cap>
+typename small_array<T, cap>::const_reverse_iterator small_array<T, cap>::rlast() const
 {
-  return const_iterator(*this, m_size);
+  return items();
 }
 //----
 
-template<typename T>
-typename deque<T>::iterator deque<T>::end()
+template<typename T, usize_t cap>
+typename small_array<T, cap>::reverse_iterator small_array<T, cap>::rlast()
 {
-  return iterator(*this, m_size);
+  return items();
 }
 //----
 
-template<typename T>
-typename deque<T>::const_reverse_iterator deque<T>::rend() const
+template<typename T, usize_t cap>
+typename small_array<T, cap>::const_iterator small_array<T, cap>::end() const
 {
-  return const_reverse_iterator(*this, usize_t(-1));
+  return items()+m_size;
 }
 //----
 
-template<typename T>
-typename deque<T>::reverse_iterator deque<T>::rend()
+template<typename T, usize_t cap>
+typename small_array<T, cap>::iterator small_array<T, cap>::end()
 {
-  return reverse_iterator(*this, usize_t(-1));
+  return items()+m_size;
 }
 //----
 
-template<typename T>
-void deque<T>::get(usize_t start_idx_, T *p_, usize_t num_items_) const
+template<typename T, usize_t cap>
+typename small_array<T, cap>::const_reverse_iterator small_array<T, cap>::rend() const
+{
+  return items()-1;
+}
+//----
+
+template<typename T, usize_t cap>
+typename small_array<T, cap>::reverse_iterator small_array<T, cap>::rend()
+{
+  return items()-1;
+}
+//----
+
+template<typename T, usize_t cap>
+void small_array<T, cap>::get(usize_t start_idx_, T *p_, usize_t num_items_) const
 {
   // get items to the given array from the container
   PFC_ASSERT_MSG(start_idx_+num_items_<=m_size, ("Reading values past the end of the container\r\n"));
   destruct(p_, num_items_);
-  start_idx_+=m_offset;
-  while(num_items_)
-  {
-    // copy items in the stride to the given array
-    usize_t num_stride_items=min(num_items_, deque_traits<T>::ssize-(start_idx_&deque_traits<T>::smask));
-    copy_construct(p_, m_strides[start_idx_>>deque_traits<T>::sshift]+(start_idx_&deque_traits<T>::smask), num_stride_items);
-    start_idx_+=num_stride_items;
-    p_+=num_stride_items;
-    num_items_-=num_stride_items;
-  }
+  copy_construct(p_, items()+start_idx_, num_items_);
 }
 //----
 
-template<typename T>
-void deque<T>::set(usize_t start_idx_, const T *p_, usize_t num_items_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::set(usize_t start_idx_, const T *p_, usize_t num_items_)
 {
   // set items from the given array to the container
   PFC_ASSERT_MSG(start_idx_+num_items_<=m_size, ("Writing values past the end of the container\r\n"));
-  start_idx_+=m_offset;
-  while(num_items_)
-  {
-    // copy items to the stride from the given array
-    usize_t num_stride_items=min(num_items_, deque_traits<T>::ssize-(start_idx_&deque_traits<T>::smask));
-    T *data=m_strides[start_idx_>>deque_traits<T>::sshift]+(start_idx_&deque_traits<T>::smask);
-    destruct(data, num_stride_items);
-    copy_construct(data, p_, num_stride_items);
-    start_idx_+=num_stride_items;
-    p_+=num_stride_items;
-    num_items_-=num_stride_items;
-  }
+  T *data=items();
+  destruct(data+start_idx_, num_items_);
+  copy_construct(data+start_idx_, p_, num_items_);
 }
 //----
 
-template<typename T>
-void deque<T>::set(usize_t start_idx_, const T &v_, usize_t num_items_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::set(usize_t start_idx_, const T &v_, usize_t num_items_)
 {
-  // set array of given item to the container
+  // set items from the given array to the container
   PFC_ASSERT_MSG(start_idx_+num_items_<=m_size, ("Writing values past the end of the container\r\n"));
-  start_idx_+=m_offset;
-  while(num_items_)
-  {
-    // copy items to the stride from the given array
-    usize_t num_stride_items=min(num_items_, deque_traits<T>::ssize-(start_idx_&deque_traits<T>::smask));
-    T *data=m_strides[start_idx_>>deque_traits<T>::sshift]+(start_idx_&deque_traits<T>::smask);
-    destruct(data, num_stride_items);
-    copy_construct(data, v_, num_stride_items);
-    start_idx_+=num_stride_items;
-    num_items_-=num_stride_items;
-  }
+  T *data=items();
+  destruct(data+start_idx_, num_items_);
+  copy_construct(data+start_idx_, v_, num_items_);
 }
 //----
 
-template<typename T>
-void deque<T>::push_front(const T &v_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::push_front(const T &v_)
 {
-  // push new element to the beginning of the deque
-  PFC_MEM_TRACK_STACK();
-  if(!m_offset)
-    alloc_stride_front();
-  --m_offset;
-  PFC_PNEW(--m_first)T(v_);  // todo: handle exceptions
+  // push the value to the beginning of the array
+  if(m_size==m_capacity)
+  {
+    PFC_MEM_TRACK_STACK();
+    reserve(m_capacity*2, 1);
+  }
+  else
+    move_construct(items()+1, items(), m_size);
+  PFC_PNEW(items())T(v_);
   ++m_size;
 }
 //----
 
-template<typename T>
-T &deque<T>::push_front()
+template<typename T, usize_t cap>
+T &small_array<T, cap>::push_front()
 {
-  // push default value to the beginning of the deque
-  PFC_MEM_TRACK_STACK();
-  if(!m_offset)
-    alloc_stride_front();
-  --m_offset;
-  PFC_PNEW(--m_first)T;  // todo: handle exceptions
+  // push default to the beginning of the array
+  if(m_size==m_capacity)
+  {
+    PFC_MEM_TRACK_STACK();
+    reserve(m_capacity*2, 1);
+  }
+  else
+    move_construct(items()+1, items(), m_size);
+  T *data=items();
+  PFC_PNEW(data)T;
   ++m_size;
-  return *m_first;
+  return *data;
 }
 //----
 
-template<typename T>
-void deque<T>::push_back(const T &v_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::push_back(const T &v_)
 {
-  // push new element to the end of the deque
-  PFC_MEM_TRACK_STACK();
-  if(m_last==m_stride_last)
-    alloc_stride_back();
-  PFC_PNEW(++m_last)T(v_);  // todo: handle exceptions
+  // push the value to the end of the array
+  if(m_size==m_capacity)
+  {
+    PFC_MEM_TRACK_STACK();
+    reserve(m_capacity*2, 0);
+  }
+  PFC_PNEW(items()+m_size)T(v_);
   ++m_size;
 }
 //----
 
-template<typename T>
-T &deque<T>::push_back()
+template<typename T, usize_t cap>
+T &small_array<T, cap>::push_back()
 {
-  // push default value to the end of the deque
-  PFC_MEM_TRACK_STACK();
-  if(m_last==m_stride_last)
-    alloc_stride_back();
-  PFC_PNEW(++m_last)T;  // todo: handle exceptions
+  // push default value to the end of the array
+  if(m_size==m_capacity)
+  {
+    PFC_MEM_TRACK_STACK();
+    reserve(m_capacity*2, 0);
+  }
+  T *v=items()+m_size;
+  PFC_PNEW(v)T;
   ++m_size;
-  return *m_last;
+  return *v;
 }
 //----
 
-template<typename T>
-void deque<T>::insert_front(usize_t num_items_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::insert_front(usize_t num_items_)
 {
-  // insert given number of default constructed items to the front of the deque
-  PFC_MEM_TRACK_STACK();
-  m_size+=num_items_;
-  while(num_items_)
+  // insert items to the beginning of the array
+  usize_t new_size=m_size+num_items_;
+  if(m_capacity<new_size)
   {
-    if(!m_offset)
-      alloc_stride_front();
-    usize_t ni=min(m_offset, num_items_);
-    num_items_-=ni;
-    m_first-=ni;
-    m_offset-=ni;
-    reverse_default_construct(m_first, ni);
+    PFC_MEM_TRACK_STACK();
+    reserve(max(new_size, m_capacity*2), num_items_);
   }
+  else
+    move_construct(items()+num_items_, items(), m_size);
+  default_construct(items(), num_items_);
+  m_size=new_size;
 }
 //----
 
-template<typename T>
-void deque<T>::insert_front(usize_t num_items_, const T &v_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::insert_front(usize_t num_items_, const T &v_)
 {
-  // insert given number of given items to the front of the deque
-  PFC_MEM_TRACK_STACK();
-  m_size+=num_items_;
-  while(num_items_)
+  // insert items to the beginning of the array
+  usize_t new_size=m_size+num_items_;
+  if(m_capacity<new_size)
   {
-    if(!m_offset)
-      alloc_stride_front();
-    usize_t ni=min(m_offset, num_items_);
-    num_items_-=ni;
-    m_first-=ni;
-    m_offset-=ni;
-    reverse_copy_construct(m_first, v_, ni);
+    PFC_MEM_TRACK_STACK();
+    reserve(max(new_size, m_capacity*2), num_items_);
   }
+  else
+    move_construct(items()+num_items_, items(), m_size);
+  copy_construct(items(), v_, num_items_);
+  m_size=new_size;
 }
 //----
 
-template<typename T>
-void deque<T>::insert_front(usize_t num_items_, const T *v_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::insert_front(usize_t num_items_, const T *v_)
 {
-  // insert given number of given items to the front of the deque
-  PFC_MEM_TRACK_STACK();
-  m_size+=num_items_;
-  while(num_items_)
+  // insert items to the beginning of the array
+  usize_t new_size=m_size+num_items_;
+  if(m_capacity<new_size)
   {
-    if(!m_offset)
-      alloc_stride_front();
-    usize_t ni=min(m_offset, num_items_);
-    num_items_-=ni;
-    m_first-=ni;
-    m_offset-=ni;
-    reverse_copy_construct(m_first, v_, ni);
-    v_+=ni;
+    PFC_MEM_TRACK_STACK();
+    reserve(max(new_size, m_capacity*2), num_items_);
   }
+  else
+    move_construct(items()+num_items_, items(), m_size);
+  copy_construct(items(), v_, num_items_);
+  m_size=new_size;
 }
 //----
 
-template<typename T>
-void deque<T>::insert_back(usize_t num_items_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::insert_back(usize_t num_items_)
 {
-  PFC_MEM_TRACK_STACK();
-  resize(m_size+num_items_);
+  // insert items to the end of the array
+  usize_t new_size=m_size+num_items_;
+  if(m_capacity<new_size)
+  {
+    PFC_MEM_TRACK_STACK();
+    reserve(max(new_size, m_capacity*2), 0);
+  }
+  default_construct(items()+m_size, num_items_);
+  m_size=new_size;
 }
 //----
 
-template<typename T>
-void deque<T>::insert_back(usize_t num_items_, const T &v_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::insert_back(usize_t num_items_, const T &v_)
 {
-  PFC_MEM_TRACK_STACK();
-  resize(m_size+num_items_, v_);
+  // insert items to the end of the array
+  usize_t new_size=m_size+num_items_;
+  if(m_capacity<new_size)
+  {
+    PFC_MEM_TRACK_STACK();
+    reserve(max(new_size, m_capacity*2), 0);
+  }
+  copy_construct(items()+m_size, v_, num_items_);
+  m_size=new_size;
 }
 //----
 
-template<typename T>
-void deque<T>::insert_back(usize_t num_items_, const T *v_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::insert_back(usize_t num_items_, const T *v_)
 {
-  // insert array of values to the deque
-  PFC_MEM_TRACK_STACK();
-  for(usize_t i=0; i<num_items_; ++i)
+  // insert items to the end of the array
+  usize_t new_size=m_size+num_items_;
+  if(m_capacity<new_size)
   {
-    if(m_last==m_stride_last)
-      alloc_stride_back();
-    PFC_PNEW(++m_last)T(*v_++);  // todo: handle exceptions
+    PFC_MEM_TRACK_STACK();
+    reserve(max(new_size, m_capacity*2), 0);
   }
-  m_size+=num_items_;
+  copy_construct(items()+m_size, v_, num_items_);
+  m_size=new_size;
 }
 //----
 
-template<typename T>
-void deque<T>::pop_front()
+template<typename T, usize_t cap>
+void small_array<T, cap>::pop_front()
 {
-  // remove the first element from the beginning of the deque
+  // remove the first element from the beginning of the array
   PFC_ASSERT_PEDANTIC(m_size);
-  --m_size;
-  m_first++->~T();
-  if(!((++m_offset)&deque_traits<T>::smask))
-    dealloc_stride_front();
+  T *data=items();
+  data[0].~T();
+  move_construct(data, data+1, --m_size);
 }
 //----
 
-template<typename T>
-void deque<T>::pop_back()
+template<typename T, usize_t cap>
+void small_array<T, cap>::pop_back()
 {
-  // remove the last element from the end of the deque
+  // remove the last element from the end of the array
   PFC_ASSERT_PEDANTIC(m_size);
   --m_size;
-  m_last--->~T();
-  if(m_last==m_stride_last-deque_traits<T>::ssize)
-    dealloc_stride_back();
+  items()[m_size].~T();
 }
 //----
 
-template<typename T>
-void deque<T>::remove_front(usize_t num_items_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::remove_front(usize_t num_items_)
 {
-  // remove given number of items from the beginning of the deque
+  // remove given number of items from the beginning of the array
   PFC_ASSERT_PEDANTIC(m_size>=num_items_);
+  T *data=items();
   m_size-=num_items_;
-  while(num_items_)
-  {
-    usize_t ni=min(num_items_, deque_traits<T>::ssize-m_offset);
-    num_items_-=ni;
-    destruct(m_first, ni);
-    m_first+=ni;
-    m_offset+=ni;
-    if(!(m_offset&deque_traits<T>::smask))
-      dealloc_stride_front();
-  }
+  destruct(data, num_items_);
+  move_construct(data, data+num_items_, m_size);
 }
 //----
 
-template<typename T>
-void deque<T>::remove_back(usize_t num_items_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::remove_back(usize_t num_items_)
 {
-  // remove given number of items from the end of the deque
+  // remove given number of items from the end of the array
   PFC_ASSERT_PEDANTIC(m_size>=num_items_);
+  reverse_destruct(items()+m_size-num_items_, num_items_);
   m_size-=num_items_;
-  while(num_items_)
-  {
-    usize_t ni=min(num_items_, usize_t(m_last-(m_stride_last-deque_traits<T>::ssize)));
-    num_items_-=ni;
-    m_last-=ni,
-    reverse_destruct(m_last+1, ni);
-    if(m_last==m_stride_last-deque_traits<T>::ssize)
-      dealloc_stride_back();
-  }
 }
-//----------------------------------------------------------------------------
+//----
 
-template<typename T>
-void deque<T>::cctor(const deque &dq_)
+template<typename T, usize_t cap>
+void small_array<T, cap>::remove(T &v_)
 {
-  // copy-construct the deque
-  m_size=0;
-  m_offset=dq_.m_offset;
-  m_strides.resize(dq_.m_strides.size());
-  usize_t idx=0, offset=m_offset;
-  PFC_EDTOR(*this, &deque<T>::clear);
-  while(m_size<dq_.m_size)
-  {
-    eh_data<T> p(*m_allocator, deque_traits<T>::ssize, deque_traits<T>::block_alloc_align);
-    m_strides[idx]=p.data;
-    usize_t num_vals=min(deque_traits<T>::ssize-offset, dq_.m_size-m_size);
-    copy_construct(m_strides[idx]+offset, dq_.m_strides[idx]+offset, num_vals);
-    p.reset();
-    offset=0;
-    ++idx;
-    m_size+=num_vals;
-  }
-  PFC_EDTOR_RESET();
-
-  // setup first & last pointers
-  if(m_size)
-  {
-    m_first=m_strides.front()+m_offset;
-    m_last=m_strides.back()+((m_size-1)&deque_traits<T>::smask);
-    m_stride_last=m_strides.back()+deque_traits<T>::smask;
-  }
-  else
-    m_first=m_last=m_stride_last=0;
+  // remove the item from the array
+  T *data=items();
+  usize_t idx=usize_t(&v_-data);
+  PFC_ASSERT_PEDANTIC_MSG(idx<m_size, ("The removed item doesn't belong to the array.\r\n"));
+  v_.~T();
+  move_construct(data+idx, data+idx+1, --m_size-idx);
 }
 //----
 
-template<typename T>
-void deque<T>::alloc_stride_front()
+template<typename T, usize_t cap>
+void small_array<T, cap>::remove_unordered(T &v_)
 {
-  // allocate new first stride
-  eh_data<T> p(*m_allocator, deque_traits<T>::ssize, deque_traits<T>::block_alloc_align);
-  m_strides.push_back(0);
-  mem_move(m_strides.data()+1, m_strides.data(), sizeof(T*)*(m_strides.size()-1));
-  m_strides.front()=p.data;
-  m_first=p.data+deque_traits<T>::ssize;
-  if(!m_size)
-    m_last=m_stride_last=m_first-1;
-  m_offset=deque_traits<T>::ssize;
-  p.reset();
+  // destruct item at the index and move the last item to its place
+  T *data=items();
+  usize_t idx=usize_t(&v_-data);
+  PFC_ASSERT_PEDANTIC_MSG(idx<m_size, ("The removed item doesn't belong to the array.\r\n"));
+  v_.~T();
+  if(--m_size!=idx)
+  {
+    PFC_PNEW(&v_)T(data[m_size]);
+    data[m_size].~T();
+  }
 }
 //----
 
-template<typename T>
-void deque<T>::alloc_stride_back()
+template<typename T, usize_t cap>
+void small_array<T, cap>::remove_at(usize_t idx_)
 {
-  // allocate new last stride
-  eh_data<T> p(*m_allocator, deque_traits<T>::ssize, deque_traits<T>::block_alloc_align);
-  m_strides.push_back(p.data);
-  m_last=p.data-1;
-  m_stride_last=p.data+deque_traits<T>::smask;
-  if(!m_size)
-    m_first=p.data;
-  p.reset();
+  // remove item at given index
+  PFC_ASSERT_PEDANTIC(idx_<m_size);
+  T *data=items();
+  data[idx_].~T();
+  move_construct(data+idx_, data+idx_+1, m_size-idx_-1);
+  --m_size;
 }
 //----
 
-template<typename T>
-void deque<T>::dealloc_stride_front()
+template<typename T, usize_t cap>
+void small_array<T, cap>::remove_at(usize_t idx_, usize_t num_items_)
 {
-  // deallocate first stride
-  m_allocator->free(m_strides.front());
-  mem_move(m_strides.data(), m_strides.data()+1, sizeof(T*)*(m_strides.size()-1));
-  m_strides.pop_back();
-  m_offset=0;
-  if(!m_size)
-    m_first=m_last=m_stride_last=0;
-  else
-    m_first=m_strides.front();
+  // remove given number of items starting at given index
+  PFC_ASSERT_PEDANTIC(idx_+num_items_<=m_size);
+  T *data=items();
+  destruct(data+idx_, num_items_);
+  move_construct(data+idx_, data+idx_+num_items_, m_size-idx_-num_items_);
+  m_size-=num_items_;
 }
 //----
 
-template<typename T>
-void deque<T>::dealloc_stride_back()
+template<typename T, usize_t cap>
+void small_array<T, cap>::remove_at_unordered(usize_t idx_)
 {
-  // deallocate last stride
-  m_allocator->free(m_strides.back());
-  m_strides.pop_back();
-  if(!m_size)
-    m_first=m_last=m_stride_last=0;
-  else
-    m_last=m_stride_last=m_strides.back()+deque_traits<T>::smask;
+  // destruct item at the index and move the last item to its place
+  PFC_ASSERT_PEDANTIC(idx_<m_size);
+  T *data=items();
+  data[idx_].~T();
+  if(--m_size!=idx_)
+  {
+    PFC_PNEW(data+idx_)T(data[m_size]);
+    data[m_size].~T();
+  }
 }
 //----------------------------------------------------------------------------
 
-
-//============================================================================
-// deque::const_iterator_impl
-//============================================================================
-template<typename T>
-template<bool is_forward>
-deque<T>::const_iterator_impl<is_forward>::const_iterator_impl()
-  :m_deque(0)
-  ,m_index(0)
+template<typename T, usize_t cap>
+T *small_array<T, cap>::items() const
 {
+  return m_capacity>cap?m_data:(T*)m_local;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-deque<T>::const_iterator_impl<is_forward>::const_iterator_impl(const iterator_impl<is_forward> &it_)
-  :m_deque(it_.m_deque)
-  ,m_index(it_.m_index)
-{
+template<typename T, usize_t cap>
+void small_array<T, cap>::reserve(usize_t capacity_, usize_t offset_)
+{
+  // move content of the array to new heap memory location
+  PFC_ASSERT(capacity_>cap);
+  eh_data<T> p(default_memory_allocator::inst(), capacity_, meta_alignof<T>::res);
+  T *data=items();
+  move_construct(p.data+offset_, data, m_size);
+  if(m_capacity>cap)
+    default_memory_allocator::inst().free(data);
+  m_data=p.data;
+  m_capacity=capacity_;
+  p.reset();
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-void deque<T>::const_iterator_impl<is_forward>::reset()
+template<typename T, usize_t cap>
+void small_array<T, cap>::take(small_array &a_)
 {
-  m_deque=0;
-  m_index=0;
+  // move content of the given array to this (empty and local) array
+  PFC_ASSERT(!m_size && m_capacity==cap);
+  if(a_.m_capacity>cap)
+  {
+    m_data=a_.m_data;
+    m_capacity=a_.m_capacity;
+  }
+  else
+    move_construct((T*)m_local, (T*)a_.m_local, a_.m_size);
+  m_size=a_.m_size;
+  a_.m_size=0;
+  a_.m_capacity=cap;
 }
 //----------------------------------------------------------------------------
 
-template<typename T>
-template<bool is_forward>
-bool deque<T>::const_iterator_impl<is_forward>::operator==(const const_iterator_impl &it_) const
-{
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return m_index==it_.m_index;
-}
-//----
 
-template<typename T>
-template<bool is_forward>
-bool deque<T>::const_iterator_impl<is_forward>::operator==(const iterator_impl<is_forward> &it_) const
+//============================================================================
+// deque
+//============================================================================
+PFC_INTROSPEC_INL_TDEF1(typename T, deque<T>)
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return m_index==it_.m_index;
-}
-//----
-
-template<typename T>
-template<bool is_forward>
-bool deque<T>::const_iterator_impl<is_forward>::operator!=(const const_iterator_impl &it_) const
-{
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return m_index!=it_.m_index;
-}
-//----
+  PFC_CUSTOM_STREAMING(0);
+  switch(unsigned(PE::pe_type))
+  {
+    case penum_input:
+    {
+      // read data
+      PFC_MEM_TRACK_STACK();
+      clear();
+      uint32_t size;
+      pe_.var(size);
+      resize(size);
+      for(uint32_t i=0; i<size; ++i)
+        pe_.var((*this)[i], i?mvarflag_array_tail:0);
+    } break;
 
-template<typename T>
-template<bool is_forward>
-bool deque<T>::const_iterator_impl<is_forward>::operator!=(const iterator_impl<is_forward> &it_) const
-{
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return m_index!=it_.m_index;
+    case penum_output:
+    case penum_display:
+    {
+      // write/display data
+      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize deque<%s> that contains more than 2^32-1 elements\r\n", typeid(T).name()));
+      uint32_t size=(uint32_t)m_size;
+      pe_.var(size, 0, "size");
+      for(uint32_t i=0; i<size; ++i)
+        pe_.var((*this)[i], mvarflag_mutable|mvarflag_mutable_ptr|(i?mvarflag_array_tail:0));
+    } break;
+  }
 }
-//----
+//----------------------------------------------------------------------------
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator++()
+deque<T>::deque(memory_allocator_base *alloc_)
+  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+  ,m_size(0)
+  ,m_offset(0)
+  ,m_first(0)
+  ,m_last(0)
+  ,m_stride_last(0)
 {
-  m_index+=is_forward?1:usize_t(-1);
-  return *this;
+  PFC_ASSERT_CALL(m_allocator->check_allocator(deque_traits<T>::block_alloc_size, deque_traits<T>::block_alloc_align));
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator--()
+deque<T>::deque(const deque &dq_)
+  :m_allocator(&default_memory_allocator::inst())
 {
-  m_index+=is_forward?usize_t(-1):1;
-  return *this;
+  PFC_MEM_TRACK_STACK();
+  cctor(dq_);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator+=(ssize_t offset_)
+deque<T>::deque(const deque &dq_, memory_allocator_base *alloc_)
+  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
 {
-  m_index+=is_forward?offset_:-offset_;
-  return *this;
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(deque_traits<T>::block_alloc_size, deque_traits<T>::block_alloc_align));
+  cctor(dq_);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator+=(const const_iterator_impl &it_)
+deque<T>::deque(usize_t size_, memory_allocator_base *alloc_)
+  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  m_index+=is_forward?it_.m_index:m_deque->m_size-1-it_.m_index;
-  return *this;
-}
-//----
+  // default construct the deque
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(deque_traits<T>::block_alloc_size, deque_traits<T>::block_alloc_align));
+  m_size=0;
+  m_offset=0;
+  m_strides.resize((size_+deque_traits<T>::smask)>>deque_traits<T>::sshift);
+  PFC_EDTOR(*this, &deque<T>::clear);
+  usize_t idx=0;
+  while(m_size<size_)
+  {
+    // construct a stride
+    eh_data<T> p(*m_allocator, deque_traits<T>::ssize, deque_traits<T>::block_alloc_align);
+    m_strides[idx++]=p.data;
+    usize_t num_vals=min<usize_t>(size_-m_size, deque_traits<T>::ssize);
+    default_construct(p.data, num_vals);
+    p.reset();
+    m_size+=num_vals;
+  }
+  PFC_EDTOR_RESET();
 
-template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator+=(const iterator_impl<is_forward> &it_)
-{
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  m_index+=is_forward?it_.m_index:m_deque->m_size-1-it_.m_index;
-  return *this;
+  // setup first & last pointers
+  if(m_size)
+  {
+    m_first=m_strides.front()+m_offset;
+    m_last=m_strides.back()+((m_size-1)&deque_traits<T>::smask);
+    m_stride_last=m_strides.back()+deque_traits<T>::smask;
+  }
+  else
+    m_first=m_last=m_stride_last=0;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator-=(ssize_t offset_)
+deque<T>::deque(usize_t size_, const T &v_, memory_allocator_base *alloc_)
+  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
 {
-  m_index+=is_forward?-offset_:offset_;
-  return *this;
-}
-//----
+  // copy-construct the deque from the value
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(deque_traits<T>::block_alloc_size, deque_traits<T>::block_alloc_align));
+  m_size=0;
+  m_offset=0;
+  m_strides.resize((size_+deque_traits<T>::smask)>>deque_traits<T>::sshift);
+  PFC_EDTOR(*this, &deque<T>::clear);
+  usize_t idx=0;
+  while(m_size<size_)
+  {
+    // construct a stride
+    eh_data<T> p(*m_allocator, deque_traits<T>::ssize, deque_traits<T>::block_alloc_align);
+    m_strides[idx++]=p.data;
+    usize_t num_vals=min<usize_t>(size_-m_size, deque_traits<T>::ssize);
+    copy_construct(p.data, v_, num_vals);
+    p.reset();
+    m_size+=num_vals;
+  }
+  PFC_EDTOR_RESET();
 
-template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator-=(const const_iterator_impl &it_)
-{
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  m_index+=is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1;
-  return *this;
+  // setup first & last pointers
+  if(m_size)
+  {
+    m_first=m_strides.front()+m_offset;
+    m_last=m_strides.back()+((m_size-1)&deque_traits<T>::smask);
+    m_stride_last=m_strides.back()+deque_traits<T>::smask;
+  }
+  else
+    m_first=m_last=m_stride_last=0;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator-=(const iterator_impl<is_forward> &it_)
+deque<T>::~deque()
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  m_index+=is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1;
-  return *this;
+  clear();
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator+(ssize_t offset_) const
+void deque<T>::operator=(const deque &dq_)
 {
-  return const_iterator_impl(*m_deque, m_index+(is_forward?offset_:-offset_));
+  deque<T> dq(dq_);
+  swap(dq);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator+(const const_iterator_impl &it_) const
+void deque<T>::set_allocator(memory_allocator_base *alloc_)
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return const_iterator_impl(*m_deque, m_index+(is_forward?it_.m_index:m_deque->m_size-1-it_.m_index));
+  PFC_ASSERT_MSG(!m_size, ("Unable to change the allocator of a non-empty deque\r\n"));
+  m_allocator=alloc_?alloc_:&default_memory_allocator::inst();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(deque_traits<T>::block_alloc_size, deque_traits<T>::block_alloc_align));
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator+(const iterator_impl<is_forward> &it_) const
+void deque<T>::clear()
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return const_iterator_impl(*m_deque, m_index+(is_forward?it_.m_index:m_deque->m_size-1-it_.m_index));
+  // clear the deque
+  usize_t idx=0;
+  while(m_size)
+  {
+    usize_t num_vals=min(m_size, deque_traits<T>::ssize-m_offset);
+    destruct(m_strides[idx]+m_offset, num_vals);
+    m_allocator->free(m_strides[idx]);
+    m_size-=num_vals;
+    m_offset=0;
+    ++idx;
+  }
+  m_first=m_last=m_stride_last=0;
+  m_strides.clear();
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator-(ssize_t offset_) const
+void deque<T>::resize(usize_t size_)
 {
-  return const_iterator_impl(*m_deque, m_index+(is_forward?-offset_:offset_));
-}
-//----
+  PFC_MEM_TRACK_STACK();
+  if(size_<m_size)
+  {
+    // release elements from the end of the deque until the size matches
+    do
+    {
+      usize_t num_vals=min(((m_offset+m_size-1)&deque_traits<T>::smask)+1, m_size-size_);
+      m_size-=num_vals;
+      usize_t offset=(m_offset+m_size)&deque_traits<T>::smask;
+      reverse_destruct(m_strides.back()+offset, num_vals);
+      if(!offset || !m_size)
+        dealloc_stride_back();
+    } while(m_size>size_);
+    if(!size_)
+      m_offset=0;
+  }
+  else
+  {
+    // add elements to the end of the deque until the size matches
+    while(m_size<size_)
+    {
+      usize_t offset=(m_offset+m_size)&deque_traits<T>::smask;
+      usize_t num_vals=min(deque_traits<T>::ssize-offset, size_-m_size);
+      if(!offset)
+        alloc_stride_back();
+      default_construct(m_strides.back()+offset, num_vals);
+      m_size+=num_vals;
+    }
+  }
 
-template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator-(const const_iterator_impl &it_) const
-{
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return const_iterator_impl(*m_deque, m_index+(is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1));
+  // setup first & last pointers
+  if(m_size)
+  {
+    m_first=m_strides.front()+m_offset;
+    m_last=m_strides.back()+((m_size-1)&deque_traits<T>::smask);
+    m_stride_last=m_strides.back()+deque_traits<T>::smask;
+  }
+  else
+    m_first=m_last=m_stride_last=0;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator-(const iterator_impl<is_forward> &it_) const
+void deque<T>::resize(usize_t size_, const T &v_)
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return const_iterator_impl(*m_deque, m_index+(is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1));
-}
-//----
-
-template<typename T>
-template<bool is_forward>
-const T &deque<T>::const_iterator_impl<is_forward>::operator[](usize_t index_) const
-{
-  return (*m_deque)[m_index+index_];
+  PFC_MEM_TRACK_STACK();
+  if(size_<m_size)
+  {
+    // release elements from the end of the deque until the size matches
+    do
+    {
+      usize_t num_vals=min(((m_offset+m_size-1)&deque_traits<T>::smask)+1, m_size-size_);
+      m_size-=num_vals;
+      usize_t offset=(m_offset+m_size)&deque_traits<T>::smask;
+      reverse_destruct(m_strides.back()+offset, num_vals);
+      if(!offset || !m_size)
+        dealloc_stride_back();
+    } while(m_size>size_);
+    if(!size_)
+      m_offset=0;
+  }
+  else
+  {
+    // add elements to the end of the deque until the size matches
+    while(m_size<size_)
+    {
+      usize_t offset=(m_offset+m_size)&deque_traits<T>::smask;
+      usize_t num_vals=min(deque_traits<T>::ssize-offset, size_-m_size);
+      if(!offset)
+        alloc_stride_back();
+      copy_construct(m_strides.back()+offset, v_, num_vals);
+      m_size+=num_vals;
+    }
+  }
+
+  // setup first & last pointers
+  if(m_size)
+  {
+    m_first=m_strides.front()+m_offset;
+    m_last=m_strides.back()+((m_size-1)&deque_traits<T>::smask);
+    m_stride_last=m_strides.back()+deque_traits<T>::smask;
+  }
+  else
+    m_first=m_last=m_stride_last=0;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-const T &deque<T>::const_iterator_impl<is_forward>::operator*() const
+void deque<T>::swap(deque &dq_)
 {
-  return (*m_deque)[m_index];
+  // swap content of deques
+  pfc::swap(m_allocator, dq_.m_allocator);
+  pfc::swap(m_size, dq_.m_size);
+  pfc::swap(m_offset, dq_.m_offset);
+  pfc::swap(m_first, dq_.m_first);
+  pfc::swap(m_last, dq_.m_last);
+  pfc::swap(m_stride_last, dq_.m_stride_last);
+  m_strides.swap(dq_.m_strides);
 }
-//----
+//----------------------------------------------------------------------------
 
 template<typename T>
-template<bool is_forward>
-const T *deque<T>::const_iterator_impl<is_forward>::operator->() const
+memory_allocator_base &deque<T>::allocator() const
 {
-  return &(*m_deque)[m_index];
+  return *m_allocator;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-usize_t deque<T>::const_iterator_impl<is_forward>::index() const
+usize_t deque<T>::size() const
 {
-  return m_index;
+  return m_size;
 }
-//----------------------------------------------------------------------------
+//----
 
 template<typename T>
-template<bool is_forward>
-deque<T>::const_iterator_impl<is_forward>::const_iterator_impl(const deque<T> &deque_, usize_t index_)
-  :m_deque(&deque_)
-  ,m_index(index_)
+const T &deque<T>::operator[](usize_t idx_) const
 {
+  // return nth element in the deque
+  PFC_ASSERT_PEDANTIC_MSG(idx_<m_size, ("Trying to access element at index %u of deque<%s> (size=%u)\r\n", idx_, typeid(T).name(), m_size));
+  idx_+=m_offset;
+  return m_strides[idx_>>deque_traits<T>::sshift][idx_&deque_traits<T>::smask];
 }
-//----------------------------------------------------------------------------
-
+//----
 
-//============================================================================
-// deque::iterator_impl
-//============================================================================
 template<typename T>
-template<bool is_forward>
-deque<T>::iterator_impl<is_forward>::iterator_impl()
-  :m_deque(0)
-  ,m_index(0)
+T &deque<T>::operator[](usize_t idx_)
 {
+  // return nth element in the deque
+  PFC_ASSERT_PEDANTIC_MSG(idx_<m_size, ("Trying to access element at index %u of deque<%s> (size=%u)\r\n", idx_, typeid(T).name(), m_size));
+  idx_+=m_offset;
+  return m_strides[idx_>>deque_traits<T>::sshift][idx_&deque_traits<T>::smask];
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-void deque<T>::iterator_impl<is_forward>::reset()
+const T &deque<T>::front() const
 {
-  m_deque=0;
-  m_index=0;
+  // return the first element in the deque
+  PFC_ASSERT_PEDANTIC(m_size);
+  return *m_first;
 }
-//----------------------------------------------------------------------------
+//----
 
 template<typename T>
-template<bool is_forward>
-bool deque<T>::iterator_impl<is_forward>::operator==(const const_iterator_impl<is_forward> &it_) const
+T &deque<T>::front()
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return m_index==it_.m_index;
+  // return the first element in the deque
+  PFC_ASSERT_PEDANTIC(m_size);
+  return *m_first;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-bool deque<T>::iterator_impl<is_forward>::operator==(const iterator_impl &it_) const
+const T &deque<T>::back() const
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return m_index==it_.m_index;
+  // return the last element in the deque
+  PFC_ASSERT_PEDANTIC(m_size);
+  return *m_last;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-bool deque<T>::iterator_impl<is_forward>::operator!=(const const_iterator_impl<is_forward> &it_) const
+T &deque<T>::back()
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return m_index!=it_.m_index;
+  // return the last element in the deque
+  PFC_ASSERT_PEDANTIC(m_size);
+  return *m_last;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-bool deque<T>::iterator_impl<is_forward>::operator!=(const iterator_impl &it_) const
+typename deque<T>::const_iterator deque<T>::begin() const
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return m_index!=it_.m_index;
+  return const_iterator(*this, 0);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator++()
+typename deque<T>::iterator deque<T>::begin()
 {
-  m_index+=is_forward?1:usize_t(-1);
-  return *this;
+  return iterator(*this, 0);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator--()
+typename deque<T>::const_reverse_iterator deque<T>::rbegin() const
 {
-  m_index+=is_forward?usize_t(-1):1;
-  return *this;
+  return const_reverse_iterator(*this, m_size-1);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator+=(ssize_t offset_)
+typename deque<T>::reverse_iterator deque<T>::rbegin()
 {
-  m_index+=is_forward?offset_:-offset_;
-  return *this;
+  return reverse_iterator(*this, m_size-1);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator+=(const const_iterator_impl<is_forward> &it_)
+typename deque<T>::const_iterator deque<T>::last() const
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  m_index+=is_forward?it_.m_index:m_deque->m_size-1-it_.m_index;
-  return *this;
+  return const_iterator(*this, m_size?m_size-1:0);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator+=(const iterator_impl &it_)
+typename deque<T>::iterator deque<T>::last()
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  m_index+=is_forward?it_.m_index:m_deque->m_size-1-it_.m_index;
-  return *this;
+  return iterator(*this, m_size?m_size-1:0);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator-=(ssize_t offset_)
+typename deque<T>::const_reverse_iterator deque<T>::rlast() const
 {
-  m_index-=offset_;
-  return *this;
+  return const_reverse_iterator(*this, 0);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator-=(const const_iterator_impl<is_forward> &it_)
+typename deque<T>::reverse_iterator deque<T>::rlast()
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  m_index+=is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1;
-  return *this;
+  return reverse_iterator(*this, 0);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator-=(const iterator_impl &it_)
+typename deque<T>::const_iterator deque<T>::end() const
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  m_index+=is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1;
-  return *this;
+  return const_iterator(*this, m_size);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator+(ssize_t offset_) const
+typename deque<T>::iterator deque<T>::end()
 {
-  return iterator_impl(*m_deque, m_index+(is_forward?offset_:-offset_));
+  return iterator(*this, m_size);
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator+(const const_iterator_impl<is_forward> &it_) const
+typename deque<T>::const_reverse_iterator deque<T>::rend() const
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return iterator_impl(*m_deque, m_index+(is_forward?it_.m_index:m_deque->m_size-1-it_.m_index));
+  return const_reverse_iterator(*this, usize_t(-1));
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator+(const iterator_impl &it_) const
+typename deque<T>::reverse_iterator deque<T>::rend()
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return iterator(*m_deque, m_index+(is_forward?it_.m_index:m_deque->m_size-1-it_.m_index));
+  return reverse_iterator(*this, usize_t(-1));
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator-(ssize_t offset_) const
+void deque<T>::get(usize_t start_idx_, T *p_, usize_t num_items_) const
 {
-  return iterator_impl(*m_deque, m_index+(is_forward?-offset_:offset_));
+  // get items to the given array from the container
+  PFC_ASSERT_MSG(start_idx_+num_items_<=m_size, ("Reading values past the end of the container\r\n"));
+  destruct(p_, num_items_);
+  start_idx_+=m_offset;
+  while(num_items_)
+  {
+    // copy items in the stride to the given array
+    usize_t num_stride_items=min(num_items_, deque_traits<T>::ssize-(start_idx_&deque_traits<T>::smask));
+    copy_construct(p_, m_strides[start_idx_>>deque_traits<T>::sshift]+(start_idx_&deque_traits<T>::smask), num_stride_items);
+    start_idx_+=num_stride_items;
+    p_+=num_stride_items;
+    num_items_-=num_stride_items;
+  }
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator-(const const_iterator_impl<is_forward> &it_) const
+void deque<T>::set(usize_t start_idx_, const T *p_, usize_t num_items_)
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return iterator_impl(*m_deque, m_index+(is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1));
+  // set items from the given array to the container
+  PFC_ASSERT_MSG(start_idx_+num_items_<=m_size, ("Writing values past the end of the container\r\n"));
+  start_idx_+=m_offset;
+  while(num_items_)
+  {
+    // copy items to the stride from the given array
+    usize_t num_stride_items=min(num_items_, deque_traits<T>::ssize-(start_idx_&deque_traits<T>::smask));
+    T *data=m_strides[start_idx_>>deque_traits<T>::sshift]+(start_idx_&deque_traits<T>::smask);
+    destruct(data, num_stride_items);
+    copy_construct(data, p_, num_stride_items);
+    start_idx_+=num_stride_items;
+    p_+=num_stride_items;
+    num_items_-=num_stride_items;
+  }
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator-(const iterator_impl &it_) const
+void deque<T>::set(usize_t start_idx_, const T &v_, usize_t num_items_)
 {
-  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
-  return iterator_impl(*m_deque, m_index+(is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1));
+  // set array of given item to the container
+  PFC_ASSERT_MSG(start_idx_+num_items_<=m_size, ("Writing values past the end of the container\r\n"));
+  start_idx_+=m_offset;
+  while(num_items_)
+  {
+    // copy items to the stride from the given array
+    usize_t num_stride_items=min(num_items_, deque_traits<T>::ssize-(start_idx_&deque_traits<T>::smask));
+    T *data=m_strides[start_idx_>>deque_traits<T>::sshift]+(start_idx_&deque_traits<T>::smask);
+    destruct(data, num_stride_items);
+    copy_construct(data, v_, num_stride_items);
+    start_idx_+=num_stride_items;
+    num_items_-=num_stride_items;
+  }
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-T &deque<T>::iterator_impl<is_forward>::operator[](usize_t index_) const
+void deque<T>::push_front(const T &v_)
 {
-  return (*m_deque)[m_index+index_];
+  // push new element to the beginning of the deque
+  PFC_MEM_TRACK_STACK();
+  if(!m_offset)
+    alloc_stride_front();
+  --m_offset;
+  PFC_PNEW(--m_first)T(v_);  // todo: handle exceptions
+  ++m_size;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-T &deque<T>::iterator_impl<is_forward>::operator*() const
+T &deque<T>::push_front()
 {
-  return (*m_deque)[m_index];
+  // push default value to the beginning of the deque
+  PFC_MEM_TRACK_STACK();
+  if(!m_offset)
+    alloc_stride_front();
+  --m_offset;
+  PFC_PNEW(--m_first)T;  // todo: handle exceptions
+  ++m_size;
+  return *m_first;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-T *deque<T>::iterator_impl<is_forward>::operator->() const
+void deque<T>::push_back(const T &v_)
 {
-  return &(*m_deque)[m_index];
+  // push new element to the end of the deque
+  PFC_MEM_TRACK_STACK();
+  if(m_last==m_stride_last)
+    alloc_stride_back();
+  PFC_PNEW(++m_last)T(v_);  // todo: handle exceptions
+  ++m_size;
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-usize_t deque<T>::iterator_impl<is_forward>::index() const
+T &deque<T>::push_back()
 {
-  return m_index;
+  // push default value to the end of the deque
+  PFC_MEM_TRACK_STACK();
+  if(m_last==m_stride_last)
+    alloc_stride_back();
+  PFC_PNEW(++m_last)T;  // todo: handle exceptions
+  ++m_size;
+  return *m_last;
 }
-//----------------------------------------------------------------------------
+//----
 
 template<typename T>
-template<bool is_forward>
-deque<T>::iterator_impl<is_forward>::iterator_impl(deque<T> &deque_, usize_t index_)
-  :m_deque(&deque_)
-  ,m_index(index_)
+void deque<T>::insert_front(usize_t num_items_)
 {
+  // insert given number of default constructed items to the front of the deque
+  PFC_MEM_TRACK_STACK();
+  m_size+=num_items_;
+  while(num_items_)
+  {
+    if(!m_offset)
+      alloc_stride_front();
+    usize_t ni=min(m_offset, num_items_);
+    num_items_-=ni;
+    m_first-=ni;
+    m_offset-=ni;
+    reverse_default_construct(m_first, ni);
+  }
 }
-//----------------------------------------------------------------------------
+//----
 
 template<typename T>
-template<bool is_forward>
-void deque<T>::iterator_impl<is_forward>::move_construct_impl(const iterator_impl &dst_, const iterator_impl &src_, usize_t count_)
+void deque<T>::insert_front(usize_t num_items_, const T &v_)
 {
-  if(count_)
+  // insert given number of given items to the front of the deque
+  PFC_MEM_TRACK_STACK();
+  m_size+=num_items_;
+  while(num_items_)
   {
-    // move-construct deque sequence in passes
-    PFC_ASSERT(dst_.m_deque && src_.m_deque);
-    usize_t dst_idx=dst_.m_index+dst_.m_deque->m_offset;
-    usize_t src_idx=src_.m_index+src_.m_deque->m_offset;
-    if(src_idx>dst_idx)
-    {
-      // move items starting from the beginning of the deque
-      do
-      {
-        // copy longest continuous sequence from source to target deque
-        enum {smask=deque_traits<T>::smask, ssize=deque_traits<T>::ssize, sshift=deque_traits<T>::sshift};
-        usize_t dst_stride_idx=dst_idx&smask;
-        usize_t dst_stride_left=ssize-dst_stride_idx;
-        usize_t src_stride_idx=src_idx&smask;
-        usize_t src_stride_left=ssize-src_stride_idx;
-        usize_t num_pass_values=min(dst_stride_left, src_stride_left, count_);
-        move_construct(dst_.m_deque->m_strides[dst_idx>>sshift]+dst_stride_idx,
-                       src_.m_deque->m_strides[src_idx>>sshift]+src_stride_idx,
-                       num_pass_values);
-        dst_idx+=num_pass_values;
-        src_idx+=num_pass_values;
-        count_-=num_pass_values;
-      } while(count_);
-    }
-    else
-    {
-      // move items starting from the end of the deque
-      dst_idx+=count_-1;
-      src_idx+=count_-1;
-      do
-      {
-        // copy longest continuous sequence from source to target deque
-        enum {smask=deque_traits<T>::smask, ssize=deque_traits<T>::ssize, sshift=deque_traits<T>::sshift};
-        usize_t dst_stride_idx=dst_idx&smask;
-        usize_t src_stride_idx=src_idx&smask;
-        usize_t num_pass_values=min(dst_stride_idx+1, src_stride_idx+1, count_);
-        move_construct(dst_.m_deque->m_strides[dst_idx>>sshift]+dst_stride_idx-num_pass_values+1,
-                       src_.m_deque->m_strides[src_idx>>sshift]+src_stride_idx-num_pass_values+1,
-                       num_pass_values);
-        dst_idx-=num_pass_values;
-        src_idx-=num_pass_values;
-        count_-=num_pass_values;
-      } while(count_);
-    }
+    if(!m_offset)
+      alloc_stride_front();
+    usize_t ni=min(m_offset, num_items_);
+    num_items_-=ni;
+    m_first-=ni;
+    m_offset-=ni;
+    reverse_copy_construct(m_first, v_, ni);
   }
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-void deque<T>::iterator_impl<is_forward>::rotate_sequence_left_impl(const iterator_impl &first_, const iterator_impl &last_)
+void deque<T>::insert_front(usize_t num_items_, const T *v_)
 {
-  // rotate deque data sequence to the left
-  PFC_ASSERT_PEDANTIC_MSG(first_.m_deque && first_.m_deque==last_.m_deque, ("Iterators must be valid and of the same deque (first: %p, last: %p)\r\n", first_.m_deque, last_.m_deque));
-  PFC_ASSERT_PEDANTIC_MSG(first_.m_index<=last_.m_index, ("deque first iterator must precede last iterator (first: %u, last: %u)\r\n", first_.m_index, last_.m_index));
-  T &first=(*first_.m_deque)[first_.m_index], tmp(first);
-  first.~T();
-  move_construct_impl(first_, iterator_impl(*first_.m_deque, first_.m_index+1), last_.m_index-first_.m_index);
-  PFC_PNEW(&(*last_.m_deque)[last_.m_index])T(tmp);
+  // insert given number of given items to the front of the deque
+  PFC_MEM_TRACK_STACK();
+  m_size+=num_items_;
+  while(num_items_)
+  {
+    if(!m_offset)
+      alloc_stride_front();
+    usize_t ni=min(m_offset, num_items_);
+    num_items_-=ni;
+    m_first-=ni;
+    m_offset-=ni;
+    reverse_copy_construct(m_first, v_, ni);
+    v_+=ni;
+  }
 }
 //----
 
 template<typename T>
-template<bool is_forward>
-void deque<T>::iterator_impl<is_forward>::rotate_sequence_right_impl(const iterator_impl &first_, const iterator_impl &last_)
+void deque<T>::insert_back(usize_t num_items_)
 {
-  // rotate deque data sequence to the right
-  PFC_ASSERT_PEDANTIC_MSG(first_.m_deque && first_.m_deque==last_.m_deque, ("Iterators must be valid and of the same deque (first: %p, last: %p)\r\n", first_.m_deque, last_.m_deque));
-  PFC_ASSERT_PEDANTIC_MSG(first_.m_index<=last_.m_index, ("deque first iterator must precede last iterator (first: %u, last: %u)\r\n", first_.m_index, last_.m_index));
-  T &last=(*last_.m_deque)[last_.m_index], tmp(last);
-  last.~T();
-  move_construct_impl(iterator_impl(*first_.m_deque, first_.m_index+1), first_, last_.m_index-first_.m_index);
-  PFC_PNEW(&(*first_.m_deque)[first_.m_index])T(tmp);
+  PFC_MEM_TRACK_STACK();
+  resize(m_size+num_items_);
 }
-//----------------------------------------------------------------------------
-
+//----
 
-//============================================================================
-// list
-//============================================================================
-PFC_INTROSPEC_INL_TDEF1(typename T, list<T>)
+template<typename T>
+void deque<T>::insert_back(usize_t num_items_, const T &v_)
 {
-  PFC_CUSTOM_STREAMING(0);
-  switch(unsigned(PE::pe_type))
-  {
-    case penum_input:
-    {
-      // read data
-      PFC_MEM_TRACK_STACK();
-      clear();
-      uint32_t size;
-      pe_.var(size);
-      resize(size);
-      list<T>::iterator it=begin();
-      if(is_valid(it))
-      {
-        unsigned var_flags=0;
-        do
-        {
-          pe_.var(*it, var_flags);
-          var_flags=mvarflag_array_tail;
-          ++it;
-        } while(is_valid(it));
-      }
-    } break;
-
-    case penum_output:
-    case penum_display:
-    {
-      // write/display data
-      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize list<%s> that contains more than 2^32-1 elements\r\n", typeid(T).name()));
-      uint32_t size=(uint32_t)m_size;
-      pe_.var(size, 0, "size");
-      list<T>::iterator it=begin();
-      unsigned var_flags=mvarflag_mutable|mvarflag_mutable_ptr;
-      while(is_valid(it))
-      {
-        pe_.var(*it, var_flags);
-        var_flags|=mvarflag_array_tail;
-        ++it;
-      }
-    } break;
-  }
+  PFC_MEM_TRACK_STACK();
+  resize(m_size+num_items_, v_);
 }
-//----------------------------------------------------------------------------
+//----
 
 template<typename T>
-list<T>::list(memory_allocator_base *alloc_)
-  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
-  ,m_size(0)
-  ,m_first(0)
-  ,m_last(0)
+void deque<T>::insert_back(usize_t num_items_, const T *v_)
 {
-  PFC_ASSERT_CALL(m_allocator->check_allocator(list_traits<T>::block_alloc_size, list_traits<T>::block_alloc_align));
+  // insert array of values to the deque
+  PFC_MEM_TRACK_STACK();
+  for(usize_t i=0; i<num_items_; ++i)
+  {
+    if(m_last==m_stride_last)
+      alloc_stride_back();
+    PFC_PNEW(++m_last)T(*v_++);  // todo: handle exceptions
+  }
+  m_size+=num_items_;
 }
 //----
 
 template<typename T>
-list<T>::list(const list &l_)
-  :m_allocator(&default_memory_allocator::inst())
+void deque<T>::pop_front()
 {
-  PFC_MEM_TRACK_STACK();
-  cctor(l_);
+  // remove the first element from the beginning of the deque
+  PFC_ASSERT_PEDANTIC(m_size);
+  --m_size;
+  m_first++->~T();
+  if(!((++m_offset)&deque_traits<T>::smask))
+    dealloc_stride_front();
 }
 //----
 
 template<typename T>
-list<T>::list(const list &l_, memory_allocator_base *alloc_)
-  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+void deque<T>::pop_back()
 {
-  PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(list_traits<T>::block_alloc_size, list_traits<T>::block_alloc_align));
-  cctor(l_);
+  // remove the last element from the end of the deque
+  PFC_ASSERT_PEDANTIC(m_size);
+  --m_size;
+  m_last--->~T();
+  if(m_last==m_stride_last-deque_traits<T>::ssize)
+    dealloc_stride_back();
 }
 //----
 
 template<typename T>
-list<T>::list(usize_t size_, memory_allocator_base *alloc_)
-  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+void deque<T>::remove_front(usize_t num_items_)
+{
+  // remove given number of items from the beginning of the deque
+  PFC_ASSERT_PEDANTIC(m_size>=num_items_);
+  m_size-=num_items_;
+  while(num_items_)
+  {
+    usize_t ni=min(num_items_, deque_traits<T>::ssize-m_offset);
+    num_items_-=ni;
+    destruct(m_first, ni);
+    m_first+=ni;
+    m_offset+=ni;
+    if(!(m_offset&deque_traits<T>::smask))
+      dealloc_stride_front();
+  }
+}
+//----
+
+template<typename T>
+void deque<T>::remove_back(usize_t num_items_)
+{
+  // remove given number of items from the end of the deque
+  PFC_ASSERT_PEDANTIC(m_size>=num_items_);
+  m_size-=num_items_;
+  while(num_items_)
+  {
+    usize_t ni=min(num_items_, usize_t(m_last-(m_stride_last-deque_traits<T>::ssize)));
+    num_items_-=ni;
+    m_last-=ni,
+    reverse_destruct(m_last+1, ni);
+    if(m_last==m_stride_last-deque_traits<T>::ssize)
+      dealloc_stride_back();
+  }
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+void deque<T>::cctor(const deque &dq_)
+{
+  // copy-construct the deque
+  m_size=0;
+  m_offset=dq_.m_offset;
+  m_strides.resize(dq_.m_strides.size());
+  usize_t idx=0, offset=m_offset;
+  PFC_EDTOR(*this, &deque<T>::clear);
+  while(m_size<dq_.m_size)
+  {
+    eh_data<T> p(*m_allocator, deque_traits<T>::ssize, deque_traits<T>::block_alloc_align);
+    m_strides[idx]=p.data;
+    usize_t num_vals=min(deque_traits<T>::ssize-offset, dq_.m_size-m_size);
+    copy_construct(m_strides[idx]+offset, dq_.m_strides[idx]+offset, num_vals);
+    p.reset();
+    offset=0;
+    ++idx;
+    m_size+=num_vals;
+  }
+  PFC_EDTOR_RESET();
+
+  // setup first & last pointers
+  if(m_size)
+  {
+    m_first=m_strides.front()+m_offset;
+    m_last=m_strides.back()+((m_size-1)&deque_traits<T>::smask);
+    m_stride_last=m_strides.back()+deque_traits<T>::smask;
+  }
+  else
+    m_first=m_last=m_stride_last=0;
+}
+//----
+
+template<typename T>
+void deque<T>::alloc_stride_front()
+{
+  // allocate new first stride
+  eh_data<T> p(*m_allocator, deque_traits<T>::ssize, deque_traits<T>::block_alloc_align);
+  m_strides.push_back(0);
+  mem_move(m_strides.data()+1, m_strides.data(), sizeof(T*)*(m_strides.size()-1));
+  m_strides.front()=p.data;
+  m_first=p.data+deque_traits<T>::ssize;
+  if(!m_size)
+    m_last=m_stride_last=m_first-1;
+  m_offset=deque_traits<T>::ssize;
+  p.reset();
+}
+//----
+
+template<typename T>
+void deque<T>::alloc_stride_back()
+{
+  // allocate new last stride
+  eh_data<T> p(*m_allocator, deque_traits<T>::ssize, deque_traits<T>::block_alloc_align);
+  m_strides.push_back(p.data);
+  m_last=p.data-1;
+  m_stride_last=p.data+deque_traits<T>::smask;
+  if(!m_size)
+    m_first=p.data;
+  p.reset();
+}
+//----
+
+template<typename T>
+void deque<T>::dealloc_stride_front()
+{
+  // deallocate first stride
+  m_allocator->free(m_strides.front());
+  mem_move(m_strides.data(), m_strides.data()+1, sizeof(T*)*(m_strides.size()-1));
+  m_strides.pop_back();
+  m_offset=0;
+  if(!m_size)
+    m_first=m_last=m_stride_last=0;
+  else
+    m_first=m_strides.front();
+}
+//----
+
+template<typename T>
+void deque<T>::dealloc_stride_back()
+{
+  // deallocate last stride
+  m_allocator->free(m_strides.back());
+  m_strides.pop_back();
+  if(!m_size)
+    m_first=m_last=m_stride_last=0;
+  else
+    m_last=m_stride_last=m_strides.back()+deque_traits<T>::smask;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// deque::const_iterator_impl
+//============================================================================
+template<typename T>
+template<bool is_forward>
+deque<T>::const_iterator_impl<is_forward>::const_iterator_impl()
+  :m_deque(0)
+  ,m_index(0)
+{
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+deque<T>::const_iterator_impl<is_forward>::const_iterator_impl(const iterator_impl<is_forward> &it_)
+  :m_deque(it_.m_deque)
+  ,m_index(it_.m_index)
+{
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+void deque<T>::const_iterator_impl<is_forward>::reset()
+{
+  m_deque=0;
+  m_index=0;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+template<bool is_forward>
+bool deque<T>::const_iterator_impl<is_forward>::operator==(const const_iterator_impl &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return m_index==it_.m_index;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool deque<T>::const_iterator_impl<is_forward>::operator==(const iterator_impl<is_forward> &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return m_index==it_.m_index;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool deque<T>::const_iterator_impl<is_forward>::operator!=(const const_iterator_impl &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return m_index!=it_.m_index;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool deque<T>::const_iterator_impl<is_forward>::operator!=(const iterator_impl<is_forward> &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return m_index!=it_.m_index;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator++()
+{
+  m_index+=is_forward?1:usize_t(-1);
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator--()
+{
+  m_index+=is_forward?usize_t(-1):1;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator+=(ssize_t offset_)
+{
+  m_index+=is_forward?offset_:-offset_;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator+=(const const_iterator_impl &it_)
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  m_index+=is_forward?it_.m_index:m_deque->m_size-1-it_.m_index;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator+=(const iterator_impl<is_forward> &it_)
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  m_index+=is_forward?it_.m_index:m_deque->m_size-1-it_.m_index;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator-=(ssize_t offset_)
+{
+  m_index+=is_forward?-offset_:offset_;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator-=(const const_iterator_impl &it_)
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  m_index+=is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> &deque<T>::const_iterator_impl<is_forward>::operator-=(const iterator_impl<is_forward> &it_)
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  m_index+=is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator+(ssize_t offset_) const
+{
+  return const_iterator_impl(*m_deque, m_index+(is_forward?offset_:-offset_));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator+(const const_iterator_impl &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return const_iterator_impl(*m_deque, m_index+(is_forward?it_.m_index:m_deque->m_size-1-it_.m_index));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator+(const iterator_impl<is_forward> &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return const_iterator_impl(*m_deque, m_index+(is_forward?it_.m_index:m_deque->m_size-1-it_.m_index));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator-(ssize_t offset_) const
+{
+  return const_iterator_impl(*m_deque, m_index+(is_forward?-offset_:offset_));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator-(const const_iterator_impl &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return const_iterator_impl(*m_deque, m_index+(is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template const_iterator_impl<is_forward> deque<T>::const_iterator_impl<is_forward>::operator-(const iterator_impl<is_forward> &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return const_iterator_impl(*m_deque, m_index+(is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+const T &deque<T>::const_iterator_impl<is_forward>::operator[](usize_t index_) const
+{
+  return (*m_deque)[m_index+index_];
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+const T &deque<T>::const_iterator_impl<is_forward>::operator*() const
+{
+  return (*m_deque)[m_index];
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+const T *deque<T>::const_iterator_impl<is_forward>::operator->() const
+{
+  return &(*m_deque)[m_index];
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+usize_t deque<T>::const_iterator_impl<is_forward>::index() const
+{
+  return m_index;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+template<bool is_forward>
+deque<T>::const_iterator_impl<is_forward>::const_iterator_impl(const deque<T> &deque_, usize_t index_)
+  :m_deque(&deque_)
+  ,m_index(index_)
+{
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// deque::iterator_impl
+//============================================================================
+template<typename T>
+template<bool is_forward>
+deque<T>::iterator_impl<is_forward>::iterator_impl()
+  :m_deque(0)
+  ,m_index(0)
+{
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+void deque<T>::iterator_impl<is_forward>::reset()
+{
+  m_deque=0;
+  m_index=0;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+template<bool is_forward>
+bool deque<T>::iterator_impl<is_forward>::operator==(const const_iterator_impl<is_forward> &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return m_index==it_.m_index;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool deque<T>::iterator_impl<is_forward>::operator==(const iterator_impl &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return m_index==it_.m_index;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool deque<T>::iterator_impl<is_forward>::operator!=(const const_iterator_impl<is_forward> &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return m_index!=it_.m_index;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool deque<T>::iterator_impl<is_forward>::operator!=(const iterator_impl &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return m_index!=it_.m_index;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator++()
+{
+  m_index+=is_forward?1:usize_t(-1);
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator--()
+{
+  m_index+=is_forward?usize_t(-1):1;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator+=(ssize_t offset_)
+{
+  m_index+=is_forward?offset_:-offset_;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator+=(const const_iterator_impl<is_forward> &it_)
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  m_index+=is_forward?it_.m_index:m_deque->m_size-1-it_.m_index;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator+=(const iterator_impl &it_)
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  m_index+=is_forward?it_.m_index:m_deque->m_size-1-it_.m_index;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator-=(ssize_t offset_)
+{
+  m_index-=offset_;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator-=(const const_iterator_impl<is_forward> &it_)
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  m_index+=is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> &deque<T>::iterator_impl<is_forward>::operator-=(const iterator_impl &it_)
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  m_index+=is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator+(ssize_t offset_) const
+{
+  return iterator_impl(*m_deque, m_index+(is_forward?offset_:-offset_));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator+(const const_iterator_impl<is_forward> &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return iterator_impl(*m_deque, m_index+(is_forward?it_.m_index:m_deque->m_size-1-it_.m_index));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator+(const iterator_impl &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return iterator(*m_deque, m_index+(is_forward?it_.m_index:m_deque->m_size-1-it_.m_index));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator-(ssize_t offset_) const
+{
+  return iterator_impl(*m_deque, m_index+(is_forward?-offset_:offset_));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator-(const const_iterator_impl<is_forward> &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return iterator_impl(*m_deque, m_index+(is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename deque<T>::template iterator_impl<is_forward> deque<T>::iterator_impl<is_forward>::operator-(const iterator_impl &it_) const
+{
+  PFC_ASSERT_PEDANTIC(m_deque==it_.m_deque);
+  return iterator_impl(*m_deque, m_index+(is_forward?-it_.m_index:it_.m_index-m_deque->m_size+1));
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+T &deque<T>::iterator_impl<is_forward>::operator[](usize_t index_) const
+{
+  return (*m_deque)[m_index+index_];
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+T &deque<T>::iterator_impl<is_forward>::operator*() const
+{
+  return (*m_deque)[m_index];
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+T *deque<T>::iterator_impl<is_forward>::operator->() const
+{
+  return &(*m_deque)[m_index];
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+usize_t deque<T>::iterator_impl<is_forward>::index() const
+{
+  return m_index;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+template<bool is_forward>
+deque<T>::iterator_impl<is_forward>::iterator_impl(deque<T> &deque_, usize_t index_)
+  :m_deque(&deque_)
+  ,m_index(index_)
+{
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+template<bool is_forward>
+void deque<T>::iterator_impl<is_forward>::move_construct_impl(const iterator_impl &dst_, const iterator_impl &src_, usize_t count_)
+{
+  if(count_)
+  {
+    // move-construct deque sequence in passes
+    PFC_ASSERT(dst_.m_deque && src_.m_deque);
+    usize_t dst_idx=dst_.m_index+dst_.m_deque->m_offset;
+    usize_t src_idx=src_.m_index+src_.m_deque->m_offset;
+    if(src_idx>dst_idx)
+    {
+      // move items starting from the beginning of the deque
+      do
+      {
+        // copy longest continuous sequence from source to target deque
+        enum {smask=deque_traits<T>::smask, ssize=deque_traits<T>::ssize, sshift=deque_traits<T>::sshift};
+        usize_t dst_stride_idx=dst_idx&smask;
+        usize_t dst_stride_left=ssize-dst_stride_idx;
+        usize_t src_stride_idx=src_idx&smask;
+        usize_t src_stride_left=ssize-src_stride_idx;
+        usize_t num_pass_values=min(dst_stride_left, src_stride_left, count_);
+        move_construct(dst_.m_deque->m_strides[dst_idx>>sshift]+dst_stride_idx,
+                       src_.m_deque->m_strides[src_idx>>sshift]+src_stride_idx,
+                       num_pass_values);
+        dst_idx+=num_pass_values;
+        src_idx+=num_pass_values;
+        count_-=num_pass_values;
+      } while(count_);
+    }
+    else
+    {
+      // move items starting from the end of the deque
+      dst_idx+=count_-1;
+      src_idx+=count_-1;
+      do
+      {
+        // copy longest continuous sequence from source to target deque
+        enum {smask=deque_traits<T>::smask, ssize=deque_traits<T>::ssize, sshift=deque_traits<T>::sshift};
+        usize_t dst_stride_idx=dst_idx&smask;
+        usize_t src_stride_idx=src_idx&smask;
+        usize_t num_pass_values=min(dst_stride_idx+1, src_stride_idx+1, count_);
+        move_construct(dst_.m_deque->m_strides[dst_idx>>sshift]+dst_stride_idx-num_pass_values+1,
+                       src_.m_deque->m_strides[src_idx>>sshift]+src_stride_idx-num_pass_values+1,
+                       num_pass_values);
+        dst_idx-=num_pass_values;
+        src_idx-=num_pass_values;
+        count_-=num_pass_values;
+      } while(count_);
+    }
+  }
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+void deque<T>::iterator_impl<is_forward>::rotate_sequence_left_impl(const iterator_impl &first_, const iterator_impl &last_)
+{
+  // rotate deque data sequence to the left
+  PFC_ASSERT_PEDANTIC_MSG(first_.m_deque && first_.m_deque==last_.m_deque, ("Iterators must be valid and of the same deque (first: %p, last: %p)\r\n", first_.m_deque, last_.m_deque));
+  PFC_ASSERT_PEDANTIC_MSG(first_.m_index<=last_.m_index, ("deque first iterator must precede last iterator (first: %u, last: %u)\r\n", first_.m_index, last_.m_index));
+  T &first=(*first_.m_deque)[first_.m_index], tmp(first);
+  first.~T();
+  move_construct_impl(first_, iterator_impl(*first_.m_deque, first_.m_index+1), last_.m_index-first_.m_index);
+  PFC_PNEW(&(*last_.m_deque)[last_.m_index])T(tmp);
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+void deque<T>::iterator_impl<is_forward>::rotate_sequence_right_impl(const iterator_impl &first_, const iterator_impl &last_)
+{
+  // rotate deque data sequence to the right
+  PFC_ASSERT_PEDANTIC_MSG(first_.m_deque && first_.m_deque==last_.m_deque, ("Iterators must be valid and of the same deque (first: %p, last: %p)\r\n", first_.m_deque, last_.m_deque));
+  PFC_ASSERT_PEDANTIC_MSG(first_.m_index<=last_.m_index, ("deque first iterator must precede last iterator (first: %u, last: %u)\r\n", first_.m_index, last_.m_index));
+  T &last=(*last_.m_deque)[last_.m_index], tmp(last);
+  last.~T();
+  move_construct_impl(iterator_impl(*first_.m_deque, first_.m_index+1), first_, last_.m_index-first_.m_index);
+  PFC_PNEW(&(*first_.m_deque)[first_.m_index])T(tmp);
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// list
+//============================================================================
+PFC_INTROSPEC_INL_TDEF1(typename T, list<T>)
+{
+  PFC_CUSTOM_STREAMING(0);
+  switch(unsigned(PE::pe_type))
+  {
+    case penum_input:
+    {
+      // read data
+      PFC_MEM_TRACK_STACK();
+      clear();
+      uint32_t size;
+      pe_.var(size);
+      resize(size);
+      list<T>::iterator it=begin();
+      if(is_valid(it))
+      {
+        unsigned var_flags=0;
+        do
+        {
+          pe_.var(*it, var_flags);
+          var_flags=mvarflag_array_tail;
+          ++it;
+        } while(is_valid(it));
+      }
+    } break;
+
+    case penum_output:
+    case penum_display:
+    {
+      // write/display data
+      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize list<%s> that contains more than 2^32-1 elements\r\n", typeid(T).name()));
+      uint32_t size=(uint32_t)m_size;
+      pe_.var(size, 0, "size");
+      list<T>::iterator it=begin();
+      unsigned var_flags=mvarflag_mutable|mvarflag_mutable_ptr;
+      while(is_valid(it))
+      {
+        pe_.var(*it, var_flags);
+        var_flags|=mvarflag_array_tail;
+        ++it;
+      }
+    } break;
+  }
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+list<T>::list(memory_allocator_base *alloc_)
+  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+  ,m_size(0)
+  ,m_first(0)
+  ,m_last(0)
+{
+  PFC_ASSERT_CALL(m_allocator->check_allocator(list_traits<T>::block_alloc_size, list_traits<T>::block_alloc_align));
+}
+//----
+
+template<typename T>
+list<T>::list(const list &l_)
+  :m_allocator(&default_memory_allocator::inst())
+{
+  PFC_MEM_TRACK_STACK();
+  cctor(l_);
+}
+//----
+
+template<typename T>
+list<T>::list(const list &l_, memory_allocator_base *alloc_)
+  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+{
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(list_traits<T>::block_alloc_size, list_traits<T>::block_alloc_align));
+  cctor(l_);
+}
+//----
+
+template<typename T>
+list<T>::list(usize_t size_, memory_allocator_base *alloc_)
+  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+{
+  // construct the list
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(list_traits<T>::block_alloc_size, list_traits<T>::block_alloc_align));
+  item **next=&m_first, *i=0;
+  if((m_size=size_)!=0)
+  {
+    PFC_EDTOR(*this, &list<T>::clear);
+    item *prev=0;
+    do
+    {
+      // add new item to the list
+      eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+      i=p.data;
+      PFC_PNEW(&i->data)T;
+      p.reset();
+      i->prev=prev;
+      *next=i;
+      prev=i;
+      next=&i->next;
+    } while(--size_);
+    PFC_EDTOR_RESET();
+  }
+  *next=0;
+  m_last=i;
+}
+//----
+
+template<typename T>
+list<T>::list(usize_t size_, const T &v_, memory_allocator_base *alloc_)
+  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+{
+  // construct the list
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(list_traits<T>::block_alloc_size, list_traits<T>::block_alloc_align));
+  item **next=&m_first, *i=0;
+  if((m_size=size_)!=0)
+  {
+    PFC_EDTOR(*this, &list<T>::clear);
+    item *prev=0;
+    do
+    {
+      // add new item to the list
+      eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+      i=p.data;
+      PFC_PNEW(&i->data)T(v_);
+      p.reset();
+      i->prev=prev;
+      *next=i;
+      prev=i;
+      next=&i->next;
+    } while(--size_);
+    PFC_EDTOR_RESET();
+  }
+  *next=0;
+  m_last=i;
+}
+//----
+
+template<typename T>
+list<T>::~list()
+{
+  clear();
+}
+//----
+
+template<typename T>
+void list<T>::set_allocator(memory_allocator_base *alloc_)
+{
+  PFC_ASSERT_MSG(!m_size, ("Unable to change the allocator for a non-empty list\r\n"));
+  m_allocator=alloc_?alloc_:&default_memory_allocator::inst();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(list_traits<T>::block_alloc_size, list_traits<T>::block_alloc_align));
+}
+//----
+
+template<typename T>
+void list<T>::operator=(const list &l_)
+{
+  list<T> l(l_);
+  swap(l);
+}
+//----
+
+template<typename T>
+void list<T>::clear()
+{
+  // clear the list
+  item *i=m_last;
+  if(i)
+  {
+    do
+    {
+      i->data.~T();
+      item *prev=i->prev;
+      m_allocator->free(i);
+      i=prev;
+    } while(i);
+    m_first=m_last=0;
+    m_size=0;
+  }
+}
+//----
+
+template<typename T>
+void list<T>::resize(usize_t size_)
+{
+  if(size_<m_size)
+  {
+    // release elements from the end of the list to match given size
+    usize_t count=m_size-size_;
+    item *it=m_last;
+    do
+    {
+      it->data.~T();
+      item *prev=it->prev;
+      m_allocator->free(it);
+      it=prev;
+    } while(--count);
+    m_size=size_;
+    m_last=it;
+    if(it)
+      m_last->next=0;
+    else
+      m_first=0;
+  }
+  else
+  {
+    // add elements to the end of the list to match given size
+    PFC_MEM_TRACK_STACK();
+    usize_t count=size_-m_size;
+    if(count)
+    {
+      item *prev=m_last, **next=m_last?&m_last->next:&m_first, *i;
+      do
+      {
+        // add new item to the list
+        eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+        i=p.data;
+        PFC_PNEW(&i->data)T;
+        p.reset();
+        i->prev=prev;
+        *next=i;
+        prev=i;
+        next=&i->next;
+      } while(--count);
+      m_size=size_;
+      *next=0;
+      m_last=i;
+    }
+  }
+}
+//----
+
+template<typename T>
+void list<T>::resize(usize_t size_, const T &v_)
+{
+  if(size_<m_size)
+  {
+    // release elements from the end of the list to match given size
+    usize_t count=m_size-size_;
+    item *it=m_last;
+    do
+    {
+      it->data.~T();
+      item *prev=it->prev;
+      m_allocator->free(it);
+      it=prev;
+    } while(--count);
+    m_size=size_;
+    m_last=it;
+    if(it)
+      m_last->next=0;
+    else
+      m_first=0;
+  }
+  else
+  {
+    // add elements to the end of the list to match given size
+    PFC_MEM_TRACK_STACK();
+    usize_t count=size_-m_size;
+    if(count)
+    {
+      item *prev=m_last, **next=m_last?&m_last->next:&m_first, *i;
+      do
+      {
+        // add new item to the list
+        eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+        i=p.data;
+        PFC_PNEW(&i->data)T(v_);
+        p.reset();
+        i->prev=prev;
+        *next=i;
+        prev=i;
+        next=&i->next;
+      } while(--count);
+      m_size=size_;
+      *next=0;
+      m_last=i;
+    }
+  }
+}
+//----
+
+template<typename T>
+void list<T>::swap(list &l_)
+{
+  // swap content of the lists
+  pfc::swap(m_allocator, l_.m_allocator);
+  pfc::swap(m_size, l_.m_size);
+  pfc::swap(m_first, l_.m_first);
+  pfc::swap(m_last, l_.m_last);
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+memory_allocator_base &list<T>::allocator() const
+{
+  return *m_allocator;
+}
+//----
+
+template<typename T>
+usize_t list<T>::size() const
+{
+  return m_size;
+}
+//----
+
+template<typename T>
+const T &list<T>::front() const
+{
+  PFC_ASSERT_PEDANTIC(m_size);
+  return m_first->data;
+}
+//----
+
+template<typename T>
+T &list<T>::front()
+{
+  PFC_ASSERT_PEDANTIC(m_size);
+  return m_first->data;
+}
+//----
+
+template<typename T>
+const T &list<T>::back() const
+{
+  PFC_ASSERT_PEDANTIC(m_size);
+  return m_last->data;
+}
+//----
+
+template<typename T>
+T &list<T>::back()
+{
+  PFC_ASSERT_PEDANTIC(m_size);
+  return m_last->data;
+}
+//----
+
+template<typename T>
+typename list<T>::const_iterator list<T>::begin() const
+{
+  return m_first;
+}
+//----
+
+template<typename T>
+typename list<T>::iterator list<T>::begin()
+{
+  return iterator(*this, m_first);
+}
+//----
+
+template<typename T>
+typename list<T>::const_reverse_iterator list<T>::rbegin() const
+{
+  return m_last;
+}
+//----
+
+template<typename T>
+typename list<T>::reverse_iterator list<T>::rbegin()
+{
+  return reverse_iterator(*this, m_last);
+}
+//----
+
+template<typename T>
+typename list<T>::const_iterator list<T>::last() const
+{
+  return const_iterator(m_last);
+}
+//----
+
+template<typename T>
+typename list<T>::iterator list<T>::last()
+{
+  return iterator(*this, m_last);
+}
+//----
+
+template<typename T>
+typename list<T>::const_reverse_iterator list<T>::rlast() const
+{
+  return const_reverse_iterator(m_first);
+}
+//----
+
+template<typename T>
+typename list<T>::reverse_iterator list<T>::rlast()
+{
+  return reverse_iterator(*this, m_first);
+}
+//----
+
+template<typename T>
+typename list<T>::const_iterator list<T>::end() const
+{
+  return const_iterator();
+}
+//----
+
+template<typename T>
+typename list<T>::iterator list<T>::end()
+{
+  return iterator();
+}
+//----
+
+template<typename T>
+typename list<T>::const_reverse_iterator list<T>::rend() const
+{
+  return const_reverse_iterator();
+}
+//----
+
+template<typename T>
+typename list<T>::reverse_iterator list<T>::rend()
+{
+  return reverse_iterator();
+}
+//----
+
+template<typename T>
+void list<T>::push_front(const T &v_)
+{
+  // push an element to the beginning of the list
+  PFC_MEM_TRACK_STACK();
+  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+  item *i=p.data;
+  PFC_PNEW(&p.data->data)T(v_);
+  p.reset();
+  i->prev=0;
+  i->next=m_first;
+  if(!m_last)
+    m_last=i;
+  else
+    m_first->prev=i;
+  m_first=i;
+  ++m_size;
+}
+//----
+
+template<typename T>
+T &list<T>::push_front()
+{
+  // push default value to the beginning of the list
+  PFC_MEM_TRACK_STACK();
+  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+  item *i=p.data;
+  PFC_PNEW(&p.data->data)T;
+  p.reset();
+  i->prev=0;
+  i->next=m_first;
+  if(!m_last)
+    m_last=i;
+  else
+    m_first->prev=i;
+  m_first=i;
+  ++m_size;
+  return m_first->data;
+}
+//----
+
+template<typename T>
+void list<T>::push_back(const T &v_)
+{
+  // push an element to the end of the list
+  PFC_MEM_TRACK_STACK();
+  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+  item *i=p.data;
+  PFC_PNEW(&i->data)T(v_);
+  p.reset();
+  i->prev=m_last;
+  i->next=0;
+  if(!m_first)
+    m_first=i;
+  else
+    m_last->next=i;
+  m_last=i;
+  ++m_size;
+}
+//----
+
+template<typename T>
+T &list<T>::push_back()
+{
+  // push an element to the end of the list
+  PFC_MEM_TRACK_STACK();
+  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+  item *i=p.data;
+  PFC_PNEW(&i->data)T;
+  p.reset();
+  i->prev=m_last;
+  i->next=0;
+  if(!m_first)
+    m_first=i;
+  else
+    m_last->next=i;
+  m_last=i;
+  ++m_size;
+  return m_last->data;
+}
+//----
+
+template<typename T>
+void list<T>::insert_front(usize_t num_items_)
+{
+  PFC_MEM_TRACK_STACK();
+  while(num_items_--)
+    push_front();
+}
+//----
+
+template<typename T>
+void list<T>::insert_front(usize_t num_items_, const T &v_)
+{
+  PFC_MEM_TRACK_STACK();
+  while(num_items_--)
+    push_front(v_);
+}
+//----
+
+template<typename T>
+void list<T>::insert_front(usize_t num_items_, const T *v_)
+{
+  PFC_MEM_TRACK_STACK();
+  while(num_items_--)
+    push_front(*v_++);
+}
+//----
+
+template<typename T>
+void list<T>::insert_front(const list<T> &l_)
+{
+  list<T> l(l_);
+  splice_front(l);
+}
+//----
+
+template<typename T>
+void list<T>::insert_back(usize_t num_items_)
+{
+  PFC_MEM_TRACK_STACK();
+  resize(m_size+num_items_);
+}
+//----
+
+template<typename T>
+void list<T>::insert_back(usize_t num_items_, const T &v_)
+{
+  PFC_MEM_TRACK_STACK();
+  resize(m_size+num_items_, v_);
+}
+//----
+
+template<typename T>
+void list<T>::insert_back(usize_t num_items_, const T *v_)
+{
+  PFC_MEM_TRACK_STACK();
+  for(usize_t i=0; i<num_items_; ++i)
+    push_back(*v_++);
+}
+//----
+
+template<typename T>
+void list<T>::insert_back(const list<T> &l_)
+{
+  list<T> l(l_);
+  splice_back(l);
+}
+//----
+
+template<typename T>
+void list<T>::insert_before(iterator &it_, const T &v_)
+{
+  // insert given item before the iterator
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_PEDANTIC(it_.m_item);
+  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+  item *i=p.data;
+  PFC_PNEW(&i->data)T(v_);
+  p.reset();
+  if(it_.m_item->prev)
+  {
+    it_.m_item->prev->next=i;
+    i->prev=it_.m_item->prev;
+  }
+  else
+    m_first=i;
+  it_.m_item->prev=i;
+  i->next=it_.m_item;
+  ++m_size;
+}
+//----
+
+template<typename T>
+T &list<T>::insert_before(iterator &it_)
+{
+  // insert default-constructed item before the iterator
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_PEDANTIC(it_.m_item);
+  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+  item *i=p.data;
+  PFC_PNEW(&i->data)T;
+  p.reset();
+  if(it_.m_item->prev)
+  {
+    it_.m_item->prev->next=i;
+    i->prev=it_.m_item->prev;
+  }
+  else
+  {
+    m_first=i;
+    i->prev=0;
+  }
+  it_.m_item->prev=i;
+  i->next=it_.m_item;
+  ++m_size;
+  return i->data;
+}
+//----
+
+template<typename T>
+void list<T>::insert_after(iterator &it_, const T &v_)
+{
+  // insert given item after the iterator
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_PEDANTIC(it_.m_item);
+  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+  item *i=p.data;
+  PFC_PNEW(&i->data)T(v_);
+  p.reset();
+  if(it_.m_item->next)
+  {
+    it_.m_item->next->prev=i;
+    i->next=it_.m_item->next;
+  }
+  else
+  {
+    m_last=i;
+    i->next=0;
+  }
+  it_.m_item->next=i;
+  i->prev=it_.m_item;
+  ++m_size;
+}
+//----
+
+template<typename T>
+T &list<T>::insert_after(iterator &it_)
+{
+  // insert default-constructed item after the iterator
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_PEDANTIC(it_.m_item);
+  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+  item *i=p.data;
+  PFC_PNEW(&i->data)T;
+  p.reset();
+  if(it_.m_item->next)
+  {
+    it_.m_item->next->prev=i;
+    i->next=it_.m_item->next;
+  }
+  else
+    m_last=i;
+  it_.m_item->next=i;
+  i->prev=it_.m_item;
+  ++m_size;
+  return i->data;
+}
+//----
+
+template<typename T>
+void list<T>::splice_front(list &l_)
+{
+  // push a list to the beginning of the list
+  PFC_ASSERT(m_allocator==l_.m_allocator);
+  m_size+=l_.m_size;
+  if(!m_first)
+  {
+    m_first=l_.m_first;
+    m_last=l_.m_last;
+  }
+  else
+  {
+    m_first->prev=l_.m_last;
+    if(l_.m_last)
+    {
+      l_.m_last->next=m_first;
+      m_first=l_.m_first;
+    }
+  }
+
+  // clear the source list
+  l_.m_size=0;
+  l_.m_first=0;
+  l_.m_last=0;
+}
+//----
+
+template<typename T>
+void list<T>::splice_front(iterator &it_)
+{
+  if(it_.m_item)
+  {
+    // remove item from its list and add to the beginning of this list
+    PFC_ASSERT(m_allocator==it_.m_list->m_allocator);
+    it_.m_list->detach(it_);
+    it_.m_item->next=m_first;
+    it_.m_item->prev=0;
+    if(m_first)
+      m_first->prev=it_.m_item;
+    else
+      m_last=it_.m_item;
+    m_first=it_.m_item;
+    ++m_size;
+  }
+}
+//----
+
+template<typename T>
+void list<T>::splice_back(list &l_)
+{
+  // push a list to the end of the list
+  PFC_ASSERT(m_allocator==l_.m_allocator);
+  m_size+=l_.m_size;
+  if(!m_first)
+  {
+    m_first=l_.m_first;
+    m_last=l_.m_last;
+  }
+  else
+  {
+    m_last->next=l_.m_first;
+    if(l_.m_first)
+    {
+      l_.m_first->prev=m_last;
+      m_last=l_.m_last;
+    }
+  }
+
+  // clear the source list
+  l_.m_size=0;
+  l_.m_first=0;
+  l_.m_last=0;
+}
+//----
+
+template<typename T>
+void list<T>::splice_back(iterator &it_)
+{
+  if(it_.m_item)
+  {
+    // remove item from its list and add to the end of this list
+    PFC_ASSERT(m_allocator==it_.m_list->m_allocator);
+    it_.m_list->detach(it_);
+    it_.m_item->next=0;
+    it_.m_item->prev=m_last;
+    if(m_last)
+      m_last->next=it_.m_item;
+    else
+      m_first=it_.m_item;
+    m_last=it_.m_item;
+    ++m_size;
+  }
+}
+//----
+
+template<typename T>
+void list<T>::pop_front()
+{
+  // remove element from the beginning of the list
+  PFC_ASSERT_PEDANTIC(m_size);
+  item *i=m_first;
+  m_first=i->next;
+  if(!--m_size)
+    m_last=0;
+  else
+    m_first->prev=0;
+  i->data.~T();
+  m_allocator->free(i);
+}
+//----
+
+template<typename T>
+void list<T>::pop_back()
+{
+  // remove element from the end of the list
+  PFC_ASSERT_PEDANTIC(m_size);
+  item *i=m_last;
+  m_last=i->prev;
+  if(!--m_size)
+    m_first=0;
+  else
+    m_last->next=0;
+  i->data.~T();
+  m_allocator->free(i);
+}
+//----
+
+template<typename T>
+void list<T>::remove_front(usize_t num_items_)
+{
+  // remove given number of items from the beginning of the list
+  PFC_ASSERT(m_size>=num_items_);
+  for(usize_t i=0; i<num_items_; ++i)
+  {
+    item *next=m_first->next;
+    m_first->data.~T();
+    m_allocator->free(m_first);
+    m_first=next;
+  }
+  m_size-=num_items_;
+  if(!m_size)
+    m_last=0;
+}
+//----
+
+template<typename T>
+void list<T>::remove_back(usize_t num_items_)
+{
+  // remove given number of items from the end of the list
+  PFC_ASSERT(m_size>=num_items_);
+  for(usize_t i=0; i<num_items_; ++i)
+  {
+    item *prev=m_last->prev;
+    m_last->data.~T();
+    m_allocator->free(m_last);
+    m_last=prev;
+  }
+  m_size-=num_items_;
+  if(!m_size)
+    m_first=0;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+void list<T>::erase(iterator_impl<is_forward> &it_)
+{
+  // remove item from the list and destroy it
+  PFC_ASSERT_PEDANTIC(it_.m_item);
+  detach(it_);
+  it_.m_item->data.~T();
+  item *next=is_forward?it_.m_item->next:it_.m_item->prev;
+  m_allocator->free(it_.m_item);
+  it_.m_item=next;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+void list<T>::cctor(const list &l_)
+{
+  // copy-construct the list
+  item **next=&m_first, *i=0;
+  if((m_size=l_.m_size)!=0)
+  {
+    PFC_EDTOR(*this, &list<T>::clear);
+    item *it=l_.m_first, *prev=0;
+    do
+    {
+      // add new item to the list
+      eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
+      i=p.data;
+      PFC_PNEW(&i->data)T(it->data);
+      p.reset();
+      i->prev=prev;
+      *next=i;
+      prev=i;
+      next=&i->next;
+    } while((it=it->next)!=0);
+    PFC_EDTOR_RESET();
+  }
+  *next=0;
+  m_last=i;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+void list<T>::detach(iterator_impl<is_forward> &it_)
+{
+  // detach item from the list
+  if(!it_.m_item->prev)
+    m_first=it_.m_item->next;
+  else
+    it_.m_item->prev->next=it_.m_item->next;
+  if(!it_.m_item->next)
+    m_last=it_.m_item->prev;
+  else
+    it_.m_item->next->prev=it_.m_item->prev;
+  --m_size;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// list::const_iterator_impl
+//============================================================================
+template<typename T>
+template<bool is_forward>
+list<T>::const_iterator_impl<is_forward>::const_iterator_impl()
+  :m_item(0)
+{
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+list<T>::const_iterator_impl<is_forward>::const_iterator_impl(const iterator_impl<is_forward> &it_)
+  :m_item(it_.m_item)
+{
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+void list<T>::const_iterator_impl<is_forward>::reset()
+{
+  m_item=0;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+template<bool is_forward>
+bool list<T>::const_iterator_impl<is_forward>::operator==(const const_iterator_impl &it_) const
+{
+  return m_item==it_.m_item;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool list<T>::const_iterator_impl<is_forward>::operator==(const iterator_impl<is_forward> &it_) const
+{
+  return m_item==it_.m_item;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool list<T>::const_iterator_impl<is_forward>::operator!=(const const_iterator_impl &it_) const
+{
+  return m_item!=it_.m_item;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool list<T>::const_iterator_impl<is_forward>::operator!=(const iterator_impl<is_forward> &it_) const
+{
+  return m_item!=it_.m_item;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename list<T>::template const_iterator_impl<is_forward> &list<T>::const_iterator_impl<is_forward>::operator++()
+{
+  PFC_ASSERT_PEDANTIC(m_item);
+  m_item=is_forward?m_item->next:m_item->prev;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename list<T>::template const_iterator_impl<is_forward> &list<T>::const_iterator_impl<is_forward>::operator--()
+{
+  PFC_ASSERT_PEDANTIC(m_item);
+  m_item=is_forward?m_item->prev:m_item->next;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+const T &list<T>::const_iterator_impl<is_forward>::operator*() const
+{
+  PFC_ASSERT_PEDANTIC(m_item);
+  return m_item->data;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+const T *list<T>::const_iterator_impl<is_forward>::operator->() const
+{
+  PFC_ASSERT_PEDANTIC(m_item);
+  return &m_item->data;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+template<bool is_forward>
+list<T>::const_iterator_impl<is_forward>::const_iterator_impl(item *i_)
+{
+  m_item=i_;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// list::iterator_impl
+//============================================================================
+template<typename T>
+template<bool is_forward>
+list<T>::iterator_impl<is_forward>::iterator_impl()
+  :m_list(0)
+  ,m_item(0)
+{
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+void list<T>::iterator_impl<is_forward>::reset()
+{
+  m_list=0;
+  m_item=0;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+template<bool is_forward>
+bool list<T>::iterator_impl<is_forward>::operator==(const const_iterator_impl<is_forward> &it_) const
+{
+  return m_item==it_.m_item;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool list<T>::iterator_impl<is_forward>::operator==(const iterator_impl &it_) const
+{
+  return m_item==it_.m_item;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool list<T>::iterator_impl<is_forward>::operator!=(const const_iterator_impl<is_forward> &it_) const
+{
+  return m_item!=it_.m_item;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+bool list<T>::iterator_impl<is_forward>::operator!=(const iterator_impl &it_) const
+{
+  return m_item!=it_.m_item;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename list<T>::template iterator_impl<is_forward> &list<T>::iterator_impl<is_forward>::operator++()
+{
+  PFC_ASSERT_PEDANTIC(m_item);
+  m_item=is_forward?m_item->next:m_item->prev;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+typename list<T>::template iterator_impl<is_forward> &list<T>::iterator_impl<is_forward>::operator--()
+{
+  PFC_ASSERT_PEDANTIC(m_item);
+  m_item=is_forward?m_item->prev:m_item->next;
+  return *this;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+T &list<T>::iterator_impl<is_forward>::operator*() const
+{
+  PFC_ASSERT_PEDANTIC(m_item);
+  return m_item->data;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+T *list<T>::iterator_impl<is_forward>::operator->() const
+{
+  PFC_ASSERT_PEDANTIC(m_item);
+  return &m_item->data;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+template<bool is_forward>
+list<T>::iterator_impl<is_forward>::iterator_impl(list &l_, item *i_)
+  :m_list(&l_)
+  ,m_item(i_)
+{
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+void list<T>::iterator_impl<is_forward>::rotate_sequence_left_impl(iterator_impl &first_, iterator_impl &last_)
+{
+  PFC_ASSERT_PEDANTIC_MSG(first_.m_item && last_.m_item && first_.m_list==last_.m_list,
+                          ("Iterators must be valid and of the same list (first: %p, last: %p)\r\n", first_.m_item?first_.m_list:0, last_.m_item?last_.m_list:0));
+  list<T> *l=first_.m_list;
+  list<T>::item *fi=first_.m_item, *li=last_.m_item;
+  if(fi==li)
+    return;
+  first_.m_item=fi->next;
+  last_.m_item=fi;
+  if(fi->prev)
+    fi->prev->next=fi->next;
+  else
+    l->m_first=fi->next;
+  if(li->next)
+    li->next->prev=fi;
+  else
+    l->m_last=fi;
+  fi->next->prev=fi->prev;
+  fi->prev=li;
+  fi->next=li->next;
+  li->next=fi;
+}
+//----
+
+template<typename T>
+template<bool is_forward>
+void list<T>::iterator_impl<is_forward>::rotate_sequence_right_impl(iterator_impl &first_, iterator_impl &last_)
+{
+  PFC_ASSERT_PEDANTIC_MSG(first_.m_item && last_.m_item && first_.m_list==last_.m_list,
+                          ("Iterators must be valid and of the same list (first: %p, last: %p)\r\n", first_.m_item?first_.m_list:0, last_.m_item?last_.m_list:0));
+  list<T> *l=first_.m_list;
+  list<T>::item *fi=first_.m_item, *li=last_.m_item;
+  if(fi==li)
+    return;
+  first_.m_item=li;
+  last_.m_item=li->prev;
+  if(li->next)
+    li->next->prev=li->prev;
+  else
+    l->m_last=li->prev;
+  if(fi->prev)
+    fi->prev->next=li;
+  else
+    l->m_first=li;
+  li->prev->next=li->next;
+  li->next=fi;
+  li->prev=fi->prev;
+  fi->prev=li;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// set
+//============================================================================
+PFC_INTROSPEC_INL_TDEF2(typename T, class CmpPred, set<T, CmpPred>)
+{
+  PFC_CUSTOM_STREAMING(0);
+  switch(unsigned(PE::pe_type))
+  {
+    case penum_input:
+    {
+      // read data
+      PFC_MEM_TRACK_STACK();
+      clear();
+      uint32_t size;
+      pe_.var(size);
+      for(uint32_t i=0; i<size; ++i)
+      {
+        // search for the leaf node where to add the value
+        node *n=m_root, *parent=0, **parent_childptr=&m_root;
+        while(n)
+        {
+          parent=n;
+          parent_childptr=&n->children[m_cmp_pred.before(n->data, v_)];
+          n=*parent_childptr;
+        }
+
+        // add new node
+        eh_data<node> p(*m_allocator, 1, set_traits<T, CmpPred>::block_alloc_align);
+        n=p.data;
+        PFC_PNEW(&n->data)T;
+        pe_.var(n->data, i?mvarflag_array_tail:0);
+        n->color=1;
+        n->parent=parent;
+        n->children[0]=0;
+        n->children[1]=0;
+        *parent_childptr=n;
+        p.reset();
+        ++m_size;
+        restore_rb_property_after_insert(n);
+      }
+    } break;
+
+    case penum_output:
+    case penum_display:
+    {
+      // write/display data
+      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize set<%s> that contains more than 2^32-1 elements\r\n", typeid(T).name()));
+      uint32_t size=(uint32_t)m_size;
+      pe_.var(size, 0, "size");
+      typename set<T, CmpPred>::iterator it=begin();
+      unsigned var_flags=0;
+      while(is_valid(it))
+      {
+        pe_.var(const_cast<T&>(*it), var_flags);
+        var_flags=mvarflag_array_tail;
+        ++it;
+      }
+    } break;
+  }
+}
+//----------------------------------------------------------------------------
+
+template<typename T, class CmpPred>
+set<T, CmpPred>::set(const CmpPred &cmp_pred_, memory_allocator_base *alloc_)
+  :m_cmp_pred(cmp_pred_)
+  ,m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+{
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(set_traits<T, CmpPred>::block_alloc_size, set_traits<T, CmpPred>::block_alloc_align));
+  m_size=0;
+  m_root=0;
+}
+//----
+
+template<typename T, class CmpPred>
+set<T, CmpPred>::set(const set &s_)
+  :m_cmp_pred(s_.m_cmp_pred)
+  ,m_allocator(&default_memory_allocator::inst())
+{
+  PFC_MEM_TRACK_STACK();
+  cctor(s_);
+}
+//----
+
+template<typename T, class CmpPred>
+set<T, CmpPred>::set(const set &s_, memory_allocator_base *alloc_)
+  :m_cmp_pred(s_.m_cmp_pred)
+  ,m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+{
+  PFC_MEM_TRACK_STACK();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(set_traits<T, CmpPred>::block_alloc_size, set_traits<T, CmpPred>::block_alloc_align));
+  cctor(s_);
+}
+//----
+
+template<typename T, class CmpPred>
+set<T, CmpPred>::~set()
+{
+  clear();
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::operator=(const set &s_)
+{
+  set s(s_);
+  swap(s);
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::set_allocator(memory_allocator_base *alloc_)
+{
+  PFC_ASSERT_MSG(!m_size, ("Unable to change the allocator of a non-empty set\r\n"));
+  m_allocator=alloc_?alloc_:&default_memory_allocator::inst();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(set_traits<T, CmpPred>::block_alloc_size, set_traits<T, CmpPred>::block_alloc_align));
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::clear()
+{
+  // recursively destroy nodes
+  if(m_root)
+  {
+    destroy_subtree(*m_root);
+    m_root=0;
+    m_size=0;
+  }
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::swap(set &s_)
+{
+  // swap content of sets
+  pfc::swap(m_cmp_pred, s_.m_cmp_pred);
+  pfc::swap(m_allocator, s_.m_allocator);
+  pfc::swap(m_size, s_.m_size);
+  pfc::swap(m_root, s_.m_root);
+}
+//----------------------------------------------------------------------------
+
+template<typename T, class CmpPred>
+memory_allocator_base &set<T, CmpPred>::allocator() const
+{
+  return *m_allocator;
+}
+//----
+
+template<typename T, class CmpPred>
+usize_t set<T, CmpPred>::size() const
+{
+  return m_size;
+}
+//----
+
+template<typename T, class CmpPred>
+template<typename K>
+typename set<T, CmpPred>::const_iterator set<T, CmpPred>::find(const K &k_) const
+{
+  // search from value from the set
+  const node *n=m_root;
+  while(n && !m_cmp_pred.equal(n->data, k_))
+    n=n->children[m_cmp_pred.before(n->data, k_)];
+  return const_iterator(n);
+}
+//----
+
+template<typename T, class CmpPred>
+template<typename K>
+typename set<T, CmpPred>::iterator set<T, CmpPred>::find(const K &k_)
+{
+  // search from value from the set
+  node *n=m_root;
+  while(n && !m_cmp_pred.equal(n->data, k_))
+    n=n->children[m_cmp_pred.before(n->data, k_)];
+  return iterator(n);
+}
+//----
+
+template<typename T, class CmpPred>
+template<typename K>
+typename set<T, CmpPred>::const_iterator set<T, CmpPred>::lower_bound(const K &k_) const
+{
+  // return iterator to the closest less-or-equal value in the set
+  const node *n=m_root, *prev=0;
+  while(n)
+    if(m_cmp_pred.before(k_, n->data))
+      n=n->children[0];
+    else
+    {
+      prev=n;
+      if(!m_cmp_pred.before(n->data, k_))
+        break;
+      n=n->children[1];
+    }
+  return const_iterator(prev);
+}
+//----
+
+template<typename T, class CmpPred>
+template<typename K>
+typename set<T, CmpPred>::iterator set<T, CmpPred>::lower_bound(const K &k_)
+{
+  // return iterator to the closest less-or-equal value in the set
+  node *n=m_root, *prev=0;
+  while(n)
+    if(m_cmp_pred.before(k_, n->data))
+      n=n->children[0];
+    else
+    {
+      prev=n;
+      if(!m_cmp_pred.before(n->data, k_))
+        break;
+      n=n->children[1];
+    }
+  return iterator(prev);
+}
+//----
+
+template<typename T, class CmpPred>
+template<typename K>
+typename set<T, CmpPred>::const_iterator set<T, CmpPred>::upper_bound(const K &k_) const
+{
+  // return iterator to the closest greater value in the set
+  const node *n=m_root, *prev=0;
+  while(n)
+    if(!m_cmp_pred.before(k_, n->data))
+      n=n->children[1];
+    else
+    {
+      prev=n;
+      n=n->children[0];
+    }
+  return const_iterator(prev);
+}
+//----
+
+template<typename T, class CmpPred>
+template<typename K>
+typename set<T, CmpPred>::iterator set<T, CmpPred>::upper_bound(const K &k_)
+{
+  // return iterator to the closest greater value in the set
+  node *n=m_root, *prev=0;
+  while(n)
+    if(!m_cmp_pred.before(k_, n->data))
+      n=n->children[1];
+    else
+    {
+      prev=n;
+      n=n->children[0];
+    }
+  return iterator(prev);
+}
+//----
+
+template<typename T, class CmpPred>
+typename set<T, CmpPred>::const_iterator set<T, CmpPred>::begin() const
+{
+  // return iterator to the left-most node
+  const node *n=m_root, *prev=0;
+  while(n)
+  {
+    prev=n;
+    n=n->children[0];
+  }
+  return const_iterator(prev);
+}
+//----
+
+template<typename T, class CmpPred>
+typename set<T, CmpPred>::iterator set<T, CmpPred>::begin()
+{
+  // return iterator to the left-most node
+  node *n=m_root, *prev=0;
+  while(n)
+  {
+    prev=n;
+    n=n->children[0];
+  }
+  return iterator(prev);
+}
+//----
+
+template<typename T, class CmpPred>
+typename set<T, CmpPred>::const_iterator set<T, CmpPred>::end() const
 {
-  // construct the list
-  PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(list_traits<T>::block_alloc_size, list_traits<T>::block_alloc_align));
-  item **next=&m_first, *i=0;
-  if((m_size=size_)!=0)
+  return const_iterator(0);
+}
+//----
+
+template<typename T, class CmpPred>
+typename set<T, CmpPred>::iterator set<T, CmpPred>::end()
+{
+  return iterator(0);
+}
+//----
+
+template<typename T, class CmpPred>
+template<typename K>
+typename set<T, CmpPred>::inserter set<T, CmpPred>::insert(const K &k_, bool replace_)
+{
+  // search for the leaf node where to add the value
+  node *n=m_root, *parent=0, **parent_childptr=&m_root;
+  while(n && !m_cmp_pred.equal(n->data, k_))
   {
-    PFC_EDTOR(*this, &list<T>::clear);
-    item *prev=0;
-    do
+    if(m_cmp_pred.equal(n->data, k_))
     {
-      // add new item to the list
-      eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-      i=p.data;
-      PFC_PNEW(&i->data)T;
-      p.reset();
-      i->prev=prev;
-      *next=i;
-      prev=i;
-      next=&i->next;
-    } while(--size_);
-    PFC_EDTOR_RESET();
+      inserter ins={iterator(n), false};
+      return ins;
+    }
+    parent=n;
+    parent_childptr=&n->children[m_cmp_pred.before(n->data, k_)];
+    n=*parent_childptr;
   }
-  *next=0;
-  m_last=i;
+
+  bool is_new=!n;
+  if(is_new)
+  {
+    // add new node
+    eh_data<node> p(*m_allocator, 1, set_traits<T, CmpPred>::block_alloc_align);
+    n=p.data;
+    PFC_PNEW(&n->data)T(k_);
+    n->color=1;
+    n->parent=parent;
+    n->children[0]=0;
+    n->children[1]=0;
+    *parent_childptr=n;
+    p.reset();
+    ++m_size;
+    restore_rb_property_after_insert(n);
+  }
+  else
+    if(replace_)
+    {
+      // replace existing node data with new one
+      n->data.~T();
+      PFC_PNEW(&n->data)T(k_);
+    }
+  inserter ins={iterator(n), is_new};
+  return ins;
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::erase(iterator &it_)
+{
+  PFC_ASSERT_PEDANTIC(it_.m_node);
+  node *y=it_.m_node;
+  if(y->children[0] && y->children[1])
+  {
+    // search the left-most child from the right sub-tree
+    y=y->children[1];
+    while(node *child=y->children[0])
+      y=child;
+  }
+
+  // remove y from parent chain
+  node *x=y->children[0]?y->children[0]:y->children[1];
+  if(x)
+    x->parent=y->parent;
+  bool is_left_parent=false;
+  if(y->parent)
+  {
+    is_left_parent=y==y->parent->children[0];
+    y->parent->children[!is_left_parent]=x;
+  }
+  else
+    m_root=x;
+
+  // restore RB-property if removing black node
+  if(!y->color)
+    restore_rb_property_after_remove(x, y->parent, is_left_parent);
+  if(y!=it_.m_node)
+  {
+    // replace m_node with y
+    if((y->parent=it_.m_node->parent)!=0)
+      y->parent->children[it_.m_node==y->parent->children[1]]=y;
+    else
+      m_root=y;
+    y->color=it_.m_node->color;
+    if((y->children[0]=it_.m_node->children[0])!=0)
+      y->children[0]->parent=y;
+    if((y->children[1]=it_.m_node->children[1])!=0)
+      y->children[1]->parent=y;
+  }
+
+  // delete node
+  it_.m_node->data.~T();
+  m_allocator->free(it_.m_node);
+  it_.m_node=0;
+  --m_size;
+}
+//----------------------------------------------------------------------------
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::cctor(const set &s_)
+{
+  // copy-construct the set
+  m_size=s_.m_size;
+  m_root=0;
+  if(s_.m_root)
+    copy_subtree(*s_.m_root, 0, m_root);
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::copy_subtree(node &n_, node *parent_, node *&child_ptr_)
+{
+  // recursively copy the sub-tree
+  eh_data<node> p(*m_allocator, 1, set_traits<T, CmpPred>::block_alloc_align);
+  node *n=p.data;
+  PFC_PNEW(&n->data)T(n_.data);
+  n->color=n_.color;
+  n->parent=parent_;
+  n->children[0]=0;
+  n->children[1]=0;
+  p.reset();
+  child_ptr_=n;
+  if(n_.children[0])
+    copy_subtree(*n_.children[0], n, n->children[0]);
+  if(n_.children[1])
+    copy_subtree(*n_.children[1], n, n->children[1]);
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::destroy_subtree(node &n_)
+{
+  // destroy children
+  if(n_.children[0])
+    destroy_subtree(*n_.children[0]);
+  if(n_.children[1])
+    destroy_subtree(*n_.children[1]);
+  n_.data.~T();
+  m_allocator->free(&n_);
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::rotate_subtree(node &n_, bool rotate_right_)
+{
+  // rotate sub-tree left/right about the node
+  unsigned idx0=rotate_right_, idx1=!rotate_right_;
+  node *y=n_.children[idx1];
+  if((n_.children[idx1]=y->children[idx0])!=0)
+    y->children[idx0]->parent=&n_;
+  node *parent=n_.parent;
+  if((y->parent=parent)!=0)
+    parent->children[&n_==parent->children[idx0]?idx0:idx1]=y;
+  else
+    m_root=y;
+  y->children[idx0]=&n_;
+  n_.parent=y;
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::restore_rb_property_after_insert(node *n_)
+{
+  // restore RB-tree property after node insertion
+  while(n_!=m_root && n_->parent->color)
+  {
+    node *grandparent=n_->parent->parent;
+    bool is_left_parent=n_->parent==grandparent->children[0];
+    node *y=grandparent->children[is_left_parent];
+    if(y && y->color)
+    {
+      // change colors
+      n_->parent->color=0;
+      y->color=0;
+      grandparent->color=1;
+      n_=grandparent;
+    }
+    else
+    {
+      if(n_==n_->parent->children[is_left_parent])
+      {
+        // move node up and rotate
+        n_=n_->parent;
+        rotate_subtree(*n_, !is_left_parent);
+        grandparent=n_->parent->parent;
+      }
+      n_->parent->color=0;
+      grandparent->color=1;
+      rotate_subtree(*grandparent, is_left_parent);
+    }
+  }
+  m_root->color=0;
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::validate_rb_state(node *n_, unsigned depth_, unsigned &max_depth_) const
+{
+  if(!n_)
+    return;
+  max_depth_=max(depth_, max_depth_);
+  if(n_->color)
+  {
+    PFC_ASSERT(   (!n_->children[0] || !n_->children[0]->color)
+               && (!n_->children[1] || !n_->children[1]->color));
+  }
+  validate_rb_state(n_->children[0], depth_+1, max_depth_);
+  validate_rb_state(n_->children[1], depth_+1, max_depth_);
+}
+//----
+
+template<typename T, class CmpPred>
+void set<T, CmpPred>::validate_rb_state() const
+{
+  unsigned max_depth=0;
+  validate_rb_state(m_root, 1, max_depth);
+  PFC_ASSERT(max_depth<=2.0f*std::log(m_size+1)*1.44269504089f);
 }
 //----
 
-template<typename T>
-list<T>::list(usize_t size_, const T &v_, memory_allocator_base *alloc_)
-  :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+template<typename T, class CmpPred>
+void set<T, CmpPred>::restore_rb_property_after_remove(node *n_, node *parent_, bool is_left_child_)
 {
-  // construct the list
-  PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(list_traits<T>::block_alloc_size, list_traits<T>::block_alloc_align));
-  item **next=&m_first, *i=0;
-  if((m_size=size_)!=0)
+  // restore RB-tree property after node removal
+  while(n_!=m_root && (!n_ || !n_->color))
   {
-    PFC_EDTOR(*this, &list<T>::clear);
-    item *prev=0;
-    do
+    node *w=parent_->children[is_left_child_];
+    if(w->color)
     {
-      // add new item to the list
-      eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-      i=p.data;
-      PFC_PNEW(&i->data)T(v_);
-      p.reset();
-      i->prev=prev;
-      *next=i;
-      prev=i;
-      next=&i->next;
-    } while(--size_);
-    PFC_EDTOR_RESET();
+      w->color=0;
+      parent_->color=1;
+      rotate_subtree(*parent_, !is_left_child_);
+      w=parent_->children[is_left_child_];
+    }
+    bool is_child0_black=!w->children[is_left_child_] || !w->children[is_left_child_]->color;
+    if(is_child0_black && (!w->children[!is_left_child_] || !w->children[!is_left_child_]->color))
+    {
+      w->color=1;
+      n_=parent_;
+      parent_=n_->parent;
+      if(parent_)
+        is_left_child_=n_==parent_->children[0];
+    }
+    else
+    {
+      if(is_child0_black)
+      {
+        w->children[!is_left_child_]->color=0;
+        w->color=1;
+        rotate_subtree(*w, is_left_child_);
+        w=parent_->children[is_left_child_];
+      }
+      w->color=parent_->color;
+      parent_->color=0;
+      w->children[is_left_child_]->color=0;
+      rotate_subtree(*parent_, !is_left_child_);
+      n_=m_root;
+    }
   }
-  *next=0;
-  m_last=i;
+  if(n_)
+    n_->color=0;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// set::const_iterator
+//============================================================================
+template<typename T, class CmpPred>
+set<T, CmpPred>::const_iterator::const_iterator()
+  :m_node(0)
+{
 }
 //----
 
-template<typename T>
-list<T>::~list()
+template<typename T, class CmpPred>
+set<T, CmpPred>::const_iterator::const_iterator(const iterator &it_)
+  :m_node(it_.m_node)
 {
-  clear();
 }
 //----
 
-template<typename T>
-void list<T>::set_allocator(memory_allocator_base *alloc_)
+template<typename T, class CmpPred>
+void set<T, CmpPred>::const_iterator::reset()
 {
-  PFC_ASSERT_MSG(!m_size, ("Unable to change the allocator for a non-empty list\r\n"));
-  m_allocator=alloc_?alloc_:&default_memory_allocator::inst();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(list_traits<T>::block_alloc_size, list_traits<T>::block_alloc_align));
+  m_node=0;
+}
+//----------------------------------------------------------------------------
+
+template<typename T, class CmpPred>
+bool set<T, CmpPred>::const_iterator::operator==(const const_iterator &it_) const
+{
+  return m_node==it_.m_node;
 }
 //----
 
-template<typename T>
-void list<T>::operator=(const list &l_)
+template<typename T, class CmpPred>
+bool set<T, CmpPred>::const_iterator::operator==(const iterator &it_) const
 {
-  list<T> l(l_);
-  swap(l);
+  return m_node==it_.m_node;
 }
 //----
 
-template<typename T>
-void list<T>::clear()
+template<typename T, class CmpPred>
+bool set<T, CmpPred>::const_iterator::operator!=(const const_iterator &it_) const
 {
-  // clear the list
-  item *i=m_last;
-  if(i)
-  {
-    do
-    {
-      i->data.~T();
-      item *prev=i->prev;
-      m_allocator->free(i);
-      i=prev;
-    } while(i);
-    m_first=m_last=0;
-    m_size=0;
-  }
+  return m_node!=it_.m_node;
 }
 //----
 
-template<typename T>
-void list<T>::resize(usize_t size_)
+template<typename T, class CmpPred>
+bool set<T, CmpPred>::const_iterator::operator!=(const iterator &it_) const
 {
-  if(size_<m_size)
-  {
-    // release elements from the end of the list to match given size
-    usize_t count=m_size-size_;
-    item *it=m_last;
-    do
-    {
-      it->data.~T();
-      item *prev=it->prev;
-      m_allocator->free(it);
-      it=prev;
-    } while(--count);
-    m_size=size_;
-    m_last=it;
-    if(it)
-      m_last->next=0;
-    else
-      m_first=0;
-  }
-  else
-  {
-    // add elements to the end of the list to match given size
-    PFC_MEM_TRACK_STACK();
-    usize_t count=size_-m_size;
-    if(count)
-    {
-      item *prev=m_last, **next=m_last?&m_last->next:&m_first, *i;
-      do
-      {
-        // add new item to the list
-        eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-        i=p.data;
-        PFC_PNEW(&i->data)T;
-        p.reset();
-        i->prev=prev;
-        *next=i;
-        prev=i;
-        next=&i->next;
-      } while(--count);
-      m_size=size_;
-      *next=0;
-      m_last=i;
-    }
-  }
+  return m_node!=it_.m_node;
 }
 //----
 
-template<typename T>
-void list<T>::resize(usize_t size_, const T &v_)
+template<typename T, class CmpPred>
+typename set<T, CmpPred>::const_iterator &set<T, CmpPred>::const_iterator::operator++()
 {
-  if(size_<m_size)
+  PFC_ASSERT_PEDANTIC(m_node);
+  const node *n=m_node->children[1];
+  if(n)
   {
-    // release elements from the end of the list to match given size
-    usize_t count=m_size-size_;
-    item *it=m_last;
+    // find left-most node under right child
     do
     {
-      it->data.~T();
-      item *prev=it->prev;
-      m_allocator->free(it);
-      it=prev;
-    } while(--count);
-    m_size=size_;
-    m_last=it;
-    if(it)
-      m_last->next=0;
-    else
-      m_first=0;
+      m_node=n;
+      n=n->children[0];
+    } while(n);
   }
   else
   {
-    // add elements to the end of the list to match given size
-    PFC_MEM_TRACK_STACK();
-    usize_t count=size_-m_size;
-    if(count)
-    {
-      item *prev=m_last, **next=m_last?&m_last->next:&m_first, *i;
-      do
-      {
-        // add new item to the list
-        eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-        i=p.data;
-        PFC_PNEW(&i->data)T(v_);
-        p.reset();
-        i->prev=prev;
-        *next=i;
-        prev=i;
-        next=&i->next;
-      } while(--count);
-      m_size=size_;
-      *next=0;
-      m_last=i;
-    }
+    // traverse right sub-tree up
+    while(m_node->parent && m_node->parent->children[1]==m_node)
+      m_node=m_node->parent;
+    m_node=m_node->parent;
   }
+  return *this;
 }
 //----
 
-template<typename T>
-void list<T>::swap(list &l_)
-{
-  // swap content of the lists
-  pfc::swap(m_allocator, l_.m_allocator);
-  pfc::swap(m_size, l_.m_size);
-  pfc::swap(m_first, l_.m_first);
-  pfc::swap(m_last, l_.m_last);
-}
-//----------------------------------------------------------------------------
-
-template<typename T>
-memory_allocator_base &list<T>::allocator() const
-{
-  return *m_allocator;
-}
-//----
-
-template<typename T>
-usize_t list<T>::size() const
-{
-  return m_size;
-}
-//----
-
-template<typename T>
-const T &list<T>::front() const
+template<typename T, class CmpPred>
+const T &set<T, CmpPred>::const_iterator::operator*() const
 {
-  PFC_ASSERT_PEDANTIC(m_size);
-  return m_first->data;
+  PFC_ASSERT_PEDANTIC(m_node);
+  return m_node->data;
 }
 //----
 
-template<typename T>
-T &list<T>::front()
+template<typename T, class CmpPred>
+const T *set<T, CmpPred>::const_iterator::operator->() const
 {
-  PFC_ASSERT_PEDANTIC(m_size);
-  return m_first->data;
+  PFC_ASSERT_PEDANTIC(m_node);
+  return &m_node->data;
 }
-//----
+//----------------------------------------------------------------------------
 
-template<typename T>
-const T &list<T>::back() const
+template<typename T, class CmpPred>
+set<T, CmpPred>::const_iterator::const_iterator(const node *n_)
+  :m_node(n_)
 {
-  PFC_ASSERT_PEDANTIC(m_size);
-  return m_last->data;
 }
-//----
+//----------------------------------------------------------------------------
 
-template<typename T>
-T &list<T>::back()
+
+//============================================================================
+// set::iterator
+//============================================================================
+template<typename T, class CmpPred>
+set<T, CmpPred>::iterator::iterator()
+  :m_node(0)
 {
-  PFC_ASSERT_PEDANTIC(m_size);
-  return m_last->data;
 }
 //----
 
-template<typename T>
-typename list<T>::const_iterator list<T>::begin() const
+template<typename T, class CmpPred>
+void set<T, CmpPred>::iterator::reset()
 {
-  return m_first;
+  m_node=0;
 }
-//----
+//----------------------------------------------------------------------------
 
-template<typename T>
-typename list<T>::iterator list<T>::begin()
+template<typename T, class CmpPred>
+bool set<T, CmpPred>::iterator::operator==(const const_iterator &it_) const
 {
-  return iterator(*this, m_first);
+  return m_node==it_.m_node;
 }
 //----
 
-template<typename T>
-typename list<T>::const_reverse_iterator list<T>::rbegin() const
+template<typename T, class CmpPred>
+bool set<T, CmpPred>::iterator::operator==(const iterator &it_) const
 {
-  return m_last;
+  return m_node==it_.m_node;
 }
 //----
 
-template<typename T>
-typename list<T>::reverse_iterator list<T>::rbegin()
+template<typename T, class CmpPred>
+bool set<T, CmpPred>::iterator::operator!=(const const_iterator &it_) const
 {
-  return reverse_iterator(*this, m_last);
+  return m_node!=it_.m_node;
 }
 //----
 
-template<typename T>
-typename list<T>::const_iterator list<T>::last() const
+template<typename T, class CmpPred>
+bool set<T, CmpPred>::iterator::operator!=(const iterator &it_) const
 {
-  return const_iterator(m_last);
+  return m_node!=it_.m_node;
 }
 //----
 
-template<typename T>
-typename list<T>::iterator list<T>::last()
+template<typename T, class CmpPred>
+typename set<T, CmpPred>::iterator &set<T, CmpPred>::iterator::operator++()
 {
-  return iterator(*this, m_last);
+  PFC_ASSERT_PEDANTIC(m_node);
+  node *n=m_node->children[1];
+  if(n)
+  {
+    // find left-most node under right child
+    do
+    {
+      m_node=n;
+      n=n->children[0];
+    } while(n);
+  }
+  else
+  {
+    // traverse right sub-tree up
+    while(m_node->parent && m_node->parent->children[1]==m_node)
+      m_node=m_node->parent;
+    m_node=m_node->parent;
+  }
+  return *this;
 }
 //----
 
-template<typename T>
-typename list<T>::const_reverse_iterator list<T>::rlast() const
+template<typename T, class CmpPred>
+const T &set<T, CmpPred>::iterator::operator*() const
 {
-  return const_reverse_iterator(m_first);
+  PFC_ASSERT_PEDANTIC(m_node);
+  return m_node->data;
 }
 //----
 
-template<typename T>
-typename list<T>::reverse_iterator list<T>::rlast()
+template<typename T, class CmpPred>
+const T *set<T, CmpPred>::iterator::operator->() const
 {
-  return reverse_iterator(*this, m_first);
+  PFC_ASSERT_PEDANTIC(m_node);
+  return &m_node->data;
 }
-//----
+//----------------------------------------------------------------------------
 
-template<typename T>
-typename list<T>::const_iterator list<T>::end() const
+template<typename T, class CmpPred>
+set<T, CmpPred>::iterator::iterator(node *n_)
+  :m_node(n_)
 {
-  return const_iterator();
 }
-//----
+//----------------------------------------------------------------------------
 
-template<typename T>
-typename list<T>::iterator list<T>::end()
+
+//============================================================================
+// map
+//============================================================================
+PFC_INTROSPEC_INL_TDEF3(typename K, typename T, class CmpPred, map<K, T, CmpPred>)
 {
-  return iterator();
+  PFC_CUSTOM_STREAMING(0);
+  switch(unsigned(PE::pe_type))
+  {
+    case penum_input:
+    {
+      // read data
+      PFC_MEM_TRACK_STACK();
+      clear();
+      uint32_t size;
+      pe_.var(size);
+      for(uint32_t i=0; i<size; ++i)
+      {
+        // create new node
+        eh_data<node> p(*m_allocator, 1, map_traits<K, T, CmpPred>::block_alloc_align);
+        node *nn=p.data;
+        PFC_PNEW(&nn->key)K;
+        PFC_PNEW(&nn->val)T;
+        pe_.var(*nn, i?mvarflag_array_tail:0);
+
+        // search for the leaf node where to add the data
+        node *n=m_root, *parent=0, **parent_childptr=&m_root;
+        while(n && !m_cmp_pred.equal(n->key, nn->key))
+        {
+          parent=n;
+          parent_childptr=&n->children[m_cmp_pred.before(n->key, nn->key)];
+          n=*parent_childptr;
+        }
+
+        // add new node
+        nn->color=1;
+        nn->parent=parent;
+        nn->children[0]=0;
+        nn->children[1]=0;
+        *parent_childptr=nn;
+        p.reset();
+        ++m_size;
+        restore_rb_property_after_insert(n);
+      }
+    } break;
+
+    case penum_output:
+    case penum_display:
+    {
+      // write/display data
+      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize map<%s, %s> that contains more than 2^32-1 elements\r\n", typeid(K).name(), typeid(T).name()));
+      uint32_t size=(uint32_t)m_size;
+      pe_.var(size, 0, "size");
+      typename map<K, T, CmpPred>::iterator it=begin();
+      unsigned var_flags=0;
+      while(is_valid(it))
+      {
+        pe_.var(*it.m_node, var_flags);
+        var_flags=mvarflag_array_tail;
+        ++it;
+      }
+    } break;
+  }
 }
-//----
+//----------------------------------------------------------------------------
 
-template<typename T>
-typename list<T>::const_reverse_iterator list<T>::rend() const
+template<typename K, typename T, class CmpPred>
+map<K, T, CmpPred>::map(const CmpPred &cmp_pred_, memory_allocator_base *alloc_)
+  :m_cmp_pred(cmp_pred_)
+  ,m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
 {
-  return const_reverse_iterator();
+  // init empty map
+  PFC_ASSERT_CALL(m_allocator->check_allocator(map_traits<K, T, CmpPred>::block_alloc_size, map_traits<K, T, CmpPred>::block_alloc_align));
+  m_size=0;
+  m_root=0;
 }
 //----
 
-template<typename T>
-typename list<T>::reverse_iterator list<T>::rend()
+template<typename K, typename T, class CmpPred>
+map<K, T, CmpPred>::map(const map &m_)
+  :m_cmp_pred(m_.m_cmp_pred)
+  ,m_allocator(&default_memory_allocator::inst())
 {
-  return reverse_iterator();
+  PFC_MEM_TRACK_STACK();
+  cctor(m_);
 }
 //----
 
-template<typename T>
-void list<T>::push_front(const T &v_)
+template<typename K, typename T, class CmpPred>
+map<K, T, CmpPred>::map(const map &m_, memory_allocator_base *alloc_)
+  :m_cmp_pred(m_.m_cmp_pred)
+  ,m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
 {
-  // push an element to the beginning of the list
   PFC_MEM_TRACK_STACK();
-  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-  item *i=p.data;
-  PFC_PNEW(&p.data->data)T(v_);
-  p.reset();
-  i->prev=0;
-  i->next=m_first;
-  if(!m_last)
-    m_last=i;
-  else
-    m_first->prev=i;
-  m_first=i;
-  ++m_size;
+  PFC_ASSERT_CALL(m_allocator->check_allocator(map_traits<K, T, CmpPred>::block_alloc_size, map_traits<K, T, CmpPred>::block_alloc_align));
+  cctor(m_);
 }
 //----
 
-template<typename T>
-T &list<T>::push_front()
+template<typename K, typename T, class CmpPred>
+map<K, T, CmpPred>::~map()
 {
-  // push default value to the beginning of the list
-  PFC_MEM_TRACK_STACK();
-  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-  item *i=p.data;
-  PFC_PNEW(&p.data->data)T;
-  p.reset();
-  i->prev=0;
-  i->next=m_first;
-  if(!m_last)
-    m_last=i;
-  else
-    m_first->prev=i;
-  m_first=i;
-  ++m_size;
-  return m_first->data;
+  clear();
 }
 //----
 
-template<typename T>
-void list<T>::push_back(const T &v_)
-{
-  // push an element to the end of the list
-  PFC_MEM_TRACK_STACK();
-  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-  item *i=p.data;
-  PFC_PNEW(&i->data)T(v_);
-  p.reset();
-  i->prev=m_last;
-  i->next=0;
-  if(!m_first)
-    m_first=i;
-  else
-    m_last->next=i;
-  m_last=i;
-  ++m_size;
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::operator=(const map &m_)
+{
+  map m(m_);
+  swap(m);
 }
 //----
 
-template<typename T>
-T &list<T>::push_back()
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::set_allocator(memory_allocator_base *alloc_)
 {
-  // push an element to the end of the list
-  PFC_MEM_TRACK_STACK();
-  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-  item *i=p.data;
-  PFC_PNEW(&i->data)T;
-  p.reset();
-  i->prev=m_last;
-  i->next=0;
-  if(!m_first)
-    m_first=i;
-  else
-    m_last->next=i;
-  m_last=i;
-  ++m_size;
-  return m_last->data;
+  PFC_ASSERT_MSG(!m_size, ("Unable to change the allocator of a non-empty map\r\n"));
+  m_allocator=alloc_?alloc_:&default_memory_allocator::inst();
+  PFC_ASSERT_CALL(m_allocator->check_allocator(map_traits<K, T, CmpPred>::block_alloc_size, map_traits<K, T, CmpPred>::block_alloc_align));
 }
 //----
 
-template<typename T>
-void list<T>::insert_front(usize_t num_items_)
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::clear()
 {
-  PFC_MEM_TRACK_STACK();
-  while(num_items_--)
-    push_front();
+  // recursively destroy nodes
+  if(m_root)
+  {
+    destroy_subtree(*m_root);
+    m_root=0;
+    m_size=0;
+  }
 }
 //----
 
-template<typename T>
-void list<T>::insert_front(usize_t num_items_, const T &v_)
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::swap(map &m_)
 {
-  PFC_MEM_TRACK_STACK();
-  while(num_items_--)
-    push_front(v_);
+  // swap content of maps
+  pfc::swap(m_cmp_pred, m_.m_cmp_pred);
+  pfc::swap(m_allocator, m_.m_allocator);
+  pfc::swap(m_size, m_.m_size);
+  pfc::swap(m_root, m_.m_root);
+}
+//----------------------------------------------------------------------------
+
+template<typename K, typename T, class CmpPred>
+memory_allocator_base &map<K, T, CmpPred>::allocator() const
+{
+  return *m_allocator;
 }
 //----
 
-template<typename T>
-void list<T>::insert_front(usize_t num_items_, const T *v_)
+template<typename K, typename T, class CmpPred>
+usize_t map<K, T, CmpPred>::size() const
 {
-  PFC_MEM_TRACK_STACK();
-  while(num_items_--)
-    push_front(*v_++);
+  return m_size;
 }
 //----
 
-template<typename T>
-void list<T>::insert_front(const list<T> &l_)
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+const T &map<K, T, CmpPred>::operator[](const K1 &k_) const
 {
-  list<T> l(l_);
-  splice_front(l);
+  // search key from the map and return the associated value
+  const node *n=m_root;
+  while(n && !m_cmp_pred.equal(n->key, k_))
+    n=n->children[m_cmp_pred.before(n->key, k_)];
+  PFC_ASSERT_MSG(n, ("Key not found from the map\r\n"));
+  return n->val;
 }
 //----
 
-template<typename T>
-void list<T>::insert_back(usize_t num_items_)
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+T &map<K, T, CmpPred>::operator[](const K1 &k_)
 {
-  PFC_MEM_TRACK_STACK();
-  resize(m_size+num_items_);
+  // search key from the map and return the associated value
+  node *n=m_root;
+  while(n && !m_cmp_pred.equal(n->key, k_))
+    n=n->children[m_cmp_pred.before(n->key, k_)];
+  PFC_ASSERT_MSG(n, ("Key not found from the map\r\n"));
+  return n->val;
 }
 //----
 
-template<typename T>
-void list<T>::insert_back(usize_t num_items_, const T &v_)
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+typename map<K, T, CmpPred>::const_iterator map<K, T, CmpPred>::find(const K1 &k_) const
 {
-  PFC_MEM_TRACK_STACK();
-  resize(m_size+num_items_, v_);
+  // search key from the map and return iteration that points to it
+  const node *n=m_root;
+  while(n && !m_cmp_pred.equal(n->key, k_))
+    n=n->children[m_cmp_pred.before(n->key, k_)];
+  return const_iterator(n);
 }
 //----
 
-template<typename T>
-void list<T>::insert_back(usize_t num_items_, const T *v_)
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+typename map<K, T, CmpPred>::iterator map<K, T, CmpPred>::find(const K1 &k_)
 {
-  PFC_MEM_TRACK_STACK();
-  for(usize_t i=0; i<num_items_; ++i)
-    push_back(*v_++);
+  // search key from the map and return iteration that points to it
+  node *n=m_root;
+  while(n && !m_cmp_pred.equal(n->key, k_))
+    n=n->children[m_cmp_pred.before(n->key, k_)];
+  return iterator(n);
 }
 //----
 
-template<typename T>
-void list<T>::insert_back(const list<T> &l_)
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+typename map<K, T, CmpPred>::const_iterator map<K, T, CmpPred>::lower_bound(const K1 &k_) const
 {
-  list<T> l(l_);
-  splice_back(l);
+  // return iterator to the closest less-or-equal value in the set
+  const node *n=m_root, *prev=0;
+  while(n)
+    if(m_cmp_pred.before(k_, n->key))
+      n=n->children[0];
+    else
+    {
+      prev=n;
+      if(!m_cmp_pred.before(n->key, k_))
+        break;
+      n=n->children[1];
+    }
+  return const_iterator(prev);
 }
 //----
 
-template<typename T>
-void list<T>::insert_before(iterator &it_, const T &v_)
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+typename map<K, T, CmpPred>::iterator map<K, T, CmpPred>::lower_bound(const K1 &k_)
 {
-  // insert given item before the iterator
-  PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_PEDANTIC(it_.m_item);
-  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-  item *i=p.data;
-  PFC_PNEW(&i->data)T(v_);
-  p.reset();
-  if(it_.m_item->prev)
-  {
-    it_.m_item->prev->next=i;
-    i->prev=it_.m_item->prev;
-  }
-  else
-    m_first=i;
-  it_.m_item->prev=i;
-  i->next=it_.m_item;
-  ++m_size;
+  // return iterator to the closest less-or-equal value in the set
+  node *n=m_root, *prev=0;
+  while(n)
+    if(m_cmp_pred.before(k_, n->key))
+      n=n->children[0];
+    else
+    {
+      prev=n;
+      if(!m_cmp_pred.before(n->key, k_))
+        break;
+      n=n->children[1];
+    }
+  return iterator(prev);
 }
 //----
 
-template<typename T>
-T &list<T>::insert_before(iterator &it_)
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+typename map<K, T, CmpPred>::const_iterator map<K, T, CmpPred>::upper_bound(const K1 &k_) const
 {
-  // insert default-constructed item before the iterator
-  PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_PEDANTIC(it_.m_item);
-  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-  item *i=p.data;
-  PFC_PNEW(&i->data)T;
-  p.reset();
-  if(it_.m_item->prev)
-  {
-    it_.m_item->prev->next=i;
-    i->prev=it_.m_item->prev;
-  }
-  else
-  {
-    m_first=i;
-    i->prev=0;
-  }
-  it_.m_item->prev=i;
-  i->next=it_.m_item;
-  ++m_size;
-  return i->data;
+  // return iterator to the closest greater value in the set
+  const node *n=m_root, *prev=0;
+  while(n)
+    if(!m_cmp_pred.before(k_, n->key))
+      n=n->children[1];
+    else
+    {
+      prev=n;
+      n=n->children[0];
+    }
+  return const_iterator(prev);
 }
 //----
 
-template<typename T>
-void list<T>::insert_after(iterator &it_, const T &v_)
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+typename map<K, T, CmpPred>::iterator map<K, T, CmpPred>::upper_bound(const K1 &k_)
 {
-  // insert given item after the iterator
-  PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_PEDANTIC(it_.m_item);
-  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-  item *i=p.data;
-  PFC_PNEW(&i->data)T(v_);
-  p.reset();
-  if(it_.m_item->next)
-  {
-    it_.m_item->next->prev=i;
-    i->next=it_.m_item->next;
-  }
-  else
+  // return iterator to the closest greater value in the set
+  node *n=m_root, *prev=0;
+  while(n)
+    if(!m_cmp_pred.before(k_, n->key))
+      n=n->children[1];
+    else
+    {
+      prev=n;
+      n=n->children[0];
+    }
+  return iterator(prev);
+}
+//----
+
+template<typename K, typename T, class CmpPred>
+typename map<K, T, CmpPred>::const_iterator map<K, T, CmpPred>::begin() const
+{
+  // return iterator to the left-most node
+  const node *n=m_root, *prev=0;
+  while(n)
   {
-    m_last=i;
-    i->next=0;
-  }
-  it_.m_item->next=i;
-  i->prev=it_.m_item;
-  ++m_size;
+    prev=n;
+    n=n->children[0];
+  }
+  return const_iterator(prev);
 }
 //----
 
-template<typename T>
-T &list<T>::insert_after(iterator &it_)
+template<typename K, typename T, class CmpPred>
+typename map<K, T, CmpPred>::iterator map<K, T, CmpPred>::begin()
 {
-  // insert default-constructed item after the iterator
-  PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_PEDANTIC(it_.m_item);
-  eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-  item *i=p.data;
-  PFC_PNEW(&i->data)T;
-  p.reset();
-  if(it_.m_item->next)
+  // return iterator to the left-most node
+  node *n=m_root, *prev=0;
+  while(n)
   {
-    it_.m_item->next->prev=i;
-    i->next=it_.m_item->next;
+    prev=n;
+    n=n->children[0];
   }
-  else
-    m_last=i;
-  it_.m_item->next=i;
-  i->prev=it_.m_item;
-  ++m_size;
-  return i->data;
+  return iterator(prev);
 }
 //----
 
-template<typename T>
-void list<T>::splice_front(list &l_)
+template<typename K, typename T, class CmpPred>
+typename map<K, T, CmpPred>::const_iterator map<K, T, CmpPred>::end() const
 {
-  // push a list to the beginning of the list
-  PFC_ASSERT(m_allocator==l_.m_allocator);
-  m_size+=l_.m_size;
-  if(!m_first)
-  {
-    m_first=l_.m_first;
-    m_last=l_.m_last;
-  }
-  else
-  {
-    m_first->prev=l_.m_last;
-    if(l_.m_last)
-    {
-      l_.m_last->next=m_first;
-      m_first=l_.m_first;
-    }
-  }
+  return const_iterator(0);
+}
+//----
 
-  // clear the source list
-  l_.m_size=0;
-  l_.m_first=0;
-  l_.m_last=0;
+template<typename K, typename T, class CmpPred>
+typename map<K, T, CmpPred>::iterator map<K, T, CmpPred>::end()
+{
+  return iterator(0);
 }
 //----
 
-template<typename T>
-void list<T>::splice_front(iterator &it_)
+template<typename K, typename T, class CmpPred>
+typename map<K, T, CmpPred>::inserter map<K, T, CmpPred>::insert(const K &k_, const T &v_, bool replace_)
 {
-  if(it_.m_item)
+  // search for the leaf node where to add the data
+  node *n=m_root, *parent=0, **parent_childptr=&m_root;
+  while(n && !m_cmp_pred.equal(n->key, k_))
   {
-    // remove item from its list and add to the beginning of this list
-    PFC_ASSERT(m_allocator==it_.m_list->m_allocator);
-    it_.m_list->detach(it_);
-    it_.m_item->next=m_first;
-    it_.m_item->prev=0;
-    if(m_first)
-      m_first->prev=it_.m_item;
-    else
-      m_last=it_.m_item;
-    m_first=it_.m_item;
+    parent=n;
+    parent_childptr=&n->children[m_cmp_pred.before(n->key, k_)];
+    n=*parent_childptr;
+  }
+
+  bool is_new=!n;
+  if(is_new)
+  {
+    // add new node
+    eh_data<node> p(*m_allocator, 1, map_traits<K, T, CmpPred>::block_alloc_align);
+    n=p.data;
+    PFC_PNEW(&n->key)K(k_);
+    PFC_PNEW(&n->val)T(v_);
+    n->color=1;
+    n->parent=parent;
+    n->children[0]=0;
+    n->children[1]=0;
+    *parent_childptr=n;
+    p.reset();
     ++m_size;
+    restore_rb_property_after_insert(n);
   }
+  else
+    if(replace_)
+    {
+      // replace existing node data with new one
+      n->val.~T();
+      PFC_PNEW(&n->val)T(v_);
+    }
+  inserter ins={iterator(n), is_new};
+  return ins;
 }
 //----
 
-template<typename T>
-void list<T>::splice_back(list &l_)
+template<typename K, typename T, class CmpPred>
+typename map<K, T, CmpPred>::inserter map<K, T, CmpPred>::insert(const K &k_, bool replace_)
 {
-  // push a list to the end of the list
-  PFC_ASSERT(m_allocator==l_.m_allocator);
-  m_size+=l_.m_size;
-  if(!m_first)
+  // search for the leaf node where to add the data
+  node *n=m_root, *parent=0, **parent_childptr=&m_root;
+  while(n && !m_cmp_pred.equal(n->key, k_))
   {
-    m_first=l_.m_first;
-    m_last=l_.m_last;
+    parent=n;
+    parent_childptr=&n->children[m_cmp_pred.before(n->key, k_)];
+    n=*parent_childptr;
   }
-  else
+
+  bool is_new=!n;
+  if(is_new)
   {
-    m_last->next=l_.m_first;
-    if(l_.m_first)
+    // add new node
+    eh_data<node> p(*m_allocator, 1, map_traits<K, T, CmpPred>::block_alloc_align);
+    n=p.data;
+    PFC_PNEW(&n->key)K(k_);
+    PFC_PNEW(&n->val)T;
+    n->color=1;
+    n->parent=parent;
+    n->children[0]=0;
+    n->children[1]=0;
+    *parent_childptr=n;
+    p.reset();
+    ++m_size;
+    restore_rb_property_after_insert(n);
+  }
+  else
+    if(replace_)
     {
-      l_.m_first->prev=m_last;
-      m_last=l_.m_last;
+      // replace existing node value with new one
+      n->val.~T();
+      PFC_PNEW(&n->val)T;
     }
-  }
-
-  // clear the source list
-  l_.m_size=0;
-  l_.m_first=0;
-  l_.m_last=0;
+  inserter ins={iterator(n), is_new};
+  return ins;
 }
 //----
 
-template<typename T>
-void list<T>::splice_back(iterator &it_)
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::erase(iterator &it_)
 {
-  if(it_.m_item)
+  PFC_ASSERT_PEDANTIC(it_.m_node);
+  node *y=it_.m_node;
+  if(y->children[0] && y->children[1])
   {
-    // remove item from its list and add to the end of this list
-    PFC_ASSERT(m_allocator==it_.m_list->m_allocator);
-    it_.m_list->detach(it_);
-    it_.m_item->next=0;
-    it_.m_item->prev=m_last;
-    if(m_last)
-      m_last->next=it_.m_item;
+    // search the left-most child from the right sub-tree
+    y=y->children[1];
+    while(node *child=y->children[0])
+      y=child;
+  }
+
+  // remove y from parent chain
+  node *x=y->children[0]?y->children[0]:y->children[1];
+  if(x)
+    x->parent=y->parent;
+  bool is_left_parent=false;
+  if(y->parent)
+  {
+    is_left_parent=y==y->parent->children[0];
+    y->parent->children[!is_left_parent]=x;
+  }
+  else
+    m_root=x;
+
+  // restore RB-property if removing black node
+  if(!y->color)
+    restore_rb_property_after_remove(x, y->parent, is_left_parent);
+  if(y!=it_.m_node)
+  {
+    // replace m_node with y
+    if((y->parent=it_.m_node->parent)!=0)
+      y->parent->children[it_.m_node==y->parent->children[1]]=y;
     else
-      m_first=it_.m_item;
-    m_last=it_.m_item;
-    ++m_size;
+      m_root=y;
+    y->color=it_.m_node->color;
+    if((y->children[0]=it_.m_node->children[0])!=0)
+      y->children[0]->parent=y;
+    if((y->children[1]=it_.m_node->children[1])!=0)
+      y->children[1]->parent=y;
   }
+
+  // delete node
+  it_.m_node->val.~T();
+  it_.m_node->key.~K();
+  m_allocator->free(it_.m_node);
+  it_.m_node=0;
+  --m_size;
 }
-//----
+//----------------------------------------------------------------------------
 
-template<typename T>
-void list<T>::pop_front()
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::cctor(const map &m_)
 {
-  // remove element from the beginning of the list
-  PFC_ASSERT_PEDANTIC(m_size);
-  item *i=m_first;
-  m_first=i->next;
-  if(!--m_size)
-    m_last=0;
-  else
-    m_first->prev=0;
-  i->data.~T();
-  m_allocator->free(i);
+  // copy-construct the map
+  m_size=m_.m_size;
+  m_root=0;
+  if(m_.m_root)
+    copy_subtree(*m_.m_root, 0, m_root);
 }
 //----
 
-template<typename T>
-void list<T>::pop_back()
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::copy_subtree(node &n_, node *parent_, node *&child_ptr_)
 {
-  // remove element from the end of the list
-  PFC_ASSERT_PEDANTIC(m_size);
-  item *i=m_last;
-  m_last=i->prev;
-  if(!--m_size)
-    m_first=0;
-  else
-    m_last->next=0;
-  i->data.~T();
-  m_allocator->free(i);
+  // recursively copy the sub-tree
+  eh_data<node> p(*m_allocator, 1, map_traits<K, T, CmpPred>::block_alloc_align);
+  node *n=p.data;
+  PFC_PNEW(&n->key)K(n_.key);
+  PFC_PNEW(&n->val)T(n_.val);
+  n->color=n_.color;
+  n->parent=parent_;
+  n->children[0]=0;
+  n->children[1]=0;
+  p.reset();
+  child_ptr_=n;
+  if(n_.children[0])
+    copy_subtree(*n_.children[0], n, n->children[0]);
+  if(n_.children[1])
+    copy_subtree(*n_.children[1], n, n->children[1]);
 }
 //----
 
-template<typename T>
-void list<T>::remove_front(usize_t num_items_)
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::destroy_subtree(node &n_)
 {
-  // remove given number of items from the beginning of the list
-  PFC_ASSERT(m_size>=num_items_);
-  for(usize_t i=0; i<num_items_; ++i)
-  {
-    item *next=m_first->next;
-    m_first->data.~T();
-    m_allocator->free(m_first);
-    m_first=next;
-  }
-  m_size-=num_items_;
-  if(!m_size)
-    m_last=0;
+  // destroy children
+  if(n_.children[0])
+    destroy_subtree(*n_.children[0]);
+  if(n_.children[1])
+    destroy_subtree(*n_.children[1]);
+  n_.val.~T();
+  n_.key.~K();
+  m_allocator->free(&n_);
 }
 //----
 
-template<typename T>
-void list<T>::remove_back(usize_t num_items_)
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::rotate_subtree(node &n_, bool rotate_right_)
 {
-  // remove given number of items from the end of the list
-  PFC_ASSERT(m_size>=num_items_);
-  for(usize_t i=0; i<num_items_; ++i)
-  {
-    item *prev=m_last->prev;
-    m_last->data.~T();
-    m_allocator->free(m_last);
-    m_last=prev;
-  }
-  m_size-=num_items_;
-  if(!m_size)
-    m_first=0;
+  // rotate sub-tree left/right about the node
+  unsigned idx0=rotate_right_, idx1=!rotate_right_;
+  node *y=n_.children[idx1];
+  if((n_.children[idx1]=y->children[idx0])!=0)
+    y->children[idx0]->parent=&n_;
+  node *parent=n_.parent;
+  if((y->parent=parent)!=0)
+    parent->children[&n_==parent->children[idx0]?idx0:idx1]=y;
+  else
+    m_root=y;
+  y->children[idx0]=&n_;
+  n_.parent=y;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-void list<T>::erase(iterator_impl<is_forward> &it_)
-{
-  // remove item from the list and destroy it
-  PFC_ASSERT_PEDANTIC(it_.m_item);
-  detach(it_);
-  it_.m_item->data.~T();
-  item *next=is_forward?it_.m_item->next:it_.m_item->prev;
-  m_allocator->free(it_.m_item);
-  it_.m_item=next;
-}
-//----------------------------------------------------------------------------
-
-template<typename T>
-void list<T>::cctor(const list &l_)
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::restore_rb_property_after_insert(node *n_)
 {
-  // copy-construct the list
-  item **next=&m_first, *i=0;
-  if((m_size=l_.m_size)!=0)
+  // restore RB-tree property after node insertion
+  while(n_!=m_root && n_->parent->color)
   {
-    PFC_EDTOR(*this, &list<T>::clear);
-    item *it=l_.m_first, *prev=0;
-    do
+    node *grandparent=n_->parent->parent;
+    bool is_left_parent=n_->parent==grandparent->children[0];
+    node *y=grandparent->children[is_left_parent];
+    if(y && y->color)
     {
-      // add new item to the list
-      eh_data<item> p(*m_allocator, 1, list_traits<T>::block_alloc_align);
-      i=p.data;
-      PFC_PNEW(&i->data)T(it->data);
-      p.reset();
-      i->prev=prev;
-      *next=i;
-      prev=i;
-      next=&i->next;
-    } while((it=it->next)!=0);
-    PFC_EDTOR_RESET();
+      // change colors
+      n_->parent->color=0;
+      y->color=0;
+      grandparent->color=1;
+      n_=grandparent;
+    }
+    else
+    {
+      if(n_==n_->parent->children[is_left_parent])
+      {
+        // move node up and rotate
+        n_=n_->parent;
+        rotate_subtree(*n_, !is_left_parent);
+        grandparent=n_->parent->parent;
+      }
+      n_->parent->color=0;
+      grandparent->color=1;
+      rotate_subtree(*grandparent, is_left_parent);
+    }
   }
-  *next=0;
-  m_last=i;
+  m_root->color=0;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-void list<T>::detach(iterator_impl<is_forward> &it_)
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::restore_rb_property_after_remove(node *n_, node *parent_, bool is_left_child_)
 {
-  // detach item from the list
-  if(!it_.m_item->prev)
-    m_first=it_.m_item->next;
-  else
-    it_.m_item->prev->next=it_.m_item->next;
-  if(!it_.m_item->next)
-    m_last=it_.m_item->prev;
-  else
-    it_.m_item->next->prev=it_.m_item->prev;
-  --m_size;
+  // restore RB-tree property after node removal
+  while(n_!=m_root && (!n_ || !n_->color))
+  {
+    node *w=parent_->children[is_left_child_];
+    if(w->color)
+    {
+      w->color=0;
+      parent_->color=1;
+      rotate_subtree(*parent_, !is_left_child_);
+      w=parent_->children[is_left_child_];
+    }
+    bool is_child0_black=!w->children[is_left_child_] || !w->children[is_left_child_]->color;
+    if(is_child0_black && (!w->children[!is_left_child_] || !w->children[!is_left_child_]->color))
+    {
+      w->color=1;
+      n_=parent_;
+      parent_=n_->parent;
+      if(parent_)
+        is_left_child_=n_==parent_->children[0];
+    }
+    else
+    {
+      if(is_child0_black)
+      {
+        w->children[!is_left_child_]->color=0;
+        w->color=1;
+        rotate_subtree(*w, is_left_child_);
+        w=parent_->children[is_left_child_];
+      }
+      w->color=parent_->color;
+      parent_->color=0;
+      w->children[is_left_child_]->color=0;
+      rotate_subtree(*parent_, !is_left_child_);
+      n_=m_root;
+    }
+  }
+  if(n_)
+    n_->color=0;
 }
 //----------------------------------------------------------------------------
 
 
 //============================================================================
-// list::const_iterator_impl
+// map::const_iterator
 //============================================================================
-template<typename T>
-template<bool is_forward>
-list<T>::const_iterator_impl<is_forward>::const_iterator_impl()
-  :m_item(0)
+template<typename K, typename T, class CmpPred>
+map<K, T, CmpPred>::const_iterator::const_iterator()
+  :m_node(0)
 {
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-list<T>::const_iterator_impl<is_forward>::const_iterator_impl(const iterator_impl<is_forward> &it_)
-  :m_item(it_.m_item)
+template<typename K, typename T, class CmpPred>
+map<K, T, CmpPred>::const_iterator::const_iterator(const iterator &it_)
+  :m_node(it_.m_node)
 {
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-void list<T>::const_iterator_impl<is_forward>::reset()
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::const_iterator::reset()
 {
-  m_item=0;
+  m_node=0;
 }
 //----------------------------------------------------------------------------
 
-template<typename T>
-template<bool is_forward>
-bool list<T>::const_iterator_impl<is_forward>::operator==(const const_iterator_impl &it_) const
+template<typename K, typename T, class CmpPred>
+bool map<K, T, CmpPred>::const_iterator::operator==(const const_iterator &it_) const
 {
-  return m_item==it_.m_item;
+  return m_node==it_.m_node;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-bool list<T>::const_iterator_impl<is_forward>::operator==(const iterator_impl<is_forward> &it_) const
+template<typename K, typename T, class CmpPred>
+bool map<K, T, CmpPred>::const_iterator::operator==(const iterator &it_) const
 {
-  return m_item==it_.m_item;
+  return m_node==it_.m_node;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-bool list<T>::const_iterator_impl<is_forward>::operator!=(const const_iterator_impl &it_) const
+template<typename K, typename T, class CmpPred>
+bool map<K, T, CmpPred>::const_iterator::operator!=(const const_iterator &it_) const
 {
-  return m_item!=it_.m_item;
+  return m_node!=it_.m_node;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-bool list<T>::const_iterator_impl<is_forward>::operator!=(const iterator_impl<is_forward> &it_) const
+template<typename K, typename T, class CmpPred>
+bool map<K, T, CmpPred>::const_iterator::operator!=(const iterator &it_) const
 {
-  return m_item!=it_.m_item;
+  return m_node!=it_.m_node;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-typename list<T>::template const_iterator_impl<is_forward> &list<T>::const_iterator_impl<is_forward>::operator++()
+template<typename K, typename T, class CmpPred>
+typename map<K, T, CmpPred>::const_iterator &map<K, T, CmpPred>::const_iterator::operator++()
 {
-  PFC_ASSERT_PEDANTIC(m_item);
-  m_item=is_forward?m_item->next:m_item->prev;
+  PFC_ASSERT_PEDANTIC(m_node);
+  if(const node *n=m_node->children[1])
+  {
+    // find left-most node under right child
+    while(n)
+    {
+      m_node=n;
+      n=n->children[0];
+    }
+  }
+  else
+  {
+    // traverse right sub-tree up
+    while(m_node->parent && m_node->parent->children[1]==m_node)
+      m_node=m_node->parent;
+    m_node=m_node->parent;
+  }
   return *this;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-typename list<T>::template const_iterator_impl<is_forward> &list<T>::const_iterator_impl<is_forward>::operator--()
+template<typename K, typename T, class CmpPred>
+const T &map<K, T, CmpPred>::const_iterator::operator*() const
 {
-  PFC_ASSERT_PEDANTIC(m_item);
-  m_item=is_forward?m_item->prev:m_item->next;
-  return *this;
+  PFC_ASSERT_PEDANTIC(m_node);
+  return m_node->val;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-const T &list<T>::const_iterator_impl<is_forward>::operator*() const
+template<typename K, typename T, class CmpPred>
+const T *map<K, T, CmpPred>::const_iterator::operator->() const
 {
-  PFC_ASSERT_PEDANTIC(m_item);
-  return m_item->data;
+  PFC_ASSERT_PEDANTIC(m_node);
+  return &m_node->val;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-const T *list<T>::const_iterator_impl<is_forward>::operator->() const
+template<typename K, typename T, class CmpPred>
+const K &map<K, T, CmpPred>::const_iterator::key() const
 {
-  PFC_ASSERT_PEDANTIC(m_item);
-  return &m_item->data;
+  PFC_ASSERT_PEDANTIC(m_node);
+  return m_node->key;
 }
 //----------------------------------------------------------------------------
 
-template<typename T>
-template<bool is_forward>
-list<T>::const_iterator_impl<is_forward>::const_iterator_impl(item *i_)
+template<typename K, typename T, class CmpPred>
+map<K, T, CmpPred>::const_iterator::const_iterator(const node *n_)
+  :m_node(n_)
 {
-  m_item=i_;
 }
 //----------------------------------------------------------------------------
 
 
 //============================================================================
-// list::iterator_impl
+// map::iterator
 //============================================================================
-template<typename T>
-template<bool is_forward>
-list<T>::iterator_impl<is_forward>::iterator_impl()
-  :m_list(0)
-  ,m_item(0)
+template<typename K, typename T, class CmpPred>
+map<K, T, CmpPred>::iterator::iterator()
+  :m_node(0)
 {
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-void list<T>::iterator_impl<is_forward>::reset()
+template<typename K, typename T, class CmpPred>
+void map<K, T, CmpPred>::iterator::reset()
 {
-  m_list=0;
-  m_item=0;
+  m_node=0;
 }
 //----------------------------------------------------------------------------
 
-template<typename T>
-template<bool is_forward>
-bool list<T>::iterator_impl<is_forward>::operator==(const const_iterator_impl<is_forward> &it_) const
+template<typename K, typename T, class CmpPred>
+bool map<K, T, CmpPred>::iterator::operator==(const const_iterator &it_) const
 {
-  return m_item==it_.m_item;
+  return m_node==it_.m_node;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-bool list<T>::iterator_impl<is_forward>::operator==(const iterator_impl &it_) const
+template<typename K, typename T, class CmpPred>
+bool map<K, T, CmpPred>::iterator::operator==(const iterator &it_) const
 {
-  return m_item==it_.m_item;
+  return m_node==it_.m_node;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-bool list<T>::iterator_impl<is_forward>::operator!=(const const_iterator_impl<is_forward> &it_) const
+template<typename K, typename T, class CmpPred>
+bool map<K, T, CmpPred>::iterator::operator!=(const const_iterator &it_) const
 {
-  return m_item!=it_.m_item;
+  return m_node!=it_.m_node;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-bool list<T>::iterator_impl<is_forward>::operator!=(const iterator_impl &it_) const
+template<typename K, typename T, class CmpPred>
+bool map<K, T, CmpPred>::iterator::operator!=(const iterator &it_) const
 {
-  return m_item!=it_.m_item;
+  return m_node!=it_.m_node;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-typename list<T>::template iterator_impl<is_forward> &list<T>::iterator_impl<is_forward>::operator++()
+template<typename K, typename T, class CmpPred>
+typename map<K, T, CmpPred>::iterator &map<K, T, CmpPred>::iterator::operator++()
 {
-  PFC_ASSERT_PEDANTIC(m_item);
-  m_item=is_forward?m_item->next:m_item->prev;
+  PFC_ASSERT_PEDANTIC(m_node);
+  if(node *n=m_node->children[1])
+  {
+    // find left-most node under right child
+    while(n)
+    {
+      m_node=n;
+      n=n->children[0];
+    }
+  }
+  else
+  {
+    // traverse right sub-tree up
+    while(m_node->parent && m_node->parent->children[1]==m_node)
+      m_node=m_node->parent;
+    m_node=m_node->parent;
+  }
   return *this;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-typename list<T>::template iterator_impl<is_forward> &list<T>::iterator_impl<is_forward>::operator--()
+template<typename K, typename T, class CmpPred>
+T &map<K, T, CmpPred>::iterator::operator*() const
 {
-  PFC_ASSERT_PEDANTIC(m_item);
-  m_item=is_forward?m_item->prev:m_item->next;
-  return *this;
+  PFC_ASSERT_PEDANTIC(m_node);
+  return m_node->val;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-T &list<T>::iterator_impl<is_forward>::operator*() const
+template<typename K, typename T, class CmpPred>
+T *map<K, T, CmpPred>::iterator::operator->() const
 {
-  PFC_ASSERT_PEDANTIC(m_item);
-  return m_item->data;
+  PFC_ASSERT_PEDANTIC(m_node);
+  return &m_node->val;
 }
 //----
 
-template<typename T>
-template<bool is_forward>
-T *list<T>::iterator_impl<is_forward>::operator->() const
+template<typename K, typename T, class CmpPred>
+const K &map<K, T, CmpPred>::iterator::key() const
 {
-  PFC_ASSERT_PEDANTIC(m_item);
-  return &m_item->data;
+  PFC_ASSERT_PEDANTIC(m_node);
+  return m_node->key;
 }
 //----------------------------------------------------------------------------
 
-template<typename T>
-template<bool is_forward>
-list<T>::iterator_impl<is_forward>::iterator_impl(list &l_, item *i_)
-  :m_list(&l_)
-  ,m_item(i_)
-{
-}
-//----
-
-template<typename T>
-template<bool is_forward>
-void list<T>::iterator_impl<is_forward>::rotate_sequence_left_impl(iterator_impl &first_, iterator_impl &last_)
-{
-  PFC_ASSERT_PEDANTIC_MSG(first_.m_item && last_.m_item && first_.m_list==last_.m_list,
-                          ("Iterators must be valid and of the same list (first: %p, last: %p)\r\n", first_.m_item?first_.m_list:0, last_.m_item?last_.m_list:0));
-  list<T> *l=first_.m_list;
-  list<T>::item *fi=first_.m_item, *li=last_.m_item;
-  if(fi==li)
-    return;
-  first_.m_item=fi->next;
-  last_.m_item=fi;
-  if(fi->prev)
-    fi->prev->next=fi->next;
-  else
-    l->m_first=fi->next;
-  if(li->next)
-    li->next->prev=fi;
-  else
-    l->m_last=fi;
-  fi->next->prev=fi->prev;
-  fi->prev=li;
-  fi->next=li->next;
-  li->next=fi;
-}
-//----
-
-template<typename T>
-template<bool is_forward>
-void list<T>::iterator_impl<is_forward>::rotate_sequence_right_impl(iterator_impl &first_, iterator_impl &last_)
+template<typename K, typename T, class CmpPred>
+map<K, T, CmpPred>::iterator::iterator(node *n_)
+  :m_node(n_)
 {
-  PFC_ASSERT_PEDANTIC_MSG(first_.m_item && last_.m_item && first_.m_list==last_.m_list,
-                          ("Iterators must be valid and of the same list (first: %p, last: %p)\r\n", first_.m_item?first_.m_list:0, last_.m_item?last_.m_list:0));
-  list<T> *l=first_.m_list;
-  list<T>::item *fi=first_.m_item, *li=last_.m_item;
-  if(fi==li)
-    return;
-  first_.m_item=li;
-  last_.m_item=li->prev;
-  if(li->next)
-    li->next->prev=li->prev;
-  else
-    l->m_last=li->prev;
-  if(fi->prev)
-    fi->prev->next=li;
-  else
-    l->m_first=li;
-  li->prev->next=li->next;
-  li->next=fi;
-  li->prev=fi->prev;
-  fi->prev=li;
 }
 //----------------------------------------------------------------------------
 
 
 //============================================================================
-// set
+// btree_set
 //============================================================================
-PFC_INTROSPEC_INL_TDEF2(typename T, class CmpPred, set<T, CmpPred>)
+PFC_INTROSPEC_INL_TDEF2(typename T, class CmpPred, btree_set<T, CmpPred>)
 {
   PFC_CUSTOM_STREAMING(0);
   switch(unsigned(PE::pe_type))
@@ -3935,28 +6255,9 @@ PFC_INTROSPEC_INL_TDEF2(typename T, class CmpPred, set<T, CmpPred>)
       pe_.var(size);
       for(uint32_t i=0; i<size; ++i)
       {
-        // search for the leaf node where to add the value
-        node *n=m_root, *parent=0, **parent_childptr=&m_root;
-        while(n)
-        {
-          parent=n;
-          parent_childptr=&n->children[m_cmp_pred.before(n->data, v_)];
-          n=*parent_childptr;
-        }
-
-        // add new node
-        eh_data<node> p(*m_allocator, 1, set_traits<T, CmpPred>::block_alloc_align);
-        n=p.data;
-        PFC_PNEW(&n->data)T;
-        pe_.var(n->data, i?mvarflag_array_tail:0);
-        n->color=1;
-        n->parent=parent;
-        n->children[0]=0;
-        n->children[1]=0;
-        *parent_childptr=n;
-        p.reset();
-        ++m_size;
-        restore_rb_property_after_insert(n);
+        T v;
+        pe_.var(v, i?mvarflag_array_tail:0);
+        insert(v);
       }
     } break;
 
@@ -3964,10 +6265,10 @@ PFC_INTROSPEC_INL_TDEF2(typename T, class CmpPred, set<T, CmpPred>)
     case penum_display:
     {
       // write/display data
-      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize set<%s> that contains more than 2^32-1 elements\r\n", typeid(T).name()));
+      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize btree_set<%s> that contains more than 2^32-1 elements\r\n", typeid(T).name()));
       uint32_t size=(uint32_t)m_size;
       pe_.var(size, 0, "size");
-      typename set<T, CmpPred>::iterator it=begin();
+      typename btree_set<T, CmpPred>::iterator it=begin();
       unsigned var_flags=0;
       while(is_valid(it))
       {
@@ -3981,95 +6282,131 @@ PFC_INTROSPEC_INL_TDEF2(typename T, class CmpPred, set<T, CmpPred>)
 //----------------------------------------------------------------------------
 
 template<typename T, class CmpPred>
-set<T, CmpPred>::set(const CmpPred &cmp_pred_, memory_allocator_base *alloc_)
+btree_set<T, CmpPred>::btree_set(const CmpPred &cmp_pred_, memory_allocator_base *alloc_)
+  :m_cmp_pred(cmp_pred_)
+  ,m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+{
+  m_size=0;
+  m_root=0;
+  m_depth=0;
+}
+//----
+
+template<typename T, class CmpPred>
+btree_set<T, CmpPred>::btree_set(const T *sorted_items_, usize_t num_items_, const CmpPred &cmp_pred_, memory_allocator_base *alloc_)
   :m_cmp_pred(cmp_pred_)
   ,m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
 {
+  // build the tree bottom-up from sorted unique items
   PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(set_traits<T, CmpPred>::block_alloc_size, set_traits<T, CmpPred>::block_alloc_align));
   m_size=0;
   m_root=0;
+  m_depth=0;
+  bulk_load(sorted_items_, num_items_);
 }
 //----
 
 template<typename T, class CmpPred>
-set<T, CmpPred>::set(const set &s_)
+btree_set<T, CmpPred>::btree_set(const btree_set &s_)
   :m_cmp_pred(s_.m_cmp_pred)
   ,m_allocator(&default_memory_allocator::inst())
 {
   PFC_MEM_TRACK_STACK();
-  cctor(s_);
+  m_size=0;
+  m_root=0;
+  m_depth=0;
+  bulk_load(s_.begin(), s_.m_size);
 }
 //----
 
 template<typename T, class CmpPred>
-set<T, CmpPred>::set(const set &s_, memory_allocator_base *alloc_)
+btree_set<T, CmpPred>::btree_set(const btree_set &s_, memory_allocator_base *alloc_)
   :m_cmp_pred(s_.m_cmp_pred)
   ,m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
 {
   PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(set_traits<T, CmpPred>::block_alloc_size, set_traits<T, CmpPred>::block_alloc_align));
-  cctor(s_);
+  m_size=0;
+  m_root=0;
+  m_depth=0;
+  bulk_load(s_.begin(), s_.m_size);
 }
 //----
 
 template<typename T, class CmpPred>
-set<T, CmpPred>::~set()
+btree_set<T, CmpPred>::~btree_set()
 {
   clear();
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::operator=(const set &s_)
+void btree_set<T, CmpPred>::operator=(const btree_set &s_)
 {
-  set s(s_);
+  btree_set s(s_);
   swap(s);
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::set_allocator(memory_allocator_base *alloc_)
+void btree_set<T, CmpPred>::set_allocator(memory_allocator_base *alloc_)
 {
-  PFC_ASSERT_MSG(!m_size, ("Unable to change the allocator of a non-empty set\r\n"));
+  PFC_ASSERT_MSG(!m_size, ("Unable to change the allocator of a non-empty btree_set\r\n"));
   m_allocator=alloc_?alloc_:&default_memory_allocator::inst();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(set_traits<T, CmpPred>::block_alloc_size, set_traits<T, CmpPred>::block_alloc_align));
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::clear()
+void btree_set<T, CmpPred>::clear()
 {
   // recursively destroy nodes
   if(m_root)
   {
-    destroy_subtree(*m_root);
+    destroy_subtree(m_root, 0);
     m_root=0;
+    m_depth=0;
     m_size=0;
   }
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::swap(set &s_)
+void btree_set<T, CmpPred>::swap(btree_set &s_)
 {
   // swap content of sets
   pfc::swap(m_cmp_pred, s_.m_cmp_pred);
   pfc::swap(m_allocator, s_.m_allocator);
   pfc::swap(m_size, s_.m_size);
   pfc::swap(m_root, s_.m_root);
+  pfc::swap(m_depth, s_.m_depth);
+}
+//----
+
+template<typename T, class CmpPred>
+void btree_set<T, CmpPred>::validate_btree_state() const
+{
+  // check node occupancy, item order and leaf links
+  if(!m_root)
+  {
+    PFC_ASSERT(!m_size && !m_depth);
+    return;
+  }
+  usize_t num_items=0;
+  const leaf *prev_leaf=0;
+  validate_btree_state(m_root, 0, 0, 0, num_items, prev_leaf);
+  PFC_ASSERT(num_items==m_size);
+  PFC_ASSERT(!prev_leaf->next);
 }
 //----------------------------------------------------------------------------
 
 template<typename T, class CmpPred>
-memory_allocator_base &set<T, CmpPred>::allocator() const
+memory_allocator_base &btree_set<T, CmpPred>::allocator() const
 {
   return *m_allocator;
 }
 //----
 
 template<typename T, class CmpPred>
-usize_t set<T, CmpPred>::size() const
+usize_t btree_set<T, CmpPred>::size() const
 {
   return m_size;
 }
@@ -4077,609 +6414,747 @@ usize_t set<T, CmpPred>::size() const
 
 template<typename T, class CmpPred>
 template<typename K>
-typename set<T, CmpPred>::const_iterator set<T, CmpPred>::find(const K &k_) const
+typename btree_set<T, CmpPred>::const_iterator btree_set<T, CmpPred>::find(const K &k_) const
 {
-  // search from value from the set
-  const node *n=m_root;
-  while(n && !m_cmp_pred.equal(n->data, k_))
-    n=n->children[m_cmp_pred.before(n->data, k_)];
-  return const_iterator(n);
+  // search for the value from the leaf covering the key
+  if(leaf *l=find_leaf(k_))
+  {
+    unsigned idx=lower_idx(l->items(), l->num_items, k_);
+    if(idx<l->num_items && m_cmp_pred.equal(l->items()[idx], k_))
+      return const_iterator(l, idx);
+  }
+  return const_iterator();
 }
 //----
 
 template<typename T, class CmpPred>
 template<typename K>
-typename set<T, CmpPred>::iterator set<T, CmpPred>::find(const K &k_)
+typename btree_set<T, CmpPred>::iterator btree_set<T, CmpPred>::find(const K &k_)
 {
-  // search from value from the set
-  node *n=m_root;
-  while(n && !m_cmp_pred.equal(n->data, k_))
-    n=n->children[m_cmp_pred.before(n->data, k_)];
-  return iterator(n);
+  // search for the value from the leaf covering the key
+  if(leaf *l=find_leaf(k_))
+  {
+    unsigned idx=lower_idx(l->items(), l->num_items, k_);
+    if(idx<l->num_items && m_cmp_pred.equal(l->items()[idx], k_))
+      return iterator(l, idx);
+  }
+  return iterator();
 }
 //----
 
 template<typename T, class CmpPred>
 template<typename K>
-typename set<T, CmpPred>::const_iterator set<T, CmpPred>::lower_bound(const K &k_) const
+typename btree_set<T, CmpPred>::const_iterator btree_set<T, CmpPred>::lower_bound(const K &k_) const
 {
   // return iterator to the closest less-or-equal value in the set
-  const node *n=m_root, *prev=0;
-  while(n)
-    if(m_cmp_pred.before(k_, n->data))
-      n=n->children[0];
-    else
-    {
-      prev=n;
-      if(!m_cmp_pred.before(n->data, k_))
-        break;
-      n=n->children[1];
-    }
-  return const_iterator(prev);
+  if(leaf *l=find_leaf(k_))
+  {
+    if(unsigned idx=upper_idx(l->items(), l->num_items, k_))
+      return const_iterator(l, idx-1);
+    if(l->prev)
+      return const_iterator(l->prev, l->prev->num_items-1);
+  }
+  return const_iterator();
 }
 //----
 
 template<typename T, class CmpPred>
 template<typename K>
-typename set<T, CmpPred>::iterator set<T, CmpPred>::lower_bound(const K &k_)
+typename btree_set<T, CmpPred>::iterator btree_set<T, CmpPred>::lower_bound(const K &k_)
 {
   // return iterator to the closest less-or-equal value in the set
-  node *n=m_root, *prev=0;
-  while(n)
-    if(m_cmp_pred.before(k_, n->data))
-      n=n->children[0];
-    else
-    {
-      prev=n;
-      if(!m_cmp_pred.before(n->data, k_))
-        break;
-      n=n->children[1];
-    }
-  return iterator(prev);
+  if(leaf *l=find_leaf(k_))
+  {
+    if(unsigned idx=upper_idx(l->items(), l->num_items, k_))
+      return iterator(l, idx-1);
+    if(l->prev)
+      return iterator(l->prev, l->prev->num_items-1);
+  }
+  return iterator();
 }
 //----
 
 template<typename T, class CmpPred>
 template<typename K>
-typename set<T, CmpPred>::const_iterator set<T, CmpPred>::upper_bound(const K &k_) const
+typename btree_set<T, CmpPred>::const_iterator btree_set<T, CmpPred>::upper_bound(const K &k_) const
 {
   // return iterator to the closest greater value in the set
-  const node *n=m_root, *prev=0;
-  while(n)
-    if(!m_cmp_pred.before(k_, n->data))
-      n=n->children[1];
-    else
-    {
-      prev=n;
-      n=n->children[0];
-    }
-  return const_iterator(prev);
+  if(leaf *l=find_leaf(k_))
+  {
+    unsigned idx=upper_idx(l->items(), l->num_items, k_);
+    if(idx<l->num_items)
+      return const_iterator(l, idx);
+    if(l->next)
+      return const_iterator(l->next, 0);
+  }
+  return const_iterator();
 }
 //----
 
 template<typename T, class CmpPred>
 template<typename K>
-typename set<T, CmpPred>::iterator set<T, CmpPred>::upper_bound(const K &k_)
+typename btree_set<T, CmpPred>::iterator btree_set<T, CmpPred>::upper_bound(const K &k_)
 {
   // return iterator to the closest greater value in the set
-  node *n=m_root, *prev=0;
-  while(n)
-    if(!m_cmp_pred.before(k_, n->data))
-      n=n->children[1];
-    else
-    {
-      prev=n;
-      n=n->children[0];
-    }
-  return iterator(prev);
+  if(leaf *l=find_leaf(k_))
+  {
+    unsigned idx=upper_idx(l->items(), l->num_items, k_);
+    if(idx<l->num_items)
+      return iterator(l, idx);
+    if(l->next)
+      return iterator(l->next, 0);
+  }
+  return iterator();
 }
 //----
 
 template<typename T, class CmpPred>
-typename set<T, CmpPred>::const_iterator set<T, CmpPred>::begin() const
+typename btree_set<T, CmpPred>::const_iterator btree_set<T, CmpPred>::begin() const
 {
-  // return iterator to the left-most node
-  const node *n=m_root, *prev=0;
-  while(n)
-  {
-    prev=n;
-    n=n->children[0];
-  }
-  return const_iterator(prev);
+  // return iterator to the first item of the left-most leaf
+  void *n=m_root;
+  for(unsigned d=0; d<m_depth; ++d)
+    n=((branch*)n)->children[0];
+  return const_iterator((leaf*)n, 0);
 }
 //----
 
 template<typename T, class CmpPred>
-typename set<T, CmpPred>::iterator set<T, CmpPred>::begin()
+typename btree_set<T, CmpPred>::iterator btree_set<T, CmpPred>::begin()
 {
-  // return iterator to the left-most node
-  node *n=m_root, *prev=0;
-  while(n)
-  {
-    prev=n;
-    n=n->children[0];
-  }
-  return iterator(prev);
+  // return iterator to the first item of the left-most leaf
+  void *n=m_root;
+  for(unsigned d=0; d<m_depth; ++d)
+    n=((branch*)n)->children[0];
+  return iterator((leaf*)n, 0);
 }
 //----
 
 template<typename T, class CmpPred>
-typename set<T, CmpPred>::const_iterator set<T, CmpPred>::end() const
+typename btree_set<T, CmpPred>::const_iterator btree_set<T, CmpPred>::end() const
 {
-  return const_iterator(0);
+  return const_iterator();
 }
 //----
 
 template<typename T, class CmpPred>
-typename set<T, CmpPred>::iterator set<T, CmpPred>::end()
+typename btree_set<T, CmpPred>::iterator btree_set<T, CmpPred>::end()
 {
-  return iterator(0);
+  return iterator();
 }
 //----
 
 template<typename T, class CmpPred>
 template<typename K>
-typename set<T, CmpPred>::inserter set<T, CmpPred>::insert(const K &k_, bool replace_)
+typename btree_set<T, CmpPred>::inserter btree_set<T, CmpPred>::insert(const K &k_, bool replace_)
 {
-  // search for the leaf node where to add the value
-  node *n=m_root, *parent=0, **parent_childptr=&m_root;
-  while(n && !m_cmp_pred.equal(n->data, k_))
+  // add root leaf for empty set
+  PFC_MEM_TRACK_STACK();
+  if(!m_root)
   {
-    if(m_cmp_pred.equal(n->data, k_))
-    {
-      inserter ins={iterator(n), false};
-      return ins;
-    }
-    parent=n;
-    parent_childptr=&n->children[m_cmp_pred.before(n->data, k_)];
-    n=*parent_childptr;
+    leaf *l=alloc_leaf();
+    l->num_items=0;
+    l->prev=l->next=0;
+    m_root=l;
   }
 
-  bool is_new=!n;
-  if(is_new)
+  // search for the leaf where to add the value
+  branch *path[max_depth];
+  unsigned path_idx[max_depth];
+  leaf *l=find_leaf(k_, path, path_idx);
+  T *items=l->items();
+  unsigned idx=lower_idx(items, l->num_items, k_);
+  if(idx<l->num_items && m_cmp_pred.equal(items[idx], k_))
   {
-    // add new node
-    eh_data<node> p(*m_allocator, 1, set_traits<T, CmpPred>::block_alloc_align);
-    n=p.data;
-    PFC_PNEW(&n->data)T(k_);
-    n->color=1;
-    n->parent=parent;
-    n->children[0]=0;
-    n->children[1]=0;
-    *parent_childptr=n;
-    p.reset();
-    ++m_size;
-    restore_rb_property_after_insert(n);
-  }
-  else
     if(replace_)
     {
-      // replace existing node data with new one
-      n->data.~T();
-      PFC_PNEW(&n->data)T(k_);
+      // replace existing item with new one
+      items[idx].~T();
+      PFC_PNEW(items+idx)T(k_);
     }
-  inserter ins={iterator(n), is_new};
+    inserter ins={iterator(l, idx), false};
+    return ins;
+  }
+
+  // add the value to the leaf (leaves have one spare slot for overflow)
+  move_construct(items+idx+1, items+idx, l->num_items-idx);
+  PFC_PNEW(items+idx)T(k_);
+  ++m_size;
+  if(++l->num_items>leaf_capacity)
+  {
+    // split the leaf in half and add the new leaf to the parent
+    leaf *r=alloc_leaf();
+    unsigned num_left=l->num_items/2;
+    r->num_items=l->num_items-num_left;
+    move_construct(r->items(), items+num_left, r->num_items);
+    l->num_items=num_left;
+    r->prev=l;
+    if((r->next=l->next)!=0)
+      r->next->prev=r;
+    l->next=r;
+    add_separator(path, path_idx, r->items()[0], r);
+    if(idx>=num_left)
+    {
+      inserter ins={iterator(r, idx-num_left), true};
+      return ins;
+    }
+  }
+  inserter ins={iterator(l, idx), true};
   return ins;
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::erase(iterator &it_)
-{
-  PFC_ASSERT_PEDANTIC(it_.m_node);
-  node *y=it_.m_node;
-  if(y->children[0] && y->children[1])
+void btree_set<T, CmpPred>::erase(iterator &it_)
+{
+  // search path to the leaf of the item
+  PFC_ASSERT_PEDANTIC(it_.m_leaf);
+  branch *path[max_depth];
+  unsigned path_idx[max_depth];
+  leaf *l=find_leaf(it_.m_leaf->items()[it_.m_idx], path, path_idx);
+  PFC_ASSERT(l==it_.m_leaf);
+
+  // remove the item from the leaf
+  T *items=l->items();
+  unsigned idx=it_.m_idx;
+  items[idx].~T();
+  move_construct(items+idx, items+idx+1, --l->num_items-idx);
+  it_.reset();
+  --m_size;
+
+  // release empty root leaf or restore the minimum occupancy of the leaf
+  if(!m_depth)
   {
-    // search the left-most child from the right sub-tree
-    y=y->children[1];
-    while(node *child=y->children[0])
-      y=child;
+    if(!l->num_items)
+    {
+      m_allocator->free(l);
+      m_root=0;
+    }
   }
+  else if(l->num_items<leaf_min_items)
+    rebalance(path, path_idx, *l);
+}
+//----------------------------------------------------------------------------
 
-  // remove y from parent chain
-  node *x=y->children[0]?y->children[0]:y->children[1];
-  if(x)
-    x->parent=y->parent;
-  bool is_left_parent=false;
-  if(y->parent)
-  {
-    is_left_parent=y==y->parent->children[0];
-    y->parent->children[!is_left_parent]=x;
+template<typename T, class CmpPred>
+template<class U>
+void btree_set<T, CmpPred>::bulk_load(U it_, usize_t num_items_)
+{
+  // build leaves with evenly distributed items
+  if(!num_items_)
+    return;
+  usize_t num_nodes=(num_items_+leaf_capacity-1)/leaf_capacity;
+  array<void*> nodes(num_nodes);
+  array<const T*> node_mins(num_nodes);
+  leaf *prev=0;
+  for(usize_t ni=0; ni<num_nodes; ++ni)
+  {
+    leaf *l=alloc_leaf();
+    T *items=l->items();
+    unsigned num_items=unsigned(num_items_/num_nodes+(ni<num_items_%num_nodes));
+    for(unsigned i=0; i<num_items; ++i, ++it_)
+    {
+      PFC_PNEW(items+i)T(*it_);
+      PFC_ASSERT_PEDANTIC_MSG((i?items+i-1:prev?prev->items()+prev->num_items-1:0)==0 || m_cmp_pred.before(i?items[i-1]:prev->items()[prev->num_items-1], items[i]),
+                              ("Bulk loaded btree_set items must be sorted and unique\r\n"));
+    }
+    l->num_items=num_items;
+    l->next=0;
+    if((l->prev=prev)!=0)
+      prev->next=l;
+    nodes[ni]=l;
+    node_mins[ni]=items;
+    prev=l;
   }
-  else
-    m_root=x;
+  m_size=num_items_;
 
-  // restore RB-property if removing black node
-  if(!y->color)
-    restore_rb_property_after_remove(x, y->parent, is_left_parent);
-  if(y!=it_.m_node)
+  // build branch levels bottom-up until there's a single root node
+  while(num_nodes>1)
   {
-    // replace m_node with y
-    if((y->parent=it_.m_node->parent)!=0)
-      y->parent->children[it_.m_node==y->parent->children[1]]=y;
-    else
-      m_root=y;
-    y->color=it_.m_node->color;
-    if((y->children[0]=it_.m_node->children[0])!=0)
-      y->children[0]->parent=y;
-    if((y->children[1]=it_.m_node->children[1])!=0)
-      y->children[1]->parent=y;
+    usize_t num_parents=(num_nodes+branch_capacity)/(branch_capacity+1), child_idx=0;
+    for(usize_t ni=0; ni<num_parents; ++ni)
+    {
+      branch *b=alloc_branch();
+      T *keys=b->keys();
+      unsigned num_children=unsigned(num_nodes/num_parents+(ni<num_nodes%num_parents));
+      const T *node_min=node_mins[child_idx];
+      b->children[0]=nodes[child_idx];
+      for(unsigned i=1; i<num_children; ++i)
+      {
+        PFC_PNEW(keys+i-1)T(*node_mins[child_idx+i]);
+        b->children[i]=nodes[child_idx+i];
+      }
+      b->num_keys=num_children-1;
+      nodes[ni]=b;
+      node_mins[ni]=node_min;
+      child_idx+=num_children;
+    }
+    num_nodes=num_parents;
+    ++m_depth;
   }
-
-  // delete node
-  it_.m_node->data.~T();
-  m_allocator->free(it_.m_node);
-  it_.m_node=0;
-  --m_size;
+  m_root=nodes[0];
 }
-//----------------------------------------------------------------------------
+//----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::cctor(const set &s_)
+typename btree_set<T, CmpPred>::leaf *btree_set<T, CmpPred>::alloc_leaf()
 {
-  // copy-construct the set
-  m_size=s_.m_size;
-  m_root=0;
-  if(s_.m_root)
-    copy_subtree(*s_.m_root, 0, m_root);
+  return (leaf*)m_allocator->alloc(sizeof(leaf), meta_alignof<leaf>::res);
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::copy_subtree(node &n_, node *parent_, node *&child_ptr_)
+typename btree_set<T, CmpPred>::branch *btree_set<T, CmpPred>::alloc_branch()
 {
-  // recursively copy the sub-tree
-  eh_data<node> p(*m_allocator, 1, set_traits<T, CmpPred>::block_alloc_align);
-  node *n=p.data;
-  PFC_PNEW(&n->data)T(n_.data);
-  n->color=n_.color;
-  n->parent=parent_;
-  n->children[0]=0;
-  n->children[1]=0;
-  p.reset();
-  child_ptr_=n;
-  if(n_.children[0])
-    copy_subtree(*n_.children[0], n, n->children[0]);
-  if(n_.children[1])
-    copy_subtree(*n_.children[1], n, n->children[1]);
+  return (branch*)m_allocator->alloc(sizeof(branch), meta_alignof<branch>::res);
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::destroy_subtree(node &n_)
+void btree_set<T, CmpPred>::destroy_subtree(void *n_, unsigned depth_)
 {
-  // destroy children
-  if(n_.children[0])
-    destroy_subtree(*n_.children[0]);
-  if(n_.children[1])
-    destroy_subtree(*n_.children[1]);
-  n_.data.~T();
-  m_allocator->free(&n_);
+  // destroy children and keys/items of the node
+  if(depth_<m_depth)
+  {
+    branch *b=(branch*)n_;
+    for(unsigned i=0; i<=b->num_keys; ++i)
+      destroy_subtree(b->children[i], depth_+1);
+    reverse_destruct(b->keys(), b->num_keys);
+  }
+  else
+  {
+    leaf *l=(leaf*)n_;
+    reverse_destruct(l->items(), l->num_items);
+  }
+  m_allocator->free(n_);
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::rotate_subtree(node &n_, bool rotate_right_)
-{
-  // rotate sub-tree left/right about the node
-  unsigned idx0=rotate_right_, idx1=!rotate_right_;
-  node *y=n_.children[idx1];
-  if((n_.children[idx1]=y->children[idx0])!=0)
-    y->children[idx0]->parent=&n_;
-  node *parent=n_.parent;
-  if((y->parent=parent)!=0)
-    parent->children[&n_==parent->children[idx0]?idx0:idx1]=y;
-  else
-    m_root=y;
-  y->children[idx0]=&n_;
-  n_.parent=y;
+void btree_set<T, CmpPred>::add_separator(branch *const *path_, const unsigned *path_idx_, const T &key_, void *right_)
+{
+  // add the key and right node to the parent, and split the branches up the path that overflow
+  const T *key=&key_, *moved_key=0;
+  unsigned depth=m_depth;
+  while(depth--)
+  {
+    // insert key & child to the branch (branches have one spare slot for overflow)
+    branch *b=path_[depth];
+    unsigned idx=path_idx_[depth];
+    T *keys=b->keys();
+    move_construct(keys+idx+1, keys+idx, b->num_keys-idx);
+    mem_move(b->children+idx+2, b->children+idx+1, sizeof(void*)*(b->num_keys-idx));
+    PFC_PNEW(keys+idx)T(*key);
+    if(moved_key)
+      moved_key->~T();
+    b->children[idx+1]=right_;
+    if(++b->num_keys<=branch_capacity)
+      return;
+
+    // split the branch and move the middle key up
+    branch *r=alloc_branch();
+    unsigned mid=b->num_keys/2;
+    r->num_keys=b->num_keys-mid-1;
+    move_construct(r->keys(), keys+mid+1, r->num_keys);
+    mem_copy(r->children, b->children+mid+1, sizeof(void*)*(r->num_keys+1));
+    b->num_keys=mid;
+    key=moved_key=keys+mid;
+    right_=r;
+  }
+
+  // add new root
+  PFC_ASSERT(m_depth+1<max_depth);
+  branch *root=alloc_branch();
+  PFC_PNEW(root->keys())T(*key);
+  if(moved_key)
+    moved_key->~T();
+  root->num_keys=1;
+  root->children[0]=m_root;
+  root->children[1]=right_;
+  m_root=root;
+  ++m_depth;
+}
+//----
+
+template<typename T, class CmpPred>
+void btree_set<T, CmpPred>::rebalance(branch *const *path_, const unsigned *path_idx_, leaf &l_)
+{
+  // borrow an item from a sibling leaf if possible
+  unsigned depth=m_depth-1;
+  branch *b=path_[depth];
+  unsigned idx=path_idx_[depth];
+  T *bkeys=b->keys();
+  leaf *rl=idx<b->num_keys?(leaf*)b->children[idx+1]:0;
+  leaf *ll=idx?(leaf*)b->children[idx-1]:0;
+  if(rl && rl->num_items>leaf_min_items)
+  {
+    // move the first item of the right sibling to the end of the leaf
+    T *ritems=rl->items();
+    move_construct(l_.items()+l_.num_items++, ritems, 1);
+    move_construct(ritems, ritems+1, --rl->num_items);
+    bkeys[idx].~T();
+    PFC_PNEW(bkeys+idx)T(*ritems);
+    return;
+  }
+  if(ll && ll->num_items>leaf_min_items)
+  {
+    // move the last item of the left sibling to the beginning of the leaf
+    T *items=l_.items();
+    move_construct(items+1, items, l_.num_items++);
+    move_construct(items, ll->items()+--ll->num_items, 1);
+    bkeys[idx-1].~T();
+    PFC_PNEW(bkeys+idx-1)T(*items);
+    return;
+  }
+
+  // merge the leaf with a sibling and remove the separating key from the parent
+  leaf *dst=rl?&l_:ll, *src=rl?rl:&l_;
+  unsigned key_idx=rl?idx:idx-1;
+  move_construct(dst->items()+dst->num_items, src->items(), src->num_items);
+  dst->num_items+=src->num_items;
+  if((dst->next=src->next)!=0)
+    dst->next->prev=dst;
+  m_allocator->free(src);
+  bkeys[key_idx].~T();
+  move_construct(bkeys+key_idx, bkeys+key_idx+1, b->num_keys-key_idx-1);
+  mem_move(b->children+key_idx+1, b->children+key_idx+2, sizeof(void*)*(b->num_keys-key_idx-1));
+  --b->num_keys;
+
+  // restore the minimum occupancy of branches up the path
+  while(depth && b->num_keys<branch_min_keys)
+  {
+    branch *p=path_[--depth];
+    idx=path_idx_[depth];
+    T *pkeys=p->keys(), *keys=b->keys();
+    branch *rb=idx<p->num_keys?(branch*)p->children[idx+1]:0;
+    branch *lb=idx?(branch*)p->children[idx-1]:0;
+    if(rb && rb->num_keys>branch_min_keys)
+    {
+      // rotate the first key & child of the right sibling through the parent
+      T *rkeys=rb->keys();
+      move_construct(keys+b->num_keys, pkeys+idx, 1);
+      b->children[++b->num_keys]=rb->children[0];
+      move_construct(pkeys+idx, rkeys, 1);
+      move_construct(rkeys, rkeys+1, --rb->num_keys);
+      mem_move(rb->children, rb->children+1, sizeof(void*)*(rb->num_keys+1));
+      return;
+    }
+    if(lb && lb->num_keys>branch_min_keys)
+    {
+      // rotate the last key & child of the left sibling through the parent
+      move_construct(keys+1, keys, b->num_keys);
+      mem_move(b->children+1, b->children, sizeof(void*)*(b->num_keys+1));
+      move_construct(keys, pkeys+idx-1, 1);
+      b->children[0]=lb->children[lb->num_keys];
+      ++b->num_keys;
+      move_construct(pkeys+idx-1, lb->keys()+--lb->num_keys, 1);
+      return;
+    }
+
+    // merge the branch with a sibling and the separating key of the parent
+    branch *bdst=rb?b:lb, *bsrc=rb?rb:b;
+    key_idx=rb?idx:idx-1;
+    T *dkeys=bdst->keys();
+    move_construct(dkeys+bdst->num_keys, pkeys+key_idx, 1);
+    move_construct(dkeys+bdst->num_keys+1, bsrc->keys(), bsrc->num_keys);
+    mem_copy(bdst->children+bdst->num_keys+1, bsrc->children, sizeof(void*)*(bsrc->num_keys+1));
+    bdst->num_keys+=bsrc->num_keys+1;
+    m_allocator->free(bsrc);
+    move_construct(pkeys+key_idx, pkeys+key_idx+1, p->num_keys-key_idx-1);
+    mem_move(p->children+key_idx+1, p->children+key_idx+2, sizeof(void*)*(p->num_keys-key_idx-1));
+    --p->num_keys;
+    b=p;
+  }
+
+  // collapse empty root branch
+  if(!depth && !b->num_keys)
+  {
+    m_root=b->children[0];
+    m_allocator->free(b);
+    --m_depth;
+  }
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::restore_rb_property_after_insert(node *n_)
+template<typename K>
+typename btree_set<T, CmpPred>::leaf *btree_set<T, CmpPred>::find_leaf(const K &k_, branch **path_, unsigned *path_idx_) const
 {
-  // restore RB-tree property after node insertion
-  while(n_!=m_root && n_->parent->color)
+  // descend from the root to the leaf covering the key and store the path
+  void *n=m_root;
+  for(unsigned d=0; d<m_depth; ++d)
   {
-    node *grandparent=n_->parent->parent;
-    bool is_left_parent=n_->parent==grandparent->children[0];
-    node *y=grandparent->children[is_left_parent];
-    if(y && y->color)
-    {
-      // change colors
-      n_->parent->color=0;
-      y->color=0;
-      grandparent->color=1;
-      n_=grandparent;
-    }
-    else
+    branch *b=(branch*)n;
+    unsigned idx=upper_idx(b->keys(), b->num_keys, k_);
+    if(path_)
     {
-      if(n_==n_->parent->children[is_left_parent])
-      {
-        // move node up and rotate
-        n_=n_->parent;
-        rotate_subtree(*n_, !is_left_parent);
-        grandparent=n_->parent->parent;
-      }
-      n_->parent->color=0;
-      grandparent->color=1;
-      rotate_subtree(*grandparent, is_left_parent);
+      path_[d]=b;
+      path_idx_[d]=idx;
     }
+    n=b->children[idx];
   }
-  m_root->color=0;
+  return (leaf*)n;
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::validate_rb_state(node *n_, unsigned depth_, unsigned &max_depth_) const
+template<typename K>
+unsigned btree_set<T, CmpPred>::lower_idx(const T *items_, unsigned num_items_, const K &k_) const
 {
-  if(!n_)
-    return;
-  max_depth_=max(depth_, max_depth_);
-  if(n_->color)
+  // binary search the first item not before the key
+  if(!num_items_)
+    return 0;
+  unsigned idx=0;
+  while(num_items_>1)
   {
-    PFC_ASSERT(   (!n_->children[0] || !n_->children[0]->color)
-               && (!n_->children[1] || !n_->children[1]->color));
+    unsigned half=num_items_>>1;
+    idx=m_cmp_pred.before(items_[idx+half-1], k_)?idx+half:idx;
+    num_items_-=half;
   }
-  validate_rb_state(n_->children[0], depth_+1, max_depth_);
-  validate_rb_state(n_->children[1], depth_+1, max_depth_);
+  return idx+m_cmp_pred.before(items_[idx], k_);
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::validate_rb_state() const
+template<typename K>
+unsigned btree_set<T, CmpPred>::upper_idx(const T *items_, unsigned num_items_, const K &k_) const
 {
-  unsigned max_depth=0;
-  validate_rb_state(m_root, 1, max_depth);
-  PFC_ASSERT(max_depth<=2.0f*std::log(m_size+1)*1.44269504089f);
+  // binary search the first item after the key
+  if(!num_items_)
+    return 0;
+  unsigned idx=0;
+  while(num_items_>1)
+  {
+    unsigned half=num_items_>>1;
+    idx=!m_cmp_pred.before(k_, items_[idx+half-1])?idx+half:idx;
+    num_items_-=half;
+  }
+  return idx+!m_cmp_pred.before(k_, items_[idx]);
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::restore_rb_property_after_remove(node *n_, node *parent_, bool is_left_child_)
+void btree_set<T, CmpPred>::validate_btree_state(const void *n_, unsigned depth_, const T *min_, const T *max_, usize_t &num_items_, const leaf *&prev_leaf_) const
 {
-  // restore RB-tree property after node removal
-  while(n_!=m_root && (!n_ || !n_->color))
+  if(depth_<m_depth)
   {
-    node *w=parent_->children[is_left_child_];
-    if(w->color)
-    {
-      w->color=0;
-      parent_->color=1;
-      rotate_subtree(*parent_, !is_left_child_);
-      w=parent_->children[is_left_child_];
-    }
-    bool is_child0_black=!w->children[is_left_child_] || !w->children[is_left_child_]->color;
-    if(is_child0_black && (!w->children[!is_left_child_] || !w->children[!is_left_child_]->color))
+    // check branch keys and children
+    branch *b=(branch*)n_;
+    const T *keys=b->keys();
+    PFC_ASSERT(b->num_keys<=branch_capacity && b->num_keys>=(depth_?unsigned(branch_min_keys):1));
+    for(unsigned i=0; i<b->num_keys; ++i)
     {
-      w->color=1;
-      n_=parent_;
-      parent_=n_->parent;
-      if(parent_)
-        is_left_child_=n_==parent_->children[0];
+      PFC_ASSERT(!i || m_cmp_pred.before(keys[i-1], keys[i]));
+      PFC_ASSERT(!min_ || !m_cmp_pred.before(keys[i], *min_));
+      PFC_ASSERT(!max_ || m_cmp_pred.before(keys[i], *max_));
     }
-    else
+    for(unsigned i=0; i<=b->num_keys; ++i)
+      validate_btree_state(b->children[i], depth_+1, i?keys+i-1:min_, i<b->num_keys?keys+i:max_, num_items_, prev_leaf_);
+  }
+  else
+  {
+    // check leaf items and links
+    leaf *l=(leaf*)n_;
+    const T *items=l->items();
+    PFC_ASSERT(l->num_items<=leaf_capacity && l->num_items>=(depth_?unsigned(leaf_min_items):1));
+    PFC_ASSERT(l->prev==prev_leaf_ && (!prev_leaf_ || prev_leaf_->next==l));
+    for(unsigned i=0; i<l->num_items; ++i)
     {
-      if(is_child0_black)
-      {
-        w->children[!is_left_child_]->color=0;
-        w->color=1;
-        rotate_subtree(*w, is_left_child_);
-        w=parent_->children[is_left_child_];
-      }
-      w->color=parent_->color;
-      parent_->color=0;
-      w->children[is_left_child_]->color=0;
-      rotate_subtree(*parent_, !is_left_child_);
-      n_=m_root;
+      PFC_ASSERT(!i || m_cmp_pred.before(items[i-1], items[i]));
+      PFC_ASSERT(!min_ || !m_cmp_pred.before(items[i], *min_));
+      PFC_ASSERT(!max_ || m_cmp_pred.before(items[i], *max_));
     }
+    num_items_+=l->num_items;
+    prev_leaf_=l;
   }
-  if(n_)
-    n_->color=0;
 }
 //----------------------------------------------------------------------------
 
 
 //============================================================================
-// set::const_iterator
+// btree_set::const_iterator
 //============================================================================
 template<typename T, class CmpPred>
-set<T, CmpPred>::const_iterator::const_iterator()
-  :m_node(0)
+btree_set<T, CmpPred>::const_iterator::const_iterator()
+  :m_leaf(0)
+  ,m_idx(0)
 {
 }
 //----
 
 template<typename T, class CmpPred>
-set<T, CmpPred>::const_iterator::const_iterator(const iterator &it_)
-  :m_node(it_.m_node)
+btree_set<T, CmpPred>::const_iterator::const_iterator(const iterator &it_)
+  :m_leaf(it_.m_leaf)
+  ,m_idx(it_.m_idx)
 {
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::const_iterator::reset()
+void btree_set<T, CmpPred>::const_iterator::reset()
 {
-  m_node=0;
+  m_leaf=0;
+  m_idx=0;
 }
 //----------------------------------------------------------------------------
 
 template<typename T, class CmpPred>
-bool set<T, CmpPred>::const_iterator::operator==(const const_iterator &it_) const
+bool btree_set<T, CmpPred>::const_iterator::operator==(const const_iterator &it_) const
 {
-  return m_node==it_.m_node;
+  return m_leaf==it_.m_leaf && m_idx==it_.m_idx;
 }
 //----
 
 template<typename T, class CmpPred>
-bool set<T, CmpPred>::const_iterator::operator==(const iterator &it_) const
+bool btree_set<T, CmpPred>::const_iterator::operator==(const iterator &it_) const
 {
-  return m_node==it_.m_node;
+  return m_leaf==it_.m_leaf && m_idx==it_.m_idx;
 }
 //----
 
 template<typename T, class CmpPred>
-bool set<T, CmpPred>::const_iterator::operator!=(const const_iterator &it_) const
+bool btree_set<T, CmpPred>::const_iterator::operator!=(const const_iterator &it_) const
 {
-  return m_node!=it_.m_node;
+  return m_leaf!=it_.m_leaf || m_idx!=it_.m_idx;
 }
 //----
 
 template<typename T, class CmpPred>
-bool set<T, CmpPred>::const_iterator::operator!=(const iterator &it_) const
+bool btree_set<T, CmpPred>::const_iterator::operator!=(const iterator &it_) const
 {
-  return m_node!=it_.m_node;
+  return m_leaf!=it_.m_leaf || m_idx!=it_.m_idx;
 }
 //----
 
 template<typename T, class CmpPred>
-typename set<T, CmpPred>::const_iterator &set<T, CmpPred>::const_iterator::operator++()
+typename btree_set<T, CmpPred>::const_iterator &btree_set<T, CmpPred>::const_iterator::operator++()
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  const node *n=m_node->children[1];
-  if(n)
-  {
-    // find left-most node under right child
-    do
-    {
-      m_node=n;
-      n=n->children[0];
-    } while(n);
-  }
-  else
+  // proceed to the next item in the leaf or to the next leaf
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  if(++m_idx==m_leaf->num_items)
   {
-    // traverse right sub-tree up
-    while(m_node->parent && m_node->parent->children[1]==m_node)
-      m_node=m_node->parent;
-    m_node=m_node->parent;
+    m_leaf=m_leaf->next;
+    m_idx=0;
   }
   return *this;
 }
 //----
 
 template<typename T, class CmpPred>
-const T &set<T, CmpPred>::const_iterator::operator*() const
+const T &btree_set<T, CmpPred>::const_iterator::operator*() const
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  return m_node->data;
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  return m_leaf->items()[m_idx];
 }
 //----
 
 template<typename T, class CmpPred>
-const T *set<T, CmpPred>::const_iterator::operator->() const
+const T *btree_set<T, CmpPred>::const_iterator::operator->() const
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  return &m_node->data;
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  return m_leaf->items()+m_idx;
 }
 //----------------------------------------------------------------------------
 
 template<typename T, class CmpPred>
-set<T, CmpPred>::const_iterator::const_iterator(const node *n_)
-  :m_node(n_)
+btree_set<T, CmpPred>::const_iterator::const_iterator(leaf *l_, unsigned idx_)
+  :m_leaf(l_)
+  ,m_idx(idx_)
 {
 }
 //----------------------------------------------------------------------------
 
 
 //============================================================================
-// set::iterator
+// btree_set::iterator
 //============================================================================
 template<typename T, class CmpPred>
-set<T, CmpPred>::iterator::iterator()
-  :m_node(0)
+btree_set<T, CmpPred>::iterator::iterator()
+  :m_leaf(0)
+  ,m_idx(0)
 {
 }
 //----
 
 template<typename T, class CmpPred>
-void set<T, CmpPred>::iterator::reset()
+void btree_set<T, CmpPred>::iterator::reset()
 {
-  m_node=0;
+  m_leaf=0;
+  m_idx=0;
 }
 //----------------------------------------------------------------------------
 
 template<typename T, class CmpPred>
-bool set<T, CmpPred>::iterator::operator==(const const_iterator &it_) const
+bool btree_set<T, CmpPred>::iterator::operator==(const const_iterator &it_) const
 {
-  return m_node==it_.m_node;
+  return m_leaf==it_.m_leaf && m_idx==it_.m_idx;
 }
 //----
 
 template<typename T, class CmpPred>
-bool set<T, CmpPred>::iterator::operator==(const iterator &it_) const
+bool btree_set<T, CmpPred>::iterator::operator==(const iterator &it_) const
 {
-  return m_node==it_.m_node;
+  return m_leaf==it_.m_leaf && m_idx==it_.m_idx;
 }
 //----
 
 template<typename T, class CmpPred>
-bool set<T, CmpPred>::iterator::operator!=(const const_iterator &it_) const
+bool btree_set<T, CmpPred>::iterator::operator!=(const const_iterator &it_) const
 {
-  return m_node!=it_.m_node;
+  return m_leaf!=it_.m_leaf || m_idx!=it_.m_idx;
 }
 //----
 
 template<typename T, class CmpPred>
-bool set<T, CmpPred>::iterator::operator!=(const iterator &it_) const
+bool btree_set<T, CmpPred>::iterator::operator!=(const iterator &it_) const
 {
-  return m_node!=it_.m_node;
+  return m_leaf!=it_.m_leaf || m_idx!=it_.m_idx;
 }
 //----
 
 template<typename T, class CmpPred>
-typename set<T, CmpPred>::iterator &set<T, CmpPred>::iterator::operator++()
+typename btree_set<T, CmpPred>::iterator &btree_set<T, CmpPred>::iterator::operator++()
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  node *n=m_node->children[1];
-  if(n)
-  {
-    // find left-most node under right child
-    do
-    {
-      m_node=n;
-      n=n->children[0];
-    } while(n);
-  }
-  else
+  // proceed to the next item in the leaf or to the next leaf
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  if(++m_idx==m_leaf->num_items)
   {
-    // traverse right sub-tree up
-    while(m_node->parent && m_node->parent->children[1]==m_node)
-      m_node=m_node->parent;
-    m_node=m_node->parent;
+    m_leaf=m_leaf->next;
+    m_idx=0;
   }
   return *this;
 }
 //----
 
 template<typename T, class CmpPred>
-const T &set<T, CmpPred>::iterator::operator*() const
+const T &btree_set<T, CmpPred>::iterator::operator*() const
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  return m_node->data;
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  return m_leaf->items()[m_idx];
 }
 //----
 
 template<typename T, class CmpPred>
-const T *set<T, CmpPred>::iterator::operator->() const
+const T *btree_set<T, CmpPred>::iterator::operator->() const
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  return &m_node->data;
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  return m_leaf->items()+m_idx;
 }
 //----------------------------------------------------------------------------
 
 template<typename T, class CmpPred>
-set<T, CmpPred>::iterator::iterator(node *n_)
-  :m_node(n_)
+btree_set<T, CmpPred>::iterator::iterator(leaf *l_, unsigned idx_)
+  :m_leaf(l_)
+  ,m_idx(idx_)
 {
 }
 //----------------------------------------------------------------------------
 
 
 //============================================================================
-// map
+// btree_map
 //============================================================================
-PFC_INTROSPEC_INL_TDEF3(typename K, typename T, class CmpPred, map<K, T, CmpPred>)
+PFC_INTROSPEC_INL_TDEF3(typename K, typename T, class CmpPred, btree_map<K, T, CmpPred>)
 {
   PFC_CUSTOM_STREAMING(0);
   switch(unsigned(PE::pe_type))
@@ -4691,33 +7166,13 @@ PFC_INTROSPEC_INL_TDEF3(typename K, typename T, class CmpPred, map<K, T, CmpPred
       clear();
       uint32_t size;
       pe_.var(size);
+      K key;
+      T val;
+      item v={key, val};
       for(uint32_t i=0; i<size; ++i)
       {
-        // create new node
-        eh_data<node> p(*m_allocator, 1, map_traits<K, T, CmpPred>::block_alloc_align);
-        node *nn=p.data;
-        PFC_PNEW(&nn->key)K;
-        PFC_PNEW(&nn->val)T;
-        pe_.var(*nn, i?mvarflag_array_tail:0);
-
-        // search for the leaf node where to add the data
-        node *n=m_root, *parent=0, **parent_childptr=&m_root;
-        while(n && !m_cmp_pred.equal(n->key, nn->key))
-        {
-          parent=n;
-          parent_childptr=&n->children[m_cmp_pred.before(n->key, nn->key)];
-          n=*parent_childptr;
-        }
-
-        // add new node
-        nn->color=1;
-        nn->parent=parent;
-        nn->children[0]=0;
-        nn->children[1]=0;
-        *parent_childptr=nn;
-        p.reset();
-        ++m_size;
-        restore_rb_property_after_insert(n);
+        pe_.var(v, i?mvarflag_array_tail:0);
+        insert(key, val);
       }
     } break;
 
@@ -4725,14 +7180,15 @@ PFC_INTROSPEC_INL_TDEF3(typename K, typename T, class CmpPred, map<K, T, CmpPred
     case penum_display:
     {
       // write/display data
-      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize map<%s, %s> that contains more than 2^32-1 elements\r\n", typeid(K).name(), typeid(T).name()));
+      PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize btree_map<%s, %s> that contains more than 2^32-1 elements\r\n", typeid(K).name(), typeid(T).name()));
       uint32_t size=(uint32_t)m_size;
       pe_.var(size, 0, "size");
-      typename map<K, T, CmpPred>::iterator it=begin();
+      typename btree_map<K, T, CmpPred>::iterator it=begin();
       unsigned var_flags=0;
       while(is_valid(it))
       {
-        pe_.var(*it.m_node, var_flags);
+        item v={it.m_leaf->keys()[it.m_idx], it.m_leaf->vals()[it.m_idx]};
+        pe_.var(v, var_flags);
         var_flags=mvarflag_array_tail;
         ++it;
       }
@@ -4742,750 +7198,950 @@ PFC_INTROSPEC_INL_TDEF3(typename K, typename T, class CmpPred, map<K, T, CmpPred
 //----------------------------------------------------------------------------
 
 template<typename K, typename T, class CmpPred>
-map<K, T, CmpPred>::map(const CmpPred &cmp_pred_, memory_allocator_base *alloc_)
+btree_map<K, T, CmpPred>::btree_map(const CmpPred &cmp_pred_, memory_allocator_base *alloc_)
   :m_cmp_pred(cmp_pred_)
   ,m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
 {
-  // init empty map
-  PFC_ASSERT_CALL(m_allocator->check_allocator(map_traits<K, T, CmpPred>::block_alloc_size, map_traits<K, T, CmpPred>::block_alloc_align));
   m_size=0;
   m_root=0;
+  m_depth=0;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-map<K, T, CmpPred>::map(const map &m_)
+btree_map<K, T, CmpPred>::btree_map(const K *sorted_keys_, const T *values_, usize_t num_items_, const CmpPred &cmp_pred_, memory_allocator_base *alloc_)
+  :m_cmp_pred(cmp_pred_)
+  ,m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
+{
+  // build the tree bottom-up from sorted unique keys
+  PFC_MEM_TRACK_STACK();
+  m_size=0;
+  m_root=0;
+  m_depth=0;
+  array_iterator it={sorted_keys_, values_};
+  bulk_load(it, num_items_);
+}
+//----
+
+template<typename K, typename T, class CmpPred>
+btree_map<K, T, CmpPred>::btree_map(const btree_map &m_)
   :m_cmp_pred(m_.m_cmp_pred)
   ,m_allocator(&default_memory_allocator::inst())
 {
   PFC_MEM_TRACK_STACK();
-  cctor(m_);
+  m_size=0;
+  m_root=0;
+  m_depth=0;
+  bulk_load(m_.begin(), m_.m_size);
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-map<K, T, CmpPred>::map(const map &m_, memory_allocator_base *alloc_)
+btree_map<K, T, CmpPred>::btree_map(const btree_map &m_, memory_allocator_base *alloc_)
   :m_cmp_pred(m_.m_cmp_pred)
   ,m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
 {
   PFC_MEM_TRACK_STACK();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(map_traits<K, T, CmpPred>::block_alloc_size, map_traits<K, T, CmpPred>::block_alloc_align));
-  cctor(m_);
+  m_size=0;
+  m_root=0;
+  m_depth=0;
+  bulk_load(m_.begin(), m_.m_size);
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-map<K, T, CmpPred>::~map()
+btree_map<K, T, CmpPred>::~btree_map()
 {
   clear();
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::operator=(const map &m_)
+void btree_map<K, T, CmpPred>::operator=(const btree_map &m_)
 {
-  map m(m_);
+  btree_map m(m_);
   swap(m);
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::set_allocator(memory_allocator_base *alloc_)
+void btree_map<K, T, CmpPred>::set_allocator(memory_allocator_base *alloc_)
 {
-  PFC_ASSERT_MSG(!m_size, ("Unable to change the allocator of a non-empty map\r\n"));
+  PFC_ASSERT_MSG(!m_size, ("Unable to change the allocator of a non-empty btree_map\r\n"));
   m_allocator=alloc_?alloc_:&default_memory_allocator::inst();
-  PFC_ASSERT_CALL(m_allocator->check_allocator(map_traits<K, T, CmpPred>::block_alloc_size, map_traits<K, T, CmpPred>::block_alloc_align));
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::clear()
+void btree_map<K, T, CmpPred>::clear()
 {
   // recursively destroy nodes
   if(m_root)
   {
-    destroy_subtree(*m_root);
+    destroy_subtree(m_root, 0);
     m_root=0;
+    m_depth=0;
     m_size=0;
   }
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::swap(map &m_)
+void btree_map<K, T, CmpPred>::swap(btree_map &m_)
 {
   // swap content of maps
   pfc::swap(m_cmp_pred, m_.m_cmp_pred);
   pfc::swap(m_allocator, m_.m_allocator);
   pfc::swap(m_size, m_.m_size);
   pfc::swap(m_root, m_.m_root);
-}
-//----------------------------------------------------------------------------
-
-template<typename K, typename T, class CmpPred>
-memory_allocator_base &map<K, T, CmpPred>::allocator() const
-{
-  return *m_allocator;
-}
-//----
-
-template<typename K, typename T, class CmpPred>
-usize_t map<K, T, CmpPred>::size() const
-{
-  return m_size;
+  pfc::swap(m_depth, m_.m_depth);
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-template<typename K1>
-const T &map<K, T, CmpPred>::operator[](const K1 &k_) const
+void btree_map<K, T, CmpPred>::validate_btree_state() const
 {
-  // search key from the map and return the associated value
-  const node *n=m_root;
-  while(n && !m_cmp_pred.equal(n->key, k_))
-    n=n->children[m_cmp_pred.before(n->key, k_)];
-  PFC_ASSERT_MSG(n, ("Key not found from the map\r\n"));
-  return n->val;
+  // check node occupancy, key order and leaf links
+  if(!m_root)
+  {
+    PFC_ASSERT(!m_size && !m_depth);
+    return;
+  }
+  usize_t num_items=0;
+  const leaf *prev_leaf=0;
+  validate_btree_state(m_root, 0, 0, 0, num_items, prev_leaf);
+  PFC_ASSERT(num_items==m_size);
+  PFC_ASSERT(!prev_leaf->next);
+}
+//----------------------------------------------------------------------------
+
+template<typename K, typename T, class CmpPred>
+memory_allocator_base &btree_map<K, T, CmpPred>::allocator() const
+{
+  return *m_allocator;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-template<typename K1>
-T &map<K, T, CmpPred>::operator[](const K1 &k_)
+usize_t btree_map<K, T, CmpPred>::size() const
 {
-  // search key from the map and return the associated value
-  node *n=m_root;
-  while(n && !m_cmp_pred.equal(n->key, k_))
-    n=n->children[m_cmp_pred.before(n->key, k_)];
-  PFC_ASSERT_MSG(n, ("Key not found from the map\r\n"));
-  return n->val;
+  return m_size;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
 template<typename K1>
-typename map<K, T, CmpPred>::const_iterator map<K, T, CmpPred>::find(const K1 &k_) const
+const T &btree_map<K, T, CmpPred>::operator[](const K1 &k_) const
 {
-  // search key from the map and return iteration that points to it
-  const node *n=m_root;
-  while(n && !m_cmp_pred.equal(n->key, k_))
-    n=n->children[m_cmp_pred.before(n->key, k_)];
-  return const_iterator(n);
+  // search for the value with given key
+  leaf *l=find_leaf(k_);
+  PFC_ASSERT_PEDANTIC(l);
+  unsigned idx=lower_idx(l->keys(), l->num_items, k_);
+  PFC_ASSERT_PEDANTIC_MSG(idx<l->num_items && m_cmp_pred.equal(l->keys()[idx], k_), ("No item with the given key in the btree_map\r\n"));
+  return l->vals()[idx];
 }
 //----
 
 template<typename K, typename T, class CmpPred>
 template<typename K1>
-typename map<K, T, CmpPred>::iterator map<K, T, CmpPred>::find(const K1 &k_)
+T &btree_map<K, T, CmpPred>::operator[](const K1 &k_)
 {
-  // search key from the map and return iteration that points to it
-  node *n=m_root;
-  while(n && !m_cmp_pred.equal(n->key, k_))
-    n=n->children[m_cmp_pred.before(n->key, k_)];
-  return iterator(n);
+  // search for the value with given key
+  leaf *l=find_leaf(k_);
+  PFC_ASSERT_PEDANTIC(l);
+  unsigned idx=lower_idx(l->keys(), l->num_items, k_);
+  PFC_ASSERT_PEDANTIC_MSG(idx<l->num_items && m_cmp_pred.equal(l->keys()[idx], k_), ("No item with the given key in the btree_map\r\n"));
+  return l->vals()[idx];
 }
 //----
 
 template<typename K, typename T, class CmpPred>
 template<typename K1>
-typename map<K, T, CmpPred>::const_iterator map<K, T, CmpPred>::lower_bound(const K1 &k_) const
+typename btree_map<K, T, CmpPred>::const_iterator btree_map<K, T, CmpPred>::find(const K1 &k_) const
 {
-  // return iterator to the closest less-or-equal value in the set
-  const node *n=m_root, *prev=0;
-  while(n)
-    if(m_cmp_pred.before(k_, n->key))
-      n=n->children[0];
-    else
-    {
-      prev=n;
-      if(!m_cmp_pred.before(n->key, k_))
-        break;
-      n=n->children[1];
-    }
-  return const_iterator(prev);
+  // search for the key from the leaf covering the key
+  if(leaf *l=find_leaf(k_))
+  {
+    unsigned idx=lower_idx(l->keys(), l->num_items, k_);
+    if(idx<l->num_items && m_cmp_pred.equal(l->keys()[idx], k_))
+      return const_iterator(l, idx);
+  }
+  return const_iterator();
 }
 //----
 
 template<typename K, typename T, class CmpPred>
 template<typename K1>
-typename map<K, T, CmpPred>::iterator map<K, T, CmpPred>::lower_bound(const K1 &k_)
+typename btree_map<K, T, CmpPred>::iterator btree_map<K, T, CmpPred>::find(const K1 &k_)
 {
-  // return iterator to the closest less-or-equal value in the set
-  node *n=m_root, *prev=0;
-  while(n)
-    if(m_cmp_pred.before(k_, n->key))
-      n=n->children[0];
-    else
-    {
-      prev=n;
-      if(!m_cmp_pred.before(n->key, k_))
-        break;
-      n=n->children[1];
-    }
-  return iterator(prev);
+  // search for the key from the leaf covering the key
+  if(leaf *l=find_leaf(k_))
+  {
+    unsigned idx=lower_idx(l->keys(), l->num_items, k_);
+    if(idx<l->num_items && m_cmp_pred.equal(l->keys()[idx], k_))
+      return iterator(l, idx);
+  }
+  return iterator();
 }
 //----
 
 template<typename K, typename T, class CmpPred>
 template<typename K1>
-typename map<K, T, CmpPred>::const_iterator map<K, T, CmpPred>::upper_bound(const K1 &k_) const
+typename btree_map<K, T, CmpPred>::const_iterator btree_map<K, T, CmpPred>::lower_bound(const K1 &k_) const
 {
-  // return iterator to the closest greater value in the set
-  const node *n=m_root, *prev=0;
-  while(n)
-    if(!m_cmp_pred.before(k_, n->key))
-      n=n->children[1];
-    else
-    {
-      prev=n;
-      n=n->children[0];
-    }
-  return const_iterator(prev);
+  // return iterator to the closest less-or-equal key in the map
+  if(leaf *l=find_leaf(k_))
+  {
+    if(unsigned idx=upper_idx(l->keys(), l->num_items, k_))
+      return const_iterator(l, idx-1);
+    if(l->prev)
+      return const_iterator(l->prev, l->prev->num_items-1);
+  }
+  return const_iterator();
 }
 //----
 
 template<typename K, typename T, class CmpPred>
 template<typename K1>
-typename map<K, T, CmpPred>::iterator map<K, T, CmpPred>::upper_bound(const K1 &k_)
+typename btree_map<K, T, CmpPred>::iterator btree_map<K, T, CmpPred>::lower_bound(const K1 &k_)
 {
-  // return iterator to the closest greater value in the set
-  node *n=m_root, *prev=0;
-  while(n)
-    if(!m_cmp_pred.before(k_, n->key))
-      n=n->children[1];
-    else
-    {
-      prev=n;
-      n=n->children[0];
-    }
-  return iterator(prev);
+  // return iterator to the closest less-or-equal key in the map
+  if(leaf *l=find_leaf(k_))
+  {
+    if(unsigned idx=upper_idx(l->keys(), l->num_items, k_))
+      return iterator(l, idx-1);
+    if(l->prev)
+      return iterator(l->prev, l->prev->num_items-1);
+  }
+  return iterator();
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-typename map<K, T, CmpPred>::const_iterator map<K, T, CmpPred>::begin() const
+template<typename K1>
+typename btree_map<K, T, CmpPred>::const_iterator btree_map<K, T, CmpPred>::upper_bound(const K1 &k_) const
 {
-  // return iterator to the left-most node
-  const node *n=m_root, *prev=0;
-  while(n)
+  // return iterator to the closest greater key in the map
+  if(leaf *l=find_leaf(k_))
   {
-    prev=n;
-    n=n->children[0];
+    unsigned idx=upper_idx(l->keys(), l->num_items, k_);
+    if(idx<l->num_items)
+      return const_iterator(l, idx);
+    if(l->next)
+      return const_iterator(l->next, 0);
   }
-  return const_iterator(prev);
+  return const_iterator();
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-typename map<K, T, CmpPred>::iterator map<K, T, CmpPred>::begin()
+template<typename K1>
+typename btree_map<K, T, CmpPred>::iterator btree_map<K, T, CmpPred>::upper_bound(const K1 &k_)
 {
-  // return iterator to the left-most node
-  node *n=m_root, *prev=0;
-  while(n)
+  // return iterator to the closest greater key in the map
+  if(leaf *l=find_leaf(k_))
   {
-    prev=n;
-    n=n->children[0];
+    unsigned idx=upper_idx(l->keys(), l->num_items, k_);
+    if(idx<l->num_items)
+      return iterator(l, idx);
+    if(l->next)
+      return iterator(l->next, 0);
   }
-  return iterator(prev);
+  return iterator();
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-typename map<K, T, CmpPred>::const_iterator map<K, T, CmpPred>::end() const
+typename btree_map<K, T, CmpPred>::const_iterator btree_map<K, T, CmpPred>::begin() const
 {
-  return const_iterator(0);
+  // return iterator to the first item of the left-most leaf
+  void *n=m_root;
+  for(unsigned d=0; d<m_depth; ++d)
+    n=((branch*)n)->children[0];
+  return const_iterator((leaf*)n, 0);
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-typename map<K, T, CmpPred>::iterator map<K, T, CmpPred>::end()
+typename btree_map<K, T, CmpPred>::iterator btree_map<K, T, CmpPred>::begin()
 {
-  return iterator(0);
+  // return iterator to the first item of the left-most leaf
+  void *n=m_root;
+  for(unsigned d=0; d<m_depth; ++d)
+    n=((branch*)n)->children[0];
+  return iterator((leaf*)n, 0);
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-typename map<K, T, CmpPred>::inserter map<K, T, CmpPred>::insert(const K &k_, const T &v_, bool replace_)
+typename btree_map<K, T, CmpPred>::const_iterator btree_map<K, T, CmpPred>::end() const
 {
-  // search for the leaf node where to add the data
-  node *n=m_root, *parent=0, **parent_childptr=&m_root;
-  while(n && !m_cmp_pred.equal(n->key, k_))
-  {
-    parent=n;
-    parent_childptr=&n->children[m_cmp_pred.before(n->key, k_)];
-    n=*parent_childptr;
-  }
-
-  bool is_new=!n;
-  if(is_new)
-  {
-    // add new node
-    eh_data<node> p(*m_allocator, 1, map_traits<K, T, CmpPred>::block_alloc_align);
-    n=p.data;
-    PFC_PNEW(&n->key)K(k_);
-    PFC_PNEW(&n->val)T(v_);
-    n->color=1;
-    n->parent=parent;
-    n->children[0]=0;
-    n->children[1]=0;
-    *parent_childptr=n;
-    p.reset();
-    ++m_size;
-    restore_rb_property_after_insert(n);
-  }
-  else
-    if(replace_)
-    {
-      // replace existing node data with new one
-      n->val.~T();
-      PFC_PNEW(&n->val)T(v_);
-    }
-  inserter ins={iterator(n), is_new};
-  return ins;
+  return const_iterator();
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-typename map<K, T, CmpPred>::inserter map<K, T, CmpPred>::insert(const K &k_, bool replace_)
+typename btree_map<K, T, CmpPred>::iterator btree_map<K, T, CmpPred>::end()
 {
-  // search for the leaf node where to add the data
-  node *n=m_root, *parent=0, **parent_childptr=&m_root;
-  while(n && !m_cmp_pred.equal(n->key, k_))
-  {
-    parent=n;
-    parent_childptr=&n->children[m_cmp_pred.before(n->key, k_)];
-    n=*parent_childptr;
-  }
+  return iterator();
+}
+//----
 
-  bool is_new=!n;
-  if(is_new)
-  {
-    // add new node
-    eh_data<node> p(*m_allocator, 1, map_traits<K, T, CmpPred>::block_alloc_align);
-    n=p.data;
-    PFC_PNEW(&n->key)K(k_);
-    PFC_PNEW(&n->val)T;
-    n->color=1;
-    n->parent=parent;
-    n->children[0]=0;
-    n->children[1]=0;
-    *parent_childptr=n;
-    p.reset();
-    ++m_size;
-    restore_rb_property_after_insert(n);
-  }
-  else
-    if(replace_)
-    {
-      // replace existing node value with new one
-      n->val.~T();
-      PFC_PNEW(&n->val)T;
-    }
-  inserter ins={iterator(n), is_new};
-  return ins;
+template<typename K, typename T, class CmpPred>
+typename btree_map<K, T, CmpPred>::inserter btree_map<K, T, CmpPred>::insert(const K &k_, const T &v_, bool replace_)
+{
+  return insert_item(k_, &v_, replace_);
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::erase(iterator &it_)
+typename btree_map<K, T, CmpPred>::inserter btree_map<K, T, CmpPred>::insert(const K &k_, bool replace_)
 {
-  PFC_ASSERT_PEDANTIC(it_.m_node);
-  node *y=it_.m_node;
-  if(y->children[0] && y->children[1])
-  {
-    // search the left-most child from the right sub-tree
-    y=y->children[1];
-    while(node *child=y->children[0])
-      y=child;
-  }
+  return insert_item(k_, 0, replace_);
+}
+//----
 
-  // remove y from parent chain
-  node *x=y->children[0]?y->children[0]:y->children[1];
-  if(x)
-    x->parent=y->parent;
-  bool is_left_parent=false;
-  if(y->parent)
-  {
-    is_left_parent=y==y->parent->children[0];
-    y->parent->children[!is_left_parent]=x;
-  }
-  else
-    m_root=x;
+template<typename K, typename T, class CmpPred>
+void btree_map<K, T, CmpPred>::erase(iterator &it_)
+{
+  // search path to the leaf of the item
+  PFC_ASSERT_PEDANTIC(it_.m_leaf);
+  branch *path[max_depth];
+  unsigned path_idx[max_depth];
+  leaf *l=find_leaf(it_.m_leaf->keys()[it_.m_idx], path, path_idx);
+  PFC_ASSERT(l==it_.m_leaf);
+
+  // remove the item from the leaf
+  K *keys=l->keys();
+  T *vals=l->vals();
+  unsigned idx=it_.m_idx;
+  keys[idx].~K();
+  vals[idx].~T();
+  unsigned num_moved=--l->num_items-idx;
+  move_construct(keys+idx, keys+idx+1, num_moved);
+  move_construct(vals+idx, vals+idx+1, num_moved);
+  it_.reset();
+  --m_size;
 
-  // restore RB-property if removing black node
-  if(!y->color)
-    restore_rb_property_after_remove(x, y->parent, is_left_parent);
-  if(y!=it_.m_node)
+  // release empty root leaf or restore the minimum occupancy of the leaf
+  if(!m_depth)
   {
-    // replace m_node with y
-    if((y->parent=it_.m_node->parent)!=0)
-      y->parent->children[it_.m_node==y->parent->children[1]]=y;
-    else
-      m_root=y;
-    y->color=it_.m_node->color;
-    if((y->children[0]=it_.m_node->children[0])!=0)
-      y->children[0]->parent=y;
-    if((y->children[1]=it_.m_node->children[1])!=0)
-      y->children[1]->parent=y;
+    if(!l->num_items)
+    {
+      m_allocator->free(l);
+      m_root=0;
+    }
   }
-
-  // delete node
-  it_.m_node->val.~T();
-  it_.m_node->key.~K();
-  m_allocator->free(it_.m_node);
-  it_.m_node=0;
-  --m_size;
+  else if(l->num_items<leaf_min_items)
+    rebalance(path, path_idx, *l);
 }
 //----------------------------------------------------------------------------
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::cctor(const map &m_)
+template<class U>
+void btree_map<K, T, CmpPred>::bulk_load(U it_, usize_t num_items_)
 {
-  // copy-construct the map
-  m_size=m_.m_size;
-  m_root=0;
-  if(m_.m_root)
-    copy_subtree(*m_.m_root, 0, m_root);
+  // build leaves with evenly distributed items
+  if(!num_items_)
+    return;
+  usize_t num_nodes=(num_items_+leaf_capacity-1)/leaf_capacity;
+  array<void*> nodes(num_nodes);
+  array<const K*> node_mins(num_nodes);
+  leaf *prev=0;
+  for(usize_t ni=0; ni<num_nodes; ++ni)
+  {
+    leaf *l=alloc_leaf();
+    K *keys=l->keys();
+    T *vals=l->vals();
+    unsigned num_items=unsigned(num_items_/num_nodes+(ni<num_items_%num_nodes));
+    for(unsigned i=0; i<num_items; ++i, ++it_)
+    {
+      PFC_PNEW(keys+i)K(it_.key());
+      PFC_PNEW(vals+i)T(*it_);
+      PFC_ASSERT_PEDANTIC_MSG((i?keys+i-1:prev?prev->keys()+prev->num_items-1:0)==0 || m_cmp_pred.before(i?keys[i-1]:prev->keys()[prev->num_items-1], keys[i]),
+                              ("Bulk loaded btree_map keys must be sorted and unique\r\n"));
+    }
+    l->num_items=num_items;
+    l->next=0;
+    if((l->prev=prev)!=0)
+      prev->next=l;
+    nodes[ni]=l;
+    node_mins[ni]=keys;
+    prev=l;
+  }
+  m_size=num_items_;
+
+  // build branch levels bottom-up until there's a single root node
+  while(num_nodes>1)
+  {
+    usize_t num_parents=(num_nodes+branch_capacity)/(branch_capacity+1), child_idx=0;
+    for(usize_t ni=0; ni<num_parents; ++ni)
+    {
+      branch *b=alloc_branch();
+      K *keys=b->keys();
+      unsigned num_children=unsigned(num_nodes/num_parents+(ni<num_nodes%num_parents));
+      const K *node_min=node_mins[child_idx];
+      b->children[0]=nodes[child_idx];
+      for(unsigned i=1; i<num_children; ++i)
+      {
+        PFC_PNEW(keys+i-1)K(*node_mins[child_idx+i]);
+        b->children[i]=nodes[child_idx+i];
+      }
+      b->num_keys=num_children-1;
+      nodes[ni]=b;
+      node_mins[ni]=node_min;
+      child_idx+=num_children;
+    }
+    num_nodes=num_parents;
+    ++m_depth;
+  }
+  m_root=nodes[0];
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::copy_subtree(node &n_, node *parent_, node *&child_ptr_)
+typename btree_map<K, T, CmpPred>::leaf *btree_map<K, T, CmpPred>::alloc_leaf()
 {
-  // recursively copy the sub-tree
-  eh_data<node> p(*m_allocator, 1, map_traits<K, T, CmpPred>::block_alloc_align);
-  node *n=p.data;
-  PFC_PNEW(&n->key)K(n_.key);
-  PFC_PNEW(&n->val)T(n_.val);
-  n->color=n_.color;
-  n->parent=parent_;
-  n->children[0]=0;
-  n->children[1]=0;
-  p.reset();
-  child_ptr_=n;
-  if(n_.children[0])
-    copy_subtree(*n_.children[0], n, n->children[0]);
-  if(n_.children[1])
-    copy_subtree(*n_.children[1], n, n->children[1]);
+  return (leaf*)m_allocator->alloc(sizeof(leaf), meta_alignof<leaf>::res);
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::destroy_subtree(node &n_)
+typename btree_map<K, T, CmpPred>::branch *btree_map<K, T, CmpPred>::alloc_branch()
 {
-  // destroy children
-  if(n_.children[0])
-    destroy_subtree(*n_.children[0]);
-  if(n_.children[1])
-    destroy_subtree(*n_.children[1]);
-  n_.val.~T();
-  n_.key.~K();
-  m_allocator->free(&n_);
+  return (branch*)m_allocator->alloc(sizeof(branch), meta_alignof<branch>::res);
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::rotate_subtree(node &n_, bool rotate_right_)
+void btree_map<K, T, CmpPred>::destroy_subtree(void *n_, unsigned depth_)
 {
-  // rotate sub-tree left/right about the node
-  unsigned idx0=rotate_right_, idx1=!rotate_right_;
-  node *y=n_.children[idx1];
-  if((n_.children[idx1]=y->children[idx0])!=0)
-    y->children[idx0]->parent=&n_;
-  node *parent=n_.parent;
-  if((y->parent=parent)!=0)
-    parent->children[&n_==parent->children[idx0]?idx0:idx1]=y;
+  // destroy children and keys/items of the node
+  if(depth_<m_depth)
+  {
+    branch *b=(branch*)n_;
+    for(unsigned i=0; i<=b->num_keys; ++i)
+      destroy_subtree(b->children[i], depth_+1);
+    reverse_destruct(b->keys(), b->num_keys);
+  }
   else
-    m_root=y;
-  y->children[idx0]=&n_;
-  n_.parent=y;
+  {
+    leaf *l=(leaf*)n_;
+    reverse_destruct(l->keys(), l->num_items);
+    reverse_destruct(l->vals(), l->num_items);
+  }
+  m_allocator->free(n_);
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::restore_rb_property_after_insert(node *n_)
+typename btree_map<K, T, CmpPred>::inserter btree_map<K, T, CmpPred>::insert_item(const K &k_, const T *v_, bool replace_)
 {
-  // restore RB-tree property after node insertion
-  while(n_!=m_root && n_->parent->color)
+  // add root leaf for empty map
+  PFC_MEM_TRACK_STACK();
+  if(!m_root)
   {
-    node *grandparent=n_->parent->parent;
-    bool is_left_parent=n_->parent==grandparent->children[0];
-    node *y=grandparent->children[is_left_parent];
-    if(y && y->color)
+    leaf *l=alloc_leaf();
+    l->num_items=0;
+    l->prev=l->next=0;
+    m_root=l;
+  }
+
+  // search for the leaf where to add the item
+  branch *path[max_depth];
+  unsigned path_idx[max_depth];
+  leaf *l=find_leaf(k_, path, path_idx);
+  K *keys=l->keys();
+  T *vals=l->vals();
+  unsigned idx=lower_idx(keys, l->num_items, k_);
+  if(idx<l->num_items && m_cmp_pred.equal(keys[idx], k_))
+  {
+    if(replace_)
     {
-      // change colors
-      n_->parent->color=0;
-      y->color=0;
-      grandparent->color=1;
-      n_=grandparent;
+      // replace existing item value with new one
+      vals[idx].~T();
+      if(v_)
+        PFC_PNEW(vals+idx)T(*v_);
+      else
+        PFC_PNEW(vals+idx)T;
     }
-    else
+    inserter ins={iterator(l, idx), false};
+    return ins;
+  }
+
+  // add the item to the leaf (leaves have one spare slot for overflow)
+  move_construct(keys+idx+1, keys+idx, l->num_items-idx);
+  move_construct(vals+idx+1, vals+idx, l->num_items-idx);
+  PFC_PNEW(keys+idx)K(k_);
+  if(v_)
+    PFC_PNEW(vals+idx)T(*v_);
+  else
+    PFC_PNEW(vals+idx)T;
+  ++m_size;
+  if(++l->num_items>leaf_capacity)
+  {
+    // split the leaf in half and add the new leaf to the parent
+    leaf *r=alloc_leaf();
+    unsigned num_left=l->num_items/2;
+    r->num_items=l->num_items-num_left;
+    move_construct(r->keys(), keys+num_left, r->num_items);
+    move_construct(r->vals(), vals+num_left, r->num_items);
+    l->num_items=num_left;
+    r->prev=l;
+    if((r->next=l->next)!=0)
+      r->next->prev=r;
+    l->next=r;
+    add_separator(path, path_idx, r->keys()[0], r);
+    if(idx>=num_left)
     {
-      if(n_==n_->parent->children[is_left_parent])
-      {
-        // move node up and rotate
-        n_=n_->parent;
-        rotate_subtree(*n_, !is_left_parent);
-        grandparent=n_->parent->parent;
-      }
-      n_->parent->color=0;
-      grandparent->color=1;
-      rotate_subtree(*grandparent, is_left_parent);
+      inserter ins={iterator(r, idx-num_left), true};
+      return ins;
     }
   }
-  m_root->color=0;
+  inserter ins={iterator(l, idx), true};
+  return ins;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::restore_rb_property_after_remove(node *n_, node *parent_, bool is_left_child_)
+void btree_map<K, T, CmpPred>::add_separator(branch *const *path_, const unsigned *path_idx_, const K &key_, void *right_)
+{
+  // add the key and right node to the parent, and split the branches up the path that overflow
+  const K *key=&key_, *moved_key=0;
+  unsigned depth=m_depth;
+  while(depth--)
+  {
+    // insert key & child to the branch (branches have one spare slot for overflow)
+    branch *b=path_[depth];
+    unsigned idx=path_idx_[depth];
+    K *keys=b->keys();
+    move_construct(keys+idx+1, keys+idx, b->num_keys-idx);
+    mem_move(b->children+idx+2, b->children+idx+1, sizeof(void*)*(b->num_keys-idx));
+    PFC_PNEW(keys+idx)K(*key);
+    if(moved_key)
+      moved_key->~K();
+    b->children[idx+1]=right_;
+    if(++b->num_keys<=branch_capacity)
+      return;
+
+    // split the branch and move the middle key up
+    branch *r=alloc_branch();
+    unsigned mid=b->num_keys/2;
+    r->num_keys=b->num_keys-mid-1;
+    move_construct(r->keys(), keys+mid+1, r->num_keys);
+    mem_copy(r->children, b->children+mid+1, sizeof(void*)*(r->num_keys+1));
+    b->num_keys=mid;
+    key=moved_key=keys+mid;
+    right_=r;
+  }
+
+  // add new root
+  PFC_ASSERT(m_depth+1<max_depth);
+  branch *root=alloc_branch();
+  PFC_PNEW(root->keys())K(*key);
+  if(moved_key)
+    moved_key->~K();
+  root->num_keys=1;
+  root->children[0]=m_root;
+  root->children[1]=right_;
+  m_root=root;
+  ++m_depth;
+}
+//----
+
+template<typename K, typename T, class CmpPred>
+void btree_map<K, T, CmpPred>::rebalance(branch *const *path_, const unsigned *path_idx_, leaf &l_)
+{
+  // borrow an item from a sibling leaf if possible
+  unsigned depth=m_depth-1;
+  branch *b=path_[depth];
+  unsigned idx=path_idx_[depth];
+  K *bkeys=b->keys();
+  leaf *rl=idx<b->num_keys?(leaf*)b->children[idx+1]:0;
+  leaf *ll=idx?(leaf*)b->children[idx-1]:0;
+  if(rl && rl->num_items>leaf_min_items)
+  {
+    // move the first item of the right sibling to the end of the leaf
+    K *rkeys=rl->keys();
+    T *rvals=rl->vals();
+    move_construct(l_.keys()+l_.num_items, rkeys, 1);
+    move_construct(l_.vals()+l_.num_items++, rvals, 1);
+    move_construct(rkeys, rkeys+1, --rl->num_items);
+    move_construct(rvals, rvals+1, rl->num_items);
+    bkeys[idx].~K();
+    PFC_PNEW(bkeys+idx)K(*rkeys);
+    return;
+  }
+  if(ll && ll->num_items>leaf_min_items)
+  {
+    // move the last item of the left sibling to the beginning of the leaf
+    K *keys=l_.keys();
+    T *vals=l_.vals();
+    move_construct(keys+1, keys, l_.num_items);
+    move_construct(vals+1, vals, l_.num_items++);
+    move_construct(keys, ll->keys()+--ll->num_items, 1);
+    move_construct(vals, ll->vals()+ll->num_items, 1);
+    bkeys[idx-1].~K();
+    PFC_PNEW(bkeys+idx-1)K(*keys);
+    return;
+  }
+
+  // merge the leaf with a sibling and remove the separating key from the parent
+  leaf *dst=rl?&l_:ll, *src=rl?rl:&l_;
+  unsigned key_idx=rl?idx:idx-1;
+  move_construct(dst->keys()+dst->num_items, src->keys(), src->num_items);
+  move_construct(dst->vals()+dst->num_items, src->vals(), src->num_items);
+  dst->num_items+=src->num_items;
+  if((dst->next=src->next)!=0)
+    dst->next->prev=dst;
+  m_allocator->free(src);
+  bkeys[key_idx].~K();
+  move_construct(bkeys+key_idx, bkeys+key_idx+1, b->num_keys-key_idx-1);
+  mem_move(b->children+key_idx+1, b->children+key_idx+2, sizeof(void*)*(b->num_keys-key_idx-1));
+  --b->num_keys;
+
+  // restore the minimum occupancy of branches up the path
+  while(depth && b->num_keys<branch_min_keys)
+  {
+    branch *p=path_[--depth];
+    idx=path_idx_[depth];
+    K *pkeys=p->keys(), *keys=b->keys();
+    branch *rb=idx<p->num_keys?(branch*)p->children[idx+1]:0;
+    branch *lb=idx?(branch*)p->children[idx-1]:0;
+    if(rb && rb->num_keys>branch_min_keys)
+    {
+      // rotate the first key & child of the right sibling through the parent
+      K *rkeys=rb->keys();
+      move_construct(keys+b->num_keys, pkeys+idx, 1);
+      b->children[++b->num_keys]=rb->children[0];
+      move_construct(pkeys+idx, rkeys, 1);
+      move_construct(rkeys, rkeys+1, --rb->num_keys);
+      mem_move(rb->children, rb->children+1, sizeof(void*)*(rb->num_keys+1));
+      return;
+    }
+    if(lb && lb->num_keys>branch_min_keys)
+    {
+      // rotate the last key & child of the left sibling through the parent
+      move_construct(keys+1, keys, b->num_keys);
+      mem_move(b->children+1, b->children, sizeof(void*)*(b->num_keys+1));
+      move_construct(keys, pkeys+idx-1, 1);
+      b->children[0]=lb->children[lb->num_keys];
+      ++b->num_keys;
+      move_construct(pkeys+idx-1, lb->keys()+--lb->num_keys, 1);
+      return;
+    }
+
+    // merge the branch with a sibling and the separating key of the parent
+    branch *bdst=rb?b:lb, *bsrc=rb?rb:b;
+    key_idx=rb?idx:idx-1;
+    K *dkeys=bdst->keys();
+    move_construct(dkeys+bdst->num_keys, pkeys+key_idx, 1);
+    move_construct(dkeys+bdst->num_keys+1, bsrc->keys(), bsrc->num_keys);
+    mem_copy(bdst->children+bdst->num_keys+1, bsrc->children, sizeof(void*)*(bsrc->num_keys+1));
+    bdst->num_keys+=bsrc->num_keys+1;
+    m_allocator->free(bsrc);
+    move_construct(pkeys+key_idx, pkeys+key_idx+1, p->num_keys-key_idx-1);
+    mem_move(p->children+key_idx+1, p->children+key_idx+2, sizeof(void*)*(p->num_keys-key_idx-1));
+    --p->num_keys;
+    b=p;
+  }
+
+  // collapse empty root branch
+  if(!depth && !b->num_keys)
+  {
+    m_root=b->children[0];
+    m_allocator->free(b);
+    --m_depth;
+  }
+}
+//----
+
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+typename btree_map<K, T, CmpPred>::leaf *btree_map<K, T, CmpPred>::find_leaf(const K1 &k_, branch **path_, unsigned *path_idx_) const
 {
-  // restore RB-tree property after node removal
-  while(n_!=m_root && (!n_ || !n_->color))
+  // descend from the root to the leaf covering the key and store the path
+  void *n=m_root;
+  for(unsigned d=0; d<m_depth; ++d)
   {
-    node *w=parent_->children[is_left_child_];
-    if(w->color)
+    branch *b=(branch*)n;
+    unsigned idx=upper_idx(b->keys(), b->num_keys, k_);
+    if(path_)
     {
-      w->color=0;
-      parent_->color=1;
-      rotate_subtree(*parent_, !is_left_child_);
-      w=parent_->children[is_left_child_];
+      path_[d]=b;
+      path_idx_[d]=idx;
     }
-    bool is_child0_black=!w->children[is_left_child_] || !w->children[is_left_child_]->color;
-    if(is_child0_black && (!w->children[!is_left_child_] || !w->children[!is_left_child_]->color))
+    n=b->children[idx];
+  }
+  return (leaf*)n;
+}
+//----
+
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+unsigned btree_map<K, T, CmpPred>::lower_idx(const K *keys_, unsigned num_keys_, const K1 &k_) const
+{
+  // binary search the first key not before the key
+  if(!num_keys_)
+    return 0;
+  unsigned idx=0;
+  while(num_keys_>1)
+  {
+    unsigned half=num_keys_>>1;
+    idx=m_cmp_pred.before(keys_[idx+half-1], k_)?idx+half:idx;
+    num_keys_-=half;
+  }
+  return idx+m_cmp_pred.before(keys_[idx], k_);
+}
+//----
+
+template<typename K, typename T, class CmpPred>
+template<typename K1>
+unsigned btree_map<K, T, CmpPred>::upper_idx(const K *keys_, unsigned num_keys_, const K1 &k_) const
+{
+  // binary search the first key after the key
+  if(!num_keys_)
+    return 0;
+  unsigned idx=0;
+  while(num_keys_>1)
+  {
+    unsigned half=num_keys_>>1;
+    idx=!m_cmp_pred.before(k_, keys_[idx+half-1])?idx+half:idx;
+    num_keys_-=half;
+  }
+  return idx+!m_cmp_pred.before(k_, keys_[idx]);
+}
+//----
+
+template<typename K, typename T, class CmpPred>
+void btree_map<K, T, CmpPred>::validate_btree_state(const void *n_, unsigned depth_, const K *min_, const K *max_, usize_t &num_items_, const leaf *&prev_leaf_) const
+{
+  if(depth_<m_depth)
+  {
+    // check branch keys and children
+    branch *b=(branch*)n_;
+    const K *keys=b->keys();
+    PFC_ASSERT(b->num_keys<=branch_capacity && b->num_keys>=(depth_?unsigned(branch_min_keys):1));
+    for(unsigned i=0; i<b->num_keys; ++i)
     {
-      w->color=1;
-      n_=parent_;
-      parent_=n_->parent;
-      if(parent_)
-        is_left_child_=n_==parent_->children[0];
+      PFC_ASSERT(!i || m_cmp_pred.before(keys[i-1], keys[i]));
+      PFC_ASSERT(!min_ || !m_cmp_pred.before(keys[i], *min_));
+      PFC_ASSERT(!max_ || m_cmp_pred.before(keys[i], *max_));
     }
-    else
+    for(unsigned i=0; i<=b->num_keys; ++i)
+      validate_btree_state(b->children[i], depth_+1, i?keys+i-1:min_, i<b->num_keys?keys+i:max_, num_items_, prev_leaf_);
+  }
+  else
+  {
+    // check leaf keys and links
+    leaf *l=(leaf*)n_;
+    const K *keys=l->keys();
+    PFC_ASSERT(l->num_items<=leaf_capacity && l->num_items>=(depth_?unsigned(leaf_min_items):1));
+    PFC_ASSERT(l->prev==prev_leaf_ && (!prev_leaf_ || prev_leaf_->next==l));
+    for(unsigned i=0; i<l->num_items; ++i)
     {
-      if(is_child0_black)
-      {
-        w->children[!is_left_child_]->color=0;
-        w->color=1;
-        rotate_subtree(*w, is_left_child_);
-        w=parent_->children[is_left_child_];
-      }
-      w->color=parent_->color;
-      parent_->color=0;
-      w->children[is_left_child_]->color=0;
-      rotate_subtree(*parent_, !is_left_child_);
-      n_=m_root;
+      PFC_ASSERT(!i || m_cmp_pred.before(keys[i-1], keys[i]));
+      PFC_ASSERT(!min_ || !m_cmp_pred.before(keys[i], *min_));
+      PFC_ASSERT(!max_ || m_cmp_pred.before(keys[i], *max_));
     }
+    num_items_+=l->num_items;
+    prev_leaf_=l;
   }
-  if(n_)
-    n_->color=0;
 }
 //----------------------------------------------------------------------------
 
 
 //============================================================================
-// map::const_iterator
+// btree_map::const_iterator
 //============================================================================
 template<typename K, typename T, class CmpPred>
-map<K, T, CmpPred>::const_iterator::const_iterator()
-  :m_node(0)
+btree_map<K, T, CmpPred>::const_iterator::const_iterator()
+  :m_leaf(0)
+  ,m_idx(0)
 {
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-map<K, T, CmpPred>::const_iterator::const_iterator(const iterator &it_)
-  :m_node(it_.m_node)
+btree_map<K, T, CmpPred>::const_iterator::const_iterator(const iterator &it_)
+  :m_leaf(it_.m_leaf)
+  ,m_idx(it_.m_idx)
 {
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::const_iterator::reset()
+void btree_map<K, T, CmpPred>::const_iterator::reset()
 {
-  m_node=0;
+  m_leaf=0;
+  m_idx=0;
 }
 //----------------------------------------------------------------------------
 
 template<typename K, typename T, class CmpPred>
-bool map<K, T, CmpPred>::const_iterator::operator==(const const_iterator &it_) const
+bool btree_map<K, T, CmpPred>::const_iterator::operator==(const const_iterator &it_) const
 {
-  return m_node==it_.m_node;
+  return m_leaf==it_.m_leaf && m_idx==it_.m_idx;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-bool map<K, T, CmpPred>::const_iterator::operator==(const iterator &it_) const
+bool btree_map<K, T, CmpPred>::const_iterator::operator==(const iterator &it_) const
 {
-  return m_node==it_.m_node;
+  return m_leaf==it_.m_leaf && m_idx==it_.m_idx;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-bool map<K, T, CmpPred>::const_iterator::operator!=(const const_iterator &it_) const
+bool btree_map<K, T, CmpPred>::const_iterator::operator!=(const const_iterator &it_) const
 {
-  return m_node!=it_.m_node;
+  return m_leaf!=it_.m_leaf || m_idx!=it_.m_idx;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-bool map<K, T, CmpPred>::const_iterator::operator!=(const iterator &it_) const
+bool btree_map<K, T, CmpPred>::const_iterator::operator!=(const iterator &it_) const
 {
-  return m_node!=it_.m_node;
+  return m_leaf!=it_.m_leaf || m_idx!=it_.m_idx;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-typename map<K, T, CmpPred>::const_iterator &map<K, T, CmpPred>::const_iterator::operator++()
+typename btree_map<K, T, CmpPred>::const_iterator &btree_map<K, T, CmpPred>::const_iterator::operator++()
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  if(const node *n=m_node->children[1])
-  {
-    // find left-most node under right child
-    while(n)
-    {
-      m_node=n;
-      n=n->children[0];
-    }
-  }
-  else
+  // proceed to the next item in the leaf or to the next leaf
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  if(++m_idx==m_leaf->num_items)
   {
-    // traverse right sub-tree up
-    while(m_node->parent && m_node->parent->children[1]==m_node)
-      m_node=m_node->parent;
-    m_node=m_node->parent;
+    m_leaf=m_leaf->next;
+    m_idx=0;
   }
   return *this;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-const T &map<K, T, CmpPred>::const_iterator::operator*() const
+const T &btree_map<K, T, CmpPred>::const_iterator::operator*() const
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  return m_node->val;
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  return m_leaf->vals()[m_idx];
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-const T *map<K, T, CmpPred>::const_iterator::operator->() const
+const T *btree_map<K, T, CmpPred>::const_iterator::operator->() const
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  return &m_node->val;
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  return m_leaf->vals()+m_idx;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-const K &map<K, T, CmpPred>::const_iterator::key() const
+const K &btree_map<K, T, CmpPred>::const_iterator::key() const
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  return m_node->key;
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  return m_leaf->keys()[m_idx];
 }
 //----------------------------------------------------------------------------
 
 template<typename K, typename T, class CmpPred>
-map<K, T, CmpPred>::const_iterator::const_iterator(const node *n_)
-  :m_node(n_)
+btree_map<K, T, CmpPred>::const_iterator::const_iterator(leaf *l_, unsigned idx_)
+  :m_leaf(l_)
+  ,m_idx(idx_)
 {
 }
 //----------------------------------------------------------------------------
 
 
 //============================================================================
-// map::iterator
+// btree_map::iterator
 //============================================================================
 template<typename K, typename T, class CmpPred>
-map<K, T, CmpPred>::iterator::iterator()
-  :m_node(0)
+btree_map<K, T, CmpPred>::iterator::iterator()
+  :m_leaf(0)
+  ,m_idx(0)
 {
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-void map<K, T, CmpPred>::iterator::reset()
+void btree_map<K, T, CmpPred>::iterator::reset()
 {
-  m_node=0;
+  m_leaf=0;
+  m_idx=0;
 }
 //----------------------------------------------------------------------------
 
 template<typename K, typename T, class CmpPred>
-bool map<K, T, CmpPred>::iterator::operator==(const const_iterator &it_) const
+bool btree_map<K, T, CmpPred>::iterator::operator==(const const_iterator &it_) const
 {
-  return m_node==it_.m_node;
+  return m_leaf==it_.m_leaf && m_idx==it_.m_idx;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-bool map<K, T, CmpPred>::iterator::operator==(const iterator &it_) const
+bool btree_map<K, T, CmpPred>::iterator::operator==(const iterator &it_) const
 {
-  return m_node==it_.m_node;
+  return m_leaf==it_.m_leaf && m_idx==it_.m_idx;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-bool map<K, T, CmpPred>::iterator::operator!=(const const_iterator &it_) const
+bool btree_map<K, T, CmpPred>::iterator::operator!=(const const_iterator &it_) const
 {
-  return m_node!=it_.m_node;
+  return m_leaf!=it_.m_leaf || m_idx!=it_.m_idx;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-bool map<K, T, CmpPred>::iterator::operator!=(const iterator &it_) const
+bool btree_map<K, T, CmpPred>::iterator::operator!=(const iterator &it_) const
 {
-  return m_node!=it_.m_node;
+  return m_leaf!=it_.m_leaf || m_idx!=it_.m_idx;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-typename map<K, T, CmpPred>::iterator &map<K, T, CmpPred>::iterator::operator++()
+typename btree_map<K, T, CmpPred>::iterator &btree_map<K, T, CmpPred>::iterator::operator++()
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  if(node *n=m_node->children[1])
-  {
-    // find left-most node under right child
-    while(n)
-    {
-      m_node=n;
-      n=n->children[0];
-    }
-  }
-  else
+  // proceed to the next item in the leaf or to the next leaf
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  if(++m_idx==m_leaf->num_items)
   {
-    // traverse right sub-tree up
-    while(m_node->parent && m_node->parent->children[1]==m_node)
-      m_node=m_node->parent;
-    m_node=m_node->parent;
+    m_leaf=m_leaf->next;
+    m_idx=0;
   }
   return *this;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-T &map<K, T, CmpPred>::iterator::operator*() const
+T &btree_map<K, T, CmpPred>::iterator::operator*() const
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  return m_node->val;
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  return m_leaf->vals()[m_idx];
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-T *map<K, T, CmpPred>::iterator::operator->() const
+T *btree_map<K, T, CmpPred>::iterator::operator->() const
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  return &m_node->val;
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  return m_leaf->vals()+m_idx;
 }
 //----
 
 template<typename K, typename T, class CmpPred>
-const K &map<K, T, CmpPred>::iterator::key() const
+const K &btree_map<K, T, CmpPred>::iterator::key() const
 {
-  PFC_ASSERT_PEDANTIC(m_node);
-  return m_node->key;
+  PFC_ASSERT_PEDANTIC(m_leaf);
+  return m_leaf->keys()[m_idx];
 }
 //----------------------------------------------------------------------------
 
 template<typename K, typename T, class CmpPred>
-map<K, T, CmpPred>::iterator::iterator(node *n_)
-  :m_node(n_)
+btree_map<K, T, CmpPred>::iterator::iterator(leaf *l_, unsigned idx_)
+  :m_leaf(l_)
+  ,m_idx(idx_)
 {
 }
 //----------------------------------------------------------------------------
@@ -8198,6 +10854,13 @@ PFC_INLINE void swap(sarray<T, capacity> &a0_, sarray<T, capacity> &a1_)
 }
 //----
 
+template<typename T, usize_t capacity>
+PFC_INLINE void swap(small_array<T, capacity> &a0_, small_array<T, capacity> &a1_)
+{
+  a0_.swap(a1_);
+}
+//----
+
 template<typename T>
 PFC_INLINE void swap(deque<T> &d0_, deque<T> &d1_)
 {
@@ -8226,6 +10889,20 @@ PFC_INLINE void swap(map<K, T> &m0_, map<K, T> &m1_)
 }
 //----
 
+template<typename T, class CmpPred>
+PFC_INLINE void swap(btree_set<T, CmpPred> &s0_, btree_set<T, CmpPred> &s1_)
+{
+  s0_.swap(s1_);
+}
+//----
+
+template<typename K, typename T, class CmpPred>
+PFC_INLINE void swap(btree_map<K, T, CmpPred> &m0_, btree_map<K, T, CmpPred> &m1_)
+{
+  m0_.swap(m1_);
+}
+//----
+
 template<typename T>
 PFC_INLINE void swap(hash_set<T> &hs0_, hash_set<T> &hs1_)
 {
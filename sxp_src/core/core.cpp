@@ -331,38 +331,201 @@ void pfc::set_preabort_func(bool(*preabort_)())
 namespace pfc
 {
 #ifdef PFC_BUILDOP_MEMORY_TRACKING
-  static mp_critical_section s_memory_info_list_csect;
-  memory_info memory_info::s_head={0, 0, &s_head, &s_head};
+  //==========================================================================
+  // memory_track_shard
+  //==========================================================================
+  // Per-thread list of tracked memory blocks. Blocks are linked to the shard
+  // of the allocating thread without locking, and blocks freed by other threads
+  // are pushed to a lock-free remote free list of the shard, which the owner
+  // thread drains (unlinks and frees the blocks). Shards of exited threads are
+  // adopted by new threads.
+  struct memory_track_shard
+  {
+    memory_info *volatile remote_free;
+    char pad[64-sizeof(memory_info*)];  // keep remote frees in separate cache line
+    memory_info head;
+    memory_track_shard *next;
+    memory_track_shard *next_abandoned;
+    volatile bool is_abandoned;
+  };
+  //--------------------------------------------------------------------------
+
+  static mp_critical_section s_memory_shard_csect;
+  static memory_track_shard *volatile s_memory_shards=0;
+  static memory_track_shard *s_abandoned_memory_shards=0;
+  static usize_t s_memory_shard_exit_key=0;
+  static bool s_has_memory_shard_exit_key=false;
+  static PFC_THREAD_VAR memory_track_shard *s_memory_shard=0;
+  static const alloc_site_info *volatile s_alloc_sites=0;
   PFC_THREAD_VAR const char *memory_stack_entry::s_stack[max_memory_stack_depth]={0};
   PFC_THREAD_VAR unsigned memory_stack_entry::s_stack_depth=PFC_MEM_TRACK_STACK_DEPTH;
   //----
 
-  void add_memory_info(memory_info &info_)
+  static const alloc_site_info &unknown_alloc_site()
+  {
+    static const alloc_site_info s_site("<unknown>", "<unknown>", 0);
+    return s_site;
+  }
+  //----
+
+  static void abandon_memory_shard(void *shard_)
+  {
+    // move shard of the exiting thread to the abandoned list for adoption by new threads
+    memory_track_shard *shard=(memory_track_shard*)shard_;
+    s_memory_shard=0;
+    s_memory_shard_csect.enter();
+    shard->is_abandoned=true;
+    shard->next_abandoned=s_abandoned_memory_shards;
+    s_abandoned_memory_shards=shard;
+    s_memory_shard_csect.leave();
+  }
+  //----
+
+  static memory_track_shard &create_memory_shard()
+  {
+    // adopt abandoned shard
+    s_memory_shard_csect.enter();
+    if(!s_has_memory_shard_exit_key)
+    {
+      s_memory_shard_exit_key=create_thread_exit_key(&abandon_memory_shard);
+      s_has_memory_shard_exit_key=true;
+    }
+    memory_track_shard *shard=s_abandoned_memory_shards;
+    if(shard)
+    {
+      s_abandoned_memory_shards=shard->next_abandoned;
+      shard->is_abandoned=false;
+    }
+    s_memory_shard_csect.leave();
+
+    // create new shard (shards are never released and aren't tracked)
+    if(!shard)
+    {
+      shard=(memory_track_shard*)PFC_HEAP_MALLOC(sizeof(memory_track_shard));
+      PFC_CHECK_MSG(shard, ("Unable to allocate memory tracking shard\r\n"));
+      mem_zero(shard, sizeof(memory_track_shard));
+      shard->head.prev=&shard->head;
+      shard->head.next=&shard->head;
+      s_memory_shard_csect.enter();
+      shard->next=s_memory_shards;
+      s_memory_shards=shard;
+      s_memory_shard_csect.leave();
+    }
+    s_memory_shard=shard;
+    set_thread_exit_value(s_memory_shard_exit_key, shard);
+    return *shard;
+  }
+  //----
+
+  static PFC_INLINE void unlink_memory_info(memory_info &info_)
+  {
+    info_.prev->next=info_.next;
+    info_.next->prev=info_.prev;
+  }
+  //----
+
+  static PFC_INLINE void drain_memory_shard(memory_track_shard &shard_)
   {
-    // add memory info block to the block list
-    s_memory_info_list_csect.enter();
-    info_.next=&memory_info::s_head;
-    info_.prev=memory_info::s_head.prev;
-    memory_info::s_head.prev->next=&info_;
-    memory_info::s_head.prev=&info_;
-    s_memory_info_list_csect.leave();
-    atom_inc(memory_info::s_head.num_items);
+    // unlink and free blocks freed by other threads
+    if(!atom_read(shard_.remote_free))
+      return;
+    memory_info *info=atom_mov(shard_.remote_free, (memory_info*)0);
+    while(info)
+    {
+      memory_info *next=info->remote_next;
+      unlink_memory_info(*info);
+      PFC_HEAP_FREE(info);
+      info=next;
+    }
+  }
+  //--------------------------------------------------------------------------
+
+  static void register_alloc_site(const alloc_site_info &site_)
+  {
+    // push the site to the list of sites with allocations
+    if(atom_cmov_eq(site_.is_registered, int32_t(1), int32_t(0))==0)
+    {
+      const alloc_site_info *head;
+      do
+      {
+        head=s_alloc_sites;
+        site_.next=head;
+      } while(atom_cmov_eq(s_alloc_sites, &site_, head)!=head);
+    }
+  }
+  //----
+
+  void add_memory_info(memory_info &info_, usize_t num_bytes_)
+  {
+    // add memory info block to the thread shard block list
+    memory_track_shard *shard=s_memory_shard;
+    if(!shard)
+      shard=&create_memory_shard();
+    drain_memory_shard(*shard);
+    info_.shard=shard;
+    info_.num_bytes=num_bytes_;
+    info_.next=&shard->head;
+    info_.prev=shard->head.prev;
+    shard->head.prev->next=&info_;
+    shard->head.prev=&info_;
 
 #if PFC_MEM_TRACK_STACK_DEPTH>0
     // save memory allocation stack
     mem_copy(info_.stack, memory_stack_entry::s_stack+memory_stack_entry::s_stack_depth-PFC_MEM_TRACK_STACK_DEPTH, sizeof(info_.stack));
 #endif
+
+    // update allocation site stats
+    const alloc_site_info &site=info_.site_info?*info_.site_info:unknown_alloc_site();
+    usize_t num_site_bytes=atom_add(site.num_bytes, num_bytes_)+num_bytes_;
+    atom_inc(site.num_allocs);
+    atom_add(site.total_bytes, num_bytes_);
+    atom_inc(site.total_allocs);
+    if(num_site_bytes>site.peak_bytes)
+      atom_cmov_max(site.peak_bytes, num_site_bytes);
+    if(!site.is_registered)
+      register_alloc_site(site);
   }
   //----
 
-  void remove_memory_info(memory_info &info_)
+  void free_memory_info(memory_info &info_)
   {
-    // remove memory info block from the block list
-    s_memory_info_list_csect.enter();
-    info_.prev->next=info_.next;
-    info_.next->prev=info_.prev;
-    s_memory_info_list_csect.leave();
-    atom_dec(memory_info::s_head.num_items);
+    // update allocation site stats
+    const alloc_site_info &site=info_.site_info?*info_.site_info:unknown_alloc_site();
+    atom_add(site.num_bytes, usize_t(0)-info_.num_bytes);
+    atom_dec(site.num_allocs);
+
+    // unlink and free the block directly if owned by the thread
+    memory_track_shard *shard=info_.shard;
+    if(shard==s_memory_shard)
+    {
+      drain_memory_shard(*shard);
+      unlink_memory_info(info_);
+      PFC_HEAP_FREE(&info_);
+      return;
+    }
+
+    // unlink and free the block of an abandoned shard under lock
+    if(shard->is_abandoned)
+    {
+      s_memory_shard_csect.enter();
+      if(shard->is_abandoned)
+      {
+        unlink_memory_info(info_);
+        s_memory_shard_csect.leave();
+        PFC_HEAP_FREE(&info_);
+        return;
+      }
+      s_memory_shard_csect.leave();
+    }
+
+    // push the block to the owner shard to be unlinked and freed by the owner thread
+    info_.shard=0;
+    memory_info *head;
+    do
+    {
+      head=shard->remote_free;
+      info_.remote_next=head;
+    } while(atom_cmov_eq(shard->remote_free, &info_, head)!=head);
   }
 #endif
 } // namespace pfc
@@ -382,18 +545,26 @@ void pfc::log_allocated_memory()
 #ifdef PFC_BUILDOP_MEMORY_TRACKING
   // iterate through all allocated memory blocks
   // note: must ensure we don't perform any memory tracked allocations here, thus using custom allocator for memory logs
+  // note: blocks freed by other threads but not yet drained by the owner thread are skipped
   memory_log_allocator alloc;
   heap_str mem_log(&alloc);
-  memory_info *info=memory_info::s_head.next;
+  usize_t num_blocks=0;
+  for(memory_track_shard *shard=s_memory_shards; shard; shard=shard->next)
+    for(memory_info *info=shard->head.next; info!=&shard->head; info=info->next)
+      if(info->shard)
+        ++num_blocks;
   bool is_first=true;
-  if(info!=&memory_info::s_head)
+  if(num_blocks)
   {
     mem_log+="============================================================================\r\n";
-    mem_log.push_back_format("Allocated memory blocks (%i):\r\n", memory_info::s_head.num_items);
+    mem_log.push_back_format("Allocated memory blocks (%i):\r\n", num_blocks);
     mem_log+="----------------------------------------------------------------------------\r\n";
-    do
+    for(memory_track_shard *shard=s_memory_shards; shard; shard=shard->next)
+    for(memory_info *info=shard->head.next; info!=&shard->head; info=info->next)
     {
       // log the number of allocated bytes/objects and allocation site
+      if(!info->shard)
+        continue;
       const uint8_t *data=((const uint8_t*)info)+memory_info_size;
       if(!is_first)
         mem_log+="\r\n";
@@ -421,11 +592,8 @@ void pfc::log_allocated_memory()
           mem_log.push_back_format("  %s\r\n", stack_entry);
       }
 #endif
-
-      // proceed to the next allocation
-      info=info->next;
       is_first=false;
-    } while(info!=&memory_info::s_head);
+    }
     log(mem_log.c_str());
     log("----------------------------------------------------------------------------\r\n");
   }
@@ -433,6 +601,126 @@ void pfc::log_allocated_memory()
   log("Memory tracking not enabled.\r\n");
 #endif
 }
+//----
+
+void pfc::reset_alloc_site_peaks()
+{
+#ifdef PFC_BUILDOP_MEMORY_TRACKING
+  // reset peaks of all allocation sites to the current number of live bytes
+  for(const alloc_site_info *site=atom_read(s_alloc_sites); site; site=site->next)
+    atom_write(site->peak_bytes, atom_read(site->num_bytes));
+#endif
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// memory_snapshot
+//============================================================================
+memory_snapshot::memory_snapshot()
+{
+  m_sites=0;
+  m_num_sites=0;
+  m_capacity=0;
+}
+//----
+
+memory_snapshot::~memory_snapshot()
+{
+  // note: snapshot data isn't tracked to keep it out of the captured stats
+  PFC_HEAP_FREE(m_sites);
+}
+//----
+
+void memory_snapshot::capture()
+{
+  m_num_sites=0;
+#ifdef PFC_BUILDOP_MEMORY_TRACKING
+  // copy stats of all sites with allocations (sites are only ever pushed to the list front)
+  const alloc_site_info *sites=atom_read(s_alloc_sites);
+  usize_t num_sites=0;
+  for(const alloc_site_info *site=sites; site; site=site->next)
+    ++num_sites;
+  reserve(num_sites);
+  for(const alloc_site_info *site=sites; site; site=site->next)
+  {
+    alloc_site_stats &s=m_sites[m_num_sites++];
+    s.site=site;
+    s.num_bytes=ssize_t(site->num_bytes);
+    s.num_allocs=ssize_t(site->num_allocs);
+    s.peak_bytes=site->peak_bytes;
+    s.total_bytes=site->total_bytes;
+    s.total_allocs=site->total_allocs;
+  }
+#endif
+}
+//----
+
+void memory_snapshot::diff(const memory_snapshot &prev_, const memory_snapshot &cur_)
+{
+  // sites of the previous snapshot are the tail of the current snapshot sites
+  PFC_ASSERT(this!=&prev_ && this!=&cur_);
+  PFC_ASSERT_MSG(prev_.m_num_sites<=cur_.m_num_sites, ("Previous snapshot must be captured before the current snapshot\r\n"));
+  reserve(cur_.m_num_sites);
+  m_num_sites=0;
+  usize_t num_new_sites=cur_.m_num_sites-prev_.m_num_sites;
+  for(usize_t i=0; i<cur_.m_num_sites; ++i)
+  {
+    // store stats of sites with allocations or frees in the interval
+    alloc_site_stats s=cur_.m_sites[i];
+    if(i>=num_new_sites)
+    {
+      const alloc_site_stats &ps=prev_.m_sites[i-num_new_sites];
+      PFC_ASSERT_PEDANTIC(ps.site==s.site);
+      s.num_bytes-=ps.num_bytes;
+      s.num_allocs-=ps.num_allocs;
+      s.total_bytes-=ps.total_bytes;
+      s.total_allocs-=ps.total_allocs;
+    }
+    if(s.num_bytes || s.num_allocs || s.total_allocs)
+      m_sites[m_num_sites++]=s;
+  }
+}
+//----------------------------------------------------------------------------
+
+alloc_site_stats memory_snapshot::total_stats() const
+{
+  // sum stats of all sites (peak is the sum of site peaks)
+  alloc_site_stats total;
+  mem_zero(&total, sizeof(total));
+  for(usize_t i=0; i<m_num_sites; ++i)
+  {
+    const alloc_site_stats &s=m_sites[i];
+    total.num_bytes+=s.num_bytes;
+    total.num_allocs+=s.num_allocs;
+    total.peak_bytes+=s.peak_bytes;
+    total.total_bytes+=s.total_bytes;
+    total.total_allocs+=s.total_allocs;
+  }
+  return total;
+}
+//----
+
+void memory_snapshot::log() const
+{
+  for(usize_t i=0; i<m_num_sites; ++i)
+  {
+    const alloc_site_stats &s=m_sites[i];
+    PFC_LOGF("%i bytes in %i allocs (peak %u bytes, %u allocs total): %s (%i) - %s\r\n",
+             int(s.num_bytes), int(s.num_allocs), unsigned(s.peak_bytes), unsigned(s.total_allocs), s.site->filename, s.site->line, s.site->funcname);
+  }
+}
+//----------------------------------------------------------------------------
+
+void memory_snapshot::reserve(usize_t num_sites_)
+{
+  if(num_sites_<=m_capacity)
+    return;
+  PFC_HEAP_FREE(m_sites);
+  m_capacity=num_sites_+num_sites_/2+16;
+  m_sites=(alloc_site_stats*)PFC_HEAP_MALLOC(m_capacity*sizeof(alloc_site_stats));
+  PFC_CHECK_MSG(m_sites, ("Unable to allocate memory snapshot\r\n"));
+}
 //----------------------------------------------------------------------------
 
 
@@ -664,6 +952,256 @@ unsigned perf_timer::num_groups()
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// perf_trace
+//============================================================================
+namespace
+{
+  // config
+  enum {perf_trace_text_size=32};
+  enum {perf_trace_thread_name_size=32};
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // perf_trace_event
+  //==========================================================================
+  struct perf_trace_event
+  {
+    uint64_t start_cycles, end_cycles;
+    const char *name, *category;
+    char text[perf_trace_text_size];
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // perf_trace_buffer
+  //==========================================================================
+  // Single-producer event ring buffer of a thread. The buffer is kept after
+  // the thread exits so that events of finished threads can be exported.
+  struct perf_trace_buffer
+  {
+    perf_trace_event *events;
+    usize_t mask;
+    volatile usize_t num_events; // number of events recorded since the last clear
+    unsigned tid;
+    char thread_name[perf_trace_thread_name_size];
+    perf_trace_buffer *next;
+  };
+  //--------------------------------------------------------------------------
+
+  static PFC_THREAD_VAR perf_trace_buffer *s_perf_trace_buffer=0;
+  static perf_trace_buffer *volatile s_perf_trace_buffers=0;
+  static volatile int32_t s_perf_trace_num_threads=0;
+  static usize_t s_perf_trace_capacity=0;
+  static udouble_t s_perf_trace_start_time=0.0, s_perf_trace_stop_time=0.0;
+  static uint64_t s_perf_trace_start_cycles=0, s_perf_trace_stop_cycles=0;
+  //--------------------------------------------------------------------------
+
+  perf_trace_buffer &perf_trace_thread_buffer()
+  {
+    // check for existing thread buffer
+    perf_trace_buffer *buf=s_perf_trace_buffer;
+    if(buf)
+      return *buf;
+
+    // create and register a new buffer for the thread
+    buf=(perf_trace_buffer*)PFC_HEAP_MALLOC(sizeof(perf_trace_buffer));
+    buf->events=0;
+    buf->mask=0;
+    buf->num_events=0;
+    buf->tid=unsigned(atom_inc(s_perf_trace_num_threads));
+    PFC_SNPRINTF(buf->thread_name, sizeof(buf->thread_name), "thread %u", buf->tid);
+    perf_trace_buffer *head;
+    do
+    {
+      head=s_perf_trace_buffers;
+      buf->next=head;
+    } while(atom_cmov_eq(s_perf_trace_buffers, buf, head)!=head);
+    s_perf_trace_buffer=buf;
+    return *buf;
+  }
+  //----
+
+  void copy_perf_trace_str(char *dst_, usize_t dst_size_, const char *str_)
+  {
+    // copy the string keeping the tail if truncated (e.g. file name of a path)
+    usize_t len=str_size(str_);
+    if(len>=dst_size_)
+    {
+      str_+=len-(dst_size_-1);
+      len=dst_size_-1;
+    }
+    mem_copy(dst_, str_, len);
+    dst_[len]=0;
+  }
+  //----
+
+  void write_perf_trace_str(bin_output_stream_base &s_, const char *str_)
+  {
+    // write JSON string with escaped special characters
+    char buf[256];
+    usize_t size=0;
+    buf[size++]='"';
+    while(char c=*str_++)
+    {
+      if(size>sizeof(buf)-8)
+      {
+        s_.write_bytes(buf, size);
+        size=0;
+      }
+      if(c=='"' || c=='\\')
+      {
+        buf[size++]='\\';
+        buf[size++]=c;
+      }
+      else if((unsigned char)c<0x20)
+        size+=PFC_SNPRINTF(buf+size, 7, "\\u%04x", unsigned((unsigned char)c));
+      else
+        buf[size++]=c;
+    }
+    buf[size++]='"';
+    s_.write_bytes(buf, size);
+  }
+  //----
+
+  void write_perf_trace_fmt(bin_output_stream_base &s_, const char *fmt_, ...)
+  {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt_);
+    int size=vsnprintf(buf, sizeof(buf), fmt_, args);
+    va_end(args);
+    s_.write_bytes(buf, usize_t(min(size, int(sizeof(buf)-1))));
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+bool perf_trace::s_is_active=false;
+//----------------------------------------------------------------------------
+
+void perf_trace::start(usize_t max_events_per_thread_)
+{
+  // setup per-thread ring buffer capacity (power-of-2) and calibrate timing
+  PFC_ASSERT_MSG(!s_is_active, ("Performance trace has already been started\r\n"));
+  PFC_ASSERT(max_events_per_thread_);
+  usize_t capacity=1;
+  while(capacity<max_events_per_thread_)
+    capacity<<=1;
+  s_perf_trace_capacity=capacity;
+  clear();
+  s_perf_trace_start_time=get_global_time();
+  s_perf_trace_start_cycles=get_thread_cycles();
+  s_is_active=true;
+}
+//----
+
+void perf_trace::stop()
+{
+  // stop tracing and store timing calibration for the export
+  if(!s_is_active)
+    return;
+  s_is_active=false;
+  s_perf_trace_stop_time=get_global_time();
+  s_perf_trace_stop_cycles=get_thread_cycles();
+}
+//----
+
+void perf_trace::clear()
+{
+  // reset all thread buffers (buffers allocated with different capacity are reallocated on the next event)
+  for(perf_trace_buffer *buf=atom_read(s_perf_trace_buffers); buf; buf=buf->next)
+    atom_write(buf->num_events, usize_t(0));
+}
+//----
+
+void perf_trace::set_thread_name(const char *name_)
+{
+  perf_trace_buffer &buf=perf_trace_thread_buffer();
+  copy_perf_trace_str(buf.thread_name, sizeof(buf.thread_name), name_);
+}
+//----
+
+void perf_trace::add_event(const char *name_, const char *category_, uint64_t start_cycles_, uint64_t end_cycles_, const char *text_)
+{
+  // check for ring buffer (re)allocation
+  if(!s_perf_trace_capacity)
+    return;
+  perf_trace_buffer &buf=perf_trace_thread_buffer();
+  usize_t idx=buf.num_events;
+  if(!idx && (!buf.events || buf.mask+1!=s_perf_trace_capacity))
+  {
+    if(buf.events)
+      PFC_HEAP_FREE(buf.events);
+    buf.events=(perf_trace_event*)PFC_HEAP_MALLOC(s_perf_trace_capacity*sizeof(perf_trace_event));
+    buf.mask=s_perf_trace_capacity-1;
+  }
+
+  // record the event, overwriting the oldest event if the buffer is full
+  perf_trace_event &e=buf.events[idx&buf.mask];
+  e.start_cycles=start_cycles_;
+  e.end_cycles=end_cycles_;
+  e.name=name_?name_:"<unnamed>";
+  e.category=category_?category_:"misc";
+  if(text_)
+    copy_perf_trace_str(e.text, sizeof(e.text), text_);
+  else
+    e.text[0]=0;
+  atom_write(buf.num_events, idx+1);
+}
+//----
+
+bool perf_trace::write_json(bin_output_stream_base &s_)
+{
+  // calibrate cycles to microseconds over the trace duration
+  if(!s_perf_trace_capacity)
+    return false;
+  udouble_t end_time=s_is_active?get_global_time():s_perf_trace_stop_time;
+  uint64_t end_cycles=s_is_active?get_thread_cycles():s_perf_trace_stop_cycles;
+  udouble_t us_per_cycle=end_cycles>s_perf_trace_start_cycles?(end_time-s_perf_trace_start_time)*1000000.0/udouble_t(end_cycles-s_perf_trace_start_cycles):0.0;
+
+  // write process & thread names
+  const char *proc_name=executable_name();
+  write_perf_trace_fmt(s_, "{\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":");
+  write_perf_trace_str(s_, proc_name && *proc_name?proc_name:"pfc");
+  write_perf_trace_fmt(s_, "}}");
+  for(perf_trace_buffer *buf=atom_read(s_perf_trace_buffers); buf; buf=buf->next)
+  {
+    write_perf_trace_fmt(s_, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", buf->tid);
+    write_perf_trace_str(s_, buf->thread_name);
+    write_perf_trace_fmt(s_, "}}");
+  }
+
+  // write the events available in thread ring buffers as complete events
+  for(perf_trace_buffer *buf=atom_read(s_perf_trace_buffers); buf; buf=buf->next)
+  {
+    usize_t num_events=atom_read(buf->num_events);
+    if(!buf->events || !num_events)
+      continue;
+    usize_t capacity=buf->mask+1;
+    for(usize_t i=num_events>capacity?num_events-capacity:0; i<num_events; ++i)
+    {
+      const perf_trace_event &e=buf->events[i&buf->mask];
+      uint64_t num_cycles=e.end_cycles-e.start_cycles;
+      udouble_t ts=udouble_t(int64_t(e.start_cycles-s_perf_trace_start_cycles))*us_per_cycle;
+      write_perf_trace_fmt(s_, ",\n{\"name\":");
+      write_perf_trace_str(s_, e.name);
+      write_perf_trace_fmt(s_, ",\"cat\":");
+      write_perf_trace_str(s_, e.category);
+      write_perf_trace_fmt(s_, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"cycles\":%llu", buf->tid, ts, udouble_t(num_cycles)*us_per_cycle, (unsigned long long)num_cycles);
+      if(e.text[0])
+      {
+        write_perf_trace_fmt(s_, ",\"text\":");
+        write_perf_trace_str(s_, e.text);
+      }
+      write_perf_trace_fmt(s_, "}}");
+    }
+  }
+  write_perf_trace_fmt(s_, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  return true;
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // directory setup and accessors
 //============================================================================
@@ -92,7 +92,14 @@ template<unsigned> static PFC_INLINE const alloc_site_info &get_alloc_site_info(
 PFC_INLINE void *mem_alloc(usize_t num_bytes_, const alloc_site_info *site_info_=0);
 template<typename T> PFC_INLINE T *mem_alloc(const alloc_site_info *site_info_=0);
 PFC_INLINE void mem_free(void*);
+void *mp_heap_alloc(usize_t num_bytes_);
+void mp_heap_free(void*);
+void *map_os_memory(usize_t num_bytes_, usize_t align_, bool huge_pages_=false);
+void unmap_os_memory(void*, usize_t num_bytes_);
 void log_allocated_memory();
+struct alloc_site_stats;
+class memory_snapshot;
+void reset_alloc_site_peaks();
 PFC_INLINE void mem_copy(void*, const void*, usize_t num_bytes_);
 PFC_INLINE void mem_move(void*, const void*, usize_t num_bytes_);
 PFC_INLINE void mem_zero(void*, usize_t num_bytes_);
@@ -154,6 +161,8 @@ template<typename T> struct definit_var;
 template<typename T> class uninit_var;
 // profiling
 struct perf_timer;
+struct perf_trace;
+class bin_output_stream_base;
 // directory setup and accessors
 void init_working_dir();
 const char *executable_dir();
@@ -209,6 +218,16 @@ struct alloc_site_info
   const char *filename;
   const char *funcname;
   unsigned line;
+#ifdef PFC_BUILDOP_MEMORY_TRACKING
+  // allocation stats (atomically updated by all threads)
+  mutable volatile usize_t num_bytes;
+  mutable volatile usize_t num_allocs;
+  mutable volatile usize_t peak_bytes;
+  mutable volatile usize_t total_bytes;
+  mutable volatile usize_t total_allocs;
+  mutable const alloc_site_info *volatile next;  // next site in the list of sites with allocations
+  mutable volatile int32_t is_registered;
+#endif
 };
 //----------------------------------------------------------------------------
 
@@ -227,6 +246,13 @@ struct alloc_site_info
 #define PFC_NEW(type__) new(pfc::mem_alloc<type__ >())type__
 #define PFC_ARRAY_NEW(type__, num_items__) pfc::array_new<type__ >(num_items__)
 #endif
+#ifdef PFC_BUILDOP_MP_HEAP
+#define PFC_HEAP_MALLOC(bytes__) pfc::mp_heap_alloc(bytes__)
+#define PFC_HEAP_FREE(ptr__) pfc::mp_heap_free(ptr__)
+#else
+#define PFC_HEAP_MALLOC(bytes__) PFC_ALIGNED_MALLOC(bytes__, pfc::memory_align)
+#define PFC_HEAP_FREE(ptr__) PFC_ALIGNED_FREE(ptr__)
+#endif
 #define PFC_STACK_MALLOC(bytes__) PFC_ALLOCA(bytes__)
 #define PFC_ALIGNED_STACK_MALLOC(bytes__, alignment__) ((void*)((usize_t(PFC_ALLOCA(bytes__+alignment__))+alignment__)&-alignment__))
 #define PFC_MEM_FREE(ptr__) pfc::mem_free(ptr__)
@@ -396,16 +422,22 @@ enum {memory_align=16,
       max_memory_stack_depth=256};
 //----------------------------------------------------------------------------
 
+struct memory_track_shard;
 struct memory_info
 {
   usize_t num_items;
 #ifdef PFC_BUILDOP_MEMORY_TRACKING
   const alloc_site_info *site_info;
-  memory_info *prev, *next;
+  memory_track_shard *shard;   // tracking shard of the allocating thread (0=freed by other thread, pending unlink by the owner)
+  memory_info *prev, *next;    // links in the shard block list
+  union
+  {
+    usize_t num_bytes;         // number of allocated bytes (for live blocks)
+    memory_info *remote_next;  // next block in the shard remote free list (for blocks freed by other threads)
+  };
 #if PFC_MEM_TRACK_STACK_DEPTH>0
   const char *stack[PFC_MEM_TRACK_STACK_DEPTH];
 #endif
-  static memory_info s_head;
 #endif
 };
 //----
@@ -427,6 +459,63 @@ struct memory_stack_entry
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// alloc_site_stats
+//============================================================================
+struct alloc_site_stats
+{
+  const alloc_site_info *site;
+  ssize_t num_bytes;     // number of live bytes (change in the interval for snapshot diffs)
+  ssize_t num_allocs;    // number of live allocations (change in the interval for snapshot diffs)
+  usize_t peak_bytes;    // peak live bytes since the last peak reset
+  usize_t total_bytes;   // total allocated bytes (in the interval for snapshot diffs)
+  usize_t total_allocs;  // total number of allocations (in the interval for snapshot diffs)
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// memory_snapshot
+//============================================================================
+// Captures per allocation site memory stats of memory tracking builds.
+// Snapshots are cheap to capture (no locking, size proportional to the number
+// of allocation sites) and two snapshots can be diffed for per frame/load
+// allocation stats, e.g.:
+//   memory_snapshot s0, s1, d;
+//   s0.capture();
+//   load_level();
+//   s1.capture();
+//   d.diff(s0, s1);
+class memory_snapshot
+{
+public:
+  // construction
+  memory_snapshot();
+  ~memory_snapshot();
+  void capture();
+  void diff(const memory_snapshot &prev_, const memory_snapshot &cur_);
+  //--------------------------------------------------------------------------
+
+  // accessors
+  PFC_INLINE usize_t num_sites() const;
+  PFC_INLINE const alloc_site_stats &site_stats(usize_t idx_) const;
+  alloc_site_stats total_stats() const;
+  void log() const;
+  //--------------------------------------------------------------------------
+
+private:
+  memory_snapshot(const memory_snapshot&); // not implemented
+  void operator=(const memory_snapshot&); // not implemented
+  void reserve(usize_t num_sites_);
+  //--------------------------------------------------------------------------
+
+  alloc_site_stats *m_sites;
+  usize_t m_num_sites;
+  usize_t m_capacity;
+};
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // memory_allocator_base
 //============================================================================
@@ -1234,8 +1323,8 @@ PFC_INLINE void thread_sleep(ufloat_t time_);
 #define PFC_PERF_TIMER_START(timer__) {s_timer_##timer__.start();}
 #define PFC_PERF_TIMER_PAUSE(timer__) {s_timer_##timer__.pause();}
 #define PFC_PERF_TIMER_STOP(timer__) {s_timer_##timer__.stop();}
-#define PFC_PERF_TIMER_SCOPE(timer__) pfc::perf_timer::toggle perf_timer##__LINE__(s_timer_##timer__)
-#define PFC_PERF_TIMER_AUTO(timer__, group__, name__) static PFC_THREAD_VAR pfc::perf_timer s_timer_##timer__={group__, name__, 0, 0.0, 0.0, 0, false, 0, 0}; pfc::perf_timer::toggle perf_timer##__LINE__(s_timer_##timer__)
+#define PFC_PERF_TIMER_SCOPE(timer__) pfc::perf_timer::toggle PFC_CAT2(perf_timer_, __LINE__)(s_timer_##timer__)
+#define PFC_PERF_TIMER_AUTO(timer__, group__, name__) static PFC_THREAD_VAR pfc::perf_timer s_timer_##timer__={group__, name__, 0, 0.0, 0.0, 0, false, 0, 0}; pfc::perf_timer::toggle PFC_CAT2(perf_timer_, __LINE__)(s_timer_##timer__)
 #else
 #define PFC_PERF_TIMERS_ENABLE() {}
 #define PFC_PERF_TIMERS_DISABLE() {}
@@ -1298,6 +1387,66 @@ private:
   //--------------------------------------------------------------------------
 
   perf_timer &m_timer;
+  uint64_t m_trace_start_cycles;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// perf_trace
+//============================================================================
+#ifdef PFC_BUILDOP_PROFILING
+#define PFC_PERF_TRACE_SCOPE(name__, category__, text__) pfc::perf_trace::scope PFC_CAT2(perf_trace_, __LINE__)(name__, category__, text__)
+#define PFC_PERF_TRACE_EVENT(name__, category__, start_cycles__, end_cycles__) {if(pfc::perf_trace::s_is_active) pfc::perf_trace::add_event(name__, category__, start_cycles__, end_cycles__);}
+#else
+#define PFC_PERF_TRACE_SCOPE(name__, category__, text__) {}
+#define PFC_PERF_TRACE_EVENT(name__, category__, start_cycles__, end_cycles__) {}
+#endif
+//----------------------------------------------------------------------------
+
+// Timeline event tracing exported as Chrome trace JSON (chrome://tracing or
+// ui.perfetto.dev). Events are recorded to per-thread lock-free ring buffers
+// which overwrite the oldest events when full. With PFC_BUILDOP_PROFILING
+// perf timer scopes, job queue jobs and file loads are traced while tracing
+// is active. Event names and categories must be static strings, while the
+// optional text is copied (tail truncated to 31 chars).
+struct perf_trace
+{
+  // nested types
+  class scope;
+  //--------------------------------------------------------------------------
+
+  // tracing
+  static void start(usize_t max_events_per_thread_=32768);
+  static void stop();
+  static void clear();
+  static void set_thread_name(const char*);
+  static void add_event(const char *name_, const char *category_, uint64_t start_cycles_, uint64_t end_cycles_, const char *text_=0);
+  static bool write_json(bin_output_stream_base&);
+  //--------------------------------------------------------------------------
+
+  static bool s_is_active;
+};
+//----------------------------------------------------------------------------
+
+//============================================================================
+// perf_trace::scope
+//============================================================================
+class perf_trace::scope
+{
+public:
+  // construction
+  PFC_INLINE scope(const char *name_, const char *category_, const char *text_=0);
+  PFC_INLINE ~scope();
+  //--------------------------------------------------------------------------
+
+private:
+  scope(const scope&); // not implemented
+  void operator=(const scope&); // not implemented
+  //--------------------------------------------------------------------------
+
+  const char *m_name, *m_category, *m_text;
+  uint64_t m_start_cycles;
 };
 //----------------------------------------------------------------------------
 
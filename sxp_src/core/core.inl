@@ -27,6 +27,15 @@ alloc_site_info::alloc_site_info(const char *filename_, const char *funcname_, u
   ,funcname(funcname_)
   ,line(line_)
 {
+#ifdef PFC_BUILDOP_MEMORY_TRACKING
+  num_bytes=0;
+  num_allocs=0;
+  peak_bytes=0;
+  total_bytes=0;
+  total_allocs=0;
+  next=0;
+  is_registered=0;
+#endif
 }
 //----
 
@@ -45,15 +54,15 @@ static PFC_INLINE const alloc_site_info &get_alloc_site_info(const char *filenam
 PFC_INLINE void *mem_alloc(usize_t num_bytes_, const alloc_site_info *site_info_)
 {
 #ifdef PFC_BUILDOP_MEMORY_TRACKING
-  memory_info *info=(memory_info*)PFC_ALIGNED_MALLOC(num_bytes_+memory_info_size, memory_align);
+  memory_info *info=(memory_info*)PFC_HEAP_MALLOC(num_bytes_+memory_info_size);
   PFC_ASSERT_MSG(info, ("Memory allocation of %u bytes failed\r\n", num_bytes_+memory_info_size));
   info->site_info=site_info_;
   info->num_items=memory_flag_typeless|num_bytes_;
-  extern void add_memory_info(memory_info&);
-  add_memory_info(*info);
+  extern void add_memory_info(memory_info&, usize_t num_bytes_);
+  add_memory_info(*info, num_bytes_);
   return ((char*)info)+memory_info_size;
 #else
-  return PFC_ALIGNED_MALLOC(num_bytes_, memory_align);
+  return PFC_HEAP_MALLOC(num_bytes_);
 #endif
 }
 //----
@@ -62,15 +71,15 @@ template<typename T>
 PFC_INLINE T *mem_alloc(const alloc_site_info *site_info_)
 {
 #ifdef PFC_BUILDOP_MEMORY_TRACKING
-  memory_info *info=(memory_info*)PFC_ALIGNED_MALLOC(sizeof(T)+memory_info_size, memory_align);
+  memory_info *info=(memory_info*)PFC_HEAP_MALLOC(sizeof(T)+memory_info_size);
   PFC_ASSERT_MSG(info, ("Memory allocation of %u bytes failed\r\n", sizeof(T)+memory_info_size));
   info->num_items=usize_t(memory_flag_typeless)|sizeof(T);
   info->site_info=site_info_;
-  extern void add_memory_info(memory_info&);
-  add_memory_info(*info);
+  extern void add_memory_info(memory_info&, usize_t num_bytes_);
+  add_memory_info(*info, sizeof(T));
   return (T*)(((char*)info)+memory_info_size);
 #else
-  return (T*)PFC_ALIGNED_MALLOC(sizeof(T), memory_align);
+  return (T*)PFC_HEAP_MALLOC(sizeof(T));
 #endif
 }
 //----
@@ -81,12 +90,11 @@ PFC_INLINE void mem_free(void *p_)
   if(p_)
   {
     memory_info *info=(memory_info*)(((char*)p_)-memory_info_size);
-    extern void remove_memory_info(memory_info&);
-    remove_memory_info(*info);
-    PFC_ALIGNED_FREE(info);
+    extern void free_memory_info(memory_info&);
+    free_memory_info(*info);
   }
 #else
-  PFC_ALIGNED_FREE(p_);
+  PFC_HEAP_FREE(p_);
 #endif
 }
 //----
@@ -161,6 +169,23 @@ memory_stack_entry::~memory_stack_entry()
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// memory_snapshot
+//============================================================================
+usize_t memory_snapshot::num_sites() const
+{
+  return m_num_sites;
+}
+//----
+
+const alloc_site_stats &memory_snapshot::site_stats(usize_t idx_) const
+{
+  PFC_ASSERT_PEDANTIC(idx_<m_num_sites);
+  return m_sites[idx_];
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // memory_allocator_base
 //============================================================================
@@ -209,12 +234,12 @@ template<typename T>
 PFC_INLINE T *array_new(usize_t num_items_, const alloc_site_info *site_info_)
 {
   // alloc memory and setup memory info
-  memory_info *info=(memory_info*)PFC_ALIGNED_MALLOC(num_items_*sizeof(T)+memory_info_size, memory_align);
+  memory_info *info=(memory_info*)PFC_HEAP_MALLOC(num_items_*sizeof(T)+memory_info_size);
   info->num_items=num_items_;
 #ifdef PFC_BUILDOP_MEMORY_TRACKING
   info->site_info=site_info_;
-  extern void add_memory_info(memory_info&);
-  add_memory_info(*info);
+  extern void add_memory_info(memory_info&, usize_t num_bytes_);
+  add_memory_info(*info, num_items_*sizeof(T));
 #endif
 
   // construct array
@@ -242,10 +267,6 @@ PFC_INLINE void array_delete(const T *p_)
   memory_info *info=(memory_info*)(((char*)p_)-memory_info_size);
   usize_t num_items=info->num_items;
   PFC_ASSERT_MSG((num_items&memory_flag_typeless)==0, ("Trying to release typeless data with array_delete()\r\n"));
-#ifdef PFC_BUILDOP_MEMORY_TRACKING
-  extern void remove_memory_info(memory_info&);
-  remove_memory_info(*info);
-#endif
 
   // destruct objects and free memory
   for(usize_t i=0; i<num_items; ++i)
@@ -253,7 +274,12 @@ PFC_INLINE void array_delete(const T *p_)
     p_->~T();
     ++p_;
   }
-  PFC_ALIGNED_FREE(info);
+#ifdef PFC_BUILDOP_MEMORY_TRACKING
+  extern void free_memory_info(memory_info&);
+  free_memory_info(*info);
+#else
+  PFC_HEAP_FREE(info);
+#endif
 }
 //----
 
@@ -1767,11 +1793,34 @@ perf_timer::toggle::toggle(perf_timer &t_)
   :m_timer(t_)
 {
   m_timer.start();
+  m_trace_start_cycles=perf_trace::s_is_active?get_thread_cycles():0;
 }
 //----
 
 perf_timer::toggle::~toggle()
 {
   m_timer.stop();
+  if(m_trace_start_cycles && perf_trace::s_is_active)
+    perf_trace::add_event(m_timer.name, m_timer.group?m_timer.group:"misc", m_trace_start_cycles, get_thread_cycles());
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// perf_trace::scope
+//============================================================================
+perf_trace::scope::scope(const char *name_, const char *category_, const char *text_)
+  :m_name(name_)
+  ,m_category(category_)
+  ,m_text(text_)
+{
+  m_start_cycles=perf_trace::s_is_active?get_thread_cycles():0;
+}
+//----
+
+perf_trace::scope::~scope()
+{
+  if(m_start_cycles && perf_trace::s_is_active)
+    perf_trace::add_event(m_name, m_category, m_start_cycles, get_thread_cycles(), m_text);
 }
 //----------------------------------------------------------------------------
@@ -111,7 +111,7 @@ public:
 
 private:
   struct func_stack_entry {uint8_t eop, eop_prec; functor_t func;};
-  typedef array<func_stack_entry> func_stack_t;
+  typedef small_array<func_stack_entry, 16> func_stack_t;
   expression_parser(const expression_parser&); // not implemented
   void operator=(const expression_parser&); // not implemented
   //--------------------------------------------------------------------------
@@ -137,7 +137,7 @@ struct expression_parser_config
 {
   typedef T var_t;
   typedef str_id id_str_t;
-  typedef array<var_t> var_stack_t;
+  typedef small_array<var_t, 16> var_stack_t;
   typedef hash_map<str_id, var_t> extra_var_container_t;
   //--------------------------------------------------------------------------
 
@@ -236,6 +236,7 @@ void pfc::build_temp_filepath(filepath_str &res_, const filepath_str &input_)
 usize_t pfc::read_file(file_system_base &fsys_, owner_data &res_, const char *filename_, const char *path_, e_file_open_check check_)
 {
   // read given file content to the string
+  PFC_PERF_TRACE_SCOPE("read_file", "file", filename_);
   owner_ptr<bin_input_stream_base> file=fsys_.open_read(filename_, path_, check_);
   if(!file.data)
     return 0;
@@ -249,6 +250,7 @@ usize_t pfc::read_file(file_system_base &fsys_, owner_data &res_, const char *fi
 usize_t pfc::read_file(file_system_base &fsys_, heap_str &res_, const char *filename_, const char *path_, e_file_open_check check_)
 {
   // read given file content to the string
+  PFC_PERF_TRACE_SCOPE("read_file", "file", filename_);
   res_.clear();
   owner_ptr<bin_input_stream_base> file=fsys_.open_read(filename_, path_, check_);
   if(!file.data)
@@ -262,6 +264,7 @@ usize_t pfc::read_file(file_system_base &fsys_, heap_str &res_, const char *file
 usize_t pfc::read_file(file_system_base &fsys_, array<uint8_t> &res_, const char *filename_, const char *path_, e_file_open_check check_)
 {
   // read given file content to the string
+  PFC_PERF_TRACE_SCOPE("read_file", "file", filename_);
   res_.clear();
   owner_ptr<bin_input_stream_base> file=fsys_.open_read(filename_, path_, check_);
   if(!file.data)
@@ -0,0 +1,310 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "sxp_src/sxp_pch.h"
+#include "lz4.h"
+#ifdef PFC_ENGINEOP_LZ4
+#include "sxp_src/core/mp/mp_job_queue.h"
+#include "sxp_extlibs/slang/external/lz4/lib/lz4.h"
+#endif
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+#ifdef PFC_ENGINEOP_LZ4
+//============================================================================
+// external library dependencies
+//============================================================================
+// lz4
+#pragma comment(lib, PFC_STR(PFC_CAT2(lz4_,PFC_BUILD_STR)PFC_COMPILER_LIB_EXT))
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  // stream format: block size followed by blocks of [compressed size, uncompressed size, data] and [0, 0] terminator
+  enum {lz4_block_flag_uncompressed=0x80000000};
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// lz4_input_stream
+//============================================================================
+lz4_input_stream::lz4_input_stream(bin_input_stream_base &s_)
+  :m_stream(s_)
+{
+  // read stream header and allocate buffers for the blocks
+  m_stream_start_pos=m_stream.pos();
+  m_stream>>m_block_size;
+  PFC_CHECK_MSG(m_block_size && m_block_size<=LZ4_MAX_INPUT_SIZE, ("LZ4 data is corrupted\r\n"));
+  m_buffer_compressed=PFC_MEM_ALLOC(LZ4_compressBound(int(m_block_size)));
+  m_buffer_uncompressed=PFC_MEM_ALLOC(m_block_size);
+  init_stream();
+}
+//----
+
+lz4_input_stream::~lz4_input_stream()
+{
+}
+//----------------------------------------------------------------------------
+
+usize_t lz4_input_stream::update_buffer_impl(void *p_, usize_t num_bytes_, bool exact_)
+{
+  // decompress blocks directly to the target or through the buffer for partial blocks
+  m_data=m_end;
+  usize_t num_total_bytes=0;
+  while(m_next_block_size)
+  {
+    usize_t block_size=m_next_block_size;
+    m_begin_pos+=usize_t(m_end-m_begin);
+    m_is_first=!m_begin_pos;
+    if(num_bytes_ && num_bytes_>=block_size)
+    {
+      decode_block(p_);
+      m_begin_pos+=block_size;
+      m_is_first=false;
+      m_begin=m_end=m_data=0;
+      (uint8_t*&)p_+=block_size;
+      num_bytes_-=block_size;
+      num_total_bytes+=block_size;
+      if(!num_bytes_)
+        break;
+    }
+    else
+    {
+      decode_block(m_buffer_uncompressed.data);
+      mem_copy(p_, m_buffer_uncompressed.data, num_bytes_);
+      m_begin=(const uint8_t*)m_buffer_uncompressed.data;
+      m_end=m_begin+block_size;
+      m_data=m_begin+num_bytes_;
+      num_total_bytes+=num_bytes_;
+      num_bytes_=0;
+      break;
+    }
+  }
+
+  // check for valid result
+  PFC_CHECK_MSG(!exact_ || !num_bytes_, ("Trying to read beyond the end of the stream\r\n"));
+  return num_total_bytes;
+}
+//----
+
+void lz4_input_stream::rewind_impl()
+{
+  m_stream.seek(m_stream_start_pos+sizeof(m_block_size));
+  init_stream();
+}
+//----
+
+void lz4_input_stream::rewind_impl(usize_t num_bytes_)
+{
+  seek_impl(pos()-num_bytes_);
+}
+//----
+
+void lz4_input_stream::skip_impl()
+{
+  usize_t abs_pos=pos();
+  m_data=m_end;
+  seek_impl(abs_pos);
+}
+//----
+
+void lz4_input_stream::seek_impl(usize_t abs_pos_)
+{
+  // rewind for backward seek and skip whole blocks without decompression until reaching the position
+  if(abs_pos_<m_begin_pos)
+    rewind_impl();
+  while(true)
+  {
+    usize_t buffer_end_pos=m_begin_pos+usize_t(m_end-m_begin);
+    if(abs_pos_<=buffer_end_pos)
+    {
+      m_data=m_begin+abs_pos_-m_begin_pos;
+      return;
+    }
+    PFC_CHECK_MSG(m_next_block_size, ("Trying to seek beyond the end of the stream\r\n"));
+    usize_t block_size=m_next_block_size;
+    m_begin_pos=buffer_end_pos;
+    m_is_first=!m_begin_pos;
+    if(abs_pos_>=m_begin_pos+block_size)
+    {
+      skip_block();
+      m_begin_pos+=block_size;
+      m_is_first=false;
+      m_begin=m_end=m_data=0;
+    }
+    else
+    {
+      decode_block(m_buffer_uncompressed.data);
+      m_begin=m_data=(const uint8_t*)m_buffer_uncompressed.data;
+      m_end=m_begin+block_size;
+    }
+  }
+}
+//----------------------------------------------------------------------------
+
+void lz4_input_stream::init_stream()
+{
+  init();
+  read_block_header();
+}
+//----
+
+void lz4_input_stream::read_block_header()
+{
+  // read header of the next block (zero size for the stream end)
+  m_stream>>m_next_block_compressed_size>>m_next_block_size;
+  PFC_CHECK_MSG(   m_next_block_size<=m_block_size
+                && (m_next_block_compressed_size&~lz4_block_flag_uncompressed)<=unsigned(LZ4_compressBound(int(m_block_size))),
+                ("LZ4 data is corrupted\r\n"));
+  m_is_last=!m_next_block_size;
+}
+//----
+
+void lz4_input_stream::decode_block(void *p_)
+{
+  // read & decompress the next block and the following block header
+  if(m_next_block_compressed_size&lz4_block_flag_uncompressed)
+    m_stream.read_bytes(p_, m_next_block_size);
+  else
+  {
+    m_stream.read_bytes(m_buffer_compressed.data, m_next_block_compressed_size);
+    int num_bytes=LZ4_decompress_safe((const char*)m_buffer_compressed.data, (char*)p_, int(m_next_block_compressed_size), int(m_next_block_size));
+    PFC_CHECK_MSG(num_bytes==int(m_next_block_size), ("LZ4 data is corrupted\r\n"));
+  }
+  read_block_header();
+}
+//----
+
+void lz4_input_stream::skip_block()
+{
+  m_stream.skip(m_next_block_compressed_size&~lz4_block_flag_uncompressed);
+  read_block_header();
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// lz4_output_stream
+//============================================================================
+lz4_output_stream::lz4_output_stream(bin_output_stream_base &s_, usize_t block_size_)
+  :m_stream(s_)
+  ,m_block_size(uint32_t(block_size_))
+{
+  // batch blocks for parallel compression if there's an active job queue
+  PFC_ASSERT(block_size_ && block_size_<=LZ4_MAX_INPUT_SIZE);
+  m_max_compressed_block_size=LZ4_compressBound(int(m_block_size));
+  m_num_batch_blocks=mp_job_queue::has_active()?min<unsigned>(mp_job_queue::active().num_worker_threads()+1, max_batch_blocks):1;
+  m_buffer_uncompressed=PFC_MEM_ALLOC(usize_t(m_block_size)*m_num_batch_blocks);
+  m_buffer_compressed=PFC_MEM_ALLOC(usize_t(m_max_compressed_block_size)*m_num_batch_blocks);
+
+  // initialize buffer pointers and write stream header
+  m_begin=m_data=(uint8_t*)m_buffer_uncompressed.data;
+  m_end=m_begin+usize_t(m_block_size)*m_num_batch_blocks;
+  m_begin_pos=0;
+  m_stream<<m_block_size;
+}
+//----
+
+lz4_output_stream::~lz4_output_stream()
+{
+  flush_buffer_impl(0, 0);
+  m_stream<<uint32_t(0)<<uint32_t(0);
+}
+//----------------------------------------------------------------------------
+
+void lz4_output_stream::flush_buffer_impl(const void *p_, usize_t num_bytes_)
+{
+  // compress buffered blocks upon flush
+  if(!p_)
+  {
+    compress_blocks();
+    return;
+  }
+
+  // fill the buffer and compress the blocks when the buffer is full
+  while(true)
+  {
+    usize_t num_copied=min(num_bytes_, usize_t(m_end-m_data));
+    mem_copy(m_data, p_, num_copied);
+    m_data+=num_copied;
+    (const uint8_t*&)p_+=num_copied;
+    num_bytes_-=num_copied;
+    if(m_data!=m_end)
+      break;
+    compress_blocks();
+    if(!num_bytes_)
+      break;
+  }
+}
+//----------------------------------------------------------------------------
+
+void lz4_output_stream::compress_blocks()
+{
+  // setup compression of the buffered blocks
+  usize_t num_bytes=usize_t(m_data-m_begin);
+  if(!num_bytes)
+    return;
+  block_job jobs[max_batch_blocks];
+  unsigned num_blocks=unsigned((num_bytes+m_block_size-1)/m_block_size);
+  for(unsigned i=0; i<num_blocks; ++i)
+  {
+    block_job &job=jobs[i];
+    job.src=m_begin+usize_t(i)*m_block_size;
+    job.dst=(uint8_t*)m_buffer_compressed.data+usize_t(i)*m_max_compressed_block_size;
+    job.src_size=uint32_t(min<usize_t>(num_bytes-usize_t(i)*m_block_size, m_block_size));
+    job.dst_size=0;
+  }
+
+  // compress blocks in parallel on the job queue (if any)
+  if(num_blocks<2 || !mp_job_queue::has_active())
+  {
+    for(unsigned i=0; i<num_blocks; ++i)
+      compress_block(jobs+i, 0);
+  }
+  else
+  {
+    // wait only for the blocks of this stream
+    mp_job_queue &jq=mp_job_queue::active();
+    e_jobtype_id job_type=jq.find_or_create_job_type("lz4 block compression", &compress_block);
+    volatile uint32_t job_counter=0;
+    for(unsigned i=0; i<num_blocks; ++i)
+      jq.add_job(job_type, jobs+i, job_counter);
+    jq.wait_jobs(job_counter);
+  }
+
+  // write the blocks in order (store uncompressed if the block doesn't compress)
+  for(unsigned i=0; i<num_blocks; ++i)
+  {
+    const block_job &job=jobs[i];
+    if(job.dst_size && job.dst_size<job.src_size)
+    {
+      m_stream<<job.dst_size<<job.src_size;
+      m_stream.write_bytes(job.dst, job.dst_size);
+    }
+    else
+    {
+      m_stream<<uint32_t(job.src_size|lz4_block_flag_uncompressed)<<job.src_size;
+      m_stream.write_bytes(job.src, job.src_size);
+    }
+  }
+  m_begin_pos+=num_bytes;
+  m_data=m_begin;
+}
+//----
+
+void lz4_output_stream::compress_block(block_job *job_, void*)
+{
+  job_->dst_size=uint32_t(LZ4_compress_default((const char*)job_->src, (char*)job_->dst, int(job_->src_size), LZ4_compressBound(int(job_->src_size))));
+}
+//----------------------------------------------------------------------------
+#endif // PFC_ENGINEOP_LZ4
@@ -0,0 +1,114 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_CORE_LZ4_H
+#define PFC_CORE_LZ4_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "streams.h"
+namespace pfc
+{
+
+// new
+class lz4_input_stream;
+class lz4_output_stream;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// lz4_input_stream
+//============================================================================
+class lz4_input_stream: public bin_input_stream_base
+{
+public:
+  // construction
+  lz4_input_stream(bin_input_stream_base&);
+  virtual ~lz4_input_stream();
+  //--------------------------------------------------------------------------
+
+private:
+  lz4_input_stream(const lz4_input_stream&); // not implemented
+  void operator=(const lz4_input_stream&); // not implemented
+  //--------------------------------------------------------------------------
+
+  // stream implementation
+  virtual usize_t update_buffer_impl(void*, usize_t num_bytes_, bool exact_);
+  virtual void rewind_impl();
+  virtual void rewind_impl(usize_t num_bytes_);
+  virtual void skip_impl();
+  virtual void seek_impl(usize_t abs_pos_);
+  //--------------------------------------------------------------------------
+
+  // helpers
+  void init_stream();
+  void read_block_header();
+  void decode_block(void*);
+  void skip_block();
+  //--------------------------------------------------------------------------
+
+  bin_input_stream_base &m_stream;
+  usize_t m_stream_start_pos;
+  uint32_t m_block_size;
+  uint32_t m_next_block_compressed_size;
+  uint32_t m_next_block_size;
+  owner_data m_buffer_compressed;
+  owner_data m_buffer_uncompressed;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// lz4_output_stream
+//============================================================================
+class lz4_output_stream: public bin_output_stream_base
+{
+public:
+  // construction
+  enum {default_block_size=64*1024};
+  lz4_output_stream(bin_output_stream_base&, usize_t block_size_=default_block_size);
+  virtual ~lz4_output_stream();
+  //--------------------------------------------------------------------------
+
+private:
+  lz4_output_stream(const lz4_output_stream&); // not implemented
+  void operator=(const lz4_output_stream&); // not implemented
+  //--------------------------------------------------------------------------
+
+  // stream implementation
+  virtual void flush_buffer_impl(const void*, usize_t num_bytes_);
+  //--------------------------------------------------------------------------
+
+  // helpers
+  struct block_job
+  {
+    const uint8_t *src;
+    uint8_t *dst;
+    uint32_t src_size;
+    uint32_t dst_size;
+  };
+  void compress_blocks();
+  static void compress_block(block_job*, void*);
+  //--------------------------------------------------------------------------
+
+  enum {max_batch_blocks=16};
+  bin_output_stream_base &m_stream;
+  const uint32_t m_block_size;
+  uint32_t m_max_compressed_block_size;
+  unsigned m_num_batch_blocks;
+  owner_data m_buffer_uncompressed;
+  owner_data m_buffer_compressed;
+};
+//----------------------------------------------------------------------------
+
+//============================================================================
+} // namespace pfc
+#endif
@@ -0,0 +1,1038 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "sxp_src/sxp_pch.h"
+#include "bvh3.h"
+#include "sxp_src/core/math/bit_math.h"
+#include "sxp_src/core/mp/mp_job_queue.h"
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  enum {bvh_num_bins=16};                    // number of SAH bins per axis
+  enum {bvh_max_leaf_tris=16};               // maximum number of triangles in a leaf if splitting doesn't pay off
+  enum {bvh_max_sah_depth=48};               // depth after which nodes are split at the median
+  enum {bvh_min_job_tris=4096};              // minimum number of triangles in a sub-tree to build it as a separate job
+  enum {bvh_max_stack_depth=128};            // traversal stack size
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // build_prim
+  //==========================================================================
+  struct build_prim
+  {
+    vec3f bmin, bmax;
+    vec3f center;
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // stack_entry
+  //==========================================================================
+  struct stack_entry
+  {
+    uint32_t node_idx;
+    float dist;
+  };
+  //--------------------------------------------------------------------------
+
+  PFC_INLINE float half_area(const vec3f &bmin_, const vec3f &bmax_)
+  {
+    vec3f e=bmax_-bmin_;
+    return e.x*e.y+e.y*e.z+e.z*e.x;
+  }
+  //----
+
+  PFC_INLINE bool isect_ray_box(float &t_, const vec3f &pos_, const vec3f &inv_dir_, const vec3f &bmin_, const vec3f &bmax_, float max_t_)
+  {
+    // slab test against the box
+    float tx0=(bmin_.x-pos_.x)*inv_dir_.x, tx1=(bmax_.x-pos_.x)*inv_dir_.x;
+    float ty0=(bmin_.y-pos_.y)*inv_dir_.y, ty1=(bmax_.y-pos_.y)*inv_dir_.y;
+    float tz0=(bmin_.z-pos_.z)*inv_dir_.z, tz1=(bmax_.z-pos_.z)*inv_dir_.z;
+    float tmin=max(min(tx0, tx1), min(ty0, ty1), min(tz0, tz1), 0.0f);
+    float tmax=min(max(tx0, tx1), max(ty0, ty1), max(tz0, tz1), max_t_);
+    t_=tmin;
+    return tmin<=tmax;
+  }
+  //----
+
+  PFC_INLINE bool isect_ray_tri(float &t_, float &u_, float &v_, const vec3f &pos_, const vec3f &dir_, const vec3f &a_, const vec3f &b_, const vec3f &c_, float max_t_)
+  {
+    // two-sided Moller-Trumbore ray-triangle test
+    vec3f e0=b_-a_, e1=c_-a_;
+    vec3f p=cross(dir_, e1);
+    float det=dot(e0, p);
+    if(!det)
+      return false;
+    float rdet=1.0f/det;
+    vec3f s=pos_-a_;
+    float u=dot(s, p)*rdet;
+    if(u<0.0f || u>1.0f)
+      return false;
+    vec3f q=cross(s, e0);
+    float v=dot(dir_, q)*rdet;
+    if(v<0.0f || u+v>1.0f)
+      return false;
+    float t=dot(e1, q)*rdet;
+    if(t<0.0f || t>=max_t_)
+      return false;
+    t_=t;
+    u_=u;
+    v_=v;
+    return true;
+  }
+  //----
+
+  PFC_INLINE float dist2_point_box(const vec3f &p_, const vec3f &bmin_, const vec3f &bmax_)
+  {
+    vec3f d=max(bmin_-p_, p_-bmax_, vec3f(0.0f));
+    return norm2(d);
+  }
+  //----
+
+  vec3f closest_point_tri(const vec3f &p_, const vec3f &a_, const vec3f &b_, const vec3f &c_)
+  {
+    // check if the point is in the vertex region of a
+    vec3f ab=b_-a_, ac=c_-a_, ap=p_-a_;
+    float d1=dot(ab, ap), d2=dot(ac, ap);
+    if(d1<=0.0f && d2<=0.0f)
+      return a_;
+
+    // check if the point is in the vertex region of b or in the edge region of ab
+    vec3f bp=p_-b_;
+    float d3=dot(ab, bp), d4=dot(ac, bp);
+    if(d3>=0.0f && d4<=d3)
+      return b_;
+    float vc=d1*d4-d3*d2;
+    if(vc<=0.0f && d1>=0.0f && d3<=0.0f)
+      return a_+ab*(d1/(d1-d3));
+
+    // check if the point is in the vertex region of c or in the edge region of ac
+    vec3f cp=p_-c_;
+    float d5=dot(ab, cp), d6=dot(ac, cp);
+    if(d6>=0.0f && d5<=d6)
+      return c_;
+    float vb=d5*d2-d1*d6;
+    if(vb<=0.0f && d2>=0.0f && d6<=0.0f)
+      return a_+ac*(d2/(d2-d6));
+
+    // check if the point is in the edge region of bc
+    float va=d3*d6-d5*d4;
+    if(va<=0.0f && (d4-d3)>=0.0f && (d5-d6)>=0.0f)
+      return b_+(c_-b_)*((d4-d3)/((d4-d3)+(d5-d6)));
+
+    // the point is inside the face region
+    float rd=1.0f/(va+vb+vc);
+    return a_+ab*(vb*rd)+ac*(vc*rd);
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// triangle_mesh_bvh3::build_context
+//============================================================================
+struct triangle_mesh_bvh3::build_context
+{
+  node *nodes;
+  build_task *tasks;
+  const build_prim *prims;
+  uint32_t *prim_ids;
+  volatile uint32_t num_nodes;
+  unsigned max_leaf_tris;
+  e_jobtype_id job_type;
+  volatile uint32_t job_counter;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// triangle_mesh_bvh3::build_task
+//============================================================================
+struct triangle_mesh_bvh3::build_task
+{
+  build_context *context;
+  uint32_t start, count;
+  unsigned depth;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// triangle_mesh_bvh3
+//============================================================================
+triangle_mesh_bvh3::triangle_mesh_bvh3()
+{
+}
+//----
+
+triangle_mesh_bvh3::triangle_mesh_bvh3(const vec3f *points_, usize_t num_points_, const uint32_t *tri_indices_, usize_t num_tris_, unsigned max_leaf_tris_)
+{
+  init(points_, num_points_, tri_indices_, num_tris_, max_leaf_tris_);
+}
+//----
+
+void triangle_mesh_bvh3::init(const vec3f *points_, usize_t num_points_, const uint32_t *tri_indices_, usize_t num_tris_, unsigned max_leaf_tris_)
+{
+  // setup points and triangle bounds
+  PFC_PERF_TIMER_AUTO(triangle_mesh_bvh3_init, "geometry", "triangle_mesh_bvh3::init()");
+  PFC_ASSERT(max_leaf_tris_>0 && max_leaf_tris_<=bvh_max_leaf_tris);
+  PFC_ASSERT_MSG(num_tris_<0x80000000, ("Too many triangles (%i) for BVH\r\n", num_tris_));
+  clear();
+  if(!num_tris_)
+    return;
+  m_points.insert_back(num_points_, points_);
+  array<build_prim> prims(num_tris_);
+  array<uint32_t> prim_ids(num_tris_);
+  for(usize_t i=0; i<num_tris_; ++i)
+  {
+    const uint32_t *vidx=tri_indices_+i*3;
+    PFC_ASSERT_PEDANTIC(vidx[0]<num_points_ && vidx[1]<num_points_ && vidx[2]<num_points_);
+    const vec3f &a=points_[vidx[0]], &b=points_[vidx[1]], &c=points_[vidx[2]];
+    build_prim &p=prims[i];
+    p.bmin=min(a, b, c);
+    p.bmax=max(a, b, c);
+    p.center=(p.bmin+p.bmax)*0.5f;
+    prim_ids[i]=uint32_t(i);
+  }
+
+  // build the tree (distribute large sub-trees to the job queue if available)
+  m_nodes.resize(num_tris_*2);
+  build_context ctx;
+  ctx.nodes=m_nodes.data();
+  ctx.tasks=0;
+  ctx.prims=prims.data();
+  ctx.prim_ids=prim_ids.data();
+  ctx.num_nodes=1;
+  ctx.max_leaf_tris=max_leaf_tris_;
+  ctx.job_type=e_jobtype_id(0);
+  ctx.job_counter=0;
+  array<build_task> tasks;
+  if(mp_job_queue::has_active() && num_tris_>=bvh_min_job_tris*2)
+  {
+    ctx.job_type=find_or_create_job_type("triangle_mesh_bvh3 build", &build_job);
+    tasks.resize(num_tris_*2);
+    ctx.tasks=tasks.data();
+  }
+  build_node(ctx, 0, 0, uint32_t(num_tris_), 0);
+  if(ctx.job_type)
+    wait_jobs(ctx.job_counter);
+  m_nodes.resize(ctx.num_nodes);
+  m_nodes.trim();
+
+  // setup triangles in the leaf order
+  m_tris.resize(num_tris_);
+  for(usize_t i=0; i<num_tris_; ++i)
+  {
+    tri &t=m_tris[i];
+    uint32_t tidx=prim_ids[i];
+    const uint32_t *vidx=tri_indices_+tidx*3;
+    t.vidx[0]=vidx[0];
+    t.vidx[1]=vidx[1];
+    t.vidx[2]=vidx[2];
+    t.tri_idx=tidx;
+  }
+}
+//----
+
+void triangle_mesh_bvh3::refit(const vec3f *points_)
+{
+  // update points and node bounds bottom-up (children always follow parents)
+  if(!m_nodes.size())
+    return;
+  mem_copy(m_points.data(), points_, m_points.size()*sizeof(vec3f));
+  const vec3f *points=m_points.data();
+  const tri *tris=m_tris.data();
+  node *nodes=m_nodes.data();
+  usize_t ni=m_nodes.size();
+  do
+  {
+    node &n=nodes[--ni];
+    if(n.num_tris)
+    {
+      // calculate leaf bounds from triangles
+      const tri *t=tris+n.data, *tend=t+n.num_tris;
+      vec3f bmin=points[t->vidx[0]], bmax=bmin;
+      do
+      {
+        for(unsigned vi=0; vi<3; ++vi)
+        {
+          const vec3f &p=points[t->vidx[vi]];
+          bmin=min(bmin, p);
+          bmax=max(bmax, p);
+        }
+      } while(++t!=tend);
+      n.bmin=bmin;
+      n.bmax=bmax;
+    }
+    else
+    {
+      // merge child bounds
+      const node &c0=nodes[n.data], &c1=nodes[n.data+1];
+      n.bmin=min(c0.bmin, c1.bmin);
+      n.bmax=max(c0.bmax, c1.bmax);
+    }
+  } while(ni);
+}
+//----
+
+void triangle_mesh_bvh3::clear()
+{
+  m_points.clear();
+  m_tris.clear();
+  m_nodes.clear();
+}
+//----------------------------------------------------------------------------
+
+bool triangle_mesh_bvh3::ray_cast(triangle_mesh_bvh3_hit &hit_, const ray3f &ray_, float max_t_) const
+{
+  // check for ray hitting the root
+  if(!m_nodes.size())
+    return false;
+  const node *nodes=m_nodes.data();
+  const tri *tris=m_tris.data();
+  const vec3f *points=m_points.data();
+  vec3f inv_dir=safe_rcp_dir(ray_.dir);
+  float max_t=max_t_, t;
+  if(!isect_ray_box(t, ray_.pos, inv_dir, nodes->bmin, nodes->bmax, max_t))
+    return false;
+
+  // traverse the tree front-to-back
+  stack_entry stack[bvh_max_stack_depth];
+  unsigned stack_size=0;
+  const tri *hit_tri=0;
+  uint32_t node_idx=0;
+  for(;;)
+  {
+    const node &n=nodes[node_idx];
+    if(n.num_tris)
+    {
+      // test leaf triangles
+      const tri *tr=tris+n.data, *tend=tr+n.num_tris;
+      do
+      {
+        float u, v;
+        if(isect_ray_tri(t, u, v, ray_.pos, ray_.dir, points[tr->vidx[0]], points[tr->vidx[1]], points[tr->vidx[2]], max_t))
+        {
+          max_t=t;
+          hit_.u=u;
+          hit_.v=v;
+          hit_tri=tr;
+        }
+      } while(++tr!=tend);
+    }
+    else
+    {
+      // test children and descend to the nearest one
+      uint32_t c0=n.data, c1=c0+1;
+      float t0, t1;
+      bool h0=isect_ray_box(t0, ray_.pos, inv_dir, nodes[c0].bmin, nodes[c0].bmax, max_t);
+      bool h1=isect_ray_box(t1, ray_.pos, inv_dir, nodes[c1].bmin, nodes[c1].bmax, max_t);
+      if(h0 && h1)
+      {
+        if(t1<t0)
+        {
+          swap(c0, c1);
+          swap(t0, t1);
+        }
+        PFC_ASSERT_PEDANTIC(stack_size<bvh_max_stack_depth);
+        stack[stack_size].node_idx=c1;
+        stack[stack_size].dist=t1;
+        ++stack_size;
+        node_idx=c0;
+        continue;
+      }
+      if(h0 || h1)
+      {
+        node_idx=h0?c0:c1;
+        continue;
+      }
+    }
+
+    // pop the next node closer than the current hit
+    do
+    {
+      if(!stack_size)
+      {
+        if(!hit_tri)
+          return false;
+        hit_.t=max_t;
+        hit_.tri_idx=hit_tri->tri_idx;
+        return true;
+      }
+      --stack_size;
+    } while(stack[stack_size].dist>max_t);
+    node_idx=stack[stack_size].node_idx;
+  }
+}
+//----
+
+bool triangle_mesh_bvh3::ray_any_hit(const ray3f &ray_, float max_t_) const
+{
+  // check for ray hitting the root
+  if(!m_nodes.size())
+    return false;
+  const node *nodes=m_nodes.data();
+  const tri *tris=m_tris.data();
+  const vec3f *points=m_points.data();
+  vec3f inv_dir=safe_rcp_dir(ray_.dir);
+  float t;
+  if(!isect_ray_box(t, ray_.pos, inv_dir, nodes->bmin, nodes->bmax, max_t_))
+    return false;
+
+  // traverse the tree until any triangle is hit
+  uint32_t stack[bvh_max_stack_depth];
+  unsigned stack_size=0;
+  uint32_t node_idx=0;
+  for(;;)
+  {
+    const node &n=nodes[node_idx];
+    if(n.num_tris)
+    {
+      const tri *tr=tris+n.data, *tend=tr+n.num_tris;
+      do
+      {
+        float u, v;
+        if(isect_ray_tri(t, u, v, ray_.pos, ray_.dir, points[tr->vidx[0]], points[tr->vidx[1]], points[tr->vidx[2]], max_t_))
+          return true;
+      } while(++tr!=tend);
+    }
+    else
+    {
+      uint32_t c0=n.data;
+      bool h0=isect_ray_box(t, ray_.pos, inv_dir, nodes[c0].bmin, nodes[c0].bmax, max_t_);
+      bool h1=isect_ray_box(t, ray_.pos, inv_dir, nodes[c0+1].bmin, nodes[c0+1].bmax, max_t_);
+      if(h0 && h1)
+      {
+        PFC_ASSERT_PEDANTIC(stack_size<bvh_max_stack_depth);
+        stack[stack_size++]=c0+1;
+        node_idx=c0;
+        continue;
+      }
+      if(h0 || h1)
+      {
+        node_idx=h0?c0:c0+1;
+        continue;
+      }
+    }
+    if(!stack_size)
+      return false;
+    node_idx=stack[--stack_size];
+  }
+}
+//----
+
+bool triangle_mesh_bvh3::closest_point(triangle_mesh_bvh3_point &res_, const vec3f &pos_, float max_dist_) const
+{
+  // check for the root being within the search distance
+  if(!m_nodes.size())
+    return false;
+  const node *nodes=m_nodes.data();
+  const tri *tris=m_tris.data();
+  const vec3f *points=m_points.data();
+  float max_dist2=max_dist_<numeric_type<float>::range_max()?max_dist_*max_dist_:max_dist_;
+  if(dist2_point_box(pos_, nodes->bmin, nodes->bmax)>max_dist2)
+    return false;
+
+  // traverse the tree visiting nearest nodes first
+  stack_entry stack[bvh_max_stack_depth];
+  unsigned stack_size=0;
+  const tri *res_tri=0;
+  uint32_t node_idx=0;
+  for(;;)
+  {
+    const node &n=nodes[node_idx];
+    if(n.num_tris)
+    {
+      // find closest point on leaf triangles
+      const tri *tr=tris+n.data, *tend=tr+n.num_tris;
+      do
+      {
+        vec3f p=closest_point_tri(pos_, points[tr->vidx[0]], points[tr->vidx[1]], points[tr->vidx[2]]);
+        float d2=norm2(p-pos_);
+        if(d2<=max_dist2)
+        {
+          max_dist2=d2;
+          res_.pos=p;
+          res_tri=tr;
+        }
+      } while(++tr!=tend);
+    }
+    else
+    {
+      // descend to the nearest child within the search distance
+      uint32_t c0=n.data, c1=c0+1;
+      float d0=dist2_point_box(pos_, nodes[c0].bmin, nodes[c0].bmax);
+      float d1=dist2_point_box(pos_, nodes[c1].bmin, nodes[c1].bmax);
+      if(d1<d0)
+      {
+        swap(c0, c1);
+        swap(d0, d1);
+      }
+      if(d0<=max_dist2)
+      {
+        if(d1<=max_dist2)
+        {
+          PFC_ASSERT_PEDANTIC(stack_size<bvh_max_stack_depth);
+          stack[stack_size].node_idx=c1;
+          stack[stack_size].dist=d1;
+          ++stack_size;
+        }
+        node_idx=c0;
+        continue;
+      }
+    }
+
+    // pop the next node within the search distance
+    do
+    {
+      if(!stack_size)
+      {
+        if(!res_tri)
+          return false;
+        res_.dist2=max_dist2;
+        res_.tri_idx=res_tri->tri_idx;
+        return true;
+      }
+      --stack_size;
+    } while(stack[stack_size].dist>max_dist2);
+    node_idx=stack[stack_size].node_idx;
+  }
+}
+//----------------------------------------------------------------------------
+
+unsigned triangle_mesh_bvh3::ray_cast(triangle_mesh_bvh3_hit hits_[4], const soa4_ray3f &rays_, const float *max_t_) const
+{
+  // check for rays hitting the root
+  if(!m_nodes.size())
+    return 0;
+  const node *nodes=m_nodes.data();
+  const tri *tris=m_tris.data();
+  const vec3f *points=m_points.data();
+  float max_t[4], t[4], u[4], v[4], t0[4], t1[4];
+  for(unsigned i=0; i<4; ++i)
+    max_t[i]=max_t_?max_t_[i]:numeric_type<float>::range_max();
+  if(!isect(t0, rays_, nodes->bmin, nodes->bmax, max_t))
+    return 0;
+
+  // traverse the tree with the packet front-to-back (ordered by the first ray hitting both children)
+  uint32_t stack[bvh_max_stack_depth];
+  unsigned stack_size=0;
+  unsigned hit_mask=0;
+  uint32_t node_idx=0;
+  for(;;)
+  {
+    const node &n=nodes[node_idx];
+    if(n.num_tris)
+    {
+      // test leaf triangles with the packet
+      const tri *tr=tris+n.data, *tend=tr+n.num_tris;
+      do
+      {
+        tri3f tri3(points[tr->vidx[0]], points[tr->vidx[1]], points[tr->vidx[2]]);
+        uint32_t mask=isect(t, u, v, rays_, tri3, max_t);
+        hit_mask|=mask;
+        while(mask)
+        {
+          unsigned lane=lsb_pos(mask);
+          mask=strip_lsb(mask);
+          max_t[lane]=t[lane];
+          triangle_mesh_bvh3_hit &hit=hits_[lane];
+          hit.t=t[lane];
+          hit.u=u[lane];
+          hit.v=v[lane];
+          hit.tri_idx=tr->tri_idx;
+        }
+      } while(++tr!=tend);
+    }
+    else
+    {
+      // test children with the packet and descend to the nearest one
+      uint32_t c0=n.data, c1=c0+1;
+      unsigned m0=isect(t0, rays_, nodes[c0].bmin, nodes[c0].bmax, max_t);
+      unsigned m1=isect(t1, rays_, nodes[c1].bmin, nodes[c1].bmax, max_t);
+      if(m0 && m1)
+      {
+        uint32_t m01=m0&m1;
+        unsigned lane=lsb_pos(uint32_t(m01?m01:m0));
+        if(m01 && t1[lane]<t0[lane])
+          swap(c0, c1);
+        PFC_ASSERT_PEDANTIC(stack_size<bvh_max_stack_depth);
+        stack[stack_size++]=c1;
+        node_idx=c0;
+        continue;
+      }
+      if(m0 || m1)
+      {
+        node_idx=m0?c0:c1;
+        continue;
+      }
+    }
+
+    // pop the next node
+    if(!stack_size)
+      return hit_mask;
+    node_idx=stack[--stack_size];
+  }
+}
+//----
+
+unsigned triangle_mesh_bvh3::ray_any_hit(const soa4_ray3f &rays_, const float *max_t_) const
+{
+  // check for rays hitting the root
+  if(!m_nodes.size())
+    return 0;
+  const node *nodes=m_nodes.data();
+  const tri *tris=m_tris.data();
+  const vec3f *points=m_points.data();
+  float max_t[4], t[4], u[4], v[4];
+  for(unsigned i=0; i<4; ++i)
+    max_t[i]=max_t_?max_t_[i]:numeric_type<float>::range_max();
+  if(!isect(t, rays_, nodes->bmin, nodes->bmax, max_t))
+    return 0;
+
+  // traverse the tree until all rays have hit a triangle (hit rays are disabled with negative max t)
+  uint32_t stack[bvh_max_stack_depth];
+  unsigned stack_size=0;
+  unsigned hit_mask=0;
+  uint32_t node_idx=0;
+  for(;;)
+  {
+    const node &n=nodes[node_idx];
+    if(n.num_tris)
+    {
+      const tri *tr=tris+n.data, *tend=tr+n.num_tris;
+      do
+      {
+        tri3f tri3(points[tr->vidx[0]], points[tr->vidx[1]], points[tr->vidx[2]]);
+        uint32_t mask=isect(t, u, v, rays_, tri3, max_t);
+        if(mask)
+        {
+          hit_mask|=mask;
+          if(hit_mask==0xf)
+            return hit_mask;
+          do
+          {
+            max_t[lsb_pos(mask)]=-1.0f;
+            mask=strip_lsb(mask);
+          } while(mask);
+        }
+      } while(++tr!=tend);
+    }
+    else
+    {
+      uint32_t c0=n.data;
+      unsigned m0=isect(t, rays_, nodes[c0].bmin, nodes[c0].bmax, max_t);
+      unsigned m1=isect(t, rays_, nodes[c0+1].bmin, nodes[c0+1].bmax, max_t);
+      if(m0 && m1)
+      {
+        PFC_ASSERT_PEDANTIC(stack_size<bvh_max_stack_depth);
+        stack[stack_size++]=c0+1;
+        node_idx=c0;
+        continue;
+      }
+      if(m0 || m1)
+      {
+        node_idx=m0?c0:c0+1;
+        continue;
+      }
+    }
+    if(!stack_size)
+      return hit_mask;
+    node_idx=stack[--stack_size];
+  }
+}
+//----------------------------------------------------------------------------
+
+void triangle_mesh_bvh3::build_node(build_context &ctx_, uint32_t node_idx_, uint32_t start_, uint32_t count_, unsigned depth_)
+{
+  const build_prim *prims=ctx_.prims;
+  for(;;)
+  {
+    // calculate node bounds and bounds of the triangle centers
+    node &n=ctx_.nodes[node_idx_];
+    uint32_t *ids=ctx_.prim_ids+start_;
+    vec3f bmin=prims[ids[0]].bmin, bmax=prims[ids[0]].bmax;
+    vec3f cmin=prims[ids[0]].center, cmax=cmin;
+    for(uint32_t i=1; i<count_; ++i)
+    {
+      const build_prim &p=prims[ids[i]];
+      bmin=min(bmin, p.bmin);
+      bmax=max(bmax, p.bmax);
+      cmin=min(cmin, p.center);
+      cmax=max(cmax, p.center);
+    }
+    n.bmin=bmin;
+    n.bmax=bmax;
+    if(count_<=ctx_.max_leaf_tris)
+    {
+      n.data=start_;
+      n.num_tris=count_;
+      return;
+    }
+
+    // find the best split with binned SAH
+    vec3f cext=cmax-cmin;
+    float best_cost=numeric_type<float>::range_max();
+    unsigned best_axis=0, best_bin=0;
+    float best_bin_scale=0.0f, best_bin_offs=0.0f;
+    if(depth_<bvh_max_sah_depth)
+      for(unsigned axis=0; axis<3; ++axis)
+      {
+        // bin triangles by their centers
+        if(cext[axis]<=0.0f)
+          continue;
+        uint32_t bin_counts[bvh_num_bins]={0};
+        vec3f bin_min[bvh_num_bins], bin_max[bvh_num_bins];
+        for(unsigned bi=0; bi<bvh_num_bins; ++bi)
+        {
+          bin_min[bi]=vec3f(numeric_type<float>::range_max());
+          bin_max[bi]=vec3f(-numeric_type<float>::range_max());
+        }
+        float bin_scale=float(bvh_num_bins)*0.9999f/cext[axis], bin_offs=cmin[axis];
+        for(uint32_t i=0; i<count_; ++i)
+        {
+          const build_prim &p=prims[ids[i]];
+          unsigned bi=unsigned((p.center[axis]-bin_offs)*bin_scale);
+          ++bin_counts[bi];
+          bin_min[bi]=min(bin_min[bi], p.bmin);
+          bin_max[bi]=max(bin_max[bi], p.bmax);
+        }
+
+        // sweep the bins from right to left and evaluate split costs left to right
+        float right_area[bvh_num_bins];
+        vec3f rmin=bin_min[bvh_num_bins-1], rmax=bin_max[bvh_num_bins-1];
+        for(unsigned bi=bvh_num_bins-1; bi>0; --bi)
+        {
+          rmin=min(rmin, bin_min[bi]);
+          rmax=max(rmax, bin_max[bi]);
+          right_area[bi]=half_area(rmin, rmax);
+        }
+        vec3f lmin=bin_min[0], lmax=bin_max[0];
+        uint32_t left_count=0;
+        for(unsigned bi=0; bi<bvh_num_bins-1; ++bi)
+        {
+          lmin=min(lmin, bin_min[bi]);
+          lmax=max(lmax, bin_max[bi]);
+          left_count+=bin_counts[bi];
+          if(!left_count || left_count==count_)
+            continue;
+          float cost=float(left_count)*half_area(lmin, lmax)+float(count_-left_count)*right_area[bi+1];
+          if(cost<best_cost)
+          {
+            best_cost=cost;
+            best_axis=axis;
+            best_bin=bi;
+            best_bin_scale=bin_scale;
+            best_bin_offs=bin_offs;
+          }
+        }
+      }
+
+    // check if splitting the node pays off
+    float node_area=half_area(bmin, bmax);
+    if(   count_<=bvh_max_leaf_tris
+       && best_cost>=(float(count_)-1.0f)*node_area)
+    {
+      n.data=start_;
+      n.num_tris=count_;
+      return;
+    }
+
+    // partition triangles to the children
+    uint32_t num_left=count_/2;
+    if(best_cost<numeric_type<float>::range_max())
+    {
+      uint32_t *first=ids, *last=ids+count_;
+      while(first<last)
+      {
+        if(unsigned((prims[*first].center[best_axis]-best_bin_offs)*best_bin_scale)<=best_bin)
+          ++first;
+        else
+          swap(*first, *--last);
+      }
+      num_left=uint32_t(first-ids);
+    }
+
+    // build children, large left sub-trees as separate jobs
+    uint32_t child_idx=atom_add(ctx_.num_nodes, 2u);
+    n.data=child_idx;
+    n.num_tris=0;
+    if(ctx_.job_type && num_left>=bvh_min_job_tris)
+    {
+      build_task &task=ctx_.tasks[child_idx];
+      task.context=&ctx_;
+      task.start=start_;
+      task.count=num_left;
+      task.depth=depth_+1;
+      add_job(ctx_.job_type, &task, ctx_.job_counter);
+    }
+    else
+      build_node(ctx_, child_idx, start_, num_left, depth_+1);
+    node_idx_=child_idx+1;
+    start_+=num_left;
+    count_-=num_left;
+    ++depth_;
+  }
+}
+//----
+
+void triangle_mesh_bvh3::build_job(build_task *task_, void*)
+{
+  build_context &ctx=*task_->context;
+  build_node(ctx, uint32_t(task_-ctx.tasks), task_->start, task_->count, task_->depth);
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// triangle_mesh_qbvh3
+//============================================================================
+triangle_mesh_qbvh3::triangle_mesh_qbvh3()
+{
+  m_root=0;
+}
+//----
+
+triangle_mesh_qbvh3::triangle_mesh_qbvh3(const triangle_mesh_bvh3 &bvh_)
+{
+  m_root=0;
+  init(bvh_);
+}
+//----
+
+void triangle_mesh_qbvh3::init(const triangle_mesh_bvh3 &bvh_)
+{
+  // collapse the binary tree to a 4-wide tree
+  PFC_PERF_TIMER_AUTO(triangle_mesh_qbvh3_init, "geometry", "triangle_mesh_qbvh3::init()");
+  clear();
+  if(!bvh_.m_nodes.size())
+    return;
+  m_nodes.reserve(bvh_.m_nodes.size()/2+1);
+  m_tri_packs.reserve(bvh_.m_nodes.size()/2+1);
+  const triangle_mesh_bvh3::node &root=bvh_.m_nodes[0];
+  m_root=root.num_tris?add_leaf(bvh_, root):add_node(bvh_, 0);
+  m_nodes.trim();
+  m_tri_packs.trim();
+}
+//----
+
+void triangle_mesh_qbvh3::clear()
+{
+  m_nodes.clear();
+  m_tri_packs.clear();
+  m_root=0;
+}
+//----------------------------------------------------------------------------
+
+bool triangle_mesh_qbvh3::ray_cast(triangle_mesh_bvh3_hit &hit_, const ray3f &ray_, float max_t_) const
+{
+  // traverse the tree front-to-back
+  if(!m_tri_packs.size())
+    return false;
+  const node *nodes=m_nodes.data();
+  const tri_pack *packs=m_tri_packs.data();
+  vec3f rcp_dir=safe_rcp_dir(ray_.dir);
+  float max_t=max_t_, t[4], u[4], v[4];
+  stack_entry stack[bvh_max_stack_depth];
+  unsigned stack_size=0;
+  uint32_t hit_tri_idx=0xffffffff;
+  uint32_t ref=m_root;
+  for(;;)
+  {
+    if(ref&leaf_flag)
+    {
+      // test leaf triangle packs
+      const tri_pack *pack=packs+((ref&~leaf_flag)>>3), *pend=pack+(ref&7)+1;
+      do
+      {
+        uint32_t mask=isect(t, u, v, ray_, pack->tris, max_t);
+        while(mask)
+        {
+          unsigned lane=lsb_pos(mask);
+          mask=strip_lsb(mask);
+          if(t[lane]<max_t)
+          {
+            max_t=t[lane];
+            hit_.u=u[lane];
+            hit_.v=v[lane];
+            hit_tri_idx=pack->tri_idx[lane];
+          }
+        }
+      } while(++pack!=pend);
+    }
+    else
+    {
+      // test child boxes, push far children and descend to the nearest one
+      const node &n=nodes[ref];
+      uint32_t mask=isect(t, ray_, rcp_dir, n.child_bounds, max_t)&((1<<n.num_children)-1);
+      if(mask)
+      {
+        unsigned near_lane=lsb_pos(mask);
+        mask=strip_lsb(mask);
+        while(mask)
+        {
+          unsigned lane=lsb_pos(mask);
+          mask=strip_lsb(mask);
+          unsigned push_lane=lane;
+          if(t[lane]<t[near_lane])
+          {
+            push_lane=near_lane;
+            near_lane=lane;
+          }
+          PFC_ASSERT_PEDANTIC(stack_size<bvh_max_stack_depth);
+          stack[stack_size].node_idx=n.children[push_lane];
+          stack[stack_size].dist=t[push_lane];
+          ++stack_size;
+        }
+        ref=n.children[near_lane];
+        continue;
+      }
+    }
+
+    // pop the next node closer than the current hit
+    do
+    {
+      if(!stack_size)
+      {
+        if(hit_tri_idx==0xffffffff)
+          return false;
+        hit_.t=max_t;
+        hit_.tri_idx=hit_tri_idx;
+        return true;
+      }
+      --stack_size;
+    } while(stack[stack_size].dist>max_t);
+    ref=stack[stack_size].node_idx;
+  }
+}
+//----
+
+bool triangle_mesh_qbvh3::ray_any_hit(const ray3f &ray_, float max_t_) const
+{
+  // traverse the tree until any triangle is hit
+  if(!m_tri_packs.size())
+    return false;
+  const node *nodes=m_nodes.data();
+  const tri_pack *packs=m_tri_packs.data();
+  vec3f rcp_dir=safe_rcp_dir(ray_.dir);
+  float t[4], u[4], v[4];
+  uint32_t stack[bvh_max_stack_depth];
+  unsigned stack_size=0;
+  uint32_t ref=m_root;
+  for(;;)
+  {
+    if(ref&leaf_flag)
+    {
+      const tri_pack *pack=packs+((ref&~leaf_flag)>>3), *pend=pack+(ref&7)+1;
+      do
+      {
+        if(isect(t, u, v, ray_, pack->tris, max_t_))
+          return true;
+      } while(++pack!=pend);
+    }
+    else
+    {
+      const node &n=nodes[ref];
+      uint32_t mask=isect(t, ray_, rcp_dir, n.child_bounds, max_t_)&((1<<n.num_children)-1);
+      if(mask)
+      {
+        ref=n.children[lsb_pos(mask)];
+        mask=strip_lsb(mask);
+        while(mask)
+        {
+          PFC_ASSERT_PEDANTIC(stack_size<bvh_max_stack_depth);
+          stack[stack_size++]=n.children[lsb_pos(mask)];
+          mask=strip_lsb(mask);
+        }
+        continue;
+      }
+    }
+    if(!stack_size)
+      return false;
+    ref=stack[--stack_size];
+  }
+}
+//----------------------------------------------------------------------------
+
+uint32_t triangle_mesh_qbvh3::add_leaf(const triangle_mesh_bvh3 &bvh_, const triangle_mesh_bvh3::node &bnode_)
+{
+  // pack leaf triangles to SoA packs of 4 triangles
+  uint32_t first_pack=uint32_t(m_tri_packs.size());
+  uint32_t num_packs=(bnode_.num_tris+3)/4;
+  PFC_ASSERT_MSG(num_packs<=8 && first_pack<(1<<28), ("Unable to reference the leaf triangles\r\n"));
+  const vec3f *points=bvh_.m_points.data();
+  const triangle_mesh_bvh3::tri *tr=bvh_.m_tris.data()+bnode_.data;
+  for(uint32_t pi=0; pi<num_packs; ++pi)
+  {
+    tri_pack &pack=m_tri_packs.push_back();
+    pack.tris.clear();
+    for(unsigned lane=0; lane<4; ++lane)
+    {
+      uint32_t ti=pi*4+lane;
+      if(ti<bnode_.num_tris)
+      {
+        pack.tris.set(lane, points[tr[ti].vidx[0]], points[tr[ti].vidx[1]], points[tr[ti].vidx[2]]);
+        pack.tri_idx[lane]=tr[ti].tri_idx;
+      }
+      else
+        pack.tri_idx[lane]=0xffffffff;
+    }
+  }
+  return leaf_flag|(first_pack<<3)|(num_packs-1);
+}
+//----
+
+uint32_t triangle_mesh_qbvh3::add_node(const triangle_mesh_bvh3 &bvh_, uint32_t bnode_idx_)
+{
+  // gather up to 4 children by opening the largest inner children
+  const triangle_mesh_bvh3::node *bnodes=bvh_.m_nodes.data();
+  uint32_t children[4]={bnodes[bnode_idx_].data, bnodes[bnode_idx_].data+1};
+  unsigned num_children=2;
+  while(num_children<4)
+  {
+    unsigned open_idx=4;
+    float max_area=-1.0f;
+    for(unsigned i=0; i<num_children; ++i)
+    {
+      const triangle_mesh_bvh3::node &c=bnodes[children[i]];
+      float area=half_area(c.bmin, c.bmax);
+      if(!c.num_tris && area>max_area)
+      {
+        open_idx=i;
+        max_area=area;
+      }
+    }
+    if(open_idx==4)
+      break;
+    uint32_t first=bnodes[children[open_idx]].data;
+    children[open_idx]=first;
+    children[num_children++]=first+1;
+  }
+
+  // setup the node and its children
+  uint32_t node_idx=uint32_t(m_nodes.size());
+  node &n=m_nodes.push_back();
+  n.child_bounds.clear();
+  n.num_children=num_children;
+  for(unsigned i=0; i<4; ++i)
+    n.children[i]=0xffffffff;
+  for(unsigned i=0; i<num_children; ++i)
+  {
+    const triangle_mesh_bvh3::node &c=bnodes[children[i]];
+    m_nodes[node_idx].child_bounds.set(i, c.bmin, c.bmax);
+    uint32_t ref=c.num_tris?add_leaf(bvh_, c):add_node(bvh_, children[i]);
+    m_nodes[node_idx].children[i]=ref;
+  }
+  return node_idx;
+}
+//----------------------------------------------------------------------------
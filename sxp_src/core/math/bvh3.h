@@ -0,0 +1,195 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_CORE_MATH_BVH3_H
+#define PFC_CORE_MATH_BVH3_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "prim3/prim3_soa.h"
+#include "sxp_src/core/containers.h"
+namespace pfc
+{
+
+// new
+struct triangle_mesh_bvh3_hit;
+struct triangle_mesh_bvh3_point;
+class triangle_mesh_bvh3;
+class triangle_mesh_qbvh3;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// triangle_mesh_bvh3_hit
+//============================================================================
+struct triangle_mesh_bvh3_hit
+{
+  float t;            // distance along the ray direction (in ray direction units)
+  float u, v;         // barycentric coordinates of the hit (hit=a+(b-a)*u+(c-a)*v)
+  uint32_t tri_idx;   // index of the hit triangle in the source triangle list
+};
+PFC_SET_TYPE_TRAIT(triangle_mesh_bvh3_hit, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// triangle_mesh_bvh3_point
+//============================================================================
+struct triangle_mesh_bvh3_point
+{
+  vec3f pos;          // closest point on the mesh surface
+  float dist2;        // squared distance from the query point to pos
+  uint32_t tri_idx;   // index of the closest triangle in the source triangle list
+};
+PFC_SET_TYPE_TRAIT(triangle_mesh_bvh3_point, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// triangle_mesh_bvh3
+//============================================================================
+// Bounding volume hierarchy of triangle list mesh for ray and closest point
+// queries. The tree is built top-down with binned SAH and the build of large
+// sub-trees is distributed to the active mp_job_queue (if any).
+class triangle_mesh_bvh3
+{
+public:
+  // construction
+  triangle_mesh_bvh3();
+  triangle_mesh_bvh3(const vec3f *points_, usize_t num_points_, const uint32_t *tri_indices_, usize_t num_tris_, unsigned max_leaf_tris_=4);
+  void init(const vec3f *points_, usize_t num_points_, const uint32_t *tri_indices_, usize_t num_tris_, unsigned max_leaf_tris_=4);
+  void refit(const vec3f *points_);
+  void clear();
+  //--------------------------------------------------------------------------
+
+  // accessors
+  PFC_INLINE usize_t num_points() const;
+  PFC_INLINE usize_t num_triangles() const;
+  PFC_INLINE usize_t num_nodes() const;
+  PFC_INLINE const vec3f *points() const;
+  PFC_INLINE aabox3f bounds() const;
+  //--------------------------------------------------------------------------
+
+  // queries
+  bool ray_cast(triangle_mesh_bvh3_hit&, const ray3f&, float max_t_=numeric_type<float>::range_max()) const;
+  bool ray_any_hit(const ray3f&, float max_t_=numeric_type<float>::range_max()) const;
+  bool closest_point(triangle_mesh_bvh3_point&, const vec3f&, float max_dist_=numeric_type<float>::range_max()) const;
+  //--------------------------------------------------------------------------
+
+  // packet queries (return bit mask of rays hitting the mesh, max_t_=0 for unlimited rays)
+  unsigned ray_cast(triangle_mesh_bvh3_hit hits_[4], const soa4_ray3f&, const float *max_t_=0) const;
+  unsigned ray_any_hit(const soa4_ray3f&, const float *max_t_=0) const;
+  //--------------------------------------------------------------------------
+
+private:
+  friend class triangle_mesh_qbvh3;
+  struct build_context;
+  struct build_task;
+  triangle_mesh_bvh3(const triangle_mesh_bvh3&); // not implemented
+  void operator=(const triangle_mesh_bvh3&); // not implemented
+  static void build_node(build_context&, uint32_t node_idx_, uint32_t start_, uint32_t count_, unsigned depth_);
+  static void build_job(build_task*, void*);
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // triangle_mesh_bvh3::node
+  //==========================================================================
+  struct node
+  {
+    vec3f bmin;         // node bounding box min
+    uint32_t data;      // inner: index of the first child (second at data+1), leaf: index of the first triangle
+    vec3f bmax;         // node bounding box max
+    uint32_t num_tris;  // number of triangles in a leaf (0 for inner nodes)
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // triangle_mesh_bvh3::tri
+  //==========================================================================
+  struct tri
+  {
+    uint32_t vidx[3];   // vertex indices of the triangle
+    uint32_t tri_idx;   // index of the triangle in the source triangle list
+  };
+  //--------------------------------------------------------------------------
+
+  array<vec3f> m_points;
+  array<tri> m_tris;
+  array<node> m_nodes;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// triangle_mesh_qbvh3
+//============================================================================
+// 4-wide BVH collapsed from triangle_mesh_bvh3 for SIMD single ray traversal:
+// a node tests its 4 child boxes and a leaf tests 4 triangles at once. To
+// refit, refit the source BVH and re-init the 4-wide BVH from it.
+class triangle_mesh_qbvh3
+{
+public:
+  // construction
+  triangle_mesh_qbvh3();
+  triangle_mesh_qbvh3(const triangle_mesh_bvh3&);
+  void init(const triangle_mesh_bvh3&);
+  void clear();
+  //--------------------------------------------------------------------------
+
+  // accessors
+  PFC_INLINE usize_t num_nodes() const;
+  PFC_INLINE usize_t num_tri_packs() const;
+  //--------------------------------------------------------------------------
+
+  // queries
+  bool ray_cast(triangle_mesh_bvh3_hit&, const ray3f&, float max_t_=numeric_type<float>::range_max()) const;
+  bool ray_any_hit(const ray3f&, float max_t_=numeric_type<float>::range_max()) const;
+  //--------------------------------------------------------------------------
+
+private:
+  triangle_mesh_qbvh3(const triangle_mesh_qbvh3&); // not implemented
+  void operator=(const triangle_mesh_qbvh3&); // not implemented
+  uint32_t add_leaf(const triangle_mesh_bvh3&, const triangle_mesh_bvh3::node&);
+  uint32_t add_node(const triangle_mesh_bvh3&, uint32_t bnode_idx_);
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // triangle_mesh_qbvh3::node
+  //==========================================================================
+  struct node
+  {
+    soa4_aabox3f child_bounds;  // bounds of the children
+    uint32_t children[4];       // child references (node index or leaf_flag|(first_pack<<3)|(num_packs-1))
+    uint32_t num_children;      // number of valid children (2-4)
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // triangle_mesh_qbvh3::tri_pack
+  //==========================================================================
+  struct tri_pack
+  {
+    soa4_tri3f tris;      // SoA triangle data (unused lanes are degenerate)
+    uint32_t tri_idx[4];  // index of the triangle in the source triangle list
+  };
+  //--------------------------------------------------------------------------
+
+  enum {leaf_flag=0x80000000};
+  array<node> m_nodes;
+  array<tri_pack> m_tri_packs;
+  uint32_t m_root;
+};
+//----------------------------------------------------------------------------
+
+//============================================================================
+#include "bvh3.inl"
+} // namespace pfc
+#endif
@@ -0,0 +1,59 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+
+//============================================================================
+// triangle_mesh_bvh3
+//============================================================================
+usize_t triangle_mesh_bvh3::num_points() const
+{
+  return m_points.size();
+}
+//----
+
+usize_t triangle_mesh_bvh3::num_triangles() const
+{
+  return m_tris.size();
+}
+//----
+
+usize_t triangle_mesh_bvh3::num_nodes() const
+{
+  return m_nodes.size();
+}
+//----
+
+const vec3f *triangle_mesh_bvh3::points() const
+{
+  return m_points.data();
+}
+//----
+
+aabox3f triangle_mesh_bvh3::bounds() const
+{
+  if(!m_nodes.size())
+    return aabox3f::s_zero;
+  const node &root=m_nodes[0];
+  return aabox3f((root.bmin+root.bmax)*0.5f, (root.bmax-root.bmin)*0.5f);
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// triangle_mesh_qbvh3
+//============================================================================
+usize_t triangle_mesh_qbvh3::num_nodes() const
+{
+  return m_nodes.size();
+}
+//----
+
+usize_t triangle_mesh_qbvh3::num_tri_packs() const
+{
+  return m_tri_packs.size();
+}
+//----------------------------------------------------------------------------
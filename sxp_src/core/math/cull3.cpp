@@ -0,0 +1,493 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "sxp_src/sxp_pch.h"
+#include "cull3.h"
+#include "sxp_src/core/math/tform3.h"
+#include "sxp_src/core/mp/mp_job_queue.h"
+#include <xmmintrin.h>
+#ifdef PFC_PLATFORM_AVX
+#include <immintrin.h>
+#endif
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  enum {cull_min_job_objects=8192};  // minimum number of objects culled in a job
+  enum {cull_max_jobs=64};           // maximum number of jobs per cull
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // simd_sse
+  //==========================================================================
+  struct simd_sse
+  {
+    enum {width=4};
+    typedef __m128 vec_t;
+    static PFC_INLINE vec_t zero()                       {return _mm_setzero_ps();}
+    static PFC_INLINE vec_t ones()                       {__m128 z=_mm_setzero_ps(); return _mm_cmpeq_ps(z, z);}
+    static PFC_INLINE vec_t splat(float s_)              {return _mm_set1_ps(s_);}
+    static PFC_INLINE vec_t add(vec_t a_, vec_t b_)      {return _mm_add_ps(a_, b_);}
+    static PFC_INLINE vec_t sub(vec_t a_, vec_t b_)      {return _mm_sub_ps(a_, b_);}
+    static PFC_INLINE vec_t mul(vec_t a_, vec_t b_)      {return _mm_mul_ps(a_, b_);}
+    static PFC_INLINE vec_t abs(vec_t a_)                {return _mm_andnot_ps(_mm_set1_ps(-0.0f), a_);}
+    static PFC_INLINE vec_t cmpge(vec_t a_, vec_t b_)    {return _mm_cmpge_ps(a_, b_);}
+    static PFC_INLINE vec_t band(vec_t a_, vec_t b_)     {return _mm_and_ps(a_, b_);}
+    static PFC_INLINE unsigned movemask(vec_t a_)        {return unsigned(_mm_movemask_ps(a_));}
+    static PFC_INLINE vec_t load(const float *data_, usize_t idx_, usize_t end_)
+    {
+      if(idx_+width<=end_)
+        return _mm_loadu_ps(data_+idx_);
+      PFC_ALIGN(16) float tail[width]={0.0f};
+      for(usize_t i=idx_; i<end_; ++i)
+        tail[i-idx_]=data_[i];
+      return _mm_load_ps(tail);
+    }
+  };
+  //--------------------------------------------------------------------------
+
+#ifdef PFC_PLATFORM_AVX
+  //==========================================================================
+  // simd_avx
+  //==========================================================================
+  struct simd_avx
+  {
+    enum {width=8};
+    typedef __m256 vec_t;
+    static PFC_INLINE vec_t zero()                       {return _mm256_setzero_ps();}
+    static PFC_INLINE vec_t ones()                       {__m256 z=_mm256_setzero_ps(); return _mm256_cmp_ps(z, z, _CMP_EQ_OQ);}
+    static PFC_INLINE vec_t splat(float s_)              {return _mm256_set1_ps(s_);}
+    static PFC_INLINE vec_t add(vec_t a_, vec_t b_)      {return _mm256_add_ps(a_, b_);}
+    static PFC_INLINE vec_t sub(vec_t a_, vec_t b_)      {return _mm256_sub_ps(a_, b_);}
+    static PFC_INLINE vec_t mul(vec_t a_, vec_t b_)      {return _mm256_mul_ps(a_, b_);}
+    static PFC_INLINE vec_t abs(vec_t a_)                {return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a_);}
+    static PFC_INLINE vec_t cmpge(vec_t a_, vec_t b_)    {return _mm256_cmp_ps(a_, b_, _CMP_GE_OQ);}
+    static PFC_INLINE vec_t band(vec_t a_, vec_t b_)     {return _mm256_and_ps(a_, b_);}
+    static PFC_INLINE unsigned movemask(vec_t a_)        {return unsigned(_mm256_movemask_ps(a_));}
+    static PFC_INLINE vec_t load(const float *data_, usize_t idx_, usize_t end_)
+    {
+      if(idx_+width<=end_)
+        return _mm256_loadu_ps(data_+idx_);
+      PFC_ALIGN(32) float tail[width]={0.0f};
+      for(usize_t i=idx_; i<end_; ++i)
+        tail[i-idx_]=data_[i];
+      return _mm256_load_ps(tail);
+    }
+  };
+  typedef simd_avx simd_t;
+#else
+  typedef simd_sse simd_t;
+#endif
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // simd_planes
+  //==========================================================================
+  template<class V>
+  struct simd_planes
+  {
+    typedef typename V::vec_t vec_t;
+    simd_planes(const cull_frustum3f &f_)
+    {
+      // broadcast plane components and their absolute values
+      for(unsigned i=0; i<6; ++i)
+      {
+        const vec4f &p=f_.planes[i];
+        nx[i]=V::splat(p.x);
+        ny[i]=V::splat(p.y);
+        nz[i]=V::splat(p.z);
+        d[i]=V::splat(p.w);
+        anx[i]=V::splat(pfc::abs(p.x));
+        any[i]=V::splat(pfc::abs(p.y));
+        anz[i]=V::splat(pfc::abs(p.z));
+      }
+    }
+    //------------------------------------------------------------------------
+
+    PFC_INLINE vec_t dist(unsigned i_, vec_t px_, vec_t py_, vec_t pz_) const
+    {
+      return V::add(V::add(V::mul(nx[i_], px_), V::mul(ny[i_], py_)), V::add(V::mul(nz[i_], pz_), d[i_]));
+    }
+    //------------------------------------------------------------------------
+
+    vec_t nx[6], ny[6], nz[6], d[6];
+    vec_t anx[6], any[6], anz[6];
+  };
+  //--------------------------------------------------------------------------
+
+  template<class V>
+  PFC_INLINE unsigned cull_lanes(unsigned &inside_, const simd_planes<V> &planes_, const soa_aabox3f_array &b_, usize_t idx_, usize_t end_)
+  {
+    // test lanes of boxes against the planes using projected box radius
+    typedef typename V::vec_t vec_t;
+    vec_t px=V::load(b_.pos[0], idx_, end_), py=V::load(b_.pos[1], idx_, end_), pz=V::load(b_.pos[2], idx_, end_);
+    vec_t hx=V::load(b_.hsize[0], idx_, end_), hy=V::load(b_.hsize[1], idx_, end_), hz=V::load(b_.hsize[2], idx_, end_);
+    vec_t zero=V::zero(), vis=V::ones(), in=vis;
+    for(unsigned i=0; i<6; ++i)
+    {
+      vec_t dist=planes_.dist(i, px, py, pz);
+      vec_t rad=V::add(V::add(V::mul(planes_.anx[i], hx), V::mul(planes_.any[i], hy)), V::mul(planes_.anz[i], hz));
+      vis=V::band(vis, V::cmpge(V::add(dist, rad), zero));
+      in=V::band(in, V::cmpge(dist, rad));
+      if(!V::movemask(vis))
+        break;
+    }
+    inside_=V::movemask(in);
+    return V::movemask(vis);
+  }
+  //----
+
+  template<class V>
+  PFC_INLINE unsigned cull_lanes(unsigned &inside_, const simd_planes<V> &planes_, const soa_sphere3f_array &b_, usize_t idx_, usize_t end_)
+  {
+    // test lanes of spheres against the planes
+    typedef typename V::vec_t vec_t;
+    vec_t px=V::load(b_.pos[0], idx_, end_), py=V::load(b_.pos[1], idx_, end_), pz=V::load(b_.pos[2], idx_, end_);
+    vec_t rad=V::load(b_.rad, idx_, end_);
+    vec_t zero=V::zero(), vis=V::ones(), in=vis;
+    for(unsigned i=0; i<6; ++i)
+    {
+      vec_t dist=planes_.dist(i, px, py, pz);
+      vis=V::band(vis, V::cmpge(V::add(dist, rad), zero));
+      in=V::band(in, V::cmpge(dist, rad));
+      if(!V::movemask(vis))
+        break;
+    }
+    inside_=V::movemask(in);
+    return V::movemask(vis);
+  }
+  //----
+
+  template<class V>
+  PFC_INLINE unsigned cull_lanes(unsigned &inside_, const simd_planes<V> &planes_, const soa_oobox3f_array &b_, usize_t idx_, usize_t end_)
+  {
+    // calculate box axes from the rotation quaternions
+    typedef typename V::vec_t vec_t;
+    vec_t px=V::load(b_.pos[0], idx_, end_), py=V::load(b_.pos[1], idx_, end_), pz=V::load(b_.pos[2], idx_, end_);
+    vec_t hx=V::load(b_.hsize[0], idx_, end_), hy=V::load(b_.hsize[1], idx_, end_), hz=V::load(b_.hsize[2], idx_, end_);
+    vec_t qx=V::load(b_.rot[0], idx_, end_), qy=V::load(b_.rot[1], idx_, end_), qz=V::load(b_.rot[2], idx_, end_), qw=V::load(b_.rot[3], idx_, end_);
+    vec_t x2=V::add(qx, qx), y2=V::add(qy, qy), z2=V::add(qz, qz);
+    vec_t xx2=V::mul(qx, x2), yy2=V::mul(qy, y2), zz2=V::mul(qz, z2);
+    vec_t xy2=V::mul(qx, y2), xz2=V::mul(qx, z2), yz2=V::mul(qy, z2);
+    vec_t wx2=V::mul(qw, x2), wy2=V::mul(qw, y2), wz2=V::mul(qw, z2);
+    vec_t one=V::splat(1.0f);
+    vec_t axx=V::sub(one, V::add(yy2, zz2)), axy=V::add(xy2, wz2), axz=V::sub(xz2, wy2);
+    vec_t ayx=V::sub(xy2, wz2), ayy=V::sub(one, V::add(xx2, zz2)), ayz=V::add(yz2, wx2);
+    vec_t azx=V::add(xz2, wy2), azy=V::sub(yz2, wx2), azz=V::sub(one, V::add(xx2, yy2));
+
+    // test lanes of boxes against the planes using projected box radius
+    vec_t zero=V::zero(), vis=V::ones(), in=vis;
+    for(unsigned i=0; i<6; ++i)
+    {
+      vec_t dist=planes_.dist(i, px, py, pz);
+      vec_t rx=V::abs(V::add(V::add(V::mul(planes_.nx[i], axx), V::mul(planes_.ny[i], axy)), V::mul(planes_.nz[i], axz)));
+      vec_t ry=V::abs(V::add(V::add(V::mul(planes_.nx[i], ayx), V::mul(planes_.ny[i], ayy)), V::mul(planes_.nz[i], ayz)));
+      vec_t rz=V::abs(V::add(V::add(V::mul(planes_.nx[i], azx), V::mul(planes_.ny[i], azy)), V::mul(planes_.nz[i], azz)));
+      vec_t rad=V::add(V::add(V::mul(rx, hx), V::mul(ry, hy)), V::mul(rz, hz));
+      vis=V::band(vis, V::cmpge(V::add(dist, rad), zero));
+      in=V::band(in, V::cmpge(dist, rad));
+      if(!V::movemask(vis))
+        break;
+    }
+    inside_=V::movemask(in);
+    return V::movemask(vis);
+  }
+  //--------------------------------------------------------------------------
+
+  PFC_INLINE void or_bits(uint32_t *words_, usize_t idx_, uint32_t bits_)
+  {
+    // or bits to the bit array starting from given bit index (words touched only for non-zero bits)
+    if(!bits_)
+      return;
+    unsigned shift=unsigned(idx_&31);
+    words_[idx_>>5]|=bits_<<shift;
+    if(shift && (bits_>>(32-shift)))
+      words_[(idx_>>5)+1]|=bits_>>(32-shift);
+  }
+  //----
+
+  void set_bits(uint32_t *words_, usize_t start_, usize_t end_)
+  {
+    // set bit range [start_, end_)
+    while(start_<end_)
+    {
+      unsigned shift=unsigned(start_&31);
+      usize_t num_bits=min<usize_t>(32-shift, end_-start_);
+      words_[start_>>5]|=(num_bits==32?0xffffffff:((uint32_t(1)<<num_bits)-1))<<shift;
+      start_+=num_bits;
+    }
+  }
+  //----
+
+  PFC_INLINE void clear_words(uint32_t *words_, usize_t start_, usize_t end_)
+  {
+    // clear words of bit range [start_, end_) (start_ is multiple of 32)
+    PFC_ASSERT_PEDANTIC(!(start_&31));
+    mem_zero(words_+(start_>>5), ((end_+31)/32-start_/32)*sizeof(uint32_t));
+  }
+  //----
+
+  template<class B>
+  void cull_bits(uint32_t *visible_, uint32_t *inside_, const simd_planes<simd_t> &planes_, const B &bounds_, usize_t start_, usize_t end_)
+  {
+    // cull objects in range [start_, end_) and or the results to the bit arrays
+    for(usize_t idx=start_; idx<end_; idx+=simd_t::width)
+    {
+      unsigned inside;
+      unsigned vis=cull_lanes(inside, planes_, bounds_, idx, end_);
+      if(end_-idx<simd_t::width)
+      {
+        unsigned lane_mask=(1<<(end_-idx))-1;
+        vis&=lane_mask;
+        inside&=lane_mask;
+      }
+      or_bits(visible_, idx, vis);
+      if(inside_)
+        or_bits(inside_, idx, inside&vis);
+    }
+  }
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // cull_context
+  //==========================================================================
+  struct cull_context
+  {
+    void(*func)(const cull_context&, usize_t start_, usize_t end_);
+    const cull_frustum3f *frustum;
+    const void *bounds;
+    uint32_t *visible;
+    uint32_t *inside;
+    // hierarchical culling
+    const uint32_t *group_visible;
+    const uint32_t *group_inside;
+    const uint32_t *group_first;
+    usize_t num_groups;
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // cull_task
+  //==========================================================================
+  struct cull_task
+  {
+    const cull_context *ctx;
+    usize_t start, end;
+  };
+  //--------------------------------------------------------------------------
+
+  template<class B>
+  void cull_range(const cull_context &ctx_, usize_t start_, usize_t end_)
+  {
+    // cull range of objects to visibility (and inside) bit arrays
+    simd_planes<simd_t> planes(*ctx_.frustum);
+    clear_words(ctx_.visible, start_, end_);
+    if(ctx_.inside)
+      clear_words(ctx_.inside, start_, end_);
+    cull_bits(ctx_.visible, ctx_.inside, planes, *(const B*)ctx_.bounds, start_, end_);
+  }
+  //----
+
+  template<class B>
+  void cull_group_range(const cull_context &ctx_, usize_t start_, usize_t end_)
+  {
+    // find the first group overlapping the range
+    simd_planes<simd_t> planes(*ctx_.frustum);
+    clear_words(ctx_.visible, start_, end_);
+    const uint32_t *group_first=ctx_.group_first;
+    usize_t group_idx=0, num_groups=ctx_.num_groups;
+    while(num_groups)
+    {
+      usize_t half=num_groups/2;
+      if(group_first[group_idx+half+1]<=start_)
+      {
+        group_idx+=half+1;
+        num_groups-=half+1;
+      }
+      else
+        num_groups=half;
+    }
+
+    // set objects of fully visible groups and cull objects of partially visible groups
+    const B &bounds=*(const B*)ctx_.bounds;
+    for(; group_idx<ctx_.num_groups && group_first[group_idx]<end_; ++group_idx)
+    {
+      uint32_t group_bit=uint32_t(1)<<(group_idx&31);
+      if(!(ctx_.group_visible[group_idx>>5]&group_bit))
+        continue;
+      usize_t start=max<usize_t>(group_first[group_idx], start_);
+      usize_t end=min<usize_t>(group_first[group_idx+1], end_);
+      if(ctx_.group_inside[group_idx>>5]&group_bit)
+        set_bits(ctx_.visible, start, end);
+      else
+        cull_bits(ctx_.visible, 0, planes, bounds, start, end);
+    }
+  }
+  //----
+
+  void cull_job(cull_task *task_, void*)
+  {
+    task_->ctx->func(*task_->ctx, task_->start, task_->end);
+  }
+  //----
+
+  void dispatch(const cull_context &ctx_, usize_t num_)
+  {
+    // split large culls to 32 object aligned ranges for the active job queue (if any)
+    PFC_PERF_TIMER_AUTO(frustum_cull, "geometry", "cull()");
+    if(!mp_job_queue::has_active() || num_<cull_min_job_objects*2)
+    {
+      ctx_.func(ctx_, 0, num_);
+      return;
+    }
+    mp_job_queue &jq=mp_job_queue::active();
+    e_jobtype_id job_type=jq.find_or_create_job_type("frustum cull", &cull_job);
+    volatile uint32_t job_counter=0;
+    usize_t num_jobs=min<usize_t>(usize_t(jq.num_worker_threads()+1)*4, num_/cull_min_job_objects, cull_max_jobs);
+    usize_t range_size=((num_+num_jobs-1)/num_jobs+31)&~usize_t(31);
+    cull_task tasks[cull_max_jobs];
+    unsigned num_tasks=0;
+    for(usize_t start=0; start<num_; start+=range_size)
+    {
+      cull_task &task=tasks[num_tasks++];
+      task.ctx=&ctx_;
+      task.start=start;
+      task.end=min(start+range_size, num_);
+      jq.add_job(job_type, &task, job_counter);
+    }
+    jq.wait_jobs(job_counter);
+  }
+  //----
+
+  template<class B>
+  void cull_objects(uint32_t *visible_, const cull_frustum3f &frustum_, const B &bounds_, usize_t num_)
+  {
+    cull_context ctx;
+    mem_zero(&ctx, sizeof(ctx));
+    ctx.func=&cull_range<B>;
+    ctx.frustum=&frustum_;
+    ctx.bounds=&bounds_;
+    ctx.visible=visible_;
+    dispatch(ctx, num_);
+  }
+  //----
+
+  template<class B>
+  void cull_groups(uint32_t *visible_, const cull_frustum3f &frustum_, const soa_aabox3f_array &group_bounds_, const uint32_t *group_first_, usize_t num_groups_, const B &bounds_, usize_t num_)
+  {
+    // cull groups to visible and fully inside groups
+    PFC_ASSERT(!num_groups_ || group_first_[num_groups_]<=num_);
+    array<uint32_t> group_masks((num_groups_+31)/32*2);
+    cull_context ctx;
+    mem_zero(&ctx, sizeof(ctx));
+    ctx.func=&cull_range<soa_aabox3f_array>;
+    ctx.frustum=&frustum_;
+    ctx.bounds=&group_bounds_;
+    ctx.visible=group_masks.data();
+    ctx.inside=group_masks.data()+(num_groups_+31)/32;
+    dispatch(ctx, num_groups_);
+
+    // cull objects of the groups
+    ctx.func=&cull_group_range<B>;
+    ctx.bounds=&bounds_;
+    ctx.visible=visible_;
+    ctx.inside=0;
+    ctx.group_visible=group_masks.data();
+    ctx.group_inside=group_masks.data()+(num_groups_+31)/32;
+    ctx.group_first=group_first_;
+    ctx.num_groups=num_groups_;
+    dispatch(ctx, num_);
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// batch frustum culling
+//============================================================================
+void pfc::cull(uint32_t *visible_, const cull_frustum3f &frustum_, const soa_aabox3f_array &boxes_, usize_t num_)
+{
+  cull_objects(visible_, frustum_, boxes_, num_);
+}
+//----
+
+void pfc::cull(uint32_t *visible_, const cull_frustum3f &frustum_, const soa_sphere3f_array &spheres_, usize_t num_)
+{
+  cull_objects(visible_, frustum_, spheres_, num_);
+}
+//----
+
+void pfc::cull(uint32_t *visible_, const cull_frustum3f &frustum_, const soa_oobox3f_array &boxes_, usize_t num_)
+{
+  cull_objects(visible_, frustum_, boxes_, num_);
+}
+//----
+
+void pfc::cull(uint32_t *visible_, const cull_frustum3f &frustum_, const soa_aabox3f_array &group_bounds_, const uint32_t *group_first_, usize_t num_groups_, const soa_aabox3f_array &boxes_, usize_t num_)
+{
+  cull_groups(visible_, frustum_, group_bounds_, group_first_, num_groups_, boxes_, num_);
+}
+//----
+
+void pfc::cull(uint32_t *visible_, const cull_frustum3f &frustum_, const soa_aabox3f_array &group_bounds_, const uint32_t *group_first_, usize_t num_groups_, const soa_sphere3f_array &spheres_, usize_t num_)
+{
+  cull_groups(visible_, frustum_, group_bounds_, group_first_, num_groups_, spheres_, num_);
+}
+//----
+
+void pfc::cull(uint32_t *visible_, const cull_frustum3f &frustum_, const soa_aabox3f_array &group_bounds_, const uint32_t *group_first_, usize_t num_groups_, const soa_oobox3f_array &boxes_, usize_t num_)
+{
+  cull_groups(visible_, frustum_, group_bounds_, group_first_, num_groups_, boxes_, num_);
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// cull_frustum3f
+//============================================================================
+void cull_frustum3f::set(const frustum3f &f_)
+{
+  set(inv(f_.proj_to_local));
+}
+//----
+
+void cull_frustum3f::set(const camera<float> &cam_)
+{
+  set(cam_.world_to_proj());
+}
+//----
+
+void cull_frustum3f::set(const mat44f &local_to_proj_)
+{
+  // extract planes from the transform columns
+  const mat44f &m=local_to_proj_;
+  vec4f cx(m.x.x, m.y.x, m.z.x, m.w.x);
+  vec4f cy(m.x.y, m.y.y, m.z.y, m.w.y);
+  vec4f cz(m.x.z, m.y.z, m.z.z, m.w.z);
+  vec4f cw(m.x.w, m.y.w, m.z.w, m.w.w);
+  planes[0]=cw+cx;
+  planes[1]=cw-cx;
+  planes[2]=cw+cy;
+  planes[3]=cw-cy;
+  planes[4]=cz;
+  planes[5]=cw-cz;
+
+  // normalize planes
+  for(unsigned i=0; i<6; ++i)
+  {
+    vec4f &p=planes[i];
+    float len=norm(vec3f(p.x, p.y, p.z));
+    if(len>0.0f)
+      p*=1.0f/len;
+  }
+}
+//----------------------------------------------------------------------------
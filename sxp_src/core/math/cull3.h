@@ -0,0 +1,101 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_CORE_MATH_CULL3_H
+#define PFC_CORE_MATH_CULL3_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "prim3/prim3.h"
+namespace pfc
+{
+template<typename> class camera;
+
+// new
+struct cull_frustum3f;
+struct soa_aabox3f_array;
+struct soa_sphere3f_array;
+struct soa_oobox3f_array;
+// batch frustum culling (bit i of visible_[i/32] is set for visible objects, visible_ must have (num_+31)/32 words)
+void cull(uint32_t *visible_, const cull_frustum3f&, const soa_aabox3f_array&, usize_t num_);
+void cull(uint32_t *visible_, const cull_frustum3f&, const soa_sphere3f_array&, usize_t num_);
+void cull(uint32_t *visible_, const cull_frustum3f&, const soa_oobox3f_array&, usize_t num_);
+// hierarchical culling of objects in groups (group i contains objects [group_first_[i], group_first_[i+1]) which must be inside the group bounds)
+void cull(uint32_t *visible_, const cull_frustum3f&, const soa_aabox3f_array &group_bounds_, const uint32_t *group_first_, usize_t num_groups_, const soa_aabox3f_array&, usize_t num_);
+void cull(uint32_t *visible_, const cull_frustum3f&, const soa_aabox3f_array &group_bounds_, const uint32_t *group_first_, usize_t num_groups_, const soa_sphere3f_array&, usize_t num_);
+void cull(uint32_t *visible_, const cull_frustum3f&, const soa_aabox3f_array &group_bounds_, const uint32_t *group_first_, usize_t num_groups_, const soa_oobox3f_array&, usize_t num_);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// cull_frustum3f
+//============================================================================
+// Frustum planes for batch culling. The planes are extracted from local->proj
+// space transform, where the visible volume is -w<=x<=w, -w<=y<=w, 0<=z<=w.
+struct cull_frustum3f
+{
+  // construction
+  PFC_INLINE cull_frustum3f();
+  PFC_INLINE cull_frustum3f(const frustum3f&);
+  PFC_INLINE cull_frustum3f(const camera<float>&);
+  PFC_INLINE cull_frustum3f(const mat44f &local_to_proj_);
+  void set(const frustum3f&);
+  void set(const camera<float>&);
+  void set(const mat44f &local_to_proj_);
+  //--------------------------------------------------------------------------
+
+  vec4f planes[6];  // normalized inward facing planes: visible if dot(planes[i].xyz, p)+planes[i].w>=0
+};
+PFC_SET_TYPE_TRAIT(cull_frustum3f, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa_aabox3f_array
+//============================================================================
+// SoA array of axis aligned boxes (component arrays don't need to be aligned)
+struct soa_aabox3f_array
+{
+  const float *pos[3];    // center position x, y and z arrays
+  const float *hsize[3];  // half size x, y and z arrays
+};
+PFC_SET_TYPE_TRAIT(soa_aabox3f_array, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa_sphere3f_array
+//============================================================================
+struct soa_sphere3f_array
+{
+  const float *pos[3];    // center position x, y and z arrays
+  const float *rad;       // radius array
+};
+PFC_SET_TYPE_TRAIT(soa_sphere3f_array, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa_oobox3f_array
+//============================================================================
+struct soa_oobox3f_array
+{
+  const float *pos[3];    // center position x, y and z arrays
+  const float *hsize[3];  // half size x, y and z arrays
+  const float *rot[4];    // rotation quaternion x, y, z and w arrays
+};
+PFC_SET_TYPE_TRAIT(soa_oobox3f_array, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+//============================================================================
+#include "cull3.inl"
+} // namespace pfc
+#endif
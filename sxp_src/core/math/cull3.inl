@@ -0,0 +1,33 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+
+//============================================================================
+// cull_frustum3f
+//============================================================================
+cull_frustum3f::cull_frustum3f()
+{
+}
+//----
+
+cull_frustum3f::cull_frustum3f(const frustum3f &f_)
+{
+  set(f_);
+}
+//----
+
+cull_frustum3f::cull_frustum3f(const camera<float> &cam_)
+{
+  set(cam_);
+}
+//----
+
+cull_frustum3f::cull_frustum3f(const mat44f &local_to_proj_)
+{
+  set(local_to_proj_);
+}
+//----------------------------------------------------------------------------
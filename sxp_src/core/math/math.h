@@ -1192,6 +1192,7 @@ struct vec2
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec2<T>, is_type_vec, true);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec2<T>, is_type_pod, is_type_pod<T>::res);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec2<T>, is_type_pod_stream, is_type_pod_stream<T>::res);
+PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec2<T>, is_type_pod_archive, is_type_pod_archive<T>::res);
 //----------------------------------------------------------------------------
 
 
@@ -1234,6 +1235,7 @@ struct vec3
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec3<T>, is_type_vec, true);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec3<T>, is_type_pod, is_type_pod<T>::res);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec3<T>, is_type_pod_stream, is_type_pod_stream<T>::res);
+PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec3<T>, is_type_pod_archive, is_type_pod_archive<T>::res);
 //----------------------------------------------------------------------------
 
 
@@ -1354,6 +1356,7 @@ struct vec4
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec4<T>, is_type_vec, true);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec4<T>, is_type_pod, is_type_pod<T>::res);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec4<T>, is_type_pod_stream, is_type_pod_stream<T>::res);
+PFC_SET_TYPE_TRAIT_PARTIAL(typename T, vec4<T>, is_type_pod_archive, is_type_pod_archive<T>::res);
 //----------------------------------------------------------------------------
 
 
@@ -1485,6 +1488,7 @@ struct mat22
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat22<T>, is_type_mat, true);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat22<T>, is_type_pod, is_type_pod<vec2<T> >::res);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat22<T>, is_type_pod_stream, is_type_pod_stream<vec2<T> >::res);
+PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat22<T>, is_type_pod_archive, is_type_pod_archive<vec2<T> >::res);
 //----------------------------------------------------------------------------
 
 
@@ -1543,6 +1547,7 @@ struct mat33
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat33<T>, is_type_mat, true);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat33<T>, is_type_pod, is_type_pod<vec3<T> >::res);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat33<T>, is_type_pod_stream, is_type_pod_stream<vec3<T> >::res);
+PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat33<T>, is_type_pod_archive, is_type_pod_archive<vec3<T> >::res);
 //----------------------------------------------------------------------------
 
 
@@ -1604,6 +1609,7 @@ struct mat44
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat44<T>, is_type_mat, true);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat44<T>, is_type_pod, is_type_pod<vec4<T> >::res);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat44<T>, is_type_pod_stream, is_type_pod_stream<vec4<T> >::res);
+PFC_SET_TYPE_TRAIT_PARTIAL(typename T, mat44<T>, is_type_pod_archive, is_type_pod_archive<vec4<T> >::res);
 //----------------------------------------------------------------------------
 
 
@@ -1649,6 +1655,7 @@ struct quat
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, quat<T>, is_type_quat, true);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, quat<T>, is_type_pod, is_type_pod<T>::res);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, quat<T>, is_type_pod_stream, is_type_pod_stream<T>::res);
+PFC_SET_TYPE_TRAIT_PARTIAL(typename T, quat<T>, is_type_pod_archive, is_type_pod_archive<T>::res);
 //----------------------------------------------------------------------------
 
 
@@ -1777,6 +1784,7 @@ struct complex
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, complex<T>, is_type_complex, true);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, complex<T>, is_type_pod, is_type_pod<T>::res);
 PFC_SET_TYPE_TRAIT_PARTIAL(typename T, complex<T>, is_type_pod_stream, is_type_pod_stream<T>::res);
+PFC_SET_TYPE_TRAIT_PARTIAL(typename T, complex<T>, is_type_pod_archive, is_type_pod_archive<T>::res);
 //----------------------------------------------------------------------------
 
 //============================================================================
@@ -647,18 +647,37 @@ bool isect(const ray3<T> &ray_, const cone3<T> &cone_, typename math<T>::scalar_
 template<typename T>
 bool isect(const ray3<T> &ray_, const aabox3<T> &aab_)
 {
-  /*todo*/
-  PFC_ERROR_NOT_IMPL();
-  return false;
+  typename math<T>::scalar_t min_t, max_t;
+  return isect(ray_, aab_, min_t, max_t);
 }
 //----
 
 template<typename T>
 bool isect(const ray3<T> &ray_, const aabox3<T> &aab_, typename math<T>::scalar_t &min_t_, typename math<T>::scalar_t &max_t_)
 {
-  /*todo*/
-  PFC_ERROR_NOT_IMPL();
-  return false;
+  // clip the ray against the box slabs
+  typedef typename math<T>::scalar_t scalar_t;
+  vec3<T> d=aab_.pos-ray_.pos;
+  scalar_t min_t=0, max_t=numeric_type<scalar_t>::range_max();
+  for(unsigned i=0; i<3; ++i)
+  {
+    if(ray_.dir[i])
+    {
+      scalar_t rd=scalar_t(1)/ray_.dir[i];
+      scalar_t t0=(d[i]-aab_.hsize[i])*rd, t1=(d[i]+aab_.hsize[i])*rd;
+      if(t0>t1)
+        swap(t0, t1);
+      min_t=max(min_t, t0);
+      max_t=min(max_t, t1);
+      if(min_t>max_t)
+        return false;
+    }
+    else if(abs(d[i])>aab_.hsize[i])
+      return false;
+  }
+  min_t_=min_t;
+  max_t_=max_t;
+  return true;
 }
 //----
 
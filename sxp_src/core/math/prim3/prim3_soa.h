@@ -0,0 +1,124 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_CORE_MATH_PRIM3_SOA_H
+#define PFC_CORE_MATH_PRIM3_SOA_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "prim3.h"
+#include <xmmintrin.h>
+#ifdef PFC_PLATFORM_AVX
+#include <immintrin.h>
+#endif
+namespace pfc
+{
+
+// new
+struct soa4_ray3f;
+struct soa4_tri3f;
+struct soa8_tri3f;
+struct soa4_aabox3f;
+// SoA batch intersection kernels (return bit mask of intersecting lanes, per-lane results written for all lanes)
+PFC_INLINE unsigned isect(float t_[4], float u_[4], float v_[4], const ray3f&, const soa4_tri3f&, float max_t_);               // 1 ray vs 4 triangles
+PFC_INLINE unsigned isect(float t_[8], float u_[8], float v_[8], const ray3f&, const soa8_tri3f&, float max_t_);               // 1 ray vs 8 triangles
+PFC_INLINE unsigned isect(float min_t_[4], const ray3f&, const vec3f &rcp_dir_, const soa4_aabox3f&, float max_t_);            // 1 ray vs 4 boxes
+PFC_INLINE unsigned isect(float t_[4], float u_[4], float v_[4], const soa4_ray3f&, const tri3f&, const float max_t_[4]);      // 4 rays vs 1 triangle
+PFC_INLINE unsigned isect(float min_t_[4], const soa4_ray3f&, const vec3f &bmin_, const vec3f &bmax_, const float max_t_[4]);  // 4 rays vs 1 box
+PFC_INLINE vec3f safe_rcp_dir(const vec3f&);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa4_ray3f
+//============================================================================
+// Packet of 4 rays in SoA layout ([component][lane]).
+struct soa4_ray3f
+{
+  // construction
+  PFC_INLINE soa4_ray3f();
+  PFC_INLINE soa4_ray3f(const ray3f*);
+  PFC_INLINE void set(unsigned lane_, const ray3f&);
+  //--------------------------------------------------------------------------
+
+  PFC_ALIGN(16) float pos[3][4];
+  PFC_ALIGN(16) float dir[3][4];
+  PFC_ALIGN(16) float rcp_dir[3][4];
+};
+PFC_SET_TYPE_TRAIT(soa4_ray3f, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa4_tri3f
+//============================================================================
+// 4 triangles in SoA layout stored as vertex a and edges b-a and c-a. Unused
+// lanes are degenerate (zero) triangles that never intersect.
+struct soa4_tri3f
+{
+  // construction
+  PFC_INLINE soa4_tri3f();
+  PFC_INLINE void clear();
+  PFC_INLINE void set(unsigned lane_, const vec3f &a_, const vec3f &b_, const vec3f &c_);
+  //--------------------------------------------------------------------------
+
+  PFC_ALIGN(16) float a[3][4];
+  PFC_ALIGN(16) float e0[3][4];
+  PFC_ALIGN(16) float e1[3][4];
+};
+PFC_SET_TYPE_TRAIT(soa4_tri3f, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa8_tri3f
+//============================================================================
+// 8 triangles in SoA layout (see soa4_tri3f). Tested with AVX if
+// PFC_PLATFORM_AVX is defined, otherwise as two 4-wide halves. The data is
+// only 16 byte aligned to be usable with the default memory allocator.
+struct soa8_tri3f
+{
+  // construction
+  PFC_INLINE soa8_tri3f();
+  PFC_INLINE void clear();
+  PFC_INLINE void set(unsigned lane_, const vec3f &a_, const vec3f &b_, const vec3f &c_);
+  //--------------------------------------------------------------------------
+
+  PFC_ALIGN(16) float a[3][8];
+  PFC_ALIGN(16) float e0[3][8];
+  PFC_ALIGN(16) float e1[3][8];
+};
+PFC_SET_TYPE_TRAIT(soa8_tri3f, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa4_aabox3f
+//============================================================================
+// 4 axis aligned boxes in SoA min/max layout.
+struct soa4_aabox3f
+{
+  // construction
+  PFC_INLINE soa4_aabox3f();
+  PFC_INLINE void clear();
+  PFC_INLINE void set(unsigned lane_, const vec3f &bmin_, const vec3f &bmax_);
+  //--------------------------------------------------------------------------
+
+  PFC_ALIGN(16) float bmin[3][4];
+  PFC_ALIGN(16) float bmax[3][4];
+};
+PFC_SET_TYPE_TRAIT(soa4_aabox3f, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+//============================================================================
+#include "prim3_soa.inl"
+} // namespace pfc
+#endif
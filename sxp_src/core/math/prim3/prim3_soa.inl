@@ -0,0 +1,297 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+
+//============================================================================
+// SoA kernel helpers
+//============================================================================
+namespace priv
+{
+  PFC_INLINE __m128 soa4_dot(__m128 ax_, __m128 ay_, __m128 az_, __m128 bx_, __m128 by_, __m128 bz_)
+  {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax_, bx_), _mm_mul_ps(ay_, by_)), _mm_mul_ps(az_, bz_));
+  }
+  //----
+
+  PFC_INLINE unsigned isect_ray_tri4(float *t_, float *u_, float *v_,
+                                     __m128 px_, __m128 py_, __m128 pz_, __m128 dx_, __m128 dy_, __m128 dz_,
+                                     __m128 ax_, __m128 ay_, __m128 az_,
+                                     __m128 e0x_, __m128 e0y_, __m128 e0z_,
+                                     __m128 e1x_, __m128 e1y_, __m128 e1z_, __m128 max_t_)
+  {
+    // two-sided Moller-Trumbore test for 4 lanes
+    __m128 cx=_mm_sub_ps(_mm_mul_ps(dy_, e1z_), _mm_mul_ps(dz_, e1y_));
+    __m128 cy=_mm_sub_ps(_mm_mul_ps(dz_, e1x_), _mm_mul_ps(dx_, e1z_));
+    __m128 cz=_mm_sub_ps(_mm_mul_ps(dx_, e1y_), _mm_mul_ps(dy_, e1x_));
+    __m128 det=soa4_dot(e0x_, e0y_, e0z_, cx, cy, cz);
+    __m128 rdet=_mm_div_ps(_mm_set1_ps(1.0f), det);
+    __m128 sx=_mm_sub_ps(px_, ax_), sy=_mm_sub_ps(py_, ay_), sz=_mm_sub_ps(pz_, az_);
+    __m128 u=_mm_mul_ps(soa4_dot(sx, sy, sz, cx, cy, cz), rdet);
+    __m128 qx=_mm_sub_ps(_mm_mul_ps(sy, e0z_), _mm_mul_ps(sz, e0y_));
+    __m128 qy=_mm_sub_ps(_mm_mul_ps(sz, e0x_), _mm_mul_ps(sx, e0z_));
+    __m128 qz=_mm_sub_ps(_mm_mul_ps(sx, e0y_), _mm_mul_ps(sy, e0x_));
+    __m128 v=_mm_mul_ps(soa4_dot(dx_, dy_, dz_, qx, qy, qz), rdet);
+    __m128 t=_mm_mul_ps(soa4_dot(e1x_, e1y_, e1z_, qx, qy, qz), rdet);
+
+    // setup hit mask (NaNs of degenerate triangles fail the comparisons)
+    __m128 zero=_mm_setzero_ps();
+    __m128 mask=_mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero));
+    mask=_mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+    mask=_mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmplt_ps(t, max_t_)));
+    _mm_storeu_ps(t_, t);
+    _mm_storeu_ps(u_, u);
+    _mm_storeu_ps(v_, v);
+    return unsigned(_mm_movemask_ps(mask));
+  }
+  //----
+
+  PFC_INLINE unsigned isect_ray_box4(float *min_t_,
+                                     __m128 px_, __m128 py_, __m128 pz_, __m128 rdx_, __m128 rdy_, __m128 rdz_,
+                                     __m128 bminx_, __m128 bminy_, __m128 bminz_,
+                                     __m128 bmaxx_, __m128 bmaxy_, __m128 bmaxz_, __m128 max_t_)
+  {
+    // slab test for 4 lanes
+    __m128 t0x=_mm_mul_ps(_mm_sub_ps(bminx_, px_), rdx_), t1x=_mm_mul_ps(_mm_sub_ps(bmaxx_, px_), rdx_);
+    __m128 t0y=_mm_mul_ps(_mm_sub_ps(bminy_, py_), rdy_), t1y=_mm_mul_ps(_mm_sub_ps(bmaxy_, py_), rdy_);
+    __m128 t0z=_mm_mul_ps(_mm_sub_ps(bminz_, pz_), rdz_), t1z=_mm_mul_ps(_mm_sub_ps(bmaxz_, pz_), rdz_);
+    __m128 tmin=_mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)), _mm_max_ps(_mm_min_ps(t0z, t1z), _mm_setzero_ps()));
+    __m128 tmax=_mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)), _mm_min_ps(_mm_max_ps(t0z, t1z), max_t_));
+    _mm_storeu_ps(min_t_, tmin);
+    return unsigned(_mm_movemask_ps(_mm_cmple_ps(tmin, tmax)));
+  }
+  //----
+
+#ifdef PFC_PLATFORM_AVX
+  PFC_INLINE __m256 soa8_dot(__m256 ax_, __m256 ay_, __m256 az_, __m256 bx_, __m256 by_, __m256 bz_)
+  {
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax_, bx_), _mm256_mul_ps(ay_, by_)), _mm256_mul_ps(az_, bz_));
+  }
+  //----
+
+  PFC_INLINE unsigned isect_ray_tri8(float *t_, float *u_, float *v_, const ray3f &ray_, const soa8_tri3f &tris_, float max_t_)
+  {
+    // two-sided Moller-Trumbore test for 8 lanes
+    __m256 dx=_mm256_set1_ps(ray_.dir.x), dy=_mm256_set1_ps(ray_.dir.y), dz=_mm256_set1_ps(ray_.dir.z);
+    __m256 e0x=_mm256_loadu_ps(tris_.e0[0]), e0y=_mm256_loadu_ps(tris_.e0[1]), e0z=_mm256_loadu_ps(tris_.e0[2]);
+    __m256 e1x=_mm256_loadu_ps(tris_.e1[0]), e1y=_mm256_loadu_ps(tris_.e1[1]), e1z=_mm256_loadu_ps(tris_.e1[2]);
+    __m256 cx=_mm256_sub_ps(_mm256_mul_ps(dy, e1z), _mm256_mul_ps(dz, e1y));
+    __m256 cy=_mm256_sub_ps(_mm256_mul_ps(dz, e1x), _mm256_mul_ps(dx, e1z));
+    __m256 cz=_mm256_sub_ps(_mm256_mul_ps(dx, e1y), _mm256_mul_ps(dy, e1x));
+    __m256 det=soa8_dot(e0x, e0y, e0z, cx, cy, cz);
+    __m256 rdet=_mm256_div_ps(_mm256_set1_ps(1.0f), det);
+    __m256 sx=_mm256_sub_ps(_mm256_set1_ps(ray_.pos.x), _mm256_loadu_ps(tris_.a[0]));
+    __m256 sy=_mm256_sub_ps(_mm256_set1_ps(ray_.pos.y), _mm256_loadu_ps(tris_.a[1]));
+    __m256 sz=_mm256_sub_ps(_mm256_set1_ps(ray_.pos.z), _mm256_loadu_ps(tris_.a[2]));
+    __m256 u=_mm256_mul_ps(soa8_dot(sx, sy, sz, cx, cy, cz), rdet);
+    __m256 qx=_mm256_sub_ps(_mm256_mul_ps(sy, e0z), _mm256_mul_ps(sz, e0y));
+    __m256 qy=_mm256_sub_ps(_mm256_mul_ps(sz, e0x), _mm256_mul_ps(sx, e0z));
+    __m256 qz=_mm256_sub_ps(_mm256_mul_ps(sx, e0y), _mm256_mul_ps(sy, e0x));
+    __m256 v=_mm256_mul_ps(soa8_dot(dx, dy, dz, qx, qy, qz), rdet);
+    __m256 t=_mm256_mul_ps(soa8_dot(e1x, e1y, e1z, qx, qy, qz), rdet);
+
+    // setup hit mask
+    __m256 zero=_mm256_setzero_ps();
+    __m256 mask=_mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+    mask=_mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f), _CMP_LE_OQ));
+    mask=_mm256_and_ps(mask, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, _mm256_set1_ps(max_t_), _CMP_LT_OQ)));
+    _mm256_storeu_ps(t_, t);
+    _mm256_storeu_ps(u_, u);
+    _mm256_storeu_ps(v_, v);
+    return unsigned(_mm256_movemask_ps(mask));
+  }
+#endif
+} // namespace priv
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// SoA batch intersection kernels
+//============================================================================
+PFC_INLINE unsigned isect(float t_[4], float u_[4], float v_[4], const ray3f &ray_, const soa4_tri3f &tris_, float max_t_)
+{
+  return priv::isect_ray_tri4(t_, u_, v_,
+                              _mm_set1_ps(ray_.pos.x), _mm_set1_ps(ray_.pos.y), _mm_set1_ps(ray_.pos.z),
+                              _mm_set1_ps(ray_.dir.x), _mm_set1_ps(ray_.dir.y), _mm_set1_ps(ray_.dir.z),
+                              _mm_load_ps(tris_.a[0]), _mm_load_ps(tris_.a[1]), _mm_load_ps(tris_.a[2]),
+                              _mm_load_ps(tris_.e0[0]), _mm_load_ps(tris_.e0[1]), _mm_load_ps(tris_.e0[2]),
+                              _mm_load_ps(tris_.e1[0]), _mm_load_ps(tris_.e1[1]), _mm_load_ps(tris_.e1[2]),
+                              _mm_set1_ps(max_t_));
+}
+//----
+
+PFC_INLINE unsigned isect(float t_[8], float u_[8], float v_[8], const ray3f &ray_, const soa8_tri3f &tris_, float max_t_)
+{
+#ifdef PFC_PLATFORM_AVX
+  return priv::isect_ray_tri8(t_, u_, v_, ray_, tris_, max_t_);
+#else
+  // test the triangles as two 4-wide halves
+  __m128 px=_mm_set1_ps(ray_.pos.x), py=_mm_set1_ps(ray_.pos.y), pz=_mm_set1_ps(ray_.pos.z);
+  __m128 dx=_mm_set1_ps(ray_.dir.x), dy=_mm_set1_ps(ray_.dir.y), dz=_mm_set1_ps(ray_.dir.z);
+  __m128 max_t=_mm_set1_ps(max_t_);
+  unsigned mask_lo=priv::isect_ray_tri4(t_, u_, v_, px, py, pz, dx, dy, dz,
+                                        _mm_load_ps(tris_.a[0]), _mm_load_ps(tris_.a[1]), _mm_load_ps(tris_.a[2]),
+                                        _mm_load_ps(tris_.e0[0]), _mm_load_ps(tris_.e0[1]), _mm_load_ps(tris_.e0[2]),
+                                        _mm_load_ps(tris_.e1[0]), _mm_load_ps(tris_.e1[1]), _mm_load_ps(tris_.e1[2]), max_t);
+  unsigned mask_hi=priv::isect_ray_tri4(t_+4, u_+4, v_+4, px, py, pz, dx, dy, dz,
+                                        _mm_load_ps(tris_.a[0]+4), _mm_load_ps(tris_.a[1]+4), _mm_load_ps(tris_.a[2]+4),
+                                        _mm_load_ps(tris_.e0[0]+4), _mm_load_ps(tris_.e0[1]+4), _mm_load_ps(tris_.e0[2]+4),
+                                        _mm_load_ps(tris_.e1[0]+4), _mm_load_ps(tris_.e1[1]+4), _mm_load_ps(tris_.e1[2]+4), max_t);
+  return mask_lo|(mask_hi<<4);
+#endif
+}
+//----
+
+PFC_INLINE unsigned isect(float min_t_[4], const ray3f &ray_, const vec3f &rcp_dir_, const soa4_aabox3f &boxes_, float max_t_)
+{
+  return priv::isect_ray_box4(min_t_,
+                              _mm_set1_ps(ray_.pos.x), _mm_set1_ps(ray_.pos.y), _mm_set1_ps(ray_.pos.z),
+                              _mm_set1_ps(rcp_dir_.x), _mm_set1_ps(rcp_dir_.y), _mm_set1_ps(rcp_dir_.z),
+                              _mm_load_ps(boxes_.bmin[0]), _mm_load_ps(boxes_.bmin[1]), _mm_load_ps(boxes_.bmin[2]),
+                              _mm_load_ps(boxes_.bmax[0]), _mm_load_ps(boxes_.bmax[1]), _mm_load_ps(boxes_.bmax[2]),
+                              _mm_set1_ps(max_t_));
+}
+//----
+
+PFC_INLINE unsigned isect(float t_[4], float u_[4], float v_[4], const soa4_ray3f &rays_, const tri3f &tri_, const float max_t_[4])
+{
+  vec3f e0=tri_.b-tri_.a, e1=tri_.c-tri_.a;
+  return priv::isect_ray_tri4(t_, u_, v_,
+                              _mm_load_ps(rays_.pos[0]), _mm_load_ps(rays_.pos[1]), _mm_load_ps(rays_.pos[2]),
+                              _mm_load_ps(rays_.dir[0]), _mm_load_ps(rays_.dir[1]), _mm_load_ps(rays_.dir[2]),
+                              _mm_set1_ps(tri_.a.x), _mm_set1_ps(tri_.a.y), _mm_set1_ps(tri_.a.z),
+                              _mm_set1_ps(e0.x), _mm_set1_ps(e0.y), _mm_set1_ps(e0.z),
+                              _mm_set1_ps(e1.x), _mm_set1_ps(e1.y), _mm_set1_ps(e1.z),
+                              _mm_loadu_ps(max_t_));
+}
+//----
+
+PFC_INLINE unsigned isect(float min_t_[4], const soa4_ray3f &rays_, const vec3f &bmin_, const vec3f &bmax_, const float max_t_[4])
+{
+  return priv::isect_ray_box4(min_t_,
+                              _mm_load_ps(rays_.pos[0]), _mm_load_ps(rays_.pos[1]), _mm_load_ps(rays_.pos[2]),
+                              _mm_load_ps(rays_.rcp_dir[0]), _mm_load_ps(rays_.rcp_dir[1]), _mm_load_ps(rays_.rcp_dir[2]),
+                              _mm_set1_ps(bmin_.x), _mm_set1_ps(bmin_.y), _mm_set1_ps(bmin_.z),
+                              _mm_set1_ps(bmax_.x), _mm_set1_ps(bmax_.y), _mm_set1_ps(bmax_.z),
+                              _mm_loadu_ps(max_t_));
+}
+//----
+
+PFC_INLINE vec3f safe_rcp_dir(const vec3f &dir_)
+{
+  // reciprocal which maps 0 to a large value to keep slab tests NaN free
+  return vec3f(dir_.x?1.0f/dir_.x:1e30f, dir_.y?1.0f/dir_.y:1e30f, dir_.z?1.0f/dir_.z:1e30f);
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa4_ray3f
+//============================================================================
+soa4_ray3f::soa4_ray3f()
+{
+}
+//----
+
+soa4_ray3f::soa4_ray3f(const ray3f *rays_)
+{
+  for(unsigned i=0; i<4; ++i)
+    set(i, rays_[i]);
+}
+//----
+
+void soa4_ray3f::set(unsigned lane_, const ray3f &ray_)
+{
+  PFC_ASSERT_PEDANTIC(lane_<4);
+  vec3f rcp=safe_rcp_dir(ray_.dir);
+  for(unsigned c=0; c<3; ++c)
+  {
+    pos[c][lane_]=ray_.pos[c];
+    dir[c][lane_]=ray_.dir[c];
+    rcp_dir[c][lane_]=rcp[c];
+  }
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa4_tri3f
+//============================================================================
+soa4_tri3f::soa4_tri3f()
+{
+}
+//----
+
+void soa4_tri3f::clear()
+{
+  mem_zero(this, sizeof(*this));
+}
+//----
+
+void soa4_tri3f::set(unsigned lane_, const vec3f &a_, const vec3f &b_, const vec3f &c_)
+{
+  PFC_ASSERT_PEDANTIC(lane_<4);
+  for(unsigned c=0; c<3; ++c)
+  {
+    a[c][lane_]=a_[c];
+    e0[c][lane_]=b_[c]-a_[c];
+    e1[c][lane_]=c_[c]-a_[c];
+  }
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa8_tri3f
+//============================================================================
+soa8_tri3f::soa8_tri3f()
+{
+}
+//----
+
+void soa8_tri3f::clear()
+{
+  mem_zero(this, sizeof(*this));
+}
+//----
+
+void soa8_tri3f::set(unsigned lane_, const vec3f &a_, const vec3f &b_, const vec3f &c_)
+{
+  PFC_ASSERT_PEDANTIC(lane_<8);
+  for(unsigned c=0; c<3; ++c)
+  {
+    a[c][lane_]=a_[c];
+    e0[c][lane_]=b_[c]-a_[c];
+    e1[c][lane_]=c_[c]-a_[c];
+  }
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// soa4_aabox3f
+//============================================================================
+soa4_aabox3f::soa4_aabox3f()
+{
+}
+//----
+
+void soa4_aabox3f::clear()
+{
+  mem_zero(this, sizeof(*this));
+}
+//----
+
+void soa4_aabox3f::set(unsigned lane_, const vec3f &bmin_, const vec3f &bmax_)
+{
+  PFC_ASSERT_PEDANTIC(lane_<4);
+  for(unsigned c=0; c<3; ++c)
+  {
+    bmin[c][lane_]=bmin_[c];
+    bmax[c][lane_]=bmax_[c];
+  }
+}
+//----------------------------------------------------------------------------
@@ -0,0 +1,155 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "sxp_src/sxp_pch.h"
+#include "spherical_harmonics.h"
+#include <xmmintrin.h>
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  //==========================================================================
+  // sh3_poly_sse
+  //==========================================================================
+  // SH3 vector folded to polynomial of the direction components:
+  // f(d)=k0+k1*y+k2*z+k3*x+k4*x*y+k5*y*z+k6*z*z+k7*x*z+k8*(x*x-y*y)
+  struct sh3_poly_sse
+  {
+    // construction
+    void set(const float *coeffs_, unsigned stride_)
+    {
+      static const float s_c0=0.28209479177387814347403972578039f;  //  0.5*sqrt(1/pi)
+      static const float s_c1=0.48860251190291992158638462283835f;  //  0.5*sqrt(3/pi)
+      static const float s_c20=1.0925484305920790705433857058027f;  //  0.5*sqrt(15/pi)
+      static const float s_c21=0.31539156525252000603089369029571f; // 0.25*sqrt(5/pi)
+      static const float s_c22=0.54627421529603953527169285290134f; // 0.25*sqrt(15/pi)
+      k[0]=_mm_set1_ps(s_c0*coeffs_[0]-s_c21*coeffs_[6*stride_]);
+      k[1]=_mm_set1_ps(s_c1*coeffs_[1*stride_]);
+      k[2]=_mm_set1_ps(s_c1*coeffs_[2*stride_]);
+      k[3]=_mm_set1_ps(s_c1*coeffs_[3*stride_]);
+      k[4]=_mm_set1_ps(s_c20*coeffs_[4*stride_]);
+      k[5]=_mm_set1_ps(s_c20*coeffs_[5*stride_]);
+      k[6]=_mm_set1_ps(3.0f*s_c21*coeffs_[6*stride_]);
+      k[7]=_mm_set1_ps(s_c20*coeffs_[7*stride_]);
+      k[8]=_mm_set1_ps(s_c22*coeffs_[8*stride_]);
+    }
+    //------------------------------------------------------------------------
+
+    // evaluation
+    PFC_INLINE __m128 eval(__m128 x_, __m128 y_, __m128 z_, __m128 xy_, __m128 yz_, __m128 zz_, __m128 xz_, __m128 xxyy_) const
+    {
+      __m128 r0=_mm_add_ps(k[0], _mm_mul_ps(k[1], y_));
+      __m128 r1=_mm_add_ps(_mm_mul_ps(k[2], z_), _mm_mul_ps(k[3], x_));
+      __m128 r2=_mm_add_ps(_mm_mul_ps(k[4], xy_), _mm_mul_ps(k[5], yz_));
+      __m128 r3=_mm_add_ps(_mm_mul_ps(k[6], zz_), _mm_mul_ps(k[7], xz_));
+      return _mm_add_ps(_mm_add_ps(_mm_add_ps(r0, r1), _mm_add_ps(r2, r3)), _mm_mul_ps(k[8], xxyy_));
+    }
+    //------------------------------------------------------------------------
+
+    __m128 k[9];
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // sh3_dirs_sse
+  //==========================================================================
+  struct sh3_dirs_sse
+  {
+    PFC_INLINE sh3_dirs_sse(const float *dir_x_, const float *dir_y_, const float *dir_z_)
+    {
+      x=_mm_loadu_ps(dir_x_);
+      y=_mm_loadu_ps(dir_y_);
+      z=_mm_loadu_ps(dir_z_);
+      xy=_mm_mul_ps(x, y);
+      yz=_mm_mul_ps(y, z);
+      zz=_mm_mul_ps(z, z);
+      xz=_mm_mul_ps(x, z);
+      xxyy=_mm_sub_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y));
+    }
+    //------------------------------------------------------------------------
+
+    PFC_INLINE __m128 eval(const sh3_poly_sse &p_) const
+    {
+      return p_.eval(x, y, z, xy, yz, zz, xz, xxyy);
+    }
+    //------------------------------------------------------------------------
+
+    __m128 x, y, z, xy, yz, zz, xz, xxyy;
+  };
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// SH3 batch ops
+//============================================================================
+void pfc::sh_eval(float *res_, const shvec3f &shv_, const float *dir_x_, const float *dir_y_, const float *dir_z_, usize_t num_)
+{
+  // evaluate 4 directions at a time
+  sh3_poly_sse p;
+  p.set(shv_.coeffs, 1);
+  usize_t num_simd=num_&~usize_t(3);
+  for(usize_t i=0; i<num_simd; i+=4)
+  {
+    sh3_dirs_sse d(dir_x_+i, dir_y_+i, dir_z_+i);
+    _mm_storeu_ps(res_+i, d.eval(p));
+  }
+
+  // evaluate remaining directions
+  for(usize_t i=num_simd; i<num_; ++i)
+  {
+    shvec3f b;
+    sh_basis(b, vec3f(dir_x_[i], dir_y_[i], dir_z_[i]));
+    float res=0.0f;
+    for(unsigned ci=0; ci<9; ++ci)
+      res+=shv_.coeffs[ci]*b.coeffs[ci];
+    res_[i]=res;
+  }
+}
+//----
+
+void pfc::sh_eval(vec3f *res_, const shvec3<vec3f> &shv_, const float *dir_x_, const float *dir_y_, const float *dir_z_, usize_t num_)
+{
+  // evaluate 4 directions at a time and interleave RGB channels for output
+  PFC_STATIC_ASSERT(sizeof(vec3f)==3*sizeof(float));
+  sh3_poly_sse pr, pg, pb;
+  pr.set(&shv_.coeffs[0].x, 3);
+  pg.set(&shv_.coeffs[0].y, 3);
+  pb.set(&shv_.coeffs[0].z, 3);
+  usize_t num_simd=num_&~usize_t(3);
+  for(usize_t i=0; i<num_simd; i+=4)
+  {
+    sh3_dirs_sse d(dir_x_+i, dir_y_+i, dir_z_+i);
+    __m128 r=d.eval(pr), g=d.eval(pg), b=d.eval(pb);
+    __m128 rg_lo=_mm_unpacklo_ps(r, g), rg_hi=_mm_unpackhi_ps(r, g);  // r0 g0 r1 g1, r2 g2 r3 g3
+    __m128 t0=_mm_shuffle_ps(b, rg_lo, _MM_SHUFFLE(2, 2, 0, 0));  // b0 b0 r1 r1
+    __m128 t1=_mm_shuffle_ps(rg_lo, b, _MM_SHUFFLE(1, 1, 3, 3));  // g1 g1 b1 b1
+    __m128 t2=_mm_shuffle_ps(b, rg_hi, _MM_SHUFFLE(2, 2, 2, 2));  // b2 b2 r3 r3
+    __m128 t3=_mm_shuffle_ps(rg_hi, b, _MM_SHUFFLE(3, 3, 3, 3));  // g3 g3 b3 b3
+    float *res=&res_[i].x;
+    _mm_storeu_ps(res+0, _mm_shuffle_ps(rg_lo, t0, _MM_SHUFFLE(2, 0, 1, 0)));  // r0 g0 b0 r1
+    _mm_storeu_ps(res+4, _mm_shuffle_ps(t1, rg_hi, _MM_SHUFFLE(1, 0, 2, 0)));  // g1 b1 r2 g2
+    _mm_storeu_ps(res+8, _mm_shuffle_ps(t2, t3, _MM_SHUFFLE(2, 0, 2, 0)));     // b2 r3 g3 b3
+  }
+
+  // evaluate remaining directions
+  for(usize_t i=num_simd; i<num_; ++i)
+  {
+    shvec3f b;
+    sh_basis(b, vec3f(dir_x_[i], dir_y_[i], dir_z_[i]));
+    vec3f res(0.0f, 0.0f, 0.0f);
+    for(unsigned ci=0; ci<9; ++ci)
+      res+=shv_.coeffs[ci]*b.coeffs[ci];
+    res_[i]=res;
+  }
+}
+//----------------------------------------------------------------------------
@@ -43,7 +43,7 @@ template<typename T> PFC_INLINE bool is_sat(const shvec2<T>&);
 template<typename T> PFC_INLINE bool is_ssat(const shvec2<T>&);                                             // test for signed saturated vector, i.e. all coeffs are in range [-1, 1]
 template<typename T, typename U> PFC_INLINE bool operator==(const shvec2<T>&, const shvec2<U>&);            // test for equality of vectors, i.e. all coeffs of the vectors are equal (exact)
 template<typename T, typename U> PFC_INLINE bool operator==(const shvec2<T>&, U);                           // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
-template<typename T, typename U> PFC_INLINE bool operator==(typename U, const shvec2<T>&);                  // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
+template<typename T, typename U> PFC_INLINE bool operator==(U, const shvec2<T>&);                  // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(const shvec2<T>&, const shvec2<U>&);            // test for inequality of vectors, i.e. any of the coeffs of the vectors are unequal (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(const shvec2<T>&, U);                           // test for inequality of vector and value, i.e. any of the coeffs of the vector is unequal to the value (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(U, const shvec2<T>&);                           // test for inequality of vector and value, i.e. any of the coeffs of the vector is unequal to the value (exact)
@@ -162,7 +162,7 @@ template<typename T> PFC_INLINE bool is_sat(const shvec3<T>&);
 template<typename T> PFC_INLINE bool is_ssat(const shvec3<T>&);                                             // test for signed saturated vector, i.e. all coeffs are in range [-1, 1]
 template<typename T, typename U> PFC_INLINE bool operator==(const shvec3<T>&, const shvec3<U>&);            // test for equality of vectors, i.e. all coeffs of the vectors are equal (exact)
 template<typename T, typename U> PFC_INLINE bool operator==(const shvec3<T>&, U);                           // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
-template<typename T, typename U> PFC_INLINE bool operator==(typename U, const shvec3<T>&);                  // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
+template<typename T, typename U> PFC_INLINE bool operator==(U, const shvec3<T>&);                  // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(const shvec3<T>&, const shvec3<U>&);            // test for inequality of vectors, i.e. any of the coeffs of the vectors are unequal (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(const shvec3<T>&, U);                           // test for inequality of vector and value, i.e. any of the coeffs of the vector is unequal to the value (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(U, const shvec3<T>&);                           // test for inequality of vector and value, i.e. any of the coeffs of the vector is unequal to the value (exact)
@@ -275,13 +275,16 @@ template<typename T, typename U> PFC_INLINE shvec3<T> lerp(const shvec3<T> &shv0
 template<typename T, typename U> PFC_INLINE void sh_basis(shvec3<T>&, const vec3<U>&);
 template<typename T, typename U> shvec3<T> sh_product(const shvec3<T>&, const shvec3<U>&);
 template<typename T, typename U> shvec3<T> sh_product(const shvec3<T>&, const zhvec3<U>&);
+// SH3 batch ops
+void sh_eval(float *res_, const shvec3f&, const float *dir_x_, const float *dir_y_, const float *dir_z_, usize_t num_);        // evaluate SH vector for SoA unit directions: res_[i]=dot(shv, sh_basis(dir_i))
+void sh_eval(vec3f *res_, const shvec3<vec3f>&, const float *dir_x_, const float *dir_y_, const float *dir_z_, usize_t num_); // evaluate RGB SH vector for SoA unit directions
 // ZH2 vector ops
 template<typename T> PFC_INLINE bool is_zero(const zhvec2<T>&);                                             // test for zero-vector, i.e. all coeffs equal zero (exact)
 template<typename T> PFC_INLINE bool is_sat(const zhvec2<T>&);                                              // test for saturated vector, i.e. all coeffs are in range [0, 1]
 template<typename T> PFC_INLINE bool is_ssat(const zhvec2<T>&);                                             // test for signed saturated vector, i.e. all coeffs are in range [-1, 1]
 template<typename T, typename U> PFC_INLINE bool operator==(const zhvec2<T>&, const zhvec2<U>&);            // test for equality of vectors, i.e. all coeffs of the vectors are equal (exact)
 template<typename T, typename U> PFC_INLINE bool operator==(const zhvec2<T>&, U);                           // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
-template<typename T, typename U> PFC_INLINE bool operator==(typename U, const zhvec2<T>&);                  // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
+template<typename T, typename U> PFC_INLINE bool operator==(U, const zhvec2<T>&);                  // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(const zhvec2<T>&, const zhvec2<U>&);            // test for inequality of vectors, i.e. any of the coeffs of the vectors are unequal (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(const zhvec2<T>&, U);                           // test for inequality of vector and value, i.e. any of the coeffs of the vector is unequal to the value (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(U, const zhvec2<T>&);                           // test for inequality of vector and value, i.e. any of the coeffs of the vector is unequal to the value (exact)
@@ -394,7 +397,7 @@ template<typename T> PFC_INLINE bool is_sat(const zhvec3<T>&);
 template<typename T> PFC_INLINE bool is_ssat(const zhvec3<T>&);                                             // test for signed saturated vector, i.e. all coeffs are in range [-1, 1]
 template<typename T, typename U> PFC_INLINE bool operator==(const zhvec3<T>&, const zhvec3<U>&);            // test for equality of vectors, i.e. all coeffs of the vectors are equal (exact)
 template<typename T, typename U> PFC_INLINE bool operator==(const zhvec3<T>&, U);                           // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
-template<typename T, typename U> PFC_INLINE bool operator==(typename U, const zhvec3<T>&);                  // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
+template<typename T, typename U> PFC_INLINE bool operator==(U, const zhvec3<T>&);                  // test for equality of vector and value, i.e. all coeffs of the vector equals the value (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(const zhvec3<T>&, const zhvec3<U>&);            // test for inequality of vectors, i.e. any of the coeffs of the vectors are unequal (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(const zhvec3<T>&, U);                           // test for inequality of vector and value, i.e. any of the coeffs of the vector is unequal to the value (exact)
 template<typename T, typename U> PFC_INLINE bool operator!=(U, const zhvec3<T>&);                           // test for inequality of vector and value, i.e. any of the coeffs of the vector is unequal to the value (exact)
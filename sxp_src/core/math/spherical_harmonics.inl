@@ -673,7 +673,7 @@ PFC_INLINE shvec2<T> floor(const shvec2<T> &shv_)
     floor(shv_.coeffs[1]),
     floor(shv_.coeffs[2]),
     floor(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -687,7 +687,7 @@ PFC_INLINE shvec2<T> ceil(const shvec2<T> &shv_)
     ceil(shv_.coeffs[1]),
     ceil(shv_.coeffs[2]),
     ceil(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -701,7 +701,7 @@ PFC_INLINE shvec2<T> trunc(const shvec2<T> &shv_)
     trunc(shv_.coeffs[1]),
     trunc(shv_.coeffs[2]),
     trunc(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -715,7 +715,7 @@ PFC_INLINE shvec2<T> frc(const shvec2<T> &shv_)
     frc(shv_.coeffs[1]),
     frc(shv_.coeffs[2]),
     frc(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -729,7 +729,7 @@ PFC_INLINE shvec2<T> mod(const shvec2<T> &shv_, U div_)
     mod(shv_.coeffs[1], div_),
     mod(shv_.coeffs[2], div_),
     mod(shv_.coeffs[3], div_)
-  }
+  };
   return res;
 }
 //----
@@ -743,7 +743,7 @@ PFC_INLINE shvec2<T> cycle(const shvec2<T> &shv_, U cycle_)
     cycle(shv_.coeffs[1], cycle_),
     cycle(shv_.coeffs[2], cycle_),
     cycle(shv_.coeffs[3], cycle_)
-  }
+  };
   return res;
 }
 //----
@@ -757,7 +757,7 @@ PFC_INLINE shvec2<T> cycle(const shvec2<T> &shv_, const shvec2<U>& cycle_)
     cycle(shv_.coeffs[1], cycle_),
     cycle(shv_.coeffs[2], cycle_),
     cycle(shv_.coeffs[3], cycle_)
-  }
+  };
   return res;
 }
 //----
@@ -771,7 +771,7 @@ PFC_INLINE shvec2<T> cycle1(const shvec2<T> &shv_)
     cycle1(shv_.coeffs[1]),
     cycle1(shv_.coeffs[2]),
     cycle1(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -785,7 +785,7 @@ PFC_INLINE shvec2<T> sat(const shvec2<T> &shv_)
     sat(shv_.coeffs[1]),
     sat(shv_.coeffs[2]),
     sat(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -799,7 +799,7 @@ PFC_INLINE shvec2<T> ssat(const shvec2<T> &shv_)
     ssat(shv_.coeffs[1]),
     ssat(shv_.coeffs[2]),
     ssat(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -813,7 +813,7 @@ PFC_INLINE shvec2<T> clamp(const shvec2<T> &shv_, const shvec2<U> &min_, const s
     clamp(shv_.coeffs[1], min_.coeffs[1], max_.coeffs[1]),
     clamp(shv_.coeffs[2], min_.coeffs[2], max_.coeffs[2]),
     clamp(shv_.coeffs[3], min_.coeffs[3], max_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -827,7 +827,7 @@ PFC_INLINE shvec2<T> clamp(const shvec2<T> &shv_, U min_, U max_)
     clamp(shv_.coeffs[1], min_, max_),
     clamp(shv_.coeffs[2], min_, max_),
     clamp(shv_.coeffs[3], min_, max_)
-  }
+  };
   return res;
 }
 //----
@@ -841,7 +841,7 @@ PFC_INLINE shvec2<T> abs(const shvec2<T> &shv_)
     abs(shv_.coeffs[1]),
     abs(shv_.coeffs[2]),
     abs(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -855,7 +855,7 @@ PFC_INLINE shvec2<T> sgn(const shvec2<T> &shv_)
     sgn(shv_.coeffs[1]),
     sgn(shv_.coeffs[2]),
     sgn(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -869,7 +869,7 @@ PFC_INLINE shvec2<T> sgn_zp(const shvec2<T> &shv_)
     sgn_zp(shv_.coeffs[1]),
     sgn_zp(shv_.coeffs[2]),
     sgn_zp(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -883,7 +883,7 @@ PFC_INLINE shvec2<T> sqr(const shvec2<T> &shv_)
     sqr(shv_.coeffs[1]),
     sqr(shv_.coeffs[2]),
     sqr(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -897,7 +897,7 @@ PFC_INLINE shvec2<T> cubic(const shvec2<T> &shv_)
     cubic(shv_.coeffs[1]),
     cubic(shv_.coeffs[2]),
     cubic(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -911,7 +911,7 @@ PFC_INLINE shvec2<T> sqrt(const shvec2<T> &shv_)
     sqrt(shv_.coeffs[1]),
     sqrt(shv_.coeffs[2]),
     sqrt(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -925,7 +925,7 @@ PFC_INLINE shvec2<T> sqrt_z(const shvec2<T> &shv_)
     sqrt_z(shv_.coeffs[1]),
     sqrt_z(shv_.coeffs[2]),
     sqrt_z(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -939,7 +939,7 @@ PFC_INLINE shvec2<T> cbrt(const shvec2<T> &shv_)
     cbrt(shv_.coeffs[1]),
     cbrt(shv_.coeffs[2]),
     cbrt(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -953,7 +953,7 @@ PFC_INLINE shvec2<T> rsqrt(const shvec2<T> &shv_)
     rsqrt(shv_.coeffs[1]),
     rsqrt(shv_.coeffs[2]),
     rsqrt(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -967,7 +967,7 @@ PFC_INLINE shvec2<T> rsqrt_z(const shvec2<T> &shv_)
     rsqrt_z(shv_.coeffs[1]),
     rsqrt_z(shv_.coeffs[2]),
     rsqrt_z(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -981,7 +981,7 @@ PFC_INLINE shvec2<T> rcbrt(const shvec2<T> &shv_)
     rcbrt(shv_.coeffs[1]),
     rcbrt(shv_.coeffs[2]),
     rcbrt(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -995,7 +995,7 @@ PFC_INLINE shvec2<T> rcbrt_z(const shvec2<T> &shv_)
     rcbrt_z(shv_.coeffs[1]),
     rcbrt_z(shv_.coeffs[2]),
     rcbrt_z(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -1099,7 +1099,7 @@ PFC_INLINE shvec2<T> exp(const shvec2<T> &shv_)
     exp(shv_.coeffs[1]),
     exp(shv_.coeffs[2]),
     exp(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -1113,7 +1113,7 @@ PFC_INLINE shvec2<T> exp2(const shvec2<T> &shv_)
     exp2(shv_.coeffs[1]),
     exp2(shv_.coeffs[2]),
     exp2(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -1127,7 +1127,7 @@ PFC_INLINE shvec2<T> ln(const shvec2<T> &shv_)
     ln(shv_.coeffs[1]),
     ln(shv_.coeffs[2]),
     ln(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -1141,7 +1141,7 @@ PFC_INLINE shvec2<T> log2(const shvec2<T> &shv_)
     log2(shv_.coeffs[1]),
     log2(shv_.coeffs[2]),
     log2(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -1155,7 +1155,7 @@ PFC_INLINE shvec2<T> log10(const shvec2<T> &shv_)
     log10(shv_.coeffs[1]),
     log10(shv_.coeffs[2]),
     log10(shv_.coeffs[3])
-  }
+  };
   return res;
 }
 //----
@@ -1169,7 +1169,7 @@ PFC_INLINE shvec2<T> pow(const shvec2<T> &shv_, U power_)
     pow(shv_.coeffs[1], power_),
     pow(shv_.coeffs[2], power_),
     pow(shv_.coeffs[3], power_)
-  }
+  };
   return res;
 }
 //----
@@ -1187,7 +1187,7 @@ PFC_INLINE shvec2<T> unit(const shvec2<T> &shv_)
     shv_.coeffs[1]*rn,
     shv_.coeffs[2]*rn,
     shv_.coeffs[3]*rn
-  }
+  };
   return res;
 }
 //----
@@ -1205,7 +1205,7 @@ PFC_INLINE shvec2<T> unit_z(const shvec2<T> &shv_)
     shv_.coeffs[1]*rn,
     shv_.coeffs[2]*rn,
     shv_.coeffs[3]*rn
-  }
+  };
   return res;
 }
 //----
@@ -1307,13 +1307,13 @@ PFC_INLINE shvec2<T> lerp(const shvec2<T> &shv0_, const shvec2<T> &shv1_, U t_)
 template<typename T, typename U>
 PFC_INLINE void sh_basis(shvec2<T> &shv_, const vec3<U> &dir_)
 {
-  typedef math<T>::scalar_t scalar_t;
+  typedef typename math<T>::scalar_t scalar_t;
   static const scalar_t s_c0=scalar_t(0.28209479177387814347403972578039); // 0.5*sqrt(1/pi)
   static const scalar_t s_c1=scalar_t(0.48860251190291992158638462283835); // 0.5*sqrt(3/pi)
   shv_.coeffs[0]=s_c0;
-  shv_.coeffs[1]=s_c1*dir.y;
-  shv_.coeffs[2]=s_c1*dir.z;
-  shv_.coeffs[3]=s_c1*dir.x;
+  shv_.coeffs[1]=s_c1*dir_.y;
+  shv_.coeffs[2]=s_c1*dir_.z;
+  shv_.coeffs[3]=s_c1*dir_.x;
 }
 //----
 
@@ -1338,10 +1338,10 @@ shvec2<T> sh_product(const shvec2<T> &shv_, const zhvec2<U> &zhv_)
 {
   shvec2<T> res=
   {
-    shv0_.coeffs[0]*zhv_.coeffs[0],
-    shv0_.coeffs[1]*zhv_.coeffs[1],
-    shv0_.coeffs[2]*zhv_.coeffs[1],
-    shv0_.coeffs[3]*zhv_.coeffs[1]
+    shv_.coeffs[0]*zhv_.coeffs[0],
+    shv_.coeffs[1]*zhv_.coeffs[1],
+    shv_.coeffs[2]*zhv_.coeffs[1],
+    shv_.coeffs[3]*zhv_.coeffs[1]
   };
   return res;
 }
@@ -1820,15 +1820,15 @@ PFC_INLINE shvec3<T> operator*(const shvec3<T> &shv_, const shmat3<U> &shm_)
 {
   shvec3<T> res=
   {
-    shv.coeffs[0]*shm_.m[0][0]+shv.coeffs[1]*shm_.m[1][0]+shv.coeffs[2]*shm_.m[2][0]+shv.coeffs[3]*shm_.m[3][0]+shv.coeffs[4]*shm_.m[4][0]+shv.coeffs[5]*shm_.m[5][0]+shv.coeffs[6]*shm_.m[6][0]+shv.coeffs[7]*shm_.m[7][0]+shv.coeffs[8]*shm_.m[8][0],
-    shv.coeffs[0]*shm_.m[0][1]+shv.coeffs[1]*shm_.m[1][1]+shv.coeffs[2]*shm_.m[2][1]+shv.coeffs[3]*shm_.m[3][1]+shv.coeffs[4]*shm_.m[4][1]+shv.coeffs[5]*shm_.m[5][1]+shv.coeffs[6]*shm_.m[6][1]+shv.coeffs[7]*shm_.m[7][1]+shv.coeffs[8]*shm_.m[8][1],
-    shv.coeffs[0]*shm_.m[0][2]+shv.coeffs[1]*shm_.m[1][2]+shv.coeffs[2]*shm_.m[2][2]+shv.coeffs[3]*shm_.m[3][2]+shv.coeffs[4]*shm_.m[4][2]+shv.coeffs[5]*shm_.m[5][2]+shv.coeffs[6]*shm_.m[6][2]+shv.coeffs[7]*shm_.m[7][2]+shv.coeffs[8]*shm_.m[8][2],
-    shv.coeffs[0]*shm_.m[0][3]+shv.coeffs[1]*shm_.m[1][3]+shv.coeffs[2]*shm_.m[2][3]+shv.coeffs[3]*shm_.m[3][3]+shv.coeffs[4]*shm_.m[4][3]+shv.coeffs[5]*shm_.m[5][3]+shv.coeffs[6]*shm_.m[6][3]+shv.coeffs[7]*shm_.m[7][3]+shv.coeffs[8]*shm_.m[8][3],
-    shv.coeffs[0]*shm_.m[0][4]+shv.coeffs[1]*shm_.m[1][4]+shv.coeffs[2]*shm_.m[2][4]+shv.coeffs[3]*shm_.m[3][4]+shv.coeffs[4]*shm_.m[4][4]+shv.coeffs[5]*shm_.m[5][4]+shv.coeffs[6]*shm_.m[6][4]+shv.coeffs[7]*shm_.m[7][4]+shv.coeffs[8]*shm_.m[8][4],
-    shv.coeffs[0]*shm_.m[0][5]+shv.coeffs[1]*shm_.m[1][5]+shv.coeffs[2]*shm_.m[2][5]+shv.coeffs[3]*shm_.m[3][5]+shv.coeffs[4]*shm_.m[4][5]+shv.coeffs[5]*shm_.m[5][5]+shv.coeffs[6]*shm_.m[6][5]+shv.coeffs[7]*shm_.m[7][5]+shv.coeffs[8]*shm_.m[8][5],
-    shv.coeffs[0]*shm_.m[0][6]+shv.coeffs[1]*shm_.m[1][6]+shv.coeffs[2]*shm_.m[2][6]+shv.coeffs[3]*shm_.m[3][6]+shv.coeffs[4]*shm_.m[4][6]+shv.coeffs[5]*shm_.m[5][6]+shv.coeffs[6]*shm_.m[6][6]+shv.coeffs[7]*shm_.m[7][6]+shv.coeffs[8]*shm_.m[8][6],
-    shv.coeffs[0]*shm_.m[0][7]+shv.coeffs[1]*shm_.m[1][7]+shv.coeffs[2]*shm_.m[2][7]+shv.coeffs[3]*shm_.m[3][7]+shv.coeffs[4]*shm_.m[4][7]+shv.coeffs[5]*shm_.m[5][7]+shv.coeffs[6]*shm_.m[6][7]+shv.coeffs[7]*shm_.m[7][7]+shv.coeffs[8]*shm_.m[8][7],
-    shv.coeffs[0]*shm_.m[0][8]+shv.coeffs[1]*shm_.m[1][8]+shv.coeffs[2]*shm_.m[2][8]+shv.coeffs[3]*shm_.m[3][8]+shv.coeffs[4]*shm_.m[4][8]+shv.coeffs[5]*shm_.m[5][8]+shv.coeffs[6]*shm_.m[6][8]+shv.coeffs[7]*shm_.m[7][8]+shv.coeffs[8]*shm_.m[8][8]
+    shv_.coeffs[0]*shm_.m[0][0]+shv_.coeffs[1]*shm_.m[1][0]+shv_.coeffs[2]*shm_.m[2][0]+shv_.coeffs[3]*shm_.m[3][0]+shv_.coeffs[4]*shm_.m[4][0]+shv_.coeffs[5]*shm_.m[5][0]+shv_.coeffs[6]*shm_.m[6][0]+shv_.coeffs[7]*shm_.m[7][0]+shv_.coeffs[8]*shm_.m[8][0],
+    shv_.coeffs[0]*shm_.m[0][1]+shv_.coeffs[1]*shm_.m[1][1]+shv_.coeffs[2]*shm_.m[2][1]+shv_.coeffs[3]*shm_.m[3][1]+shv_.coeffs[4]*shm_.m[4][1]+shv_.coeffs[5]*shm_.m[5][1]+shv_.coeffs[6]*shm_.m[6][1]+shv_.coeffs[7]*shm_.m[7][1]+shv_.coeffs[8]*shm_.m[8][1],
+    shv_.coeffs[0]*shm_.m[0][2]+shv_.coeffs[1]*shm_.m[1][2]+shv_.coeffs[2]*shm_.m[2][2]+shv_.coeffs[3]*shm_.m[3][2]+shv_.coeffs[4]*shm_.m[4][2]+shv_.coeffs[5]*shm_.m[5][2]+shv_.coeffs[6]*shm_.m[6][2]+shv_.coeffs[7]*shm_.m[7][2]+shv_.coeffs[8]*shm_.m[8][2],
+    shv_.coeffs[0]*shm_.m[0][3]+shv_.coeffs[1]*shm_.m[1][3]+shv_.coeffs[2]*shm_.m[2][3]+shv_.coeffs[3]*shm_.m[3][3]+shv_.coeffs[4]*shm_.m[4][3]+shv_.coeffs[5]*shm_.m[5][3]+shv_.coeffs[6]*shm_.m[6][3]+shv_.coeffs[7]*shm_.m[7][3]+shv_.coeffs[8]*shm_.m[8][3],
+    shv_.coeffs[0]*shm_.m[0][4]+shv_.coeffs[1]*shm_.m[1][4]+shv_.coeffs[2]*shm_.m[2][4]+shv_.coeffs[3]*shm_.m[3][4]+shv_.coeffs[4]*shm_.m[4][4]+shv_.coeffs[5]*shm_.m[5][4]+shv_.coeffs[6]*shm_.m[6][4]+shv_.coeffs[7]*shm_.m[7][4]+shv_.coeffs[8]*shm_.m[8][4],
+    shv_.coeffs[0]*shm_.m[0][5]+shv_.coeffs[1]*shm_.m[1][5]+shv_.coeffs[2]*shm_.m[2][5]+shv_.coeffs[3]*shm_.m[3][5]+shv_.coeffs[4]*shm_.m[4][5]+shv_.coeffs[5]*shm_.m[5][5]+shv_.coeffs[6]*shm_.m[6][5]+shv_.coeffs[7]*shm_.m[7][5]+shv_.coeffs[8]*shm_.m[8][5],
+    shv_.coeffs[0]*shm_.m[0][6]+shv_.coeffs[1]*shm_.m[1][6]+shv_.coeffs[2]*shm_.m[2][6]+shv_.coeffs[3]*shm_.m[3][6]+shv_.coeffs[4]*shm_.m[4][6]+shv_.coeffs[5]*shm_.m[5][6]+shv_.coeffs[6]*shm_.m[6][6]+shv_.coeffs[7]*shm_.m[7][6]+shv_.coeffs[8]*shm_.m[8][6],
+    shv_.coeffs[0]*shm_.m[0][7]+shv_.coeffs[1]*shm_.m[1][7]+shv_.coeffs[2]*shm_.m[2][7]+shv_.coeffs[3]*shm_.m[3][7]+shv_.coeffs[4]*shm_.m[4][7]+shv_.coeffs[5]*shm_.m[5][7]+shv_.coeffs[6]*shm_.m[6][7]+shv_.coeffs[7]*shm_.m[7][7]+shv_.coeffs[8]*shm_.m[8][7],
+    shv_.coeffs[0]*shm_.m[0][8]+shv_.coeffs[1]*shm_.m[1][8]+shv_.coeffs[2]*shm_.m[2][8]+shv_.coeffs[3]*shm_.m[3][8]+shv_.coeffs[4]*shm_.m[4][8]+shv_.coeffs[5]*shm_.m[5][8]+shv_.coeffs[6]*shm_.m[6][8]+shv_.coeffs[7]*shm_.m[7][8]+shv_.coeffs[8]*shm_.m[8][8]
   };
   return res;
 }
@@ -1839,15 +1839,15 @@ PFC_INLINE shvec3<T> operator*(const shmat3<T> &shm_, const shvec3<U> &shv_)
 {
   shvec3<T> res=
   {
-    shv.coeffs[0]*shm_.m[0][0]+shv.coeffs[1]*shm_.m[0][1]+shv.coeffs[2]*shm_.m[0][2]+shv.coeffs[3]*shm_.m[0][3]+shv.coeffs[4]*shm_.m[0][4]+shv.coeffs[5]*shm_.m[0][5]+shv.coeffs[6]*shm_.m[0][6]+shv.coeffs[7]*shm_.m[0][7]+shv.coeffs[8]*shm_.m[0][8],
-    shv.coeffs[0]*shm_.m[1][0]+shv.coeffs[1]*shm_.m[1][1]+shv.coeffs[2]*shm_.m[1][2]+shv.coeffs[3]*shm_.m[1][3]+shv.coeffs[4]*shm_.m[1][4]+shv.coeffs[5]*shm_.m[1][5]+shv.coeffs[6]*shm_.m[1][6]+shv.coeffs[7]*shm_.m[1][7]+shv.coeffs[8]*shm_.m[1][8],
-    shv.coeffs[0]*shm_.m[2][0]+shv.coeffs[1]*shm_.m[2][1]+shv.coeffs[2]*shm_.m[2][2]+shv.coeffs[3]*shm_.m[2][3]+shv.coeffs[4]*shm_.m[2][4]+shv.coeffs[5]*shm_.m[2][5]+shv.coeffs[6]*shm_.m[2][6]+shv.coeffs[7]*shm_.m[2][7]+shv.coeffs[8]*shm_.m[2][8],
-    shv.coeffs[0]*shm_.m[3][0]+shv.coeffs[1]*shm_.m[3][1]+shv.coeffs[2]*shm_.m[3][2]+shv.coeffs[3]*shm_.m[3][3]+shv.coeffs[4]*shm_.m[3][4]+shv.coeffs[5]*shm_.m[3][5]+shv.coeffs[6]*shm_.m[3][6]+shv.coeffs[7]*shm_.m[3][7]+shv.coeffs[8]*shm_.m[3][8],
-    shv.coeffs[0]*shm_.m[4][0]+shv.coeffs[1]*shm_.m[4][1]+shv.coeffs[2]*shm_.m[4][2]+shv.coeffs[3]*shm_.m[4][3]+shv.coeffs[4]*shm_.m[4][4]+shv.coeffs[5]*shm_.m[4][5]+shv.coeffs[6]*shm_.m[4][6]+shv.coeffs[7]*shm_.m[4][7]+shv.coeffs[8]*shm_.m[4][8],
-    shv.coeffs[0]*shm_.m[5][0]+shv.coeffs[1]*shm_.m[5][1]+shv.coeffs[2]*shm_.m[5][2]+shv.coeffs[3]*shm_.m[5][3]+shv.coeffs[4]*shm_.m[5][4]+shv.coeffs[5]*shm_.m[5][5]+shv.coeffs[6]*shm_.m[5][6]+shv.coeffs[7]*shm_.m[5][7]+shv.coeffs[8]*shm_.m[5][8],
-    shv.coeffs[0]*shm_.m[6][0]+shv.coeffs[1]*shm_.m[6][1]+shv.coeffs[2]*shm_.m[6][2]+shv.coeffs[3]*shm_.m[6][3]+shv.coeffs[4]*shm_.m[6][4]+shv.coeffs[5]*shm_.m[6][5]+shv.coeffs[6]*shm_.m[6][6]+shv.coeffs[7]*shm_.m[6][7]+shv.coeffs[8]*shm_.m[6][8],
-    shv.coeffs[0]*shm_.m[7][0]+shv.coeffs[1]*shm_.m[7][1]+shv.coeffs[2]*shm_.m[7][2]+shv.coeffs[3]*shm_.m[7][3]+shv.coeffs[4]*shm_.m[7][4]+shv.coeffs[5]*shm_.m[7][5]+shv.coeffs[6]*shm_.m[7][6]+shv.coeffs[7]*shm_.m[7][7]+shv.coeffs[8]*shm_.m[7][8],
-    shv.coeffs[0]*shm_.m[8][0]+shv.coeffs[1]*shm_.m[8][1]+shv.coeffs[2]*shm_.m[8][2]+shv.coeffs[3]*shm_.m[8][3]+shv.coeffs[4]*shm_.m[8][4]+shv.coeffs[5]*shm_.m[8][5]+shv.coeffs[6]*shm_.m[8][6]+shv.coeffs[7]*shm_.m[8][7]+shv.coeffs[8]*shm_.m[8][8]
+    shv_.coeffs[0]*shm_.m[0][0]+shv_.coeffs[1]*shm_.m[0][1]+shv_.coeffs[2]*shm_.m[0][2]+shv_.coeffs[3]*shm_.m[0][3]+shv_.coeffs[4]*shm_.m[0][4]+shv_.coeffs[5]*shm_.m[0][5]+shv_.coeffs[6]*shm_.m[0][6]+shv_.coeffs[7]*shm_.m[0][7]+shv_.coeffs[8]*shm_.m[0][8],
+    shv_.coeffs[0]*shm_.m[1][0]+shv_.coeffs[1]*shm_.m[1][1]+shv_.coeffs[2]*shm_.m[1][2]+shv_.coeffs[3]*shm_.m[1][3]+shv_.coeffs[4]*shm_.m[1][4]+shv_.coeffs[5]*shm_.m[1][5]+shv_.coeffs[6]*shm_.m[1][6]+shv_.coeffs[7]*shm_.m[1][7]+shv_.coeffs[8]*shm_.m[1][8],
+    shv_.coeffs[0]*shm_.m[2][0]+shv_.coeffs[1]*shm_.m[2][1]+shv_.coeffs[2]*shm_.m[2][2]+shv_.coeffs[3]*shm_.m[2][3]+shv_.coeffs[4]*shm_.m[2][4]+shv_.coeffs[5]*shm_.m[2][5]+shv_.coeffs[6]*shm_.m[2][6]+shv_.coeffs[7]*shm_.m[2][7]+shv_.coeffs[8]*shm_.m[2][8],
+    shv_.coeffs[0]*shm_.m[3][0]+shv_.coeffs[1]*shm_.m[3][1]+shv_.coeffs[2]*shm_.m[3][2]+shv_.coeffs[3]*shm_.m[3][3]+shv_.coeffs[4]*shm_.m[3][4]+shv_.coeffs[5]*shm_.m[3][5]+shv_.coeffs[6]*shm_.m[3][6]+shv_.coeffs[7]*shm_.m[3][7]+shv_.coeffs[8]*shm_.m[3][8],
+    shv_.coeffs[0]*shm_.m[4][0]+shv_.coeffs[1]*shm_.m[4][1]+shv_.coeffs[2]*shm_.m[4][2]+shv_.coeffs[3]*shm_.m[4][3]+shv_.coeffs[4]*shm_.m[4][4]+shv_.coeffs[5]*shm_.m[4][5]+shv_.coeffs[6]*shm_.m[4][6]+shv_.coeffs[7]*shm_.m[4][7]+shv_.coeffs[8]*shm_.m[4][8],
+    shv_.coeffs[0]*shm_.m[5][0]+shv_.coeffs[1]*shm_.m[5][1]+shv_.coeffs[2]*shm_.m[5][2]+shv_.coeffs[3]*shm_.m[5][3]+shv_.coeffs[4]*shm_.m[5][4]+shv_.coeffs[5]*shm_.m[5][5]+shv_.coeffs[6]*shm_.m[5][6]+shv_.coeffs[7]*shm_.m[5][7]+shv_.coeffs[8]*shm_.m[5][8],
+    shv_.coeffs[0]*shm_.m[6][0]+shv_.coeffs[1]*shm_.m[6][1]+shv_.coeffs[2]*shm_.m[6][2]+shv_.coeffs[3]*shm_.m[6][3]+shv_.coeffs[4]*shm_.m[6][4]+shv_.coeffs[5]*shm_.m[6][5]+shv_.coeffs[6]*shm_.m[6][6]+shv_.coeffs[7]*shm_.m[6][7]+shv_.coeffs[8]*shm_.m[6][8],
+    shv_.coeffs[0]*shm_.m[7][0]+shv_.coeffs[1]*shm_.m[7][1]+shv_.coeffs[2]*shm_.m[7][2]+shv_.coeffs[3]*shm_.m[7][3]+shv_.coeffs[4]*shm_.m[7][4]+shv_.coeffs[5]*shm_.m[7][5]+shv_.coeffs[6]*shm_.m[7][6]+shv_.coeffs[7]*shm_.m[7][7]+shv_.coeffs[8]*shm_.m[7][8],
+    shv_.coeffs[0]*shm_.m[8][0]+shv_.coeffs[1]*shm_.m[8][1]+shv_.coeffs[2]*shm_.m[8][2]+shv_.coeffs[3]*shm_.m[8][3]+shv_.coeffs[4]*shm_.m[8][4]+shv_.coeffs[5]*shm_.m[8][5]+shv_.coeffs[6]*shm_.m[8][6]+shv_.coeffs[7]*shm_.m[8][7]+shv_.coeffs[8]*shm_.m[8][8]
   };
   return res;
 }
@@ -2274,7 +2274,7 @@ PFC_INLINE shvec3<T> floor(const shvec3<T> &shv_)
     floor(shv_.coeffs[6]),
     floor(shv_.coeffs[7]),
     floor(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2293,7 +2293,7 @@ PFC_INLINE shvec3<T> ceil(const shvec3<T> &shv_)
     ceil(shv_.coeffs[6]),
     ceil(shv_.coeffs[7]),
     ceil(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2312,7 +2312,7 @@ PFC_INLINE shvec3<T> trunc(const shvec3<T> &shv_)
     trunc(shv_.coeffs[6]),
     trunc(shv_.coeffs[7]),
     trunc(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2331,7 +2331,7 @@ PFC_INLINE shvec3<T> frc(const shvec3<T> &shv_)
     frc(shv_.coeffs[6]),
     frc(shv_.coeffs[7]),
     frc(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2350,7 +2350,7 @@ PFC_INLINE shvec3<T> mod(const shvec3<T> &shv_, U div_)
     mod(shv_.coeffs[6], div_),
     mod(shv_.coeffs[7], div_),
     mod(shv_.coeffs[8], div_)
-  }
+  };
   return res;
 }
 //----
@@ -2369,7 +2369,7 @@ PFC_INLINE shvec3<T> cycle(const shvec3<T> &shv_, U cycle_)
     cycle(shv_.coeffs[6], cycle_),
     cycle(shv_.coeffs[7], cycle_),
     cycle(shv_.coeffs[8], cycle_)
-  }
+  };
   return res;
 }
 //----
@@ -2388,7 +2388,7 @@ PFC_INLINE shvec3<T> cycle(const shvec3<T> &shv_, const shvec3<U>& cycle_)
     cycle(shv_.coeffs[6], cycle_),
     cycle(shv_.coeffs[7], cycle_),
     cycle(shv_.coeffs[8], cycle_)
-  }
+  };
   return res;
 }
 //----
@@ -2407,7 +2407,7 @@ PFC_INLINE shvec3<T> cycle1(const shvec3<T> &shv_)
     cycle1(shv_.coeffs[6]),
     cycle1(shv_.coeffs[7]),
     cycle1(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2426,7 +2426,7 @@ PFC_INLINE shvec3<T> sat(const shvec3<T> &shv_)
     sat(shv_.coeffs[6]),
     sat(shv_.coeffs[7]),
     sat(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2445,7 +2445,7 @@ PFC_INLINE shvec3<T> ssat(const shvec3<T> &shv_)
     ssat(shv_.coeffs[6]),
     ssat(shv_.coeffs[7]),
     ssat(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2464,7 +2464,7 @@ PFC_INLINE shvec3<T> clamp(const shvec3<T> &shv_, const shvec3<U> &min_, const s
     clamp(shv_.coeffs[6], min_.coeffs[6], max_.coeffs[6]),
     clamp(shv_.coeffs[7], min_.coeffs[7], max_.coeffs[7]),
     clamp(shv_.coeffs[8], min_.coeffs[8], max_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2483,7 +2483,7 @@ PFC_INLINE shvec3<T> clamp(const shvec3<T> &shv_, U min_, U max_)
     clamp(shv_.coeffs[6], min_, max_),
     clamp(shv_.coeffs[7], min_, max_),
     clamp(shv_.coeffs[8], min_, max_)
-  }
+  };
   return res;
 }
 //----
@@ -2502,7 +2502,7 @@ PFC_INLINE shvec3<T> abs(const shvec3<T> &shv_)
     abs(shv_.coeffs[6]),
     abs(shv_.coeffs[7]),
     abs(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2521,7 +2521,7 @@ PFC_INLINE shvec3<T> sgn(const shvec3<T> &shv_)
     sgn(shv_.coeffs[6]),
     sgn(shv_.coeffs[7]),
     sgn(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2540,7 +2540,7 @@ PFC_INLINE shvec3<T> sgn_zp(const shvec3<T> &shv_)
     sgn_zp(shv_.coeffs[6]),
     sgn_zp(shv_.coeffs[7]),
     sgn_zp(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2559,7 +2559,7 @@ PFC_INLINE shvec3<T> sqr(const shvec3<T> &shv_)
     sqr(shv_.coeffs[6]),
     sqr(shv_.coeffs[7]),
     sqr(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2578,7 +2578,7 @@ PFC_INLINE shvec3<T> cubic(const shvec3<T> &shv_)
     cubic(shv_.coeffs[6]),
     cubic(shv_.coeffs[7]),
     cubic(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2597,7 +2597,7 @@ PFC_INLINE shvec3<T> sqrt(const shvec3<T> &shv_)
     sqrt(shv_.coeffs[6]),
     sqrt(shv_.coeffs[7]),
     sqrt(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2616,7 +2616,7 @@ PFC_INLINE shvec3<T> sqrt_z(const shvec3<T> &shv_)
     sqrt_z(shv_.coeffs[6]),
     sqrt_z(shv_.coeffs[7]),
     sqrt_z(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2635,7 +2635,7 @@ PFC_INLINE shvec3<T> cbrt(const shvec3<T> &shv_)
     cbrt(shv_.coeffs[6]),
     cbrt(shv_.coeffs[7]),
     cbrt(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2654,7 +2654,7 @@ PFC_INLINE shvec3<T> rsqrt(const shvec3<T> &shv_)
     rsqrt(shv_.coeffs[6]),
     rsqrt(shv_.coeffs[7]),
     rsqrt(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2673,7 +2673,7 @@ PFC_INLINE shvec3<T> rsqrt_z(const shvec3<T> &shv_)
     rsqrt_z(shv_.coeffs[6]),
     rsqrt_z(shv_.coeffs[7]),
     rsqrt_z(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2692,7 +2692,7 @@ PFC_INLINE shvec3<T> rcbrt(const shvec3<T> &shv_)
     rcbrt(shv_.coeffs[6]),
     rcbrt(shv_.coeffs[7]),
     rcbrt(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2711,7 +2711,7 @@ PFC_INLINE shvec3<T> rcbrt_z(const shvec3<T> &shv_)
     rcbrt_z(shv_.coeffs[6]),
     rcbrt_z(shv_.coeffs[7]),
     rcbrt_z(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2865,7 +2865,7 @@ PFC_INLINE shvec3<T> exp(const shvec3<T> &shv_)
     exp(shv_.coeffs[6]),
     exp(shv_.coeffs[7]),
     exp(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2884,7 +2884,7 @@ PFC_INLINE shvec3<T> exp2(const shvec3<T> &shv_)
     exp2(shv_.coeffs[6]),
     exp2(shv_.coeffs[7]),
     exp2(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2903,7 +2903,7 @@ PFC_INLINE shvec3<T> ln(const shvec3<T> &shv_)
     ln(shv_.coeffs[6]),
     ln(shv_.coeffs[7]),
     ln(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2922,7 +2922,7 @@ PFC_INLINE shvec3<T> log2(const shvec3<T> &shv_)
     log2(shv_.coeffs[6]),
     log2(shv_.coeffs[7]),
     log2(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2941,7 +2941,7 @@ PFC_INLINE shvec3<T> log10(const shvec3<T> &shv_)
     log10(shv_.coeffs[6]),
     log10(shv_.coeffs[7]),
     log10(shv_.coeffs[8])
-  }
+  };
   return res;
 }
 //----
@@ -2960,7 +2960,7 @@ PFC_INLINE shvec3<T> pow(const shvec3<T> &shv_, U power_)
     pow(shv_.coeffs[6], power_),
     pow(shv_.coeffs[7], power_),
     pow(shv_.coeffs[8], power_)
-  }
+  };
   return res;
 }
 //----
@@ -2988,7 +2988,7 @@ PFC_INLINE shvec3<T> unit(const shvec3<T> &shv_)
     shv_.coeffs[6]*rn,
     shv_.coeffs[7]*rn,
     shv_.coeffs[8]*rn
-  }
+  };
   return res;
 }
 //----
@@ -3016,7 +3016,7 @@ PFC_INLINE shvec3<T> unit_z(const shvec3<T> &shv_)
     shv_.coeffs[6]*rn,
     shv_.coeffs[7]*rn,
     shv_.coeffs[8]*rn
-  }
+  };
   return res;
 }
 //----
@@ -3158,7 +3158,7 @@ PFC_INLINE shvec3<T> lerp(const shvec3<T> &shv0_, const shvec3<T> &shv1_, U t_)
 template<typename T, typename U>
 PFC_INLINE void sh_basis(shvec3<T> &shv_, const vec3<U> &dir_)
 {
-  typedef math<T>::scalar_t scalar_t;
+  typedef typename math<T>::scalar_t scalar_t;
   static const scalar_t s_c0=scalar_t(0.28209479177387814347403972578039);  //  0.5*sqrt(1/pi)
   static const scalar_t s_c1=scalar_t(0.48860251190291992158638462283835);  //  0.5*sqrt(3/pi)
   static const scalar_t s_c20=scalar_t(1.0925484305920790705433857058027);  //  0.5*sqrt(15/pi)
@@ -3180,7 +3180,7 @@ template<typename T, typename U>
 shvec3<T> sh_product(const shvec3<T> &shv0_, const shvec3<U> &shv1_)
 {
   // product constants (22 muls)
-  typedef math<T>::scalar_t scalar_t;
+  typedef typename math<T>::scalar_t scalar_t;
   static const scalar_t s_f0=scalar_t(0.3194382824999699566298819526759); // sqrt(5/49)
   static const scalar_t s_f1=scalar_t(0.4472135954999579392818347337463); // sqrt(1/5)
   static const scalar_t s_f2=scalar_t(0.5532833351724881264541807713975); // sqrt(15/49)
@@ -3233,15 +3233,15 @@ shvec3<T> sh_product(const shvec3<T> &shv_, const zhvec3<U> &zhv_)
 {
   shvec3<T> res=
   {
-    shv0_.coeffs[0]*zhv_.coeffs[0],
-    shv0_.coeffs[1]*zhv_.coeffs[1],
-    shv0_.coeffs[2]*zhv_.coeffs[1],
-    shv0_.coeffs[3]*zhv_.coeffs[1],
-    shv0_.coeffs[4]*zhv_.coeffs[2],
-    shv0_.coeffs[5]*zhv_.coeffs[2],
-    shv0_.coeffs[6]*zhv_.coeffs[2],
-    shv0_.coeffs[7]*zhv_.coeffs[2],
-    shv0_.coeffs[8]*zhv_.coeffs[2]
+    shv_.coeffs[0]*zhv_.coeffs[0],
+    shv_.coeffs[1]*zhv_.coeffs[1],
+    shv_.coeffs[2]*zhv_.coeffs[1],
+    shv_.coeffs[3]*zhv_.coeffs[1],
+    shv_.coeffs[4]*zhv_.coeffs[2],
+    shv_.coeffs[5]*zhv_.coeffs[2],
+    shv_.coeffs[6]*zhv_.coeffs[2],
+    shv_.coeffs[7]*zhv_.coeffs[2],
+    shv_.coeffs[8]*zhv_.coeffs[2]
   };
   return res;
 }
@@ -3352,7 +3352,7 @@ PFC_INLINE void operator+=(zhvec2<T> &zhvr_, U v_)
 //----
 
 template<typename T, typename U>
-PFC_INLINE void operator-=(zhvec2<T> &zhvr_, const zhvec2<U>&)
+PFC_INLINE void operator-=(zhvec2<T> &zhvr_, const zhvec2<U> &zhv_)
 {
   zhvr_.coeffs[0]-=zhv_.coeffs[0];
   zhvr_.coeffs[1]-=zhv_.coeffs[1];
@@ -3368,7 +3368,7 @@ PFC_INLINE void operator-=(zhvec2<T> &zhvr_, U v_)
 //----
 
 template<typename T, typename U>
-PFC_INLINE void operator*=(zhvec2<T> &zhvr_, const zhvec2<U>&)
+PFC_INLINE void operator*=(zhvec2<T> &zhvr_, const zhvec2<U> &zhv_)
 {
   zhvr_.coeffs[0]*=zhv_.coeffs[0];
   zhvr_.coeffs[1]*=zhv_.coeffs[1];
@@ -3509,7 +3509,7 @@ PFC_INLINE zhvec2<T> operator*(const zhvec2<T> &zhv_, U v_)
 //----
 
 template<typename T, typename U>
-PFC_INLINE zhvec2<T> operator*(T U_, const zhvec2<T> &zhv_)
+PFC_INLINE zhvec2<T> operator*(U v_, const zhvec2<T> &zhv_)
 {
   zhvec2<T> res=
   {
@@ -3790,7 +3790,7 @@ PFC_INLINE zhvec2<T> floor(const zhvec2<T> &zhv_)
   {
     floor(zhv_.coeffs[0]),
     floor(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3802,7 +3802,7 @@ PFC_INLINE zhvec2<T> ceil(const zhvec2<T> &zhv_)
   {
     ceil(zhv_.coeffs[0]),
     ceil(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3814,7 +3814,7 @@ PFC_INLINE zhvec2<T> trunc(const zhvec2<T> &zhv_)
   {
     trunc(zhv_.coeffs[0]),
     trunc(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3826,7 +3826,7 @@ PFC_INLINE zhvec2<T> frc(const zhvec2<T> &zhv_)
   {
     frc(zhv_.coeffs[0]),
     frc(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3838,7 +3838,7 @@ PFC_INLINE zhvec2<T> mod(const zhvec2<T> &zhv_, U div_)
   {
     mod(zhv_.coeffs[0], div_),
     mod(zhv_.coeffs[1], div_)
-  }
+  };
   return res;
 }
 //----
@@ -3850,7 +3850,7 @@ PFC_INLINE zhvec2<T> cycle(const zhvec2<T> &zhv_, U cycle_)
   {
     cycle(zhv_.coeffs[0], cycle_),
     cycle(zhv_.coeffs[1], cycle_)
-  }
+  };
   return res;
 }
 //----
@@ -3862,7 +3862,7 @@ PFC_INLINE zhvec2<T> cycle(const zhvec2<T> &zhv_, const zhvec2<U>& cycle_)
   {
     cycle(zhv_.coeffs[0], cycle_),
     cycle(zhv_.coeffs[1], cycle_)
-  }
+  };
   return res;
 }
 //----
@@ -3874,7 +3874,7 @@ PFC_INLINE zhvec2<T> cycle1(const zhvec2<T> &zhv_)
   {
     cycle1(zhv_.coeffs[0]),
     cycle1(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3886,7 +3886,7 @@ PFC_INLINE zhvec2<T> sat(const zhvec2<T> &zhv_)
   {
     sat(zhv_.coeffs[0]),
     sat(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3898,7 +3898,7 @@ PFC_INLINE zhvec2<T> ssat(const zhvec2<T> &zhv_)
   {
     ssat(zhv_.coeffs[0]),
     ssat(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3910,7 +3910,7 @@ PFC_INLINE zhvec2<T> clamp(const zhvec2<T> &zhv_, const zhvec2<U> &min_, const z
   {
     clamp(zhv_.coeffs[0], min_.coeffs[0], max_.coeffs[0]),
     clamp(zhv_.coeffs[1], min_.coeffs[1], max_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3922,7 +3922,7 @@ PFC_INLINE zhvec2<T> clamp(const zhvec2<T> &zhv_, U min_, U max_)
   {
     clamp(zhv_.coeffs[0], min_, max_),
     clamp(zhv_.coeffs[1], min_, max_)
-  }
+  };
   return res;
 }
 //----
@@ -3934,7 +3934,7 @@ PFC_INLINE zhvec2<T> abs(const zhvec2<T> &zhv_)
   {
     abs(zhv_.coeffs[0]),
     abs(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3946,7 +3946,7 @@ PFC_INLINE zhvec2<T> sgn(const zhvec2<T> &zhv_)
   {
     sgn(zhv_.coeffs[0]),
     sgn(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3958,7 +3958,7 @@ PFC_INLINE zhvec2<T> sgn_zp(const zhvec2<T> &zhv_)
   {
     sgn_zp(zhv_.coeffs[0]),
     sgn_zp(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3970,7 +3970,7 @@ PFC_INLINE zhvec2<T> sqr(const zhvec2<T> &zhv_)
   {
     sqr(zhv_.coeffs[0]),
     sqr(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3982,7 +3982,7 @@ PFC_INLINE zhvec2<T> cubic(const zhvec2<T> &zhv_)
   {
     cubic(zhv_.coeffs[0]),
     cubic(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -3994,7 +3994,7 @@ PFC_INLINE zhvec2<T> sqrt(const zhvec2<T> &zhv_)
   {
     sqrt(zhv_.coeffs[0]),
     sqrt(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4006,7 +4006,7 @@ PFC_INLINE zhvec2<T> sqrt_z(const zhvec2<T> &zhv_)
   {
     sqrt_z(zhv_.coeffs[0]),
     sqrt_z(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4018,7 +4018,7 @@ PFC_INLINE zhvec2<T> cbrt(const zhvec2<T> &zhv_)
   {
     cbrt(zhv_.coeffs[0]),
     cbrt(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4030,7 +4030,7 @@ PFC_INLINE zhvec2<T> rsqrt(const zhvec2<T> &zhv_)
   {
     rsqrt(zhv_.coeffs[0]),
     rsqrt(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4042,7 +4042,7 @@ PFC_INLINE zhvec2<T> rsqrt_z(const zhvec2<T> &zhv_)
   {
     rsqrt_z(zhv_.coeffs[0]),
     rsqrt_z(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4054,7 +4054,7 @@ PFC_INLINE zhvec2<T> rcbrt(const zhvec2<T> &zhv_)
   {
     rcbrt(zhv_.coeffs[0]),
     rcbrt(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4066,7 +4066,7 @@ PFC_INLINE zhvec2<T> rcbrt_z(const zhvec2<T> &zhv_)
   {
     rcbrt_z(zhv_.coeffs[0]),
     rcbrt_z(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4150,7 +4150,7 @@ PFC_INLINE zhvec2<T> exp(const zhvec2<T> &zhv_)
   {
     exp(zhv_.coeffs[0]),
     exp(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4162,7 +4162,7 @@ PFC_INLINE zhvec2<T> exp2(const zhvec2<T> &zhv_)
   {
     exp2(zhv_.coeffs[0]),
     exp2(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4174,7 +4174,7 @@ PFC_INLINE zhvec2<T> ln(const zhvec2<T> &zhv_)
   {
     ln(zhv_.coeffs[0]),
     ln(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4186,7 +4186,7 @@ PFC_INLINE zhvec2<T> log2(const zhvec2<T> &zhv_)
   {
     log2(zhv_.coeffs[0]),
     log2(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4198,7 +4198,7 @@ PFC_INLINE zhvec2<T> log10(const zhvec2<T> &zhv_)
   {
     log10(zhv_.coeffs[0]),
     log10(zhv_.coeffs[1])
-  }
+  };
   return res;
 }
 //----
@@ -4210,7 +4210,7 @@ PFC_INLINE zhvec2<T> pow(const zhvec2<T> &zhv_, U power_)
   {
     pow(zhv_.coeffs[0], power_),
     pow(zhv_.coeffs[1], power_)
-  }
+  };
   return res;
 }
 //----
@@ -4224,7 +4224,7 @@ PFC_INLINE zhvec2<T> unit(const zhvec2<T> &zhv_)
   {
     zhv_.coeffs[0]*rn,
     zhv_.coeffs[1]*rn
-  }
+  };
   return res;
 }
 //----
@@ -4238,7 +4238,7 @@ PFC_INLINE zhvec2<T> unit_z(const zhvec2<T> &zhv_)
   {
     zhv_.coeffs[0]*rn,
     zhv_.coeffs[1]*rn
-  }
+  };
   return res;
 }
 //----
@@ -4437,7 +4437,7 @@ PFC_INLINE void operator+=(zhvec3<T> &zhvr_, U v_)
 //----
 
 template<typename T, typename U>
-PFC_INLINE void operator-=(zhvec3<T> &zhvr_, const zhvec3<U>&)
+PFC_INLINE void operator-=(zhvec3<T> &zhvr_, const zhvec3<U> &zhv_)
 {
   zhvr_.coeffs[0]-=zhv_.coeffs[0];
   zhvr_.coeffs[1]-=zhv_.coeffs[1];
@@ -4455,7 +4455,7 @@ PFC_INLINE void operator-=(zhvec3<T> &zhvr_, U v_)
 //----
 
 template<typename T, typename U>
-PFC_INLINE void operator*=(zhvec3<T> &zhvr_, const zhvec3<U>&)
+PFC_INLINE void operator*=(zhvec3<T> &zhvr_, const zhvec3<U> &zhv_)
 {
   zhvr_.coeffs[0]*=zhv_.coeffs[0];
   zhvr_.coeffs[1]*=zhv_.coeffs[1];
@@ -4912,7 +4912,7 @@ PFC_INLINE zhvec3<T> floor(const zhvec3<T> &zhv_)
     floor(zhv_.coeffs[0]),
     floor(zhv_.coeffs[1]),
     floor(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -4925,7 +4925,7 @@ PFC_INLINE zhvec3<T> ceil(const zhvec3<T> &zhv_)
     ceil(zhv_.coeffs[0]),
     ceil(zhv_.coeffs[1]),
     ceil(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -4938,7 +4938,7 @@ PFC_INLINE zhvec3<T> trunc(const zhvec3<T> &zhv_)
     trunc(zhv_.coeffs[0]),
     trunc(zhv_.coeffs[1]),
     trunc(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -4951,7 +4951,7 @@ PFC_INLINE zhvec3<T> frc(const zhvec3<T> &zhv_)
     frc(zhv_.coeffs[0]),
     frc(zhv_.coeffs[1]),
     frc(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -4964,7 +4964,7 @@ PFC_INLINE zhvec3<T> mod(const zhvec3<T> &zhv_, U div_)
     mod(zhv_.coeffs[0], div_),
     mod(zhv_.coeffs[1], div_),
     mod(zhv_.coeffs[2], div_)
-  }
+  };
   return res;
 }
 //----
@@ -4977,7 +4977,7 @@ PFC_INLINE zhvec3<T> cycle(const zhvec3<T> &zhv_, U cycle_)
     cycle(zhv_.coeffs[0], cycle_),
     cycle(zhv_.coeffs[1], cycle_),
     cycle(zhv_.coeffs[2], cycle_)
-  }
+  };
   return res;
 }
 //----
@@ -4990,7 +4990,7 @@ PFC_INLINE zhvec3<T> cycle(const zhvec3<T> &zhv_, const zhvec3<U>& cycle_)
     cycle(zhv_.coeffs[0], cycle_),
     cycle(zhv_.coeffs[1], cycle_),
     cycle(zhv_.coeffs[2], cycle_)
-  }
+  };
   return res;
 }
 //----
@@ -5003,7 +5003,7 @@ PFC_INLINE zhvec3<T> cycle1(const zhvec3<T> &zhv_)
     cycle1(zhv_.coeffs[0]),
     cycle1(zhv_.coeffs[1]),
     cycle1(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5016,7 +5016,7 @@ PFC_INLINE zhvec3<T> sat(const zhvec3<T> &zhv_)
     sat(zhv_.coeffs[0]),
     sat(zhv_.coeffs[1]),
     sat(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5029,7 +5029,7 @@ PFC_INLINE zhvec3<T> ssat(const zhvec3<T> &zhv_)
     ssat(zhv_.coeffs[0]),
     ssat(zhv_.coeffs[1]),
     ssat(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5042,7 +5042,7 @@ PFC_INLINE zhvec3<T> clamp(const zhvec3<T> &zhv_, const zhvec3<U> &min_, const z
     clamp(zhv_.coeffs[0], min_.coeffs[0], max_.coeffs[0]),
     clamp(zhv_.coeffs[1], min_.coeffs[1], max_.coeffs[1]),
     clamp(zhv_.coeffs[2], min_.coeffs[2], max_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5055,7 +5055,7 @@ PFC_INLINE zhvec3<T> clamp(const zhvec3<T> &zhv_, U min_, U max_)
     clamp(zhv_.coeffs[0], min_, max_),
     clamp(zhv_.coeffs[1], min_, max_),
     clamp(zhv_.coeffs[2], min_, max_)
-  }
+  };
   return res;
 }
 //----
@@ -5068,7 +5068,7 @@ PFC_INLINE zhvec3<T> abs(const zhvec3<T> &zhv_)
     abs(zhv_.coeffs[0]),
     abs(zhv_.coeffs[1]),
     abs(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5081,7 +5081,7 @@ PFC_INLINE zhvec3<T> sgn(const zhvec3<T> &zhv_)
     sgn(zhv_.coeffs[0]),
     sgn(zhv_.coeffs[1]),
     sgn(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5094,7 +5094,7 @@ PFC_INLINE zhvec3<T> sgn_zp(const zhvec3<T> &zhv_)
     sgn_zp(zhv_.coeffs[0]),
     sgn_zp(zhv_.coeffs[1]),
     sgn_zp(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5107,7 +5107,7 @@ PFC_INLINE zhvec3<T> sqr(const zhvec3<T> &zhv_)
     sqr(zhv_.coeffs[0]),
     sqr(zhv_.coeffs[1]),
     sqr(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5120,7 +5120,7 @@ PFC_INLINE zhvec3<T> cubic(const zhvec3<T> &zhv_)
     cubic(zhv_.coeffs[0]),
     cubic(zhv_.coeffs[1]),
     cubic(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5133,7 +5133,7 @@ PFC_INLINE zhvec3<T> sqrt(const zhvec3<T> &zhv_)
     sqrt(zhv_.coeffs[0]),
     sqrt(zhv_.coeffs[1]),
     sqrt(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5146,7 +5146,7 @@ PFC_INLINE zhvec3<T> sqrt_z(const zhvec3<T> &zhv_)
     sqrt_z(zhv_.coeffs[0]),
     sqrt_z(zhv_.coeffs[1]),
     sqrt_z(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5159,7 +5159,7 @@ PFC_INLINE zhvec3<T> cbrt(const zhvec3<T> &zhv_)
     cbrt(zhv_.coeffs[0]),
     cbrt(zhv_.coeffs[1]),
     cbrt(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5172,7 +5172,7 @@ PFC_INLINE zhvec3<T> rsqrt(const zhvec3<T> &zhv_)
     rsqrt(zhv_.coeffs[0]),
     rsqrt(zhv_.coeffs[1]),
     rsqrt(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5185,7 +5185,7 @@ PFC_INLINE zhvec3<T> rsqrt_z(const zhvec3<T> &zhv_)
     rsqrt_z(zhv_.coeffs[0]),
     rsqrt_z(zhv_.coeffs[1]),
     rsqrt_z(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5198,7 +5198,7 @@ PFC_INLINE zhvec3<T> rcbrt(const zhvec3<T> &zhv_)
     rcbrt(zhv_.coeffs[0]),
     rcbrt(zhv_.coeffs[1]),
     rcbrt(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5211,7 +5211,7 @@ PFC_INLINE zhvec3<T> rcbrt_z(const zhvec3<T> &zhv_)
     rcbrt_z(zhv_.coeffs[0]),
     rcbrt_z(zhv_.coeffs[1]),
     rcbrt_z(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5305,7 +5305,7 @@ PFC_INLINE zhvec3<T> exp(const zhvec3<T> &zhv_)
     exp(zhv_.coeffs[0]),
     exp(zhv_.coeffs[1]),
     exp(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5318,7 +5318,7 @@ PFC_INLINE zhvec3<T> exp2(const zhvec3<T> &zhv_)
     exp2(zhv_.coeffs[0]),
     exp2(zhv_.coeffs[1]),
     exp2(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5331,7 +5331,7 @@ PFC_INLINE zhvec3<T> ln(const zhvec3<T> &zhv_)
     ln(zhv_.coeffs[0]),
     ln(zhv_.coeffs[1]),
     ln(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5344,7 +5344,7 @@ PFC_INLINE zhvec3<T> log2(const zhvec3<T> &zhv_)
     log2(zhv_.coeffs[0]),
     log2(zhv_.coeffs[1]),
     log2(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5357,7 +5357,7 @@ PFC_INLINE zhvec3<T> log10(const zhvec3<T> &zhv_)
     log10(zhv_.coeffs[0]),
     log10(zhv_.coeffs[1]),
     log10(zhv_.coeffs[2])
-  }
+  };
   return res;
 }
 //----
@@ -5370,7 +5370,7 @@ PFC_INLINE zhvec3<T> pow(const zhvec3<T> &zhv_, U power_)
     pow(zhv_.coeffs[0], power_),
     pow(zhv_.coeffs[1], power_),
     pow(zhv_.coeffs[2], power_)
-  }
+  };
   return res;
 }
 //----
@@ -5386,7 +5386,7 @@ PFC_INLINE zhvec3<T> unit(const zhvec3<T> &zhv_)
     zhv_.coeffs[0]*rn,
     zhv_.coeffs[1]*rn,
     zhv_.coeffs[2]*rn
-  }
+  };
   return res;
 }
 //----
@@ -5402,7 +5402,7 @@ PFC_INLINE zhvec3<T> unit_z(const zhvec3<T> &zhv_)
     zhv_.coeffs[0]*rn,
     zhv_.coeffs[1]*rn,
     zhv_.coeffs[2]*rn
-  }
+  };
   return res;
 }
 //----
@@ -202,6 +202,14 @@ sequential_memory_allocator::~sequential_memory_allocator()
 }
 //----
 
+void sequential_memory_allocator::check_allocator(usize_t num_bytes_, usize_t mem_align_)
+{
+  PFC_CHECK_MSG(m_support_free_blocks || num_bytes_<=m_max_stride_alloc_size, ("sequential_memory_allocator allocates at most %u byte memory blocks (requesting %u bytes)\r\n", m_max_stride_alloc_size, num_bytes_));
+  PFC_CHECK_MSG(mem_align_ && mem_align_<=memory_align && (mem_align_&(mem_align_-1))==0,
+                ("sequential_memory_allocator memory alignment must be power-of-2 and in range [1, %u] (requesting %u byte alignment)\r\n", memory_align, mem_align_));
+}
+//----
+
 void sequential_memory_allocator::release()
 {
   // check for no allocations and release memory resources
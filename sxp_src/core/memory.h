@@ -86,6 +86,7 @@ public:
   // construction
   sequential_memory_allocator(usize_t stride_size_=65536, usize_t max_stride_alloc_size_=1024, bool support_free_blocks_=false);
   ~sequential_memory_allocator();
+  virtual void check_allocator(usize_t num_bytes_, usize_t mem_align_);
   void release();
   void force_release();
   //--------------------------------------------------------------------------
@@ -40,6 +40,7 @@ template<typename> struct is_type_pod_dtor;      // rs: POD semantics for defaul
 template<typename> struct is_type_pod_move;      // rs: POD semantics for memory moves (can be moved with mem_copy() without calls to copy-ctor/dtor)
 template<typename> struct is_type_pod_copy;      // rs: POD semantics for copying (can be copied with mem_copy() without call to copy-ctor)
 template<typename> struct is_type_pod_stream;    // rs: POD semantics for streaming (can be read/written from/to binary stream as plain data)
+template<typename> struct is_type_pod_archive;   // rs: POD semantics for archiving (archived as plain data, i.e. no padding and all members archived as plain data)
 template<typename> struct is_type_copyable;      // rs: public copy-constructor
 template<typename> struct is_type_mono;          // monomorphic types (types without v-table)
 template<typename> struct is_type_poly;          // polymorphic types (classes with v-table)
@@ -394,6 +394,17 @@ struct is_type_pod_stream
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// is_type_pod_archive
+//============================================================================
+template<typename T>
+struct is_type_pod_archive
+{
+  enum {res=is_type_fund<T>::res && !is_type_equal<T, bool>::res};
+};
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // is_type_copyable
 //============================================================================
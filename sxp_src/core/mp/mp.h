@@ -38,6 +38,9 @@ template<typename T> PFC_INLINE T atom_cmov_lte(volatile T &dst_, T v_, T cmp_);
 template<typename T> PFC_INLINE T atom_cmov_gte(volatile T &dst_, T v_, T cmp_);  // dst_=dst_>=cmp_?v_:dst_; returns dst_ before cmov
 template<typename T> PFC_INLINE T atom_cmov_min(volatile T &dst_, T v_);          // dst_=dst_<v_?dst_:v_; returns dst_ before cmov
 template<typename T> PFC_INLINE T atom_cmov_max(volatile T &dst_, T v_);          // dst_=dst_>v_?dst_:v_; returns dst_ before cmov
+PFC_INLINE void atom_fence_acquire();                                             // prior loads aren't reordered with following loads & stores
+PFC_INLINE void atom_fence_release();                                             // prior loads & stores aren't reordered with following stores
+PFC_INLINE void atom_fence();                                                     // full memory fence
 // basic lock-free constructs
 template<typename T, T *(T::*next_mvar)> PFC_INLINE void atom_push_front(T*&, T&);
 template<typename T> class mp_tptr;
@@ -46,6 +49,7 @@ template<typename T, T *(T::*next_mvar)> class mp_fifo_queue;
 template<typename T, T *(T::*next_mvar)> class mp_lifo_queue;
 // thread & synchronization objects
 class mp_thread;
+class mp_fiber;
 class mp_event;
 class mp_gate;
 class mp_critical_section;
@@ -56,6 +60,8 @@ PFC_INLINE bool wait_gate(mp_gate&, float timeout_secs_=0.0f);
 // misc
 void set_hardware_thread(unsigned hw_thread_idx_);
 unsigned num_hardware_threads();
+usize_t create_thread_exit_key(void(*exit_func_)(void*)); // exit_func_ is called at thread exit for non-null thread value of the key
+void set_thread_exit_value(usize_t key_, void*);
 enum e_process_priority
 {
   processpriority_idle=-3,
@@ -290,6 +296,48 @@ private:
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// mp_fiber
+//============================================================================
+// Stackful fiber running on its own stack with a guard page. resume() runs
+// the fiber on the calling thread until the fiber calls suspend() or the fiber
+// function returns, and a suspended fiber may be resumed on any thread.
+// Destroying a suspended fiber doesn't unwind its stack. Compilers may cache
+// addresses of thread local variables, so fiber code shouldn't hold thread
+// local state over suspend() calls.
+class mp_fiber
+{
+public:
+  // construction
+  mp_fiber();
+  mp_fiber(const functor<void()>&, usize_t stack_size_=0);
+  void init(const functor<void()>&, usize_t stack_size_=0);
+  ~mp_fiber();
+  //--------------------------------------------------------------------------
+
+  // execution
+  void resume();
+  static void suspend();
+  static mp_fiber *active();
+  //--------------------------------------------------------------------------
+
+  // accessors
+  bool is_finished() const;
+  //--------------------------------------------------------------------------
+
+private:
+  mp_fiber(const mp_fiber&); // not implemented
+  void operator=(const mp_fiber&); // not implemented
+  static PFC_FIBER_PROC;
+  //--------------------------------------------------------------------------
+
+  mp_fiber_handle_t m_handle;
+  functor<void()> m_func;
+  mp_fiber *m_resumer;
+};
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // mp_event
 //============================================================================
@@ -0,0 +1,421 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "sxp_src/sxp_pch.h"
+#include "mp_heap.h"
+#include "sxp_src/core/math/bit_math.h"
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// config
+//============================================================================
+enum {span_size=64*1024};         // size of a span of same size class blocks (spans are aligned to their size)
+enum {span_header_size=64};       // size of the span header in the beginning of each span
+enum {arena_size=2*1024*1024};    // size of huge page backed arenas spans are carved from
+enum {span_class_large=0xffff};   // span "size class" of large allocations
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  struct thread_heap;
+  //==========================================================================
+  // heap_span
+  //==========================================================================
+  struct heap_span
+  {
+    thread_heap *heap;   // owner heap
+    heap_span *next;     // next span of the size class in the owner heap (or in the global span pool)
+    heap_span *prev;     // previous span of the size class in the owner heap
+    void *free_list;     // list of freed blocks
+    char *bump;          // next never allocated block
+    uint32_t block_size;
+    uint32_t bump_left;  // number of never allocated blocks
+    uint32_t num_used;   // number of allocated blocks
+    uint16_t size_class;
+    uint16_t is_full;    // span is full and unlinked from the owner heap span list
+    usize_t large_size;  // number of mapped bytes for large allocations
+  };
+  PFC_STATIC_ASSERT(sizeof(heap_span)<=span_header_size);
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // thread_heap
+  //==========================================================================
+  struct thread_heap
+  {
+    void *volatile remote_free;                      // blocks freed by other threads (lock-free stack)
+    char pad[64-sizeof(void*)];                      // keep remote frees in separate cache line
+    heap_span *spans[mp_heap_num_size_classes];      // spans with free blocks per size class
+    thread_heap *next;                               // next heap in the list of all heaps
+    thread_heap *next_abandoned;                     // next heap in the list of abandoned heaps
+    usize_t num_allocs;
+    usize_t num_frees;
+    usize_t num_remote_frees;
+    usize_t num_spans;
+    usize_t class_live_blocks[mp_heap_num_size_classes];
+  };
+  //--------------------------------------------------------------------------
+
+  // global heap state (zero initialized prior to static construction, thus usable by static constructors)
+  PFC_THREAD_VAR thread_heap *s_heap=0;
+  volatile int32_t s_pool_lock=0;
+  heap_span *s_free_spans=0;
+  char *s_arena_pos=0, *s_arena_end=0;
+  thread_heap *s_heaps=0, *s_abandoned_heaps=0;
+  usize_t s_num_heaps=0, s_num_free_spans=0, s_arena_bytes=0;
+  volatile usize_t s_num_large_allocs=0, s_large_bytes=0;
+  usize_t s_thread_exit_key=0;
+  bool s_has_thread_exit_key=false;
+  void(*s_os_map_hook)(void*, usize_t, bool)=0;
+  //--------------------------------------------------------------------------
+
+  PFC_INLINE void lock_pool()
+  {
+    while(atom_cmov_eq(s_pool_lock, int32_t(1), int32_t(0)))
+      thread_nap();
+  }
+  //----
+
+  PFC_INLINE void unlock_pool()
+  {
+    atom_write(s_pool_lock, int32_t(0));
+  }
+  //--------------------------------------------------------------------------
+
+  PFC_INLINE unsigned size_class(usize_t num_bytes_)
+  {
+    // 16 byte steps up to 256 bytes and 4 steps per power-of-2 above
+    uint32_t v=uint32_t(num_bytes_?num_bytes_-1:0);
+    if(v<256)
+      return v>>4;
+    unsigned pow2=msb_pos(v);
+    return 16+(pow2-8)*4+((v-(uint32_t(1)<<pow2))>>(pow2-2));
+  }
+  //----
+
+  PFC_INLINE heap_span *owner_span(void *p_)
+  {
+    return (heap_span*)(usize_t(p_)&~usize_t(span_size-1));
+  }
+  //--------------------------------------------------------------------------
+
+  void abandon_heap(void *heap_)
+  {
+    // move heap of the exiting thread to the abandoned list for adoption by new threads
+    thread_heap *heap=(thread_heap*)heap_;
+    s_heap=0;
+    lock_pool();
+    heap->next_abandoned=s_abandoned_heaps;
+    s_abandoned_heaps=heap;
+    unlock_pool();
+  }
+  //----
+
+  thread_heap *create_heap()
+  {
+    // adopt abandoned heap
+    lock_pool();
+    if(!s_has_thread_exit_key)
+    {
+      s_thread_exit_key=create_thread_exit_key(&abandon_heap);
+      s_has_thread_exit_key=true;
+    }
+    thread_heap *heap=s_abandoned_heaps;
+    if(heap)
+      s_abandoned_heaps=heap->next_abandoned;
+    unlock_pool();
+
+    // create new heap (OS mapped memory is zero initialized)
+    if(!heap)
+    {
+      heap=(thread_heap*)map_os_memory(sizeof(thread_heap), 64);
+      PFC_CHECK_MSG(heap, ("Unable to allocate thread heap\r\n"));
+      lock_pool();
+      heap->next=s_heaps;
+      s_heaps=heap;
+      ++s_num_heaps;
+      unlock_pool();
+      if(s_os_map_hook)
+        s_os_map_hook(heap, sizeof(thread_heap), true);
+    }
+    heap->next_abandoned=0;
+    s_heap=heap;
+    set_thread_exit_value(s_thread_exit_key, heap);
+    return heap;
+  }
+  //--------------------------------------------------------------------------
+
+  heap_span *alloc_span()
+  {
+    // get span from the span pool or carve a new one from the current arena
+    lock_pool();
+    heap_span *span=s_free_spans;
+    if(span)
+    {
+      s_free_spans=span->next;
+      --s_num_free_spans;
+      unlock_pool();
+      return span;
+    }
+    char *arena=0;
+    if(s_arena_pos==s_arena_end)
+    {
+      arena=(char*)map_os_memory(arena_size, arena_size, true);
+      if(!arena)
+      {
+        unlock_pool();
+        return 0;
+      }
+      s_arena_pos=arena;
+      s_arena_end=arena+arena_size;
+      s_arena_bytes+=arena_size;
+    }
+    span=(heap_span*)s_arena_pos;
+    s_arena_pos+=span_size;
+    unlock_pool();
+    if(arena && s_os_map_hook)
+      s_os_map_hook(arena, arena_size, true);
+    return span;
+  }
+  //----
+
+  void release_span(heap_span &span_)
+  {
+    // return span to the span pool
+    lock_pool();
+    span_.next=s_free_spans;
+    s_free_spans=&span_;
+    ++s_num_free_spans;
+    unlock_pool();
+  }
+  //--------------------------------------------------------------------------
+
+  PFC_INLINE void link_span(thread_heap &heap_, heap_span &span_)
+  {
+    heap_span *&head=heap_.spans[span_.size_class];
+    span_.prev=0;
+    span_.next=head;
+    if(head)
+      head->prev=&span_;
+    head=&span_;
+  }
+  //----
+
+  PFC_INLINE void unlink_span(thread_heap &heap_, heap_span &span_)
+  {
+    if(span_.prev)
+      span_.prev->next=span_.next;
+    else
+      heap_.spans[span_.size_class]=span_.next;
+    if(span_.next)
+      span_.next->prev=span_.prev;
+  }
+  //--------------------------------------------------------------------------
+
+  PFC_INLINE void *span_alloc(thread_heap &heap_, heap_span &span_)
+  {
+    // allocate block from the free list or from never allocated blocks
+    void *p=span_.free_list;
+    if(p)
+      span_.free_list=*(void**)p;
+    else if(span_.bump_left)
+    {
+      p=span_.bump;
+      span_.bump+=span_.block_size;
+      --span_.bump_left;
+    }
+    else
+      return 0;
+    ++span_.num_used;
+    ++heap_.num_allocs;
+    ++heap_.class_live_blocks[span_.size_class];
+    return p;
+  }
+  //----
+
+  void local_free(thread_heap &heap_, heap_span &span_, void *p_)
+  {
+    // add block to the span free list
+    *(void**)p_=span_.free_list;
+    span_.free_list=p_;
+    --span_.num_used;
+    ++heap_.num_frees;
+    --heap_.class_live_blocks[span_.size_class];
+    if(span_.is_full)
+    {
+      // relink full span to the heap for allocation
+      span_.is_full=0;
+      link_span(heap_, span_);
+    }
+    else if(!span_.num_used && (span_.prev || span_.next))
+    {
+      // release empty span unless it's the only span of the size class
+      unlink_span(heap_, span_);
+      --heap_.num_spans;
+      release_span(span_);
+    }
+  }
+  //----
+
+  void drain_remote_frees(thread_heap &heap_)
+  {
+    // free all blocks freed to the heap by other threads
+    void *p=atom_read(heap_.remote_free)?atom_mov(heap_.remote_free, (void*)0):0;
+    while(p)
+    {
+      void *next=*(void**)p;
+      local_free(heap_, *owner_span(p), p);
+      ++heap_.num_remote_frees;
+      p=next;
+    }
+  }
+  //--------------------------------------------------------------------------
+
+  void *alloc_small_slow(thread_heap &heap_, unsigned size_class_)
+  {
+    // try to allocate from existing spans (unlink full spans)
+    drain_remote_frees(heap_);
+    while(heap_span *span=heap_.spans[size_class_])
+    {
+      if(void *p=span_alloc(heap_, *span))
+        return p;
+      unlink_span(heap_, *span);
+      span->is_full=1;
+    }
+
+    // setup new span for the size class
+    heap_span *span=alloc_span();
+    if(!span)
+      return 0;
+    uint32_t block_size=uint32_t(mp_heap_size_class_bytes(size_class_));
+    span->heap=&heap_;
+    span->free_list=0;
+    span->bump=((char*)span)+span_header_size;
+    span->block_size=block_size;
+    span->bump_left=(span_size-span_header_size)/block_size;
+    span->num_used=0;
+    span->size_class=uint16_t(size_class_);
+    span->is_full=0;
+    span->large_size=0;
+    link_span(heap_, *span);
+    ++heap_.num_spans;
+    return span_alloc(heap_, *span);
+  }
+  //----
+
+  void *alloc_large(usize_t num_bytes_)
+  {
+    // map span aligned memory directly from the OS
+    usize_t size=num_bytes_+span_header_size;
+    heap_span *span=(heap_span*)map_os_memory(size, span_size, size>=arena_size);
+    if(!span)
+      return 0;
+    span->heap=0;
+    span->size_class=span_class_large;
+    span->large_size=size;
+    atom_inc(s_num_large_allocs);
+    atom_add(s_large_bytes, size);
+    if(s_os_map_hook)
+      s_os_map_hook(span, size, true);
+    return ((char*)span)+span_header_size;
+  }
+  //----
+
+  void free_large(heap_span &span_)
+  {
+    usize_t size=span_.large_size;
+    atom_dec(s_num_large_allocs);
+    atom_add(s_large_bytes, usize_t(0)-size);
+    if(s_os_map_hook)
+      s_os_map_hook(&span_, size, false);
+    unmap_os_memory(&span_, size);
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// mp_heap
+//============================================================================
+void *pfc::mp_heap_alloc(usize_t num_bytes_)
+{
+  // allocate small blocks from the thread heap and large directly from the OS
+  if(num_bytes_>mp_heap_max_small_size)
+    return alloc_large(num_bytes_);
+  thread_heap *heap=s_heap;
+  if(!heap)
+    heap=create_heap();
+  unsigned sc=size_class(num_bytes_);
+  if(heap_span *span=heap->spans[sc])
+    if(void *p=span_alloc(*heap, *span))
+      return p;
+  return alloc_small_slow(*heap, sc);
+}
+//----
+
+void pfc::mp_heap_free(void *p_)
+{
+  // check for large allocation
+  if(!p_)
+    return;
+  heap_span *span=owner_span(p_);
+  if(span->size_class==span_class_large)
+  {
+    free_large(*span);
+    return;
+  }
+
+  // free the block to the span directly if owned by the thread heap, otherwise push to the owner heap
+  thread_heap *heap=span->heap;
+  if(heap==s_heap)
+  {
+    local_free(*heap, *span, p_);
+    return;
+  }
+  void *head;
+  do
+  {
+    head=heap->remote_free;
+    *(void**)p_=head;
+  } while(atom_cmov_eq(heap->remote_free, p_, head)!=head);
+}
+//----------------------------------------------------------------------------
+
+void pfc::get_mp_heap_stats(mp_heap_stats &stats_)
+{
+  // gather stats from all thread heaps
+  mem_zero(&stats_, sizeof(stats_));
+  lock_pool();
+  for(thread_heap *heap=s_heaps; heap; heap=heap->next)
+  {
+    stats_.num_allocs+=heap->num_allocs;
+    stats_.num_frees+=heap->num_frees;
+    stats_.num_remote_frees+=heap->num_remote_frees;
+    stats_.num_spans+=heap->num_spans;
+    for(unsigned i=0; i<mp_heap_num_size_classes; ++i)
+      stats_.class_live_blocks[i]+=heap->class_live_blocks[i];
+  }
+  stats_.num_heaps=s_num_heaps;
+  stats_.arena_bytes=s_arena_bytes;
+  stats_.num_free_spans=s_num_free_spans;
+  unlock_pool();
+  stats_.num_large_allocs=atom_read(s_num_large_allocs);
+  stats_.large_bytes=atom_read(s_large_bytes);
+}
+//----
+
+void pfc::set_mp_heap_os_map_hook(void(*hook_)(void *ptr_, usize_t num_bytes_, bool is_map_))
+{
+  s_os_map_hook=hook_;
+}
+//----------------------------------------------------------------------------
@@ -0,0 +1,60 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_CORE_MP_HEAP_H
+#define PFC_CORE_MP_HEAP_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "mp.h"
+namespace pfc
+{
+
+// new
+struct mp_heap_stats;
+enum {mp_heap_num_size_classes=36};   // number of small allocation size classes
+enum {mp_heap_max_small_size=8192};   // max small allocation size (bigger allocations are mapped directly from the OS)
+void get_mp_heap_stats(mp_heap_stats&);
+void set_mp_heap_os_map_hook(void(*hook_)(void *ptr_, usize_t num_bytes_, bool is_map_));
+PFC_INLINE usize_t mp_heap_size_class_bytes(unsigned size_class_);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// mp_heap_stats
+//============================================================================
+// Thread-caching size-class heap (mp_heap_alloc()/mp_heap_free()) statistics.
+// Each thread allocates small blocks from its own heap of 64KB spans carved
+// from huge page backed 2MB arenas, and blocks freed by other threads are
+// returned to the owner heap through a lock-free queue. Heaps of exited
+// threads are adopted by new threads. Counters are gathered from per-thread
+// heaps without synchronization, so they are approximate while other threads
+// are allocating.
+struct mp_heap_stats
+{
+  usize_t num_heaps;                                  // number of thread heaps (including heaps of exited threads)
+  usize_t num_allocs;                                 // number of small allocations
+  usize_t num_frees;                                  // number of small frees
+  usize_t num_remote_frees;                           // number of small frees from other than the owner thread
+  usize_t num_large_allocs;                           // number of live large allocations
+  usize_t large_bytes;                                // bytes mapped for live large allocations
+  usize_t arena_bytes;                                // bytes mapped for span arenas
+  usize_t num_spans;                                  // number of spans in use by heaps
+  usize_t num_free_spans;                             // number of spans in the global span pool
+  usize_t class_live_blocks[mp_heap_num_size_classes]; // number of live blocks per size class
+};
+PFC_SET_TYPE_TRAIT(mp_heap_stats, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+//============================================================================
+#include "mp_heap.inl"
+} // namespace pfc
+#endif
@@ -0,0 +1,21 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+
+//============================================================================
+// mp_heap
+//============================================================================
+PFC_INLINE usize_t mp_heap_size_class_bytes(unsigned size_class_)
+{
+  // 16 byte steps up to 256 bytes and 4 steps per power-of-2 above
+  PFC_ASSERT_PEDANTIC(size_class_<mp_heap_num_size_classes);
+  if(size_class_<16)
+    return (size_class_+1)*16;
+  unsigned pow2=(size_class_-16)>>2;
+  return (usize_t(256)<<pow2)+(usize_t(((size_class_-16)&3)+1)<<(pow2+6));
+}
+//----------------------------------------------------------------------------
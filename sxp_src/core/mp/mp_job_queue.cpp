@@ -9,6 +9,7 @@
 #include "mp_job_queue.h"
 #include "sxp_src/core/math/bit_math.h"
 #include "sxp_src/core/sort.h"
+#include "sxp_src/core/str.h"
 using namespace pfc;
 //----------------------------------------------------------------------------
 
@@ -17,6 +18,7 @@ using namespace pfc;
 // mp_job_queue
 //============================================================================
 static unsigned s_num_job_queue_worker_threads=0;
+static PFC_THREAD_VAR void *s_active_job_fiber=0;
 mp_job_queue *mp_job_queue::s_active=0;
 //----------------------------------------------------------------------------
 
@@ -27,12 +29,19 @@ mp_job_queue::mp_job_queue(int max_num_worker_threads_)
   PFC_CHECK_MSG(!s_active, ("mp_job_queue has already been created\r\n"));
   s_active=this;
   s_num_job_queue_worker_threads=0;
+  m_job_pool.enable_thread_cache();  // jobs are allocated & freed by all threads
 
   // init the queue
   m_process_jobs=true;
   m_num_pending_job_types=0;
   m_num_pending_jobs=0;
   m_num_job_types=0;
+  m_use_job_fibers=false;
+  m_job_fiber_stack_size=0;
+  m_job_fibers=0;
+  m_wait_job_fibers=0;
+  m_ready_job_fibers=0;
+  m_num_wait_job_fibers=0;
   for(unsigned i=0; i<max_job_types; ++i)
   {
     job_type &jt=m_job_types[i];
@@ -86,6 +95,15 @@ mp_job_queue::~mp_job_queue()
       PFC_ASSERT(!jt->jobs.head());
     }
 
+  // release job fibers
+  PFC_ASSERT(!m_wait_job_fibers && !m_ready_job_fibers);
+  m_idle_job_fibers.force_clear();
+  while(job_fiber *f=m_job_fibers)
+  {
+    m_job_fibers=f->next_alloc;
+    PFC_DELETE(f);
+  }
+
   // reset active job queue
   s_active=0;
 }
@@ -96,6 +114,21 @@ void mp_job_queue::set_worker_priority(e_thread_priority p_)
   for(unsigned i=0; i<m_workers.size(); ++i)
     m_workers[i].thread.set_priority(p_);
 }
+//----
+
+void mp_job_queue::enable_job_fibers(usize_t stack_size_)
+{
+  // run jobs in pooled fibers, so that jobs waiting for other jobs suspend their fibers instead of blocking threads
+  PFC_ASSERT_MSG(!m_num_pending_jobs, ("Job fibers must be enabled while there are no pending jobs\r\n"));
+  m_use_job_fibers=true;
+  m_job_fiber_stack_size=stack_size_;
+}
+//----
+
+bool mp_job_queue::is_job_fiber_active() const
+{
+  return s_active_job_fiber!=0;
+}
 //----------------------------------------------------------------------------
 
 e_jobtype_id mp_job_queue::create_job_type(const char *type_name_, void(*func_)(void*, void*), e_job_scheduling scheduling_)
@@ -120,14 +153,37 @@ e_jobtype_id mp_job_queue::create_job_type(const char *type_name_, void(*func_)(
 
 e_jobtype_id mp_job_queue::find_job_type(void(*func_)(void*, void*))
 {
-  for(unsigned i=1; i<m_num_job_types; ++i)
+  for(unsigned i=1; i<=m_num_job_types; ++i)
     if(m_job_types[i].job_func==func_)
       return e_jobtype_id(i);
   return e_jobtype_id(0);
 }
+//----
+
+e_jobtype_id mp_job_queue::find_or_create_job_type(const char *type_name_, void(*func_)(void*, void*), e_job_scheduling scheduling_)
+{
+  return find_or_create_job_type(type_name_, func_, scheduling_, pfc::type_id<void>::id, pfc::type_id<void>::id);
+}
+//----
+
+e_jobtype_id mp_job_queue::find_or_create_job_type(const char *type_name_, void(*func_)(void*, void*), e_job_scheduling scheduling_, uint32_t type_data_id_, uint32_t job_data_id_)
+{
+  // find the job type for the function or create it (serialized so that concurrent first uses create the type only once)
+  m_job_type_lock.enter();
+  e_jobtype_id type_id=find_job_type(func_);
+  if(!type_id)
+  {
+    type_id=create_job_type(type_name_, func_, scheduling_);
+    job_type &jt=m_job_types[type_id];
+    jt.type_data_id=type_data_id_;
+    jt.job_data_id=job_data_id_;
+  }
+  m_job_type_lock.leave();
+  return type_id;
+}
 //----------------------------------------------------------------------------
 
-void mp_job_queue::add_job(e_jobtype_id type_, void *data_)
+void mp_job_queue::add_job(e_jobtype_id type_, void *data_, volatile uint32_t *job_counter_)
 {
   // setup new job and add it to the job type
   PFC_ASSERT_PEDANTIC_MSG(type_, ("Job type ID not defined\r\n"));
@@ -135,23 +191,47 @@ void mp_job_queue::add_job(e_jobtype_id type_, void *data_)
   atom_inc(m_num_pending_jobs);
   job_type &jt=m_job_types[type_];
   atom_inc(jt.num_pending_jobs);
+  if(job_counter_)
+    atom_inc(*job_counter_);
   job *j=(job*)m_job_pool.alloc_block();
   j->data=data_;
+  j->counter=job_counter_;
   jt.jobs.push(*j);
 
   // ensure that job type is in a priority queue
-  if(   m_priority_queues[jt.priority].secure_push(jt)
-     && atom_inc(m_num_pending_job_types)==1)
-    m_run_workers_state.open();
+  if(m_priority_queues[jt.priority].secure_push(jt))
+    inc_pending_job_types();
 }
 //----
 
 void mp_job_queue::wait_job_type(e_jobtype_id type_)
 {
-  // execute top-priority jobs until given job is executed
-  job_type &type=m_job_types[type_];
-  while(type.num_pending_jobs)
-    exec_top_priority_job_type(false, false);
+  wait_jobs(m_job_types[type_].num_pending_jobs);
+}
+//----
+
+void mp_job_queue::wait_jobs(volatile uint32_t &job_counter_)
+{
+  // suspend the job fiber or execute top-priority jobs until the counted jobs are executed
+  job_fiber *f=(job_fiber*)s_active_job_fiber;
+  while(job_counter_)
+  {
+    if(f)
+    {
+      f->wait_counter=&job_counter_;
+      mp_fiber::suspend();
+    }
+    else
+      exec_top_priority_job_type(false, false);
+  }
+}
+//----
+
+void mp_job_queue::dec_job_counter(volatile uint32_t &job_counter_)
+{
+  // complete counted work done outside of jobs and resume fibers waiting for the counter
+  if(atom_dec(job_counter_)==0 && m_num_wait_job_fibers)
+    wake_ready_job_fibers();
 }
 //----
 
@@ -165,25 +245,30 @@ void mp_job_queue::wait_job_types(const e_jobtype_id *types_, unsigned num_job_t
 void mp_job_queue::wait_all_jobs()
 {
   // run jobs until all jobs have been completed
-  while(m_num_pending_jobs)
-    exec_top_priority_job_type(false, false);
+  PFC_ASSERT_MSG(!s_active_job_fiber, ("wait_all_jobs() can't be called from a job, since the job would wait for itself\r\n"));
+  wait_jobs(m_num_pending_jobs);
 }
 //----
 
 void mp_job_queue::exec_job(e_jobtype_id jtid_)
 {
+  // execute a job on the thread (job fibers yield the thread to execute the job)
   job_type &type=m_job_types[jtid_];
   if(type.num_pending_jobs)
-    exec_top_priority_job_type(false, true);
+  {
+    if(job_fiber *f=(job_fiber*)s_active_job_fiber)
+      yield_job_fiber(*f);
+    else
+      exec_top_priority_job_type(false, true);
+  }
 }
 //----
 
 bool mp_job_queue::has_jobs(e_jobtype_id jtid_, bool exec_jobs_)
 {
-  job_type &type=m_job_types[jtid_];
-  if(exec_jobs_ && type.num_pending_jobs)
-    exec_top_priority_job_type(false, true);
-  return type.num_pending_jobs!=0;
+  if(exec_jobs_)
+    exec_job(jtid_);
+  return m_job_types[jtid_].num_pending_jobs!=0;
 }
 //----
 
@@ -236,6 +321,11 @@ void mp_job_queue::reprioritize()
 
 void mp_job_queue::exec_top_priority_job_type(bool wait_jobs_, bool exec_single_job_)
 {
+  // resume job fibers whose waits have completed before starting new jobs
+  if(   m_ready_job_fibers
+     && resume_ready_job_fiber())
+    return;
+
   // process jobs for a job type with top priority
   for(unsigned i=0; i<num_priorities; ++i)
   {
@@ -245,14 +335,16 @@ void mp_job_queue::exec_top_priority_job_type(bool wait_jobs_, bool exec_single_
       // execute all jobs for the job type
       while(job *j=jt->jobs.pop())
       {
-        // execute and profile the job
-        uint64_t job_cycles=get_thread_cycles();
-        (*jt->job_func)(j->data, jt->type_data);
-        job_cycles=get_thread_cycles()-job_cycles;
-        m_job_pool.free(j);
-        atom_cmov_max(jt->max_kcycles, uint32_t(job_cycles>>10));
-        atom_dec(jt->num_pending_jobs);
-        atom_dec(m_num_pending_jobs);
+        // execute the job directly or in a fiber
+        if(m_use_job_fibers)
+        {
+          job_fiber &f=alloc_job_fiber();
+          f.type=jt;
+          f.exec_job=j;
+          run_job_fiber(f);
+        }
+        else
+          run_job(*jt, *j);
         if(exec_single_job_)
         {
           if(jt->jobs.head())
@@ -264,31 +356,181 @@ void mp_job_queue::exec_top_priority_job_type(bool wait_jobs_, bool exec_single_
       // remove the type from the priority queue
       if(pq.pop_if(jt))
       {
-        // inactivate workers if number of pending job types drops to zero
-        while(   atom_dec(m_num_pending_job_types)==0
-              && atom_cmov_eq(m_num_pending_job_types, 1u, 0u)==0)
-        {
-          m_run_workers_state.close();
-          if(atom_cmov_eq(m_num_pending_job_types, 0u, 1u)==1)
-            break;
-          m_run_workers_state.open();
-        }
-
         // add job type back to queue if new jobs were added while removing
+        dec_pending_job_types();
         jt->next_pq=0;
         if(   jt->jobs.head()
-           && pq.secure_push(*jt)
-           && atom_inc(m_num_pending_job_types)==1)
-          m_run_workers_state.open();
+           && pq.secure_push(*jt))
+          inc_pending_job_types();
       }
       return;
     }
   }
 
-  // wait for jobs to execute
+  // wait for jobs to execute (ready fibers are counted as pending job types, so they open the gate)
   if(wait_jobs_)
     wait_gate(m_run_workers_state);
 }
+//----
+
+void mp_job_queue::run_job(job_type &jt_, job &j_)
+{
+  // execute and profile the job
+  uint64_t job_start_cycles=get_thread_cycles();
+  (*jt_.job_func)(j_.data, jt_.type_data);
+  uint64_t job_end_cycles=get_thread_cycles(), job_cycles=job_end_cycles-job_start_cycles;
+  PFC_PERF_TRACE_EVENT(jt_.name, "job", job_start_cycles, job_end_cycles);
+  volatile uint32_t *counter=j_.counter;
+  m_job_pool.free(&j_);
+  atom_cmov_max(jt_.max_kcycles, uint32_t(job_cycles>>10));
+  bool is_wait_done=atom_dec(jt_.num_pending_jobs)==0;
+  if(counter && atom_dec(*counter)==0)
+    is_wait_done=true;
+  if(is_wait_done && m_num_wait_job_fibers)
+    wake_ready_job_fibers();
+  atom_dec(m_num_pending_jobs);
+}
+//----
+
+mp_job_queue::job_fiber &mp_job_queue::alloc_job_fiber()
+{
+  // reuse an idle fiber (and its stack) or create a new one
+  if(job_fiber *f=m_idle_job_fibers.pop())
+    return *f;
+  job_fiber *f=PFC_NEW(job_fiber);
+  f->job_queue=this;
+  f->type=0;
+  f->exec_job=0;
+  f->wait_counter=0;
+  f->is_yielding=false;
+  f->next=0;
+  f->fiber.init(PFC_MAKE_MEM_FUNCTOR(functor<void()>, *f, job_fiber, func), m_job_fiber_stack_size);
+  job_fiber *head;
+  do
+  {
+    head=m_job_fibers;
+    f->next_alloc=head;
+  } while(atom_cmov_eq(m_job_fibers, f, head)!=head);
+  return *f;
+}
+//----
+
+void mp_job_queue::run_job_fiber(job_fiber &f_)
+{
+  // run the fiber until it completes the job or starts to wait for other jobs
+  // note: jobs requested by yielding fibers are executed here on the thread stack instead of the fiber stack
+  void *prev_fiber=s_active_job_fiber;
+  s_active_job_fiber=&f_;
+  f_.fiber.resume();
+  while(f_.is_yielding)
+  {
+    s_active_job_fiber=prev_fiber;
+    f_.is_yielding=false;
+    exec_top_priority_job_type(false, true);
+    s_active_job_fiber=&f_;
+    f_.fiber.resume();
+  }
+  s_active_job_fiber=prev_fiber;
+  if(!f_.wait_counter)
+  {
+    m_idle_job_fibers.push(f_);
+    return;
+  }
+
+  // add the suspended fiber to the wait list, or to the ready list if the jobs completed while suspending
+  m_wait_job_fiber_lock.enter();
+  if(*f_.wait_counter)
+  {
+    f_.next=m_wait_job_fibers;
+    m_wait_job_fibers=&f_;
+    atom_inc(m_num_wait_job_fibers);
+  }
+  else
+  {
+    f_.next=m_ready_job_fibers;
+    m_ready_job_fibers=&f_;
+    inc_pending_job_types();
+  }
+  m_wait_job_fiber_lock.leave();
+}
+//----
+
+void mp_job_queue::yield_job_fiber(job_fiber &f_)
+{
+  // suspend the fiber to have a job executed by the thread running the fiber
+  f_.is_yielding=true;
+  mp_fiber::suspend();
+}
+//----
+
+void mp_job_queue::wake_ready_job_fibers()
+{
+  // move fibers whose jobs have completed from the wait list to the ready list, which wakes workers to resume them
+  m_wait_job_fiber_lock.enter();
+  job_fiber **f=&m_wait_job_fibers;
+  while(job_fiber *wf=*f)
+  {
+    if(*wf->wait_counter)
+    {
+      f=&wf->next;
+      continue;
+    }
+    *f=wf->next;
+    atom_dec(m_num_wait_job_fibers);
+    wf->next=m_ready_job_fibers;
+    m_ready_job_fibers=wf;
+    inc_pending_job_types();
+  }
+  m_wait_job_fiber_lock.leave();
+}
+//----
+
+bool mp_job_queue::resume_ready_job_fiber()
+{
+  // pop a fiber whose jobs have completed
+  m_wait_job_fiber_lock.enter();
+  job_fiber *ready_fiber=m_ready_job_fibers;
+  if(ready_fiber)
+    m_ready_job_fibers=ready_fiber->next;
+  m_wait_job_fiber_lock.leave();
+  if(!ready_fiber)
+    return false;
+
+  // resume the fiber
+  ready_fiber->wait_counter=0;
+  dec_pending_job_types();
+  run_job_fiber(*ready_fiber);
+  return true;
+}
+//----
+
+void mp_job_queue::dec_pending_job_types()
+{
+  // inactivate workers if number of pending job types drops to zero
+  while(   atom_dec(m_num_pending_job_types)==0
+        && atom_cmov_eq(m_num_pending_job_types, 1u, 0u)==0)
+  {
+    m_run_workers_state.close();
+    if(atom_cmov_eq(m_num_pending_job_types, 0u, 1u)==1)
+      break;
+    m_run_workers_state.open();
+  }
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// mp_job_queue::job_fiber
+//============================================================================
+void mp_job_queue::job_fiber::func()
+{
+  // run jobs assigned to the fiber, suspending after each job
+  while(true)
+  {
+    job_queue->run_job(*type, *exec_job);
+    mp_fiber::suspend();
+  }
+}
 //----------------------------------------------------------------------------
 
 
@@ -302,6 +544,11 @@ int mp_job_queue::worker::func()
 {
   // run jobs until job queue exits
   g_job_queue_thread_id=atom_inc(s_num_job_queue_worker_threads);
+#ifdef PFC_BUILDOP_PROFILING
+  stack_str32 thread_name;
+  thread_name.format("job worker %u", g_job_queue_thread_id);
+  perf_trace::set_thread_name(thread_name.c_str());
+#endif
   do
   {
     job_queue->exec_top_priority_job_type(true, false);
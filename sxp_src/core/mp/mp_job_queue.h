@@ -23,9 +23,12 @@ enum e_job_scheduling {jobscheduling_normal, jobscheduling_realtime};
 class mp_job_queue;
 template<typename T, typename U> PFC_INLINE e_jobtype_id create_job_type(const char *type_name_, void(*)(T*, U*), e_job_scheduling=jobscheduling_normal);
 PFC_INLINE e_jobtype_id create_job_type(const char *type_name_, void(*)(void*, void*), e_job_scheduling=jobscheduling_normal);
+template<typename T, typename U> PFC_INLINE e_jobtype_id find_or_create_job_type(const char *type_name_, void(*)(T*, U*), e_job_scheduling=jobscheduling_normal);
 template<typename T> PFC_INLINE void set_job_type_data(e_jobtype_id, T*);
 template<typename T> PFC_INLINE void add_job(e_jobtype_id, T*);
+template<typename T> PFC_INLINE void add_job(e_jobtype_id, T*, volatile uint32_t &job_counter_);
 PFC_INLINE void wait_job_type(e_jobtype_id);
+PFC_INLINE void wait_jobs(volatile uint32_t &job_counter_);
 PFC_INLINE void wait_job_types(const e_jobtype_id*, unsigned num_jobs_types_);
 PFC_INLINE void wait_all_jobs();
 PFC_INLINE void exec_job(e_jobtype_id);
@@ -51,6 +54,8 @@ public:
   // accessors and mutators
   PFC_INLINE unsigned num_worker_threads() const;
   void set_worker_priority(e_thread_priority);
+  void enable_job_fibers(usize_t stack_size_=0);
+  bool is_job_fiber_active() const;
   //--------------------------------------------------------------------------
 
   // job type management
@@ -58,13 +63,18 @@ public:
   e_jobtype_id create_job_type(const char *type_name_, void(*)(void*, void*), e_job_scheduling=jobscheduling_normal);
   template<typename T, typename U> PFC_INLINE e_jobtype_id find_job_type(void(*)(T*, U*));
   e_jobtype_id find_job_type(void(*)(void*, void*));
+  template<typename T, typename U> PFC_INLINE e_jobtype_id find_or_create_job_type(const char *type_name_, void(*)(T*, U*), e_job_scheduling=jobscheduling_normal);
+  e_jobtype_id find_or_create_job_type(const char *type_name_, void(*)(void*, void*), e_job_scheduling=jobscheduling_normal);
   template<typename T> PFC_INLINE void set_job_type_data(e_jobtype_id, T*);
   //--------------------------------------------------------------------------
 
   // job management
   template<typename T> PFC_INLINE void add_job(e_jobtype_id, T*);
-  void add_job(e_jobtype_id, void*);
+  template<typename T> PFC_INLINE void add_job(e_jobtype_id, T*, volatile uint32_t &job_counter_);
+  void add_job(e_jobtype_id, void*, volatile uint32_t *job_counter_=0);
   void wait_job_type(e_jobtype_id);
+  void wait_jobs(volatile uint32_t &job_counter_);
+  void dec_job_counter(volatile uint32_t &job_counter_);
   void wait_job_types(const e_jobtype_id*, unsigned num_job_types_);
   void wait_all_jobs();
   void exec_job(e_jobtype_id);
@@ -74,10 +84,21 @@ public:
   //--------------------------------------------------------------------------
 
 private:
+  struct job;
   struct job_type;
+  struct job_fiber;
   mp_job_queue(const mp_job_queue&); // not implemented
   void operator=(const mp_job_queue&); // not implemented
+  e_jobtype_id find_or_create_job_type(const char *type_name_, void(*)(void*, void*), e_job_scheduling, uint32_t type_data_id_, uint32_t job_data_id_);
   void exec_top_priority_job_type(bool wait_jobs_, bool exec_single_job_);
+  void run_job(job_type&, job&);
+  job_fiber &alloc_job_fiber();
+  void run_job_fiber(job_fiber&);
+  void yield_job_fiber(job_fiber&);
+  void wake_ready_job_fibers();
+  bool resume_ready_job_fiber();
+  PFC_INLINE void inc_pending_job_types();
+  void dec_pending_job_types();
   //--------------------------------------------------------------------------
 
   //==========================================================================
@@ -86,6 +107,7 @@ private:
   struct job
   {
     void *data;
+    volatile uint32_t *counter;
     job *next;
   };
   //--------------------------------------------------------------------------
@@ -109,6 +131,26 @@ private:
   };
   //--------------------------------------------------------------------------
 
+  //==========================================================================
+  // mp_job_queue::job_fiber
+  //==========================================================================
+  struct job_fiber
+  {
+    void func();
+    //------------------------------------------------------------------------
+
+    mp_fiber fiber;
+    mp_job_queue *job_queue;
+    job_type *type;                 // type of the job run by the fiber
+    job *exec_job;                  // job run by the fiber
+    volatile uint32_t *wait_counter; // pending job counter the fiber waits to reach zero (0=not waiting)
+    bool is_yielding;               // fiber yielded to have a job executed on the thread stack
+    job_fiber *next;                // next fiber in the wait or ready list
+    job_fiber *next_idle;           // next fiber in the idle fiber queue
+    job_fiber *next_alloc;          // next allocated fiber
+  };
+  //--------------------------------------------------------------------------
+
   //==========================================================================
   // mp_job_queue::worker
   //==========================================================================
@@ -130,11 +172,20 @@ private:
   volatile unsigned m_num_pending_job_types;
   volatile unsigned m_num_pending_jobs;
   unsigned m_num_job_types;
+  mp_critical_section m_job_type_lock;
   job_type m_job_types[max_job_types];
   mp_fifo_queue<job_type, &job_type::next_pq> m_priority_queues[num_priorities];
   mp_free_list m_job_pool;
   mp_gate m_run_workers_state;
   array<worker> m_workers;
+  bool m_use_job_fibers;
+  usize_t m_job_fiber_stack_size;
+  job_fiber *volatile m_job_fibers;
+  mp_lifo_queue<job_fiber, &job_fiber::next_idle> m_idle_job_fibers;
+  mp_critical_section m_wait_job_fiber_lock;
+  job_fiber *m_wait_job_fibers;
+  job_fiber *volatile m_ready_job_fibers;
+  volatile unsigned m_num_wait_job_fibers;
 };
 //----------------------------------------------------------------------------
 
@@ -22,6 +22,13 @@ e_jobtype_id create_job_type(const char *type_name_, void(*func_)(void*, void*),
 }
 //----
 
+template<typename T, typename U>
+PFC_INLINE e_jobtype_id find_or_create_job_type(const char *type_name_, void(*func_)(T*, U*), e_job_scheduling scheduling_)
+{
+  return mp_job_queue::active().find_or_create_job_type(type_name_, func_, scheduling_);
+}
+//----
+
 template<typename T>
 void set_job_type_data(e_jobtype_id type_, T *data_)
 {
@@ -36,12 +43,25 @@ PFC_INLINE void add_job(e_jobtype_id type_, T *data_)
 }
 //----
 
+template<typename T>
+PFC_INLINE void add_job(e_jobtype_id type_, T *data_, volatile uint32_t &job_counter_)
+{
+  mp_job_queue::active().add_job(type_, data_, job_counter_);
+}
+//----
+
 PFC_INLINE void wait_job_type(e_jobtype_id type_)
 {
   mp_job_queue::active().wait_job_type(type_);
 }
 //----
 
+PFC_INLINE void wait_jobs(volatile uint32_t &job_counter_)
+{
+  mp_job_queue::active().wait_jobs(job_counter_);
+}
+//----
+
 PFC_INLINE void wait_job_types(const e_jobtype_id *types_, unsigned num_job_types_)
 {
   mp_job_queue::active().wait_job_types(types_, num_job_types_);
@@ -112,6 +132,13 @@ e_jobtype_id mp_job_queue::find_job_type(void(*func_)(T*, U*))
 }
 //----
 
+template<typename T, typename U>
+e_jobtype_id mp_job_queue::find_or_create_job_type(const char *type_name_, void(*func_)(T*, U*), e_job_scheduling scheduling_)
+{
+  return find_or_create_job_type(type_name_, (void(*)(void*, void*))func_, scheduling_, type_id<U>::id, type_id<T>::id);
+}
+//----
+
 template<typename T>
 void mp_job_queue::set_job_type_data(e_jobtype_id type_, T *data_)
 {
@@ -126,4 +153,20 @@ void mp_job_queue::add_job(e_jobtype_id type_, T *data_)
   PFC_ASSERT_MSG(type_id<T>::id==m_job_types[type_].job_data_id, ("Added wrong type of job data \"%s\" for the given job type \"%s\"\r\n", typeid(T).name(), m_job_types[type_].name));
   add_job(type_, (void*)data_);
 }
+//----
+
+template<typename T>
+void mp_job_queue::add_job(e_jobtype_id type_, T *data_, volatile uint32_t &job_counter_)
+{
+  PFC_ASSERT_MSG(type_id<T>::id==m_job_types[type_].job_data_id, ("Added wrong type of job data \"%s\" for the given job type \"%s\"\r\n", typeid(T).name(), m_job_types[type_].name));
+  add_job(type_, (void*)data_, &job_counter_);
+}
+//----------------------------------------------------------------------------
+
+void mp_job_queue::inc_pending_job_types()
+{
+  // activate workers if there were no pending job types
+  if(atom_inc(m_num_pending_job_types)==1)
+    m_run_workers_state.open();
+}
 //----------------------------------------------------------------------------
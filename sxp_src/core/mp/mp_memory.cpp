@@ -26,11 +26,31 @@ enum
 //============================================================================
 // mp_free_list
 //============================================================================
+PFC_THREAD_VAR unsigned mp_free_list::s_thread_cache_idx=0;
+//----
+
+namespace
+{
+  volatile uint64_t s_thread_cache_slot_mask=0;
+  //--------------------------------------------------------------------------
+
+  void release_thread_cache_idx(void *idx_)
+  {
+    // release the thread cache slot of the exiting thread for reuse by new threads
+    // note: blocks in the slot caches are inherited by the next thread using the slot
+    unsigned idx=unsigned(usize_t(idx_));
+    atom_and(s_thread_cache_slot_mask, ~(uint64_t(1)<<(idx-1)));
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
 mp_free_list::mp_free_list(void *buffer_, usize_t buffer_size_, usize_t item_size_, usize_t item_byte_align_)
   :m_block_size(item_byte_align_*((item_size_+item_byte_align_-1)/item_byte_align_))
   ,m_block_align(item_byte_align_)
   ,m_num_items_per_stride(0)
   ,m_num_allocs(0)
+  ,m_thread_caches(0)
+  ,m_magazine_size(0)
 {
   // calculate capacity
   PFC_ASSERT(item_size_);
@@ -57,6 +77,8 @@ mp_free_list::mp_free_list(usize_t item_size_, usize_t capacity_, usize_t item_b
   ,m_num_items_per_stride(max<usize_t>(min_stride_items, m_block_size?stride_size/m_block_size:0))
   ,m_capacity(0)
   ,m_num_allocs(0)
+  ,m_thread_caches(0)
+  ,m_magazine_size(0)
 {
   PFC_ASSERT(item_size_);
   PFC_ASSERT_MSG(item_byte_align_>=ptr_size && is_pow2(item_byte_align_), ("free_list item byte alignment (%i) must be at least %i and power-of-2\r\n", item_byte_align_, ptr_size));
@@ -78,6 +100,32 @@ void mp_free_list::check_allocator(usize_t num_bytes_, usize_t mem_align_)
 }
 //----
 
+void mp_free_list::enable_thread_cache(usize_t magazine_size_)
+{
+  // setup per-thread caches (one cache line per thread)
+  PFC_ASSERT_MSG(!m_thread_caches, ("Thread cache already enabled for the free list\r\n"));
+  PFC_ASSERT_MSG(!m_num_allocs, ("Thread cache must be enabled before allocating from the free list\r\n"));
+  PFC_ASSERT_MSG(m_block_size>=sizeof(magazine), ("Thread cached free list requires at least %i byte blocks\r\n", sizeof(magazine)));
+  PFC_ASSERT(magazine_size_>1);
+  PFC_STATIC_ASSERT(sizeof(thread_cache)==64 && max_thread_caches==64);
+  m_thread_cache_buffer=PFC_MEM_ALLOC(sizeof(thread_cache)*(max_thread_caches+1));
+  m_thread_caches=(thread_cache*)((usize_t(m_thread_cache_buffer.data)+sizeof(thread_cache)-1)&-usize_t(sizeof(thread_cache)));
+  mem_zero(m_thread_caches, sizeof(thread_cache)*max_thread_caches);
+  m_magazine_size=magazine_size_;
+
+  // move existing free items to the depot
+  item *items=0;
+  usize_t num_items=0;
+  while(item *i=m_queue.pop())
+  {
+    i->next=items;
+    items=i;
+    ++num_items;
+  }
+  add_free_items(items, num_items);
+}
+//----
+
 void mp_free_list::reserve(usize_t capacity_)
 {
   // check for free-list expansion
@@ -101,12 +149,15 @@ void mp_free_list::reserve(usize_t capacity_)
     usize_t align_offset=(m_block_align-usize_t(stride))&(m_block_align-1);
     (uint8_t*&)stride+=align_offset;
     usize_t num_items=m_num_items_per_stride-(align_offset?1:0);
-    for(usize_t i=0; i<num_items; ++i)
+    item *items=stride;
+    for(usize_t i=1; i<num_items; ++i)
     {
       item *next_it=(item*)(((uint8_t*&)stride)+m_block_size);
-      m_queue.push(*stride);
+      stride->next=next_it;
       stride=next_it;
     }
+    stride->next=0;
+    add_free_items(items, num_items);
   }
   m_capacity+=num_new_strides*m_num_items_per_stride;
   m_reserve_csect.leave();
@@ -116,10 +167,13 @@ void mp_free_list::reserve(usize_t capacity_)
 void mp_free_list::release()
 {
   // release free list queue items
-  PFC_ASSERT(!m_num_allocs);
+  PFC_ASSERT(!num_pending_allocs());
   m_capacity=0;
   m_strides.clear();
   m_queue.force_clear();
+  m_depot.force_clear();
+  if(m_thread_caches)
+    mem_zero(m_thread_caches, sizeof(thread_cache)*max_thread_caches);
 }
 //----------------------------------------------------------------------------
 
@@ -139,6 +193,83 @@ void mp_free_list::free(void *p_)
 }
 //----------------------------------------------------------------------------
 
+unsigned mp_free_list::alloc_thread_cache_idx()
+{
+  // assign free thread cache slot for the calling thread (max_thread_caches+1 if none available)
+  static const usize_t s_exit_key=create_thread_exit_key(&release_thread_cache_idx);
+  uint64_t mask;
+  unsigned idx;
+  do
+  {
+    mask=atom_read(s_thread_cache_slot_mask);
+    if(mask==uint64_t(-1))
+      return s_thread_cache_idx=max_thread_caches+1;
+    idx=lsb_pos(~mask);
+  } while(atom_cmov_eq(s_thread_cache_slot_mask, mask|(uint64_t(1)<<idx), mask)!=mask);
+  s_thread_cache_idx=idx+1;
+  set_thread_exit_value(s_exit_key, (void*)usize_t(idx+1));
+  return idx+1;
+}
+//----
+
+void *mp_free_list::alloc_cached_block(thread_cache &tc_)
+{
+  while(true)
+  {
+    // load a full magazine from the depot to the thread cache and return its first block
+    if(magazine *m=m_depot.pop())
+    {
+      tc_.items=m->items;
+      tc_.num_items=m_magazine_size-1;
+      return m;
+    }
+
+    // allocate item from the shared free list
+    if(item *i=m_queue.pop())
+      return i;
+    reserve(m_capacity+1);
+  }
+}
+//----
+
+void mp_free_list::flush_thread_cache(thread_cache &tc_)
+{
+  // move magazine_size items from the thread cache to the depot
+  tc_.items=push_magazine(tc_.items);
+  tc_.num_items-=m_magazine_size;
+}
+//----
+
+mp_free_list::item *mp_free_list::push_magazine(item *items_)
+{
+  // push the first magazine_size items of the list to the depot as a full magazine and return the rest
+  item *last=items_;
+  for(usize_t i=1; i<m_magazine_size; ++i)
+    last=last->next;
+  item *rest=last->next;
+  last->next=0;
+  magazine *m=reinterpret_cast<magazine*>(items_);
+  m->items=items_->next;
+  m_depot.push(*m);
+  return rest;
+}
+//----
+
+void mp_free_list::add_free_items(item *items_, usize_t num_items_)
+{
+  // add list of items to the depot as full magazines and the rest to the shared free list
+  if(m_thread_caches)
+    for(; num_items_>=m_magazine_size; num_items_-=m_magazine_size)
+      items_=push_magazine(items_);
+  while(items_)
+  {
+    item *next=items_->next;
+    m_queue.push(*items_);
+    items_=next;
+  }
+}
+//----------------------------------------------------------------------------
+
 
 //============================================================================
 // mp_sequential_memory_allocator
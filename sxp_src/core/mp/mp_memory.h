@@ -28,6 +28,10 @@ class mp_sequential_memory_allocator;
 //============================================================================
 // mp_free_list
 //============================================================================
+// Lock-free free list of fixed size memory blocks. Optionally blocks can be
+// cached in per-thread magazines (enable_thread_cache()), which are exchanged
+// with a shared depot in batches of full magazines, so that only every Nth
+// alloc/free touches shared state.
 class mp_free_list: public memory_allocator_base
 {
 public:
@@ -36,6 +40,7 @@ public:
   mp_free_list(usize_t item_size_, usize_t capacity_=0, usize_t item_byte_align_=ptr_size);
   ~mp_free_list();
   virtual void check_allocator(usize_t num_bytes_, usize_t mem_align_);
+  void enable_thread_cache(usize_t magazine_size_=32);
   void reserve(usize_t capacity_);
   void release();
   //--------------------------------------------------------------------------
@@ -60,6 +65,38 @@ private:
   PFC_STATIC_ASSERT(sizeof(item)==ptr_size);
   //--------------------------------------------------------------------------
 
+  //==========================================================================
+  // mp_free_list::magazine
+  //==========================================================================
+  // full magazine in the depot (overlaid to the first block of the magazine)
+  struct magazine
+  {
+    magazine *next;
+    item *items;  // remaining magazine_size-1 blocks
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // mp_free_list::thread_cache
+  //==========================================================================
+  struct thread_cache
+  {
+    item *items;
+    usize_t num_items;
+    ssize_t num_allocs;
+    char pad[64-3*sizeof(usize_t)];
+  };
+  enum {max_thread_caches=64};
+  //--------------------------------------------------------------------------
+
+  PFC_INLINE thread_cache *thread_cache_slot() const;
+  static unsigned alloc_thread_cache_idx();
+  void *alloc_cached_block(thread_cache&);
+  void flush_thread_cache(thread_cache&);
+  item *push_magazine(item*);
+  void add_free_items(item*, usize_t num_items_);
+  //--------------------------------------------------------------------------
+
   const usize_t m_block_size;
   const usize_t m_block_align;
   const usize_t m_num_items_per_stride;
@@ -68,6 +105,11 @@ private:
   mp_lifo_queue<item> m_queue;
   mp_critical_section m_reserve_csect;
   array<owner_data> m_strides;
+  thread_cache *m_thread_caches;
+  usize_t m_magazine_size;
+  mp_lifo_queue<magazine> m_depot;
+  owner_data m_thread_cache_buffer;
+  static PFC_THREAD_VAR unsigned s_thread_cache_idx;
 };
 //----------------------------------------------------------------------------
 
@@ -17,12 +17,30 @@ usize_t mp_free_list::capacity() const
 
 usize_t mp_free_list::num_pending_allocs() const
 {
-  return m_num_allocs;
+  // sum allocs of the shared free list and thread caches
+  usize_t num_allocs=m_num_allocs;
+  if(m_thread_caches)
+    for(unsigned i=0; i<max_thread_caches; ++i)
+      num_allocs+=usize_t(m_thread_caches[i].num_allocs);
+  return num_allocs;
 }
 //----
 
 void *mp_free_list::alloc_block()
 {
+  // allocate item from the thread cache
+  if(thread_cache *tc=thread_cache_slot())
+  {
+    ++tc->num_allocs;
+    if(item *i=tc->items)
+    {
+      tc->items=i->next;
+      --tc->num_items;
+      return i;
+    }
+    return alloc_cached_block(*tc);
+  }
+
   while(true)
   {
     // allocate item from free list
@@ -40,7 +58,30 @@ void mp_free_list::free_block(void *p_)
 {
   // release item back to the free list
   PFC_ASSERT_PEDANTIC(p_!=0);
-  m_queue.push(*reinterpret_cast<item*>(p_));
+  item *i=reinterpret_cast<item*>(p_);
+  if(thread_cache *tc=thread_cache_slot())
+  {
+    // release item to the thread cache and move a magazine to the depot if the cache is full
+    --tc->num_allocs;
+    i->next=tc->items;
+    tc->items=i;
+    if(++tc->num_items==2*m_magazine_size)
+      flush_thread_cache(*tc);
+    return;
+  }
+  m_queue.push(*i);
   atom_dec(m_num_allocs);
 }
 //----------------------------------------------------------------------------
+
+mp_free_list::thread_cache *mp_free_list::thread_cache_slot() const
+{
+  // get cache of the calling thread (threads beyond max_thread_caches use the shared free list)
+  if(!m_thread_caches)
+    return 0;
+  unsigned idx=s_thread_cache_idx;
+  if(!idx)
+    idx=alloc_thread_cache_idx();
+  return idx<=max_thread_caches?m_thread_caches+idx-1:0;
+}
+//----------------------------------------------------------------------------
@@ -0,0 +1,191 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_CORE_MP_RING_QUEUE_H
+#define PFC_CORE_MP_RING_QUEUE_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "mp.h"
+namespace pfc
+{
+
+// new
+template<typename T> class mp_ring_queue;
+template<typename T> class mp_spsc_ring_queue;
+template<class Queue> class mp_blocking_queue;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// mp_ring_queue
+//============================================================================
+// Bounded lock-free multi-producer multi-consumer FIFO ring buffer. Each slot
+// has a sequence number telling which lap of the ring the slot is ready to be
+// pushed or popped for, so producers and consumers contend only on their own
+// position counter. Capacity is rounded up to power-of-2 and the queue
+// doesn't allocate memory after init().
+template<typename T>
+class mp_ring_queue
+{
+public:
+  // nested types
+  typedef T type;
+  //--------------------------------------------------------------------------
+
+  // construction
+  mp_ring_queue();
+  explicit mp_ring_queue(usize_t capacity_);
+  ~mp_ring_queue();
+  void init(usize_t capacity_);
+  //--------------------------------------------------------------------------
+
+  // accessors
+  PFC_INLINE usize_t capacity() const;
+  PFC_INLINE usize_t size() const;
+  //--------------------------------------------------------------------------
+
+  // queue operations
+  PFC_INLINE bool try_push(const T&);
+  PFC_INLINE bool try_pop(T&);
+  //--------------------------------------------------------------------------
+
+private:
+  mp_ring_queue(const mp_ring_queue&); // not implemented
+  void operator=(const mp_ring_queue&); // not implemented
+  void release();
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // mp_ring_queue::slot
+  //==========================================================================
+  struct slot
+  {
+    volatile usize_t seq;
+    typename meta_storage<T>::res data;
+  };
+  //--------------------------------------------------------------------------
+
+  slot *m_slots;
+  usize_t m_mask;
+  char m_pad0[64-sizeof(slot*)-sizeof(usize_t)]; // keep push and pop positions in separate cache lines
+  volatile usize_t m_push_pos;
+  char m_pad1[64-sizeof(usize_t)];
+  volatile usize_t m_pop_pos;
+  char m_pad2[64-sizeof(usize_t)];
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// mp_spsc_ring_queue
+//============================================================================
+// Bounded wait-free single-producer single-consumer FIFO ring buffer. Only
+// one thread may push and only one thread may pop at a time. Both sides cache
+// the position of the other side to touch the shared cache line only when the
+// queue looks full or empty. Capacity is rounded up to power-of-2 and the
+// queue doesn't allocate memory after init().
+template<typename T>
+class mp_spsc_ring_queue
+{
+public:
+  // nested types
+  typedef T type;
+  //--------------------------------------------------------------------------
+
+  // construction
+  mp_spsc_ring_queue();
+  explicit mp_spsc_ring_queue(usize_t capacity_);
+  ~mp_spsc_ring_queue();
+  void init(usize_t capacity_);
+  //--------------------------------------------------------------------------
+
+  // accessors
+  PFC_INLINE usize_t capacity() const;
+  PFC_INLINE usize_t size() const;
+  //--------------------------------------------------------------------------
+
+  // queue operations
+  PFC_INLINE bool try_push(const T&);
+  PFC_INLINE bool try_pop(T&);
+  //--------------------------------------------------------------------------
+
+private:
+  mp_spsc_ring_queue(const mp_spsc_ring_queue&); // not implemented
+  void operator=(const mp_spsc_ring_queue&); // not implemented
+  void release();
+  //--------------------------------------------------------------------------
+
+  T *m_data;
+  usize_t m_mask;
+  char m_pad0[64-sizeof(T*)-sizeof(usize_t)]; // keep producer and consumer data in separate cache lines
+  volatile usize_t m_push_pos;
+  usize_t m_cached_pop_pos;
+  char m_pad1[64-2*sizeof(usize_t)];
+  volatile usize_t m_pop_pos;
+  usize_t m_cached_push_pos;
+  char m_pad2[64-2*sizeof(usize_t)];
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// mp_blocking_queue
+//============================================================================
+// Blocking and timed push & pop for mp_ring_queue and mp_spsc_ring_queue. The
+// events are triggered only if threads are waiting for them, so non-blocking
+// operations cost only an extra memory fence over the underlying queue.
+// Timeout of 0 waits infinitely.
+template<class Queue>
+class mp_blocking_queue
+{
+public:
+  // nested types
+  typedef typename Queue::type type;
+  //--------------------------------------------------------------------------
+
+  // construction
+  mp_blocking_queue();
+  explicit mp_blocking_queue(usize_t capacity_);
+  void init(usize_t capacity_);
+  //--------------------------------------------------------------------------
+
+  // accessors
+  PFC_INLINE usize_t capacity() const;
+  PFC_INLINE usize_t size() const;
+  //--------------------------------------------------------------------------
+
+  // queue operations
+  PFC_INLINE bool try_push(const type&);
+  PFC_INLINE bool try_pop(type&);
+  bool push(const type&, float timeout_secs_=0.0f);
+  bool pop(type&, float timeout_secs_=0.0f);
+  //--------------------------------------------------------------------------
+
+private:
+  mp_blocking_queue(const mp_blocking_queue&); // not implemented
+  void operator=(const mp_blocking_queue&); // not implemented
+  PFC_INLINE void notify_pushed();
+  PFC_INLINE void notify_popped();
+  //--------------------------------------------------------------------------
+
+  Queue m_queue;
+  mp_event m_pushed_event;
+  mp_event m_popped_event;
+  volatile int32_t m_num_pop_waiters;
+  volatile int32_t m_num_push_waiters;
+};
+//----------------------------------------------------------------------------
+
+//============================================================================
+#include "mp_ring_queue.inl"
+} // namespace pfc
+#endif
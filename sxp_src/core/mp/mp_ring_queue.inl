@@ -0,0 +1,440 @@
+//============================================================================
+// Mini Spin-X Library
+//
+// Copyright (c) 2024, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+
+//============================================================================
+// mp_ring_queue
+//============================================================================
+template<typename T>
+mp_ring_queue<T>::mp_ring_queue()
+{
+  m_slots=0;
+  m_mask=0;
+  m_push_pos=0;
+  m_pop_pos=0;
+}
+//----
+
+template<typename T>
+mp_ring_queue<T>::mp_ring_queue(usize_t capacity_)
+{
+  m_slots=0;
+  m_mask=0;
+  m_push_pos=0;
+  m_pop_pos=0;
+  init(capacity_);
+}
+//----
+
+template<typename T>
+mp_ring_queue<T>::~mp_ring_queue()
+{
+  release();
+}
+//----
+
+template<typename T>
+void mp_ring_queue<T>::init(usize_t capacity_)
+{
+  // allocate power-of-2 number of slots and set slot sequences for the first lap
+  PFC_ASSERT(capacity_);
+  release();
+  usize_t capacity=1;
+  while(capacity<capacity_)
+    capacity<<=1;
+  m_slots=(slot*)PFC_MEM_ALLOC(capacity*sizeof(slot));
+  m_mask=capacity-1;
+  for(usize_t i=0; i<capacity; ++i)
+    m_slots[i].seq=i;
+  m_push_pos=0;
+  m_pop_pos=0;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+usize_t mp_ring_queue<T>::capacity() const
+{
+  return m_slots?m_mask+1:0;
+}
+//----
+
+template<typename T>
+usize_t mp_ring_queue<T>::size() const
+{
+  // approximate queue size (pop position is read first so that the size can't go negative)
+  usize_t pop_pos=atom_read(m_pop_pos);
+  usize_t size=atom_read(m_push_pos)-pop_pos;
+  return size<=m_mask?size:capacity();
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+bool mp_ring_queue<T>::try_push(const T &v_)
+{
+  // claim the push position if the slot has been popped on the previous lap
+  PFC_ASSERT_PEDANTIC(m_slots);
+  usize_t pos=atom_read(m_push_pos);
+  slot *s;
+  while(true)
+  {
+    s=m_slots+(pos&m_mask);
+    ssize_t seq_diff=ssize_t(atom_read(s->seq)-pos);
+    if(!seq_diff)
+    {
+      usize_t prev_pos=atom_cmov_eq(m_push_pos, pos+1, pos);
+      if(prev_pos==pos)
+        break;
+      pos=prev_pos;
+    }
+    else if(seq_diff<0)
+      return false;
+    else
+      pos=atom_read(m_push_pos);
+  }
+
+  // construct the value and publish the slot for the pop
+  atom_fence_acquire();
+  PFC_PNEW(s->data)T(v_);
+  atom_fence_release();
+  atom_write(s->seq, pos+1);
+  return true;
+}
+//----
+
+template<typename T>
+bool mp_ring_queue<T>::try_pop(T &v_)
+{
+  // claim the pop position if the slot has been pushed on this lap
+  PFC_ASSERT_PEDANTIC(m_slots);
+  usize_t pos=atom_read(m_pop_pos);
+  slot *s;
+  while(true)
+  {
+    s=m_slots+(pos&m_mask);
+    ssize_t seq_diff=ssize_t(atom_read(s->seq)-(pos+1));
+    if(!seq_diff)
+    {
+      usize_t prev_pos=atom_cmov_eq(m_pop_pos, pos+1, pos);
+      if(prev_pos==pos)
+        break;
+      pos=prev_pos;
+    }
+    else if(seq_diff<0)
+      return false;
+    else
+      pos=atom_read(m_pop_pos);
+  }
+
+  // move the value out and release the slot for the push of the next lap
+  atom_fence_acquire();
+  T &v=*(T*)s->data;
+  v_=static_cast<T&&>(v);
+  v.~T();
+  atom_fence_release();
+  atom_write(s->seq, pos+m_mask+1);
+  return true;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+void mp_ring_queue<T>::release()
+{
+  // destruct remaining values and free the slots
+  if(!m_slots)
+    return;
+  for(usize_t pos=m_pop_pos; pos!=m_push_pos; ++pos)
+    ((T*)m_slots[pos&m_mask].data)->~T();
+  PFC_MEM_FREE(m_slots);
+  m_slots=0;
+  m_mask=0;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// mp_spsc_ring_queue
+//============================================================================
+template<typename T>
+mp_spsc_ring_queue<T>::mp_spsc_ring_queue()
+{
+  m_data=0;
+  m_mask=0;
+  m_push_pos=0;
+  m_cached_pop_pos=0;
+  m_pop_pos=0;
+  m_cached_push_pos=0;
+}
+//----
+
+template<typename T>
+mp_spsc_ring_queue<T>::mp_spsc_ring_queue(usize_t capacity_)
+{
+  m_data=0;
+  m_mask=0;
+  m_push_pos=0;
+  m_cached_pop_pos=0;
+  m_pop_pos=0;
+  m_cached_push_pos=0;
+  init(capacity_);
+}
+//----
+
+template<typename T>
+mp_spsc_ring_queue<T>::~mp_spsc_ring_queue()
+{
+  release();
+}
+//----
+
+template<typename T>
+void mp_spsc_ring_queue<T>::init(usize_t capacity_)
+{
+  // allocate power-of-2 number of items
+  PFC_ASSERT(capacity_);
+  release();
+  usize_t capacity=1;
+  while(capacity<capacity_)
+    capacity<<=1;
+  m_data=(T*)PFC_MEM_ALLOC(capacity*sizeof(T));
+  m_mask=capacity-1;
+  m_push_pos=0;
+  m_cached_pop_pos=0;
+  m_pop_pos=0;
+  m_cached_push_pos=0;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+usize_t mp_spsc_ring_queue<T>::capacity() const
+{
+  return m_data?m_mask+1:0;
+}
+//----
+
+template<typename T>
+usize_t mp_spsc_ring_queue<T>::size() const
+{
+  // approximate queue size (pop position is read first so that the size can't go negative)
+  usize_t pop_pos=atom_read(m_pop_pos);
+  usize_t size=atom_read(m_push_pos)-pop_pos;
+  return size<=m_mask?size:capacity();
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+bool mp_spsc_ring_queue<T>::try_push(const T &v_)
+{
+  // check for free space, refreshing the cached pop position only if the queue looks full
+  PFC_ASSERT_PEDANTIC(m_data);
+  usize_t pos=m_push_pos;
+  if(pos-m_cached_pop_pos>m_mask)
+  {
+    m_cached_pop_pos=atom_read(m_pop_pos);
+    if(pos-m_cached_pop_pos>m_mask)
+      return false;
+    atom_fence_acquire();
+  }
+
+  // construct the value and publish it for the consumer
+  PFC_PNEW(m_data+(pos&m_mask))T(v_);
+  atom_fence_release();
+  atom_write(m_push_pos, pos+1);
+  return true;
+}
+//----
+
+template<typename T>
+bool mp_spsc_ring_queue<T>::try_pop(T &v_)
+{
+  // check for pushed values, refreshing the cached push position only if the queue looks empty
+  PFC_ASSERT_PEDANTIC(m_data);
+  usize_t pos=m_pop_pos;
+  if(pos==m_cached_push_pos)
+  {
+    m_cached_push_pos=atom_read(m_push_pos);
+    if(pos==m_cached_push_pos)
+      return false;
+    atom_fence_acquire();
+  }
+
+  // move the value out and release the space for the producer
+  T &v=m_data[pos&m_mask];
+  v_=static_cast<T&&>(v);
+  v.~T();
+  atom_fence_release();
+  atom_write(m_pop_pos, pos+1);
+  return true;
+}
+//----------------------------------------------------------------------------
+
+template<typename T>
+void mp_spsc_ring_queue<T>::release()
+{
+  // destruct remaining values and free the data
+  if(!m_data)
+    return;
+  for(usize_t pos=m_pop_pos; pos!=m_push_pos; ++pos)
+    m_data[pos&m_mask].~T();
+  PFC_MEM_FREE(m_data);
+  m_data=0;
+  m_mask=0;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// mp_blocking_queue
+//============================================================================
+template<class Queue>
+mp_blocking_queue<Queue>::mp_blocking_queue()
+{
+  m_num_pop_waiters=0;
+  m_num_push_waiters=0;
+}
+//----
+
+template<class Queue>
+mp_blocking_queue<Queue>::mp_blocking_queue(usize_t capacity_)
+  :m_queue(capacity_)
+{
+  m_num_pop_waiters=0;
+  m_num_push_waiters=0;
+}
+//----
+
+template<class Queue>
+void mp_blocking_queue<Queue>::init(usize_t capacity_)
+{
+  PFC_ASSERT_MSG(!m_num_pop_waiters && !m_num_push_waiters, ("Initializing blocking queue with waiting threads\r\n"));
+  m_queue.init(capacity_);
+}
+//----------------------------------------------------------------------------
+
+template<class Queue>
+usize_t mp_blocking_queue<Queue>::capacity() const
+{
+  return m_queue.capacity();
+}
+//----
+
+template<class Queue>
+usize_t mp_blocking_queue<Queue>::size() const
+{
+  return m_queue.size();
+}
+//----------------------------------------------------------------------------
+
+template<class Queue>
+bool mp_blocking_queue<Queue>::try_push(const type &v_)
+{
+  if(!m_queue.try_push(v_))
+    return false;
+  notify_pushed();
+  return true;
+}
+//----
+
+template<class Queue>
+bool mp_blocking_queue<Queue>::try_pop(type &v_)
+{
+  if(!m_queue.try_pop(v_))
+    return false;
+  notify_popped();
+  return true;
+}
+//----
+
+template<class Queue>
+bool mp_blocking_queue<Queue>::push(const type &v_, float timeout_secs_)
+{
+  // try to push before registering as a waiter
+  PFC_ASSERT(timeout_secs_>=0.0f);
+  if(try_push(v_))
+    return true;
+
+  // wait for free space, retrying the push after registering so that a concurrent pop isn't missed
+  udouble_t end_time=timeout_secs_>0.0f?get_global_time()+timeout_secs_:0.0;
+  atom_inc(m_num_push_waiters);
+  bool is_pushed;
+  while(!(is_pushed=m_queue.try_push(v_)))
+  {
+    float wait_secs=0.0f;
+    if(timeout_secs_>0.0f)
+    {
+      udouble_t time_left=end_time-get_global_time();
+      if(time_left<=0.0)
+        break;
+      wait_secs=max(float(time_left), 0.000001f);
+    }
+    wait_event(m_popped_event, wait_secs);
+  }
+  atom_dec(m_num_push_waiters);
+  if(!is_pushed)
+    return false;
+
+  // wake a pop waiter, and pass the wake on to another push waiter if there's still space left
+  notify_pushed();
+  if(atom_read(m_num_push_waiters) && m_queue.size()<m_queue.capacity())
+    m_popped_event.trigger();
+  return true;
+}
+//----
+
+template<class Queue>
+bool mp_blocking_queue<Queue>::pop(type &v_, float timeout_secs_)
+{
+  // try to pop before registering as a waiter
+  PFC_ASSERT(timeout_secs_>=0.0f);
+  if(try_pop(v_))
+    return true;
+
+  // wait for a pushed value, retrying the pop after registering so that a concurrent push isn't missed
+  udouble_t end_time=timeout_secs_>0.0f?get_global_time()+timeout_secs_:0.0;
+  atom_inc(m_num_pop_waiters);
+  bool is_popped;
+  while(!(is_popped=m_queue.try_pop(v_)))
+  {
+    float wait_secs=0.0f;
+    if(timeout_secs_>0.0f)
+    {
+      udouble_t time_left=end_time-get_global_time();
+      if(time_left<=0.0)
+        break;
+      wait_secs=max(float(time_left), 0.000001f);
+    }
+    wait_event(m_pushed_event, wait_secs);
+  }
+  atom_dec(m_num_pop_waiters);
+  if(!is_popped)
+    return false;
+
+  // wake a push waiter, and pass the wake on to another pop waiter if there are still values left
+  notify_popped();
+  if(atom_read(m_num_pop_waiters) && m_queue.size())
+    m_pushed_event.trigger();
+  return true;
+}
+//----------------------------------------------------------------------------
+
+template<class Queue>
+void mp_blocking_queue<Queue>::notify_pushed()
+{
+  // the fence orders the waiter check after publishing the value (pairs with the waiter registration)
+  atom_fence();
+  if(atom_read(m_num_pop_waiters))
+    m_pushed_event.trigger();
+}
+//----
+
+template<class Queue>
+void mp_blocking_queue<Queue>::notify_popped()
+{
+  atom_fence();
+  if(atom_read(m_num_push_waiters))
+    m_popped_event.trigger();
+}
+//----------------------------------------------------------------------------
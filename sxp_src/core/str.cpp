@@ -17,8 +17,11 @@ using namespace pfc;
 //============================================================================
 void heap_str::swap(heap_str &str_)
 {
-  // swap string contents
-  pfc::swap(m_data, str_.m_data);
+  // swap string contents (local or allocated buffer)
+  char data[local_capacity+1];
+  mem_copy(data, m_local_data, sizeof(data));
+  mem_copy(m_local_data, str_.m_local_data, sizeof(data));
+  mem_copy(str_.m_local_data, data, sizeof(data));
   pfc::swap(m_size, str_.m_size);
   pfc::swap(m_capacity, str_.m_capacity);
 }
@@ -124,6 +124,13 @@ protected:
 //============================================================================
 // heap_str
 //============================================================================
+// Strings of up to local_capacity characters are stored inline in the object
+// and only longer strings are allocated with the string allocator. The inline
+// buffer isn't referenced by pointer so the string remains POD-movable. For
+// bulk parse-and-discard workloads the strings can be allocated from a
+// sequential_memory_allocator arena, e.g.:
+//   sequential_memory_allocator arena(65536, 1024, true);
+//   heap_str name(&arena);
 class heap_str: public str_base<heap_str>
 { PFC_MONO(heap_str) PFC_INTROSPEC_DECL;
 public:
@@ -177,13 +184,20 @@ public:
 
 private:
   enum {min_grow_alloc=15};
+  enum {local_capacity=sizeof(char*)*3-1};
+  PFC_INLINE char *init_data(usize_t capacity_);
+  PFC_INLINE char *str_data() const;
   PFC_INLINE void reserve_offset(usize_t capacity_, usize_t offset_);
   //--------------------------------------------------------------------------
 
   memory_allocator_base *m_allocator;
-  char *m_data;
   usize_t m_size;
   usize_t m_capacity;
+  union
+  {
+    char *m_data;
+    char m_local_data[local_capacity+1];
+  };
 };
 PFC_SET_TYPE_TRAIT(heap_str, is_type_pod_move, true);
 //----------------------------------------------------------------------------
@@ -291,7 +291,7 @@ PFC_INTROSPEC_INL_DEF(heap_str)
       uint32_t size;
       pe_.var(size);
       reset_size(size);
-      pe_.avar(m_data, m_size);
+      pe_.avar(str_data(), m_size);
     } break;
 
     case penum_output:
@@ -301,7 +301,7 @@ PFC_INTROSPEC_INL_DEF(heap_str)
       PFC_CHECK_MSG(m_size<=0xffffffff, ("Unable to serialize heap_string that contains more than 2^32-1 characters\r\n"));
       uint32_t size=(uint32_t)m_size;
       pe_.var(size);
-      pe_.avar(m_data, size);
+      pe_.avar(str_data(), size);
     } break;
   }
 }
@@ -311,9 +311,8 @@ heap_str::heap_str(memory_allocator_base *alloc_)
   :m_allocator(alloc_?alloc_:&default_memory_allocator::inst())
 {
   // initialize heap string
-  m_data=0;
   m_size=0;
-  m_capacity=0;
+  m_capacity=local_capacity;
 }
 //----
 
@@ -323,9 +322,7 @@ heap_str::heap_str(const heap_str &str_, memory_allocator_base *alloc_)
   // construct heap string from another heap string
   usize_t len=str_.m_size;
   m_size=len;
-  m_capacity=len;
-  m_data=len?(char*)m_allocator->alloc(m_capacity+1):0;
-  mem_copy(m_data, str_.m_data, len);
+  mem_copy(init_data(len), str_.str_data(), len);
 }
 //----
 
@@ -336,9 +333,7 @@ heap_str::heap_str(const str_base<S> &str_, memory_allocator_base *alloc_)
   // construct heap string from the base string
   usize_t len=static_cast<const S&>(str_).size();
   m_size=len;
-  m_capacity=len;
-  m_data=len?(char*)m_allocator->alloc(m_capacity+1):0;
-  mem_copy(m_data, static_cast<const S&>(str_).data(), len);
+  mem_copy(init_data(len), static_cast<const S&>(str_).data(), len);
 }
 //----
 
@@ -348,9 +343,7 @@ heap_str::heap_str(const char *cstr_, memory_allocator_base *alloc_)
   // construct heap string from the c-string
   usize_t len=str_size(cstr_);
   m_size=len;
-  m_capacity=len;
-  m_data=len?(char*)m_allocator->alloc(m_capacity+1):0;
-  mem_copy(m_data, cstr_, len);
+  mem_copy(init_data(len), cstr_, len);
 }
 //----
 
@@ -359,9 +352,7 @@ heap_str::heap_str(const char *str_, usize_t num_chars_, memory_allocator_base *
 {
   // construct heap string from given size c-string
   m_size=num_chars_;
-  m_capacity=num_chars_;
-  m_data=num_chars_?(char*)m_allocator->alloc(num_chars_+1):0;
-  mem_copy(m_data, str_, num_chars_);
+  mem_copy(init_data(num_chars_), str_, num_chars_);
 }
 //----
 
@@ -370,22 +361,22 @@ heap_str::heap_str(char c_, memory_allocator_base *alloc_)
 {
   // construct heap string from a character
   m_size=1;
-  m_capacity=1;
-  m_data=(char*)m_allocator->alloc(2);
-  *m_data=c_;
+  m_capacity=local_capacity;
+  *m_local_data=c_;
 }
 //----
 
 heap_str::~heap_str()
 {
   // release string data
-  m_allocator->free(m_data);
+  if(m_capacity>local_capacity)
+    m_allocator->free(m_data);
 }
 //----
 
 void heap_str::set_allocator(memory_allocator_base *alloc_)
 {
-  PFC_ASSERT_MSG(!m_data, ("Unable to change the allocator of heap_str with capacity\r\n"));
+  PFC_ASSERT_MSG(m_capacity<=local_capacity, ("Unable to change the allocator of heap_str with allocated capacity\r\n"));
   m_allocator=alloc_?alloc_:&default_memory_allocator::inst();
 }
 //----
@@ -397,7 +388,7 @@ void heap_str::operator=(const heap_str &str_)
   usize_t new_size=str_.m_size;
   if(m_capacity<new_size)
     reserve_offset(new_size, 0);
-  mem_copy(m_data, str_.m_data, new_size);
+  mem_copy(str_data(), str_.str_data(), new_size);
   m_size=new_size;
 }
 //----
@@ -410,7 +401,7 @@ void heap_str::operator=(const str_base<S> &str_)
   usize_t new_size=static_cast<const S&>(str_).size();
   if(m_capacity<new_size)
     reserve_offset(new_size, 0);
-  mem_copy(m_data, static_cast<const S&>(str_).data(), new_size);
+  mem_copy(str_data(), static_cast<const S&>(str_).data(), new_size);
   m_size=new_size;
 }
 //----
@@ -422,7 +413,7 @@ void heap_str::operator=(const char *cstr_)
   usize_t new_size=cstr_?str_size(cstr_):0;
   if(m_capacity<new_size)
     reserve_offset(new_size, 0);
-  mem_copy(m_data, cstr_, new_size);
+  mem_copy(str_data(), cstr_, new_size);
   m_size=new_size;
 }
 //----
@@ -432,7 +423,7 @@ void heap_str::set(const char *str_, usize_t num_chars_)
   // assign string of given size to the string
   if(m_capacity<num_chars_)
     reserve_offset(num_chars_, 0);
-  mem_copy(m_data, str_, num_chars_);
+  mem_copy(str_data(), str_, num_chars_);
   m_size=num_chars_;
 }
 //----
@@ -440,23 +431,24 @@ void heap_str::set(const char *str_, usize_t num_chars_)
 void heap_str::clear()
 {
   // clear string content
-  m_allocator->free(m_data);
-  m_data=0;
+  if(m_capacity>local_capacity)
+    m_allocator->free(m_data);
   m_size=0;
-  m_capacity=0;
+  m_capacity=local_capacity;
 }
 //----
 
 void heap_str::reset_size(usize_t size_)
 {
-  // reallocate string
+  // reallocate string without preserving the content
   PFC_MEM_TRACK_STACK();
-  if(m_size!=size_)
+  if(m_capacity<size_)
   {
-    m_allocator->free(m_data);
-    m_data=(char*)m_allocator->alloc(size_);
-    m_size=m_capacity=size_;
+    if(m_capacity>local_capacity)
+      m_allocator->free(m_data);
+    init_data(size_);
   }
+  m_size=size_;
 }
 //----
 
@@ -472,15 +464,9 @@ void heap_str::resize(usize_t size_)
 
 void heap_str::reserve(usize_t capacity_)
 {
+  // copy string to a new buffer with given capacity
   if(m_capacity<capacity_)
-  {
-    // copy string to a new buffer with given capacity
-    char *data=(char*)m_allocator->alloc(capacity_+1);
-    m_capacity=capacity_;
-    mem_copy(data, m_data, m_size);
-    m_allocator->free(m_data);
-    m_data=data;
-  }
+    reserve_offset(capacity_, 0);
 }
 //----------------------------------------------------------------------------
 
@@ -505,77 +491,72 @@ usize_t heap_str::capacity() const
 const char &heap_str::operator[](usize_t idx_) const
 {
   PFC_ASSERT_PEDANTIC(idx_<m_size);
-  return m_data[idx_];
+  return str_data()[idx_];
 }
 //----
 
 char &heap_str::operator[](usize_t idx_)
 {
   PFC_ASSERT_PEDANTIC(idx_<m_size);
-  return m_data[idx_];
+  return str_data()[idx_];
 }
 //----
 
 const char &heap_str::front() const
 {
   PFC_ASSERT_PEDANTIC(m_size);
-  return *m_data;
+  return *str_data();
 }
 //----
 
 char &heap_str::front()
 {
   PFC_ASSERT_PEDANTIC(m_size);
-  return *m_data;
+  return *str_data();
 }
 //----
 
 const char &heap_str::back() const
 {
   PFC_ASSERT_PEDANTIC(m_size);
-  return m_data[m_size-1];
+  return str_data()[m_size-1];
 }
 //----
 
 char &heap_str::back()
 {
   PFC_ASSERT_PEDANTIC(m_size);
-  return m_data[m_size-1];
+  return str_data()[m_size-1];
 }
 //----
 
 const char *heap_str::c_str() const
 {
   // return c-string of the string
-  if(!m_data)
-    return "";
-  const_cast<char&>(m_data[m_size])=0;
-  return m_data;
+  char *data=str_data();
+  data[m_size]=0;
+  return data;
 }
 //----
 
 char *heap_str::c_str()
 {
   // return c-string of the string
-  if(!m_data)
-  {
-    static char c=0;
-    return &c;
-  }
-  m_data[m_size]=0;
-  return m_data;
+  char *data=str_data();
+  data[m_size]=0;
+  return data;
 }
 //----
 
 const char *heap_str::data() const
 {
-  return m_data;
+  return str_data();
 }
 //----
 
 char *heap_str::data()
 {
-  return m_data;
+  return str_data();
 }
 //----
 
@@ -589,7 +570,7 @@ template<class S> void heap_str::operator+=(const str_base<S> &str_)
     PFC_MEM_TRACK_STACK();
     reserve_offset(max(usize_t(min_grow_alloc), new_size, m_size*2), 0);
   }
-  mem_copy(m_data+m_size, static_cast<const S&>(str_).data(), size);
+  mem_copy(str_data()+m_size, static_cast<const S&>(str_).data(), size);
   m_size=new_size;
 }
 //----
@@ -604,7 +585,7 @@ void heap_str::operator+=(const char *cstr_)
     PFC_MEM_TRACK_STACK();
     reserve_offset(max(usize_t(min_grow_alloc), new_size, m_size*2), 0);
   }
-  mem_copy(m_data+m_size, cstr_, size);
+  mem_copy(str_data()+m_size, cstr_, size);
   m_size=new_size;
 }
 //----
@@ -617,7 +598,7 @@ void heap_str::operator+=(char c_)
     PFC_MEM_TRACK_STACK();
     reserve_offset(max(usize_t(min_grow_alloc), m_size*2), 0);
   }
-  m_data[m_size++]=c_;
+  str_data()[m_size++]=c_;
 }
 //----
 
@@ -625,14 +606,19 @@ void heap_str::push_front(char c_)
 {
   // prepend character to the string
   usize_t new_size=m_size+1;
+  char *data;
   if(m_capacity<new_size)
   {
     PFC_MEM_TRACK_STACK();
     reserve_offset(max(usize_t(min_grow_alloc), new_size, m_size*2), 1);
+    data=m_data;
   }
   else
-    mem_move(m_data+1, m_data, m_size);
-  *m_data=c_;
+  {
+    data=str_data();
+    mem_move(data+1, data, m_size);
+  }
+  *data=c_;
   m_size=new_size;
 }
 //----
@@ -641,14 +627,19 @@ void heap_str::push_front(char c_, usize_t num_chars_)
 {
   // prepend given number of characters to the string
   usize_t new_size=m_size+num_chars_;
+  char *data;
   if(m_capacity<new_size)
   {
     PFC_MEM_TRACK_STACK();
     reserve_offset(max(usize_t(min_grow_alloc), new_size, m_size*2), num_chars_);
+    data=m_data;
   }
   else
-    mem_move(m_data+num_chars_, m_data, m_size);
-  mem_set(m_data, c_, num_chars_);
+  {
+    data=str_data();
+    mem_move(data+num_chars_, data, m_size);
+  }
+  mem_set(data, c_, num_chars_);
   m_size=new_size;
 }
 //----
@@ -669,14 +660,19 @@ void heap_str::push_front(const char *str_, usize_t num_chars_)
   // prepend string of given size to the string
   PFC_ASSERT(str_ || !num_chars_);
   usize_t new_size=m_size+num_chars_;
+  char *data;
   if(m_capacity<new_size)
   {
     PFC_MEM_TRACK_STACK();
     reserve_offset(max(usize_t(min_grow_alloc), new_size, m_size*2), num_chars_);
+    data=m_data;
   }
   else
-    mem_move(m_data+num_chars_, m_data, m_size);
-  mem_copy(m_data, str_, num_chars_);
+  {
+    data=str_data();
+    mem_move(data+num_chars_, data, m_size);
+  }
+  mem_copy(data, str_, num_chars_);
   m_size=new_size;
 }
 //----
@@ -689,7 +685,7 @@ void heap_str::push_back(char c_)
     PFC_MEM_TRACK_STACK();
     reserve_offset(max(usize_t(min_grow_alloc), m_size*2), 0);
   }
-  m_data[m_size++]=c_;
+  str_data()[m_size++]=c_;
 }
 //----
 
@@ -702,7 +698,7 @@ void heap_str::push_back(char c_, usize_t num_chars_)
     PFC_MEM_TRACK_STACK();
     reserve(max(usize_t(min_grow_alloc), new_size, m_size*2));
   }
-  mem_set(m_data+m_size, c_, num_chars_);
+  mem_set(str_data()+m_size, c_, num_chars_);
   m_size=new_size;
 }
 //----
@@ -716,7 +712,7 @@ void heap_str::push_back(const char *str_, usize_t num_chars_)
     PFC_MEM_TRACK_STACK();
     reserve(max(usize_t(min_grow_alloc), new_size, m_size*2));
   }
-  mem_copy(m_data+m_size, str_, num_chars_);
+  mem_copy(str_data()+m_size, str_, num_chars_);
   m_size=new_size;
 }
 //----
@@ -726,7 +722,8 @@ void heap_str::remove_front(usize_t num_chars_)
   // remove given number of characters from the beginning of the string
   PFC_ASSERT(m_size>=num_chars_);
   usize_t new_size=m_size-num_chars_;
-  mem_move(m_data, m_data+num_chars_, new_size);
+  char *data=str_data();
+  mem_move(data, data+num_chars_, new_size);
   m_size=new_size;
 }
 //----
@@ -739,14 +736,36 @@ void heap_str::remove_back(usize_t num_chars_)
 }
 //----------------------------------------------------------------------------
 
+char *heap_str::init_data(usize_t capacity_)
+{
+  // setup local buffer or allocate buffer of given capacity for the string
+  if(capacity_<=local_capacity)
+  {
+    m_capacity=local_capacity;
+    return m_local_data;
+  }
+  m_capacity=capacity_;
+  m_data=(char*)m_allocator->alloc(capacity_+1);
+  return m_data;
+}
+//----
+
+char *heap_str::str_data() const
+{
+  return m_capacity>local_capacity?m_data:const_cast<char*>(m_local_data);
+}
+//----
+
 void heap_str::reserve_offset(usize_t capacity_, usize_t offset_)
 {
-  // copy string to a new buffer with given capacity & offset
+  // copy string to a new allocated buffer with given capacity & offset
+  PFC_ASSERT(capacity_>local_capacity);
   char *data=(char*)m_allocator->alloc(capacity_+1);
-  m_capacity=capacity_;
-  mem_copy(data+offset_, m_data, m_size);
-  m_allocator->free(m_data);
+  mem_copy(data+offset_, str_data(), m_size);
+  if(m_capacity>local_capacity)
+    m_allocator->free(m_data);
   m_data=data;
+  m_capacity=capacity_;
 }
 //----------------------------------------------------------------------------
 
@@ -592,7 +592,8 @@ bit_input_stream::bit_input_stream(bin_input_stream_base &s_, usize_t bit_stream
   :m_stream(s_)
   ,m_bit_stream_length(bit_stream_length_)
 {
-  m_stream.read_bytes(m_cache, min((bit_stream_length_+7)/8, sizeof(m_cache)), false);
+  usize_t num_bytes=m_stream.read_bytes(m_cache, min((bit_stream_length_+7)/8, sizeof(m_cache)), false);
+  mem_zero((uint8_t*)m_cache+num_bytes, sizeof(m_cache)-num_bytes);
   m_cache_start_bit_pos=0;
   m_cache_bit_pos=0;
 }
@@ -602,21 +603,69 @@ bit_input_stream::bit_input_stream(bin_input_stream_base &s_)
   :m_stream(s_)
   ,m_bit_stream_length(usize_t(-8))
 {
-  m_stream.read_bytes(m_cache, min((m_bit_stream_length+7)/8, sizeof(m_cache)), false);
+  usize_t num_bytes=m_stream.read_bytes(m_cache, sizeof(m_cache), false);
+  mem_zero((uint8_t*)m_cache+num_bytes, sizeof(m_cache)-num_bytes);
   m_cache_start_bit_pos=0;
   m_cache_bit_pos=0;
 }
 //----------------------------------------------------------------------------
 
+void bit_input_stream::read_bits_u32(uint32_t *a_, usize_t count_, unsigned num_bits_)
+{
+  // read fixed-width fields with the bit position in a local variable
+  PFC_ASSERT(num_bits_<=32);
+  PFC_ASSERT_MSG(count_*num_bits_<=m_bit_stream_length-bit_pos(), ("Bit input stream underflow.\r\n"));
+  const uint64_t mask=(uint64_t(1)<<num_bits_)-1;
+  unsigned cache_bit_pos=m_cache_bit_pos;
+  uint32_t *end=a_+count_;
+  while(a_!=end)
+  {
+    unsigned cache_dword_offset=cache_bit_pos/32;
+    uint64_t window=uint64_t(m_cache[cache_dword_offset])|(uint64_t(m_cache[cache_dword_offset+1])<<32);
+    *a_++=uint32_t((window>>(cache_bit_pos&31))&mask);
+    if((cache_bit_pos+=num_bits_)>=cache_size*8)
+    {
+      cache_bit_pos-=cache_size*8;
+      update_cache();
+    }
+  }
+  m_cache_bit_pos=cache_bit_pos;
+}
+//----
+
+void bit_input_stream::read_bits_i32(int32_t *a_, usize_t count_, unsigned num_bits_)
+{
+  // read fields and sign-extend the values
+  PFC_ASSERT(num_bits_ && num_bits_<=32);
+  read_bits_u32((uint32_t*)a_, count_, num_bits_);
+  uint32_t sign=uint32_t(1)<<(num_bits_-1);
+  for(usize_t i=0; i<count_; ++i)
+    a_[i]=int32_t((uint32_t(a_[i])^sign)-sign);
+}
+//----------------------------------------------------------------------------
+
+void bit_input_stream::update_cache()
+{
+  // move the look-ahead dword to the beginning of the cache and read the next block of the bit stream
+  m_cache[0]=m_cache[cache_size/4];
+  m_cache_start_bit_pos+=cache_size*8;
+  usize_t read_bit_pos=m_cache_start_bit_pos+32;
+  usize_t remaining_stream_bits=read_bit_pos<m_bit_stream_length?m_bit_stream_length-read_bit_pos:0;
+  usize_t num_bytes=m_stream.read_bytes(m_cache+1, min((remaining_stream_bits+7)/8, usize_t(cache_size)), false);
+  mem_zero((uint8_t*)(m_cache+1)+num_bytes, cache_size-num_bytes);
+}
+//----------------------------------------------------------------------------
+
 
 //============================================================================
 // bit_output_stream
 //============================================================================
 bit_output_stream::bit_output_stream(bin_output_stream_base &stream_)
   :m_stream(stream_)
-  ,m_cache_bit_pos(0)
 {
-  mem_zero(m_cache, sizeof(m_cache));
+  m_bits=0;
+  m_num_bits=0;
+  m_cache_pos=m_cache;
 }
 //----
 
@@ -625,3 +674,49 @@ bit_output_stream::~bit_output_stream()
   flush();
 }
 //----------------------------------------------------------------------------
+
+void bit_output_stream::write_bits(const uint32_t *a_, usize_t count_, uint8_t num_bits_)
+{
+  // write fixed-width fields with the bit buffer in local variables
+  PFC_ASSERT(num_bits_<=32);
+  uint32_t *cache_end=m_cache+cache_size/4;
+  const uint64_t mask=(uint64_t(1)<<num_bits_)-1;
+  uint64_t bits=m_bits;
+  unsigned num_bits=m_num_bits;
+  const uint32_t *end=a_+count_;
+  while(a_!=end)
+  {
+    bits|=(uint64_t(*a_++)&mask)<<num_bits;
+    num_bits+=num_bits_;
+    if(num_bits>=32)
+    {
+      // move the completed dword to the cache
+      *m_cache_pos++=uint32_t(bits);
+      bits>>=32;
+      num_bits-=32;
+      if(m_cache_pos==cache_end)
+        flush_cache();
+    }
+  }
+  m_bits=bits;
+  m_num_bits=num_bits;
+}
+//----
+
+void bit_output_stream::flush()
+{
+  // write the cache and the remaining bits of the bit buffer padded to a byte
+  flush_cache();
+  uint32_t v=uint32_t(m_bits);
+  m_stream.write_bytes(&v, (m_num_bits+7)/8);
+  m_bits=0;
+  m_num_bits=0;
+}
+//----------------------------------------------------------------------------
+
+void bit_output_stream::flush_cache()
+{
+  m_stream.write_bytes(m_cache, usize_t(m_cache_pos-m_cache)*4);
+  m_cache_pos=m_cache;
+}
+//----------------------------------------------------------------------------
@@ -452,6 +452,10 @@ public:
   // bit read ops
   PFC_INLINE uint32_t read_bits_u32(unsigned num_bits_);
   PFC_INLINE int32_t read_bits_i32(unsigned num_bits_);
+  void read_bits_u32(uint32_t*, usize_t count_, unsigned num_bits_);
+  void read_bits_i32(int32_t*, usize_t count_, unsigned num_bits_);
+  PFC_INLINE uint32_t peek_bits(unsigned num_bits_);
+  PFC_INLINE void consume_bits(unsigned num_bits_);
   //--------------------------------------------------------------------------
 
   // accessors and seeking
@@ -464,14 +468,15 @@ public:
 private:
   bit_input_stream(const bit_input_stream&); // not implemented
   void operator=(const bit_input_stream&); // not implemented
+  void update_cache();
   //--------------------------------------------------------------------------
 
-  enum {cache_size=32};
+  enum {cache_size=256};
   bin_input_stream_base &m_stream;
   const usize_t m_bit_stream_length;
-  uint32_t m_cache[cache_size/4];
-  unsigned m_cache_start_bit_pos;
+  usize_t m_cache_start_bit_pos;
   unsigned m_cache_bit_pos;
+  uint32_t m_cache[cache_size/4+1];
 };
 //----------------------------------------------------------------------------
 
@@ -489,18 +494,22 @@ public:
 
   // bit write ops
   PFC_INLINE void write_bits(uint32_t, uint8_t num_bits_);
-  PFC_INLINE void flush();
+  void write_bits(const uint32_t*, usize_t count_, uint8_t num_bits_);
+  void flush();
   //--------------------------------------------------------------------------
 
 private:
   bit_output_stream(const bit_output_stream&); // not implemented
   void operator=(const bit_output_stream&); // not implemented
+  void flush_cache();
   //--------------------------------------------------------------------------
 
-  enum {cache_size=32};
+  enum {cache_size=256};
   bin_output_stream_base &m_stream;
+  uint64_t m_bits;
+  unsigned m_num_bits;
+  uint32_t *m_cache_pos;
   uint32_t m_cache[cache_size/4];
-  unsigned m_cache_bit_pos;
 };
 //----------------------------------------------------------------------------
 
@@ -1033,15 +1033,9 @@ void endian_input_stream::stream(T &v_, meta_bool<true> is_class_)
 template<typename T>
 void endian_input_stream::stream(T *p_, usize_t count_, meta_bool<false> is_class_)
 {
-  // read values from the stream and emit byte-swapped values
-  T *end=p_+count_;
-  if(count_)
-    do
-    {
-      T v;
-      m_stream>>v;
-      *p_=swap_bytes(v);
-    } while(++p_<end);
+  // read values with a single read and swap bytes of the values in place
+  m_stream.read(p_, count_);
+  swap_bytes(p_, count_);
 }
 //----
 
@@ -1132,13 +1126,18 @@ void endian_output_stream::stream(const T &v_, meta_bool<true> is_class_)
 template<typename T>
 void endian_output_stream::stream(const T *p_, usize_t count_, meta_bool<false> is_class_)
 {
-  // swap bytes in the array
-  const T *end=p_+count_;
-  if(count_)
-    do
-    {
-      m_stream<<swap_bytes(*p_);
-    } while(++p_<end);
+  // write the array in blocks of byte-swapped values
+  enum {block_size=4096/sizeof(T)};
+  T block[block_size];
+  while(count_)
+  {
+    usize_t num_values=min<usize_t>(count_, block_size);
+    mem_copy(block, p_, sizeof(T)*num_values);
+    swap_bytes(block, num_values);
+    m_stream.write_bytes(block, sizeof(T)*num_values);
+    p_+=num_values;
+    count_-=num_values;
+  }
 }
 //----
 
@@ -1162,63 +1161,41 @@ void endian_output_stream::stream(const T *p_, usize_t count_, meta_bool<true> i
 //============================================================================
 uint32_t bit_input_stream::read_bits_u32(unsigned num_bits_)
 {
-  // copy the give number of bits from the cache
-  PFC_ASSERT_PEDANTIC(num_bits_<=32);
-  PFC_ASSERT_PEDANTIC_MSG(num_bits_<=m_bit_stream_length-m_cache_start_bit_pos-m_cache_bit_pos, ("Bit input stream underflow.\r\n"));
-  uint8_t cache_dword_bit_offset=m_cache_bit_pos&31;
-  unsigned cache_dword_offset=m_cache_bit_pos/32;
-  uint32_t res=m_cache[cache_dword_offset]>>cache_dword_bit_offset;
-  m_cache_bit_pos+=num_bits_;
-
-  // check for completion of a cache dword
-  uint8_t remaining_dword_bits=32-cache_dword_bit_offset;
-  if(num_bits_>=remaining_dword_bits)
-  {
-    // check for cache read (completed the last dword)
-    if(++cache_dword_offset==cache_size/4)
-    {
-      m_cache_bit_pos-=cache_size*8;
-      m_cache_start_bit_pos+=cache_size*8;
-      usize_t remaining_stream_bits=m_cache_start_bit_pos<m_bit_stream_length?m_bit_stream_length-m_cache_start_bit_pos:0;
-      m_stream.read_bytes(m_cache, min((remaining_stream_bits+7)/8, sizeof(m_cache)), false);
-      cache_dword_offset=0;
-    }
-
-    // check for bit overflow to the next word
-    if(num_bits_>remaining_dword_bits)
-      res|=m_cache[cache_dword_offset]<<remaining_dword_bits;
-  }
-  return num_bits_<32?res&~(uint32_t(-1)<<num_bits_):res;
+  uint32_t v=peek_bits(num_bits_);
+  consume_bits(num_bits_);
+  return v;
 }
 //----
 
 int32_t bit_input_stream::read_bits_i32(unsigned num_bits_)
 {
-  // copy the give number of bits from the cache
+  // read bits and sign-extend the value
+  PFC_ASSERT_PEDANTIC(num_bits_ && num_bits_<=32);
+  uint32_t v=read_bits_u32(num_bits_), sign=uint32_t(1)<<(num_bits_-1);
+  return int32_t((v^sign)-sign);
+}
+//----
+
+uint32_t bit_input_stream::peek_bits(unsigned num_bits_)
+{
+  // return the given number of bits from the 64-bit cache window without consuming them
   PFC_ASSERT_PEDANTIC(num_bits_<=32);
-  uint8_t cache_dword_bit_offset=m_cache_bit_pos&31;
   unsigned cache_dword_offset=m_cache_bit_pos/32;
-  uint32_t res=m_cache[cache_dword_offset]>>cache_dword_bit_offset;
-  m_cache_bit_pos+=num_bits_;
+  uint64_t window=uint64_t(m_cache[cache_dword_offset])|(uint64_t(m_cache[cache_dword_offset+1])<<32);
+  return uint32_t((window>>(m_cache_bit_pos&31))&((uint64_t(1)<<num_bits_)-1));
+}
+//----
 
-  // check for completion of a cache dword
-  uint8_t remaining_dword_bits=32-cache_dword_bit_offset;
-  if(num_bits_>=remaining_dword_bits)
+void bit_input_stream::consume_bits(unsigned num_bits_)
+{
+  // advance the bit position and read the next cache block if the cache was consumed
+  PFC_ASSERT_PEDANTIC(num_bits_<=32);
+  PFC_ASSERT_PEDANTIC_MSG(num_bits_<=m_bit_stream_length-m_cache_start_bit_pos-m_cache_bit_pos, ("Bit input stream underflow.\r\n"));
+  if((m_cache_bit_pos+=num_bits_)>=cache_size*8)
   {
-    // check for cache read (completed the last dword)
-    if(++cache_dword_offset==cache_size/4)
-    {
-      m_stream.read_bytes(m_cache, sizeof(m_cache), false);
-      m_cache_bit_pos-=cache_size*8;
-      m_cache_start_bit_pos+=cache_size*8;
-      cache_dword_offset=0;
-    }
-
-    // check for bit overflow to the next word
-    if(num_bits_>remaining_dword_bits)
-      res|=m_cache[cache_dword_offset]<<remaining_dword_bits;
+    m_cache_bit_pos-=cache_size*8;
+    update_cache();
   }
-  return num_bits_<32?(res&(uint32_t(1<<num_bits_)-1))|-int32_t(res&int32_t(1<<(num_bits_-1))):res;
 }
 //----------------------------------------------------------------------------
 
@@ -1243,7 +1220,14 @@ usize_t bit_input_stream::bit_pos() const
 
 void bit_input_stream::skip_bits(usize_t num_bits_)
 {
-  m_cache_bit_pos+=(unsigned)num_bits_;
+  // skip bits and read cache blocks until reaching the skipped position
+  num_bits_+=m_cache_bit_pos;
+  while(num_bits_>=cache_size*8)
+  {
+    num_bits_-=cache_size*8;
+    update_cache();
+  }
+  m_cache_bit_pos=unsigned(num_bits_);
 }
 //----------------------------------------------------------------------------
 
@@ -1253,40 +1237,19 @@ void bit_input_stream::skip_bits(usize_t num_bits_)
 //============================================================================
 void bit_output_stream::write_bits(uint32_t v_, uint8_t num_bits_)
 {
-  // copy the give number of bits to the cache
+  // add the bits to the bit buffer and move completed dwords to the cache
   PFC_ASSERT_PEDANTIC(num_bits_<=32);
-  uint32_t v=num_bits_<32?v_&~(uint32_t(-1)<<num_bits_):v_;
-  uint8_t cache_dword_bit_offset=m_cache_bit_pos&31;
-  unsigned cache_dword_offset=m_cache_bit_pos/32;
-  m_cache[cache_dword_offset]|=v<<cache_dword_bit_offset;
-  m_cache_bit_pos+=num_bits_;
-
-  // check for completion of a cache dword
-  uint8_t remaining_dword_bits=32-cache_dword_bit_offset;
-  if(num_bits_>=remaining_dword_bits)
+  m_bits|=(uint64_t(v_)&((uint64_t(1)<<num_bits_)-1))<<m_num_bits;
+  m_num_bits+=num_bits_;
+  if(m_num_bits>=32)
   {
-    // check for cache flush (completed the last dword)
-    if(++cache_dword_offset==cache_size/4)
-    {
-      m_stream.write_bytes(m_cache, sizeof(m_cache));
-      mem_zero(m_cache, sizeof(m_cache));
-      m_cache_bit_pos-=cache_size*8;
-      cache_dword_offset=0;
-    }
-
-    // check for bit overflow to the next dword
-    if(num_bits_>remaining_dword_bits)
-      m_cache[cache_dword_offset]|=v>>remaining_dword_bits;
+    *m_cache_pos++=uint32_t(m_bits);
+    m_bits>>=32;
+    m_num_bits-=32;
+    if(m_cache_pos==m_cache+cache_size/4)
+      flush_cache();
   }
 }
-//----
-
-void bit_output_stream::flush()
-{
-  m_stream.write_bytes(m_cache, (m_cache_bit_pos+7)/8);
-  mem_zero(m_cache, sizeof(m_cache));
-  m_cache_bit_pos=0;
-}
 //----------------------------------------------------------------------------
 
 
@@ -7,6 +7,16 @@
 
 #include "sxp_src/sxp_pch.h"
 #include "utils.h"
+#include "mp/mp.h"
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PFC_SWAP_BYTES_NEON
+#else
+#include <emmintrin.h>
+#ifdef PFC_PLATFORM_SSE4
+#include <tmmintrin.h>
+#endif
+#endif
 using namespace pfc;
 //----------------------------------------------------------------------------
 
@@ -54,6 +64,199 @@ namespace
     0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693, 0x54de5729, 0x23d967bf,
     0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94, 0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
   };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // str_intern_shard
+  //==========================================================================
+  enum {str_intern_num_shards=32};       // number of independently locked shards (power-of-2)
+  enum {str_intern_min_table_size=256};  // initial number of shard table slots (power-of-2)
+  enum {str_intern_arena_size=16*1024};  // size of string arena blocks
+  //----
+
+  struct str_intern_slot
+  {
+    const char *volatile str;
+    uint32_t crc32;
+  };
+  //----
+
+  struct str_intern_table
+  {
+    usize_t mask;
+    usize_t num_bytes;
+    str_intern_table *next_retired;
+    str_intern_slot slots[1];
+  };
+  //----
+
+  struct str_intern_shard
+  {
+    str_intern_table *volatile table;
+    str_intern_table *retired;      // grown-out tables to be released once no lock-free lookups are in flight
+    volatile int32_t lock;
+    volatile int32_t num_readers;   // number of in-flight lock-free lookups
+    usize_t num_strings;
+    usize_t num_str_bytes;
+    usize_t num_arena_bytes;
+    usize_t num_table_bytes;
+    char *arena_pos, *arena_end;
+    char pad[64];  // keep shards in separate cache lines
+  };
+  //--------------------------------------------------------------------------
+
+  // interning state (zero initialized prior to static construction, thus usable by static constructors)
+  // note: strings and arenas are never released, and grown-out tables are released only when no lock-free lookups are in flight
+  str_intern_shard s_str_intern_shards[str_intern_num_shards];
+  //--------------------------------------------------------------------------
+
+  PFC_INLINE void lock_shard(str_intern_shard &shard_)
+  {
+    while(atom_cmov_eq(shard_.lock, int32_t(1), int32_t(0)))
+      thread_nap();
+  }
+  //----
+
+  PFC_INLINE void unlock_shard(str_intern_shard &shard_)
+  {
+    atom_write(shard_.lock, int32_t(0));
+  }
+  //----
+
+  const char *find_interned_str(const str_intern_table *table_, const char *str_, uint32_t crc32_)
+  {
+    // linear probe the table for the string (lower crc bits select the shard)
+    if(!table_)
+      return 0;
+    usize_t mask=table_->mask;
+    usize_t idx=(crc32_>>5)&mask;
+    while(const char *s=atom_read(table_->slots[idx].str))
+    {
+      atom_fence_acquire();
+      if(table_->slots[idx].crc32==crc32_ && str_eq(s, str_))
+        return s;
+      idx=(idx+1)&mask;
+    }
+    return 0;
+  }
+  //----
+
+  const char *find_interned_str(str_intern_shard &shard_, const char *str_, uint32_t crc32_)
+  {
+    // lock-free lookup of the string (counted to keep the read table alive)
+    atom_inc(shard_.num_readers);
+    const char *s=find_interned_str(atom_read(shard_.table), str_, crc32_);
+    atom_dec(shard_.num_readers);
+    return s;
+  }
+  //----
+
+  void insert_interned_str(str_intern_table &table_, const char *str_, uint32_t crc32_)
+  {
+    // add string to a free slot and publish it to lock-free lookups
+    usize_t mask=table_.mask;
+    usize_t idx=(crc32_>>5)&mask;
+    while(table_.slots[idx].str)
+      idx=(idx+1)&mask;
+    table_.slots[idx].crc32=crc32_;
+    atom_fence_release();
+    atom_write(table_.slots[idx].str, str_);
+  }
+  //----
+
+  str_intern_table *alloc_intern_table(usize_t num_slots_)
+  {
+    usize_t num_bytes=sizeof(str_intern_table)+(num_slots_-1)*sizeof(str_intern_slot);
+    str_intern_table *table=(str_intern_table*)PFC_HEAP_MALLOC(num_bytes);
+    PFC_CHECK_MSG(table, ("Unable to allocate %u bytes for string interning table\r\n", num_bytes));
+    mem_zero(table, num_bytes);
+    table->mask=num_slots_-1;
+    table->num_bytes=num_bytes;
+    return table;
+  }
+  //----
+
+  char *alloc_interned_str(str_intern_shard &shard_, usize_t num_bytes_)
+  {
+    // allocate string from the shard arena
+    if(usize_t(shard_.arena_end-shard_.arena_pos)<num_bytes_)
+    {
+      usize_t block_size=num_bytes_>str_intern_arena_size?num_bytes_:usize_t(str_intern_arena_size);
+      char *block=(char*)PFC_HEAP_MALLOC(block_size);
+      PFC_CHECK_MSG(block, ("Unable to allocate %u bytes for string interning arena\r\n", block_size));
+      shard_.arena_pos=block;
+      shard_.arena_end=block+block_size;
+      shard_.num_arena_bytes+=block_size;
+    }
+    char *s=shard_.arena_pos;
+    shard_.arena_pos+=num_bytes_;
+    return s;
+  }
+  //----
+
+  void release_retired_intern_tables(str_intern_shard &shard_)
+  {
+    // release grown-out tables if no lock-free lookups are in flight (new lookups read the current table)
+    if(!shard_.retired || atom_read(shard_.num_readers))
+      return;
+    str_intern_table *table=shard_.retired;
+    shard_.retired=0;
+    do
+    {
+      str_intern_table *next=table->next_retired;
+      shard_.num_table_bytes-=table->num_bytes;
+      PFC_HEAP_FREE(table);
+      table=next;
+    } while(table);
+  }
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // swap_bytes_simd
+  //==========================================================================
+#ifdef PFC_SWAP_BYTES_NEON
+  typedef uint8x16_t simd_bytes_t;
+  PFC_INLINE simd_bytes_t load_bytes(const uint8_t *p_)              {return vld1q_u8(p_);}
+  PFC_INLINE void store_bytes(uint8_t *p_, simd_bytes_t v_)          {vst1q_u8(p_, v_);}
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<2>)   {return vrev16q_u8(v_);}
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<4>)   {return vrev32q_u8(v_);}
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<8>)   {return vrev64q_u8(v_);}
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<16>)  {v_=vrev64q_u8(v_); return vextq_u8(v_, v_, 8);}
+#else
+  typedef __m128i simd_bytes_t;
+  PFC_INLINE simd_bytes_t load_bytes(const uint8_t *p_)              {return _mm_loadu_si128((const __m128i*)p_);}
+  PFC_INLINE void store_bytes(uint8_t *p_, simd_bytes_t v_)          {_mm_storeu_si128((__m128i*)p_, v_);}
+#ifdef PFC_PLATFORM_SSE4
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<2>)   {return _mm_shuffle_epi8(v_, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));}
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<4>)   {return _mm_shuffle_epi8(v_, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));}
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<8>)   {return _mm_shuffle_epi8(v_, _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));}
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<16>)  {return _mm_shuffle_epi8(v_, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));}
+#else
+  // SSE2: reverse 16-bit words with shuffles and swap bytes of the words with shifts
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<2>)   {return _mm_or_si128(_mm_slli_epi16(v_, 8), _mm_srli_epi16(v_, 8));}
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<4>)   {return swap_bytes(_mm_shufflehi_epi16(_mm_shufflelo_epi16(v_, 0xb1), 0xb1), meta_int<2>());}
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<8>)   {return swap_bytes(_mm_shufflehi_epi16(_mm_shufflelo_epi16(v_, 0x1b), 0x1b), meta_int<2>());}
+  PFC_INLINE simd_bytes_t swap_bytes(simd_bytes_t v_, meta_int<16>)  {return _mm_shuffle_epi32(swap_bytes(v_, meta_int<8>()), 0x4e);}
+#endif
+#endif
+  //----
+
+  template<int value_size>
+  void swap_bytes_blocks(uint8_t *p_, usize_t num_blocks_)
+  {
+    // swap bytes of values in 64 byte blocks and the rest in 16 byte blocks
+    uint8_t *end=p_+num_blocks_*16;
+    for(; p_+64<=end; p_+=64)
+    {
+      simd_bytes_t v0=load_bytes(p_), v1=load_bytes(p_+16), v2=load_bytes(p_+32), v3=load_bytes(p_+48);
+      store_bytes(p_,    swap_bytes(v0, meta_int<value_size>()));
+      store_bytes(p_+16, swap_bytes(v1, meta_int<value_size>()));
+      store_bytes(p_+32, swap_bytes(v2, meta_int<value_size>()));
+      store_bytes(p_+48, swap_bytes(v3, meta_int<value_size>()));
+    }
+    for(; p_<end; p_+=16)
+      store_bytes(p_, swap_bytes(load_bytes(p_), meta_int<value_size>()));
+  }
 } // namespace <anonymous>
 //----------------------------------------------------------------------------
 
@@ -85,6 +288,26 @@ uint32_t pfc::crc32(const char *s_, uint32_t seed_)
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// swap_bytes_simd
+//============================================================================
+usize_t pfc::priv::swap_bytes_simd(void *p_, usize_t count_, unsigned value_size_)
+{
+  // swap bytes of whole 16 byte blocks of values and return the number of swapped values
+  usize_t num_blocks=count_*value_size_/16;
+  switch(value_size_)
+  {
+    case 2: swap_bytes_blocks<2>((uint8_t*)p_, num_blocks); break;
+    case 4: swap_bytes_blocks<4>((uint8_t*)p_, num_blocks); break;
+    case 8: swap_bytes_blocks<8>((uint8_t*)p_, num_blocks); break;
+    case 16: swap_bytes_blocks<16>((uint8_t*)p_, num_blocks); break;
+    default: PFC_ERROR_NOT_IMPL();
+  }
+  return num_blocks*16/value_size_;
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // fourcc_id
 //============================================================================
@@ -101,6 +324,83 @@ uint32_t fourcc_id::filter_id32(uint32_t id32_) const
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// string interning
+//============================================================================
+const char *pfc::intern_str(const char *str_, uint32_t crc32_)
+{
+  // lock-free lookup of the string
+  PFC_ASSERT(str_);
+  str_intern_shard &shard=s_str_intern_shards[crc32_&(str_intern_num_shards-1)];
+  if(const char *s=find_interned_str(shard, str_, crc32_))
+    return s;
+
+  // check the string wasn't added by another thread before locking
+  lock_shard(shard);
+  str_intern_table *table=shard.table;
+  const char *s=find_interned_str(table, str_, crc32_);
+  if(!s)
+  {
+    // grow the table to keep load factor at most 0.5
+    if(!table || (shard.num_strings+1)*2>table->mask+1)
+    {
+      str_intern_table *new_table=alloc_intern_table(table?(table->mask+1)*2:usize_t(str_intern_min_table_size));
+      if(table)
+        for(usize_t i=0; i<=table->mask; ++i)
+          if(table->slots[i].str)
+            insert_interned_str(*new_table, table->slots[i].str, table->slots[i].crc32);
+      shard.num_table_bytes+=new_table->num_bytes;
+      atom_mov(shard.table, new_table);
+      if(table)
+      {
+        table->next_retired=shard.retired;
+        shard.retired=table;
+      }
+      table=new_table;
+    }
+
+    // copy the string to the arena and add it to the table
+    usize_t num_bytes=str_size(str_)+1;
+    char *new_str=alloc_interned_str(shard, num_bytes);
+    mem_copy(new_str, str_, num_bytes);
+    insert_interned_str(*table, new_str, crc32_);
+    ++shard.num_strings;
+    shard.num_str_bytes+=num_bytes;
+    s=new_str;
+    release_retired_intern_tables(shard);
+  }
+  unlock_shard(shard);
+  return s;
+}
+//----
+
+void pfc::get_str_intern_stats(str_intern_stats &stats_)
+{
+  // accumulate stats of all shards
+  mem_zero(&stats_, sizeof(stats_));
+  for(unsigned i=0; i<str_intern_num_shards; ++i)
+  {
+    str_intern_shard &shard=s_str_intern_shards[i];
+    lock_shard(shard);
+    stats_.num_strings+=shard.num_strings;
+    stats_.num_str_bytes+=shard.num_str_bytes;
+    stats_.num_arena_bytes+=shard.num_arena_bytes;
+    stats_.num_table_bytes+=shard.num_table_bytes;
+    unlock_shard(shard);
+  }
+}
+//----
+
+void pfc::log_str_intern_stats()
+{
+  str_intern_stats stats;
+  get_str_intern_stats(stats);
+  PFC_LOGF("Interned strings: %u (%u bytes), arenas: %u bytes, tables: %u bytes\r\n",
+           unsigned(stats.num_strings), unsigned(stats.num_str_bytes), unsigned(stats.num_arena_bytes), unsigned(stats.num_table_bytes));
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // tokenize_command_line
 //============================================================================
@@ -57,6 +57,12 @@ typedef char fourcc_cstr[5];
 #define PFC_BE_FOURCC_ID(c0__, c1__, c2__, c3__) uint32_t(uint32_t(c0__)<<24|uint32_t(c1__)<<16|uint32_t(c2__)<<8|uint32_t(c3__))
 #define PFC_LE_FOURCC_ID(c0__, c1__, c2__, c3__) uint32_t(uint32_t(c0__)|uint32_t(c1__)<<8|uint32_t(c2__)<<16|uint32_t(c3__)<<24)
 class str_id;
+enum e_str_id_intern {strid_intern};
+const char *intern_str(const char*, uint32_t crc32_);
+PFC_INLINE const char *intern_str(const char*);
+struct str_intern_stats;
+void get_str_intern_stats(str_intern_stats&);
+void log_str_intern_stats();
 // tokenization
 unsigned tokenize_command_line(char *cmd_line_, const char **tokens_, unsigned max_tokens_);
 // pair
@@ -201,6 +207,11 @@ PFC_SET_TYPE_TRAIT(fourcc_id, is_type_pod, true);
 //============================================================================
 // str_id
 //============================================================================
+// Non-interned ids reference the given string, which must outlive the id.
+// Interned ids (constructed with strid_intern) reference the canonical
+// process-wide copy of the string, thus ids of equal interned strings are
+// compared by pointer. Interned strings are never released, so interning is
+// meant for bounded sets of strings and not e.g. for names of streamed objects.
 class str_id
 {
 public:
@@ -208,8 +219,10 @@ public:
   PFC_INLINE str_id();
   PFC_INLINE str_id(const char*);
   PFC_INLINE str_id(const char*, uint32_t crc32_);
+  PFC_INLINE str_id(const char*, e_str_id_intern);
   PFC_INLINE void set(const char*);
   PFC_INLINE void set(const char*, uint32_t crc32_);
+  PFC_INLINE void set(const char*, e_str_id_intern);
   //--------------------------------------------------------------------------
 
   // comparison and accessors
@@ -230,6 +243,25 @@ PFC_SET_TYPE_TRAIT(str_id, is_type_pod_move, true);
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// str_intern_stats
+//============================================================================
+// Process-wide string interning table statistics. Strings are interned to
+// sharded open addressing tables with lock-free lookups and per-shard locked
+// inserts, and the strings are stored in per-shard arenas. Grown-out tables
+// are released once no lock-free lookups are in flight. Interned strings
+// are never released.
+struct str_intern_stats
+{
+  usize_t num_strings;      // number of interned strings
+  usize_t num_str_bytes;    // bytes of interned strings (including terminators)
+  usize_t num_arena_bytes;  // bytes allocated for string arenas
+  usize_t num_table_bytes;  // bytes allocated for hash tables (including retired tables not yet released)
+};
+PFC_SET_TYPE_TRAIT(str_intern_stats, is_type_pod, true);
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // pair
 //============================================================================
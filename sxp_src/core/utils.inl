@@ -143,6 +143,9 @@ namespace priv
   }
   //----
 
+  usize_t swap_bytes_simd(void*, usize_t count_, unsigned value_size_);
+  //----
+
   static PFC_INLINE void swap_bytes(void *p_, usize_t count_, meta_int<1>)
   {
     return;
@@ -151,9 +154,11 @@ namespace priv
 
   static PFC_INLINE void swap_bytes(void *p_, usize_t count_, meta_int<2>)
   {
-    // swap bytes for an array of values
+    // swap bytes for an array of values (bulk of the array with SIMD)
     uint16_t *p=(uint16_t*)p_, *end=p+count_;
-    if(count_)
+    if(count_>=8)
+      p+=swap_bytes_simd(p_, count_, 2);
+    if(p!=end)
       do
       {
 #ifdef PFC_INTRINSIC_BSWAP16
@@ -169,9 +174,11 @@ namespace priv
 
   static PFC_INLINE void swap_bytes(void *p_, usize_t count_, meta_int<4>)
   {
-    // swap bytes for an array of values
+    // swap bytes for an array of values (bulk of the array with SIMD)
     uint32_t *p=(uint32_t*)p_, *end=p+count_;
-    if(count_)
+    if(count_>=4)
+      p+=swap_bytes_simd(p_, count_, 4);
+    if(p!=end)
       do
       {
 #ifdef PFC_INTRINSIC_BSWAP32
@@ -187,9 +194,11 @@ namespace priv
 
   static PFC_INLINE void swap_bytes(void *p_, usize_t count_, meta_int<8>)
   {
-    // swap bytes for an array of values
+    // swap bytes for an array of values (bulk of the array with SIMD)
     uint64_t *p=(uint64_t*)p_, *end=p+count_;
-    if(count_)
+    if(count_>=2)
+      p+=swap_bytes_simd(p_, count_, 8);
+    if(p!=end)
       do
       {
 #ifdef PFC_INTRINSIC_BSWAP64
@@ -208,9 +217,11 @@ namespace priv
 
   static PFC_INLINE void swap_bytes(void *p_, usize_t count_, meta_int<16>)
   {
-    // swap bytes for an array of values
+    // swap bytes for an array of values (bulk of the array with SIMD)
     uint128_t *p=(uint128_t*)p_, *end=p+count_;
-    if(count_)
+    if(count_>=1)
+      p+=swap_bytes_simd(p_, count_, 16);
+    if(p!=end)
       do
       {
 #ifdef PFC_INTRINSIC_BSWAP64
@@ -1124,6 +1135,16 @@ void fourcc_id::c_str(fourcc_cstr str_) const
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// intern_str
+//============================================================================
+PFC_INLINE const char *intern_str(const char *str_)
+{
+  return intern_str(str_, pfc::crc32(str_));
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // str_id
 //============================================================================
@@ -1148,6 +1169,13 @@ str_id::str_id(const char *str_, uint32_t crc32_)
 }
 //----
 
+str_id::str_id(const char *str_, e_str_id_intern)
+  :m_crc32(pfc::crc32(str_))
+{
+  m_str=intern_str(str_, m_crc32);
+}
+//----
+
 void str_id::set(const char *str_)
 {
   m_crc32=pfc::crc32(str_);
@@ -1160,17 +1188,24 @@ void str_id::set(const char *str_, uint32_t crc32_)
   m_crc32=crc32_;
   m_str=str_;
 }
+//----
+
+void str_id::set(const char *str_, e_str_id_intern)
+{
+  m_crc32=pfc::crc32(str_);
+  m_str=intern_str(str_, m_crc32);
+}
 //----------------------------------------------------------------------------
 
 bool str_id::operator==(const str_id &id_) const
 {
-  return m_crc32==id_.m_crc32 && str_eq(m_str, id_.m_str);
+  return m_crc32==id_.m_crc32 && (m_str==id_.m_str || str_eq(m_str, id_.m_str));
 }
 //----
 
 bool str_id::operator!=(const str_id &id_) const
 {
-  return m_crc32!=id_.m_crc32 || !str_eq(m_str, id_.m_str);
+  return m_crc32!=id_.m_crc32 || (m_str!=id_.m_str && !str_eq(m_str, id_.m_str));
 }
 //----
 
@@ -50,6 +50,7 @@ void collada_info::parse_asset_properties(xml_input_stream &stream_, string_t &i
 // collada_data
 //============================================================================
 collada_data::collada_data()
+  :m_name_allocator(16384, 1024, true)
 {
 }
 //----
@@ -84,7 +85,11 @@ void collada_data::parse_data_source(xml_input_stream &stream_, string_t &item_n
       stream_.find_attrib("count", num_names);
       arr.data.resize(num_names);
       for(unsigned i=0; i<num_names; ++i)
+      {
+        // allocate long names from the arena released with the data
+        arr.data[i].set_allocator(&m_name_allocator);
         stream_.read_word(arr.data[i]);
+      }
       stream_.skip_element();
     }
     else if(item_name_=="technique_common")
@@ -104,7 +109,7 @@ void collada_data::parse_data_source(xml_input_stream &stream_, string_t &item_n
 }
 //----
 
-void collada_data::parse_source_input_attribs(array<source_input> &inputs_, xml_input_stream &stream_, string_t &item_name_)
+void collada_data::parse_source_input_attribs(source_input_array_t &inputs_, xml_input_stream &stream_, string_t &item_name_)
 {
   // parse "input" attributes
   source_input input;
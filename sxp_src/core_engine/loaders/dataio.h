@@ -15,6 +15,7 @@
 //============================================================================
 // external
 #include "sxp_src/core/math/math.h"
+#include "sxp_src/core/memory.h"
 #include "sxp_src/core/xml.h"
 namespace pfc
 {
@@ -127,6 +128,7 @@ public:
   template<typename> struct data_array;
   struct source;
   struct source_input;
+  typedef small_array<source_input, 8> source_input_array_t;
   //--------------------------------------------------------------------------
 
   // construction
@@ -136,7 +138,7 @@ public:
 
   // data parsing
   void parse_data_source(xml_input_stream&, string_t&);
-  void parse_source_input_attribs(array<source_input>&, xml_input_stream&, string_t&);
+  void parse_source_input_attribs(source_input_array_t&, xml_input_stream&, string_t&);
   //--------------------------------------------------------------------------
 
   // data accessors
@@ -161,6 +163,7 @@ private:
   e_collada_input_semantic_type input_semantic_type(e_collada_input_semantic);
   //--------------------------------------------------------------------------
 
+  sequential_memory_allocator m_name_allocator;
   deque<data_array<float> > m_data_array_float;
   deque<data_array<heap_str> > m_data_array_name;
   array<source> m_sources;
@@ -211,7 +214,7 @@ struct collada_data::source
   //--------------------------------------------------------------------------
 
   heap_str id;
-  array<source_input> inputs;
+  source_input_array_t inputs;
 };
 //----------------------------------------------------------------------------
 
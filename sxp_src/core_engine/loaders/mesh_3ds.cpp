@@ -591,7 +591,7 @@ void mesh_loader_3ds::generate_mesh(mesh &mesh_)
     max_valence=max(max_valence, vflists[i].second);
 
   // smooth the mesh and duplicate vertices when necessary
-  array<mat33f> face_smooths(max_valence), vtx_smooths(max_valence);
+  small_array<mat33f, 16> face_smooths(max_valence), vtx_smooths(max_valence);
   mat33f *fsmooths=face_smooths.data(), *vsmooths=vtx_smooths.data();
   unsigned num_generated_vertices=0;
   for(unsigned i=0; i<num_verts; ++i)
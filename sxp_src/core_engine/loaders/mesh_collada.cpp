@@ -50,7 +50,7 @@ private:
     geometry *geo;
     bool is_processed;
     heap_str material_name;
-    array<collada_data::source_input> inputs;
+    collada_data::source_input_array_t inputs;
     e_primitive_type primitive_type;
     unsigned start_index;
     unsigned num_primitives;
@@ -233,7 +233,7 @@ private:
   void parse_controllers(xml_input_stream&, string_t&);
   void parse_visual_scenes(xml_input_stream&, string_t&);
   void parse_node(xml_input_stream&, string_t&, int parent_idx_);
-  unsigned num_source_inputs(const array<collada_data::source_input>&);
+  unsigned num_source_inputs(const collada_data::source_input_array_t&);
   //--------------------------------------------------------------------------
 
   // mesh generation
@@ -535,7 +535,7 @@ void mesh_loader_collada::parse_controllers(xml_input_stream &stream_, string_t
         else if(item_name_=="joints")
         {
           // parse "joints" elements
-          array<collada_data::source_input> inputs;
+          collada_data::source_input_array_t inputs;
           stream_.skip_attribs();
           while(stream_.parse_element(item_name_))
           {
@@ -572,7 +572,7 @@ void mesh_loader_collada::parse_controllers(xml_input_stream &stream_, string_t
           // parse "vertex_weights" attributes and elements
           unsigned num_verts=0;
           stream_.find_attrib("count", num_verts);
-          array<collada_data::source_input> inputs;
+          collada_data::source_input_array_t inputs;
           array<unsigned> influence_counts;
           while(stream_.parse_element(item_name_))
           {
@@ -599,7 +599,7 @@ void mesh_loader_collada::parse_controllers(xml_input_stream &stream_, string_t
               const float *data_weight=geo->data.float_array(input_weight->array_index).data.data();
 
               // setup joint influences for vertices
-              array<unsigned> index_sp(num_inf_indices);
+              small_array<unsigned, 8> index_sp(num_inf_indices);
               unsigned *indices=index_sp.data();
               geo->vertex_joint_influences.resize(num_verts);
               mem_zero(geo->vertex_joint_influences.data(), sizeof(vertex_influence)*num_verts);
@@ -774,7 +774,7 @@ void mesh_loader_collada::parse_node(xml_input_stream &stream_, string_t &item_n
 }
 //----------------------------------------------------------------------------
 
-unsigned mesh_loader_collada::num_source_inputs(const array<collada_data::source_input> &inputs_)
+unsigned mesh_loader_collada::num_source_inputs(const collada_data::source_input_array_t &inputs_)
 {
   // get max input offset
   const collada_data::source_input *inputs=inputs_.data();
@@ -1106,7 +1106,7 @@ void mesh_loader_collada::generate_mesh(mesh &mesh_)
 
     // process all mesh points
     geo->num_total_vertices=0;
-    array<vertex> point_vertices(max_valence);
+    small_array<vertex, 16> point_vertices(max_valence);
     vertex *pnt_verts=point_vertices.data();
     const point *points=points_sp.data();
     for(unsigned pi=0; pi<num_points; ++pi)
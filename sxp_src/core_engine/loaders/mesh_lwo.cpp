@@ -402,15 +402,23 @@ void mesh_loader_lwo::parse_points(endian_input_stream &stream_, unsigned size_)
   PFC_CHECK_MSG(!l.points.size(), ("Points already defined for the LWO layer\r\n"));
   unsigned num_points=size_/12;
   l.points.resize(num_points);
-  point *points=l.points.data();
-  for(unsigned i=0; i<num_points; ++i)
+  point *points=l.points.data(), *points_end=points+num_points;
+  m_num_points_total+=num_points;
+  enum {block_size=256};
+  vec3f block[block_size];
+  while(points!=points_end)
   {
-    point &pnt=points[i];
-    stream_>>pnt.position;
-    pnt.first_polygon_idx=uint32_t(-1);
-    pnt.first_polygon_vtx_idx=0;
-    pnt.valence=0;
-    ++m_num_points_total;
+    // read block of coordinates with a single bulk read & swap and init the points
+    unsigned num_block_points=min<unsigned>(unsigned(points_end-points), block_size);
+    stream_.read(&block[0].x, num_block_points*3);
+    for(unsigned i=0; i<num_block_points; ++i)
+    {
+      point &pnt=*points++;
+      pnt.position=block[i];
+      pnt.first_polygon_idx=uint32_t(-1);
+      pnt.first_polygon_vtx_idx=0;
+      pnt.valence=0;
+    }
   }
 }
 //----
@@ -871,7 +879,7 @@ void mesh_loader_lwo::generate_mesh(mesh &mesh_)
   }
 
   // process all layers
-  array<smoother> point_face_smoothers_sp, point_vertex_smoothers_sp;
+  small_array<smoother, 16> point_face_smoothers_sp, point_vertex_smoothers_sp;
   unsigned num_points_total=0;
   unsigned num_vertices_total=0;
   unsigned num_layers=(unsigned)m_layers.size();
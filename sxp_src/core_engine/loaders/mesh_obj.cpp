@@ -415,8 +415,8 @@ void mesh_loader_obj::generate_mesh(mesh &mesh_)
 
   // setup data pointers for mesh generation
   typedef pair<mat33f, unsigned> face_tbn_t;
-  array<face_tbn_t> face_tbns_sp(m_max_valence);
-  array<smoother> vertex_smoothers_sp(m_max_valence);
+  small_array<face_tbn_t, 16> face_tbns_sp(m_max_valence);
+  small_array<smoother, 16> vertex_smoothers_sp(m_max_valence);
   face_tbn_t *face_tbns=face_tbns_sp.data();
   smoother *vertex_smoothers=vertex_smoothers_sp.data();
   const point *points=m_points.data();
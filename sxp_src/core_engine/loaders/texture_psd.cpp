@@ -403,6 +403,16 @@ bool texture_loader_psd::decode_layer(void *dst_, unsigned layer_idx_, unsigned
         case 3: PFC_WARN("PDF: Image decompression \"ZIP with prediction\" not implemented\r\n"); return false;
         default: PFC_WARNF("PDF: Unknown image compression type (%i)\r\n", chl.compression_type); return false;
       }
+
+      // convert big-endian 16/32bpc channel data to native endianness
+      if(!PFC_BIG_ENDIAN)
+      {
+        uint8_t *chl_scanline=(uint8_t*)m_scanline_scratchpad.data+chl_data_idx*m_scanline_scratchpad_channel_size;
+        if(m_bpc==16)
+          swap_bytes((uint16_t*)chl_scanline, layer_width);
+        else if(m_bpc==32)
+          swap_bytes((uint32_t*)chl_scanline, layer_width);
+      }
     }
 
     // check scanline bounds
@@ -45,7 +45,7 @@ private:
     //------------------------------------------------------------------------
 
     heap_str id;
-    array<collada_data::source_input> inputs;
+    collada_data::source_input_array_t inputs;
   };
   //--------------------------------------------------------------------------
 
@@ -422,7 +422,7 @@ void track_set_loader_collada::generate_track_set(track_set &tset_)
     while(achl)
     {
       // get channel input (time) data
-      typedef array<collada_data::source_input>::const_iterator input_iterator_t;
+      typedef collada_data::source_input_array_t::const_iterator input_iterator_t;
       const sampler &smp=m_samplers[achl->sampler_idx];
       input_iterator_t input_it=linear_search(smp.inputs.begin(), smp.inputs.end(), collsemantic_input);
       PFC_CHECK_MSG(input_it, ("No input data available for the channel\r\n"));
@@ -716,7 +716,7 @@ template<typename T>
 void track_set_loader_collada::apply_uniform_samples(T *channel_data_, unsigned stride_, const anim_channel &achl_, unsigned start_frame_, unsigned num_frames_)
 {
   // access animation channel data
-  typedef array<collada_data::source_input>::const_iterator input_iterator_t;
+  typedef collada_data::source_input_array_t::const_iterator input_iterator_t;
   const sampler &smp=m_samplers[achl_.sampler_idx];
   input_iterator_t input_it=linear_search(smp.inputs.begin(), smp.inputs.end(), collsemantic_input);
   PFC_CHECK_MSG(input_it, ("No input data available for the channel\r\n"));
@@ -10,8 +10,11 @@
 #include "sxp_src/core/fsys/fsys.h"
 #include "sxp_src/core/math/tform3.h"
 #include "sxp_src/core/math/color.h"
+#include "sxp_src/core/math/bvh3.h"
 #include "sxp_src/core/sort.h"
 #include "sxp_src/core/class.h"
+#include "sxp_src/core/mp/mp_job_queue.h"
+#include <xmmintrin.h>
 #ifdef PFC_ENGINEOP_NVTRISTRIP
 #include "sxp_extlibs/nvtristrip/src/NvTriStrip.h"
 #endif
@@ -147,6 +150,7 @@ owner_ptr<mesh> pfc::load_mesh(bin_input_stream_base &stream_)
 owner_ptr<mesh> pfc::load_mesh(const char *filename_, const char *path_)
 {
   // try to load a mesh file
+  PFC_PERF_TRACE_SCOPE("load_mesh", "file", filename_);
   owner_ptr<bin_input_stream_base> f=afs_open_read(filename_, path_);
   if(!f.data)
   {
@@ -227,35 +231,60 @@ bool pfc::is_collision_subobject(const char *subobject_name_)
 
 
 //============================================================================
-// random_mesh_surface_tforms
+// mesh_surface_sampler
 //============================================================================
-struct probability_surface_tri
+namespace
 {
-  PFC_INLINE bool operator<(float p_) const
-  {
-    return p_end<p_;
-  }
-  //----
+  enum {surface_sampler_block_size=4096};  // number of transforms generated with a single rng stream
+  //--------------------------------------------------------------------------
 
-  PFC_INLINE bool operator==(float p_) const
+  PFC_INLINE uint32_t surface_sampler_block_seed(uint32_t seed_, uint32_t block_idx_)
   {
-    return p_>=p_start && p_<=p_end;
+    // hash seed and block index to decorrelated rng stream seed
+    uint32_t h=seed_*0x9e3779b9^block_idx_;
+    h^=h>>16;
+    h*=0x85ebca6b;
+    h^=h>>13;
+    h*=0xc2b2ae35;
+    h^=h>>16;
+    return h;
   }
-  //--------------------------------------------------------------------------
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
 
-  vec3f p0, p1, p2;
-  vec3f n0, n1, n2;
-  ufloat_t p_start, p_end;  // probability range [p_start, p_end[
+struct mesh_surface_sampler::gen_task
+{
+  const mesh_surface_sampler *sampler;
+  tform_rt3f *tforms;
+  unsigned num_tforms;
+  unsigned first_block, end_block;
+  unsigned seed;
 };
 //----------------------------------------------------------------------------
 
-void pfc::random_mesh_surface_tforms(array<tform_rt3f> &tforms_, const mesh &mesh_, unsigned num_tforms_, unsigned seed_)
+mesh_surface_sampler::mesh_surface_sampler()
 {
-  // generate triangles with probabilities based on triangle areas
-  deque<probability_surface_tri> tris;
+  m_surface_area=0.0f;
+}
+//----
+
+mesh_surface_sampler::mesh_surface_sampler(const mesh &mesh_)
+{
+  m_surface_area=0.0f;
+  init(mesh_);
+}
+//----
+
+void mesh_surface_sampler::init(const mesh &mesh_)
+{
+  // gather triangles of the mesh (reuses memory of previous init)
+  PFC_PERF_TIMER_AUTO(mesh_surface_sampler_init, "geometry", "mesh_surface_sampler::init()");
+  m_tris.resize_to_zero();
+  m_alias_table.resize_to_zero();
+  m_surface_area=0.0f;
+  array<float> areas;
   const uint32_t *indices=mesh_.indices();
   unsigned num_segments=mesh_.num_segments();
-  udouble_t prob_total=0.0;
   for(unsigned si=0; si<num_segments; ++si)
   {
     // get vertex channel data for the segment
@@ -271,31 +300,33 @@ void pfc::random_mesh_surface_tforms(array<tform_rt3f> &tforms_, const mesh &mes
       case meshprim_trilist:
       {
         unsigned num_prims=seg.num_primitives;
+        usize_t base=m_tris.size();
+        m_tris.insert_back(num_prims);
+        areas.insert_back(num_prims);
+        tri *tris=m_tris.data()+base;
+        float *tri_areas=areas.data()+base;
         for(unsigned i=0; i<num_prims; ++i)
         {
           // setup triangle vertex positions and normals
-          probability_surface_tri tri;
+          tri &t=tris[i];
           unsigned i0=indices[seg.prim_start_index+i*3+0];
           unsigned i1=indices[seg.prim_start_index+i*3+1];
           unsigned i2=indices[seg.prim_start_index+i*3+2];
-          tri.p0=chl_pos[i0];
-          tri.p1=chl_pos[i1];
-          tri.p2=chl_pos[i2];
-          vec3f normal=cross(tri.p1-tri.p0, tri.p2-tri.p0);
+          t.p0=chl_pos[i0];
+          t.p1=chl_pos[i1];
+          t.p2=chl_pos[i2];
+          vec3f normal=cross(t.p1-t.p0, t.p2-t.p0);
           if(chl_nrm)
           {
-            tri.n0=chl_nrm[i0];
-            tri.n1=chl_nrm[i1];
-            tri.n2=chl_nrm[i2];
+            t.n0=chl_nrm[i0];
+            t.n1=chl_nrm[i1];
+            t.n2=chl_nrm[i2];
           }
           else
-            tri.n0=tri.n1=tri.n2=unit_z(normal);
+            t.n0=t.n1=t.n2=unit_z(normal);
 
-          // calculate triangle probability weight (area) and store the triangle
-          tri.p_start=0.0f;
-          tri.p_end=norm(normal);
-          prob_total+=tri.p_end;
-          tris.push_back(tri);
+          // triangle probability weight (area)
+          tri_areas[i]=norm(normal)*0.5f;
         }
       } break;
 
@@ -311,47 +342,212 @@ void pfc::random_mesh_surface_tforms(array<tform_rt3f> &tforms_, const mesh &mes
     }
   }
 
-  // check for triangles for transformation generation
-  unsigned num_tris=(unsigned)tris.size();
+  // check for triangles
+  unsigned num_tris=(unsigned)m_tris.size();
   if(!num_tris)
     return;
-
-  // calculate normalized probability ranges for triangles
-  udouble_t inv_prop_total=rcp_z(prob_total);
-  udouble_t prob_sum=0.0;
+  udouble_t area_total=0.0;
+  for(unsigned i=0; i<num_tris; ++i)
+    area_total+=areas[i];
+  m_surface_area=float(area_total);
+
+  // build alias table with Vose's method: split triangles to ones with scaled
+  // probability below and above average and pair each small one with a large
+  m_alias_table.resize(num_tris);
+  alias_entry *table=m_alias_table.data();
+  array<uint32_t> work(num_tris);
+  uint32_t *stack=work.data();  // small entries from the start and large from the end
+  unsigned num_small=0, num_large=0;
+  double scale=area_total>0.0?double(num_tris)/area_total:0.0;
   for(unsigned i=0; i<num_tris; ++i)
   {
-    tris[i].p_start=ufloat_t(prob_sum);
-    prob_sum+=tris[i].p_end*inv_prop_total;
-    tris[i].p_end=ufloat_t(prob_sum);
+    float p=area_total>0.0?float(areas[i]*scale):1.0f;
+    areas[i]=p;
+    if(p<1.0f)
+      stack[num_small++]=i;
+    else
+      stack[num_tris-++num_large]=i;
+  }
+  while(num_small && num_large)
+  {
+    uint32_t s=stack[--num_small], l=stack[num_tris-num_large];
+    table[s].prob=areas[s];
+    table[s].alias=l;
+    areas[l]=(areas[l]+areas[s])-1.0f;
+    if(areas[l]<1.0f)
+    {
+      --num_large;
+      stack[num_small++]=l;
+    }
   }
-  tris[num_tris-1].p_end=2.0f;
 
-  // generate transforms on the mesh using the triangles
-  rng_simple rng(seed_);
+  // remaining entries have probability 1 (small ones only due to rounding errors)
+  while(num_large)
+  {
+    uint32_t l=stack[num_tris-num_large--];
+    table[l].prob=1.0f;
+    table[l].alias=l;
+  }
+  while(num_small)
+  {
+    uint32_t s=stack[--num_small];
+    table[s].prob=1.0f;
+    table[s].alias=s;
+  }
+}
+//----
+
+void mesh_surface_sampler::clear()
+{
+  m_tris.clear();
+  m_alias_table.clear();
+  m_surface_area=0.0f;
+}
+//----------------------------------------------------------------------------
+
+tform_rt3f mesh_surface_sampler::sample_tform(rng_simple &rng_) const
+{
+  // pick random triangle from the alias table (even distribution on mesh)
+  PFC_ASSERT_MSG(m_tris.size(), ("Sampling surface of a mesh without triangles\r\n"));
+  uint32_t r=uint32_t(rng_.rand_uint16())<<16|rng_.rand_uint16();
+  uint32_t idx=uint32_t((uint64_t(r)*m_alias_table.size())>>32);
+  const alias_entry &e=m_alias_table[idx];
+  if(rng_.rand_ureal1()>=e.prob)
+    idx=e.alias;
+  const tri &t=m_tris[idx];
+
+  // calculate random barycentric coordinates for the triangle
+  ufloat1_t a=rng_.rand_ureal1();
+  ufloat1_t b=rng_.rand_ureal1();
+  if(a+b>1.0f)
+  {
+    a=1.0f-a;
+    b=1.0f-b;
+  }
+  ufloat1_t c=1.0f-a-b;
+
+  // calculate transformation by using the coordinates
+  vec3f pos=t.p0*a+t.p1*b+t.p2*c;
+  vec3f normal=unit_z(t.n0*a+t.n1*b+t.n2*c);
+  return tform_rt3f(zrot_u(normal), pos);
+}
+//----
+
+void mesh_surface_sampler::generate_tforms(array<tform_rt3f> &tforms_, unsigned num_tforms_, unsigned seed_) const
+{
   tforms_.resize(num_tforms_);
-  for(unsigned i=0; i<num_tforms_; ++i)
+  generate_tforms(tforms_.data(), num_tforms_, seed_);
+}
+//----
+
+void mesh_surface_sampler::generate_tforms(tform_rt3f *tforms_, unsigned num_tforms_, unsigned seed_) const
+{
+  // generate transforms in blocks with own rng streams (in parallel if job queue is active)
+  PFC_PERF_TIMER_AUTO(mesh_surface_sampler_generate, "geometry", "mesh_surface_sampler::generate_tforms()");
+  if(!num_tforms_ || !m_tris.size())
+    return;
+  unsigned num_blocks=(num_tforms_+surface_sampler_block_size-1)/surface_sampler_block_size;
+  if(!mp_job_queue::has_active() || num_blocks<2)
   {
-    // get random triangle by using probabilities (even distribution on mesh)
-    deque<probability_surface_tri>::iterator it=binary_search(tris.begin(), num_tris, rng.rand_ureal1());
-    PFC_ASSERT(is_valid(it));
-    const probability_surface_tri &tri=*it;
+    generate_blocks(tforms_, num_tforms_, 0, num_blocks, seed_);
+    return;
+  }
+  mp_job_queue &jq=mp_job_queue::active();
+  e_jobtype_id job_type=jq.find_or_create_job_type("mesh_surface_sampler generate", &gen_job);
+  volatile uint32_t job_counter=0;
+  array<gen_task> tasks(min(num_blocks, (jq.num_worker_threads()+1)*4));
+  unsigned num_tasks=(unsigned)tasks.size();
+  for(unsigned i=0; i<num_tasks; ++i)
+  {
+    gen_task &task=tasks[i];
+    task.sampler=this;
+    task.tforms=tforms_;
+    task.num_tforms=num_tforms_;
+    task.first_block=num_blocks*i/num_tasks;
+    task.end_block=num_blocks*(i+1)/num_tasks;
+    task.seed=seed_;
+    jq.add_job(job_type, &task, job_counter);
+  }
+  jq.wait_jobs(job_counter);
+}
+//----------------------------------------------------------------------------
+
+void mesh_surface_sampler::generate_blocks(tform_rt3f *tforms_, unsigned num_tforms_, unsigned first_block_, unsigned end_block_, unsigned seed_) const
+{
+  for(unsigned bi=first_block_; bi<end_block_; ++bi)
+  {
+    rng_simple rng(surface_sampler_block_seed(seed_, bi));
+    unsigned start=bi*surface_sampler_block_size;
+    unsigned end=min<unsigned>(start+surface_sampler_block_size, num_tforms_);
+    for(unsigned i=start; i<end; ++i)
+      tforms_[i]=sample_tform(rng);
+  }
+}
+//----
+
+void mesh_surface_sampler::gen_job(gen_task *task_, void*)
+{
+  task_->sampler->generate_blocks(task_->tforms, task_->num_tforms, task_->first_block, task_->end_block, task_->seed);
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// random_mesh_surface_tforms
+//============================================================================
+void pfc::random_mesh_surface_tforms(array<tform_rt3f> &tforms_, const mesh &mesh_, unsigned num_tforms_, unsigned seed_)
+{
+  // generate transforms with temporary sampler (use mesh_surface_sampler to reuse the sampler)
+  mesh_surface_sampler sampler(mesh_);
+  if(sampler.num_triangles())
+    sampler.generate_tforms(tforms_, num_tforms_, seed_);
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// init_mesh_surface_bvh
+//============================================================================
+void pfc::init_mesh_surface_bvh(triangle_mesh_bvh3 &bvh_, const mesh &mesh_, unsigned max_leaf_tris_)
+{
+  // gather positions of used vertex buffers and triangle indices of triangle list segments
+  // note: triangle indices of the BVH run over triangle list segments in the segment order
+  PFC_PERF_TIMER_AUTO(init_mesh_surface_bvh, "geometry", "init_mesh_surface_bvh()");
+  array<vec3f> points;
+  array<uint32_t> tri_indices;
+  array<uint32_t> vbuf_offsets(mesh_.num_vertex_buffers(), uint32_t(-1));
+  const uint32_t *indices=mesh_.indices();
+  unsigned num_segments=mesh_.num_segments();
+  for(unsigned si=0; si<num_segments; ++si)
+  {
+    const mesh_segment &seg=mesh_.segment(si);
+    if(seg.primitive_type!=meshprim_trilist)
+    {
+      PFC_WARNF("Skipping segment using primitive \"%s\"\r\n", enum_string(seg.primitive_type));
+      continue;
+    }
 
-    // calculate random barycentric coordinates for the triangle
-    ufloat1_t a=rng.rand_ureal1();
-    ufloat1_t b=rng.rand_ureal1();
-    if(a+b>1.0f)
+    // add segment vertex buffer positions (once per buffer)
+    uint32_t &vbuf_offs=vbuf_offsets[seg.vertex_buffer];
+    if(vbuf_offs==uint32_t(-1))
     {
-      a=1.0f-a;
-      b=1.0f-b;
+      const mesh_vertex_buffer &vbuf=mesh_.vertex_buffer(seg.vertex_buffer);
+      const vec3f *chl_pos=(const vec3f*)vbuf.vertex_channel(vtxchannel_position);
+      PFC_CHECK_MSG(chl_pos, ("Mesh vertex buffer doesn't have position channel\r\n"));
+      vbuf_offs=uint32_t(points.size());
+      points.insert_back(vbuf.num_vertices(), chl_pos);
     }
-    ufloat1_t c=1.0f-a-b;
 
-    // calculate transformation by using the coordinates
-    vec3f pos=tri.p0*a+tri.p1*b+tri.p2*c;
-    vec3f normal=unit_z(tri.n0*a+tri.n1*b+tri.n2*c);
-    tforms_[i].set(zrot_u(normal), pos);
+    // add segment triangles
+    const uint32_t *seg_indices=indices+seg.prim_start_index;
+    unsigned num_seg_indices=seg.num_primitives*3;
+    usize_t tri_base=tri_indices.size();
+    tri_indices.insert_back(num_seg_indices);
+    uint32_t *dst=tri_indices.data()+tri_base;
+    for(unsigned i=0; i<num_seg_indices; ++i)
+      dst[i]=seg_indices[i]+vbuf_offs;
   }
+  bvh_.init(points.data(), points.size(), tri_indices.data(), tri_indices.size()/3, max_leaf_tris_);
 }
 //----------------------------------------------------------------------------
 
@@ -359,21 +555,298 @@ void pfc::random_mesh_surface_tforms(array<tform_rt3f> &tforms_, const mesh &mes
 //============================================================================
 // transform_joints_j2p_to_b2o
 //============================================================================
+namespace
+{
+  //==========================================================================
+  // simd_tforms4
+  //==========================================================================
+  // 4 transforms in SoA layout
+  struct simd_tforms4
+  {
+    __m128 qx, qy, qz, qw;
+    __m128 tx, ty, tz;
+  };
+  //--------------------------------------------------------------------------
+
+  PFC_INLINE __m128 load_vec3(const vec3f &v_)
+  {
+    // load vec3f without reading past its end
+    return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)&v_.x), _mm_load_ss(&v_.z));
+  }
+  //----
+
+  PFC_INLINE void store_vec3(vec3f &v_, __m128 x_)
+  {
+    _mm_storel_pi((__m64*)&v_.x, x_);
+    _mm_store_ss(&v_.z, _mm_movehl_ps(x_, x_));
+  }
+  //----
+
+  PFC_INLINE void load_tforms4(simd_tforms4 &res_, const tform_rt3f &t0_, const tform_rt3f &t1_, const tform_rt3f &t2_, const tform_rt3f &t3_)
+  {
+    // gather 4 transforms to SoA layout
+    res_.qx=_mm_loadu_ps(&t0_.rotation.x);
+    res_.qy=_mm_loadu_ps(&t1_.rotation.x);
+    res_.qz=_mm_loadu_ps(&t2_.rotation.x);
+    res_.qw=_mm_loadu_ps(&t3_.rotation.x);
+    _MM_TRANSPOSE4_PS(res_.qx, res_.qy, res_.qz, res_.qw);
+    __m128 t3;
+    res_.tx=load_vec3(t0_.translation);
+    res_.ty=load_vec3(t1_.translation);
+    res_.tz=load_vec3(t2_.translation);
+    t3=load_vec3(t3_.translation);
+    _MM_TRANSPOSE4_PS(res_.tx, res_.ty, res_.tz, t3);
+  }
+  //----
+
+  PFC_INLINE void store_tforms4(tform_rt3f &t0_, tform_rt3f &t1_, tform_rt3f &t2_, tform_rt3f &t3_, const simd_tforms4 &t_)
+  {
+    // scatter 4 transforms from SoA layout (t3_ is stored last, so it can alias the others)
+    __m128 q0=t_.qx, q1=t_.qy, q2=t_.qz, q3=t_.qw;
+    _MM_TRANSPOSE4_PS(q0, q1, q2, q3);
+    __m128 v0=t_.tx, v1=t_.ty, v2=t_.tz, v3=_mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+    _mm_storeu_ps(&t0_.rotation.x, q0);
+    store_vec3(t0_.translation, v0);
+    _mm_storeu_ps(&t1_.rotation.x, q1);
+    store_vec3(t1_.translation, v1);
+    _mm_storeu_ps(&t2_.rotation.x, q2);
+    store_vec3(t2_.translation, v2);
+    _mm_storeu_ps(&t3_.rotation.x, q3);
+    store_vec3(t3_.translation, v3);
+  }
+  //----
+
+  PFC_INLINE void mul_tforms4(simd_tforms4 &tr_, const simd_tforms4 &t_)
+  {
+    // multiply 4 transforms by 4 transforms (same operation order as tform_rt3f::operator*=)
+    __m128 qx=_mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(t_.qy, tr_.qz), _mm_mul_ps(t_.qz, tr_.qy)), _mm_mul_ps(t_.qw, tr_.qx)), _mm_mul_ps(t_.qx, tr_.qw));
+    __m128 qy=_mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(t_.qz, tr_.qx), _mm_mul_ps(t_.qx, tr_.qz)), _mm_mul_ps(t_.qw, tr_.qy)), _mm_mul_ps(t_.qy, tr_.qw));
+    __m128 qz=_mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(t_.qx, tr_.qy), _mm_mul_ps(t_.qy, tr_.qx)), _mm_mul_ps(t_.qw, tr_.qz)), _mm_mul_ps(t_.qz, tr_.qw));
+    __m128 qw=_mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(t_.qw, tr_.qw), _mm_mul_ps(t_.qx, tr_.qx)), _mm_mul_ps(t_.qy, tr_.qy)), _mm_mul_ps(t_.qz, tr_.qz));
+    __m128 sx=_mm_add_ps(_mm_sub_ps(_mm_mul_ps(t_.qy, tr_.tz), _mm_mul_ps(t_.qz, tr_.ty)), _mm_mul_ps(t_.qw, tr_.tx));
+    __m128 sy=_mm_add_ps(_mm_sub_ps(_mm_mul_ps(t_.qz, tr_.tx), _mm_mul_ps(t_.qx, tr_.tz)), _mm_mul_ps(t_.qw, tr_.ty));
+    __m128 sz=_mm_add_ps(_mm_sub_ps(_mm_mul_ps(t_.qx, tr_.ty), _mm_mul_ps(t_.qy, tr_.tx)), _mm_mul_ps(t_.qw, tr_.tz));
+    __m128 two=_mm_set1_ps(2.0f);
+    tr_.tx=_mm_add_ps(_mm_add_ps(tr_.tx, _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(t_.qy, sz), _mm_mul_ps(t_.qz, sy)))), t_.tx);
+    tr_.ty=_mm_add_ps(_mm_add_ps(tr_.ty, _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(t_.qz, sx), _mm_mul_ps(t_.qx, sz)))), t_.ty);
+    tr_.tz=_mm_add_ps(_mm_add_ps(tr_.tz, _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(t_.qx, sy), _mm_mul_ps(t_.qy, sx)))), t_.tz);
+    tr_.qx=qx;
+    tr_.qy=qy;
+    tr_.qz=qz;
+    tr_.qw=qw;
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
 void pfc::transform_joints_j2p_to_b2o(tform_rt3f *tforms_, const mesh_skeleton &skel_)
 {
   // construct bind->joint->object space transforms for joint->parent transforms
   PFC_PERF_TIMER_AUTO(transform_joints_j2p_to_b2o, "animation", "transform_joints_j2p_to_b2o()");
   unsigned num_joints=(unsigned)skel_.joints.size();
+  if(!num_joints)
+    return;
   const mesh_skeleton::joint *joints=skel_.joints.data();
   float scale=skel_.scale;
   tforms_[0].translation*=scale;
-  for(unsigned i=1; i<num_joints; ++i)
+
+  // concatenate joint->parent transforms to joint->object transforms 4 joints at the time
+  // (groups of joints whose parents precede the group, otherwise one joint at the time)
+  __m128 vscale=_mm_set1_ps(scale);
+  unsigned i=1;
+  while(i<num_joints)
   {
-    tforms_[i].translation*=scale;
-    tforms_[i]*=tforms_[joints[i].parent_idx];
+    unsigned group_size=1;
+    while(group_size<4 && i+group_size<num_joints && joints[i+group_size].parent_idx<i)
+      ++group_size;
+    if(group_size<4)
+    {
+      for(unsigned gi=0; gi<group_size; ++gi, ++i)
+      {
+        tforms_[i].translation*=scale;
+        tforms_[i]*=tforms_[joints[i].parent_idx];
+      }
+      continue;
+    }
+    simd_tforms4 t, tp;
+    load_tforms4(t, tforms_[i], tforms_[i+1], tforms_[i+2], tforms_[i+3]);
+    load_tforms4(tp, tforms_[joints[i].parent_idx], tforms_[joints[i+1].parent_idx], tforms_[joints[i+2].parent_idx], tforms_[joints[i+3].parent_idx]);
+    t.tx=_mm_mul_ps(t.tx, vscale);
+    t.ty=_mm_mul_ps(t.ty, vscale);
+    t.tz=_mm_mul_ps(t.tz, vscale);
+    mul_tforms4(t, tp);
+    store_tforms4(tforms_[i], tforms_[i+1], tforms_[i+2], tforms_[i+3], t);
+    i+=4;
   }
+
+  // apply object->joint bind transforms
+  for(i=0; i<num_joints; i+=4)
+  {
+    unsigned j0=i, j1=min(i+1, num_joints-1), j2=min(i+2, num_joints-1), j3=min(i+3, num_joints-1);
+    simd_tforms4 t, tb;
+    load_tforms4(t, tforms_[j0], tforms_[j1], tforms_[j2], tforms_[j3]);
+    load_tforms4(tb, joints[j0].bind_o2j, joints[j1].bind_o2j, joints[j2].bind_o2j, joints[j3].bind_o2j);
+    mul_tforms4(tb, t);
+    store_tforms4(tforms_[j0], tforms_[j1], tforms_[j2], tforms_[j3], tb);
+  }
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// skin_mesh_segment/skin_meshes
+//============================================================================
+namespace
+{
+  //==========================================================================
+  // skin_task
+  //==========================================================================
+  struct skin_task
+  {
+    const skinned_mesh *mesh;
+    unsigned segment_idx;
+  };
+  //--------------------------------------------------------------------------
+
+  void skin_segment(const skinned_mesh &mesh_, unsigned segment_idx_)
+  {
+    unsigned vbuf_idx=mesh_.source->segment(segment_idx_).vertex_buffer;
+    vec3f *normals=mesh_.normals?mesh_.normals[vbuf_idx]:0;
+    skin_mesh_segment(mesh_.positions[vbuf_idx], normals, *mesh_.source, segment_idx_, mesh_.tforms_b2o);
+  }
+  //----
+
+  void skin_job(skin_task *task_, void*)
+  {
+    skin_segment(*task_->mesh, task_->segment_idx);
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+void pfc::skin_mesh_segment(vec3f *positions_, vec3f *normals_, const mesh &mesh_, unsigned segment_idx_, const tform_rt3f *tforms_b2o_)
+{
+  // get segment vertex data
+  const mesh_segment &seg=mesh_.segment(segment_idx_);
+  const mesh_vertex_buffer &vbuf=mesh_.vertex_buffer(seg.vertex_buffer);
+  const vec3f *src_pos=(const vec3f*)vbuf.vertex_channel(vtxchannel_position);
+  PFC_CHECK_MSG(src_pos, ("Mesh vertex buffer doesn't have position channel\r\n"));
+  const vec3f *src_nrm=normals_?(const vec3f*)vbuf.vertex_channel(vtxchannel_normal):0;
+  const vec4<uint16_t> *src_jidx=(const vec4<uint16_t>*)vbuf.vertex_channel(vtxchannel_joint_indices);
+  const vec4f *src_jweights=(const vec4f*)vbuf.vertex_channel(vtxchannel_joint_weights);
+
+  // find the vertex range referenced by the segment
+  unsigned num_seg_indices=num_primitive_vertices(seg.primitive_type, seg.num_primitives);
+  if(!num_seg_indices)
+    return;
+  const uint32_t *seg_indices=mesh_.indices()+seg.prim_start_index;
+  uint32_t vtx_start=seg_indices[0], vtx_end=seg_indices[0];
+  for(unsigned i=1; i<num_seg_indices; ++i)
+  {
+    vtx_start=min(vtx_start, seg_indices[i]);
+    vtx_end=max(vtx_end, seg_indices[i]);
+  }
+  ++vtx_end;
+
+  // copy vertices of rigid segments
+  if(!seg.num_joints || !src_jidx || !src_jweights)
+  {
+    if(positions_!=src_pos)
+      mem_copy(positions_+vtx_start, src_pos+vtx_start, sizeof(vec3f)*(vtx_end-vtx_start));
+    if(src_nrm && normals_!=src_nrm)
+      mem_copy(normals_+vtx_start, src_nrm+vtx_start, sizeof(vec3f)*(vtx_end-vtx_start));
+    return;
+  }
+
+  // setup segment joint matrices (rotated basis vectors and translation as rows)
+  PFC_PERF_TIMER_AUTO(skin_mesh_segment, "animation", "skin_mesh_segment()");
+  unsigned num_joints=seg.num_joints;
+  const uint16_t *joint_reindices=mesh_.joint_reindices()+seg.joint_reindexing_start;
+  __m128 *mats=(__m128*)((usize_t(PFC_STACK_MALLOC(sizeof(__m128)*4*num_joints+15))+15)&~usize_t(15));
   for(unsigned i=0; i<num_joints; ++i)
-    tforms_[i]=joints[i].bind_o2j*tforms_[i];
+  {
+    const tform_rt3f &t=tforms_b2o_[joint_reindices[i]];
+    __m128 *m=mats+i*4;
+    m[0]=load_vec3(vec3f(1.0f, 0.0f, 0.0f)*t.rotation);
+    m[1]=load_vec3(vec3f(0.0f, 1.0f, 0.0f)*t.rotation);
+    m[2]=load_vec3(vec3f(0.0f, 0.0f, 1.0f)*t.rotation);
+    m[3]=load_vec3(t.translation);
+  }
+
+  // skin vertices with weighted sum of 4 joint matrices
+  for(unsigned vi=vtx_start; vi<vtx_end; ++vi)
+  {
+    const vec4<uint16_t> &jidx=src_jidx[vi];
+    PFC_ASSERT_PEDANTIC(jidx.x<num_joints && jidx.y<num_joints && jidx.z<num_joints && jidx.w<num_joints);
+    const __m128 *m0=mats+jidx.x*4, *m1=mats+jidx.y*4, *m2=mats+jidx.z*4, *m3=mats+jidx.w*4;
+    __m128 w=_mm_loadu_ps(&src_jweights[vi].x);
+    __m128 w0=_mm_shuffle_ps(w, w, _MM_SHUFFLE(0, 0, 0, 0));
+    __m128 w1=_mm_shuffle_ps(w, w, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 w2=_mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 w3=_mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 r0=_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0[0], w0), _mm_mul_ps(m1[0], w1)), _mm_add_ps(_mm_mul_ps(m2[0], w2), _mm_mul_ps(m3[0], w3)));
+    __m128 r1=_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0[1], w0), _mm_mul_ps(m1[1], w1)), _mm_add_ps(_mm_mul_ps(m2[1], w2), _mm_mul_ps(m3[1], w3)));
+    __m128 r2=_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0[2], w0), _mm_mul_ps(m1[2], w1)), _mm_add_ps(_mm_mul_ps(m2[2], w2), _mm_mul_ps(m3[2], w3)));
+    __m128 r3=_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0[3], w0), _mm_mul_ps(m1[3], w1)), _mm_add_ps(_mm_mul_ps(m2[3], w2), _mm_mul_ps(m3[3], w3)));
+
+    // transform position
+    __m128 p=load_vec3(src_pos[vi]);
+    p=_mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0))),
+                            _mm_mul_ps(r1, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)))),
+                 _mm_add_ps(_mm_mul_ps(r2, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))), r3));
+    store_vec3(positions_[vi], p);
+
+    // transform and renormalize normal (degenerate normals result in zero vector)
+    if(src_nrm)
+    {
+      __m128 n=load_vec3(src_nrm[vi]);
+      n=_mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, _mm_shuffle_ps(n, n, _MM_SHUFFLE(0, 0, 0, 0))),
+                              _mm_mul_ps(r1, _mm_shuffle_ps(n, n, _MM_SHUFFLE(1, 1, 1, 1)))),
+                   _mm_mul_ps(r2, _mm_shuffle_ps(n, n, _MM_SHUFFLE(2, 2, 2, 2))));
+      __m128 nn=_mm_mul_ps(n, n);
+      __m128 len2=_mm_add_ps(_mm_add_ps(_mm_shuffle_ps(nn, nn, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(nn, nn, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(nn, nn, _MM_SHUFFLE(2, 2, 2, 2)));
+      __m128 rlen=_mm_rsqrt_ps(len2);
+      rlen=_mm_mul_ps(rlen, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), len2), _mm_mul_ps(rlen, rlen))));
+      rlen=_mm_and_ps(rlen, _mm_cmpgt_ps(len2, _mm_setzero_ps()));
+      store_vec3(normals_[vi], _mm_mul_ps(n, rlen));
+    }
+  }
+}
+//----
+
+void pfc::skin_meshes(const skinned_mesh *meshes_, unsigned num_meshes_)
+{
+  // skin all segments of the meshes (segments in parallel if job queue is active)
+  // note: segments are assumed not to share vertices
+  PFC_PERF_TIMER_AUTO(skin_meshes, "animation", "skin_meshes()");
+  unsigned num_segments=0;
+  for(unsigned mi=0; mi<num_meshes_; ++mi)
+    num_segments+=meshes_[mi].source->num_segments();
+  if(!mp_job_queue::has_active() || num_segments<2)
+  {
+    for(unsigned mi=0; mi<num_meshes_; ++mi)
+    {
+      unsigned num_mesh_segments=meshes_[mi].source->num_segments();
+      for(unsigned si=0; si<num_mesh_segments; ++si)
+        skin_segment(meshes_[mi], si);
+    }
+    return;
+  }
+  mp_job_queue &jq=mp_job_queue::active();
+  e_jobtype_id job_type=jq.find_or_create_job_type("skin_meshes", &skin_job);
+  volatile uint32_t job_counter=0;
+  array<skin_task> tasks(num_segments);
+  skin_task *task=tasks.data();
+  for(unsigned mi=0; mi<num_meshes_; ++mi)
+  {
+    unsigned num_mesh_segments=meshes_[mi].source->num_segments();
+    for(unsigned si=0; si<num_mesh_segments; ++si)
+    {
+      task->mesh=meshes_+mi;
+      task->segment_idx=si;
+      jq.add_job(job_type, task++, job_counter);
+    }
+  }
+  jq.wait_jobs(job_counter);
 }
 //----------------------------------------------------------------------------
 
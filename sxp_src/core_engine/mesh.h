@@ -19,6 +19,7 @@
 namespace pfc
 {
 class bin_input_stream_base;
+class triangle_mesh_bvh3;
 
 // new
 class mesh_vertex_buffer;
@@ -26,10 +27,15 @@ struct mesh_skeleton;
 struct mesh_segment;
 struct mesh_collision_object;
 class mesh;
+class mesh_surface_sampler;
+struct skinned_mesh;
 owner_ptr<mesh> load_mesh(bin_input_stream_base&);
 owner_ptr<mesh> load_mesh(const char *filename_, const char *path_=0);
 void random_mesh_surface_tforms(array<tform_rt3f>&, const mesh&, unsigned num_tforms_, unsigned seed_=0);
+void init_mesh_surface_bvh(triangle_mesh_bvh3&, const mesh&, unsigned max_leaf_tris_=4);
 void transform_joints_j2p_to_b2o(tform_rt3f*, const mesh_skeleton&);
+void skin_mesh_segment(vec3f *positions_, vec3f *normals_, const mesh&, unsigned segment_idx_, const tform_rt3f *tforms_b2o_);
+void skin_meshes(const skinned_mesh*, unsigned num_meshes_);
 bool is_mesh_file_ext(const char *filename_ext_);
 uint8_t subobject_lod(const char *subobject_name_);
 bool is_collision_subobject(const char *subobject_name_);
@@ -240,6 +246,88 @@ private:
 };
 //----------------------------------------------------------------------------
 
+
+//============================================================================
+// mesh_surface_sampler
+//============================================================================
+// Generates random transforms evenly distributed on the mesh surface (z-axis
+// along the interpolated vertex normal). Triangles are picked in O(1) time
+// with Walker's alias table built over the triangle areas. Large batches are
+// generated in parallel on the active mp_job_queue (if any) and the result
+// for given seed doesn't depend on the number of threads.
+class mesh_surface_sampler
+{
+public:
+  // construction
+  mesh_surface_sampler();
+  mesh_surface_sampler(const mesh&);
+  void init(const mesh&);
+  void clear();
+  //--------------------------------------------------------------------------
+
+  // accessors
+  PFC_INLINE unsigned num_triangles() const;
+  PFC_INLINE float surface_area() const;
+  //--------------------------------------------------------------------------
+
+  // sampling
+  tform_rt3f sample_tform(rng_simple&) const;
+  void generate_tforms(array<tform_rt3f>&, unsigned num_tforms_, unsigned seed_=0) const;
+  void generate_tforms(tform_rt3f*, unsigned num_tforms_, unsigned seed_=0) const;
+  //--------------------------------------------------------------------------
+
+private:
+  struct gen_task;
+  mesh_surface_sampler(const mesh_surface_sampler&); // not implemented
+  void operator=(const mesh_surface_sampler&); // not implemented
+  void generate_blocks(tform_rt3f*, unsigned num_tforms_, unsigned first_block_, unsigned end_block_, unsigned seed_) const;
+  static void gen_job(gen_task*, void*);
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // mesh_surface_sampler::tri
+  //==========================================================================
+  struct tri
+  {
+    vec3f p0, p1, p2;
+    vec3f n0, n1, n2;
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // mesh_surface_sampler::alias_entry
+  //==========================================================================
+  struct alias_entry
+  {
+    float prob;      // probability of picking the triangle instead of the alias
+    uint32_t alias;  // alias triangle index
+  };
+  //--------------------------------------------------------------------------
+
+  array<tri> m_tris;
+  array<alias_entry> m_alias_table;
+  float m_surface_area;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// skinned_mesh
+//============================================================================
+// Mesh skinning job for skin_meshes(). Vertex positions and normals of all
+// mesh segments are linear blend skinned with bind->object space joint
+// transforms (see transform_joints_j2p_to_b2o()) to per vertex buffer output
+// arrays. Segments without joints are copied unchanged. Normals are skipped
+// if normals is null, or the normal output of a vertex buffer is null.
+struct skinned_mesh
+{
+  const mesh *source;
+  const tform_rt3f *tforms_b2o;  // bind->object space transforms for skeleton joints
+  vec3f *const *positions;       // position output array per vertex buffer
+  vec3f *const *normals;         // normal output array per vertex buffer (optional)
+};
+//----------------------------------------------------------------------------
+
 //============================================================================
 #include "mesh.inl"
 } // namespace pfc
@@ -156,3 +156,19 @@ const uint16_t *mesh::joint_reindices() const
   return m_joint_reindices.data();
 }
 //----------------------------------------------------------------------------
+
+
+//============================================================================
+// mesh_surface_sampler
+//============================================================================
+unsigned mesh_surface_sampler::num_triangles() const
+{
+  return (unsigned)m_tris.size();
+}
+//----
+
+float mesh_surface_sampler::surface_area() const
+{
+  return m_surface_area;
+}
+//----------------------------------------------------------------------------
@@ -10,10 +10,13 @@
 #include "sxp_src/core/math/math.h"
 #include "sxp_src/core/math/bit_math.h"
 #include "sxp_src/core/math/numeric.h"
+#include "sxp_src/core/math/spherical_harmonics.h"
 #include "sxp_src/core/fsys/fsys.h"
+#include "sxp_src/core/mp/mp_job_queue.h"
 #ifdef PFC_ENGINEOP_NVTEXTURETOOLS
 #include "sxp_extlibs/nvtexturetools/src/nvtt/nvtt.h"
 #endif
+#include <xmmintrin.h>
 using namespace pfc;
 //----------------------------------------------------------------------------
 
@@ -1801,6 +1804,198 @@ void pfc::interleave_rgba_to_rgba(void *dst_, const void *src_red_, const void *
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// texture spherical harmonics projection
+//============================================================================
+namespace
+{
+  enum {sh_project_rows_per_task=16};           // number of cube face rows projected in a task
+  enum {sh_project_min_job_texels=6*64*64};     // minimum number of cube texels for parallel projection
+  //--------------------------------------------------------------------------
+
+  // texel direction basis of cube faces: dir=[origin+s*s_axis+t*t_axis], where s and t are in range [-1, 1] (t=-1 for the first row)
+  static const float s_cube_face_basis[6][3][3]=
+  {
+    {{-1.0f,  0.0f,  0.0f}, { 0.0f,  0.0f,  1.0f}, { 0.0f, -1.0f,  0.0f}}, // -x
+    {{ 1.0f,  0.0f,  0.0f}, { 0.0f,  0.0f, -1.0f}, { 0.0f, -1.0f,  0.0f}}, // +x
+    {{ 0.0f, -1.0f,  0.0f}, { 1.0f,  0.0f,  0.0f}, { 0.0f,  0.0f, -1.0f}}, // -y
+    {{ 0.0f,  1.0f,  0.0f}, { 1.0f,  0.0f,  0.0f}, { 0.0f,  0.0f,  1.0f}}, // +y
+    {{ 0.0f,  0.0f, -1.0f}, {-1.0f,  0.0f,  0.0f}, { 0.0f, -1.0f,  0.0f}}, // -z
+    {{ 0.0f,  0.0f,  1.0f}, { 1.0f,  0.0f,  0.0f}, { 0.0f, -1.0f,  0.0f}}, // +z
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // sh_project_task
+  //==========================================================================
+  struct sh_project_task
+  {
+    const void *face_data;
+    unsigned face;
+    unsigned edge_len;
+    e_texture_format format;
+    unsigned first_row, end_row;
+    float sums[28];     // weighted sums of SH3 basis*RGB (coeff-major) and weight sum
+  };
+  //--------------------------------------------------------------------------
+
+  void sh_project_rows(sh_project_task &task_)
+  {
+    // setup row conversion buffer padded to multiple of 4 texels
+    unsigned edge_len=task_.edge_len;
+    unsigned num_simd=(edge_len+3)&~3u;
+    array<float> row_buf(num_simd*4);
+    mem_zero(row_buf.data(), num_simd*4*sizeof(float));
+    usize_t row_pitch=texture_pitch(edge_len, task_.format);
+    const float *basis=s_cube_face_basis[task_.face][0];
+    static const float s_c0=0.28209479177387814347403972578039f;  //  0.5*sqrt(1/pi)
+    static const float s_c1=0.48860251190291992158638462283835f;  //  0.5*sqrt(3/pi)
+    static const float s_c20=1.0925484305920790705433857058027f;  //  0.5*sqrt(15/pi)
+    static const float s_c21=0.31539156525252000603089369029571f; // 0.25*sqrt(5/pi)
+    static const float s_c22=0.54627421529603953527169285290134f; // 0.25*sqrt(15/pi)
+    const __m128 c0=_mm_set1_ps(s_c0), c1=_mm_set1_ps(s_c1), c20=_mm_set1_ps(s_c20), c21=_mm_set1_ps(s_c21), c22=_mm_set1_ps(s_c22);
+    const __m128 one=_mm_set1_ps(1.0f), three=_mm_set1_ps(3.0f);
+    const __m128 texel_area=_mm_set1_ps(4.0f/(float(edge_len)*float(edge_len)));
+    const __m128 sx=_mm_set1_ps(basis[3]), sy=_mm_set1_ps(basis[4]), sz=_mm_set1_ps(basis[5]);
+    float rcp_edge=2.0f/float(edge_len);
+    __m128 acc[28];
+    for(unsigned i=0; i<28; ++i)
+      acc[i]=_mm_setzero_ps();
+
+    // project rows
+    for(unsigned y=task_.first_row; y<task_.end_row; ++y)
+    {
+      // convert row to 32-bit float RGBA
+      const void *row=static_cast<const char*>(task_.face_data)+y*row_pitch;
+      const float *texels=row_buf.data();
+      if(task_.format==texfmt_a32b32g32r32f)
+        mem_copy(row_buf.data(), row, edge_len*4*sizeof(float));
+      else
+        convert_rgba_to_rgba(row_buf.data(), row, texfmt_a32b32g32r32f, task_.format, edge_len);
+
+      // setup row direction origin
+      float t=(float(y)+0.5f)*rcp_edge-1.0f;
+      __m128 ox=_mm_set1_ps(basis[0]+t*basis[6]), oy=_mm_set1_ps(basis[1]+t*basis[7]), oz=_mm_set1_ps(basis[2]+t*basis[8]);
+      __m128 tt1=_mm_set1_ps(1.0f+t*t);
+      for(unsigned x=0; x<num_simd; x+=4, texels+=16)
+      {
+        // calculate normalized texel directions and solid angle weights
+        __m128 s=_mm_set_ps((float(x)+3.5f)*rcp_edge-1.0f, (float(x)+2.5f)*rcp_edge-1.0f, (float(x)+1.5f)*rcp_edge-1.0f, (float(x)+0.5f)*rcp_edge-1.0f);
+        __m128 rlen=_mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(tt1, _mm_mul_ps(s, s))));
+        __m128 w=_mm_mul_ps(texel_area, _mm_mul_ps(rlen, _mm_mul_ps(rlen, rlen)));
+        if(x+4>edge_len)
+        {
+          // mask out padding texels from the weight sum
+          static const float s_mask[4][4]={{1.0f, 0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 1.0f, 1.0f}};
+          acc[27]=_mm_add_ps(acc[27], _mm_mul_ps(w, _mm_loadu_ps(s_mask[edge_len-x-1])));
+        }
+        else
+          acc[27]=_mm_add_ps(acc[27], w);
+        __m128 dx=_mm_mul_ps(_mm_add_ps(ox, _mm_mul_ps(s, sx)), rlen);
+        __m128 dy=_mm_mul_ps(_mm_add_ps(oy, _mm_mul_ps(s, sy)), rlen);
+        __m128 dz=_mm_mul_ps(_mm_add_ps(oz, _mm_mul_ps(s, sz)), rlen);
+
+        // deinterleave texel RGB and pre-multiply by the weight
+        __m128 r=_mm_loadu_ps(texels+0), g=_mm_loadu_ps(texels+4), b=_mm_loadu_ps(texels+8), a=_mm_loadu_ps(texels+12);
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+        r=_mm_mul_ps(r, w);
+        g=_mm_mul_ps(g, w);
+        b=_mm_mul_ps(b, w);
+
+        // accumulate SH3 basis*RGB
+        __m128 sh[9];
+        sh[0]=c0;
+        sh[1]=_mm_mul_ps(c1, dy);
+        sh[2]=_mm_mul_ps(c1, dz);
+        sh[3]=_mm_mul_ps(c1, dx);
+        sh[4]=_mm_mul_ps(c20, _mm_mul_ps(dx, dy));
+        sh[5]=_mm_mul_ps(c20, _mm_mul_ps(dy, dz));
+        sh[6]=_mm_mul_ps(c21, _mm_sub_ps(_mm_mul_ps(three, _mm_mul_ps(dz, dz)), one));
+        sh[7]=_mm_mul_ps(c20, _mm_mul_ps(dx, dz));
+        sh[8]=_mm_mul_ps(c22, _mm_sub_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        for(unsigned ci=0; ci<9; ++ci)
+        {
+          acc[ci*3+0]=_mm_add_ps(acc[ci*3+0], _mm_mul_ps(sh[ci], r));
+          acc[ci*3+1]=_mm_add_ps(acc[ci*3+1], _mm_mul_ps(sh[ci], g));
+          acc[ci*3+2]=_mm_add_ps(acc[ci*3+2], _mm_mul_ps(sh[ci], b));
+        }
+      }
+    }
+
+    // store horizontal sums of the lanes
+    for(unsigned i=0; i<28; ++i)
+    {
+      PFC_ALIGN(16) float lanes[4];
+      _mm_store_ps(lanes, acc[i]);
+      task_.sums[i]=(lanes[0]+lanes[1])+(lanes[2]+lanes[3]);
+    }
+  }
+  //----
+
+  void sh_project_job(sh_project_task *task_, void*)
+  {
+    sh_project_rows(*task_);
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+void pfc::sh_project(shvec3<vec3f> &res_, const cpu_texcube &tex_, unsigned mip_level_)
+{
+  PFC_ASSERT_MSG(mip_level_<tex_.num_mips(), ("Mip level %i out of range (%i mips)\r\n", mip_level_, tex_.num_mips()));
+  texcube_base::mip_data md;
+  for(unsigned i=0; i<6; ++i)
+    md.data[i]=tex_.data(e_cubemap_face(i), mip_level_);
+  sh_project(res_, md, max(tex_.edge_len()>>mip_level_, 1u), tex_.format());
+}
+//----
+
+void pfc::sh_project(shvec3<vec3f> &res_, const texcube_base::mip_data &data_, unsigned edge_len_, e_texture_format format_)
+{
+  // split cube faces to fixed row ranges (independent of the number of threads for deterministic results)
+  PFC_PERF_TIMER_AUTO(sh_project, "texture", "sh_project()");
+  PFC_ASSERT_MSG(edge_len_, ("Cube texture edge length must be greater than zero\r\n"));
+  PFC_ASSERT_MSG(texfmt_type(format_)!=texfmttype_bc, ("Block compressed texture formats are not supported for SH projection\r\n"));
+  unsigned num_face_tasks=(edge_len_+sh_project_rows_per_task-1)/sh_project_rows_per_task;
+  array<sh_project_task> tasks(6*num_face_tasks);
+  for(unsigned fi=0; fi<6; ++fi)
+    for(unsigned ti=0; ti<num_face_tasks; ++ti)
+    {
+      sh_project_task &task=tasks[fi*num_face_tasks+ti];
+      task.face_data=data_.data[fi];
+      task.face=fi;
+      task.edge_len=edge_len_;
+      task.format=format_;
+      task.first_row=ti*sh_project_rows_per_task;
+      task.end_row=min<unsigned>(task.first_row+sh_project_rows_per_task, edge_len_);
+    }
+
+  // project the tasks (in parallel if job queue is active)
+  unsigned num_tasks=(unsigned)tasks.size();
+  if(mp_job_queue::has_active() && 6*edge_len_*edge_len_>=sh_project_min_job_texels)
+  {
+    mp_job_queue &jq=mp_job_queue::active();
+    e_jobtype_id job_type=jq.find_or_create_job_type("sh_project", &sh_project_job);
+    volatile uint32_t job_counter=0;
+    for(unsigned i=0; i<num_tasks; ++i)
+      jq.add_job(job_type, &tasks[i], job_counter);
+    jq.wait_jobs(job_counter);
+  }
+  else
+    for(unsigned i=0; i<num_tasks; ++i)
+      sh_project_rows(tasks[i]);
+
+  // sum task results in fixed order and normalize the weights to the sphere surface area (4pi)
+  double sums[28]={0.0};
+  for(unsigned ti=0; ti<num_tasks; ++ti)
+    for(unsigned i=0; i<28; ++i)
+      sums[i]+=tasks[ti].sums[i];
+  float norm=sums[27]>0.0?float(4.0*math<double>::pi/sums[27]):0.0f;
+  for(unsigned ci=0; ci<9; ++ci)
+    res_.coeffs[ci].set(float(sums[ci*3+0])*norm, float(sums[ci*3+1])*norm, float(sums[ci*3+2])*norm);
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // texture creation functions
 //============================================================================
@@ -21,6 +21,7 @@
 #include "sxp_src/core/variant.h"
 namespace pfc
 {
+template<typename> struct shvec3;
 
 // new
 struct texture_layer;
@@ -705,6 +706,16 @@ void interleave_rgba_to_rgba(void *dst_, const void *src_red_, const void *src_g
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// texture spherical harmonics projection
+//============================================================================
+// Projects cube texture RGB to order-3 SH with solid angle weighted texels.
+// Texel values are projected as stored (no color space conversion is done).
+void sh_project(shvec3<vec3f>&, const cpu_texcube&, unsigned mip_level_=0);
+void sh_project(shvec3<vec3f>&, const texcube_base::mip_data&, unsigned edge_len_, e_texture_format);
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // texture creation functions
 //============================================================================
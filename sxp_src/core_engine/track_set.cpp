@@ -10,6 +10,9 @@
 #include "sxp_src/core/fsys/fsys.h"
 #include "sxp_src/core/math/tform3.h"
 #include "sxp_src/core/sort.h"
+#include "sxp_src/core/math/bit_math.h"
+#include "sxp_src/core/mp/mp_job_queue.h"
+#include <xmmintrin.h>
 using namespace pfc;
 //----------------------------------------------------------------------------
 
@@ -189,6 +192,258 @@ namespace
     return madd(vec3f(v_.x, v_.y, v_.z), scale_, bias_);
   }
   //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // track sampler segments
+  //==========================================================================
+  // SoA arrays of track_set_sampler: position segment end times, position
+  // spline coefficients (a.xyz, b.xyz, c.xyz, d.xyz), rotation segment end
+  // times and rotation spline coefficients (a.xyzw, b.xyzw, c.xyzw, d.xyzw)
+  enum {sampler_pos_segments=0, sampler_rot_segments=13, sampler_num_segment_arrays=30};
+  //----
+
+  template<typename T>
+  void set_sampler_segment(float *segments_, unsigned stride_, unsigned track_index_, ufloat_t end_time_, const cubic_spline<T> &spline_)
+  {
+    // store segment end time followed by the spline coefficients
+    float *data=segments_+track_index_;
+    data[0]=end_time_;
+    data+=stride_;
+    for(unsigned ci=0; ci<T::dim; ++ci)
+    {
+      data[ci*stride_]=spline_.a[ci];
+      data[(T::dim+ci)*stride_]=spline_.b[ci];
+      data[(2*T::dim+ci)*stride_]=spline_.c[ci];
+      data[(3*T::dim+ci)*stride_]=spline_.d[ci];
+    }
+  }
+  //----
+
+  template<typename T>
+  void set_sampler_end_value(float *segments_, unsigned stride_, unsigned track_index_, const T &v_)
+  {
+    // store constant value for the rest of the track
+    cubic_spline<T> spline;
+    spline.a.set(0.0f);
+    spline.c=spline.b=spline.a;
+    spline.d=v_;
+    set_sampler_segment(segments_, stride_, track_index_, numeric_type<float>::range_max(), spline);
+  }
+  //----
+
+  template<class It, class TrackSet>
+  void advance_sampler_segment(float *segments_, unsigned stride_, unsigned track_index_, It &it_, ufloat_t time_, const TrackSet &set_)
+  {
+    // advance the track iterator to the time and store the new segment (or the end value of the track)
+    if(it_.advance(time_, set_))
+      set_sampler_segment(segments_, stride_, track_index_, it_.segment_end(), it_.segment());
+    else
+      set_sampler_end_value(segments_, stride_, track_index_, it_.segment().d);
+  }
+  //----
+
+  template<unsigned dim>
+  PFC_INLINE void eval_sampler_splines(__m128 *res_, const float *splines_, unsigned stride_, __m128 t_)
+  {
+    // evaluate 4 cubic splines per component: ((a*t+b)*t+c)*t+d
+    for(unsigned ci=0; ci<dim; ++ci)
+    {
+      __m128 v=_mm_loadu_ps(splines_+ci*stride_);
+      v=_mm_add_ps(_mm_mul_ps(v, t_), _mm_loadu_ps(splines_+(dim+ci)*stride_));
+      v=_mm_add_ps(_mm_mul_ps(v, t_), _mm_loadu_ps(splines_+(2*dim+ci)*stride_));
+      res_[ci]=_mm_add_ps(_mm_mul_ps(v, t_), _mm_loadu_ps(splines_+(3*dim+ci)*stride_));
+    }
+  }
+  //----
+
+  PFC_INLINE void normalize_quats(__m128 *q_)
+  {
+    // normalize 4 quaternions with reciprocal square root estimate refined with a Newton-Raphson step
+    __m128 len2=_mm_add_ps(_mm_add_ps(_mm_mul_ps(q_[0], q_[0]), _mm_mul_ps(q_[1], q_[1])),
+                           _mm_add_ps(_mm_mul_ps(q_[2], q_[2]), _mm_mul_ps(q_[3], q_[3])));
+    __m128 rlen=_mm_rsqrt_ps(len2);
+    rlen=_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), rlen), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_mul_ps(len2, rlen), rlen)));
+    for(unsigned ci=0; ci<4; ++ci)
+      q_[ci]=_mm_mul_ps(q_[ci], rlen);
+  }
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // channel spline fitting
+  //==========================================================================
+  template<typename T> struct spline_fit_constraint_type;
+  template<> struct spline_fit_constraint_type<vec3f> {typedef spline_fit_constraint_vec<vec3f> res;};
+  template<> struct spline_fit_constraint_type<quatf> {typedef spline_fit_constraint_quat<quatf> res;};
+  PFC_INLINE array<track_set_spline_fit_cache::channel_fit<vec3f> > &cached_channel_fits(track_set_spline_fit_cache &cache_, meta_type<vec3f>) {return cache_.position_fits;}
+  PFC_INLINE array<track_set_spline_fit_cache::channel_fit<quatf> > &cached_channel_fits(track_set_spline_fit_cache &cache_, meta_type<quatf>) {return cache_.rotation_fits;}
+  //----
+
+  template<typename T> struct channel_spline_fit_batch;
+  template<typename T>
+  struct channel_spline_fit
+  {
+    const channel_spline_fit_batch<T> *batch;
+    const T *keys;
+    unsigned num_keys;
+    track_set_spline_fit_cache::channel_fit<T> *fit;
+    bool is_reused;
+  };
+  //----
+
+  template<typename T>
+  struct channel_spline_fit_batch
+  {
+    typedef typename spline_fit_constraint_type<T>::res constraint_t;
+    //------------------------------------------------------------------------
+
+    channel_spline_fit_batch(const constraint_t &constraint_, const float tolerances_[4], unsigned max_segments_, unsigned max_segment_frames_, unsigned num_tracks_, track_set_spline_fit_cache *cache_)
+      :constraint(constraint_)
+      ,max_segments(max_segments_)
+      ,max_segment_frames(max_segment_frames_)
+      ,cache(cache_)
+    {
+      // setup fit records indexed by track, either from the cache or local
+      mem_copy(tolerances, tolerances_, sizeof(tolerances));
+      max_tolerance_change=cache_?cache_->max_tolerance_change_percent*0.01f:0.0f;
+      array<track_set_spline_fit_cache::channel_fit<T> > &fits=cache_?cached_channel_fits(*cache_, meta_type<T>()):local_fits;
+      if(fits.size()<num_tracks_)
+      {
+        unsigned num_new_fits=unsigned(num_tracks_-fits.size());
+        fits.resize(num_tracks_);
+        for(unsigned i=num_tracks_-num_new_fits; i<num_tracks_; ++i)
+          fits[i].num_keys=0;
+      }
+      track_fits=fits.data();
+    }
+    //------------------------------------------------------------------------
+
+    void add(unsigned track_index_, const T *keys_, unsigned num_keys_)
+    {
+      // add fit for a track channel
+      channel_spline_fit<T> &fit=channel_fits.push_back();
+      fit.batch=this;
+      fit.keys=keys_;
+      fit.num_keys=num_keys_;
+      fit.fit=track_fits+track_index_;
+      fit.is_reused=false;
+    }
+    //------------------------------------------------------------------------
+
+    const constraint_t &constraint;
+    float tolerances[4];
+    float max_tolerance_change;
+    unsigned max_segments;
+    unsigned max_segment_frames;
+    track_set_spline_fit_cache *cache;
+    track_set_spline_fit_cache::channel_fit<T> *track_fits;
+    array<track_set_spline_fit_cache::channel_fit<T> > local_fits;
+    array<channel_spline_fit<T> > channel_fits;
+  };
+  //----
+
+  PFC_INLINE uint32_t hash_channel_keys(const void *keys_, unsigned num_words_)
+  {
+    // FNV-1a hash of key data words for detecting changed channel keys
+    const uint32_t *words=(const uint32_t*)keys_;
+    uint32_t hash=2166136261u;
+    for(unsigned i=0; i<num_words_; ++i)
+      hash=(hash^words[i])*16777619u;
+    return hash;
+  }
+  //----
+
+  template<typename T>
+  bool is_valid_cached_fit(const channel_spline_fit<T> &fit_, uint32_t keys_hash_)
+  {
+    // check that keys, segment limits and tolerances match the cached fit
+    const channel_spline_fit_batch<T> &batch=*fit_.batch;
+    const track_set_spline_fit_cache::channel_fit<T> &cfit=*fit_.fit;
+    unsigned num_splines=(unsigned)cfit.splines.size();
+    if(   cfit.num_keys!=fit_.num_keys || cfit.keys_hash!=keys_hash_ || cfit.max_segment_frames!=batch.max_segment_frames
+       || !num_splines || num_splines>batch.max_segments)
+      return false;
+    for(unsigned i=0; i<4; ++i)
+      if(abs(batch.tolerances[i]-cfit.tolerances[i])>abs(cfit.tolerances[i])*batch.max_tolerance_change)
+        return false;
+    if(batch.tolerances[2]>=cfit.tolerances[2])
+      return true;
+
+    // check that the cached splines are within the tighter output tolerance of the keys
+    const T *keys=fit_.keys;
+    for(unsigned si=0; si<num_splines; ++si)
+    {
+      unsigned spline_len=cfit.spline_lengths[si];
+      float rcp_spline_len=1.0f/float(spline_len);
+      for(unsigned i=1; i<=spline_len; ++i)
+        if(!batch.constraint.spline_constraints(keys[i-1], keys[i], cfit.splines[si], float(i)*rcp_spline_len))
+          return false;
+      keys+=spline_len;
+    }
+    return true;
+  }
+  //----
+
+  template<typename T>
+  void fit_channel_spline(channel_spline_fit<T> *fit_, void*)
+  {
+    // check for reusable cached fit
+    const channel_spline_fit_batch<T> &batch=*fit_->batch;
+    track_set_spline_fit_cache::channel_fit<T> &cfit=*fit_->fit;
+    uint32_t keys_hash=0;
+    if(batch.cache)
+    {
+      keys_hash=hash_channel_keys(fit_->keys, fit_->num_keys*sizeof(T)/4);
+      if(is_valid_cached_fit(*fit_, keys_hash))
+      {
+        fit_->is_reused=true;
+        return;
+      }
+    }
+
+    // fit splines to the channel keys with a private copy of the constraint
+    typename channel_spline_fit_batch<T>::constraint_t constraint=batch.constraint;
+    cfit.splines.resize(batch.max_segments);
+    cfit.spline_lengths.resize(batch.max_segments);
+    constraint.init_buffers(cfit.splines.data(), cfit.spline_lengths.data(), batch.max_segments);
+    unsigned num_segments=fit_spline<T>(fit_->keys, fit_->num_keys, constraint, batch.max_segment_frames);
+    cfit.splines.resize(num_segments);
+    cfit.spline_lengths.resize(num_segments);
+    cfit.keys_hash=keys_hash;
+    cfit.num_keys=fit_->num_keys;
+    cfit.max_segment_frames=batch.max_segment_frames;
+    mem_copy(cfit.tolerances, batch.tolerances, sizeof(cfit.tolerances));
+  }
+  //----
+
+  template<typename T>
+  void fit_channel_splines(channel_spline_fit_batch<T> &batch_)
+  {
+    // fit channels independently on the active job queue (if any). each fit
+    // writes only to its own record, so the result is independent of the
+    // job scheduling
+    channel_spline_fit<T> *fits=batch_.channel_fits.data();
+    unsigned num_fits=(unsigned)batch_.channel_fits.size();
+    if(!mp_job_queue::has_active() || num_fits<2)
+    {
+      for(unsigned i=0; i<num_fits; ++i)
+        fit_channel_spline(fits+i, 0);
+    }
+    else
+    {
+      mp_job_queue &jq=mp_job_queue::active();
+      e_jobtype_id job_type=jq.find_or_create_job_type("track spline fit", &fit_channel_spline<T>);
+      volatile uint32_t job_counter=0;
+      for(unsigned i=0; i<num_fits; ++i)
+        jq.add_job(job_type, fits+i, job_counter);
+      jq.wait_jobs(job_counter);
+    }
+
+    // update cache stats
+    if(batch_.cache)
+      for(unsigned i=0; i<num_fits; ++i)
+        ++(fits[i].is_reused?batch_.cache->num_reused_fits:batch_.cache->num_new_fits);
+  }
+  //--------------------------------------------------------------------------
 } // namespace <anonymous>
 //----------------------------------------------------------------------------
 
@@ -214,6 +469,7 @@ owner_ptr<track_set> pfc::load_track_set(bin_input_stream_base &stream_)
 owner_ptr<track_set> pfc::load_track_set(const char *filename_, const char *path_)
 {
   // try to load a track set file
+  PFC_PERF_TRACE_SCOPE("load_track_set", "file", filename_);
   owner_ptr<bin_input_stream_base> f=afs_open_read(filename_, path_);
   if(!f.data)
   {
@@ -532,7 +788,7 @@ void track_set::finish_init()
 }
 //----
 
-void track_set::splinify(const track_set &tset_, const track_set_splinify_settings &settings_)
+void track_set::splinify(const track_set &tset_, const track_set_splinify_settings &settings_, track_set_spline_fit_cache *cache_)
 {
   // preliminary init of the data
   PFC_MEM_FREE(m_track_data.data);
@@ -546,14 +802,56 @@ void track_set::splinify(const track_set &tset_, const track_set_splinify_settin
   m_track_data.channel_data_size=0;
   m_track_data.data=0;
 
+  // collect sampled track channels for spline fitting
+  enum {max_splines=256};
+  spline_fit_constraint_vec<vec3f> pos_constraint(settings_.pos_input_curvature_tolerance_deg,
+                                                  settings_.pos_input_velocity_tolerance,
+                                                  settings_.pos_output_distance_tolerance,
+                                                  settings_.pos_tangent_velocity_tolerance_percent);
+  spline_fit_constraint_quat<quatf> rot_constraint(settings_.rot_input_curvature_tolerance_deg,
+                                                   settings_.rot_input_angular_velocity_tolerance,
+                                                   settings_.rot_output_angle_tolerance_deg,
+                                                   settings_.rot_tangent_angular_velocity_tolerance_percent);
+  const float pos_tolerances[4]={settings_.pos_input_curvature_tolerance_deg, settings_.pos_input_velocity_tolerance, settings_.pos_output_distance_tolerance, settings_.pos_tangent_velocity_tolerance_percent};
+  const float rot_tolerances[4]={settings_.rot_input_curvature_tolerance_deg, settings_.rot_input_angular_velocity_tolerance, settings_.rot_output_angle_tolerance_deg, settings_.rot_tangent_angular_velocity_tolerance_percent};
+  channel_spline_fit_batch<vec3f> pos_fits(pos_constraint, pos_tolerances, max_splines, 0, m_track_data.num_tracks, cache_);
+  channel_spline_fit_batch<quatf> rot_fits(rot_constraint, rot_tolerances, max_splines, 0, m_track_data.num_tracks, cache_);
+  const track_info *tinfos=tset_.track_infos();
+  const track_channel_info *cinfos=tset_.channel_infos();
+  for(unsigned ti=0; ti<m_track_data.num_tracks; ++ti)
+  {
+    const track_info &tinfo=tinfos[ti];
+    if(!tinfo.num_frames)
+      continue;
+    for(unsigned ci=0; ci<tinfo.num_channels; ++ci)
+    {
+      const track_channel_info &cinfo=cinfos[tinfo.channel_offset_start+ci];
+      if(cinfo.format==trackchannelformat_sample)
+      {
+        const uint8_t *cdata=(const uint8_t*)tset_.channel_data()+cinfo.data_offset;
+        unsigned num_keys=tinfo.num_frames+1;
+        switch(cinfo.channel)
+        {
+          case trackchannel_position: pos_fits.add(ti, (const vec3f*)cdata, num_keys); break;
+          case trackchannel_rotation: rot_fits.add(ti, (const quatf*)cdata, num_keys); break;
+        }
+      }
+    }
+  }
+
+  // fit splines to the channels in parallel
+  if(cache_)
+    cache_->num_reused_fits=cache_->num_new_fits=0;
+  fit_channel_splines(pos_fits);
+  fit_channel_splines(rot_fits);
+
   // allocate new track containers
   array<track_channel_info> new_cinfos;
   new_cinfos.reserve(m_track_data.num_total_channels);
   array<uint8_t> new_channel_data;
 
-  // process all the tracks
-  const track_info *tinfos=tset_.track_infos();
-  const track_channel_info *cinfos=tset_.channel_infos();
+  // process all the tracks in order
+  unsigned pos_fit_idx=0, rot_fit_idx=0;
   for(unsigned ti=0; ti<m_track_data.num_tracks; ++ti)
   {
     // add new track
@@ -577,27 +875,18 @@ void track_set::splinify(const track_set &tset_, const track_set_splinify_settin
       {
         case trackchannelformat_sample:
         {
-          unsigned num_keys=tinfo.num_frames+1;
           switch(cinfo.channel)
           {
             case trackchannel_position:
             {
               // add spline fitted position channel
-              spline_fit_constraint_vec<vec3f> constraint(settings_.pos_input_curvature_tolerance_deg,
-                                                          settings_.pos_input_velocity_tolerance,
-                                                          settings_.pos_output_distance_tolerance,
-                                                          settings_.pos_tangent_velocity_tolerance_percent);
-              add_channel_spline_fit(new_channel_data, (const vec3f*)cdata, num_keys, constraint);
+              add_channel_splines(new_channel_data, *pos_fits.channel_fits[pos_fit_idx++].fit);
             } break;
 
             case trackchannel_rotation:
             {
               // add spline fitted rotation channel
-              spline_fit_constraint_quat<quatf> constraint(settings_.rot_input_curvature_tolerance_deg,
-                                                           settings_.rot_input_angular_velocity_tolerance,
-                                                           settings_.rot_output_angle_tolerance_deg,
-                                                           settings_.rot_tangent_angular_velocity_tolerance_percent);
-              add_channel_spline_fit(new_channel_data, (const quatf*)cdata, num_keys, constraint);
+              add_channel_splines(new_channel_data, *rot_fits.channel_fits[rot_fit_idx++].fit);
             } break;
 
             default: PFC_ERROR("Unsupported sample track channel type\r\n");
@@ -654,25 +943,19 @@ e_file_format track_set::load(bin_input_stream_base &stream_)
 }
 //----------------------------------------------------------------------------
 
-template<typename T, class Constraint>
-void track_set::add_channel_spline_fit(array<uint8_t> &res_data_, const T *keys_, unsigned num_keys_, Constraint &constraint_)
+template<typename T>
+void track_set::add_channel_splines(array<uint8_t> &res_data_, const track_set_spline_fit_cache::channel_fit<T> &fit_)
 {
-  // fit keys to the spline
-  enum {max_splines=256};
-  cubic_spline<T> spline_buf[max_splines];
-  unsigned spline_len_buf[max_splines];
-  constraint_.init_buffers(spline_buf, spline_len_buf, max_splines);
-  unsigned num_segments=fit_spline<T>(keys_, num_keys_, constraint_);
+  // convert fitted splines to Hermite spline segments
+  unsigned num_segments=(unsigned)fit_.splines.size();
   PFC_CHECK_MSG(num_segments, ("The track channel generates too many splines\r\n"));
-
-  // convert generated spline to Hermite spline segments
   T p0;
   track_key_hermite<T> hkey;
   for(unsigned i=0; i<num_segments; ++i)
   {
-    PFC_CHECK(spline_len_buf[i]<65536);
-    hkey.num_frames=uint16_t(spline_len_buf[i]);
-    get_hermite_spline_keys(p0, hkey.p1, hkey.t0, hkey.t1, spline_buf[i]);
+    PFC_CHECK(fit_.spline_lengths[i]<65536);
+    hkey.num_frames=uint16_t(fit_.spline_lengths[i]);
+    get_hermite_spline_keys(p0, hkey.p1, hkey.t0, hkey.t1, fit_.splines[i]);
     if(!i)
       res_data_.insert_back(sizeof(T), (const uint8_t*)&p0);
     res_data_.insert_back(sizeof(track_key_hermite<T>), (const uint8_t*)&hkey);
@@ -843,6 +1126,27 @@ track_set_splinify_settings::track_set_splinify_settings()
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// track_set_spline_fit_cache
+//============================================================================
+track_set_spline_fit_cache::track_set_spline_fit_cache()
+{
+  max_tolerance_change_percent=25.0f;
+  num_reused_fits=0;
+  num_new_fits=0;
+}
+//----
+
+void track_set_spline_fit_cache::clear()
+{
+  num_reused_fits=0;
+  num_new_fits=0;
+  position_fits.clear();
+  rotation_fits.clear();
+}
+//----------------------------------------------------------------------------
+
+
 namespace pfc
 {
 //============================================================================
@@ -901,6 +1205,15 @@ struct compressed_track_set::track_channel_config<vec3f>
   vec3f current_pos;
   //--------------------------------------------------------------------------
 
+  PFC_INLINE void get_fit_tolerances(float tolerances_[4]) const
+  {
+    // get spline fit constraint tolerances
+    tolerances_[0]=input_curvature_tolerance_deg;
+    tolerances_[1]=input_velocity_tolerance;
+    tolerances_[2]=output_distance_tolerance;
+    tolerances_[3]=tangent_velocity_percent;
+  }
+
   PFC_INLINE bool is_const_spline(const vec3f &min_pos_, const vec3f &max_pos_) const
   {
     // check if all values are within output distance tolerance from the average
@@ -1056,6 +1369,15 @@ struct compressed_track_set::track_channel_config<quatf>
   float dq_segment_tangent_norm_scale, q_segment_tangent_norm_scale;
   //--------------------------------------------------------------------------
 
+  PFC_INLINE void get_fit_tolerances(float tolerances_[4]) const
+  {
+    // get spline fit constraint tolerances
+    tolerances_[0]=input_curvature_tolerance_deg;
+    tolerances_[1]=input_angular_velocity_tolerance;
+    tolerances_[2]=output_angle_tolerance_deg;
+    tolerances_[3]=tangent_angular_velocity_tolerance_percent;
+  }
+
   PFC_INLINE bool is_const_spline(const quatf &min_rot_, const quatf &max_rot_) const
   {
     // check if all values are within output distance tolerance from the average
@@ -1287,13 +1609,13 @@ compressed_track_set::compressed_track_set()
 }
 //----
 
-compressed_track_set::compressed_track_set(const track_set &set_, const track_set_splinify_settings &settings_)
+compressed_track_set::compressed_track_set(const track_set &set_, const track_set_splinify_settings &settings_, track_set_spline_fit_cache *cache_)
 {
-  init(set_, settings_);
+  init(set_, settings_, cache_);
 }
 //----
 
-void compressed_track_set::init(const track_set &set_, const track_set_splinify_settings &settings_)
+void compressed_track_set::init(const track_set &set_, const track_set_splinify_settings &settings_, track_set_spline_fit_cache *cache_)
 {
   // basic initialization
   init_members();
@@ -1329,6 +1651,8 @@ void compressed_track_set::init(const track_set &set_, const track_set_splinify_
     m_track_channel_data.resize(channel_offset_size);
 
   // compress channels
+  if(cache_)
+    cache_->num_reused_fits=cache_->num_new_fits=0;
   if(has_channel_position)
   {
     track_channel_config<vec3f> cfg(trackchannel_position,
@@ -1336,7 +1660,7 @@ void compressed_track_set::init(const track_set &set_, const track_set_splinify_
                                     settings_.pos_input_velocity_tolerance,
                                     settings_.pos_output_distance_tolerance,
                                     settings_.pos_tangent_velocity_tolerance_percent);
-    compress_channel(cfg, set_, channel_offset_writepos, channel_data_writepos);
+    compress_channel(cfg, set_, cache_, channel_offset_writepos, channel_data_writepos);
     m_pos_start_scale=cfg.dq_start_pos_scale;
     m_pos_start_bias=cfg.min_start_pos;
     m_pos_delta_scale=cfg.dq_delta_pos_scale;
@@ -1351,7 +1675,7 @@ void compressed_track_set::init(const track_set &set_, const track_set_splinify_
                                     settings_.rot_input_curvature_tolerance_deg,
                                     settings_.rot_output_angle_tolerance_deg,
                                     settings_.rot_tangent_angular_velocity_tolerance_percent);
-    compress_channel(cfg, set_, channel_offset_writepos, channel_data_writepos);
+    compress_channel(cfg, set_, cache_, channel_offset_writepos, channel_data_writepos);
     m_rot_tangent_norm_scale=-cfg.dq_segment_tangent_norm_scale;
     m_rot_tangent_norm_bias=-cfg.min_segment_tangent_norm;
   }
@@ -1385,7 +1709,7 @@ void compressed_track_set::init_members()
 //----
 
 template<class Cfg>
-void compressed_track_set::compress_channel(Cfg &cfg_, const track_set &set_, unsigned &channel_offset_writepos_, unsigned &channel_data_writepos_)
+void compressed_track_set::compress_channel(Cfg &cfg_, const track_set &set_, track_set_spline_fit_cache *cache_, unsigned &channel_offset_writepos_, unsigned &channel_data_writepos_)
 {
   // config typedefs & enums
   typedef typename Cfg::key_type key_type;
@@ -1399,13 +1723,37 @@ void compressed_track_set::compress_channel(Cfg &cfg_, const track_set &set_, un
   // add new track channel
   m_channels.push_back(cfg_.channel);
 
+  // collect non-constant sampled track channels for spline fitting
+  const track_info *tinfos=set_.track_infos();
+  const void *cdata=set_.channel_data();
+  float fit_tolerances[4];
+  cfg_.get_fit_tolerances(fit_tolerances);
+  channel_spline_fit_batch<key_type> spline_fits(cfg_.constraint, fit_tolerances, max_spline_segments, max_spline_segment_frames, m_num_tracks, cache_);
+  for(unsigned ti=0; ti<m_num_tracks; ++ti)
+  {
+    const track_info &tinfo=tinfos[ti];
+    const track_channel_info *cinfo=set_.find_channel_info(tinfo, cfg_.channel);
+    if(!cinfo || cinfo->format!=trackchannelformat_sample)
+      continue;
+    const key_type *keys=(const key_type*)((const uint8_t*)cdata+cinfo->data_offset);
+    key_type min_key=*keys, max_key=*keys;
+    unsigned num_keys=tinfo.num_frames+1;
+    for(unsigned i=1; i<num_keys; ++i)
+    {
+      min_key=min(min_key, keys[i]);
+      max_key=max(max_key, keys[i]);
+    }
+    if(!cfg_.is_const_spline(min_key, max_key))
+      spline_fits.add(ti, keys, num_keys);
+  }
+
+  // fit splines to the channels in parallel
+  fit_channel_splines(spline_fits);
+
   // generate Hermite splines for all tracks
-  cubic_spline<key_type> spline_buf[max_spline_segments];
-  unsigned spline_length_buf[max_spline_segments];
   deque<hermite_key<key_type> > hermite_keys;
   array<unsigned> num_spline_segments(m_num_tracks);
-  const track_info *tinfos=set_.track_infos();
-  const void *cdata=set_.channel_data();
+  unsigned spline_fit_idx=0;
   unsigned num_total_segments=0;
   unsigned num_total_degenerated_segments=0;
   unsigned num_const_splines=0;
@@ -1477,20 +1825,20 @@ void compressed_track_set::compress_channel(Cfg &cfg_, const track_set &set_, un
           break;
         }
 
-        // fit spline to track position channel keys
-        cfg_.constraint.init_buffers(spline_buf, spline_length_buf, max_spline_segments);
-        unsigned num_segments=fit_spline<key_type>(keys, num_keys, cfg_.constraint, max_spline_segment_frames);
+        // get spline fitted to the track channel keys
+        const track_set_spline_fit_cache::channel_fit<key_type> &fit=*spline_fits.channel_fits[spline_fit_idx++].fit;
+        unsigned num_segments=(unsigned)fit.splines.size();
         PFC_CHECK_MSG(num_segments, ("Input data generates too many cubic spline segments\r\n"));
         num_spline_segments[ti]=num_segments;
         num_total_segments+=num_segments;
-        cfg_.add_spline(spline_buf[0].d);
+        cfg_.add_spline(fit.splines[0].d);
         for(unsigned i=0; i<num_segments; ++i)
         {
           // setup Hermite key for the spline segment
           hermite_key<key_type> hkey;
-          hkey.num_frames=spline_length_buf[i];
+          hkey.num_frames=fit.spline_lengths[i];
           hkey.merge_tangent=true;
-          get_hermite_spline_keys(hkey.p0, hkey.p1, hkey.t0, hkey.t1, spline_buf[i]);
+          get_hermite_spline_keys(hkey.p0, hkey.p1, hkey.t0, hkey.t1, fit.splines[i]);
 
           // check for tangent discontinuity in the spline /*todo: improve tangent merging for better quality*/
           if(i && !cfg_.constraint.tangent_constraints(hermite_keys.back().t1, hkey.t0))
@@ -1671,3 +2019,217 @@ void compressed_track_set::compress_channel(Cfg &cfg_, const track_set &set_, un
   m_track_channel_data.insert_back(compressed_track_data.size(), compressed_track_data.data());
 }
 //----------------------------------------------------------------------------
+
+
+//============================================================================
+// track_pose
+//============================================================================
+track_pose::track_pose()
+{
+  m_num_tracks=0;
+  m_stride=0;
+}
+//----
+
+track_pose::track_pose(unsigned num_tracks_)
+{
+  m_num_tracks=0;
+  m_stride=0;
+  resize(num_tracks_);
+}
+//----
+
+void track_pose::resize(unsigned num_tracks_)
+{
+  // reset all tracks (including padding) to identity transforms
+  m_num_tracks=num_tracks_;
+  m_stride=(num_tracks_+3)&-4;
+  m_data.clear();
+  m_data.resize(m_stride*7, 0.0f);
+  float *rot_w=rot(3);
+  for(unsigned i=0; i<m_stride; ++i)
+    rot_w[i]=1.0f;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// track_set_sampler
+//============================================================================
+template<class TrackSet>
+track_set_sampler<TrackSet>::track_set_sampler()
+{
+  m_set=0;
+  m_start_time=0.0f;
+  m_time=0.0f;
+  m_num_tracks=0;
+  m_stride=0;
+}
+//----
+
+template<class TrackSet>
+track_set_sampler<TrackSet>::track_set_sampler(const TrackSet &set_, float start_time_)
+{
+  init(set_, start_time_);
+}
+//----
+
+template<class TrackSet>
+void track_set_sampler<TrackSet>::init(const TrackSet &set_, float start_time_, const vec3f &default_pos_, const quatf &default_rot_)
+{
+  // setup track iterators and SoA segment arrays padded to multiple of 4 tracks
+  m_set=&set_;
+  m_start_time=start_time_;
+  m_default_pos=default_pos_;
+  m_default_rot=default_rot_;
+  m_num_tracks=set_.num_tracks();
+  m_stride=(m_num_tracks+3)&-4;
+  m_pos_iterators.clear();
+  m_pos_iterators.resize(m_num_tracks);
+  m_rot_iterators.clear();
+  m_rot_iterators.resize(m_num_tracks);
+  m_segments.clear();
+  m_segments.resize(m_stride*sampler_num_segment_arrays);
+  restart();
+}
+//----------------------------------------------------------------------------
+
+template<class TrackSet>
+void track_set_sampler<TrackSet>::sample(track_pose &pose_, ufloat_t time_)
+{
+  // restart the tracks if sampling backwards in time
+  PFC_ASSERT_MSG(m_set, ("Track set sampler hasn't been initialized\r\n"));
+  if(pose_.num_tracks()!=m_num_tracks)
+    pose_.resize(m_num_tracks);
+  if(time_<m_time)
+    restart();
+  m_time=time_;
+
+  // advance only tracks whose segments end before the time (4 tracks tested at a time)
+  float *pos_segments=m_segments.data()+sampler_pos_segments*m_stride;
+  float *rot_segments=m_segments.data()+sampler_rot_segments*m_stride;
+  __m128 time=_mm_set1_ps(time_);
+  for(unsigned ti=0; ti<m_stride; ti+=4)
+  {
+    uint32_t pos_mask=uint32_t(_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(pos_segments+ti), time)));
+    while(pos_mask)
+    {
+      unsigned track_idx=ti+bitpos(lsb(pos_mask));
+      advance_sampler_segment(pos_segments, m_stride, track_idx, m_pos_iterators[track_idx], time_, *m_set);
+      pos_mask=strip_lsb(pos_mask);
+    }
+    uint32_t rot_mask=uint32_t(_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(rot_segments+ti), time)));
+    while(rot_mask)
+    {
+      unsigned track_idx=ti+bitpos(lsb(rot_mask));
+      advance_sampler_segment(rot_segments, m_stride, track_idx, m_rot_iterators[track_idx], time_, *m_set);
+      rot_mask=strip_lsb(rot_mask);
+    }
+  }
+
+  // evaluate position and rotation splines 4 tracks at a time
+  float *pos[3]={pose_.pos(0), pose_.pos(1), pose_.pos(2)};
+  float *rot[4]={pose_.rot(0), pose_.rot(1), pose_.rot(2), pose_.rot(3)};
+  __m128 zero=_mm_setzero_ps();
+  for(unsigned ti=0; ti<m_stride; ti+=4)
+  {
+    __m128 v[4];
+    __m128 t=_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(pos_segments+ti), time), zero);
+    eval_sampler_splines<3>(v, pos_segments+m_stride+ti, m_stride, t);
+    for(unsigned ci=0; ci<3; ++ci)
+      _mm_storeu_ps(pos[ci]+ti, v[ci]);
+    t=_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(rot_segments+ti), time), zero);
+    eval_sampler_splines<4>(v, rot_segments+m_stride+ti, m_stride, t);
+    normalize_quats(v);
+    for(unsigned ci=0; ci<4; ++ci)
+      _mm_storeu_ps(rot[ci]+ti, v[ci]);
+  }
+}
+//----------------------------------------------------------------------------
+
+template<class TrackSet>
+void track_set_sampler<TrackSet>::restart()
+{
+  // init track iterators to the start time and store their first segments
+  float *pos_segments=m_segments.data()+sampler_pos_segments*m_stride;
+  float *rot_segments=m_segments.data()+sampler_rot_segments*m_stride;
+  for(unsigned i=0; i<m_num_tracks; ++i)
+  {
+    typename TrackSet::const_iterator_vec3f &pos_it=m_pos_iterators[i];
+    pos_it.init(*m_set, trackchannel_position, i, m_default_pos, m_start_time);
+    set_sampler_segment(pos_segments, m_stride, i, pos_it.segment_end(), pos_it.segment());
+    typename TrackSet::const_iterator_quatf &rot_it=m_rot_iterators[i];
+    rot_it.init(*m_set, trackchannel_rotation, i, m_default_rot, m_start_time);
+    set_sampler_segment(rot_segments, m_stride, i, rot_it.segment_end(), rot_it.segment());
+  }
+
+  // setup identity transforms for padding tracks
+  for(unsigned i=m_num_tracks; i<m_stride; ++i)
+  {
+    set_sampler_end_value(pos_segments, m_stride, i, vec3f(0.0f, 0.0f, 0.0f));
+    set_sampler_end_value(rot_segments, m_stride, i, quatf(0.0f, 0.0f, 0.0f, 1.0f));
+  }
+  m_time=-numeric_type<float>::range_max();
+}
+//----------------------------------------------------------------------------
+
+// explicitly instantiate track set samplers
+template class pfc::track_set_sampler<track_set>;
+template class pfc::track_set_sampler<compressed_track_set>;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// blend_track_poses
+//============================================================================
+void pfc::blend_track_poses(track_pose &res_, const track_pose &pose0_, const track_pose &pose1_, float t_, const float *track_weights_)
+{
+  // lerp positions and nlerp rotations along the shorter arc 4 tracks at a time
+  unsigned num_tracks=pose0_.num_tracks();
+  PFC_ASSERT_MSG(pose1_.num_tracks()==num_tracks, ("Blended poses must have the same number of tracks\r\n"));
+  if(res_.num_tracks()!=num_tracks)
+    res_.resize(num_tracks);
+  const float *pos0[3]={pose0_.pos(0), pose0_.pos(1), pose0_.pos(2)};
+  const float *pos1[3]={pose1_.pos(0), pose1_.pos(1), pose1_.pos(2)};
+  float *res_pos[3]={res_.pos(0), res_.pos(1), res_.pos(2)};
+  const float *rot0[4]={pose0_.rot(0), pose0_.rot(1), pose0_.rot(2), pose0_.rot(3)};
+  const float *rot1[4]={pose1_.rot(0), pose1_.rot(1), pose1_.rot(2), pose1_.rot(3)};
+  float *res_rot[4]={res_.rot(0), res_.rot(1), res_.rot(2), res_.rot(3)};
+  __m128 t=_mm_set1_ps(t_), sign_mask=_mm_set1_ps(-0.0f);
+  for(unsigned ti=0; ti<num_tracks; ti+=4)
+  {
+    // get blend weights for the tracks
+    __m128 bt=t;
+    if(track_weights_)
+    {
+      PFC_ALIGN(16) float weights[4]={0.0f, 0.0f, 0.0f, 0.0f};
+      for(unsigned i=ti, ie=min(ti+4, num_tracks); i<ie; ++i)
+        weights[i-ti]=track_weights_[i];
+      bt=_mm_mul_ps(t, _mm_load_ps(weights));
+    }
+
+    // blend positions
+    for(unsigned ci=0; ci<3; ++ci)
+    {
+      __m128 p0=_mm_loadu_ps(pos0[ci]+ti), p1=_mm_loadu_ps(pos1[ci]+ti);
+      _mm_storeu_ps(res_pos[ci]+ti, _mm_add_ps(p0, _mm_mul_ps(_mm_sub_ps(p1, p0), bt)));
+    }
+
+    // blend rotations, negating the second rotation for negative dot product
+    __m128 q0[4], q1[4];
+    for(unsigned ci=0; ci<4; ++ci)
+    {
+      q0[ci]=_mm_loadu_ps(rot0[ci]+ti);
+      q1[ci]=_mm_loadu_ps(rot1[ci]+ti);
+    }
+    __m128 dot=_mm_add_ps(_mm_add_ps(_mm_mul_ps(q0[0], q1[0]), _mm_mul_ps(q0[1], q1[1])),
+                          _mm_add_ps(_mm_mul_ps(q0[2], q1[2]), _mm_mul_ps(q0[3], q1[3])));
+    __m128 sign=_mm_and_ps(dot, sign_mask);
+    for(unsigned ci=0; ci<4; ++ci)
+      q0[ci]=_mm_add_ps(q0[ci], _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(q1[ci], sign), q0[ci]), bt));
+    normalize_quats(q0);
+    for(unsigned ci=0; ci<4; ++ci)
+      _mm_storeu_ps(res_rot[ci]+ti, q0[ci]);
+  }
+}
+//----------------------------------------------------------------------------
@@ -25,10 +25,14 @@ template<typename> struct track_key_hermite;
 struct track_channel_info;
 struct track_info;
 struct track_set_splinify_settings;
+struct track_set_spline_fit_cache;
 class track_set;
 class compressed_track_set;
+class track_pose;
+template<class TrackSet> class track_set_sampler;
 owner_ptr<track_set> load_track_set(bin_input_stream_base&);
 owner_ptr<track_set> load_track_set(const char *filename_, const char *path_=0);
+void blend_track_poses(track_pose &res_, const track_pose &pose0_, const track_pose &pose1_, float t_, const float *track_weights_=0); // lerp positions & nlerp rotations with t_ (scaled by track weights if given)
 //----------------------------------------------------------------------------
 
 
@@ -137,6 +141,47 @@ struct track_set_splinify_settings
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// track_set_spline_fit_cache
+//============================================================================
+// Channel spline fits of track_set::splinify() and compressed_track_set::init()
+// for incremental fitting. A cached fit of a track channel is reused if the
+// channel keys are unchanged, the fit tolerances differ at most the given
+// percent from the ones used for the fit and, for tighter output tolerance,
+// the cached splines are still within the new tolerance from the keys.
+// Splinify and compression use different segment lengths, so they should use
+// separate caches.
+struct track_set_spline_fit_cache
+{
+  // construction
+  track_set_spline_fit_cache();
+  void clear();
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // channel_fit
+  //==========================================================================
+  template<typename T>
+  struct channel_fit
+  {
+    uint32_t keys_hash;
+    unsigned num_keys;
+    unsigned max_segment_frames;
+    float tolerances[4];
+    array<cubic_spline<T> > splines;
+    array<unsigned> spline_lengths;
+  };
+  //--------------------------------------------------------------------------
+
+  float max_tolerance_change_percent;   // max tolerance change from the cached fit tolerances for reusing the fit
+  unsigned num_reused_fits;             // number of reused channel fits in the last fitting
+  unsigned num_new_fits;                // number of new channel fits in the last fitting
+  array<channel_fit<vec3f> > position_fits;
+  array<channel_fit<quatf> > rotation_fits;
+};
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // track_set
 //============================================================================
@@ -164,7 +209,7 @@ public:
   ~track_set();
   void init(ufloat_t fps_, unsigned num_tracks_, unsigned num_total_channels_, unsigned channel_data_size_);
   void finish_init();
-  void splinify(const track_set&, const track_set_splinify_settings&);
+  void splinify(const track_set&, const track_set_splinify_settings&, track_set_spline_fit_cache *cache_=0);
   e_file_format load(bin_input_stream_base&);
   //--------------------------------------------------------------------------
 
@@ -194,7 +239,7 @@ public:
 
 private:
   template<class PE, typename T> static void serialize_spline_channel(PE&, char *data_, unsigned &data_pos_, unsigned num_frames_, const meta_type<T>&);
-  template<typename T, class Constraint> static void add_channel_spline_fit(array<uint8_t>&, const T *keys_, unsigned num_keys_, Constraint&);
+  template<typename T> static void add_channel_splines(array<uint8_t>&, const track_set_spline_fit_cache::channel_fit<T>&);
   template<typename T> static void add_spline_channel(array<uint8_t>&, const uint8_t *data_, unsigned num_frames_, const meta_type<T>&);
   //--------------------------------------------------------------------------
 
@@ -248,6 +293,11 @@ public:
   PFC_INLINE bool evaluate(T&, ufloat_t time_, const track_set&);
   //--------------------------------------------------------------------------
 
+  // accessors
+  PFC_INLINE ufloat_t segment_end() const;
+  PFC_INLINE const cubic_spline<T> &segment() const;
+  //--------------------------------------------------------------------------
+
 private:
   bool find_segment(ufloat_t &seg_time_, ufloat_t time_, const track_set&);
   //--------------------------------------------------------------------------
@@ -287,8 +337,8 @@ public:
 
   // construction
   compressed_track_set();
-  compressed_track_set(const track_set&, const track_set_splinify_settings&);
-  void init(const track_set&, const track_set_splinify_settings&);
+  compressed_track_set(const track_set&, const track_set_splinify_settings&, track_set_spline_fit_cache *cache_=0);
+  void init(const track_set&, const track_set_splinify_settings&, track_set_spline_fit_cache *cache_=0);
   //--------------------------------------------------------------------------
 
   // accessors
@@ -320,7 +370,7 @@ private:
   compressed_track_set(const compressed_track_set&); // not implemented
   void operator=(const compressed_track_set&); // not implemented
   void init_members();
-  template<class Cfg> void compress_channel(Cfg&, const track_set&, unsigned &channel_offset_writepos_, unsigned &channel_data_writepos_);
+  template<class Cfg> void compress_channel(Cfg&, const track_set&, track_set_spline_fit_cache*, unsigned &channel_offset_writepos_, unsigned &channel_data_writepos_);
   void compress_position_stream(const track_set&, const track_set_splinify_settings&, unsigned &channel_offset_writepos_, unsigned &channel_data_writepos_);
   void compress_rotation_stream(const track_set&, const track_set_splinify_settings&, unsigned &channel_offset_writepos_, unsigned &channel_data_writepos_);
   PFC_INLINE const void *track_channel_data(e_track_channel, unsigned track_index_) const;
@@ -366,6 +416,11 @@ public:
   PFC_INLINE bool evaluate(T&, ufloat_t time_, const compressed_track_set&);
   //--------------------------------------------------------------------------
 
+  // accessors
+  PFC_INLINE ufloat_t segment_end() const;
+  PFC_INLINE const cubic_spline<T> &segment() const;
+  //--------------------------------------------------------------------------
+
 private:
   bool find_segment(ufloat_t &seg_time_, ufloat_t time_, const compressed_track_set&);
   //--------------------------------------------------------------------------
@@ -377,6 +432,83 @@ private:
 };
 //----------------------------------------------------------------------------
 
+
+//============================================================================
+// track_pose
+//============================================================================
+// Track positions and rotations (e.g. skeleton joint transforms) in SoA
+// component arrays, which are padded to multiple of 4 tracks.
+class track_pose
+{
+public:
+  // construction
+  track_pose();
+  explicit track_pose(unsigned num_tracks_);
+  void resize(unsigned num_tracks_);
+  //--------------------------------------------------------------------------
+
+  // accessors
+  PFC_INLINE unsigned num_tracks() const;
+  PFC_INLINE const float *pos(unsigned comp_idx_) const;  // position x, y or z array
+  PFC_INLINE float *pos(unsigned comp_idx_);
+  PFC_INLINE const float *rot(unsigned comp_idx_) const;  // rotation quaternion x, y, z or w array
+  PFC_INLINE float *rot(unsigned comp_idx_);
+  PFC_INLINE vec3f position(unsigned track_index_) const;
+  PFC_INLINE quatf rotation(unsigned track_index_) const;
+  PFC_INLINE void set(unsigned track_index_, const vec3f &pos_, const quatf &rot_);
+  //--------------------------------------------------------------------------
+
+private:
+  unsigned m_num_tracks;
+  unsigned m_stride;
+  array<float> m_data;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// track_set_sampler
+//============================================================================
+// Samples all tracks of track_set or compressed_track_set to track_pose. The
+// current spline segments of the tracks are kept in SoA arrays, so that the
+// segments are evaluated and rotations normalized 4 tracks at a time, and
+// only tracks passing their segment end are advanced with track iterators.
+// Sampling time should increase between calls: sampling earlier time than the
+// previous one restarts the tracks from the start time.
+template<class TrackSet>
+class track_set_sampler
+{
+public:
+  // construction
+  track_set_sampler();
+  track_set_sampler(const TrackSet&, float start_time_=0.0f);
+  void init(const TrackSet&, float start_time_=0.0f, const vec3f &default_pos_=vec3f(0.0f, 0.0f, 0.0f), const quatf &default_rot_=quatf(0.0f, 0.0f, 0.0f, 1.0f));
+  //--------------------------------------------------------------------------
+
+  // sampling
+  PFC_INLINE unsigned num_tracks() const;
+  void sample(track_pose&, ufloat_t time_);
+  //--------------------------------------------------------------------------
+
+private:
+  track_set_sampler(const track_set_sampler&); // not implemented
+  void operator=(const track_set_sampler&); // not implemented
+  void restart();
+  //--------------------------------------------------------------------------
+
+  const TrackSet *m_set;
+  float m_start_time;
+  ufloat_t m_time;
+  vec3f m_default_pos;
+  quatf m_default_rot;
+  unsigned m_num_tracks;
+  unsigned m_stride;
+  array<typename TrackSet::const_iterator_vec3f> m_pos_iterators;
+  array<typename TrackSet::const_iterator_quatf> m_rot_iterators;
+  array<float> m_segments;  // SoA segment end times and spline coefficients of position and rotation channels
+};
+//----------------------------------------------------------------------------
+
 //============================================================================
 #include "track_set.inl"
 } // namespace pfc
@@ -227,6 +227,20 @@ bool track_set::const_iterator<T>::evaluate(T &v_, ufloat_t time_, const track_s
 }
 //----------------------------------------------------------------------------
 
+template<typename T>
+ufloat_t track_set::const_iterator<T>::segment_end() const
+{
+  return m_segment_end;
+}
+//----
+
+template<typename T>
+const cubic_spline<T> &track_set::const_iterator<T>::segment() const
+{
+  return m_segment;
+}
+//----------------------------------------------------------------------------
+
 
 //============================================================================
 // track_set::track_data
@@ -389,3 +403,96 @@ bool compressed_track_set::const_iterator<T>::evaluate(T &v_, ufloat_t time_, co
   return true;
 }
 //----------------------------------------------------------------------------
+
+template<typename T>
+ufloat_t compressed_track_set::const_iterator<T>::segment_end() const
+{
+  return m_segment_end;
+}
+//----
+
+template<typename T>
+const cubic_spline<T> &compressed_track_set::const_iterator<T>::segment() const
+{
+  return m_segment;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// track_pose
+//============================================================================
+unsigned track_pose::num_tracks() const
+{
+  return m_num_tracks;
+}
+//----
+
+const float *track_pose::pos(unsigned comp_idx_) const
+{
+  PFC_ASSERT_PEDANTIC(comp_idx_<3);
+  return m_data.data()+comp_idx_*m_stride;
+}
+//----
+
+float *track_pose::pos(unsigned comp_idx_)
+{
+  PFC_ASSERT_PEDANTIC(comp_idx_<3);
+  return m_data.data()+comp_idx_*m_stride;
+}
+//----
+
+const float *track_pose::rot(unsigned comp_idx_) const
+{
+  PFC_ASSERT_PEDANTIC(comp_idx_<4);
+  return m_data.data()+(comp_idx_+3)*m_stride;
+}
+//----
+
+float *track_pose::rot(unsigned comp_idx_)
+{
+  PFC_ASSERT_PEDANTIC(comp_idx_<4);
+  return m_data.data()+(comp_idx_+3)*m_stride;
+}
+//----
+
+vec3f track_pose::position(unsigned track_index_) const
+{
+  PFC_ASSERT_PEDANTIC(track_index_<m_num_tracks);
+  const float *data=m_data.data()+track_index_;
+  return vec3f(data[0], data[m_stride], data[2*m_stride]);
+}
+//----
+
+quatf track_pose::rotation(unsigned track_index_) const
+{
+  PFC_ASSERT_PEDANTIC(track_index_<m_num_tracks);
+  const float *data=m_data.data()+3*m_stride+track_index_;
+  return quatf(data[0], data[m_stride], data[2*m_stride], data[3*m_stride]);
+}
+//----
+
+void track_pose::set(unsigned track_index_, const vec3f &pos_, const quatf &rot_)
+{
+  PFC_ASSERT_PEDANTIC(track_index_<m_num_tracks);
+  float *data=m_data.data()+track_index_;
+  data[0]=pos_.x;
+  data[m_stride]=pos_.y;
+  data[2*m_stride]=pos_.z;
+  data[3*m_stride]=rot_.x;
+  data[4*m_stride]=rot_.y;
+  data[5*m_stride]=rot_.z;
+  data[6*m_stride]=rot_.w;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// track_set_sampler
+//============================================================================
+template<class TrackSet>
+unsigned track_set_sampler<TrackSet>::num_tracks() const
+{
+  return m_num_tracks;
+}
+//----------------------------------------------------------------------------
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <time.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <iostream>
 using namespace pfc;
 //----------------------------------------------------------------------------
@@ -131,3 +132,39 @@ int pfc::system_call(const char *cmd_)
   return system(cmd_);
 }
 //----------------------------------------------------------------------------
+
+
+//============================================================================
+// map_os_memory
+//============================================================================
+void *pfc::map_os_memory(usize_t num_bytes_, usize_t align_, bool huge_pages_)
+{
+  // map aligned memory by over-allocating and unmapping the unaligned head & tail
+  usize_t page_size=usize_t(sysconf(_SC_PAGESIZE));
+  num_bytes_=(num_bytes_+page_size-1)&-page_size;
+  if(align_<page_size)
+    align_=page_size;
+  usize_t map_size=num_bytes_+align_-page_size;
+  void *p=mmap(0, map_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if(p==MAP_FAILED)
+    return 0;
+  usize_t head=((usize_t(p)+align_-1)&-align_)-usize_t(p);
+  if(head)
+    munmap(p, head);
+  if(map_size-head>num_bytes_)
+    munmap((char*)p+head+num_bytes_, map_size-head-num_bytes_);
+  p=(char*)p+head;
+#ifdef MADV_HUGEPAGE
+  if(huge_pages_)
+    madvise(p, num_bytes_, MADV_HUGEPAGE);
+#endif
+  return p;
+}
+//----
+
+void pfc::unmap_os_memory(void *p_, usize_t num_bytes_)
+{
+  if(p_)
+    munmap(p_, num_bytes_);
+}
+//----------------------------------------------------------------------------
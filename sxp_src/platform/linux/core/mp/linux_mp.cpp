@@ -8,6 +8,10 @@
 #include "sxp_src/sxp_pch.h"
 #include "sxp_src/core/mp/mp.h"
 #include "sxp_src/core/math/bit_math.h"
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 using namespace pfc;
 //----------------------------------------------------------------------------
 
@@ -86,6 +90,26 @@ void mp_thread::start()
   m_handle.is_running=true;
   PFC_VERIFY_MSG(pthread_create(&m_handle.thread_id, &m_handle.thread_attr, &thread_proc, this)==0, ("Thread creation failed"));
 }
+//----
+
+void mp_thread::set_priority(e_thread_priority priority_)
+{
+  // map the priority to a scheduling policy (raising priority above normal requires privileges, so failures are ignored)
+  PFC_ASSERT_MSG(m_handle.thread_id, ("Thread has not been started"));
+  sched_param param;
+  param.sched_priority=0;
+  switch(priority_)
+  {
+    case threadpriority_idle:     pthread_setschedparam(m_handle.thread_id, SCHED_IDLE, &param); break;
+    case threadpriority_lower:    pthread_setschedparam(m_handle.thread_id, SCHED_BATCH, &param); break;
+    case threadpriority_low:      pthread_setschedparam(m_handle.thread_id, SCHED_BATCH, &param); break;
+    case threadpriority_normal:   pthread_setschedparam(m_handle.thread_id, SCHED_OTHER, &param); break;
+    case threadpriority_high:     pthread_setschedparam(m_handle.thread_id, SCHED_OTHER, &param); break;
+    case threadpriority_higher:   param.sched_priority=sched_get_priority_min(SCHED_RR); pthread_setschedparam(m_handle.thread_id, SCHED_RR, &param); break;
+    case threadpriority_realtime: param.sched_priority=sched_get_priority_max(SCHED_FIFO); pthread_setschedparam(m_handle.thread_id, SCHED_FIFO, &param); break;
+    default: PFC_ERROR("Unknown thread priority\r\n");
+  }
+}
 //----------------------------------------------------------------------------
 
 bool mp_thread::is_terminated() const
@@ -98,26 +122,354 @@ bool mp_thread::is_terminated() const
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// mp_fiber
+//============================================================================
+// config
+static const usize_t s_fiber_default_stack_size=256*1024;
+// context switch: pushes callee-saved registers and SSE/x87 control words to
+// the current stack, stores the stack pointer to *save_sp_ and pops the state
+// of the other context from load_sp_. fiber entry calls proc(fiber) with the
+// values initialized to the registers of a new fiber context
+extern "C" void pfc_fiber_switch_context(void **save_sp_, void *load_sp_);
+extern "C" void pfc_fiber_entry();
+#if defined(__x86_64__)
+asm(".text\n"
+    ".globl pfc_fiber_switch_context\n"
+    ".type pfc_fiber_switch_context, @function\n"
+    "pfc_fiber_switch_context:\n"
+    "  pushq %rbp\n"
+    "  pushq %rbx\n"
+    "  pushq %r12\n"
+    "  pushq %r13\n"
+    "  pushq %r14\n"
+    "  pushq %r15\n"
+    "  subq $8, %rsp\n"
+    "  stmxcsr (%rsp)\n"
+    "  fnstcw 4(%rsp)\n"
+    "  movq %rsp, (%rdi)\n"
+    "  movq %rsi, %rsp\n"
+    "  ldmxcsr (%rsp)\n"
+    "  fldcw 4(%rsp)\n"
+    "  addq $8, %rsp\n"
+    "  popq %r15\n"
+    "  popq %r14\n"
+    "  popq %r13\n"
+    "  popq %r12\n"
+    "  popq %rbx\n"
+    "  popq %rbp\n"
+    "  ret\n"
+    ".size pfc_fiber_switch_context, .-pfc_fiber_switch_context\n"
+    ".globl pfc_fiber_entry\n"
+    ".type pfc_fiber_entry, @function\n"
+    "pfc_fiber_entry:\n"
+    "  movq %r12, %rdi\n"
+    "  call *%r13\n"
+    "  ud2\n"
+    ".size pfc_fiber_entry, .-pfc_fiber_entry\n");
+enum {fiber_context_words=10, fiber_context_proc=3, fiber_context_arg=4, fiber_context_entry=7};
+#elif defined(__i386__)
+asm(".text\n"
+    ".globl pfc_fiber_switch_context\n"
+    ".type pfc_fiber_switch_context, @function\n"
+    "pfc_fiber_switch_context:\n"
+    "  movl 4(%esp), %eax\n"
+    "  movl 8(%esp), %edx\n"
+    "  pushl %ebp\n"
+    "  pushl %ebx\n"
+    "  pushl %esi\n"
+    "  pushl %edi\n"
+    "  subl $8, %esp\n"
+    "  stmxcsr (%esp)\n"
+    "  fnstcw 4(%esp)\n"
+    "  movl %esp, (%eax)\n"
+    "  movl %edx, %esp\n"
+    "  ldmxcsr (%esp)\n"
+    "  fldcw 4(%esp)\n"
+    "  addl $8, %esp\n"
+    "  popl %edi\n"
+    "  popl %esi\n"
+    "  popl %ebx\n"
+    "  popl %ebp\n"
+    "  ret\n"
+    ".size pfc_fiber_switch_context, .-pfc_fiber_switch_context\n"
+    ".globl pfc_fiber_entry\n"
+    ".type pfc_fiber_entry, @function\n"
+    "pfc_fiber_entry:\n"
+    "  pushl %esi\n"
+    "  call *%edi\n"
+    "  ud2\n"
+    ".size pfc_fiber_entry, .-pfc_fiber_entry\n");
+enum {fiber_context_words=10, fiber_context_proc=2, fiber_context_arg=3, fiber_context_entry=6};
+#else
+#error mp_fiber context switch not implemented for the target architecture
+#endif
+static PFC_THREAD_VAR mp_fiber *s_active_fiber=0;
+//----------------------------------------------------------------------------
+
+void mp_fiber::fiber_proc(void *fiber_)
+{
+  // run the fiber function and return to the resumer for good
+  mp_fiber *f=static_cast<mp_fiber*>(fiber_);
+  f->m_func();
+  f->m_handle.is_finished=true;
+  pfc_fiber_switch_context(&f->m_handle.context, f->m_handle.resumer_context);
+}
+//----------------------------------------------------------------------------
+
+mp_fiber::mp_fiber()
+{
+  m_handle.stack=0;
+  m_handle.stack_size=0;
+  m_handle.context=0;
+  m_handle.resumer_context=0;
+  m_handle.is_finished=false;
+  m_resumer=0;
+}
+//----
+
+mp_fiber::mp_fiber(const functor<void()> &f_, usize_t stack_size_)
+{
+  m_handle.stack=0;
+  m_handle.stack_size=0;
+  m_handle.context=0;
+  m_handle.resumer_context=0;
+  m_handle.is_finished=false;
+  m_resumer=0;
+  init(f_, stack_size_);
+}
+//----
+
+void mp_fiber::init(const functor<void()> &f_, usize_t stack_size_)
+{
+  // map stack with a guard page below it
+  PFC_ASSERT_MSG(!m_handle.stack, ("Fiber has already been initialized\r\n"));
+  usize_t page_size=usize_t(sysconf(_SC_PAGESIZE));
+  usize_t stack_size=((stack_size_?stack_size_:s_fiber_default_stack_size)+page_size-1)&~(page_size-1);
+  m_handle.stack_size=stack_size+page_size;
+  m_handle.stack=map_os_memory(m_handle.stack_size, page_size);
+  PFC_VERIFY_MSG(mprotect(m_handle.stack, page_size, PROT_NONE)==0, ("Unable to setup fiber stack guard page\r\n"));
+
+  // setup the initial context to enter fiber_proc() upon the first resume
+  usize_t *context=(usize_t*)((uint8_t*)m_handle.stack+m_handle.stack_size)-fiber_context_words;
+  mem_zero(context, fiber_context_words*sizeof(usize_t));
+  uint32_t *control_words=(uint32_t*)context;
+  control_words[0]=0x1f80;  // default MXCSR
+  control_words[1]=0x037f;  // default x87 control word
+  context[fiber_context_proc]=usize_t(&fiber_proc);
+  context[fiber_context_arg]=usize_t(this);
+  context[fiber_context_entry]=usize_t(&pfc_fiber_entry);
+  m_handle.context=context;
+  m_handle.is_finished=false;
+  m_func=f_;
+}
+//----
+
+mp_fiber::~mp_fiber()
+{
+  PFC_ASSERT_MSG(!m_handle.stack || s_active_fiber!=this, ("Destroying an active fiber\r\n"));
+  if(m_handle.stack)
+    unmap_os_memory(m_handle.stack, m_handle.stack_size);
+}
+//----------------------------------------------------------------------------
+
+void mp_fiber::resume()
+{
+  // switch to the fiber and restore the active fiber once the fiber suspends
+  PFC_ASSERT_MSG(m_handle.stack, ("Resuming an uninitialized fiber\r\n"));
+  PFC_ASSERT_MSG(!m_handle.is_finished, ("Resuming a finished fiber\r\n"));
+  m_resumer=s_active_fiber;
+  s_active_fiber=this;
+  pfc_fiber_switch_context(&m_handle.resumer_context, m_handle.context);
+  s_active_fiber=m_resumer;
+}
+//----
+
+void mp_fiber::suspend()
+{
+  // switch back to the context which resumed the active fiber
+  mp_fiber *f=s_active_fiber;
+  PFC_ASSERT_MSG(f, ("Suspending a thread which isn't running a fiber\r\n"));
+  pfc_fiber_switch_context(&f->m_handle.context, f->m_handle.resumer_context);
+}
+//----
+
+mp_fiber *mp_fiber::active()
+{
+  return s_active_fiber;
+}
+//----------------------------------------------------------------------------
+
+bool mp_fiber::is_finished() const
+{
+  return m_handle.is_finished;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// futex parking
+//============================================================================
+// config
+static const int32_t s_futex_min_spins=16;
+static const int32_t s_futex_max_spins=128;
+static int32_t s_futex_spin_limit=-1; // resolved at first contention (no spinning on single hardware thread systems)
+//----------------------------------------------------------------------------
+
+static PFC_INLINE void futex_spin_pause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  asm volatile("pause" ::: "memory");
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#else
+  asm volatile("" ::: "memory");
+#endif
+}
+//----
+
+static int32_t futex_spin_budget(int32_t spin_count_)
+{
+  // spin up to twice the recent average of successful spins
+  int32_t limit=s_futex_spin_limit;
+  if(limit<0)
+    s_futex_spin_limit=limit=num_hardware_threads()>1?s_futex_max_spins:0;
+  return min(spin_count_*2+s_futex_min_spins, limit);
+}
+//----
+
+static void futex_update_spin_count(int32_t &spin_count_, int32_t num_spins_, bool is_success_)
+{
+  // track the average of successful spins and back off when spinning fails
+  if(is_success_)
+    spin_count_+=(num_spins_-spin_count_)/8;
+  else
+    spin_count_/=2;
+}
+//----
+
+static const timespec *futex_deadline(timespec &ts_, float timeout_secs_)
+{
+  // absolute monotonic deadline of the timeout (null for infinite wait)
+  if(timeout_secs_<=0.0f)
+    return 0;
+  PFC_VERIFY_MSG(clock_gettime(CLOCK_MONOTONIC, &ts_)==0,
+                 ("Monotonic clock query for the futex wait failed\r\n"));
+  int64_t timeout_ns=int64_t(timeout_secs_*1000000000.0+0.5);
+  ts_.tv_sec+=time_t(timeout_ns/1000000000ll);
+  ts_.tv_nsec+=long(timeout_ns%1000000000ll);
+  if(ts_.tv_nsec>=1000000000) {ts_.tv_sec++; ts_.tv_nsec-=1000000000;}
+  return &ts_;
+}
+//----
+
+static bool futex_park(volatile int32_t &word_, int32_t val_, const timespec *deadline_)
+{
+  // park the thread while word_==val_ until woken, returns false if the deadline passed
+  if(syscall(SYS_futex, &word_, FUTEX_WAIT_BITSET|FUTEX_PRIVATE_FLAG, val_, deadline_, 0, FUTEX_BITSET_MATCH_ANY)==0)
+    return true;
+  PFC_ASSERT_MSG(errno==EAGAIN || errno==EINTR || errno==ETIMEDOUT, ("Futex wait failed\r\n"));
+  return errno!=ETIMEDOUT;
+}
+//----------------------------------------------------------------------------
+
+bool pfc::mp_futex_wait_event(mp_event_handle_t &handle_, float timeout_secs_)
+{
+  // spin adaptively for the trigger
+  int32_t max_spins=futex_spin_budget(handle_.spin_count);
+  for(int32_t i=0; i<max_spins; ++i)
+  {
+    futex_spin_pause();
+    if(handle_.state && atom_cmov_eq(handle_.state, int32_t(0), int32_t(1))==1)
+    {
+      futex_update_spin_count(handle_.spin_count, i+1, true);
+      return true;
+    }
+  }
+  if(max_spins)
+    futex_update_spin_count(handle_.spin_count, max_spins, false);
+
+  // park the thread until the trigger is consumed or the wait times out
+  timespec ts;
+  const timespec *deadline=futex_deadline(ts, timeout_secs_);
+  atom_inc(handle_.num_waiters);
+  bool is_triggered;
+  while(!(is_triggered=atom_cmov_eq(handle_.state, int32_t(0), int32_t(1))==1) && futex_park(handle_.state, 0, deadline));
+  atom_dec(handle_.num_waiters);
+  return is_triggered;
+}
+//----
+
+bool pfc::mp_futex_wait_gate(mp_gate_handle_t &handle_, float timeout_secs_)
+{
+  // spin adaptively for the gate to open
+  int32_t max_spins=futex_spin_budget(handle_.spin_count);
+  for(int32_t i=0; i<max_spins; ++i)
+  {
+    futex_spin_pause();
+    if(handle_.state)
+    {
+      futex_update_spin_count(handle_.spin_count, i+1, true);
+      return true;
+    }
+  }
+  if(max_spins)
+    futex_update_spin_count(handle_.spin_count, max_spins, false);
+
+  // park the thread until the gate opens or the wait times out
+  timespec ts;
+  const timespec *deadline=futex_deadline(ts, timeout_secs_);
+  atom_inc(handle_.num_waiters);
+  bool is_open;
+  while(!(is_open=atom_read(handle_.state)!=0) && futex_park(handle_.state, 0, deadline));
+  atom_dec(handle_.num_waiters);
+  return is_open;
+}
+//----
+
+void pfc::mp_futex_enter(mp_critical_section_handle_t &handle_)
+{
+  // spin adaptively for the lock to be released
+  int32_t max_spins=futex_spin_budget(handle_.spin_count);
+  for(int32_t i=0; i<max_spins; ++i)
+  {
+    futex_spin_pause();
+    if(!handle_.state && atom_cmov_eq(handle_.state, int32_t(1), int32_t(0))==0)
+    {
+      futex_update_spin_count(handle_.spin_count, i+1, true);
+      return;
+    }
+  }
+  if(max_spins)
+    futex_update_spin_count(handle_.spin_count, max_spins, false);
+
+  // mark the lock contended and park until it's released
+  while(atom_mov(handle_.state, int32_t(2))!=0)
+    futex_park(handle_.state, 2, 0);
+}
+//----
+
+void pfc::mp_futex_wake(volatile int32_t &word_, int32_t max_threads_)
+{
+  syscall(SYS_futex, &word_, FUTEX_WAKE|FUTEX_PRIVATE_FLAG, max_threads_, 0, 0, 0);
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // mp_event
 //============================================================================
 mp_event::mp_event()
 {
-  // bind event timed waits to a monotonic clock so wall-clock changes don't perturb them
-  pthread_condattr_t cond_attr;
-  PFC_VERIFY_MSG(pthread_condattr_init(&cond_attr)==0, ("Condition variable attribute creation for the event failed"));
-  PFC_VERIFY_MSG(pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC)==0, ("Condition variable clock selection for the event failed"));
-  PFC_VERIFY_MSG(pthread_cond_init(&m_handle.cond, &cond_attr)==0, ("Condition variable creation for the event failed"));
-  PFC_VERIFY_MSG(pthread_condattr_destroy(&cond_attr)==0, ("Condition variable attribute destruction for the event failed"));
-  PFC_VERIFY_MSG(pthread_mutex_init(&m_handle.mutex, 0)==0, ("Mutex creation for the event failed"));
-  m_handle.is_triggered=false;
+  m_handle.state=0;
+  m_handle.num_waiters=0;
+  m_handle.spin_count=0;
 }
 //----
 
 mp_event::~mp_event()
 {
-  PFC_VERIFY_MSG(pthread_cond_destroy(&m_handle.cond)==0, ("Condition variable destruction for the event failed"));
-  PFC_VERIFY_MSG(pthread_mutex_destroy(&m_handle.mutex)==0, ("Mutex destruction for the event failed"));
+  PFC_ASSERT_MSG(!m_handle.num_waiters, ("Destroying event with waiting threads\r\n"));
 }
 //----------------------------------------------------------------------------
 
@@ -127,21 +479,15 @@ mp_event::~mp_event()
 //============================================================================
 mp_gate::mp_gate()
 {
-  // bind gate timed waits to a monotonic clock so wall-clock changes don't perturb them
-  pthread_condattr_t cond_attr;
-  PFC_VERIFY_MSG(pthread_condattr_init(&cond_attr)==0, ("Condition variable attribute creation for the gate failed"));
-  PFC_VERIFY_MSG(pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC)==0, ("Condition variable clock selection for the gate failed"));
-  PFC_VERIFY_MSG(pthread_cond_init(&m_handle.cond, &cond_attr)==0, ("Condition variable creation for the gate failed"));
-  PFC_VERIFY_MSG(pthread_condattr_destroy(&cond_attr)==0, ("Condition variable attribute destruction for the gate failed"));
-  PFC_VERIFY_MSG(pthread_mutex_init(&m_handle.mutex, 0)==0, ("Mutex creation for the gate failed"));
-  m_handle.is_open=false;
+  m_handle.state=0;
+  m_handle.num_waiters=0;
+  m_handle.spin_count=0;
 }
 //----
 
 mp_gate::~mp_gate()
 {
-  PFC_VERIFY_MSG(pthread_cond_destroy(&m_handle.cond)==0, ("Condition variable destruction for the gate failed"));
-  PFC_VERIFY_MSG(pthread_mutex_destroy(&m_handle.mutex)==0, ("Mutex destruction for the gate failed"));
+  PFC_ASSERT_MSG(!m_handle.num_waiters, ("Destroying gate with waiting threads\r\n"));
 }
 //----------------------------------------------------------------------------
 
@@ -151,13 +497,14 @@ mp_gate::~mp_gate()
 //============================================================================
 mp_critical_section::mp_critical_section()
 {
-  PFC_VERIFY_MSG(pthread_mutex_init(&m_handle, 0)==0, ("Critical section creation failed"));
+  m_handle.state=0;
+  m_handle.spin_count=0;
 }
 //----
 
 mp_critical_section::~mp_critical_section()
 {
-  PFC_VERIFY_MSG(pthread_mutex_destroy(&m_handle)==0, ("Critical section destruction failed"));
+  PFC_ASSERT_MSG(!m_handle.state, ("Destroying critical section that's still entered\r\n"));
 }
 //----------------------------------------------------------------------------
 
@@ -167,15 +514,49 @@ mp_critical_section::~mp_critical_section()
 //============================================================================
 void pfc::set_hardware_thread(unsigned hw_thread_idx_)
 {
-  /*todo*/
-  PFC_ERROR_NOT_IMPL();
+  // set calling thread to run on given hardware thread
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(hw_thread_idx_, &cpuset);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
 }
 //----
 
 unsigned pfc::num_hardware_threads()
 {
-  /*todo*/
-  PFC_ERROR_NOT_IMPL();
-  return 0;
+  // return number of hardware threads
+  long num_threads=sysconf(_SC_NPROCESSORS_ONLN);
+  return num_threads>0?unsigned(num_threads):1;
+}
+//----
+
+usize_t pfc::create_thread_exit_key(void(*exit_func_)(void*))
+{
+  pthread_key_t key;
+  PFC_VERIFY_MSG(pthread_key_create(&key, exit_func_)==0, ("Unable to create thread exit key\r\n"));
+  return usize_t(key);
+}
+//----
+
+void pfc::set_thread_exit_value(usize_t key_, void *v_)
+{
+  pthread_setspecific(pthread_key_t(key_), v_);
+}
+//----
+
+void pfc::set_process_priority(e_process_priority priority_)
+{
+  // map the priority to a nice value (negative values require privileges, so failures are ignored)
+  switch(priority_)
+  {
+    case processpriority_idle:     setpriority(PRIO_PROCESS, 0, 19); break;
+    case processpriority_lower:    setpriority(PRIO_PROCESS, 0, 10); break;
+    case processpriority_low:      setpriority(PRIO_PROCESS, 0, 5); break;
+    case processpriority_normal:   setpriority(PRIO_PROCESS, 0, 0); break;
+    case processpriority_high:     setpriority(PRIO_PROCESS, 0, -5); break;
+    case processpriority_higher:   setpriority(PRIO_PROCESS, 0, -10); break;
+    case processpriority_realtime: setpriority(PRIO_PROCESS, 0, -20); break;
+    default: PFC_ERROR("Unknown process priority\r\n");
+  }
 }
 //----------------------------------------------------------------------------
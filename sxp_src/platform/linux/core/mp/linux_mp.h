@@ -24,10 +24,17 @@ namespace pfc
 
 // new
 struct mp_thread_handle_t {pthread_t thread_id; pthread_attr_t thread_attr; bool is_running;};
-struct mp_event_handle_t {pthread_cond_t cond; pthread_mutex_t mutex; bool is_triggered;};
-struct mp_gate_handle_t {pthread_cond_t cond; pthread_mutex_t mutex; bool is_open;};
-typedef pthread_mutex_t mp_critical_section_handle_t;
+struct mp_fiber_handle_t {void *stack; usize_t stack_size; void *context; void *resumer_context; bool is_finished;};
+struct mp_event_handle_t {volatile int32_t state; volatile int32_t num_waiters; int32_t spin_count;};
+struct mp_gate_handle_t {volatile int32_t state; volatile int32_t num_waiters; int32_t spin_count;};
+struct mp_critical_section_handle_t {volatile int32_t state; int32_t spin_count;}; // state: 0=free, 1=locked, 2=locked with parked waiters
+// futex slow paths (spin adaptively before parking the thread)
+bool mp_futex_wait_event(mp_event_handle_t&, float timeout_secs_);
+bool mp_futex_wait_gate(mp_gate_handle_t&, float timeout_secs_);
+void mp_futex_enter(mp_critical_section_handle_t&);
+void mp_futex_wake(volatile int32_t&, int32_t max_threads_);
 #define PFC_THREAD_PROC void *thread_proc(void*)
+#define PFC_FIBER_PROC void fiber_proc(void*)
 //----------------------------------------------------------------------------
 
 //============================================================================
@@ -83,6 +83,98 @@ bool mp_thread::is_terminated() const
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// mp_fiber
+//============================================================================
+static const usize_t s_fiber_default_stack_size=256*1024;
+static PFC_THREAD_VAR mp_fiber *s_active_fiber=0;
+//----------------------------------------------------------------------------
+
+VOID WINAPI mp_fiber::fiber_proc(void *fiber_)
+{
+  // run the fiber function and return to the resumer for good
+  mp_fiber *f=static_cast<mp_fiber*>(fiber_);
+  f->m_func();
+  f->m_handle.is_finished=true;
+  SwitchToFiber(f->m_handle.resumer_fiber);
+}
+//----------------------------------------------------------------------------
+
+mp_fiber::mp_fiber()
+{
+  m_handle.fiber=0;
+  m_handle.resumer_fiber=0;
+  m_handle.is_finished=false;
+  m_resumer=0;
+}
+//----
+
+mp_fiber::mp_fiber(const functor<void()> &f_, usize_t stack_size_)
+{
+  m_handle.fiber=0;
+  m_handle.resumer_fiber=0;
+  m_handle.is_finished=false;
+  m_resumer=0;
+  init(f_, stack_size_);
+}
+//----
+
+void mp_fiber::init(const functor<void()> &f_, usize_t stack_size_)
+{
+  // create fiber (the system reserves the stack with a guard page)
+  PFC_ASSERT_MSG(!m_handle.fiber, ("Fiber has already been initialized\r\n"));
+  m_handle.fiber=CreateFiberEx(0, stack_size_?stack_size_:s_fiber_default_stack_size, 0, &fiber_proc, this);
+  PFC_CHECK_MSG(m_handle.fiber, ("Fiber creation failed\r\n"));
+  m_handle.is_finished=false;
+  m_func=f_;
+}
+//----
+
+mp_fiber::~mp_fiber()
+{
+  PFC_ASSERT_MSG(!m_handle.fiber || s_active_fiber!=this, ("Destroying an active fiber\r\n"));
+  if(m_handle.fiber)
+    DeleteFiber(m_handle.fiber);
+}
+//----------------------------------------------------------------------------
+
+void mp_fiber::resume()
+{
+  // switch to the fiber (converting the thread to a fiber if necessary)
+  PFC_ASSERT_MSG(m_handle.fiber, ("Resuming an uninitialized fiber\r\n"));
+  PFC_ASSERT_MSG(!m_handle.is_finished, ("Resuming a finished fiber\r\n"));
+  if(!IsThreadAFiber())
+    PFC_VERIFY_MSG(ConvertThreadToFiber(0)!=0, ("Unable to convert thread to fiber\r\n"));
+  m_resumer=s_active_fiber;
+  s_active_fiber=this;
+  m_handle.resumer_fiber=GetCurrentFiber();
+  SwitchToFiber(m_handle.fiber);
+  s_active_fiber=m_resumer;
+}
+//----
+
+void mp_fiber::suspend()
+{
+  // switch back to the context which resumed the active fiber
+  mp_fiber *f=s_active_fiber;
+  PFC_ASSERT_MSG(f, ("Suspending a thread which isn't running a fiber\r\n"));
+  SwitchToFiber(f->m_handle.resumer_fiber);
+}
+//----
+
+mp_fiber *mp_fiber::active()
+{
+  return s_active_fiber;
+}
+//----------------------------------------------------------------------------
+
+bool mp_fiber::is_finished() const
+{
+  return m_handle.is_finished;
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // mp_event
 //============================================================================
@@ -152,6 +244,21 @@ unsigned pfc::num_hardware_threads()
 }
 //----
 
+usize_t pfc::create_thread_exit_key(void(*exit_func_)(void*))
+{
+  // use fiber local storage for the thread exit callback
+  DWORD key=FlsAlloc((PFLS_CALLBACK_FUNCTION)exit_func_);
+  PFC_VERIFY_MSG(key!=FLS_OUT_OF_INDEXES, ("Unable to create thread exit key\r\n"));
+  return usize_t(key);
+}
+//----
+
+void pfc::set_thread_exit_value(usize_t key_, void *v_)
+{
+  FlsSetValue(DWORD(key_), v_);
+}
+//----
+
 void pfc::set_process_priority(e_process_priority priority_)
 {
   HANDLE phandle=GetCurrentProcess();
@@ -19,10 +19,12 @@ namespace pfc
 
 // new
 typedef HANDLE mp_thread_handle_t;
+struct mp_fiber_handle_t {void *fiber, *resumer_fiber; bool is_finished;};
 typedef HANDLE mp_event_handle_t;
 typedef HANDLE mp_gate_handle_t;
 typedef CRITICAL_SECTION mp_critical_section_handle_t;
 #define PFC_THREAD_PROC DWORD WINAPI thread_proc(void*)
+#define PFC_FIBER_PROC VOID WINAPI fiber_proc(void*)
 //----------------------------------------------------------------------------
 
 //============================================================================
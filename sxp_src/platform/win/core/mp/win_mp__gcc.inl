@@ -67,14 +67,14 @@ namespace priv
     template<typename T>
     static PFC_INLINE int8_t op_read(const volatile T &src_)
     {
-      return (const int8_t&)src_;
+      return *(const volatile int8_t*)&src_;
     }
     //----
 
     template<typename T>
     static PFC_INLINE void op_write(volatile T &dst_, T v_)
     {
-      (volatile int8_t&)dst_=(const int8_t&)v_;
+      (volatile int8_t&)dst_=*(const int8_t*)&v_;
     }
     //----
 
@@ -149,7 +149,7 @@ namespace priv
     static PFC_INLINE int16_t op_read(const volatile T &src_)
     {
       PFC_STATIC_ASSERT_MSG(meta_alignof<T>::res>=2, alignment_restrictions_of_the_type_are_not_strict_enough_for_the_atomic_operation);
-      return (const int16_t&)src_;
+      return *(const volatile int16_t*)&src_;
     }
     //----
 
@@ -157,7 +157,7 @@ namespace priv
     static PFC_INLINE void op_write(volatile T &dst_, T v_)
     {
       PFC_STATIC_ASSERT_MSG(meta_alignof<T>::res>=2, alignment_restrictions_of_the_type_are_not_strict_enough_for_the_atomic_operation);
-      (volatile int16_t&)dst_=(const int16_t&)v_;
+      (volatile int16_t&)dst_=*(const int16_t*)&v_;
     }
     //----
 
@@ -234,7 +234,7 @@ namespace priv
     static PFC_INLINE int32_t op_read(const volatile T &src_)
     {
       PFC_STATIC_ASSERT_MSG(meta_alignof<T>::res>=4, alignment_restrictions_of_the_type_are_not_strict_enough_for_the_atomic_operation);
-      return (const int32_t&)src_;
+      return *(const volatile int32_t*)&src_;
     }
     //----
 
@@ -242,7 +242,7 @@ namespace priv
     static PFC_INLINE void op_write(volatile T &dst_, T v_)
     {
       PFC_STATIC_ASSERT_MSG(meta_alignof<T>::res>=4, alignment_restrictions_of_the_type_are_not_strict_enough_for_the_atomic_operation);
-      (volatile int32_t&)dst_=(const int32_t&)v_;
+      (volatile int32_t&)dst_=*(const int32_t*)&v_;
     }
     //----
 
@@ -327,7 +327,7 @@ namespace priv
     static PFC_INLINE void op_write(volatile T &dst_, T v_)
     {
       PFC_STATIC_ASSERT_MSG(meta_alignof<T>::res>=8, alignment_restrictions_of_the_type_are_not_strict_enough_for_the_atomic_operation);
-      (volatile float64_t&)dst_=(const float64_t&)v_;
+      (volatile float64_t&)dst_=*(const float64_t*)&v_;
     }
     //----
 
@@ -442,3 +442,25 @@ namespace priv
   };
 } // namespace priv
 //----------------------------------------------------------------------------
+
+
+//============================================================================
+// memory fences
+//============================================================================
+PFC_INLINE void atom_fence_acquire()
+{
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+//----
+
+PFC_INLINE void atom_fence_release()
+{
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+//----
+
+PFC_INLINE void atom_fence()
+{
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+//----------------------------------------------------------------------------
@@ -18,6 +18,7 @@
 #pragma intrinsic(_InterlockedAnd8, _InterlockedAnd16, _InterlockedAnd)
 #pragma intrinsic(_InterlockedOr8, _InterlockedOr16, _InterlockedOr)
 #pragma intrinsic(_InterlockedXor8, _InterlockedXor16, _InterlockedXor)
+#pragma intrinsic(_ReadWriteBarrier)
 #ifdef PFC_PLATFORM_64BIT
 // 64-bit extension
 #pragma intrinsic(_InterlockedIncrement64)
@@ -94,14 +95,14 @@ namespace priv
     template<typename T>
     static PFC_INLINE char op_read(const volatile T &src_)
     {
-      return (const char&)src_;
+      return *(const volatile char*)&src_;
     }
     //----
 
     template<typename T>
     static PFC_INLINE void op_write(volatile T &dst_, T v_)
     {
-      (volatile char&)dst_=(const char&)v_;
+      (volatile char&)dst_=*(const char*)&v_;
     }
     //----
 
@@ -176,7 +177,7 @@ namespace priv
     static PFC_INLINE short op_read(const volatile T &src_)
     {
       PFC_STATIC_ASSERT_MSG(meta_alignof<T>::res>=2, alignment_restrictions_of_the_type_are_not_strict_enough_for_the_atomic_operation);
-      return (const short&)src_;
+      return *(const volatile short*)&src_;
     }
     //----
 
@@ -184,7 +185,7 @@ namespace priv
     static PFC_INLINE void op_write(volatile T &dst_, T v_)
     {
       PFC_STATIC_ASSERT_MSG(meta_alignof<T>::res>=2, alignment_restrictions_of_the_type_are_not_strict_enough_for_the_atomic_operation);
-      (volatile short&)dst_=(const short&)v_;
+      (volatile short&)dst_=*(const short*)&v_;
     }
     //----
 
@@ -262,7 +263,7 @@ namespace priv
     static PFC_INLINE long op_read(const volatile T &src_)
     {
       PFC_STATIC_ASSERT_MSG(meta_alignof<T>::res>=4, alignment_restrictions_of_the_type_are_not_strict_enough_for_the_atomic_operation);
-      return (const long&)src_;
+      return *(const volatile long*)&src_;
     }
     //----
 
@@ -270,7 +271,7 @@ namespace priv
     static PFC_INLINE void op_write(volatile T &dst_, T v_)
     {
       PFC_STATIC_ASSERT_MSG(meta_alignof<T>::res>=4, alignment_restrictions_of_the_type_are_not_strict_enough_for_the_atomic_operation);
-      (volatile long&)dst_=(const long&)v_;
+      (volatile long&)dst_=*(const long*)&v_;
     }
     //----
 
@@ -356,7 +357,7 @@ namespace priv
     static PFC_INLINE void op_write(volatile T &dst_, T v_)
     {
       PFC_STATIC_ASSERT_MSG(meta_alignof<T>::res>=8, alignment_restrictions_of_the_type_are_not_strict_enough_for_the_atomic_operation);
-      (volatile float64_t&)dst_=(const float64_t&)v_;
+      (volatile float64_t&)dst_=*(const float64_t*)&v_;
     }
     //----
 
@@ -490,3 +491,27 @@ namespace priv
   };
 } // namespace priv
 //----------------------------------------------------------------------------
+
+
+//============================================================================
+// memory fences
+//============================================================================
+PFC_INLINE void atom_fence_acquire()
+{
+  // x86/x64 doesn't reorder loads with other loads or stores with older loads
+  _ReadWriteBarrier();
+}
+//----
+
+PFC_INLINE void atom_fence_release()
+{
+  // x86/x64 doesn't reorder stores with other stores or older loads
+  _ReadWriteBarrier();
+}
+//----
+
+PFC_INLINE void atom_fence()
+{
+  MemoryBarrier();
+}
+//----------------------------------------------------------------------------
@@ -163,3 +163,37 @@ int pfc::system_call(const char *cmd_)
   return exit_code;
 }
 //----------------------------------------------------------------------------
+
+
+//============================================================================
+// map_os_memory
+//============================================================================
+void *pfc::map_os_memory(usize_t num_bytes_, usize_t align_, bool huge_pages_)
+{
+  // note: large pages require SeLockMemoryPrivilege, thus huge_pages_ is ignored
+  void *p=VirtualAlloc(0, (SIZE_T)num_bytes_, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+  if(!p || (usize_t(p)&(align_-1))==0)
+    return p;
+
+  // reserve over-sized region to find aligned address and re-allocate at it
+  VirtualFree(p, 0, MEM_RELEASE);
+  for(unsigned i=0; i<16; ++i)
+  {
+    p=VirtualAlloc(0, (SIZE_T)(num_bytes_+align_), MEM_RESERVE, PAGE_NOACCESS);
+    if(!p)
+      return 0;
+    VirtualFree(p, 0, MEM_RELEASE);
+    p=VirtualAlloc((void*)((usize_t(p)+align_-1)&-align_), (SIZE_T)num_bytes_, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+    if(p)
+      return p;
+  }
+  return 0;
+}
+//----
+
+void pfc::unmap_os_memory(void *p_, usize_t num_bytes_)
+{
+  if(p_)
+    VirtualFree(p_, 0, MEM_RELEASE);
+}
+//----------------------------------------------------------------------------